@@ -0,0 +1,743 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Benchmark Harness
+//
+// ddac-bench: a reproducible performance suite over the C ABI, linked
+// against libdocudactyl_ffi like the integration tests.
+//
+//   parse.<kind>      ddac_parse over the synthetic corpus, per content kind
+//   stage.<name>      each stage bit alone, over the corpus document of the
+//                     kind it applies to (text stages: the PDF's fixed text);
+//                     timed by the library's own stage spans (metrics.zig)
+//   lmdb.*_batch      ddac_cache_store_batch / ddac_cache_lookup_batch
+//   dragonfly.*_batch the same against --dragonfly HOST:PORT (skipped without)
+//   conduit.batch     ddac_conduit_batch over the whole corpus
+//   crypto.sha256     ddac_crypto_batch_sha256 over the whole corpus
+//
+// Each row is: name, samples, throughput (units/s), p50 and p99 per call
+// (us), and bytes read per document (the /proc/self/io rchar delta, i.e.
+// read(2)-family bytes; mmap'd and io_uring reads are not counted). Stage
+// rows report bytes read beyond the base parse of the same document, and
+// no throughput: their spans are histogram buckets with no total time, so
+// the column is 0 (shown as "-") and never compared.
+//
+// Usage:
+//   ddac-bench [--docs N] [--iters N] [--work DIR] [--out FILE]
+//              [--baseline FILE] [--tolerance F] [--dragonfly HOST:PORT]
+//   ddac-bench corpus DIR [--docs N]
+//   ddac-bench compare RESULTS BASELINE [--tolerance F]
+//
+// With a baseline, any row whose throughput falls, or whose p99 or bytes
+// per document rise, by more than the tolerance (default 10%) is
+// reported and the exit status is 1.
+
+const std = @import("std");
+const corpus = @import("corpus.zig");
+
+// ============================================================================
+// C ABI
+// ============================================================================
+
+const ParseResult = extern struct {
+    status: c_int,
+    content_kind: c_int,
+    page_count: i32,
+    word_count: i64,
+    char_count: i64,
+    duration_sec: f64,
+    parse_time_ms: f64,
+    sha256: [65]u8,
+    _pad1: [7]u8,
+    error_msg: [256]u8,
+    title: [256]u8,
+    author: [256]u8,
+    mime_type: [64]u8,
+};
+
+comptime {
+    // Same layout as ddac_parse_result_t in generated/abi/docudactyl_ffi.h
+    std.debug.assert(@sizeOf(ParseResult) == 952);
+    std.debug.assert(@offsetOf(ParseResult, "error_msg") == 120);
+    std.debug.assert(@offsetOf(ParseResult, "title") == 376);
+    std.debug.assert(@offsetOf(ParseResult, "author") == 632);
+    std.debug.assert(@offsetOf(ParseResult, "mime_type") == 888);
+}
+
+extern fn ddac_init() ?*anyopaque;
+extern fn ddac_free(?*anyopaque) void;
+extern fn ddac_parse(?*anyopaque, ?[*:0]const u8, ?[*:0]const u8, c_int, u64) ParseResult;
+
+extern fn ddac_cache_init([*:0]const u8, u64) ?*anyopaque;
+extern fn ddac_cache_free(?*anyopaque) void;
+extern fn ddac_cache_lookup_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?*anyopaque, usize, ?[*]u64, [*]u8, u32) u32;
+extern fn ddac_cache_store_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?*const anyopaque, usize, ?[*]const u64, ?[*]const u8, u32) u32;
+
+extern fn ddac_dragonfly_pool_create([*:0]const u8, u32) ?*anyopaque;
+extern fn ddac_dragonfly_pool_free(?*anyopaque) void;
+extern fn ddac_dragonfly_lookup_batch(?*anyopaque, [*]const ?[*:0]const u8, ?*anyopaque, usize, [*]u8, u32) u32;
+extern fn ddac_dragonfly_store_batch(?*anyopaque, [*]const ?[*:0]const u8, ?*const anyopaque, usize, [*]const u8, u32, u32) u32;
+
+extern fn ddac_conduit_result_size() usize;
+extern fn ddac_conduit_batch([*]const ?[*:0]const u8, ?*anyopaque, u32) u32;
+
+extern fn ddac_crypto_batch_sha256([*]const [*:0]const u8, [*][65]u8, u32) u32;
+
+extern fn ddac_metrics_layout(*u32, *u32) void;
+extern fn ddac_metrics_phase_name(u32) [*:0]const u8;
+extern fn ddac_metrics_snapshot([*]u64, usize) usize;
+extern fn ddac_metrics_quantile([*]const u64, u32, f64) f64;
+extern fn ddac_metrics_reset() void;
+
+/// Stage bits in DDAC_STAGE_* order (bit i = STAGES[i]), with the
+/// corpus kind each one is benchmarked on.
+const STAGES = [_]struct { name: []const u8, kind: corpus.Kind }{
+    .{ .name = "language_detect", .kind = .pdf },
+    .{ .name = "readability", .kind = .pdf },
+    .{ .name = "keywords", .kind = .pdf },
+    .{ .name = "citation_extract", .kind = .pdf },
+    .{ .name = "ocr_confidence", .kind = .image },
+    .{ .name = "perceptual_hash", .kind = .image },
+    .{ .name = "toc_extract", .kind = .pdf },
+    .{ .name = "multi_lang_ocr", .kind = .image },
+    .{ .name = "subtitle_extract", .kind = .video },
+    .{ .name = "premis_metadata", .kind = .pdf },
+    .{ .name = "merkle_proof", .kind = .pdf },
+    .{ .name = "exact_dedup", .kind = .pdf },
+    .{ .name = "near_dedup", .kind = .image },
+    .{ .name = "coord_normalize", .kind = .geospatial },
+    .{ .name = "ner", .kind = .pdf },
+    .{ .name = "whisper_transcribe", .kind = .audio },
+    .{ .name = "image_classify", .kind = .image },
+    .{ .name = "layout_analysis", .kind = .pdf },
+    .{ .name = "handwriting_ocr", .kind = .image },
+    .{ .name = "format_convert", .kind = .pdf },
+    .{ .name = "redaction_detect", .kind = .pdf },
+    .{ .name = "financial_extract", .kind = .pdf },
+    .{ .name = "legal_ner", .kind = .pdf },
+    .{ .name = "speaker_id", .kind = .audio },
+};
+
+// ============================================================================
+// Results
+// ============================================================================
+
+const Row = struct {
+    name: []const u8,
+    samples: u64,
+    throughput: f64,
+    p50_us: f64,
+    p99_us: f64,
+    bytes_per_doc: f64,
+};
+
+const Results = struct {
+    gpa: std.mem.Allocator,
+    rows: std.ArrayList(Row) = .empty,
+
+    fn add(self: *Results, row: Row) !void {
+        const owned = try self.gpa.dupe(u8, row.name);
+        errdefer self.gpa.free(owned);
+        var r = row;
+        r.name = owned;
+        try self.rows.append(self.gpa, r);
+        var tp_buf: [32]u8 = undefined;
+        const tp = if (r.throughput > 0)
+            std.fmt.bufPrint(&tp_buf, "{d:.1}/s", .{r.throughput}) catch "?"
+        else
+            "-";
+        std.debug.print("  {s: <28} {d: >8} {s: >16}  p50 {d: >10.1} us  p99 {d: >10.1} us  {d: >10.0} B/doc\n", .{
+            r.name, r.samples, tp, r.p50_us, r.p99_us, r.bytes_per_doc,
+        });
+    }
+
+    fn find(self: *const Results, name: []const u8) ?Row {
+        for (self.rows.items) |r| {
+            if (std.mem.eql(u8, r.name, name)) return r;
+        }
+        return null;
+    }
+
+    fn deinit(self: *Results) void {
+        for (self.rows.items) |r| self.gpa.free(r.name);
+        self.rows.deinit(self.gpa);
+    }
+
+    const HEADER = "# name\tsamples\tthroughput_per_s\tp50_us\tp99_us\tbytes_per_doc\n";
+
+    fn write(self: *const Results, path: []const u8) !void {
+        var buf: std.ArrayList(u8) = .empty;
+        defer buf.deinit(self.gpa);
+        try buf.appendSlice(self.gpa, HEADER);
+        for (self.rows.items) |r| {
+            try buf.print(self.gpa, "{s}\t{d}\t{d:.3}\t{d:.3}\t{d:.3}\t{d:.1}\n", .{
+                r.name, r.samples, r.throughput, r.p50_us, r.p99_us, r.bytes_per_doc,
+            });
+        }
+        const file = try std.fs.cwd().createFile(path, .{});
+        defer file.close();
+        try file.writeAll(buf.items);
+    }
+
+    /// Load a results TSV (as written by write(), or by `just bench-hpc`).
+    fn load(gpa: std.mem.Allocator, path: []const u8) !Results {
+        const file = try std.fs.cwd().openFile(path, .{});
+        defer file.close();
+        const data = try gpa.alloc(u8, @intCast(try file.getEndPos()));
+        defer gpa.free(data);
+        _ = try file.readAll(data);
+        var res = Results{ .gpa = gpa };
+        errdefer res.deinit();
+        var lines = std.mem.splitScalar(u8, data, '\n');
+        while (lines.next()) |line| {
+            if (line.len == 0 or line[0] == '#') continue;
+            var f = std.mem.splitScalar(u8, line, '\t');
+            const name = f.next() orelse continue;
+            const row = Row{
+                .name = try gpa.dupe(u8, name),
+                .samples = std.fmt.parseInt(u64, f.next() orelse "0", 10) catch 0,
+                .throughput = std.fmt.parseFloat(f64, f.next() orelse "0") catch 0,
+                .p50_us = std.fmt.parseFloat(f64, f.next() orelse "0") catch 0,
+                .p99_us = std.fmt.parseFloat(f64, f.next() orelse "0") catch 0,
+                .bytes_per_doc = std.fmt.parseFloat(f64, f.next() orelse "0") catch 0,
+            };
+            try res.rows.append(gpa, row);
+        }
+        return res;
+    }
+};
+
+/// Print every regression beyond `tolerance`; returns how many there were.
+/// Rows missing from either side, and zero values on either side (not
+/// measured), are not compared.
+fn compare(current: *const Results, baseline: *const Results, tolerance: f64) usize {
+    var regressions: usize = 0;
+    std.debug.print("\n  {s: <28} {s: >12} {s: >12} {s: >12}\n", .{ "vs baseline", "throughput", "p99", "bytes/doc" });
+    for (current.rows.items) |cur| {
+        const base = baseline.find(cur.name) orelse continue;
+        const d_tp = delta(cur.throughput, base.throughput);
+        const d_p99 = delta(cur.p99_us, base.p99_us);
+        const d_bytes = delta(cur.bytes_per_doc, base.bytes_per_doc);
+        const bad = (d_tp < -tolerance) or (d_p99 > tolerance) or (d_bytes > tolerance);
+        if (bad) regressions += 1;
+        std.debug.print("  {s: <28} {d: >11.1}% {d: >11.1}% {d: >11.1}%{s}\n", .{
+            cur.name, d_tp * 100, d_p99 * 100, d_bytes * 100, if (bad) "  REGRESSION" else "",
+        });
+    }
+    return regressions;
+}
+
+fn delta(cur: f64, base: f64) f64 {
+    if (base <= 0 or cur <= 0) return 0;
+    return (cur - base) / base;
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+const Samples = struct {
+    gpa: std.mem.Allocator,
+    ns: std.ArrayList(u64) = .empty,
+
+    fn add(self: *Samples, ns: u64) !void {
+        try self.ns.append(self.gpa, ns);
+    }
+
+    fn quantileUs(self: *Samples, q: f64) f64 {
+        if (self.ns.items.len == 0) return 0;
+        std.mem.sort(u64, self.ns.items, {}, std.sort.asc(u64));
+        const n: f64 = @floatFromInt(self.ns.items.len);
+        const rank: usize = @intFromFloat(@ceil(q * n));
+        const i = @min(@max(rank, 1), self.ns.items.len) - 1;
+        return @as(f64, @floatFromInt(self.ns.items[i])) / std.time.ns_per_us;
+    }
+
+    fn deinit(self: *Samples) void {
+        self.ns.deinit(self.gpa);
+    }
+};
+
+/// Bytes this process has read through read(2)-family calls so far.
+fn readBytes() u64 {
+    var buf: [1024]u8 = undefined;
+    const file = std.fs.openFileAbsolute("/proc/self/io", .{}) catch return 0;
+    defer file.close();
+    const n = file.readAll(&buf) catch return 0;
+    var lines = std.mem.splitScalar(u8, buf[0..n], '\n');
+    while (lines.next()) |line| {
+        if (std.mem.startsWith(u8, line, "rchar: "))
+            return std.fmt.parseInt(u64, line["rchar: ".len..], 10) catch 0;
+    }
+    return 0;
+}
+
+fn now() std.time.Instant {
+    return std.time.Instant.now() catch unreachable;
+}
+
+fn perSecond(units: u64, elapsed_ns: u64) f64 {
+    if (elapsed_ns == 0) return 0;
+    return @as(f64, @floatFromInt(units)) * std.time.ns_per_s / @as(f64, @floatFromInt(elapsed_ns));
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+const Bench = struct {
+    gpa: std.mem.Allocator,
+    docs: []const corpus.Document,
+    out_dir: []const u8,
+    iters: usize,
+    results: *Results,
+    /// Per-document read bytes of the base parse, by kind (stage rows
+    /// subtract it)
+    parse_bytes: [std.enums.values(corpus.Kind).len]f64 = @splat(0),
+
+    fn ofKind(self: *const Bench, kind: corpus.Kind, list: *std.ArrayList(corpus.Document)) !void {
+        for (self.docs) |d| {
+            if (d.kind == kind) try list.append(self.gpa, d);
+        }
+    }
+
+    fn outPath(self: *const Bench, in_path: []const u8) ![:0]u8 {
+        return std.fmt.allocPrintSentinel(self.gpa, "{s}/{s}.out", .{ self.out_dir, std.fs.path.basename(in_path) }, 0);
+    }
+
+    fn parseKinds(self: *Bench, handle: *anyopaque) !void {
+        for (std.enums.values(corpus.Kind)) |kind| {
+            var docs: std.ArrayList(corpus.Document) = .empty;
+            defer docs.deinit(self.gpa);
+            try self.ofKind(kind, &docs);
+            if (docs.items.len == 0) continue;
+
+            var samples = Samples{ .gpa = self.gpa };
+            defer samples.deinit();
+            const rounds = @max(1, self.iters / docs.items.len);
+
+            // Warm up library contexts (Tesseract, GDAL drivers) once
+            const warm_out = try self.outPath(docs.items[0].path);
+            defer self.gpa.free(warm_out);
+            _ = ddac_parse(handle, docs.items[0].path, warm_out, 0, 0);
+
+            var failures: usize = 0;
+            const read0 = readBytes();
+            var busy: u64 = 0;
+            for (0..rounds) |_| {
+                for (docs.items) |d| {
+                    const out = try self.outPath(d.path);
+                    defer self.gpa.free(out);
+                    const t0 = now();
+                    const r = ddac_parse(handle, d.path, out, 0, 0);
+                    const ns = now().since(t0);
+                    busy += ns;
+                    try samples.add(ns);
+                    if (r.status != 0) failures += 1;
+                }
+            }
+            const n = rounds * docs.items.len;
+            const per_doc = @as(f64, @floatFromInt(readBytes() - read0)) / @as(f64, @floatFromInt(n));
+            self.parse_bytes[@intFromEnum(kind)] = per_doc;
+            if (failures > 0) std.debug.print("  (parse.{s}: {d} of {d} parses failed)\n", .{ @tagName(kind), failures, n });
+
+            var name_buf: [64]u8 = undefined;
+            try self.results.add(.{
+                .name = try std.fmt.bufPrint(&name_buf, "parse.{s}", .{@tagName(kind)}),
+                .samples = n,
+                .throughput = perSecond(n, busy),
+                .p50_us = samples.quantileUs(0.5),
+                .p99_us = samples.quantileUs(0.99),
+                .bytes_per_doc = per_doc,
+            });
+        }
+    }
+
+    /// Each stage bit alone. The stage's own time comes from its
+    /// metrics span, so the base parse around it is not counted.
+    fn stages(self: *Bench, handle: *anyopaque) !void {
+        var phases: u32 = 0;
+        var buckets: u32 = 0;
+        ddac_metrics_layout(&phases, &buckets);
+        const counts = try self.gpa.alloc(u64, @as(usize, phases) * buckets);
+        defer self.gpa.free(counts);
+
+        for (STAGES, 0..) |stage, bit| {
+            var doc: ?corpus.Document = null;
+            for (self.docs) |d| {
+                if (d.kind == stage.kind) {
+                    doc = d;
+                    break;
+                }
+            }
+            const d = doc orelse continue;
+            const out = try self.outPath(d.path);
+            defer self.gpa.free(out);
+            const flag = @as(u64, 1) << @intCast(bit);
+
+            var phase_name_buf: [64]u8 = undefined;
+            const phase_name = try std.fmt.bufPrint(&phase_name_buf, "stage.{s}", .{stage.name});
+            const phase = findPhase(phases, phase_name) orelse continue;
+
+            _ = ddac_parse(handle, d.path, out, 0, flag);
+            ddac_metrics_reset();
+            const read0 = readBytes();
+            for (0..self.iters) |_| _ = ddac_parse(handle, d.path, out, 0, flag);
+            const read_per_doc = @as(f64, @floatFromInt(readBytes() - read0)) / @as(f64, @floatFromInt(self.iters));
+
+            _ = ddac_metrics_snapshot(counts.ptr, counts.len);
+            const row = counts[@as(usize, phase) * buckets ..][0..buckets];
+            var n: u64 = 0;
+            for (row) |c| n += c;
+            if (n == 0) continue; // stage does not apply to this document
+            const p50 = ddac_metrics_quantile(row.ptr, buckets, 0.5);
+
+            try self.results.add(.{
+                .name = phase_name,
+                .samples = n,
+                .throughput = 0, // not measured, see the header
+                .p50_us = p50,
+                .p99_us = ddac_metrics_quantile(row.ptr, buckets, 0.99),
+                .bytes_per_doc = @max(0, read_per_doc - self.parse_bytes[@intFromEnum(stage.kind)]),
+            });
+        }
+    }
+
+    fn findPhase(phases: u32, name: []const u8) ?u32 {
+        for (0..phases) |p| {
+            if (std.mem.eql(u8, std.mem.span(ddac_metrics_phase_name(@intCast(p))), name)) return @intCast(p);
+        }
+        return null;
+    }
+
+    fn pathArray(self: *const Bench) ![]?[*:0]const u8 {
+        const paths = try self.gpa.alloc(?[*:0]const u8, self.docs.len);
+        for (self.docs, paths) |d, *p| p.* = d.path;
+        return paths;
+    }
+
+    fn batchRow(self: *Bench, name: []const u8, samples: *Samples, busy: u64, per_call: usize, bytes: f64) !void {
+        const calls = samples.ns.items.len;
+        try self.results.add(.{
+            .name = name,
+            .samples = calls,
+            .throughput = perSecond(calls * per_call, busy),
+            .p50_us = samples.quantileUs(0.5),
+            .p99_us = samples.quantileUs(0.99),
+            .bytes_per_doc = bytes,
+        });
+    }
+
+    fn lmdb(self: *Bench, work: []const u8) !void {
+        const dir = try std.fmt.allocPrintSentinel(self.gpa, "{s}/lmdb", .{work}, 0);
+        defer self.gpa.free(dir);
+        std.fs.cwd().deleteTree(dir) catch {};
+        try std.fs.cwd().makePath(dir);
+        const cache = ddac_cache_init(dir, 1024) orelse return error.CacheInit;
+        defer ddac_cache_free(cache);
+
+        const n = self.docs.len;
+        const paths = try self.pathArray();
+        defer self.gpa.free(paths);
+        const mtimes = try self.gpa.alloc(i64, n);
+        defer self.gpa.free(mtimes);
+        const sizes = try self.gpa.alloc(i64, n);
+        defer self.gpa.free(sizes);
+        for (self.docs, mtimes, sizes) |d, *m, *s| {
+            m.* = 1_700_000_000;
+            s.* = @intCast(d.size);
+        }
+        const rows = try self.gpa.alloc(ParseResult, n);
+        defer self.gpa.free(rows);
+        @memset(std.mem.sliceAsBytes(rows), 0x2a);
+        const bits = try self.gpa.alloc(u8, (n + 7) / 8);
+        defer self.gpa.free(bits);
+
+        var store = Samples{ .gpa = self.gpa };
+        defer store.deinit();
+        var busy: u64 = 0;
+        for (0..self.iters) |_| {
+            const t0 = now();
+            // SAFETY: rows is n contiguous ParseResult rows; the cache reads them as n * result_size bytes
+            _ = ddac_cache_store_batch(cache, paths.ptr, mtimes.ptr, sizes.ptr, @ptrCast(rows.ptr), @sizeOf(ParseResult), null, null, @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try store.add(ns);
+        }
+        try self.batchRow("lmdb.store_batch", &store, busy, n, 0);
+
+        var lookup = Samples{ .gpa = self.gpa };
+        defer lookup.deinit();
+        busy = 0;
+        for (0..self.iters) |_| {
+            const t0 = now();
+            // SAFETY: rows is n contiguous ParseResult rows; hits are written as n * result_size bytes
+            _ = ddac_cache_lookup_batch(cache, paths.ptr, mtimes.ptr, sizes.ptr, @ptrCast(rows.ptr), @sizeOf(ParseResult), null, bits.ptr, @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try lookup.add(ns);
+        }
+        try self.batchRow("lmdb.lookup_batch", &lookup, busy, n, 0);
+    }
+
+    fn dragonfly(self: *Bench, addr: [:0]const u8) !void {
+        const pool = ddac_dragonfly_pool_create(addr, 4) orelse {
+            std.debug.print("  (dragonfly: cannot connect to {s}; skipped)\n", .{addr});
+            return;
+        };
+        defer ddac_dragonfly_pool_free(pool);
+
+        const n = self.docs.len;
+        const shas = try self.gpa.alloc(?[*:0]const u8, n);
+        defer self.gpa.free(shas);
+        const sha_store = try self.gpa.alloc([65]u8, n);
+        defer self.gpa.free(sha_store);
+        for (sha_store, shas, 0..) |*s, *p, i| {
+            var digest: [32]u8 = undefined;
+            std.crypto.hash.sha2.Sha256.hash(std.mem.asBytes(&i), &digest, .{});
+            s[0..64].* = std.fmt.bytesToHex(digest, .lower);
+            s[64] = 0;
+            p.* = s[0..64 :0];
+        }
+        const rows = try self.gpa.alloc(ParseResult, n);
+        defer self.gpa.free(rows);
+        @memset(std.mem.sliceAsBytes(rows), 0x2a);
+        const bits = try self.gpa.alloc(u8, (n + 7) / 8);
+        defer self.gpa.free(bits);
+        @memset(bits, 0xff);
+
+        var store = Samples{ .gpa = self.gpa };
+        defer store.deinit();
+        var busy: u64 = 0;
+        for (0..self.iters) |_| {
+            const t0 = now();
+            // SAFETY: rows is n contiguous ParseResult rows; the pool reads them as n * result_size bytes
+            _ = ddac_dragonfly_store_batch(pool, shas.ptr, @ptrCast(rows.ptr), @sizeOf(ParseResult), bits.ptr, 600, @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try store.add(ns);
+        }
+        try self.batchRow("dragonfly.store_batch", &store, busy, n, 0);
+
+        var lookup = Samples{ .gpa = self.gpa };
+        defer lookup.deinit();
+        busy = 0;
+        for (0..self.iters) |_| {
+            const t0 = now();
+            // SAFETY: rows is n contiguous ParseResult rows; hits are written as n * result_size bytes
+            _ = ddac_dragonfly_lookup_batch(pool, shas.ptr, @ptrCast(rows.ptr), @sizeOf(ParseResult), bits.ptr, @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try lookup.add(ns);
+        }
+        try self.batchRow("dragonfly.lookup_batch", &lookup, busy, n, 0);
+    }
+
+    fn conduit(self: *Bench) !void {
+        const n = self.docs.len;
+        const paths = try self.pathArray();
+        defer self.gpa.free(paths);
+        const results = try self.gpa.alloc(u8, n * ddac_conduit_result_size());
+        defer self.gpa.free(results);
+
+        var samples = Samples{ .gpa = self.gpa };
+        defer samples.deinit();
+        var busy: u64 = 0;
+        const read0 = readBytes();
+        for (0..self.iters) |_| {
+            const t0 = now();
+            // SAFETY: results holds n ConduitResult structs of ddac_conduit_result_size() bytes each
+            _ = ddac_conduit_batch(paths.ptr, @ptrCast(results.ptr), @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try samples.add(ns);
+        }
+        const bytes = @as(f64, @floatFromInt(readBytes() - read0)) / @as(f64, @floatFromInt(self.iters * n));
+        try self.batchRow("conduit.batch", &samples, busy, n, bytes);
+    }
+
+    fn crypto(self: *Bench) !void {
+        const n = @min(self.docs.len, 1024);
+        const paths = try self.gpa.alloc([*:0]const u8, n);
+        defer self.gpa.free(paths);
+        for (paths, self.docs[0..n]) |*p, d| p.* = d.path;
+        const hex = try self.gpa.alloc([65]u8, n);
+        defer self.gpa.free(hex);
+
+        var samples = Samples{ .gpa = self.gpa };
+        defer samples.deinit();
+        var busy: u64 = 0;
+        const read0 = readBytes();
+        for (0..self.iters) |_| {
+            const t0 = now();
+            _ = ddac_crypto_batch_sha256(paths.ptr, hex.ptr, @intCast(n));
+            const ns = now().since(t0);
+            busy += ns;
+            try samples.add(ns);
+        }
+        const bytes = @as(f64, @floatFromInt(readBytes() - read0)) / @as(f64, @floatFromInt(self.iters * n));
+        try self.batchRow("crypto.sha256", &samples, busy, n, bytes);
+    }
+};
+
+// ============================================================================
+// Command Line
+// ============================================================================
+
+const Options = struct {
+    docs: usize = 16,
+    iters: usize = 64,
+    work: []const u8 = "/tmp/ddac-bench",
+    out: ?[]const u8 = null,
+    baseline: ?[]const u8 = null,
+    tolerance: f64 = 0.10,
+    dragonfly: ?[:0]const u8 = null,
+    positional: [2]?[]const u8 = .{ null, null },
+};
+
+fn parseArgs(args: []const [:0]const u8) !Options {
+    var o = Options{};
+    var npos: usize = 0;
+    var i: usize = 0;
+    while (i < args.len) : (i += 1) {
+        const a = args[i];
+        const value: [:0]const u8 = if (i + 1 < args.len) args[i + 1] else "";
+        if (std.mem.eql(u8, a, "--docs")) {
+            o.docs = try std.fmt.parseInt(usize, value, 10);
+        } else if (std.mem.eql(u8, a, "--iters")) {
+            o.iters = @max(1, try std.fmt.parseInt(usize, value, 10));
+        } else if (std.mem.eql(u8, a, "--work")) {
+            o.work = value;
+        } else if (std.mem.eql(u8, a, "--out")) {
+            o.out = value;
+        } else if (std.mem.eql(u8, a, "--baseline")) {
+            o.baseline = value;
+        } else if (std.mem.eql(u8, a, "--tolerance")) {
+            o.tolerance = try std.fmt.parseFloat(f64, value);
+        } else if (std.mem.eql(u8, a, "--dragonfly")) {
+            o.dragonfly = value;
+        } else {
+            if (npos >= o.positional.len) return error.TooManyArguments;
+            o.positional[npos] = a;
+            npos += 1;
+            continue;
+        }
+        if (i + 1 >= args.len) return error.MissingValue;
+        i += 1;
+    }
+    return o;
+}
+
+fn compareFiles(gpa: std.mem.Allocator, current_path: []const u8, baseline_path: []const u8, tolerance: f64) !u8 {
+    var current = try Results.load(gpa, current_path);
+    defer current.deinit();
+    var baseline = try Results.load(gpa, baseline_path);
+    defer baseline.deinit();
+    const regressions = compare(&current, &baseline, tolerance);
+    std.debug.print("\n{d} regression(s) beyond {d:.0}%\n", .{ regressions, tolerance * 100 });
+    return if (regressions > 0) 1 else 0;
+}
+
+pub fn main() !u8 {
+    var gpa_state: std.heap.GeneralPurposeAllocator(.{}) = .init;
+    defer _ = gpa_state.deinit();
+    const gpa = gpa_state.allocator();
+
+    const argv = try std.process.argsAlloc(gpa);
+    defer std.process.argsFree(gpa, argv);
+    const args = argv[1..];
+    const mode: []const u8 = if (args.len > 0 and args[0].len > 0 and args[0][0] != '-') args[0] else "run";
+    const o = parseArgs(if (std.mem.eql(u8, mode, "run")) args else args[1..]) catch |err| {
+        std.debug.print("ddac-bench: bad arguments ({s}); see the header of bench/bench.zig\n", .{@errorName(err)});
+        return 2;
+    };
+
+    if (std.mem.eql(u8, mode, "corpus")) {
+        const dir = o.positional[0] orelse return 2;
+        const docs = try corpus.writeCorpus(gpa, dir, o.docs);
+        defer corpus.freeCorpus(gpa, docs);
+        std.debug.print("ddac-bench: {d} documents and manifest.txt in {s}\n", .{ docs.len, dir });
+        return 0;
+    }
+    if (std.mem.eql(u8, mode, "compare")) {
+        const current = o.positional[0] orelse return 2;
+        const baseline = o.positional[1] orelse return 2;
+        return compareFiles(gpa, current, baseline, o.tolerance);
+    }
+    if (!std.mem.eql(u8, mode, "run")) {
+        std.debug.print("ddac-bench: unknown command '{s}'\n", .{mode});
+        return 2;
+    }
+
+    // ── Corpus and scratch space ──────────────────────────────────────
+    const corpus_dir = try std.fmt.allocPrint(gpa, "{s}/corpus", .{o.work});
+    defer gpa.free(corpus_dir);
+    const out_dir = try std.fmt.allocPrint(gpa, "{s}/out", .{o.work});
+    defer gpa.free(out_dir);
+    std.fs.cwd().deleteTree(out_dir) catch {};
+    try std.fs.cwd().makePath(out_dir);
+    const docs = try corpus.writeCorpus(gpa, corpus_dir, o.docs);
+    defer corpus.freeCorpus(gpa, docs);
+    std.debug.print("ddac-bench: {d} documents, {d} iterations per benchmark\n\n", .{ docs.len, o.iters });
+
+    var results = Results{ .gpa = gpa };
+    defer results.deinit();
+    var bench = Bench{ .gpa = gpa, .docs = docs, .out_dir = out_dir, .iters = o.iters, .results = &results };
+
+    const handle = ddac_init() orelse return error.InitFailed;
+    defer ddac_free(handle);
+    try bench.parseKinds(handle);
+    try bench.stages(handle);
+    try bench.lmdb(o.work);
+    if (o.dragonfly) |addr| try bench.dragonfly(addr);
+    try bench.conduit();
+    try bench.crypto();
+
+    if (o.out) |path| {
+        try results.write(path);
+        std.debug.print("\nddac-bench: results written to {s}\n", .{path});
+    }
+    if (o.baseline) |path| {
+        var baseline = Results.load(gpa, path) catch |err| {
+            std.debug.print("ddac-bench: no baseline at {s} ({s}); record one with `just bench-baseline`\n", .{ path, @errorName(err) });
+            return 0;
+        };
+        defer baseline.deinit();
+        const regressions = compare(&results, &baseline, o.tolerance);
+        std.debug.print("\n{d} regression(s) beyond {d:.0}%\n", .{ regressions, o.tolerance * 100 });
+        if (regressions > 0) return 1;
+    }
+    return 0;
+}
+
+test {
+    _ = corpus;
+}
+
+test "results round-trip through the TSV" {
+    const gpa = std.testing.allocator;
+    var res = Results{ .gpa = gpa };
+    defer res.deinit();
+    try res.add(.{ .name = "parse.pdf", .samples = 10, .throughput = 100, .p50_us = 5, .p99_us = 9, .bytes_per_doc = 4096 });
+
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const path = try tmp.dir.realpathAlloc(gpa, ".");
+    defer gpa.free(path);
+    const file = try std.fmt.allocPrint(gpa, "{s}/r.tsv", .{path});
+    defer gpa.free(file);
+    try res.write(file);
+
+    var back = try Results.load(gpa, file);
+    defer back.deinit();
+    try std.testing.expectEqual(@as(f64, 9), back.find("parse.pdf").?.p99_us);
+
+    // 20% slower p99 is a regression at 10% tolerance, 5% is not
+    back.rows.items[0].p99_us = 9 * 1.2;
+    try std.testing.expectEqual(@as(usize, 1), compare(&back, &res, 0.10));
+    back.rows.items[0].p99_us = 9 * 1.05;
+    try std.testing.expectEqual(@as(usize, 0), compare(&back, &res, 0.10));
+
+    // an unmeasured throughput (stage rows) is not a drop
+    back.rows.items[0].throughput = 0;
+    try std.testing.expectEqual(@as(usize, 0), compare(&back, &res, 0.10));
+}
@@ -0,0 +1,439 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Synthetic Benchmark Corpus
+//
+// Small, deterministic documents of every content kind, written without
+// any external tool so a benchmark run is reproducible on any node:
+//
+//   pdf        — multi-page PDF 1.4, Helvetica text (the fixed text below)
+//   image      — 24-bit BMP with a per-document bar pattern
+//   audio      — 16-bit mono PCM WAV, per-document tone
+//   video      — uncompressed AVI (DIB frames)
+//   epub       — XHTML body with an .epub name; parseEpub reads the
+//                document as XML, so that is the path benchmarked
+//   geospatial — uncompressed TIFF with ModelPixelScale/ModelTiepoint
+//
+// Document i of a kind differs from document i+1 (tone, bars, text
+// offset), so hashes and caches never collapse the corpus.
+
+const std = @import("std");
+
+pub const Kind = enum { pdf, image, audio, video, epub, geospatial };
+
+pub fn extension(kind: Kind) []const u8 {
+    return switch (kind) {
+        .pdf => ".pdf",
+        .image => ".bmp",
+        .audio => ".wav",
+        .video => ".avi",
+        .epub => ".epub",
+        .geospatial => ".geotiff",
+    };
+}
+
+/// The text every text-bearing document carries; also what the stage
+/// microbenchmarks run over. Mixes prose, citations, amounts, dates and
+/// legal phrasing so every text stage has work to do.
+pub const FIXED_TEXT =
+    \\The committee met on 14 March 2021 to review the archive transfer agreement
+    \\between the Records Office and the University Library. Under clause 4.2 the
+    \\transferor shall deliver all registers, correspondence and maps no later than
+    \\30 June 2021, and the recipient shall pay the sum of $12,500.00 plus VAT of
+    \\GBP 2,500.00 within thirty days of delivery. See Smith v. Jones, 123 F.3d 456
+    \\(9th Cir. 1997), and Brown v. Board of Education, 347 U.S. 483 (1954), for the
+    \\standard of care owed by a bailee. Earlier surveys (Hughes 1998; Patel and Ng,
+    \\2004, pp. 17-22) estimated the collection at 340 million items, of which
+    \\roughly a fifth are photographs, maps and audio recordings. doi:10.1000/182
+    \\The plaintiff alleges that the defendant breached the agreement and seeks an
+    \\injunction together with damages of EUR 40,000. The court held that the
+    \\indemnity in section 9 did not extend to consequential loss. Readers should
+    \\note that the catalogue is incomplete; several boxes remain unlisted and the
+    \\language of many letters is Welsh, French or Latin rather than English.
+;
+
+// ============================================================================
+// Byte Builder
+// ============================================================================
+
+const Out = struct {
+    gpa: std.mem.Allocator,
+    buf: std.ArrayList(u8) = .empty,
+
+    fn bytes(self: *Out, s: []const u8) !void {
+        try self.buf.appendSlice(self.gpa, s);
+    }
+
+    fn print(self: *Out, comptime fmt: []const u8, args: anytype) !void {
+        try self.buf.print(self.gpa, fmt, args);
+    }
+
+    fn int(self: *Out, comptime T: type, v: T) !void {
+        var b: [@sizeOf(T)]u8 = undefined;
+        std.mem.writeInt(T, &b, v, .little);
+        try self.bytes(&b);
+    }
+
+    /// Start a RIFF chunk; returns the position of its size field.
+    fn beginChunk(self: *Out, tag: *const [4]u8) !usize {
+        try self.bytes(tag);
+        const pos = self.buf.items.len;
+        try self.int(u32, 0);
+        return pos;
+    }
+
+    fn beginList(self: *Out, tag: *const [4]u8, list_type: *const [4]u8) !usize {
+        const pos = try self.beginChunk(tag);
+        try self.bytes(list_type);
+        return pos;
+    }
+
+    /// Patch a chunk's size and pad it to an even length.
+    fn endChunk(self: *Out, size_pos: usize) !void {
+        const len: u32 = @intCast(self.buf.items.len - size_pos - 4);
+        std.mem.writeInt(u32, self.buf.items[size_pos..][0..4], len, .little);
+        if (len % 2 == 1) try self.bytes(&.{0});
+    }
+};
+
+// ============================================================================
+// Generators
+// ============================================================================
+
+/// Write document `index` of `kind` to `path`; returns its size in bytes.
+pub fn writeDocument(gpa: std.mem.Allocator, path: []const u8, kind: Kind, index: usize) !u64 {
+    var out = Out{ .gpa = gpa };
+    defer out.buf.deinit(gpa);
+    switch (kind) {
+        .pdf => try pdf(&out, 8, index),
+        .image => try bmp(&out, 320, 240, index),
+        .audio => try wav(&out, 2, index),
+        .video => try avi(&out, 64, 48, 20, index),
+        .epub => try xhtml(&out, index),
+        .geospatial => try tiff(&out, 256, 256, index),
+    }
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    try file.writeAll(out.buf.items);
+    return out.buf.items.len;
+}
+
+/// FIXED_TEXT as wrapped lines, rotated by `index` lines.
+fn textLine(index: usize, n: usize) []const u8 {
+    var it = std.mem.splitScalar(u8, FIXED_TEXT, '\n');
+    var count: usize = 0;
+    while (it.next()) |_| count += 1;
+    const want = (index + n) % count;
+    it.reset();
+    var i: usize = 0;
+    while (it.next()) |line| : (i += 1) {
+        if (i == want) return line;
+    }
+    return "";
+}
+
+fn pdf(out: *Out, pages: usize, index: usize) !void {
+    const gpa = out.gpa;
+    var offsets: std.ArrayList(usize) = .empty;
+    defer offsets.deinit(gpa);
+
+    try out.bytes("%PDF-1.4\n");
+    // 1 catalog, 2 page tree, 3 font, then (page, contents) per page
+    try offsets.append(gpa, out.buf.items.len);
+    try out.bytes("1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    try offsets.append(gpa, out.buf.items.len);
+    try out.bytes("2 0 obj\n<< /Type /Pages /Kids [");
+    for (0..pages) |p| try out.print(" {d} 0 R", .{4 + 2 * p});
+    try out.print(" ] /Count {d} >>\nendobj\n", .{pages});
+    try offsets.append(gpa, out.buf.items.len);
+    try out.bytes("3 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>\nendobj\n");
+
+    var stream = Out{ .gpa = gpa };
+    defer stream.buf.deinit(gpa);
+    for (0..pages) |p| {
+        stream.buf.clearRetainingCapacity();
+        try stream.bytes("BT /F1 10 Tf 14 TL 50 760 Td\n");
+        for (0..48) |l| {
+            try stream.bytes("(");
+            for (textLine(index + p, l)) |ch| {
+                if (ch == '(' or ch == ')' or ch == '\\') try stream.bytes("\\");
+                try stream.bytes(&.{ch});
+            }
+            try stream.bytes(") Tj T*\n");
+        }
+        try stream.bytes("ET\n");
+
+        try offsets.append(gpa, out.buf.items.len);
+        try out.print("{d} 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] " ++
+            "/Resources << /Font << /F1 3 0 R >> >> /Contents {d} 0 R >>\nendobj\n", .{ 4 + 2 * p, 5 + 2 * p });
+        try offsets.append(gpa, out.buf.items.len);
+        try out.print("{d} 0 obj\n<< /Length {d} >>\nstream\n", .{ 5 + 2 * p, stream.buf.items.len });
+        try out.bytes(stream.buf.items);
+        try out.bytes("endstream\nendobj\n");
+    }
+
+    const xref = out.buf.items.len;
+    try out.print("xref\n0 {d}\n0000000000 65535 f \n", .{offsets.items.len + 1});
+    for (offsets.items) |off| try out.print("{d:0>10} 00000 n \n", .{off});
+    try out.print("trailer\n<< /Size {d} /Root 1 0 R >>\nstartxref\n{d}\n%EOF\n", .{ offsets.items.len + 1, xref });
+}
+
+fn bmp(out: *Out, width: u32, height: u32, index: usize) !void {
+    const row: u32 = (width * 3 + 3) & ~@as(u32, 3);
+    const image_size = row * height;
+    try out.bytes("BM");
+    try out.int(u32, 54 + image_size);
+    try out.int(u32, 0);
+    try out.int(u32, 54);
+    // BITMAPINFOHEADER
+    try out.int(u32, 40);
+    try out.int(i32, @intCast(width));
+    try out.int(i32, @intCast(height));
+    try out.int(u16, 1);
+    try out.int(u16, 24);
+    try out.int(u32, 0);
+    try out.int(u32, image_size);
+    try out.int(i32, 2835);
+    try out.int(i32, 2835);
+    try out.int(u32, 0);
+    try out.int(u32, 0);
+
+    const bar = 8 + index % 24;
+    for (0..height) |y| {
+        for (0..width) |x| {
+            const dark = (x / bar + y / 16) % 3 == 0;
+            const v: u8 = if (dark) 0 else 255;
+            try out.bytes(&.{ v, v, v });
+        }
+        for (width * 3..row) |_| try out.bytes(&.{0});
+    }
+}
+
+fn wav(out: *Out, seconds: u32, index: usize) !void {
+    const rate: u32 = 16000;
+    const samples = rate * seconds;
+    const riff = try out.beginList("RIFF", "WAVE");
+    const fmt = try out.beginChunk("fmt ");
+    try out.int(u16, 1); // PCM
+    try out.int(u16, 1); // mono
+    try out.int(u32, rate);
+    try out.int(u32, rate * 2);
+    try out.int(u16, 2);
+    try out.int(u16, 16);
+    try out.endChunk(fmt);
+    const data = try out.beginChunk("data");
+    const freq: f64 = 220.0 + @as(f64, @floatFromInt(index % 64)) * 10.0;
+    for (0..samples) |i| {
+        const t = @as(f64, @floatFromInt(i)) / @as(f64, @floatFromInt(rate));
+        try out.int(i16, @intFromFloat(@sin(2.0 * std.math.pi * freq * t) * 12000.0));
+    }
+    try out.endChunk(data);
+    try out.endChunk(riff);
+}
+
+fn avi(out: *Out, width: u32, height: u32, frames: u32, index: usize) !void {
+    const frame_bytes = width * 3 * height;
+    const riff = try out.beginList("RIFF", "AVI ");
+
+    const hdrl = try out.beginList("LIST", "hdrl");
+    const avih = try out.beginChunk("avih");
+    try out.int(u32, 100_000); // 10 fps
+    try out.int(u32, frame_bytes * 10);
+    try out.int(u32, 0);
+    try out.int(u32, 0x10); // AVIF_HASINDEX
+    try out.int(u32, frames);
+    try out.int(u32, 0);
+    try out.int(u32, 1);
+    try out.int(u32, frame_bytes);
+    try out.int(u32, width);
+    try out.int(u32, height);
+    for (0..4) |_| try out.int(u32, 0);
+    try out.endChunk(avih);
+
+    const strl = try out.beginList("LIST", "strl");
+    const strh = try out.beginChunk("strh");
+    try out.bytes("vidsDIB ");
+    try out.int(u32, 0);
+    try out.int(u16, 0);
+    try out.int(u16, 0);
+    try out.int(u32, 0);
+    try out.int(u32, 1); // scale
+    try out.int(u32, 10); // rate
+    try out.int(u32, 0);
+    try out.int(u32, frames);
+    try out.int(u32, frame_bytes);
+    try out.int(u32, 0xFFFF_FFFF);
+    try out.int(u32, 0);
+    try out.int(i16, 0);
+    try out.int(i16, 0);
+    try out.int(i16, @intCast(width));
+    try out.int(i16, @intCast(height));
+    try out.endChunk(strh);
+    const strf = try out.beginChunk("strf");
+    try out.int(u32, 40);
+    try out.int(i32, @intCast(width));
+    try out.int(i32, @intCast(height));
+    try out.int(u16, 1);
+    try out.int(u16, 24);
+    try out.int(u32, 0);
+    try out.int(u32, frame_bytes);
+    for (0..4) |_| try out.int(u32, 0);
+    try out.endChunk(strf);
+    try out.endChunk(strl);
+    try out.endChunk(hdrl);
+
+    const movi = try out.beginList("LIST", "movi");
+    const movi_base = movi + 4; // idx1 offsets count from the 'movi' tag
+    var chunk_offsets: [256]u32 = undefined;
+    for (0..@min(frames, 256)) |f| {
+        chunk_offsets[f] = @intCast(out.buf.items.len - movi_base);
+        const chunk = try out.beginChunk("00db");
+        for (0..frame_bytes) |b| {
+            const v: u8 = @truncate(b + f * 7 + index * 13);
+            try out.bytes(&.{v});
+        }
+        try out.endChunk(chunk);
+    }
+    try out.endChunk(movi);
+
+    const idx1 = try out.beginChunk("idx1");
+    for (0..@min(frames, 256)) |f| {
+        try out.bytes("00db");
+        try out.int(u32, 0x10); // AVIIF_KEYFRAME
+        try out.int(u32, chunk_offsets[f]);
+        try out.int(u32, frame_bytes);
+    }
+    try out.endChunk(idx1);
+    try out.endChunk(riff);
+}
+
+fn xhtml(out: *Out, index: usize) !void {
+    try out.bytes("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" ++
+        "<html xmlns=\"http://www.w3.org/1999/xhtml\"><head><title>Benchmark</title></head><body>\n");
+    for (0..12) |chapter| {
+        try out.print("<h1>Chapter {d}</h1>\n", .{chapter + 1});
+        for (0..16) |l| try out.print("<p>{s}</p>\n", .{textLine(index + chapter, l)});
+    }
+    try out.bytes("</body></html>\n");
+}
+
+fn tiff(out: *Out, width: u16, height: u16, index: usize) !void {
+    const entries = 11;
+    const doubles_off: u32 = 8 + 2 + entries * 12 + 4;
+    const pixels_off: u32 = doubles_off + 9 * 8;
+    const pixel_bytes: u32 = @as(u32, width) * height;
+
+    try out.bytes("II");
+    try out.int(u16, 42);
+    try out.int(u32, 8);
+
+    const Entry = struct { tag: u16, typ: u16, count: u32, value: u32 };
+    const SHORT = 3;
+    const LONG = 4;
+    const DOUBLE = 12;
+    const ifd = [entries]Entry{
+        .{ .tag = 256, .typ = SHORT, .count = 1, .value = width },
+        .{ .tag = 257, .typ = SHORT, .count = 1, .value = height },
+        .{ .tag = 258, .typ = SHORT, .count = 1, .value = 8 },
+        .{ .tag = 259, .typ = SHORT, .count = 1, .value = 1 },
+        .{ .tag = 262, .typ = SHORT, .count = 1, .value = 1 },
+        .{ .tag = 273, .typ = LONG, .count = 1, .value = pixels_off },
+        .{ .tag = 277, .typ = SHORT, .count = 1, .value = 1 },
+        .{ .tag = 278, .typ = SHORT, .count = 1, .value = height },
+        .{ .tag = 279, .typ = LONG, .count = 1, .value = pixel_bytes },
+        .{ .tag = 33550, .typ = DOUBLE, .count = 3, .value = doubles_off },
+        .{ .tag = 33922, .typ = DOUBLE, .count = 6, .value = doubles_off + 3 * 8 },
+    };
+    try out.int(u16, entries);
+    for (ifd) |e| {
+        try out.int(u16, e.tag);
+        try out.int(u16, e.typ);
+        try out.int(u32, e.count);
+        if (e.typ == SHORT) {
+            try out.int(u16, @intCast(e.value));
+            try out.int(u16, 0);
+        } else {
+            try out.int(u32, e.value);
+        }
+    }
+    try out.int(u32, 0); // no next IFD
+
+    // ModelPixelScale (0.001 deg), then ModelTiepoint (0,0,0 -> lon,lat,0)
+    const lon = -3.0 + @as(f64, @floatFromInt(index % 100)) * 0.01;
+    for ([_]f64{ 0.001, 0.001, 0, 0, 0, 0, lon, 52.0, 0 }) |d| try out.int(u64, @bitCast(d));
+
+    for (0..height) |y| {
+        for (0..width) |x| {
+            const v: u8 = @truncate(x ^ y ^ index);
+            try out.bytes(&.{v});
+        }
+    }
+}
+
+// ============================================================================
+// Corpus Directory
+// ============================================================================
+
+pub const Document = struct {
+    path: [:0]u8,
+    kind: Kind,
+    size: u64,
+};
+
+/// Write `per_kind` documents of every kind under dir (created if
+/// needed) plus dir/manifest.txt listing them. Caller frees with freeCorpus.
+pub fn writeCorpus(gpa: std.mem.Allocator, dir: []const u8, per_kind: usize) ![]Document {
+    try std.fs.cwd().makePath(dir);
+    const abs_dir = try std.fs.cwd().realpathAlloc(gpa, dir);
+    defer gpa.free(abs_dir);
+
+    var docs: std.ArrayList(Document) = .empty;
+    errdefer {
+        for (docs.items) |d| gpa.free(d.path);
+        docs.deinit(gpa);
+    }
+    var manifest: std.ArrayList(u8) = .empty;
+    defer manifest.deinit(gpa);
+
+    for (std.enums.values(Kind)) |kind| {
+        for (0..per_kind) |i| {
+            const path = try std.fmt.allocPrintSentinel(gpa, "{s}/{s}-{d:0>5}{s}", .{ abs_dir, @tagName(kind), i, extension(kind) }, 0);
+            errdefer gpa.free(path);
+            const size = try writeDocument(gpa, path, kind, i);
+            try docs.append(gpa, .{ .path = path, .kind = kind, .size = size });
+            try manifest.print(gpa, "{s}\n", .{path});
+        }
+    }
+
+    const manifest_path = try std.fmt.allocPrint(gpa, "{s}/manifest.txt", .{abs_dir});
+    defer gpa.free(manifest_path);
+    const file = try std.fs.cwd().createFile(manifest_path, .{});
+    defer file.close();
+    try file.writeAll(manifest.items);
+
+    return docs.toOwnedSlice(gpa);
+}
+
+pub fn freeCorpus(gpa: std.mem.Allocator, docs: []const Document) void {
+    for (docs) |d| gpa.free(d.path);
+    gpa.free(docs);
+}
+
+test "pdf xref offsets point at objects" {
+    var out = Out{ .gpa = std.testing.allocator };
+    defer out.buf.deinit(std.testing.allocator);
+    try pdf(&out, 2, 0);
+    const data = out.buf.items;
+    const xref = std.mem.lastIndexOf(u8, data, "xref\n").?;
+    var lines = std.mem.splitScalar(u8, data[xref..], '\n');
+    _ = lines.next();
+    _ = lines.next();
+    _ = lines.next();
+    var obj: usize = 1;
+    while (lines.next()) |line| : (obj += 1) {
+        if (!std.mem.endsWith(u8, line, " n ")) break;
+        const off = try std.fmt.parseInt(usize, line[0..10], 10);
+        var want: [16]u8 = undefined;
+        try std.testing.expect(std.mem.startsWith(u8, data[off..], try std.fmt.bufPrint(&want, "{d} 0 obj", .{obj})));
+    }
+    try std.testing.expectEqual(@as(usize, 8), obj);
+}
@@ -1,6 +1,8 @@
 // Docudactyl FFI Build Configuration
 //
-// Builds libdocudactyl_ffi.so (shared) and libdocudactyl_ffi.a (static)
+// Builds libdocudactyl_ffi.so (shared), libdocudactyl_ffi.a (static) and
+// the ddac-parse-worker helper executable (isolated parsing); `zig build
+// bench` builds and runs the ddac-bench harness
 // Links against: poppler-glib, tesseract, FFmpeg, libxml2, GDAL, libvips, lmdb
 //
 // Requires Zig 0.15+
@@ -48,6 +50,22 @@ pub fn build(b: *std.Build) void {
     });
     b.installArtifact(lib_static);
 
+    // ── Isolated parse worker (ddac_isolate_create) ─────────────────
+    // Carries the whole library statically; spawned per worker slot.
+    const worker_module = b.createModule(.{
+        .root_source_file = b.path("src/parse_worker.zig"),
+        .target = target,
+        .optimize = optimize,
+        .link_libc = true,
+    });
+    linkCLibrariesOnModule(worker_module);
+
+    const worker = b.addExecutable(.{
+        .name = "ddac-parse-worker",
+        .root_module = worker_module,
+    });
+    b.installArtifact(worker);
+
     // ── Unit tests ──────────────────────────────────────────────────
     const test_module = b.createModule(.{
         .root_source_file = b.path("src/docudactyl_ffi.zig"),
@@ -92,6 +110,36 @@ pub fn build(b: *std.Build) void {
     // Make `zig build test` run both unit and integration tests
     test_step.dependOn(&run_integ_tests.step);
 
+    // ── Benchmark harness (bench/bench.zig) ───────────────────────
+    // `zig build bench -Doptimize=ReleaseFast -- [ddac-bench args]`.
+    // Like the integration tests, it drives the C ABI of the built
+    // shared library.
+    const bench_module = b.createModule(.{
+        .root_source_file = b.path("bench/bench.zig"),
+        .target = target,
+        .optimize = optimize,
+        .link_libc = true,
+    });
+    bench_module.addLibraryPath(lib.getEmittedBinDirectory());
+    bench_module.addRPath(lib.getEmittedBinDirectory());
+    bench_module.linkLibrary(lib);
+
+    const bench_exe = b.addExecutable(.{
+        .name = "ddac-bench",
+        .root_module = bench_module,
+    });
+    const run_bench = b.addRunArtifact(bench_exe);
+    if (b.args) |args| run_bench.addArgs(args);
+    const bench_step = b.step("bench", "Run the benchmark harness (args after --)");
+    bench_step.dependOn(&run_bench.step);
+    bench_step.dependOn(&b.addInstallArtifact(bench_exe, .{}).step);
+
+    // Harness self-tests (TSV round-trip, regression rule, corpus)
+    const bench_tests = b.addTest(.{
+        .root_module = bench_module,
+    });
+    test_step.dependOn(&b.addRunArtifact(bench_tests).step);
+
     // ── Documentation ───────────────────────────────────────────────
     const docs_module = b.createModule(.{
         .root_source_file = b.path("src/docudactyl_ffi.zig"),
@@ -14,13 +14,34 @@
 //
 // Cache layout per entry:
 //   Key:   document path (variable-length string)
-//   Value: [mtime: i64][file_size: i64][result_bytes: 952]
-//          Total: 968 bytes per entry (fixed for ddac_parse_result_t)
+//   Value: [mtime: i64][file_size: i64][result record][stages_mask: u64]
+// The result record is result_codec.zig's compact encoding of the 952-byte
+// ddac_parse_result_t (typically ~150 bytes); lookups expand it back, and
+// raw 952-byte results from older caches are still read.
+// The stages mask records which DDAC_STAGE_* results the document's
+// .stages.capnp holds, so a re-extraction run plans from the cache scan
+// alone. Entries written before it was stored read as mask 0.
 //
 // Each Chapel locale should have its own LMDB environment to avoid
 // cross-locale write locking. Reads are fully concurrent.
+//
+// The _batch entry points handle a whole driver chunk in one read txn and
+// one write txn, so tasks contend for LMDB's single writer lock once per
+// chunk rather than once per document. ddac_cache_init_ex can also drop
+// per-commit fsync (MDB_NOSYNC / MDB_WRITEMAP); durability then comes from
+// periodic ddac_cache_sync calls.
+//
+// Content-addressed layout (DDAC_CACHE_CONTENT, separate environment):
+//   DBI "paths":   document path -> [mtime: i64][file_size: i64][sha256: 64]
+//   DBI "content": sha256 hex    -> [result record][stage blob: 0..N]
+// A lookup first resolves the path; if that misses, the conduit's SHA-256
+// is tried directly, so moved files and exact duplicates hit the content
+// DBI and only need an 80-byte index update. The stage blob is the
+// document's .stages.capnp output, re-materialised on a content hit.
 
 const std = @import("std");
+const metrics = @import("metrics.zig");
+const result_codec = @import("result_codec.zig");
 
 const lmdb = @cImport({
     @cInclude("lmdb.h");
@@ -33,19 +54,42 @@ const lmdb = @cImport({
 /// Size of the metadata prefix in each cache value (mtime + file_size).
 const META_SIZE: usize = 16; // 8 + 8
 
-/// Default maximum database size (10 GB — enough for ~10M entries).
+/// Size of the stages mask that follows the result bytes.
+const MASK_SIZE: usize = 8;
+
+/// Default maximum database size (10 GB — ~40M entries of ~250 bytes).
 const DEFAULT_MAX_SIZE_MB: u64 = 10240;
 
 /// Maximum number of readers (one per Chapel task per locale).
 const MAX_READERS: c_uint = 256;
 
+/// ddac_cache_init_ex flags (match DDAC_CACHE_* in docudactyl_ffi.h).
+/// NOSYNC: commits skip fsync; call ddac_cache_sync periodically.
+pub const CACHE_NOSYNC: u32 = 0x1;
+/// WRITEMAP: write through the memory map (implies async flush on sync).
+pub const CACHE_WRITEMAP: u32 = 0x2;
+/// CONTENT: two-DBI content-addressed layout (see header comment).
+pub const CACHE_CONTENT: u32 = 0x4;
+
+/// Length of a hex SHA-256 digest (content DBI key).
+const SHA_HEX_LEN: usize = 64;
+
+/// Size of a path index value: mtime + file_size + sha256 hex.
+const INDEX_SIZE: usize = META_SIZE + SHA_HEX_LEN;
+
+/// Stage blobs larger than this are not cached (result still is).
+const MAX_STAGE_BLOB: usize = 16 * 1024 * 1024;
+
 // ============================================================================
 // Cache Handle
 // ============================================================================
 
 const CacheState = struct {
     env: *lmdb.MDB_env,
+    /// Path-keyed entries, or the "paths" index in content-addressed mode.
     dbi: lmdb.MDB_dbi,
+    /// "content" DBI; set only when opened with CACHE_CONTENT.
+    content_dbi: ?lmdb.MDB_dbi = null,
     allocator: std.mem.Allocator,
 };
 
@@ -61,6 +105,17 @@ const CacheState = struct {
 export fn ddac_cache_init(
     dir_path: ?[*:0]const u8,
     max_size_mb: u64,
+) ?*anyopaque {
+    return ddac_cache_init_ex(dir_path, max_size_mb, 0);
+}
+
+/// Initialise LMDB cache with durability flags (CACHE_NOSYNC, CACHE_WRITEMAP).
+/// With either flag a crash can lose commits since the last ddac_cache_sync,
+/// but never corrupts the database.
+export fn ddac_cache_init_ex(
+    dir_path: ?[*:0]const u8,
+    max_size_mb: u64,
+    flags: u32,
 ) ?*anyopaque {
     const path = dir_path orelse return null;
     const allocator = std.heap.c_allocator;
@@ -76,13 +131,20 @@ export fn ddac_cache_init(
     // Allow multiple concurrent readers
     _ = lmdb.mdb_env_set_maxreaders(e, MAX_READERS);
 
+    const content_mode = flags & CACHE_CONTENT != 0;
+    if (content_mode) _ = lmdb.mdb_env_set_maxdbs(e, 2);
+
+    var env_flags: c_uint = 0;
+    if (flags & CACHE_NOSYNC != 0) env_flags |= lmdb.MDB_NOSYNC;
+    if (flags & CACHE_WRITEMAP != 0) env_flags |= lmdb.MDB_WRITEMAP | lmdb.MDB_MAPASYNC | lmdb.MDB_NOSYNC;
+
     // Open environment (directory mode)
-    if (lmdb.mdb_env_open(e, path, 0, 0o644) != 0) {
+    if (lmdb.mdb_env_open(e, path, env_flags, 0o644) != 0) {
         lmdb.mdb_env_close(e);
         return null;
     }
 
-    // Open the default (unnamed) database
+    // Open the default (unnamed) database, or the two named DBIs
     var txn: ?*lmdb.MDB_txn = null;
     if (lmdb.mdb_txn_begin(e, null, 0, &txn) != 0) {
         lmdb.mdb_env_close(e);
@@ -90,11 +152,25 @@ export fn ddac_cache_init(
     }
 
     var dbi: lmdb.MDB_dbi = 0;
-    if (lmdb.mdb_dbi_open(txn, null, 0, &dbi) != 0) {
+    var content_dbi: ?lmdb.MDB_dbi = null;
+    const dbi_rc = if (content_mode)
+        lmdb.mdb_dbi_open(txn, "paths", lmdb.MDB_CREATE, &dbi)
+    else
+        lmdb.mdb_dbi_open(txn, null, 0, &dbi);
+    if (dbi_rc != 0) {
         lmdb.mdb_txn_abort(txn);
         lmdb.mdb_env_close(e);
         return null;
     }
+    if (content_mode) {
+        var cdbi: lmdb.MDB_dbi = 0;
+        if (lmdb.mdb_dbi_open(txn, "content", lmdb.MDB_CREATE, &cdbi) != 0) {
+            lmdb.mdb_txn_abort(txn);
+            lmdb.mdb_env_close(e);
+            return null;
+        }
+        content_dbi = cdbi;
+    }
     if (lmdb.mdb_txn_commit(txn) != 0) {
         lmdb.mdb_env_close(e);
         return null;
@@ -107,6 +183,7 @@ export fn ddac_cache_init(
     state.* = .{
         .env = e,
         .dbi = dbi,
+        .content_dbi = content_dbi,
         .allocator = allocator,
     };
 
@@ -124,6 +201,137 @@ export fn ddac_cache_free(handle: ?*anyopaque) void {
     state.allocator.destroy(state);
 }
 
+/// Look up one entry inside an open transaction. Returns true on a hit
+/// (mtime and file_size match) after copying the result into out and,
+/// if mask_out is given, the stored stages mask (0 if none) into it.
+fn getInTxn(
+    state: *CacheState,
+    txn: ?*lmdb.MDB_txn,
+    path: [*:0]const u8,
+    mtime: i64,
+    file_size: i64,
+    out: [*]u8,
+    result_size: usize,
+    mask_out: ?*u64,
+) bool {
+    const path_slice = std.mem.span(path);
+    // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_get
+    // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
+    var key = lmdb.MDB_val{ .mv_size = path_slice.len, .mv_data = @constCast(@ptrCast(path_slice.ptr)) };
+    var data: lmdb.MDB_val = undefined;
+
+    if (lmdb.mdb_get(txn, state.dbi, &key, &data) != 0) return false;
+
+    // Content-addressed: the path entry is an index into the content DBI
+    if (state.content_dbi != null) {
+        if (data.mv_size != INDEX_SIZE) return false;
+        // SAFETY: LMDB mdb_get returns mv_data pointing into the memory-mapped database; valid for the transaction lifetime
+        const index_bytes: [*]const u8 = @ptrCast(data.mv_data);
+        if (std.mem.readInt(i64, index_bytes[0..8], .little) != mtime) return false;
+        if (std.mem.readInt(i64, index_bytes[8..16], .little) != file_size) return false;
+        if (mask_out) |m| m.* = 0; // (the mask lives in the content entry's stage blob)
+        return getContentInTxn(state, txn, index_bytes[META_SIZE..INDEX_SIZE], out, result_size, null);
+    }
+
+    if (data.mv_size < META_SIZE) return false;
+
+    // Check mtime and file_size
+    // SAFETY: LMDB mdb_get returns mv_data pointing into the memory-mapped database; valid for the transaction lifetime
+    const value_bytes: [*]const u8 = @ptrCast(data.mv_data);
+    const cached_mtime = std.mem.readInt(i64, value_bytes[0..8], .little);
+    const cached_size = std.mem.readInt(i64, value_bytes[8..16], .little);
+
+    if (cached_mtime != mtime or cached_size != file_size) return false;
+
+    // Cache hit — expand the result record
+    const value = value_bytes[META_SIZE..data.mv_size];
+    const used = result_codec.decodeValue(value, out[0..result_size]) orelse return false;
+    if (mask_out) |m| {
+        m.* = if (value.len - used >= MASK_SIZE)
+            std.mem.readInt(u64, value[used..][0..MASK_SIZE], .little)
+        else
+            0;
+    }
+    return true;
+}
+
+/// Fetch a content entry by SHA-256 hex. Expands the result into out and,
+/// if stage_path is given and the entry carries a stage blob, writes the
+/// blob there. Returns true on a hit.
+fn getContentInTxn(
+    state: *CacheState,
+    txn: ?*lmdb.MDB_txn,
+    sha: []const u8,
+    out: [*]u8,
+    result_size: usize,
+    stage_path: ?[*:0]const u8,
+) bool {
+    const cdbi = state.content_dbi orelse return false;
+    // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_get
+    // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
+    var key = lmdb.MDB_val{ .mv_size = sha.len, .mv_data = @constCast(@ptrCast(sha.ptr)) };
+    var data: lmdb.MDB_val = undefined;
+    if (lmdb.mdb_get(txn, cdbi, &key, &data) != 0) return false;
+
+    // SAFETY: LMDB mdb_get returns mv_data pointing into the memory-mapped database; valid for the transaction lifetime
+    const value_bytes: [*]const u8 = @ptrCast(data.mv_data);
+    const value = value_bytes[0..data.mv_size];
+    const used = result_codec.decodeValue(value, out[0..result_size]) orelse return false;
+
+    if (stage_path) |sp| {
+        if (value.len > used) {
+            const blob = value[used..];
+            writeBlob(sp, blob) catch |err| {
+                std.log.warn("Cache: stage blob restore failed: {s}", .{@errorName(err)});
+            };
+        }
+    }
+    return true;
+}
+
+fn writeBlob(path: [*:0]const u8, blob: []const u8) !void {
+    const file = try std.fs.createFileAbsoluteZ(path, .{});
+    defer file.close();
+    try file.writeAll(blob);
+}
+
+/// Extract the 64-char digest from a NUL-terminated SHA-256 hex string.
+fn shaSlice(sha: ?[*:0]const u8) ?[]const u8 {
+    const s = std.mem.span(sha orelse return null);
+    return if (s.len == SHA_HEX_LEN) s else null;
+}
+
+/// Write one entry inside an open write transaction. Returns true on success.
+fn putInTxn(
+    state: *CacheState,
+    txn: ?*lmdb.MDB_txn,
+    path: [*:0]const u8,
+    mtime: i64,
+    file_size: i64,
+    result_bytes: [*]const u8,
+    result_size: usize,
+    stages_mask: u64,
+) bool {
+    if (result_size != result_codec.ROW_SIZE) return false;
+
+    // Build value: [mtime][file_size][result record][stages_mask]
+    var value_buf: [META_SIZE + result_codec.MAX_RECORD + MASK_SIZE]u8 = undefined;
+    std.mem.writeInt(i64, value_buf[0..8], mtime, .little);
+    std.mem.writeInt(i64, value_buf[8..16], file_size, .little);
+    const record_len = result_codec.encode(result_bytes[0..result_codec.ROW_SIZE], value_buf[META_SIZE..][0..result_codec.MAX_RECORD]);
+    const value_size = META_SIZE + record_len + MASK_SIZE;
+    std.mem.writeInt(u64, value_buf[META_SIZE + record_len ..][0..MASK_SIZE], stages_mask, .little);
+
+    const path_slice = std.mem.span(path);
+    // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_put for keys
+    // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
+    var key = lmdb.MDB_val{ .mv_size = path_slice.len, .mv_data = @constCast(@ptrCast(path_slice.ptr)) };
+    // SAFETY: value_buf is a stack-allocated array; @ptrCast converts *[N]u8 to *anyopaque for MDB_val.mv_data; LMDB copies it during mdb_put
+    var data = lmdb.MDB_val{ .mv_size = value_size, .mv_data = @ptrCast(&value_buf) };
+
+    return lmdb.mdb_put(txn, state.dbi, &key, &data, 0) == 0;
+}
+
 /// Look up a cached result by document path.
 /// If the cache has a matching entry (same mtime and file_size), copies
 /// the cached ParseResult into result_out and returns 1 (hit).
@@ -139,6 +347,8 @@ export fn ddac_cache_lookup(
     result_out: ?[*]u8,
     result_size: usize,
 ) c_int {
+    const span = metrics.begin(.cache_l1);
+    defer span.end();
     const ptr = handle orelse return 0;
     // SAFETY: ptr originates from ddac_cache_init() which stores a *CacheState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *CacheState = @ptrCast(@alignCast(ptr));
@@ -150,36 +360,12 @@ export fn ddac_cache_lookup(
     if (lmdb.mdb_txn_begin(state.env, null, lmdb.MDB_RDONLY, &txn) != 0) return 0;
     defer lmdb.mdb_txn_abort(txn);
 
-    // Look up by path
-    const path_slice = std.mem.span(path);
-    // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_get
-    // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
-    var key = lmdb.MDB_val{ .mv_size = path_slice.len, .mv_data = @constCast(@ptrCast(path_slice.ptr)) };
-    var data: lmdb.MDB_val = undefined;
-
-    if (lmdb.mdb_get(txn, state.dbi, &key, &data) != 0) return 0;
-
-    // Validate value size
-    const expected_size = META_SIZE + result_size;
-    if (data.mv_size < expected_size) return 0;
-
-    // Check mtime and file_size
-    // SAFETY: LMDB mdb_get returns mv_data pointing into the memory-mapped database; valid for the transaction lifetime
-    const value_bytes: [*]const u8 = @ptrCast(data.mv_data);
-    const cached_mtime = std.mem.readInt(i64, value_bytes[0..8], .little);
-    const cached_size = std.mem.readInt(i64, value_bytes[8..16], .little);
-
-    if (cached_mtime != mtime or cached_size != file_size) return 0;
-
-    // Cache hit — copy result
-    const copy_len = @min(result_size, data.mv_size - META_SIZE);
-    @memcpy(out[0..copy_len], value_bytes[META_SIZE .. META_SIZE + copy_len]);
-
-    return 1; // hit
+    return if (getInTxn(state, txn, path, mtime, file_size, out, result_size, null)) 1 else 0;
 }
 
 /// Store a parse result in the cache, keyed by document path.
-/// Overwrites any existing entry for the same path.
+/// Overwrites any existing entry for the same path. The entry's stages
+/// mask is 0 (use ddac_cache_store_batch to record one).
 ///
 /// result: pointer to a 952-byte ParseResult struct.
 /// result_size: must be 952 (sizeof ddac_parse_result_t).
@@ -196,28 +382,14 @@ export fn ddac_cache_store(
     const state: *CacheState = @ptrCast(@alignCast(ptr));
     const path = doc_path orelse return;
     const result_bytes = result orelse return;
-
-    // Build value: [mtime][file_size][result_bytes]
-    const value_size = META_SIZE + result_size;
-    var value_buf: [META_SIZE + 1024]u8 = undefined; // 952 + 16 + slack
-    if (value_size > value_buf.len) return;
-
-    std.mem.writeInt(i64, value_buf[0..8], mtime, .little);
-    std.mem.writeInt(i64, value_buf[8..16], file_size, .little);
-    @memcpy(value_buf[META_SIZE .. META_SIZE + result_size], result_bytes[0..result_size]);
+    // Content-addressed caches need the SHA-256: use ddac_cache_store_content_batch
+    if (state.content_dbi != null) return;
 
     // Begin write transaction
     var txn: ?*lmdb.MDB_txn = null;
     if (lmdb.mdb_txn_begin(state.env, null, 0, &txn) != 0) return;
 
-    const path_slice = std.mem.span(path);
-    // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_put for keys
-    // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
-    var key = lmdb.MDB_val{ .mv_size = path_slice.len, .mv_data = @constCast(@ptrCast(path_slice.ptr)) };
-    // SAFETY: value_buf is a stack-allocated array; @ptrCast converts *[N]u8 to *anyopaque for MDB_val.mv_data; valid for the transaction scope
-    var data = lmdb.MDB_val{ .mv_size = value_size, .mv_data = @ptrCast(&value_buf) };
-
-    if (lmdb.mdb_put(txn, state.dbi, &key, &data, 0) != 0) {
+    if (!putInTxn(state, txn, path, mtime, file_size, result_bytes, result_size, 0)) {
         lmdb.mdb_txn_abort(txn);
         return;
     }
@@ -225,6 +397,322 @@ export fn ddac_cache_store(
     _ = lmdb.mdb_txn_commit(txn);
 }
 
+/// Test bit i of a little-endian bitmap (bit i lives in byte i/8, bit i%8).
+inline fn bitIsSet(bits: [*]const u8, i: usize) bool {
+    return bits[i >> 3] & (@as(u8, 1) << @intCast(i & 7)) != 0;
+}
+
+/// Batch lookup: n documents in ONE read-only transaction.
+///
+/// paths/mtimes/sizes: parallel arrays of n entries. Entries with a null
+///   path or negative mtime/size are treated as misses (metadata unknown).
+/// results_out: n * result_size bytes; hit slots are overwritten, miss
+///   slots are left untouched.
+/// stage_masks_out: optional n entries; hit slots receive the stages mask
+///   stored with the entry (0 if it predates stored masks).
+/// hit_bitmap: (n + 7) / 8 bytes, zeroed then bit i set on a hit.
+/// Returns the number of hits.
+export fn ddac_cache_lookup_batch(
+    handle: ?*anyopaque,
+    paths: ?[*]const ?[*:0]const u8,
+    mtimes: ?[*]const i64,
+    sizes: ?[*]const i64,
+    results_out: ?[*]u8,
+    result_size: usize,
+    stage_masks_out: ?[*]u64,
+    hit_bitmap: ?[*]u8,
+    n: u32,
+) u32 {
+    const span = metrics.begin(.cache_l1);
+    defer span.end();
+    const bits = hit_bitmap orelse return 0;
+    @memset(bits[0 .. (@as(usize, n) + 7) / 8], 0);
+
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_cache_init() which stores a *CacheState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *CacheState = @ptrCast(@alignCast(ptr));
+    const path_arr = paths orelse return 0;
+    const mtime_arr = mtimes orelse return 0;
+    const size_arr = sizes orelse return 0;
+    const out = results_out orelse return 0;
+    if (n == 0) return 0;
+
+    var txn: ?*lmdb.MDB_txn = null;
+    if (lmdb.mdb_txn_begin(state.env, null, lmdb.MDB_RDONLY, &txn) != 0) return 0;
+    defer lmdb.mdb_txn_abort(txn);
+
+    var hits: u32 = 0;
+    for (0..n) |i| {
+        const path = path_arr[i] orelse continue;
+        if (mtime_arr[i] < 0 or size_arr[i] < 0) continue;
+        const mask_out: ?*u64 = if (stage_masks_out) |m| &m[i] else null;
+        if (getInTxn(state, txn, path, mtime_arr[i], size_arr[i], out + i * result_size, result_size, mask_out)) {
+            bits[i >> 3] |= @as(u8, 1) << @intCast(i & 7);
+            hits += 1;
+        }
+    }
+    return hits;
+}
+
+/// Batch store: n documents in ONE write transaction and one commit.
+///
+/// stage_masks: optional n entries, the DDAC_STAGE_* mask each document's
+///   stage message holds (null stores 0).
+/// store_mask: optional (n + 7) / 8 byte bitmap; only entries whose bit
+///   is set are written (e.g. successful parses). Null stores every entry.
+/// Entries with a null path or negative mtime/size are skipped.
+/// Returns the number of entries written (0 if the commit failed).
+export fn ddac_cache_store_batch(
+    handle: ?*anyopaque,
+    paths: ?[*]const ?[*:0]const u8,
+    mtimes: ?[*]const i64,
+    sizes: ?[*]const i64,
+    results: ?[*]const u8,
+    result_size: usize,
+    stage_masks: ?[*]const u64,
+    store_mask: ?[*]const u8,
+    n: u32,
+) u32 {
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_cache_init() which stores a *CacheState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *CacheState = @ptrCast(@alignCast(ptr));
+    const path_arr = paths orelse return 0;
+    const mtime_arr = mtimes orelse return 0;
+    const size_arr = sizes orelse return 0;
+    const result_bytes = results orelse return 0;
+    // Content-addressed caches need the SHA-256: use ddac_cache_store_content_batch
+    if (state.content_dbi != null) return 0;
+
+    // Don't take the writer lock for an empty batch
+    var pending: u32 = 0;
+    for (0..n) |i| {
+        if (store_mask) |mask| if (!bitIsSet(mask, i)) continue;
+        if (path_arr[i] == null or mtime_arr[i] < 0 or size_arr[i] < 0) continue;
+        pending += 1;
+    }
+    if (pending == 0) return 0;
+
+    var txn: ?*lmdb.MDB_txn = null;
+    if (lmdb.mdb_txn_begin(state.env, null, 0, &txn) != 0) return 0;
+
+    var stored: u32 = 0;
+    for (0..n) |i| {
+        if (store_mask) |mask| if (!bitIsSet(mask, i)) continue;
+        const path = path_arr[i] orelse continue;
+        if (mtime_arr[i] < 0 or size_arr[i] < 0) continue;
+        const stages_mask: u64 = if (stage_masks) |m| m[i] else 0;
+        if (putInTxn(state, txn, path, mtime_arr[i], size_arr[i], result_bytes + i * result_size, result_size, stages_mask)) {
+            stored += 1;
+        } else {
+            // MDB_MAP_FULL etc. leave the txn unusable — abort the whole batch
+            lmdb.mdb_txn_abort(txn);
+            return 0;
+        }
+    }
+
+    if (lmdb.mdb_txn_commit(txn) != 0) return 0;
+    return stored;
+}
+
+/// Content-addressed batch lookup (CACHE_CONTENT caches) in ONE read txn.
+///
+/// Slot i is resolved by path first (paths/mtimes/sizes as in
+/// ddac_cache_lookup_batch); on a path miss, shas[i] (the conduit's
+/// SHA-256 hex, may be null) is looked up in the content DBI directly.
+/// Such hits set bit i in moved_bitmap: the document was moved, copied or
+/// modified in metadata only, and storing it again costs an index update.
+/// On content hits, stage_paths[i] (optional) receives the stage blob.
+/// hit_bitmap and moved_bitmap: (n + 7) / 8 bytes each, zeroed here.
+/// Returns the number of hits.
+export fn ddac_cache_lookup_content_batch(
+    handle: ?*anyopaque,
+    paths: ?[*]const ?[*:0]const u8,
+    mtimes: ?[*]const i64,
+    sizes: ?[*]const i64,
+    shas: ?[*]const ?[*:0]const u8,
+    stage_paths: ?[*]const ?[*:0]const u8,
+    results_out: ?[*]u8,
+    result_size: usize,
+    hit_bitmap: ?[*]u8,
+    moved_bitmap: ?[*]u8,
+    n: u32,
+) u32 {
+    const span = metrics.begin(.cache_l1);
+    defer span.end();
+    const bits = hit_bitmap orelse return 0;
+    const moved = moved_bitmap orelse return 0;
+    const nbytes = (@as(usize, n) + 7) / 8;
+    @memset(bits[0..nbytes], 0);
+    @memset(moved[0..nbytes], 0);
+
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_cache_init() which stores a *CacheState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *CacheState = @ptrCast(@alignCast(ptr));
+    if (state.content_dbi == null) return 0;
+    const path_arr = paths orelse return 0;
+    const mtime_arr = mtimes orelse return 0;
+    const size_arr = sizes orelse return 0;
+    const out = results_out orelse return 0;
+    if (n == 0) return 0;
+
+    var txn: ?*lmdb.MDB_txn = null;
+    if (lmdb.mdb_txn_begin(state.env, null, lmdb.MDB_RDONLY, &txn) != 0) return 0;
+    defer lmdb.mdb_txn_abort(txn);
+
+    var hits: u32 = 0;
+    for (0..n) |i| {
+        const slot_out = out + i * result_size;
+        const mask: u8 = @as(u8, 1) << @intCast(i & 7);
+
+        if (path_arr[i]) |path| {
+            if (mtime_arr[i] >= 0 and size_arr[i] >= 0 and
+                getInTxn(state, txn, path, mtime_arr[i], size_arr[i], slot_out, result_size, null))
+            {
+                bits[i >> 3] |= mask;
+                hits += 1;
+                continue;
+            }
+        }
+
+        const sha_arr = shas orelse continue;
+        const sha = shaSlice(sha_arr[i]) orelse continue;
+        const stage_path = if (stage_paths) |sp| sp[i] else null;
+        if (getContentInTxn(state, txn, sha, slot_out, result_size, stage_path)) {
+            bits[i >> 3] |= mask;
+            moved[i >> 3] |= mask;
+            hits += 1;
+        }
+    }
+    return hits;
+}
+
+/// Content-addressed batch store (CACHE_CONTENT caches) in ONE write txn.
+///
+/// For each slot selected by store_mask (null = all) with a path, valid
+/// mtime/size and a 64-char shas[i]: the path index is (re)pointed at the
+/// digest, and the result (plus the file at stage_paths[i], if given) is
+/// added to the content DBI unless that digest is already present. Pass a
+/// null stage path for moved_bitmap slots; their content already exists.
+/// Stage blobs are read before the write txn begins.
+/// Returns the number of slots indexed (0 if the commit failed).
+export fn ddac_cache_store_content_batch(
+    handle: ?*anyopaque,
+    paths: ?[*]const ?[*:0]const u8,
+    mtimes: ?[*]const i64,
+    sizes: ?[*]const i64,
+    shas: ?[*]const ?[*:0]const u8,
+    stage_paths: ?[*]const ?[*:0]const u8,
+    results: ?[*]const u8,
+    result_size: usize,
+    store_mask: ?[*]const u8,
+    n: u32,
+) u32 {
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_cache_init() which stores a *CacheState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *CacheState = @ptrCast(@alignCast(ptr));
+    const cdbi = state.content_dbi orelse return 0;
+    const path_arr = paths orelse return 0;
+    const mtime_arr = mtimes orelse return 0;
+    const size_arr = sizes orelse return 0;
+    const sha_arr = shas orelse return 0;
+    const result_bytes = results orelse return 0;
+
+    // Select slots and load stage blobs outside the writer lock
+    const allocator = state.allocator;
+    const values = allocator.alloc(?[]u8, n) catch return 0;
+    @memset(values, null);
+    defer {
+        for (values) |v| if (v) |buf| allocator.free(buf);
+        allocator.free(values);
+    }
+
+    var pending: u32 = 0;
+    for (0..n) |i| {
+        if (store_mask) |mask| if (!bitIsSet(mask, i)) continue;
+        if (path_arr[i] == null or mtime_arr[i] < 0 or size_arr[i] < 0) continue;
+        if (shaSlice(sha_arr[i]) == null) continue;
+
+        const sp = if (stage_paths) |arr| arr[i] else null;
+        values[i] = buildContentValue(allocator, result_bytes[i * result_size ..][0..result_size], sp) orelse continue;
+        pending += 1;
+    }
+    if (pending == 0) return 0;
+
+    var txn: ?*lmdb.MDB_txn = null;
+    if (lmdb.mdb_txn_begin(state.env, null, 0, &txn) != 0) return 0;
+
+    var stored: u32 = 0;
+    for (0..n) |i| {
+        const value = values[i] orelse continue;
+        const sha = shaSlice(sha_arr[i]).?;
+
+        // Content first; an existing digest (duplicate or move) is kept as is
+        // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_put for keys
+        // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
+        var ckey = lmdb.MDB_val{ .mv_size = sha.len, .mv_data = @constCast(@ptrCast(sha.ptr)) };
+        // SAFETY: value is a heap buffer owned by this call; @ptrCast converts [*]u8 to *anyopaque for MDB_val.mv_data; LMDB copies it during mdb_put
+        var cdata = lmdb.MDB_val{ .mv_size = value.len, .mv_data = @ptrCast(value.ptr) };
+        const crc = lmdb.mdb_put(txn, cdbi, &ckey, &cdata, lmdb.MDB_NOOVERWRITE);
+
+        var index_buf: [INDEX_SIZE]u8 = undefined;
+        std.mem.writeInt(i64, index_buf[0..8], mtime_arr[i], .little);
+        std.mem.writeInt(i64, index_buf[8..16], size_arr[i], .little);
+        @memcpy(index_buf[META_SIZE..], sha);
+
+        const path_slice = std.mem.span(path_arr[i].?);
+        // SAFETY: @constCast is required by LMDB's C API which takes void* for keys; the data is only read, never written by mdb_put for keys
+        // SAFETY: @ptrCast converts [*]const u8 to *anyopaque as required by MDB_val.mv_data field
+        var pkey = lmdb.MDB_val{ .mv_size = path_slice.len, .mv_data = @constCast(@ptrCast(path_slice.ptr)) };
+        // SAFETY: index_buf is a stack-allocated array; @ptrCast converts *[N]u8 to *anyopaque for MDB_val.mv_data; LMDB copies it during mdb_put
+        var pdata = lmdb.MDB_val{ .mv_size = INDEX_SIZE, .mv_data = @ptrCast(&index_buf) };
+
+        if ((crc != 0 and crc != lmdb.MDB_KEYEXIST) or
+            lmdb.mdb_put(txn, state.dbi, &pkey, &pdata, 0) != 0)
+        {
+            // MDB_MAP_FULL etc. leave the txn unusable — abort the whole batch
+            lmdb.mdb_txn_abort(txn);
+            return 0;
+        }
+        stored += 1;
+    }
+
+    if (lmdb.mdb_txn_commit(txn) != 0) return 0;
+    return stored;
+}
+
+/// Content value: result record followed by the stage blob read from
+/// stage_path (skipped if missing or larger than MAX_STAGE_BLOB).
+fn buildContentValue(allocator: std.mem.Allocator, result: []const u8, stage_path: ?[*:0]const u8) ?[]u8 {
+    if (result.len != result_codec.ROW_SIZE) return null;
+    var record_buf: [result_codec.MAX_RECORD]u8 = undefined;
+    const record = record_buf[0..result_codec.encode(result[0..result_codec.ROW_SIZE], &record_buf)];
+
+    var blob_len: usize = 0;
+    var file: ?std.fs.File = null;
+    if (stage_path) |sp| {
+        if (std.fs.openFileAbsoluteZ(sp, .{})) |f| {
+            const st = f.stat() catch null;
+            if (st != null and st.?.size <= MAX_STAGE_BLOB) {
+                file = f;
+                blob_len = @intCast(st.?.size);
+            } else f.close();
+        } else |_| {}
+    }
+    defer if (file) |f| f.close();
+
+    const value = allocator.alloc(u8, record.len + blob_len) catch return null;
+    @memcpy(value[0..record.len], record);
+    if (file) |f| {
+        const got = f.readAll(value[record.len..]) catch 0;
+        if (got != blob_len) {
+            // Truncated read: cache the result without a blob
+            allocator.free(value);
+            return allocator.dupe(u8, record) catch null;
+        }
+    }
+    return value;
+}
+
 /// Return the number of entries in the cache.
 export fn ddac_cache_count(handle: ?*anyopaque) u64 {
     const ptr = handle orelse return 0;
@@ -235,8 +723,9 @@ export fn ddac_cache_count(handle: ?*anyopaque) u64 {
     if (lmdb.mdb_txn_begin(state.env, null, lmdb.MDB_RDONLY, &txn) != 0) return 0;
     defer lmdb.mdb_txn_abort(txn);
 
+    // Content-addressed: count distinct documents, not paths
     var stat: lmdb.MDB_stat = undefined;
-    if (lmdb.mdb_stat(txn, state.dbi, &stat) != 0) return 0;
+    if (lmdb.mdb_stat(txn, state.content_dbi orelse state.dbi, &stat) != 0) return 0;
 
     return @intCast(stat.ms_entries);
 }
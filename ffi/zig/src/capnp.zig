@@ -1,9 +1,11 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
-// Docudactyl — Minimal Cap'n Proto Single-Segment Message Builder
+// Docudactyl — Minimal Cap'n Proto Message Builder
 //
 // Produces valid Cap'n Proto binary messages readable by any standard decoder.
-// Single-segment only (sufficient for per-document stage results).
+// Messages are built in a per-handle segment arena: segment 0 holds ordinary
+// documents, and large TOCs or entity lists spill into further segments
+// through far pointers. Output is the standard framing or packed encoding.
 // No external dependencies — pure Zig implementation of the wire format.
 //
 // Wire format reference: https://capnproto.org/encoding.html
@@ -144,73 +146,201 @@ const LIST_BYTE: u3 = 2;
 const LIST_POINTER: u3 = 6;
 const LIST_COMPOSITE: u3 = 7;
 
+/// Pointer kind (bits 0-1) of a far pointer to a landing pad in another segment.
+const PTR_FAR: u64 = 2;
+
+/// Size of segment 0. Segment i is at least SEGMENT_BYTES << i, so a
+/// message grows geometrically and almost every document fits segment 0.
+pub const SEGMENT_BYTES: usize = 64 * 1024;
+
+/// Segments per message. Also keeps the first byte of an unpacked message
+/// (segment count - 1) below 16, which isPacked relies on.
+pub const MAX_SEGMENTS: usize = 16;
+
+/// Largest message header: segment count + one size per segment, padded to a word.
+pub const MAX_HEADER: usize = 8 + 4 * MAX_SEGMENTS;
+
+/// Arenas holding more than this are shrunk back to segment 0 on reset, so
+/// one outsized document does not pin its segments for the rest of the run.
+const RETAIN_LIMIT: usize = 16 * 1024 * 1024;
+
+// ============================================================================
+// Segment Arena
+// ============================================================================
+
+/// Segments for one message at a time, kept across messages. One arena
+/// lives in each parse handle; reset() zeroes only the bytes the previous
+/// message used, so a document does not pay for clearing the whole arena.
+pub const Arena = struct {
+    allocator: std.mem.Allocator,
+    segs: [MAX_SEGMENTS][]align(8) u8 = undefined,
+    /// Bytes of each segment used by the current message
+    used: [MAX_SEGMENTS]usize = [_]usize{0} ** MAX_SEGMENTS,
+    /// Segments in the current message
+    count: usize = 0,
+    /// Segments allocated (count <= owned; the rest wait for reuse)
+    owned: usize = 0,
+    /// Packed output / unpacked input of the current message
+    scratch: std.ArrayList(u8) = .{},
+
+    pub fn init(allocator: std.mem.Allocator) Arena {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *Arena) void {
+        for (self.segs[0..self.owned]) |seg| self.allocator.free(seg);
+        self.scratch.deinit(self.allocator);
+        self.* = undefined;
+    }
+
+    /// Start a new message: zero what the last one used, keep the segments.
+    pub fn reset(self: *Arena) void {
+        var held: usize = 0;
+        for (0..self.count) |i| @memset(self.segs[i][0..self.used[i]], 0);
+        for (self.segs[0..self.owned]) |seg| held += seg.len;
+        if (held > RETAIN_LIMIT) {
+            for (self.segs[@min(self.owned, 1)..self.owned]) |seg| self.allocator.free(seg);
+            self.owned = @min(self.owned, 1);
+        }
+        if (self.scratch.capacity > RETAIN_LIMIT) {
+            self.scratch.clearAndFree(self.allocator);
+        } else {
+            self.scratch.clearRetainingCapacity();
+        }
+        @memset(self.used[0..self.count], 0);
+        self.count = 0;
+    }
+
+    /// Open the next segment with room for at least min_bytes.
+    /// Returns its index, or null past MAX_SEGMENTS or on OOM.
+    fn addSegment(self: *Arena, min_bytes: usize) ?usize {
+        if (self.count == MAX_SEGMENTS) return null;
+        const i = self.count;
+        if (i == self.owned or self.segs[i].len < min_bytes) {
+            const size = @max(SEGMENT_BYTES << @intCast(i), std.mem.alignForward(usize, min_bytes, 8));
+            const seg = self.allocator.alignedAlloc(u8, comptime std.mem.Alignment.fromByteUnits(8), size) catch return null;
+            @memset(seg, 0);
+            if (i < self.owned) self.allocator.free(self.segs[i]) else self.owned += 1;
+            self.segs[i] = seg;
+        }
+        self.count += 1;
+        return i;
+    }
+};
+
+/// Position of a word: segment index and byte offset within it.
+pub const Ref = struct {
+    seg: usize,
+    off: usize,
+};
+
+/// Where an object was allocated, and the landing pad before it when the
+/// pointer to it lives in another segment.
+const Placement = struct {
+    at: Ref,
+    pad: ?Ref,
+};
+
 // ============================================================================
-// Single-Segment Message Builder
+// Message Builder
 // ============================================================================
 
-/// Builds a Cap'n Proto single-segment message in a caller-provided buffer.
+/// Builds a Cap'n Proto message in an Arena. Objects go in the last segment;
+/// when it is full a larger one is opened and cross-segment pointers become
+/// far pointers, so no document outgrows the builder.
 ///
 /// Usage:
-///   var buf: [65536]u8 align(8) = undefined;
-///   var b = Builder.init(&buf);
+///   var arena = Arena.init(allocator); // once per handle
+///   var b = Builder.init(&arena);      // per document
 ///   b.initRoot();
 ///   b.setU64(OFF_STAGES_MASK, mask);
 ///   b.setText(PTR_LANG_SCRIPT, "Latin");
-///   try b.writeMessage(file);
+///   try b.writeMessage(file, false);
 pub const Builder = struct {
-    buf: [*]u8,
-    cap: usize,
-    pos: usize, // next free byte (always 8-byte aligned)
-    data_start: usize, // byte offset of root struct data section
-    ptr_start: usize, // byte offset of root struct pointer section
-
-    /// Initialise a builder with a zeroed buffer.
-    pub fn init(buffer: []align(8) u8) Builder {
-        @memset(buffer, 0);
-        return .{
-            .buf = buffer.ptr,
-            .cap = buffer.len,
-            .pos = 0,
-            .data_start = 0,
-            .ptr_start = 0,
-        };
+    arena: *Arena,
+    data_start: usize = 0, // byte offset of root struct data section (segment 0)
+    ptr_start: usize = 0, // byte offset of root struct pointer section (segment 0)
+
+    /// Start a message, reusing the arena's segments.
+    pub fn init(arena: *Arena) Builder {
+        arena.reset();
+        return .{ .arena = arena };
     }
 
     /// Set up the root struct. Must be called before setting any fields.
-    /// Allocates: 1 root pointer word + DATA_WORDS + PTR_WORDS.
+    /// Allocates: 1 root pointer word + DATA_WORDS + PTR_WORDS in segment 0.
     pub fn initRoot(self: *Builder) void {
-        self.pos = 8; // skip root pointer at word 0
-        self.data_start = 8;
-        self.pos += @as(usize, DATA_WORDS) * 8;
-        self.ptr_start = self.pos;
-        self.pos += @as(usize, PTR_WORDS) * 8;
+        const root_bytes = (1 + @as(usize, DATA_WORDS) + @as(usize, PTR_WORDS)) * 8;
+        const seg = self.arena.addSegment(root_bytes) orelse return;
+        self.arena.used[seg] = root_bytes;
+        self.data_start = 8; // root pointer at word 0
+        self.ptr_start = self.data_start + @as(usize, DATA_WORDS) * 8;
 
         // Root struct pointer: type=struct(0), offset=0, dw=DATA_WORDS, pw=PTR_WORDS
         // Offset 0 means struct data immediately follows the pointer word.
-        const val: u64 = (@as(u64, DATA_WORDS) << 32) | (@as(u64, PTR_WORDS) << 48);
-        self.wr64(0, val);
+        self.wr64(.{ .seg = 0, .off = 0 }, rootPointer());
+    }
+
+    /// Set up the root struct from a message written earlier (packed or
+    /// not), instead of initRoot. Setters then overwrite its fields in
+    /// place and new objects are allocated after its last segment, so the
+    /// message gains fields without its existing ones being re-encoded.
+    /// Returns false, leaving the builder empty, if the message is not a
+    /// StageResults root of this layout.
+    pub fn reopen(self: *Builder, message: []const u8) bool {
+        const a = self.arena;
+        var msg = message;
+        if (isPacked(message)) {
+            a.scratch.clearRetainingCapacity();
+            if (!unpackAppend(a.allocator, &a.scratch, message)) return false;
+            msg = a.scratch.items;
+        }
+        var table: [MAX_SEGMENTS][]const u8 = undefined;
+        const segs = segmentTable(msg, &table) orelse return false;
+        const root_len = (1 + @as(usize, DATA_WORDS) + @as(usize, PTR_WORDS)) * 8;
+        if (segs[0].len < root_len) return false;
+        if (std.mem.readInt(u64, segs[0][0..8], .little) != rootPointer()) return false;
+
+        for (segs) |seg| {
+            const i = a.addSegment(seg.len) orelse {
+                a.reset();
+                return false;
+            };
+            @memcpy(a.segs[i][0..seg.len], seg);
+            a.used[i] = seg.len;
+        }
+        self.data_start = 8;
+        self.ptr_start = 8 + @as(usize, DATA_WORDS) * 8;
+        return true;
+    }
+
+    /// Read back a UInt64 data field (e.g. the stages mask of a reopened message).
+    pub fn getU64(self: *const Builder, off: usize) u64 {
+        if (self.arena.count == 0) return 0;
+        const at = self.data_start + off;
+        return std.mem.readInt(u64, self.arena.segs[0][at..][0..8], .little);
     }
 
     // ── Data section setters ──────────────────────────────────────────
 
     pub fn setU64(self: *Builder, off: usize, val: u64) void {
-        self.wr64(self.data_start + off, val);
+        self.wr64(self.dataRef(off), val);
     }
 
     pub fn setU32(self: *Builder, off: usize, val: u32) void {
-        self.wr32(self.data_start + off, val);
+        self.wr32(self.dataRef(off), val);
     }
 
     pub fn setI32(self: *Builder, off: usize, val: i32) void {
-        self.wr32(self.data_start + off, @bitCast(val));
+        self.wr32(self.dataRef(off), @bitCast(val));
     }
 
     pub fn setI64(self: *Builder, off: usize, val: i64) void {
-        self.wr64(self.data_start + off, @bitCast(val));
+        self.wr64(self.dataRef(off), @bitCast(val));
     }
 
     pub fn setF64(self: *Builder, off: usize, val: f64) void {
-        self.wr64(self.data_start + off, @bitCast(val));
+        self.wr64(self.dataRef(off), @bitCast(val));
     }
 
     // ── Text field (allocate + link pointer) ──────────────────────────
@@ -219,8 +349,7 @@ pub const Builder = struct {
     /// root pointer slot. Cap'n Proto Text = List(UInt8) with null terminator.
     pub fn setText(self: *Builder, ptr_idx: usize, text: []const u8) void {
         if (text.len == 0) return;
-        const ptr_off = self.ptr_start + ptr_idx * 8;
-        self.allocAndLinkText(ptr_off, text);
+        self.allocAndLinkText(self.ptrRef(ptr_idx), text);
     }
 
     // ── List(Text) (list of pointers to text) ─────────────────────────
@@ -229,19 +358,16 @@ pub const Builder = struct {
     /// given root pointer slot.
     pub fn setTextList(self: *Builder, ptr_idx: usize, texts: []const []const u8) void {
         if (texts.len == 0) return;
+        const ptr = self.ptrRef(ptr_idx);
 
         // Allocate N pointer words for the list body
-        const list_off = self.allocWords(texts.len) orelse return;
-
-        // Write list pointer: type=list, element_size=pointer
-        const ptr_off = self.ptr_start + ptr_idx * 8;
-        self.writeListPtr(ptr_off, list_off, LIST_POINTER, @intCast(texts.len));
+        const list = self.allocFor(ptr.seg, texts.len) orelse return;
+        self.link(ptr, list, LIST_POINTER, @intCast(texts.len));
 
         // Each list element is a pointer to a text allocation
         for (texts, 0..) |text, i| {
             if (text.len == 0) continue;
-            const elem_ptr_off = list_off + i * 8;
-            self.allocAndLinkText(elem_ptr_off, text);
+            self.allocAndLinkText(.{ .seg = list.at.seg, .off = list.at.off + i * 8 }, text);
         }
     }
 
@@ -261,22 +387,23 @@ pub const Builder = struct {
 
         const elem_words = @as(usize, dw) + @as(usize, pw);
         const total_words = 1 + count * elem_words; // 1 tag word + elements
-        const list_off = self.allocWords(total_words) orelse return null;
+        const ptr = self.ptrRef(ptr_idx);
+        const list = self.allocFor(ptr.seg, total_words) orelse return null;
 
         // Tag word: struct pointer with offset = element count
         const tag: u64 = (@as(u64, @intCast(count)) << 2) |
             (@as(u64, dw) << 32) |
             (@as(u64, pw) << 48);
-        self.wr64(list_off, tag);
+        self.wr64(list.at, tag);
 
         // List pointer at parent: type=list, element_size=composite, count=total_element_words
-        const ptr_off = self.ptr_start + ptr_idx * 8;
         const word_count: u29 = @intCast(count * elem_words);
-        self.writeListPtr(ptr_off, list_off, LIST_COMPOSITE, word_count);
+        self.link(ptr, list, LIST_COMPOSITE, word_count);
 
         return .{
             .builder = self,
-            .start = list_off + 8, // elements begin after tag word
+            .seg = list.at.seg,
+            .start = list.at.off + 8, // elements begin after tag word
             .dw = dw,
             .pw = pw,
             .stride = elem_words * 8,
@@ -286,67 +413,139 @@ pub const Builder = struct {
 
     // ── Message serialisation ─────────────────────────────────────────
 
-    /// Write the complete Cap'n Proto message (header + segment) to a file.
-    pub fn writeMessage(self: *Builder, file: std.fs.File) !void {
-        const segment_words: u32 = @intCast(self.pos / 8);
+    /// Segments in the message (0 if initRoot/reopen could not allocate).
+    pub fn segmentCount(self: *const Builder) usize {
+        return self.arena.count;
+    }
 
-        // Message header: segment_count-1 (0 = one segment), segment_size_in_words
-        var header: [8]u8 = undefined;
-        std.mem.writeInt(u32, header[0..4], 0, .little);
-        std.mem.writeInt(u32, header[4..8], segment_words, .little);
+    /// The message as header + segments, for a vectored write: fills
+    /// header and parts and returns the used prefix of parts.
+    pub fn messageParts(
+        self: *const Builder,
+        header: *[MAX_HEADER]u8,
+        parts: *[MAX_SEGMENTS + 1][]const u8,
+    ) []const []const u8 {
+        const a = self.arena;
+        const n = a.count;
+        const header_len = headerLen(n);
+        @memset(header[0..header_len], 0);
+        std.mem.writeInt(u32, header[0..4], @intCast(n -| 1), .little);
+        for (0..n) |i| {
+            std.mem.writeInt(u32, header[4 + i * 4 ..][0..4], @intCast(a.used[i] / 8), .little);
+            parts[1 + i] = a.segs[i][0..a.used[i]];
+        }
+        parts[0] = header[0..header_len];
+        return parts[0 .. 1 + n];
+    }
+
+    /// The message in packed encoding, built in the arena's scratch buffer
+    /// and valid until the next message. Null on OOM.
+    pub fn packedMessage(self: *Builder) ?[]const u8 {
+        var header: [MAX_HEADER]u8 = undefined;
+        var parts: [MAX_SEGMENTS + 1][]const u8 = undefined;
+        const a = self.arena;
+        a.scratch.clearRetainingCapacity();
+        for (self.messageParts(&header, &parts)) |part| {
+            packAppend(a.allocator, &a.scratch, part) catch return null;
+        }
+        return a.scratch.items;
+    }
 
-        try file.writeAll(&header);
-        try file.writeAll(self.buf[0..self.pos]);
+    /// Write the complete Cap'n Proto message (header + segments) to a
+    /// file, packed or not.
+    pub fn writeMessage(self: *Builder, file: std.fs.File, pack: bool) !void {
+        if (pack) {
+            try file.writeAll(self.packedMessage() orelse return error.OutOfMemory);
+            return;
+        }
+        var header: [MAX_HEADER]u8 = undefined;
+        var parts: [MAX_SEGMENTS + 1][]const u8 = undefined;
+        for (self.messageParts(&header, &parts)) |part| try file.writeAll(part);
     }
 
     // ── Internal helpers ──────────────────────────────────────────────
 
-    fn allocWords(self: *Builder, n: usize) ?usize {
+    fn rootPointer() u64 {
+        return (@as(u64, DATA_WORDS) << 32) | (@as(u64, PTR_WORDS) << 48);
+    }
+
+    fn dataRef(self: *const Builder, off: usize) Ref {
+        return .{ .seg = 0, .off = self.data_start + off };
+    }
+
+    fn ptrRef(self: *const Builder, ptr_idx: usize) Ref {
+        return .{ .seg = 0, .off = self.ptr_start + ptr_idx * 8 };
+    }
+
+    /// Allocate n words for an object whose pointer lives in ptr_seg. The
+    /// object goes in the last segment, after a landing pad word if that is
+    /// not ptr_seg; a new segment is opened when the last one is full.
+    fn allocFor(self: *Builder, ptr_seg: usize, n: usize) ?Placement {
+        const a = self.arena;
+        if (a.count == 0) return null;
         const bytes = n * 8;
-        if (self.pos + bytes > self.cap) return null;
-        const off = self.pos;
-        self.pos += bytes;
-        return off;
+        var seg = a.count - 1;
+        var pad: usize = if (seg == ptr_seg) 0 else 8;
+        if (a.used[seg] + pad + bytes > a.segs[seg].len) {
+            seg = a.addSegment(8 + bytes) orelse return null;
+            pad = 8;
+        }
+        const off = a.used[seg];
+        a.used[seg] += pad + bytes;
+        return .{
+            .at = .{ .seg = seg, .off = off + pad },
+            .pad = if (pad != 0) .{ .seg = seg, .off = off } else null,
+        };
     }
 
-    fn wr64(self: *Builder, off: usize, val: u64) void {
-        if (off + 8 > self.cap) return;
-        // SAFETY: bounds check on line above ensures off + 8 <= cap; buf is caller-provided aligned buffer; align(1) permits unaligned write
-        @as(*align(1) u64, @ptrCast(self.buf + off)).* = std.mem.nativeToLittle(u64, val);
+    fn wr64(self: *Builder, at: Ref, val: u64) void {
+        if (at.seg >= self.arena.count or at.off + 8 > self.arena.used[at.seg]) return;
+        std.mem.writeInt(u64, self.arena.segs[at.seg][at.off..][0..8], val, .little);
     }
 
-    fn wr32(self: *Builder, off: usize, val: u32) void {
-        if (off + 4 > self.cap) return;
-        // SAFETY: bounds check on line above ensures off + 4 <= cap; buf is caller-provided aligned buffer; align(1) permits unaligned write
-        @as(*align(1) u32, @ptrCast(self.buf + off)).* = std.mem.nativeToLittle(u32, val);
+    fn wr32(self: *Builder, at: Ref, val: u32) void {
+        if (at.seg >= self.arena.count or at.off + 4 > self.arena.used[at.seg]) return;
+        std.mem.writeInt(u32, self.arena.segs[at.seg][at.off..][0..4], val, .little);
     }
 
-    /// Allocate text in the segment and write a text pointer at ptr_off.
-    fn allocAndLinkText(self: *Builder, ptr_off: usize, text: []const u8) void {
+    /// Allocate text and write a text pointer at ptr.
+    fn allocAndLinkText(self: *Builder, ptr: Ref, text: []const u8) void {
         // Cap'n Proto Text = List(UInt8) with null terminator included in count
         const len_with_null = text.len + 1;
         const words = (len_with_null + 7) / 8;
-        const text_off = self.allocWords(words) orelse return;
+        const p = self.allocFor(ptr.seg, words) orelse return;
 
-        // Copy text bytes (null terminator already 0 from zeroed buffer)
-        for (text, 0..) |byte, i| {
-            self.buf[text_off + i] = byte;
-        }
+        // Copy text bytes (null terminator already 0 from the zeroed segment)
+        @memcpy(self.arena.segs[p.at.seg][p.at.off..][0..text.len], text);
 
         // Write list pointer: type=list(1), element_size=byte(2), count=len_with_null
-        self.writeListPtr(ptr_off, text_off, LIST_BYTE, @intCast(len_with_null));
+        self.link(ptr, p, LIST_BYTE, @intCast(len_with_null));
+    }
+
+    /// Point ptr at an allocated list: directly within a segment, or via
+    /// a single-far pointer to the landing pad holding the list pointer.
+    fn link(self: *Builder, ptr: Ref, p: Placement, elem_size: u3, count: u29) void {
+        const pad = p.pad orelse {
+            self.writeListPtr(ptr, p.at, elem_size, count);
+            return;
+        };
+        self.writeListPtr(pad, p.at, elem_size, count);
+        // Far pointer: bits 0-1 = 2, bit 2 = 0 (single pad), bits 3-31 = pad
+        // word within its segment, bits 32-63 = segment id
+        self.wr64(ptr, PTR_FAR | (@as(u64, pad.off / 8) << 3) | (@as(u64, pad.seg) << 32));
     }
 
-    /// Encode and write a Cap'n Proto list pointer.
+    /// Encode and write a Cap'n Proto list pointer (ptr and target in the
+    /// same segment).
     ///
     /// Layout (64 bits, little-endian):
     ///   bits 0-1:   1 (list type)
     ///   bits 2-31:  signed offset in words (from pointer+1 to list data)
     ///   bits 32-34: element size enum
     ///   bits 35-63: element count (or word count for composite)
-    fn writeListPtr(self: *Builder, ptr_off: usize, target_off: usize, elem_size: u3, count: u29) void {
-        const ptr_word = ptr_off / 8;
-        const target_word = target_off / 8;
+    fn writeListPtr(self: *Builder, ptr: Ref, target: Ref, elem_size: u3, count: u29) void {
+        const ptr_word = ptr.off / 8;
+        const target_word = target.off / 8;
         const offset: i32 = @intCast(@as(i64, @intCast(target_word)) - @as(i64, @intCast(ptr_word)) - 1);
 
         // Lower 32 bits: (offset << 2) | type_bit
@@ -354,7 +553,7 @@ pub const Builder = struct {
         // Upper 32 bits: elem_size | (count << 3)
         const upper: u32 = @as(u32, elem_size) | (@as(u32, count) << 3);
 
-        self.wr64(ptr_off, @as(u64, lower) | (@as(u64, upper) << 32));
+        self.wr64(ptr, @as(u64, lower) | (@as(u64, upper) << 32));
     }
 };
 
@@ -365,31 +564,275 @@ pub const Builder = struct {
 /// Handle for accessing elements of a composite list (list of structs).
 pub const CompositeList = struct {
     builder: *Builder,
-    start: usize, // byte offset of first element in segment
+    seg: usize, // segment holding the list
+    start: usize, // byte offset of first element in the segment
     dw: u16, // data words per element
     pw: u16, // pointer words per element
     stride: usize, // bytes per element (dw+pw)*8
     count: usize,
 
-    /// Byte offset of element i's data section.
-    fn elemData(self: CompositeList, i: usize) usize {
-        return self.start + i * self.stride;
+    /// Position of element i's data section.
+    fn elemData(self: CompositeList, i: usize) Ref {
+        return .{ .seg = self.seg, .off = self.start + i * self.stride };
     }
 
-    /// Byte offset of element i's pointer section.
-    fn elemPtrs(self: CompositeList, i: usize) usize {
-        return self.start + i * self.stride + @as(usize, self.dw) * 8;
+    /// Position of element i's pointer slot ptr_idx.
+    fn elemPtr(self: CompositeList, i: usize, ptr_idx: usize) Ref {
+        return .{ .seg = self.seg, .off = self.start + i * self.stride + (@as(usize, self.dw) + ptr_idx) * 8 };
     }
 
     /// Set a UInt32 field on element i at the given byte offset within the data section.
     pub fn setElemU32(self: CompositeList, i: usize, byte_off: usize, val: u32) void {
-        self.builder.wr32(self.elemData(i) + byte_off, val);
+        const at = self.elemData(i);
+        self.builder.wr32(.{ .seg = at.seg, .off = at.off + byte_off }, val);
     }
 
     /// Set a Text pointer field on element i at the given pointer index.
     pub fn setElemText(self: CompositeList, i: usize, ptr_idx: usize, text: []const u8) void {
         if (text.len == 0) return;
-        const ptr_off = self.elemPtrs(i) + ptr_idx * 8;
-        self.builder.allocAndLinkText(ptr_off, text);
+        self.builder.allocAndLinkText(self.elemPtr(i, ptr_idx), text);
     }
 };
+
+// ============================================================================
+// Message Framing
+// ============================================================================
+
+/// Bytes of the header of an n-segment message (count + sizes, word padded).
+fn headerLen(n: usize) usize {
+    return std.mem.alignForward(usize, 4 + 4 * @max(n, 1), 8);
+}
+
+/// Split an unpacked message into its segments (at most MAX_SEGMENTS).
+/// Returns null if the header or any segment is truncated.
+pub fn segmentTable(msg: []const u8, out: *[MAX_SEGMENTS][]const u8) ?[]const []const u8 {
+    if (msg.len < 8) return null;
+    const n = @as(usize, std.mem.readInt(u32, msg[0..4], .little)) + 1;
+    if (n > MAX_SEGMENTS) return null;
+    var pos = headerLen(n);
+    if (msg.len < pos) return null;
+    for (0..n) |i| {
+        const len = @as(usize, std.mem.readInt(u32, msg[4 + i * 4 ..][0..4], .little)) * 8;
+        if (len == 0 or msg.len - pos < len) return null;
+        out[i] = msg[pos..][0..len];
+        pos += len;
+    }
+    return out[0..n];
+}
+
+// ============================================================================
+// Packed Encoding
+// ============================================================================
+//
+// Standard Cap'n Proto packing: each word becomes a tag byte (bit i set =
+// byte i non-zero) followed by its non-zero bytes. Tag 0x00 is followed by
+// a count of further all-zero words; tag 0xff by a count of further words
+// copied verbatim (words with at most one zero byte, where tagging costs
+// more than it saves).
+
+/// Whether a stored message is packed. An unpacked message starts with
+/// segment count - 1 (< MAX_SEGMENTS); a packed one starts with the tag of
+/// that header word, whose segment-0 size bytes (tag bits 4-7) are never
+/// all zero.
+pub fn isPacked(msg: []const u8) bool {
+    return msg.len > 0 and msg[0] >= MAX_SEGMENTS;
+}
+
+/// Append the packed encoding of words (length a multiple of 8) to out.
+pub fn packAppend(allocator: std.mem.Allocator, out: *std.ArrayList(u8), words: []const u8) !void {
+    std.debug.assert(words.len % 8 == 0);
+    // Worst case: a tag byte and a count byte per run, plus the bytes
+    try out.ensureUnusedCapacity(allocator, words.len + words.len / 8 * 2 + 2);
+    var i: usize = 0;
+    while (i < words.len) {
+        const word = words[i..][0..8];
+        i += 8;
+        var tag: u8 = 0;
+        for (word, 0..) |byte, bit| {
+            if (byte != 0) tag |= @as(u8, 1) << @intCast(bit);
+        }
+        out.appendAssumeCapacity(tag);
+        for (word) |byte| {
+            if (byte != 0) out.appendAssumeCapacity(byte);
+        }
+
+        if (tag == 0x00) {
+            var run: usize = 0;
+            while (run < 255 and i < words.len and std.mem.readInt(u64, words[i..][0..8], .little) == 0) : (run += 1) i += 8;
+            out.appendAssumeCapacity(@intCast(run));
+        } else if (tag == 0xff) {
+            const run_start = i;
+            var run: usize = 0;
+            while (run < 255 and i < words.len and std.mem.count(u8, words[i..][0..8], &.{0}) <= 1) : (run += 1) i += 8;
+            out.appendAssumeCapacity(@intCast(run));
+            out.appendSliceAssumeCapacity(words[run_start..i]);
+        }
+    }
+}
+
+/// Append the unpacked bytes of a packed message to out. Returns false if
+/// the input is truncated or out cannot grow.
+pub fn unpackAppend(allocator: std.mem.Allocator, out: *std.ArrayList(u8), src: []const u8) bool {
+    var i: usize = 0;
+    while (i < src.len) {
+        const tag = src[i];
+        i += 1;
+        var word = [_]u8{0} ** 8;
+        for (&word, 0..) |*byte, bit| {
+            if (tag & (@as(u8, 1) << @intCast(bit)) == 0) continue;
+            if (i == src.len) return false;
+            byte.* = src[i];
+            i += 1;
+        }
+        out.appendSlice(allocator, &word) catch return false;
+
+        if (tag == 0x00 or tag == 0xff) {
+            if (i == src.len) return false;
+            const run = @as(usize, src[i]) * 8;
+            i += 1;
+            if (tag == 0x00) {
+                out.appendNTimes(allocator, 0, run) catch return false;
+            } else {
+                if (src.len - i < run) return false;
+                out.appendSlice(allocator, src[i..][0..run]) catch return false;
+                i += run;
+            }
+        }
+    }
+    return true;
+}
+
+/// Unpack at most dst.len bytes from the front of a packed message into
+/// dst (enough to read a header and root fields without unpacking the
+/// rest). Returns the bytes written.
+pub fn unpackPrefix(src: []const u8, dst: []u8) usize {
+    var i: usize = 0;
+    var n: usize = 0;
+    while (i < src.len and n < dst.len) {
+        const tag = src[i];
+        i += 1;
+        var word = [_]u8{0} ** 8;
+        for (&word, 0..) |*byte, bit| {
+            if (tag & (@as(u8, 1) << @intCast(bit)) == 0) continue;
+            if (i == src.len) return n;
+            byte.* = src[i];
+            i += 1;
+        }
+        var run: usize = 0;
+        if (tag == 0x00 or tag == 0xff) {
+            if (i == src.len) return n;
+            run = @as(usize, src[i]) * 8;
+            i += 1;
+        }
+        const take = @min(8, dst.len - n);
+        @memcpy(dst[n..][0..take], word[0..take]);
+        n += take;
+        if (run == 0) continue;
+        const more = @min(run, dst.len - n);
+        if (tag == 0x00) {
+            @memset(dst[n..][0..more], 0);
+        } else {
+            if (src.len - i < more) return n;
+            @memcpy(dst[n..][0..more], src[i..][0..more]);
+            i += run;
+        }
+        n += more;
+    }
+    return n;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+/// Concatenate a builder's message for the tests.
+fn testMessage(b: *const Builder, out: *std.ArrayList(u8)) !void {
+    var header: [MAX_HEADER]u8 = undefined;
+    var parts: [MAX_SEGMENTS + 1][]const u8 = undefined;
+    for (b.messageParts(&header, &parts)) |part| try out.appendSlice(std.testing.allocator, part);
+}
+
+test "small message is one segment and the arena is reused" {
+    var arena = Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var b = Builder.init(&arena);
+    b.initRoot();
+    b.setText(PTR_LANG_LANGUAGE, "en");
+    try std.testing.expectEqual(@as(usize, 1), b.segmentCount());
+    const first = arena.segs[0].ptr;
+
+    var b2 = Builder.init(&arena);
+    b2.initRoot();
+    try std.testing.expectEqual(first, arena.segs[0].ptr);
+    // The earlier text was cleared by reset
+    const text_at = b2.ptr_start + @as(usize, PTR_WORDS) * 8;
+    try std.testing.expectEqual(@as(u8, 0), arena.segs[0][text_at]);
+}
+
+test "overflowing segment 0 links text through far pointers" {
+    var arena = Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var b = Builder.init(&arena);
+    b.initRoot();
+    // The 528-byte root plus this text leave 24 bytes of segment 0
+    const big = [_]u8{'x'} ** (SEGMENT_BYTES - 560);
+    b.setText(PTR_MERKLE_ROOT, &big);
+    b.setText(PTR_LANG_LANGUAGE, "a language tag that no longer fits segment 0");
+    try std.testing.expectEqual(@as(usize, 2), b.segmentCount());
+
+    const ptr_off = b.ptr_start + PTR_LANG_LANGUAGE * 8;
+    const far = std.mem.readInt(u64, arena.segs[0][ptr_off..][0..8], .little);
+    try std.testing.expectEqual(PTR_FAR, far & 7);
+    try std.testing.expectEqual(@as(u64, 1), far >> 32);
+
+    // The pad holds an ordinary list pointer to the text right after it
+    const pad_off = ((far >> 3) & 0x1fff_ffff) * 8;
+    const pad = std.mem.readInt(u64, arena.segs[1][pad_off..][0..8], .little);
+    try std.testing.expectEqual(@as(u64, 1), pad & 0xffff_ffff);
+    try std.testing.expectEqualStrings("a language", arena.segs[1][pad_off + 8 ..][0..10]);
+
+    var msg: std.ArrayList(u8) = .{};
+    defer msg.deinit(std.testing.allocator);
+    try testMessage(&b, &msg);
+    var table: [MAX_SEGMENTS][]const u8 = undefined;
+    const segs = segmentTable(msg.items, &table) orelse return error.BadMessage;
+    try std.testing.expectEqual(@as(usize, 2), segs.len);
+}
+
+test "packed message unpacks to the same bytes and reopens" {
+    var arena = Arena.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var b = Builder.init(&arena);
+    b.initRoot();
+    b.setU64(OFF_STAGES_MASK, 0x5);
+    b.setF64(OFF_LANG_CONFIDENCE, 0.75);
+    b.setText(PTR_MERKLE_ROOT, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    b.setTextList(PTR_KW_WORDS, &.{ "alpha", "beta" });
+
+    var plain: std.ArrayList(u8) = .{};
+    defer plain.deinit(std.testing.allocator);
+    try testMessage(&b, &plain);
+
+    const packed_msg = try std.testing.allocator.dupe(u8, b.packedMessage() orelse return error.OutOfMemory);
+    defer std.testing.allocator.free(packed_msg);
+    try std.testing.expect(packed_msg.len < plain.items.len / 2);
+    try std.testing.expect(isPacked(packed_msg));
+    try std.testing.expect(!isPacked(plain.items));
+
+    var unpacked: std.ArrayList(u8) = .{};
+    defer unpacked.deinit(std.testing.allocator);
+    try std.testing.expect(unpackAppend(std.testing.allocator, &unpacked, packed_msg));
+    try std.testing.expectEqualSlices(u8, plain.items, unpacked.items);
+
+    var prefix: [24]u8 = undefined;
+    try std.testing.expectEqual(@as(usize, 24), unpackPrefix(packed_msg, &prefix));
+    try std.testing.expectEqualSlices(u8, plain.items[0..24], &prefix);
+
+    var b2 = Builder.init(&arena);
+    try std.testing.expect(b2.reopen(packed_msg));
+    try std.testing.expectEqual(@as(u64, 0x5), b2.getU64(OFF_STAGES_MASK));
+    try std.testing.expect(!unpackAppend(std.testing.allocator, &unpacked, packed_msg[0 .. packed_msg.len - 1]));
+}
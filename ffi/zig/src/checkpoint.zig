@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Checkpoint Bitmaps + Journal
+//
+// Resume state for long HPC runs. Each locale owns one dense bitmap over
+// the manifest index range (bit i set = document i completed) and an
+// append-only journal of completed index ranges:
+//
+//   checkpoint-{locale}.bits     64-byte header + ceil(num_docs/64) u64 words
+//   checkpoint-{locale}.journal  16-byte header + (lo, count) u64 records
+//
+// The bitmap file is mmap'd shared. ddac_ckpt_mark() sets the bit in the
+// mapping and queues the index; every flush_every marks the queue is
+// sorted, coalesced into ranges, appended to the journal and fdatasync'd,
+// so a checkpoint write costs O(delta) rather than a rewrite of every
+// completed index. Once the journal grows past COMPACT_BYTES the bitmap is
+// msync'd and the journal truncated. Bits only ever go from 0 to 1 after a
+// document is done, so the kernel writing dirty bitmap pages back early is
+// harmless.
+//
+// Opening replays the journal over the bitmap (a torn trailing record from
+// a crash mid-append is ignored) and compacts. On resume every locale ORs
+// all locales' files into a private resume bitmap (ddac_ckpt_merge), so
+// ddac_ckpt_test() is a single bit test whichever locale completed the
+// document in the previous run. 170M documents = ~21 MB per bitmap.
+
+const std = @import("std");
+
+// ============================================================================
+// File Formats
+// ============================================================================
+
+const BITS_MAGIC = "DDACBITS".*;
+const JOURNAL_MAGIC = "DDACJRNL".*;
+const FORMAT_VERSION: u32 = 1;
+
+const BitsHeader = extern struct {
+    magic: [8]u8,
+    version: u32,
+    _pad: u32,
+    num_docs: u64,
+    _reserved: [40]u8,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(BitsHeader) == 64);
+}
+
+const BITS_HEADER: usize = @sizeOf(BitsHeader);
+const JOURNAL_HEADER: u64 = 16;
+const RECORD_SIZE: usize = 16;
+
+/// Journal size (records only) past which a flush also compacts.
+const COMPACT_BYTES: u64 = 4 * 1024 * 1024;
+
+// ============================================================================
+// Checkpoint State
+// ============================================================================
+
+const Checkpoint = struct {
+    num_docs: u64,
+    bits_file: std.fs.File,
+    map: []align(std.heap.page_size_min) u8,
+    /// View of the mapping after the header; bits set with atomic OR
+    words: []u64,
+    journal: std.fs.File,
+    journal_bytes: u64,
+    /// Union of the previous run's bitmaps (ddac_ckpt_merge), or null
+    resume_words: ?[]u64 = null,
+
+    mutex: std.Thread.Mutex = .{},
+    /// Indices marked since the last journal append (under mutex)
+    pending: std.ArrayList(u64) = .empty,
+    flush_every: u32,
+};
+
+fn wordCount(num_docs: u64) usize {
+    return @intCast((num_docs + 63) / 64);
+}
+
+/// Set bits [lo, lo + count), clamped to num_docs.
+fn setRange(words: []u64, num_docs: u64, lo: u64, count: u64) void {
+    if (lo >= num_docs) return;
+    const hi = @min(lo +| count, num_docs);
+    var i = lo;
+    while (i < hi) {
+        const bit: u6 = @intCast(i & 63);
+        const span = @min(hi - i, 64 - @as(u64, bit));
+        const mask: u64 = if (span == 64) ~@as(u64, 0) else ((@as(u64, 1) << @intCast(span)) - 1) << bit;
+        _ = @atomicRmw(u64, &words[@intCast(i >> 6)], .Or, mask, .monotonic);
+        i += span;
+    }
+}
+
+/// Apply every whole (lo, count) record of a journal to words. A record
+/// torn by a crash mid-append is ignored. Returns false on a bad header.
+fn replayJournal(file: std.fs.File, words: []u64, num_docs: u64) bool {
+    var header: [JOURNAL_HEADER]u8 = undefined;
+    const got = file.preadAll(&header, 0) catch return false;
+    if (got < header.len) return false;
+    if (!std.mem.eql(u8, header[0..8], &JOURNAL_MAGIC)) return false;
+    if (std.mem.readInt(u64, header[8..16], .little) != num_docs) return false;
+
+    var buf: [RECORD_SIZE * 4096]u8 = undefined;
+    var offset: u64 = JOURNAL_HEADER;
+    while (true) {
+        const n = file.preadAll(&buf, offset) catch break;
+        const records = n / RECORD_SIZE;
+        for (0..records) |r| {
+            const rec = buf[r * RECORD_SIZE ..][0..RECORD_SIZE];
+            setRange(words, num_docs, std.mem.readInt(u64, rec[0..8], .little), std.mem.readInt(u64, rec[8..16], .little));
+        }
+        if (n < buf.len) break;
+        offset += records * RECORD_SIZE;
+    }
+    return true;
+}
+
+fn writeJournalHeader(file: std.fs.File, num_docs: u64) !void {
+    var header: [JOURNAL_HEADER]u8 = undefined;
+    @memcpy(header[0..8], &JOURNAL_MAGIC);
+    std.mem.writeInt(u64, header[8..16], num_docs, .little);
+    try file.pwriteAll(&header, 0);
+}
+
+fn headerMatches(bytes: []const u8, num_docs: u64) bool {
+    if (bytes.len < BITS_HEADER) return false;
+    const h = std.mem.bytesToValue(BitsHeader, bytes[0..BITS_HEADER]);
+    return std.mem.eql(u8, &h.magic, &BITS_MAGIC) and
+        h.version == FORMAT_VERSION and h.num_docs == num_docs;
+}
+
+/// Sort and coalesce the pending indices into ranges, append them to the
+/// journal and fdatasync it. Compacts when the journal grows past
+/// COMPACT_BYTES. Caller holds ck.mutex.
+fn flushLocked(ck: *Checkpoint) !void {
+    const items = ck.pending.items;
+    if (items.len == 0) return;
+    std.mem.sort(u64, items, {}, std.sort.asc(u64));
+
+    var buf: [RECORD_SIZE * 256]u8 = undefined;
+    var used: usize = 0;
+    var i: usize = 0;
+    while (i < items.len) {
+        const lo = items[i];
+        var hi = lo + 1;
+        i += 1;
+        while (i < items.len and items[i] <= hi) : (i += 1) {
+            if (items[i] == hi) hi += 1;
+        }
+        std.mem.writeInt(u64, buf[used..][0..8], lo, .little);
+        std.mem.writeInt(u64, buf[used + 8 ..][0..8], hi - lo, .little);
+        used += RECORD_SIZE;
+        if (used == buf.len) {
+            try ck.journal.pwriteAll(buf[0..used], ck.journal_bytes);
+            ck.journal_bytes += used;
+            used = 0;
+        }
+    }
+    if (used > 0) {
+        try ck.journal.pwriteAll(buf[0..used], ck.journal_bytes);
+        ck.journal_bytes += used;
+    }
+    try std.posix.fdatasync(ck.journal.handle);
+    ck.pending.clearRetainingCapacity();
+
+    if (ck.journal_bytes - JOURNAL_HEADER >= COMPACT_BYTES) try compactLocked(ck);
+}
+
+/// Make the bitmap durable, then drop the journal records it covers.
+/// Caller holds ck.mutex.
+fn compactLocked(ck: *Checkpoint) !void {
+    try std.posix.msync(ck.map, std.posix.MSF.SYNC);
+    try ck.journal.setEndPos(JOURNAL_HEADER);
+    ck.journal_bytes = JOURNAL_HEADER;
+}
+
+fn openImpl(bits_path: [*:0]const u8, journal_path: [*:0]const u8, num_docs: u64, keep: bool, flush_every: u32) !*Checkpoint {
+    const allocator = std.heap.c_allocator;
+    const size = BITS_HEADER + wordCount(num_docs) * @sizeOf(u64);
+
+    const bits_file = try std.fs.cwd().createFileZ(bits_path, .{ .read = true, .truncate = false });
+    errdefer bits_file.close();
+    const journal = try std.fs.cwd().createFileZ(journal_path, .{ .read = true, .truncate = false });
+    errdefer journal.close();
+
+    // Keep an existing bitmap only on resume and only if it describes
+    // this manifest; otherwise start from zero
+    var header_buf: [BITS_HEADER]u8 = undefined;
+    const have = bits_file.preadAll(&header_buf, 0) catch 0;
+    const stat = try bits_file.stat();
+    const reuse = keep and stat.size == size and headerMatches(header_buf[0..have], num_docs);
+    if (!reuse) {
+        try bits_file.setEndPos(0);
+        try bits_file.setEndPos(size);
+        var header = std.mem.zeroes(BitsHeader);
+        header.magic = BITS_MAGIC;
+        header.version = FORMAT_VERSION;
+        header.num_docs = num_docs;
+        try bits_file.pwriteAll(std.mem.asBytes(&header), 0);
+    }
+
+    const map = try std.posix.mmap(
+        null,
+        size,
+        std.posix.PROT.READ | std.posix.PROT.WRITE,
+        .{ .TYPE = .SHARED },
+        bits_file.handle,
+        0,
+    );
+    errdefer std.posix.munmap(map);
+    // SAFETY: map is page-aligned and BITS_HEADER (64) is a multiple of 8, so the word array after the header is u64-aligned
+    const words_ptr: [*]u64 = @ptrCast(@alignCast(map.ptr + BITS_HEADER));
+    const words = words_ptr[0..wordCount(num_docs)];
+
+    const ck = try allocator.create(Checkpoint);
+    errdefer allocator.destroy(ck);
+    ck.* = .{
+        .num_docs = num_docs,
+        .bits_file = bits_file,
+        .map = map,
+        .words = words,
+        .journal = journal,
+        .journal_bytes = JOURNAL_HEADER,
+        .flush_every = @max(flush_every, 1),
+    };
+
+    // Fold the previous run's journal into the bitmap, then start an
+    // empty journal
+    if (reuse) _ = replayJournal(journal, words, num_docs);
+    try std.posix.msync(map, std.posix.MSF.SYNC);
+    try journal.setEndPos(0);
+    try writeJournalHeader(journal, num_docs);
+    try std.posix.fdatasync(journal.handle);
+    return ck;
+}
+
+// ============================================================================
+// C-ABI exports
+// ============================================================================
+
+/// Open (or create) a locale's checkpoint bitmap and journal for a manifest
+/// of num_docs documents. keep != 0 keeps previously completed documents
+/// (resume) when the files match num_docs; otherwise they are reset.
+/// flush_every: marks between journal appends (fdatasync each).
+/// Returns opaque handle, or null on failure.
+export fn ddac_ckpt_open(bits_path: [*:0]const u8, journal_path: [*:0]const u8, num_docs: u64, keep: u8, flush_every: u32) ?*anyopaque {
+    const ck = openImpl(bits_path, journal_path, num_docs, keep != 0, flush_every) catch return null;
+    // SAFETY: ck was just allocated by c_allocator.create(Checkpoint), which returns a well-aligned *Checkpoint
+    return @ptrCast(ck);
+}
+
+/// Record document idx as completed. Thread-safe. Returns 0, or -1 if idx
+/// is out of range or the journal append failed (the bit is still set).
+export fn ddac_ckpt_mark(handle: ?*anyopaque, idx: u64) i32 {
+    const ptr = handle orelse return -1;
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+    if (idx >= ck.num_docs) return -1;
+
+    const mask = @as(u64, 1) << @intCast(idx & 63);
+    _ = @atomicRmw(u64, &ck.words[@intCast(idx >> 6)], .Or, mask, .monotonic);
+
+    ck.mutex.lock();
+    defer ck.mutex.unlock();
+    ck.pending.append(std.heap.c_allocator, idx) catch return -1;
+    if (ck.pending.items.len >= ck.flush_every) flushLocked(ck) catch return -1;
+    return 0;
+}
+
+/// OR another checkpoint's bitmap and journal (e.g. another locale's, from
+/// the previous run) into this handle's resume bitmap.
+/// Returns 0, or -1 if the files are missing or describe another manifest.
+export fn ddac_ckpt_merge(handle: ?*anyopaque, bits_path: [*:0]const u8, journal_path: [*:0]const u8) i32 {
+    const ptr = handle orelse return -1;
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+
+    const resume_words = ck.resume_words orelse blk: {
+        const w = std.heap.c_allocator.alloc(u64, ck.words.len) catch return -1;
+        @memset(w, 0);
+        ck.resume_words = w;
+        break :blk w;
+    };
+
+    const file = std.fs.cwd().openFileZ(bits_path, .{}) catch return -1;
+    defer file.close();
+    const size = BITS_HEADER + ck.words.len * @sizeOf(u64);
+    const stat = file.stat() catch return -1;
+    if (stat.size != size) return -1;
+
+    const map = std.posix.mmap(null, size, std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, file.handle, 0) catch return -1;
+    defer std.posix.munmap(map);
+    if (!headerMatches(map, ck.num_docs)) return -1;
+    std.posix.madvise(map.ptr, map.len, std.posix.MADV.SEQUENTIAL) catch {};
+
+    // SAFETY: map is page-aligned and BITS_HEADER (64) is a multiple of 8, so the word array after the header is u64-aligned
+    const other: [*]const u64 = @ptrCast(@alignCast(map.ptr + BITS_HEADER));
+    for (resume_words, other[0..resume_words.len]) |*dst, src| dst.* |= src;
+
+    if (std.fs.cwd().openFileZ(journal_path, .{})) |jf| {
+        defer jf.close();
+        _ = replayJournal(jf, resume_words, ck.num_docs);
+    } else |_| {}
+    return 0;
+}
+
+/// 1 if document idx was completed in the merged previous run, else 0.
+export fn ddac_ckpt_test(handle: ?*anyopaque, idx: u64) u8 {
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+    const words = ck.resume_words orelse return 0;
+    if (idx >= ck.num_docs) return 0;
+    return @intFromBool(words[@intCast(idx >> 6)] & (@as(u64, 1) << @intCast(idx & 63)) != 0);
+}
+
+/// Number of documents in the merged resume bitmap.
+export fn ddac_ckpt_resume_count(handle: ?*anyopaque) u64 {
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+    const words = ck.resume_words orelse return 0;
+    var total: u64 = 0;
+    for (words) |w| total += @popCount(w);
+    return total;
+}
+
+/// Append pending marks to the journal and compact. Returns 0, or -1 if a
+/// write failed.
+export fn ddac_ckpt_sync(handle: ?*anyopaque) i32 {
+    const ptr = handle orelse return -1;
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+    ck.mutex.lock();
+    defer ck.mutex.unlock();
+    flushLocked(ck) catch return -1;
+    compactLocked(ck) catch return -1;
+    return 0;
+}
+
+/// Sync and close a checkpoint. Safe to call with null. Returns 0, or -1
+/// if the final sync failed.
+export fn ddac_ckpt_close(handle: ?*anyopaque) i32 {
+    const ptr = handle orelse return 0;
+    const status = ddac_ckpt_sync(ptr);
+    // SAFETY: ptr originates from ddac_ckpt_open() which returns a *Checkpoint via @ptrCast; alignment is guaranteed by c_allocator
+    const ck: *Checkpoint = @ptrCast(@alignCast(ptr));
+    const allocator = std.heap.c_allocator;
+    std.posix.munmap(ck.map);
+    ck.bits_file.close();
+    ck.journal.close();
+    if (ck.resume_words) |w| allocator.free(w);
+    ck.pending.deinit(allocator);
+    allocator.destroy(ck);
+    return status;
+}
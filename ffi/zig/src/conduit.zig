@@ -10,11 +10,23 @@
 //   3. SHA-256 pre-computation (feeds L2 Dragonfly cache lookup)
 //   4. File size capture (avoids stat() in main loop)
 //
-// Chapel calls ddac_conduit_process() on a batch of paths. The conduit
-// returns an array of ConduitResult structs that the main loop uses to
-// skip invalid files and pre-populate cache keys.
+// Chapel calls ddac_conduit_batch_start() on each chunk of paths. The
+// conduit fills an array of ConduitResult structs that the main loop uses
+// to skip invalid files and pre-populate cache keys. On Linux the batch
+// queues openat/statx/read for the whole block on io_uring and hashes as
+// reads complete; the _start/_wait pair queues it on the parse handle's
+// conduit Worker, one persistent thread that keeps its ring and lane
+// buffers across batches, so the next chunk's I/O overlaps the current
+// chunk's parse without a thread spawn or ring setup per chunk.
+//
+// ddac_conduit_map() is the single-read variant: the file is mmap'd once,
+// hashed from the mapping, and the same mapping is handed to
+// ddac_parse_ex() so the format libraries parse from memory.
 
 const std = @import("std");
+const builtin = @import("builtin");
+const hw_crypto = @import("hw_crypto.zig");
+const metrics = @import("metrics.zig");
 
 // ============================================================================
 // Content-Type Detection (Magic Bytes)
@@ -22,7 +34,7 @@ const std = @import("std");
 
 /// Content kind detected from file magic bytes.
 /// Matches ContentKind enum in docudactyl_ffi.zig (0-6).
-const ContentKind = enum(u8) {
+pub const ContentKind = enum(u8) {
     pdf = 0,
     image = 1,
     audio = 2,
@@ -115,7 +127,7 @@ fn detectMagic(header: []const u8) ContentKind {
 
 /// Result of pre-processing a single file.
 /// Fixed-size struct for zero-copy transfer to Chapel.
-const ConduitResult = extern struct {
+pub const ConduitResult = extern struct {
     /// Detected content kind (0-6, matches ContentKind).
     content_kind: u8,
 
@@ -143,6 +155,33 @@ comptime {
         @compileError("ConduitResult must be 8-byte aligned");
 }
 
+/// Write a SHA-256 digest as 64 lowercase hex chars + null terminator.
+fn writeHexDigest(digest: [32]u8, dest: *[65]u8) void {
+    const hex_chars = "0123456789abcdef";
+    for (digest, 0..) |byte_val, i| {
+        dest[i * 2] = hex_chars[byte_val >> 4];
+        dest[i * 2 + 1] = hex_chars[byte_val & 0x0f];
+    }
+    dest[64] = 0;
+}
+
+// ============================================================================
+// Mapped input (single-read pipeline)
+// ============================================================================
+
+/// A read-only private mapping of an input file, owned by the conduit and
+/// borrowed by ddac_parse_ex(). Released with ddac_conduit_unmap().
+pub const MappedInput = struct {
+    data: []align(std.heap.page_size_min) u8,
+};
+
+/// Borrow the bytes of a mapping returned by ddac_conduit_map().
+pub fn mappedBytes(mapping: *const anyopaque) []const u8 {
+    // SAFETY: mapping originates from ddac_conduit_map() which returns a *MappedInput via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *const MappedInput = @ptrCast(@alignCast(mapping));
+    return m.data;
+}
+
 // ============================================================================
 // C-ABI exports
 // ============================================================================
@@ -152,6 +191,8 @@ comptime {
 /// result_out: pointer to ConduitResult (88 bytes)
 /// Returns 0 on success, non-zero on error.
 export fn ddac_conduit_process(path: [*:0]const u8, result_out: *ConduitResult) c_int {
+    const span = metrics.begin(.conduit);
+    defer span.end();
     result_out.* = std.mem.zeroes(ConduitResult);
 
     // Open file
@@ -192,38 +233,579 @@ export fn ddac_conduit_process(path: [*:0]const u8, result_out: *ConduitResult)
         if (n == 0) break;
         hasher.update(buf[0..n]);
     }
-    const digest = hasher.finalResult();
+    writeHexDigest(hasher.finalResult(), &result_out.sha256);
 
-    // Convert to hex
-    const hex_chars = "0123456789abcdef";
-    for (digest, 0..) |byte_val, i| {
-        result_out.sha256[i * 2] = hex_chars[byte_val >> 4];
-        result_out.sha256[i * 2 + 1] = hex_chars[byte_val & 0x0f];
+    result_out.validation = 0;
+    return 0;
+}
+
+/// Pre-process a single file from a memory mapping: identical results to
+/// ddac_conduit_process(), but the file is read once and the mapping is
+/// returned so ddac_parse_ex() can parse from the same bytes.
+/// Returns a mapping handle (free with ddac_conduit_unmap) or null when
+/// validation fails — result_out.validation then says why.
+export fn ddac_conduit_map(path: [*:0]const u8, result_out: *ConduitResult) ?*anyopaque {
+    const span = metrics.begin(.conduit);
+    defer span.end();
+    result_out.* = std.mem.zeroes(ConduitResult);
+
+    const file = std.fs.openFileAbsoluteZ(path, .{}) catch {
+        result_out.validation = 1; // not found
+        return null;
+    };
+    defer file.close(); // the mapping outlives the descriptor
+
+    const stat = file.stat() catch {
+        result_out.validation = 3; // unreadable
+        return null;
+    };
+    result_out.file_size = @intCast(stat.size);
+
+    if (stat.size == 0) {
+        result_out.validation = 2; // empty
+        return null;
     }
-    result_out.sha256[64] = 0;
+
+    const data = std.posix.mmap(
+        null,
+        @intCast(stat.size),
+        std.posix.PROT.READ,
+        .{ .TYPE = .PRIVATE },
+        file.handle,
+        0,
+    ) catch {
+        result_out.validation = 3;
+        return null;
+    };
+    // Advisory only: one sequential pass for the hash, then the parser
+    std.posix.madvise(data.ptr, data.len, std.posix.MADV.SEQUENTIAL) catch {};
+
+    const mapping = std.heap.c_allocator.create(MappedInput) catch {
+        std.posix.munmap(data);
+        result_out.validation = 3;
+        return null;
+    };
+    mapping.* = .{ .data = data };
+
+    result_out.content_kind = @intFromEnum(detectMagic(data[0..@min(data.len, 16)]));
+
+    var digest: [32]u8 = undefined;
+    std.crypto.hash.sha2.Sha256.hash(data, &digest, .{});
+    writeHexDigest(digest, &result_out.sha256);
 
     result_out.validation = 0;
-    return 0;
+    // SAFETY: mapping was just allocated by c_allocator.create(MappedInput), which returns a well-aligned *MappedInput
+    return @ptrCast(mapping);
+}
+
+/// Release a mapping returned by ddac_conduit_map(). Safe to call with null.
+export fn ddac_conduit_unmap(mapping: ?*anyopaque) void {
+    const ptr = mapping orelse return;
+    // SAFETY: ptr originates from ddac_conduit_map() which returns a *MappedInput via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *MappedInput = @ptrCast(@alignCast(ptr));
+    std.posix.munmap(m.data);
+    std.heap.c_allocator.destroy(m);
 }
 
 /// Batch pre-process: process N files and write results.
-/// paths: array of N null-terminated path pointers
+/// paths: array of N null-terminated path pointers (null = skip slot;
+///        its result reads validation = 1)
 /// results: array of N ConduitResult structs
 /// count: number of files
 /// Returns number of valid (validation==0) files.
-export fn ddac_conduit_batch(
-    paths: [*]const [*:0]const u8,
+pub export fn ddac_conduit_batch(
+    paths: [*]const ?[*:0]const u8,
     results: [*]ConduitResult,
     count: u32,
 ) u32 {
+    if (builtin.os.tag == .linux) {
+        if (uringBatch(paths, results, count)) |valid| return valid;
+    }
+    return sequentialBatch(paths, results, 0, count);
+}
+
+/// Wait for a batch started by ddac_conduit_batch_start() and free the job.
+/// Returns the number of valid files. Safe to call with null (returns 0;
+/// the batch already ran synchronously).
+export fn ddac_conduit_batch_wait(job_ptr: ?*anyopaque) u32 {
+    const ptr = job_ptr orelse return 0;
+    // SAFETY: ptr originates from Worker.start() which returns a *BatchJob via @ptrCast; alignment is guaranteed by c_allocator
+    const job: *BatchJob = @ptrCast(@alignCast(ptr));
+    job.worker.wait(job);
+    const valid = job.valid;
+    std.heap.c_allocator.destroy(job);
+    return valid;
+}
+
+/// One queued batch. Allocated by Worker.start(), freed by
+/// ddac_conduit_batch_wait().
+const BatchJob = struct {
+    worker: *Worker,
+    paths: [*]const ?[*:0]const u8,
+    results: [*]ConduitResult,
+    count: u32,
+    valid: u32 = 0,
+    /// Set by the worker thread once results are filled
+    done: bool = false,
+    next: ?*BatchJob = null,
+};
+
+/// One persistent conduit thread per parse handle, spawned on first use.
+/// Batches queue in FIFO order (a task may have the chunk it is parsing
+/// and the one it claimed ahead outstanding at once), and the thread keeps
+/// its io_uring and lane buffers across batches, so a chunk costs a
+/// handoff rather than a thread spawn and a ring setup.
+pub const Worker = struct {
+    thread: ?std.Thread = null,
+    mutex: std.Thread.Mutex = .{},
+    cond: std.Thread.Condition = .{},
+    /// Queued jobs; the head is the one being run
+    head: ?*BatchJob = null,
+    tail: ?*BatchJob = null,
+    stop: bool = false,
+    /// The thread could not be spawned; later batches run inline
+    spawn_failed: bool = false,
+    /// Ring and lane buffers, owned by the thread (Linux; null until the
+    /// first batch, or after a ring failure)
+    uring: ?*UringBatch = null,
+
+    /// Stop and join the thread (after any queued batches). Safe if never used.
+    pub fn deinit(self: *Worker) void {
+        const t = self.thread orelse return;
+        self.mutex.lock();
+        self.stop = true;
+        self.cond.broadcast();
+        self.mutex.unlock();
+        t.join();
+        self.thread = null;
+        if (builtin.os.tag == .linux) {
+            if (self.uring) |b| b.destroy();
+        }
+        self.uring = null;
+    }
+
+    /// Queue a batch and return its job handle for ddac_conduit_batch_wait().
+    /// If the job cannot be allocated or the thread spawned, the batch runs
+    /// before this returns and the result is null.
+    pub fn start(
+        self: *Worker,
+        paths: [*]const ?[*:0]const u8,
+        results: [*]ConduitResult,
+        count: u32,
+    ) ?*anyopaque {
+        if (self.thread == null and !self.spawn_failed) {
+            self.thread = std.Thread.spawn(.{}, loop, .{self}) catch blk: {
+                self.spawn_failed = true;
+                break :blk null;
+            };
+        }
+        if (self.thread == null) {
+            _ = ddac_conduit_batch(paths, results, count);
+            return null;
+        }
+        const job = std.heap.c_allocator.create(BatchJob) catch {
+            _ = ddac_conduit_batch(paths, results, count);
+            return null;
+        };
+        job.* = .{ .worker = self, .paths = paths, .results = results, .count = count };
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (self.tail) |t| t.next = job else self.head = job;
+        self.tail = job;
+        self.cond.broadcast();
+        // SAFETY: job was just allocated by c_allocator.create(BatchJob), which returns a well-aligned *BatchJob
+        return @ptrCast(job);
+    }
+
+    /// Block until `job` has been run.
+    fn wait(self: *Worker, job: *BatchJob) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (!job.done) self.cond.wait(&self.mutex);
+    }
+
+    fn loop(self: *Worker) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            while (self.head == null and !self.stop) self.cond.wait(&self.mutex);
+            const job = self.head orelse return;
+            self.mutex.unlock();
+            job.valid = self.run(job.paths, job.results, job.count);
+            self.mutex.lock();
+            self.head = job.next;
+            if (self.head == null) self.tail = null;
+            job.done = true;
+            self.cond.broadcast();
+        }
+    }
+
+    /// ddac_conduit_batch() on the thread's own ring.
+    fn run(self: *Worker, paths: [*]const ?[*:0]const u8, results: [*]ConduitResult, count: u32) u32 {
+        if (builtin.os.tag == .linux and count > 0) {
+            if (self.uring == null) self.uring = UringBatch.create(BATCH_WINDOW);
+            if (self.uring) |b| {
+                const valid = b.run(paths, results, count);
+                // A failed ring is left to leak (see UringBatch.run); the
+                // next batch sets up a fresh one
+                if (b.broken) self.uring = null;
+                return valid;
+            }
+        }
+        return sequentialBatch(paths, results, 0, count);
+    }
+};
+
+/// Portable fallback: ddac_conduit_process() per file.
+fn sequentialBatch(paths: [*]const ?[*:0]const u8, results: [*]ConduitResult, from: u32, count: u32) u32 {
     var valid: u32 = 0;
-    for (0..count) |i| {
-        const rc = ddac_conduit_process(paths[i], &results[i]);
-        if (rc == 0) valid += 1;
+    for (from..count) |i| {
+        const path = paths[i] orelse {
+            results[i] = std.mem.zeroes(ConduitResult);
+            results[i].validation = 1;
+            continue;
+        };
+        if (ddac_conduit_process(path, &results[i]) == 0) valid += 1;
     }
     return valid;
 }
 
+// ============================================================================
+// io_uring batch (Linux)
+// ============================================================================
+
+/// Files in flight at once; each lane owns one read buffer.
+const BATCH_WINDOW: usize = 32;
+
+/// Bytes per read request. Files that fit in one read are parked after
+/// the read and hashed together via hw_crypto.sha256Many(); larger files
+/// are hashed incrementally as each read completes.
+const BATCH_READ_SIZE: usize = 128 * 1024;
+
+/// Parked small files are hashed once this many are waiting (one full
+/// multi-buffer pass on the widest SHA-256 tier).
+const HASH_GROUP: usize = hw_crypto.MAX_LANES;
+
+/// Lane validation code meaning "redo this file synchronously": the kernel
+/// rejected IORING_OP_OPENAT/STATX with EINVAL (pre-5.6 kernels).
+const REDO_SYNC: u8 = 0xFF;
+
+const LaneOp = enum(u8) { open = 1, stat = 2, read = 3, close = 4 };
+
+const Lane = struct {
+    file: u32 = 0,
+    fd: std.os.linux.fd_t = -1,
+    /// Outstanding SQEs; the lane advances when this drops to zero.
+    in_flight: u8 = 0,
+    phase: enum { idle, opening, reading, closing, parked } = .idle,
+    /// Failure code to report (ConduitResult.validation), 0 = ok so far.
+    validation: u8 = 0,
+    /// Whole file fits in buf: hash in a group instead of streaming.
+    small: bool = false,
+    size: u64 = 0,
+    offset: u64 = 0,
+    last_read: i32 = 0,
+    stx: std.os.linux.Statx = undefined,
+    hasher: std.crypto.hash.sha2.Sha256 = undefined,
+    buf: []u8 = &.{},
+    /// Conduit phase span for the file, from open to retire
+    span: metrics.Span = undefined,
+};
+
+/// A ring and its lane buffers, reusable for successive batches.
+const UringBatch = struct {
+    ring: std.os.linux.IoUring,
+    /// Backing store of the lane buffers (window * BATCH_READ_SIZE)
+    bufs: []u8,
+    /// Lanes with a buffer
+    window: usize,
+    /// The ring failed mid-batch; the batch must not be reused or freed
+    broken: bool = false,
+    lanes: [BATCH_WINDOW]Lane = [_]Lane{.{}} ** BATCH_WINDOW,
+    paths: [*]const ?[*:0]const u8 = undefined,
+    results: [*]ConduitResult = undefined,
+    count: u32 = 0,
+    next: u32 = 0,
+    /// Lanes not idle (including parked).
+    busy: usize = 0,
+    parked: [BATCH_WINDOW]u8 = undefined,
+    parked_n: usize = 0,
+    valid: u32 = 0,
+
+    /// Set up a ring with `window` lanes (at most BATCH_WINDOW). Returns
+    /// null if the ring cannot be set up.
+    fn create(window: usize) ?*UringBatch {
+        const allocator = std.heap.c_allocator;
+        const b = allocator.create(UringBatch) catch return null;
+        // Each lane has at most two SQEs outstanding (open + stat)
+        const ring = std.os.linux.IoUring.init(@intCast(2 * BATCH_WINDOW), 0) catch {
+            allocator.destroy(b);
+            return null;
+        };
+        const bufs = allocator.alloc(u8, window * BATCH_READ_SIZE) catch {
+            var r = ring;
+            r.deinit();
+            allocator.destroy(b);
+            return null;
+        };
+        b.* = .{ .ring = ring, .bufs = bufs, .window = window };
+        for (0..window) |li| b.lanes[li].buf = bufs[li * BATCH_READ_SIZE ..][0..BATCH_READ_SIZE];
+        return b;
+    }
+
+    fn destroy(self: *UringBatch) void {
+        const allocator = std.heap.c_allocator;
+        allocator.free(self.bufs);
+        self.ring.deinit();
+        allocator.destroy(self);
+    }
+
+    /// Run one batch over the ring. If the ring itself fails, the rest of
+    /// the batch is finished synchronously and `broken` is set.
+    fn run(self: *UringBatch, paths: [*]const ?[*:0]const u8, results: [*]ConduitResult, count: u32) u32 {
+        self.paths = paths;
+        self.results = results;
+        self.count = count;
+        self.next = 0;
+        self.busy = 0;
+        self.parked_n = 0;
+        self.valid = 0;
+        const window = @min(self.window, count);
+        for (0..window) |li| self.start(li);
+
+        var cqes: [2 * BATCH_WINDOW]std.os.linux.io_uring_cqe = undefined;
+        while (self.busy > 0) {
+            // Nothing left in flight but parked files: hash them now
+            if (self.parked_n > 0 and self.parked_n == self.busy) {
+                self.hashParked();
+                continue;
+            }
+            _ = self.ring.submit_and_wait(1) catch |err| switch (err) {
+                error.SignalInterrupt, error.SystemResources, error.CompletionQueueOvercommitted => {},
+                else => break,
+            };
+            const n = self.ring.copy_cqes(&cqes, 0) catch |err| switch (err) {
+                error.SignalInterrupt => continue,
+                else => break,
+            };
+            for (cqes[0..n]) |cqe| self.complete(cqe);
+        }
+
+        if (self.busy > 0) {
+            // The ring itself failed mid-batch. Reads may still be in flight
+            // into the lane buffers and descriptors may be mid-close, so both
+            // are deliberately leaked; unfinished files are redone synchronously.
+            std.log.err("Conduit: io_uring batch aborted, finishing {d} files synchronously", .{count - self.next + self.busy});
+            self.broken = true;
+            var valid = self.valid;
+            for (self.lanes[0..window]) |lane| {
+                if (lane.phase == .idle) continue;
+                if (ddac_conduit_process(paths[lane.file].?, &results[lane.file]) == 0) valid += 1;
+            }
+            return valid + sequentialBatch(paths, results, self.next, count);
+        }
+        return self.valid;
+    }
+
+    fn userData(li: usize, op: LaneOp) u64 {
+        return (@as(u64, li) << 8) | @intFromEnum(op);
+    }
+
+    /// Queue one operation for lane li. Returns false if the ring refused it.
+    fn queue(self: *UringBatch, li: usize, op: LaneOp) bool {
+        const lane = &self.lanes[li];
+        const ud = userData(li, op);
+        const linux = std.os.linux;
+        const ok = switch (op) {
+            .open => if (self.ring.openat(ud, linux.AT.FDCWD, self.paths[lane.file].?, .{ .ACCMODE = .RDONLY, .CLOEXEC = true }, 0)) |_| true else |_| false,
+            .stat => if (self.ring.statx(ud, linux.AT.FDCWD, std.mem.span(self.paths[lane.file].?), 0, linux.STATX_SIZE, &lane.stx)) |_| true else |_| false,
+            .read => blk: {
+                // A small file accumulates in buf; a large one reuses it per read
+                const at: usize = if (lane.small) @intCast(lane.offset) else 0;
+                const len: usize = @intCast(@min(@as(u64, lane.buf.len - at), lane.size - lane.offset));
+                break :blk if (self.ring.read(ud, lane.fd, .{ .buffer = lane.buf[at..][0..len] }, lane.offset)) |_| true else |_| false;
+            },
+            .close => if (self.ring.close(ud, lane.fd)) |_| true else |_| false,
+        };
+        if (ok) lane.in_flight += 1;
+        return ok;
+    }
+
+    /// Put the next unprocessed file on lane li (or leave it idle).
+    fn start(self: *UringBatch, li: usize) void {
+        const lane = &self.lanes[li];
+        while (self.next < self.count) {
+            const f = self.next;
+            self.next += 1;
+            self.results[f] = std.mem.zeroes(ConduitResult);
+            if (self.paths[f] == null) {
+                self.results[f].validation = 1;
+                continue;
+            }
+
+            lane.* = .{ .file = f, .buf = lane.buf, .phase = .opening, .span = metrics.begin(.conduit) };
+            const opened = self.queue(li, .open);
+            const statted = self.queue(li, .stat);
+            if (!opened and !statted) {
+                // Ring refused both: handle this file synchronously
+                if (ddac_conduit_process(self.paths[f].?, &self.results[f]) == 0) self.valid += 1;
+                continue;
+            }
+            if (!opened) lane.validation = 1;
+            if (!statted) lane.validation = 3;
+            self.busy += 1;
+            return;
+        }
+        lane.phase = .idle;
+    }
+
+    fn complete(self: *UringBatch, cqe: std.os.linux.io_uring_cqe) void {
+        const li: usize = @intCast(cqe.user_data >> 8);
+        const lane = &self.lanes[li];
+        lane.in_flight -= 1;
+
+        switch (@as(LaneOp, @enumFromInt(@as(u8, @truncate(cqe.user_data))))) {
+            .open => if (cqe.err() == .INVAL) {
+                lane.validation = REDO_SYNC;
+            } else if (cqe.res < 0) {
+                if (lane.validation != REDO_SYNC) lane.validation = 1; // not found / not openable
+            } else {
+                lane.fd = cqe.res;
+            },
+            .stat => if (cqe.err() == .INVAL) {
+                lane.validation = REDO_SYNC;
+            } else if (cqe.res < 0) {
+                if (lane.validation == 0) lane.validation = 3;
+            } else {
+                lane.size = lane.stx.size;
+            },
+            .read => lane.last_read = cqe.res,
+            .close => lane.fd = -1,
+        }
+        if (lane.in_flight == 0) self.advance(li);
+    }
+
+    fn advance(self: *UringBatch, li: usize) void {
+        const lane = &self.lanes[li];
+        const result = &self.results[lane.file];
+        switch (lane.phase) {
+            .opening => {
+                result.file_size = @intCast(lane.size);
+                if (lane.validation == 0 and lane.size == 0) lane.validation = 2; // empty
+                if (lane.validation != 0) return self.finish(li);
+
+                lane.phase = .reading;
+                lane.small = lane.size <= lane.buf.len;
+                if (!lane.small) lane.hasher = std.crypto.hash.sha2.Sha256.init(.{});
+                if (!self.queue(li, .read)) {
+                    lane.validation = 3;
+                    self.finish(li);
+                }
+            },
+            .reading => {
+                if (lane.last_read < 0) {
+                    lane.validation = 3;
+                    return self.finish(li);
+                }
+                const n: usize = @intCast(lane.last_read);
+                if (lane.offset == 0)
+                    result.content_kind = @intFromEnum(detectMagic(lane.buf[0..@min(n, 16)]));
+
+                if (n == 0 and lane.offset < lane.size) {
+                    // Early EOF (the file shrank since statx): redo it
+                    // synchronously rather than hash a truncated file
+                    lane.validation = REDO_SYNC;
+                    return self.finish(li);
+                }
+                if (lane.small) {
+                    // Accumulates in buf; hashed as part of a group after
+                    // close once the whole file is in (short reads resubmit)
+                    lane.offset += n;
+                    if (lane.offset >= lane.size) return self.finish(li);
+                } else {
+                    lane.hasher.update(lane.buf[0..n]);
+                    lane.offset += n;
+                    if (lane.offset >= lane.size) {
+                        writeHexDigest(lane.hasher.finalResult(), &result.sha256);
+                        return self.finish(li);
+                    }
+                }
+                if (!self.queue(li, .read)) {
+                    lane.validation = 3;
+                    self.finish(li);
+                }
+            },
+            .closing => {
+                if (lane.small and lane.validation == 0) {
+                    lane.phase = .parked;
+                    self.parked[self.parked_n] = @intCast(li);
+                    self.parked_n += 1;
+                    if (self.parked_n >= HASH_GROUP) self.hashParked();
+                } else {
+                    self.retire(li);
+                }
+            },
+            .idle, .parked => {},
+        }
+    }
+
+    /// Close the lane's file (if open), then retire or park it.
+    fn finish(self: *UringBatch, li: usize) void {
+        const lane = &self.lanes[li];
+        lane.phase = .closing;
+        if (lane.fd >= 0) {
+            if (self.queue(li, .close)) return;
+            std.posix.close(lane.fd);
+            lane.fd = -1;
+        }
+        self.advance(li);
+    }
+
+    fn retire(self: *UringBatch, li: usize) void {
+        const lane = &self.lanes[li];
+        const f = lane.file;
+        if (lane.validation == REDO_SYNC) {
+            // ddac_conduit_process records its own span
+            if (ddac_conduit_process(self.paths[f].?, &self.results[f]) == 0) self.valid += 1;
+        } else {
+            lane.span.end();
+            self.results[f].validation = lane.validation;
+            if (lane.validation == 0) self.valid += 1;
+        }
+        self.busy -= 1;
+        self.start(li);
+    }
+
+    /// Hash every parked small file in one hw_crypto.sha256Many() call.
+    fn hashParked(self: *UringBatch) void {
+        var msgs: [BATCH_WINDOW][]const u8 = undefined;
+        var digests: [BATCH_WINDOW][32]u8 = undefined;
+        const k = self.parked_n;
+        for (self.parked[0..k], 0..) |li, j| {
+            const lane = &self.lanes[li];
+            msgs[j] = lane.buf[0..@intCast(lane.offset)];
+        }
+        hw_crypto.sha256Many(msgs[0..k], digests[0..k]);
+
+        self.parked_n = 0;
+        for (self.parked[0..k], 0..) |li, j| {
+            writeHexDigest(digests[j], &self.results[self.lanes[li].file].sha256);
+            self.retire(li);
+        }
+    }
+};
+
+/// Run a batch on a one-off ring. Returns null if a ring cannot be set up
+/// (the caller falls back to the sequential path).
+fn uringBatch(paths: [*]const ?[*:0]const u8, results: [*]ConduitResult, count: u32) ?u32 {
+    if (count == 0) return 0;
+    const b = UringBatch.create(@min(BATCH_WINDOW, count)) orelse return null;
+    const valid = b.run(paths, results, count);
+    if (!b.broken) b.destroy();
+    return valid;
+}
+
 /// Get the struct size for Chapel allocation.
 export fn ddac_conduit_result_size() usize {
     return @sizeOf(ConduitResult);
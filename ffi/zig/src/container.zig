@@ -0,0 +1,475 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Packed Results Container
+//
+// Replaces one output file + one .stages.capnp sidecar per document with a
+// handful of append-only files per locale shard:
+//
+//   segment-NNNNN.dat  extracted text and Cap'n Proto stage messages,
+//                      back to back; a new segment starts at segment_max
+//   index.bin          16-byte header + one 64-byte IndexRecord per blob
+//                      (manifest index, raw SHA-256, segment, offset, length)
+//   results.bin        16-byte header + row groups of ddac_parse_result_t
+//                      rows stored column by column (ROW_GROUP rows each)
+//
+// Tasks append concurrently: a blob's segment range is reserved under the
+// mutex and written with pwrite outside it; its index record is queued only
+// after the bytes are written, so the index never points past written data.
+// Index records and result rows are buffered and written in large blocks.
+//
+// ddac_container_merge() builds a single catalog over every shard by
+// concatenating their index files — segments are never copied, so the
+// merge is metadata-only.
+//
+// A container opened in append mode (resumed runs) keeps what an earlier
+// run stored: index.bin and results.bin are cut back to their last whole
+// record / row group, and blobs continue at the end of the last segment.
+// A later record for the same document supersedes an earlier one.
+
+const std = @import("std");
+
+// ============================================================================
+// File Formats
+// ============================================================================
+
+const INDEX_MAGIC = "DDACIDX1".*;
+const RESULTS_MAGIC = "DDACCOLS".*;
+const GROUP_MAGIC = "DDACRGRP".*;
+const CATALOG_MAGIC = "DDACCAT1".*;
+const FORMAT_VERSION: u32 = 1;
+
+pub const BlobKind = enum(u16) {
+    text = 1,
+    stages = 2,
+};
+
+pub const IndexRecord = extern struct {
+    doc_idx: u64,
+    sha256: [32]u8,
+    segment: u32,
+    kind: u16,
+    _pad: u16 = 0,
+    offset: u64,
+    length: u64,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(IndexRecord) == 64);
+}
+
+/// Rows per column-major row group in results.bin
+const ROW_GROUP: usize = 4096;
+/// Buffered index bytes before a write
+const INDEX_FLUSH_BYTES: usize = 1024 * 1024;
+const DEFAULT_SEGMENT_MB: u64 = 4096;
+
+/// sizeof(ddac_parse_result_t); rows arrive as raw bytes (like cache.zig)
+/// so this module does not import the parser.
+pub const RESULT_SIZE: usize = 952;
+
+/// (offset, size) of each ddac_parse_result_t field, in declaration order:
+/// status, content_kind, page_count, word_count, char_count, duration_sec,
+/// parse_time_ms, sha256, error_msg, title, author, mime_type.
+const RESULT_COLUMNS = [_][2]usize{
+    .{ 0, 4 },   .{ 4, 4 },    .{ 8, 4 },    .{ 16, 8 },
+    .{ 24, 8 },  .{ 32, 8 },   .{ 40, 8 },   .{ 48, 65 },
+    .{ 120, 256 }, .{ 376, 256 }, .{ 632, 256 }, .{ 888, 64 },
+};
+
+/// Bytes of one row in a row group: doc_idx plus every column.
+const GROUP_ROW_BYTES: usize = blk: {
+    var n: usize = @sizeOf(u64);
+    for (RESULT_COLUMNS) |col| n += col[1];
+    break :blk n;
+};
+
+const Row = struct {
+    doc_idx: u64,
+    result: [RESULT_SIZE]u8,
+};
+
+// ============================================================================
+// Container State
+// ============================================================================
+
+const Container = struct {
+    dir: std.fs.Dir,
+    segment_max: u64,
+
+    mutex: std.Thread.Mutex = .{},
+    /// Every segment opened so far; the last one is being appended to
+    segments: std.ArrayList(std.fs.File) = .empty,
+    seg_end: u64 = 0,
+
+    index_file: std.fs.File,
+    index_buf: std.ArrayList(u8) = .empty,
+    results_file: std.fs.File,
+    rows: std.ArrayList(Row) = .empty,
+    group_buf: std.ArrayList(u8) = .empty,
+
+    /// Counters for this run (not blobs/rows kept from an earlier run)
+    blobs: u64 = 0,
+    blob_bytes: u64 = 0,
+    rows_total: u64 = 0,
+    failed: bool = false,
+
+    /// Open the next segment file. Caller holds mutex.
+    fn openSegment(self: *Container) !void {
+        var name_buf: [32]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "segment-{d:0>5}.dat", .{self.segments.items.len});
+        const file = try self.dir.createFile(name, .{ .truncate = true });
+        errdefer file.close();
+        try self.segments.append(std.heap.c_allocator, file);
+        self.seg_end = 0;
+    }
+
+    /// Reserve len bytes at the end of the current segment, rolling to a
+    /// new segment when it would pass segment_max. Caller holds mutex.
+    fn reserve(self: *Container, len: u64) !struct { segment: u32, offset: u64 } {
+        if (self.segments.items.len == 0 or
+            (self.seg_end > 0 and self.seg_end + len > self.segment_max)) try self.openSegment();
+        const off = self.seg_end;
+        self.seg_end += len;
+        return .{ .segment = @intCast(self.segments.items.len - 1), .offset = off };
+    }
+
+    /// Write buffered index records. Caller holds mutex.
+    fn flushIndex(self: *Container) void {
+        if (self.index_buf.items.len == 0) return;
+        self.index_file.writeAll(self.index_buf.items) catch {
+            self.failed = true;
+        };
+        self.index_buf.clearRetainingCapacity();
+    }
+
+    /// Write the buffered rows as one column-major row group. Caller holds mutex.
+    fn flushRows(self: *Container) void {
+        const rows = self.rows.items;
+        if (rows.len == 0) return;
+        const allocator = std.heap.c_allocator;
+        const buf = &self.group_buf;
+        buf.clearRetainingCapacity();
+
+        var header: [16]u8 = undefined;
+        @memcpy(header[0..8], &GROUP_MAGIC);
+        std.mem.writeInt(u32, header[8..12], @intCast(rows.len), .little);
+        std.mem.writeInt(u32, header[12..16], 0, .little);
+        buf.appendSlice(allocator, &header) catch {
+            self.failed = true;
+            return;
+        };
+
+        // doc_idx column, then one column per ddac_parse_result_t field
+        for (rows) |*r| buf.appendSlice(allocator, std.mem.asBytes(&r.doc_idx)) catch {
+            self.failed = true;
+            return;
+        };
+        for (RESULT_COLUMNS) |col| {
+            for (rows) |*r| buf.appendSlice(allocator, r.result[col[0]..][0..col[1]]) catch {
+                self.failed = true;
+                return;
+            };
+        }
+
+        self.results_file.writeAll(buf.items) catch {
+            self.failed = true;
+        };
+        self.rows.clearRetainingCapacity();
+    }
+};
+
+fn writeHeader(file: std.fs.File, magic: [8]u8, value: u32) !void {
+    var header: [16]u8 = undefined;
+    @memcpy(header[0..8], &magic);
+    std.mem.writeInt(u32, header[8..12], FORMAT_VERSION, .little);
+    std.mem.writeInt(u32, header[12..16], value, .little);
+    try file.writeAll(&header);
+}
+
+/// Open a container log file. In append mode an existing file with the
+/// right header is kept and positioned at `validEnd` of its size (a torn
+/// tail from a crashed run is cut off); otherwise it is created fresh.
+fn openLog(
+    dir: std.fs.Dir,
+    name: []const u8,
+    magic: [8]u8,
+    value: u32,
+    append: bool,
+    comptime validEnd: fn (std.fs.File, u64) anyerror!u64,
+) !std.fs.File {
+    if (append) {
+        if (dir.openFile(name, .{ .mode = .read_write })) |file| {
+            errdefer file.close();
+            var header: [16]u8 = undefined;
+            const size = try file.getEndPos();
+            if (size < header.len or try file.preadAll(&header, 0) != header.len) return error.BadContainer;
+            if (!std.mem.eql(u8, header[0..8], &magic) or
+                std.mem.readInt(u32, header[8..12], .little) != FORMAT_VERSION or
+                std.mem.readInt(u32, header[12..16], .little) != value) return error.BadContainer;
+            const end = try validEnd(file, size);
+            if (end < size) try file.setEndPos(end);
+            try file.seekTo(end);
+            return file;
+        } else |err| {
+            if (err != error.FileNotFound) return err;
+        }
+    }
+    const file = try dir.createFile(name, .{ .truncate = true });
+    errdefer file.close();
+    try writeHeader(file, magic, value);
+    return file;
+}
+
+/// End of the last whole index record.
+fn indexEnd(_: std.fs.File, size: u64) anyerror!u64 {
+    return 16 + (size - 16) / @sizeOf(IndexRecord) * @sizeOf(IndexRecord);
+}
+
+/// End of the last whole row group.
+fn resultsEnd(file: std.fs.File, size: u64) anyerror!u64 {
+    var pos: u64 = 16;
+    while (pos + 16 <= size) {
+        var header: [16]u8 = undefined;
+        if (try file.preadAll(&header, pos) != header.len) break;
+        if (!std.mem.eql(u8, header[0..8], &GROUP_MAGIC)) break;
+        const group = 16 + @as(u64, std.mem.readInt(u32, header[8..12], .little)) * GROUP_ROW_BYTES;
+        if (pos + group > size) break;
+        pos += group;
+    }
+    return pos;
+}
+
+/// Reopen the segments an earlier run wrote, in order, so new blobs
+/// continue at the end of the last one.
+fn reopenSegments(c: *Container) !void {
+    while (true) {
+        var name_buf: [32]u8 = undefined;
+        const name = try std.fmt.bufPrint(&name_buf, "segment-{d:0>5}.dat", .{c.segments.items.len});
+        const file = c.dir.openFile(name, .{ .mode = .read_write }) catch |err| switch (err) {
+            error.FileNotFound => return,
+            else => return err,
+        };
+        errdefer file.close();
+        const end = try file.getEndPos();
+        try c.segments.append(std.heap.c_allocator, file);
+        c.seg_end = end;
+    }
+}
+
+fn openImpl(dir_path: [*:0]const u8, segment_mb: u32, append: bool) !*Container {
+    const allocator = std.heap.c_allocator;
+    var dir = try std.fs.cwd().makeOpenPath(std.mem.span(dir_path), .{});
+    errdefer dir.close();
+
+    const index_file = try openLog(dir, "index.bin", INDEX_MAGIC, @sizeOf(IndexRecord), append, indexEnd);
+    errdefer index_file.close();
+    const results_file = try openLog(dir, "results.bin", RESULTS_MAGIC, ROW_GROUP, append, resultsEnd);
+    errdefer results_file.close();
+
+    const c = try allocator.create(Container);
+    errdefer allocator.destroy(c);
+    c.* = .{
+        .dir = dir,
+        .segment_max = (if (segment_mb == 0) DEFAULT_SEGMENT_MB else segment_mb) * 1024 * 1024,
+        .index_file = index_file,
+        .results_file = results_file,
+    };
+    if (append) {
+        errdefer {
+            for (c.segments.items) |f| f.close();
+            c.segments.deinit(allocator);
+        }
+        try reopenSegments(c);
+    }
+    return c;
+}
+
+// ============================================================================
+// Blob target — where a parse sends its text and stage message
+// ============================================================================
+
+/// One document's destination in a container, bound to a parse handle by
+/// ddac_set_container_doc(). Used by the text write-behind sink and by
+/// runStages in place of the per-document files.
+pub const BlobTarget = struct {
+    container: *anyopaque,
+    doc_idx: u64,
+    sha256: *const [65]u8,
+
+    /// Append parts as one blob and index it.
+    pub fn append(self: BlobTarget, kind: BlobKind, parts: []const []const u8) !void {
+        // SAFETY: container originates from ddac_container_open() which returns a *Container via @ptrCast; alignment is guaranteed by c_allocator
+        const c: *Container = @ptrCast(@alignCast(self.container));
+        var len: u64 = 0;
+        for (parts) |p| len += p.len;
+
+        c.mutex.lock();
+        const slot = c.reserve(len) catch |err| {
+            c.failed = true;
+            c.mutex.unlock();
+            return err;
+        };
+        const file = c.segments.items[slot.segment];
+        c.mutex.unlock();
+
+        var off = slot.offset;
+        for (parts) |p| {
+            file.pwriteAll(p, off) catch |err| {
+                c.mutex.lock();
+                c.failed = true;
+                c.mutex.unlock();
+                return err;
+            };
+            off += p.len;
+        }
+
+        var rec = IndexRecord{
+            .doc_idx = self.doc_idx,
+            .sha256 = std.mem.zeroes([32]u8),
+            .segment = slot.segment,
+            .kind = @intFromEnum(kind),
+            .offset = slot.offset,
+            .length = len,
+        };
+        _ = std.fmt.hexToBytes(&rec.sha256, self.sha256[0..64]) catch {};
+
+        c.mutex.lock();
+        defer c.mutex.unlock();
+        try c.index_buf.appendSlice(std.heap.c_allocator, std.mem.asBytes(&rec));
+        c.blobs += 1;
+        c.blob_bytes += len;
+        if (c.index_buf.items.len >= INDEX_FLUSH_BYTES) c.flushIndex();
+    }
+};
+
+// ============================================================================
+// C-ABI exports
+// ============================================================================
+
+/// Open a results container in dir_path. segment_mb: segment size before
+/// rolling over (0 = 4096 MB). append != 0 keeps an existing container's
+/// index, rows and segments and adds to them (resume); otherwise it is
+/// created afresh (truncated). Returns opaque handle, or null on failure
+/// (including an existing file that is not a container).
+export fn ddac_container_open(dir_path: [*:0]const u8, segment_mb: u32, append: u8) ?*anyopaque {
+    const c = openImpl(dir_path, segment_mb, append != 0) catch return null;
+    // SAFETY: c was just allocated by c_allocator.create(Container), which returns a well-aligned *Container
+    return @ptrCast(c);
+}
+
+/// Append one document's result row (parsed or served from cache).
+/// result_size must be sizeof(ddac_parse_result_t). Thread-safe.
+/// Returns 0, or -1 on failure.
+export fn ddac_container_put_result(container: ?*anyopaque, doc_idx: u64, result: *const anyopaque, result_size: usize) i32 {
+    const ptr = container orelse return -1;
+    if (result_size != RESULT_SIZE) return -1;
+    // SAFETY: result points to result_size (= RESULT_SIZE) readable bytes per the C ABI contract; [RESULT_SIZE]u8 has alignment 1
+    const bytes: *const [RESULT_SIZE]u8 = @ptrCast(result);
+    // SAFETY: ptr originates from ddac_container_open() which returns a *Container via @ptrCast; alignment is guaranteed by c_allocator
+    const c: *Container = @ptrCast(@alignCast(ptr));
+    c.mutex.lock();
+    defer c.mutex.unlock();
+    c.rows.append(std.heap.c_allocator, .{ .doc_idx = doc_idx, .result = bytes.* }) catch {
+        c.failed = true;
+        return -1;
+    };
+    c.rows_total += 1;
+    if (c.rows.items.len >= ROW_GROUP) c.flushRows();
+    return 0;
+}
+
+/// Container counters: blobs indexed and result rows added by this run,
+/// their blob bytes, and segment files (including reopened ones).
+export fn ddac_container_stats(container: ?*anyopaque, blobs: *u64, bytes: *u64, rows: *u64, segments: *u32) void {
+    blobs.* = 0;
+    bytes.* = 0;
+    rows.* = 0;
+    segments.* = 0;
+    const ptr = container orelse return;
+    // SAFETY: ptr originates from ddac_container_open() which returns a *Container via @ptrCast; alignment is guaranteed by c_allocator
+    const c: *Container = @ptrCast(@alignCast(ptr));
+    c.mutex.lock();
+    defer c.mutex.unlock();
+    blobs.* = c.blobs;
+    bytes.* = c.blob_bytes;
+    rows.* = c.rows_total;
+    segments.* = @intCast(c.segments.items.len);
+}
+
+/// Flush buffered index records and rows, then close. No parse may still
+/// be writing to it. Safe to call with null. Returns 0, or -1 if any write
+/// failed during the run.
+export fn ddac_container_close(container: ?*anyopaque) i32 {
+    const ptr = container orelse return 0;
+    // SAFETY: ptr originates from ddac_container_open() which returns a *Container via @ptrCast; alignment is guaranteed by c_allocator
+    const c: *Container = @ptrCast(@alignCast(ptr));
+    const allocator = std.heap.c_allocator;
+
+    c.flushIndex();
+    c.flushRows();
+    const status: i32 = if (c.failed) -1 else 0;
+
+    for (c.segments.items) |f| f.close();
+    c.segments.deinit(allocator);
+    c.index_file.close();
+    c.results_file.close();
+    c.index_buf.deinit(allocator);
+    c.rows.deinit(allocator);
+    c.group_buf.deinit(allocator);
+    c.dir.close();
+    allocator.destroy(c);
+    return status;
+}
+
+/// Write a catalog over n shard containers to out_path: a header, one
+/// (path, record count) entry per shard, then every shard's index records
+/// in shard order. Segments stay where they are. Returns the number of
+/// index records catalogued, or -1 on failure.
+export fn ddac_container_merge(out_path: [*:0]const u8, shard_dirs: [*]const [*:0]const u8, n: u32) i64 {
+    return mergeImpl(out_path, shard_dirs[0..n]) catch -1;
+}
+
+fn mergeImpl(out_path: [*:0]const u8, shard_dirs: []const [*:0]const u8) !i64 {
+    const allocator = std.heap.c_allocator;
+    const indexes = try allocator.alloc(?std.fs.File, shard_dirs.len);
+    defer allocator.free(indexes);
+    @memset(indexes, null);
+    defer for (indexes) |f| if (f) |file| file.close();
+    const counts = try allocator.alloc(u64, shard_dirs.len);
+    defer allocator.free(counts);
+    @memset(counts, 0);
+
+    for (shard_dirs, indexes, counts) |dir, *idx, *count| {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = try std.fmt.bufPrint(&path_buf, "{s}/index.bin", .{std.mem.span(dir)});
+        const file = std.fs.cwd().openFile(path, .{}) catch continue; // shard wrote nothing
+        idx.* = file;
+        const size = (try file.stat()).size;
+        if (size >= 16) count.* = (size - 16) / @sizeOf(IndexRecord);
+    }
+
+    const out = try std.fs.cwd().createFileZ(out_path, .{ .truncate = true });
+    defer out.close();
+    try writeHeader(out, CATALOG_MAGIC, @intCast(shard_dirs.len));
+    var pos: u64 = 16;
+    for (shard_dirs, counts) |dir, count| {
+        const name = std.mem.span(dir);
+        var entry: [12]u8 = undefined;
+        std.mem.writeInt(u32, entry[0..4], @intCast(name.len), .little);
+        std.mem.writeInt(u64, entry[4..12], count, .little);
+        try out.writeAll(&entry);
+        try out.writeAll(name);
+        pos += entry.len + name.len;
+    }
+
+    var total: u64 = 0;
+    for (indexes, counts) |idx, count| {
+        const file = idx orelse continue;
+        const len = count * @sizeOf(IndexRecord);
+        const copied = try file.copyRangeAll(16, out, pos, len);
+        if (copied != len) return error.ShortCopy;
+        pos += len;
+        total += count;
+    }
+    return @intCast(total);
+}
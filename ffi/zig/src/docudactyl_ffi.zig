@@ -13,6 +13,9 @@
 //   - libxml2          (EPUB/XHTML parsing)
 //   - libgdal          (geospatial: shapefiles, GeoTIFF)
 //   - libvips          (image dimensions/metadata)
+//
+// Extracted text is collected in a per-handle TextArena; stages read it
+// from memory and the output file is written once by a write-behind sink.
 
 const std = @import("std");
 const stages = @import("stages.zig");
@@ -28,12 +31,23 @@ const financial_extract = @import("financial_extract.zig");
 const speaker_id = @import("speaker_id.zig");
 const reextract = @import("reextract.zig");
 const quality_stats = @import("quality_stats.zig");
+const text_arena = @import("text_arena.zig");
 // ── Investigator-Focused Modules (citizen & investigative journalism) ──
 const flight_log = @import("flight_log.zig");
 const entity_graph = @import("entity_graph.zig");
 const redaction_recovery = @import("redaction_recovery.zig");
 const evasion_detect = @import("evasion_detect.zig");
 const investigator_summary = @import("investigator_summary.zig");
+const checkpoint = @import("checkpoint.zig");
+const ndjson_writer = @import("ndjson_writer.zig");
+const container = @import("container.zig");
+const manifest_scan = @import("manifest_scan.zig");
+const isolate = @import("isolate.zig");
+const metrics = @import("metrics.zig");
+const tokenizer = @import("tokenizer.zig");
+const neardup = @import("neardup.zig");
+const result_codec = @import("result_codec.zig");
+const capnp = @import("capnp.zig");
 
 // Ensure submodule exports are included in the shared library
 comptime {
@@ -54,6 +68,16 @@ comptime {
     _ = redaction_recovery;
     _ = evasion_detect;
     _ = investigator_summary;
+    _ = checkpoint;
+    _ = ndjson_writer;
+    _ = container;
+    _ = manifest_scan;
+    _ = isolate;
+    _ = metrics;
+    _ = tokenizer;
+    _ = neardup;
+    _ = result_codec;
+    _ = capnp;
 }
 
 const c = @cImport({
@@ -153,12 +177,32 @@ pub const ParseResult = extern struct {
     duration_sec: f64,        // audio/video duration in seconds, 0 for text
     parse_time_ms: f64,       // wall-clock time to parse this document
     sha256: [65]u8,           // hex-encoded SHA-256 + null terminator
+    _pad1: [7]u8,             // explicit, so error_msg is at 120 as in the header and Layout.idr
     error_msg: [256]u8,       // error message + null terminator
     title: [256]u8,           // document title
     author: [256]u8,          // document author
     mime_type: [64]u8,        // detected MIME type
 };
 
+comptime {
+    // container.zig stores result rows as raw bytes of this size
+    std.debug.assert(@sizeOf(ParseResult) == container.RESULT_SIZE);
+    // result_codec.zig encodes cache values from these raw offsets
+    std.debug.assert(@sizeOf(ParseResult) == result_codec.ROW_SIZE);
+    std.debug.assert(@offsetOf(ParseResult, "status") == result_codec.OFF_STATUS);
+    std.debug.assert(@offsetOf(ParseResult, "content_kind") == result_codec.OFF_CONTENT_KIND);
+    std.debug.assert(@offsetOf(ParseResult, "page_count") == result_codec.OFF_PAGE_COUNT);
+    std.debug.assert(@offsetOf(ParseResult, "word_count") == result_codec.OFF_WORD_COUNT);
+    std.debug.assert(@offsetOf(ParseResult, "char_count") == result_codec.OFF_CHAR_COUNT);
+    std.debug.assert(@offsetOf(ParseResult, "duration_sec") == result_codec.OFF_DURATION);
+    std.debug.assert(@offsetOf(ParseResult, "parse_time_ms") == result_codec.OFF_PARSE_TIME);
+    std.debug.assert(@offsetOf(ParseResult, "sha256") == result_codec.OFF_SHA256);
+    std.debug.assert(@offsetOf(ParseResult, "error_msg") == result_codec.OFF_ERROR_MSG);
+    std.debug.assert(@offsetOf(ParseResult, "title") == result_codec.OFF_TITLE);
+    std.debug.assert(@offsetOf(ParseResult, "author") == result_codec.OFF_AUTHOR);
+    std.debug.assert(@offsetOf(ParseResult, "mime_type") == result_codec.OFF_MIME_TYPE);
+}
+
 /// Library handle — holds initialised library contexts
 const HandleState = struct {
     allocator: std.mem.Allocator,
@@ -169,6 +213,32 @@ const HandleState = struct {
     ml_handle: ?*anyopaque = null,
     /// GPU OCR coprocessor handle (optional, set via ddac_set_gpu_ocr_handle)
     gpu_ocr_handle: ?*anyopaque = null,
+    /// Ticket for the next parse's image, submitted ahead of the parse
+    /// (ddac_set_gpu_ocr_ticket); -1 if none. Spent or released per parse.
+    gpu_ocr_ticket: c_int = -1,
+    /// Results container for the next parse's text and stage message
+    /// (ddac_set_container_doc); null = write per-document files. Spent per parse.
+    container: ?*anyopaque = null,
+    container_doc: u64 = 0,
+    /// Extracted text of the current document (reset per parse, capacity reused)
+    text: text_arena.TextArena,
+    /// Output writer thread for the text arena (write-behind)
+    writer: text_arena.Writer = .{},
+    /// Conduit thread for ddac_conduit_batch_start (ring kept across batches)
+    conduit: conduit.Worker = .{},
+    /// Multi-language Tesseract for scanned PDF pages and image documents
+    /// (STAGE_MULTI_LANG_OCR); loaded on first use and kept warm
+    mlang_tess: ?*anyopaque = null,
+    /// Image document decoded by parseImage, shared with the image stages
+    /// (released per parse)
+    image: stages.SharedImage = .{},
+    /// Near-duplicate index check or verdict for the next parse's image
+    /// (ddac_set_neardup_doc/_verdict); spent per parse.
+    neardup: ?stages.NearDupCheck = null,
+    /// Segments the stage message is built in (reset per parse, kept warm)
+    stage_arena: capnp.Arena,
+    /// Write stage messages in Cap'n Proto packed encoding (ddac_set_stages_packed)
+    stages_packed: bool = false,
 };
 
 // ============================================================================
@@ -194,23 +264,8 @@ fn blankResult() ParseResult {
     return r;
 }
 
-/// Count words in a byte slice (whitespace-delimited)
-fn countWords(text: []const u8) i64 {
-    var count: i64 = 0;
-    var in_word = false;
-    for (text) |ch| {
-        if (ch == ' ' or ch == '\n' or ch == '\r' or ch == '\t') {
-            if (in_word) {
-                count += 1;
-                in_word = false;
-            }
-        } else {
-            in_word = true;
-        }
-    }
-    if (in_word) count += 1;
-    return count;
-}
+/// Count words in a byte slice (whitespace-delimited), 64 bytes at a time
+const countWords = tokenizer.countWords;
 
 /// Compute SHA-256 of a file and write hex string into dest
 fn computeSha256(path: []const u8, dest: *[65]u8) bool {
@@ -244,8 +299,16 @@ fn nowMs() f64 {
 // Per-format parsers
 // ============================================================================
 
-/// PDF: extract text + metadata via Poppler
-fn parsePdf(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult) void {
+/// Open a PDF with Poppler, from the mapped bytes when available,
+/// otherwise from a file:// URI built from the input path.
+fn openPdf(input_path: [*:0]const u8, mem: ?[]const u8, gerr: *?*c.GError, result: *ParseResult) ?*c.PopplerDocument {
+    if (mem) |bytes| {
+        // Static GBytes: the mapping outlives the document (owned by the caller)
+        const gbytes = c.g_bytes_new_static(bytes.ptr, bytes.len);
+        defer c.g_bytes_unref(gbytes);
+        return c.poppler_document_new_from_bytes(gbytes, null, gerr);
+    }
+
     const uri_buf_size = 4096;
     var uri_buf: [uri_buf_size]u8 = undefined;
 
@@ -254,34 +317,38 @@ fn parsePdf(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pars
     const prefix = "file://";
     if (prefix.len + path_slice.len >= uri_buf_size) {
         copyToFixed(256, &result.error_msg, "Path too long for URI buffer");
-        result.status = 1;
-        return;
+        return null;
     }
     @memcpy(uri_buf[0..prefix.len], prefix);
     @memcpy(uri_buf[prefix.len .. prefix.len + path_slice.len], path_slice);
     uri_buf[prefix.len + path_slice.len] = 0;
 
+    return c.poppler_document_new_from_file(&uri_buf, null, gerr);
+}
+
+/// Open a PDF, filling error_msg and status (2 = ParseError) on failure.
+fn openPdfChecked(input_path: [*:0]const u8, mem: ?[]const u8, result: *ParseResult) ?*c.PopplerDocument {
     var gerr: ?*c.GError = null;
-    const doc = c.poppler_document_new_from_file(&uri_buf, null, &gerr);
+    const doc = openPdf(input_path, mem, &gerr, result);
     if (doc == null) {
         if (gerr) |e| {
             const msg = std.mem.span(e.*.message);
             copyToFixed(256, &result.error_msg, msg);
             c.g_error_free(e);
-        } else {
+        } else if (result.error_msg[0] == 0) {
             copyToFixed(256, &result.error_msg, "Failed to open PDF");
         }
         result.status = 2; // ParseError
-        return;
     }
-    defer c.g_object_unref(doc);
+    return doc;
+}
 
-    const n_pages = c.poppler_document_get_n_pages(doc);
-    result.page_count = @intCast(n_pages);
+/// Page count, kind, MIME type, title and author of an open PDF.
+fn pdfMetadata(doc: *c.PopplerDocument, result: *ParseResult) void {
+    result.page_count = @intCast(c.poppler_document_get_n_pages(doc));
     result.content_kind = @intFromEnum(ContentKind.pdf);
     copyToFixed(64, &result.mime_type, "application/pdf");
 
-    // Extract title/author
     if (c.poppler_document_get_title(doc)) |t| {
         copyToFixed(256, &result.title, std.mem.span(t));
         c.g_free(t);
@@ -290,47 +357,59 @@ fn parsePdf(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pars
         copyToFixed(256, &result.author, std.mem.span(a));
         c.g_free(a);
     }
+}
 
-    // Extract text page by page, write to output file
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-
-    var total_chars: i64 = 0;
-    var total_words: i64 = 0;
-
-    var i: c_int = 0;
-    while (i < n_pages) : (i += 1) {
+/// Extract the text of pages [first, last) into the text arena, adding to
+/// result's word and char counts. Pages with a blank text layer go to
+/// `ocr` when set (STAGE_MULTI_LANG_OCR on a scanned PDF).
+/// Returns false (status 6) if the arena could not grow.
+fn extractPdfPages(
+    doc: *c.PopplerDocument,
+    first: c_int,
+    last: c_int,
+    text_out: *text_arena.TextArena,
+    ocr: ?*stages.PdfPageOcr,
+    result: *ParseResult,
+) bool {
+    var i: c_int = first;
+    while (i < last) : (i += 1) {
         const page = c.poppler_document_get_page(doc, i) orelse continue;
         defer c.g_object_unref(page);
 
-        if (c.poppler_page_get_text(page)) |text_ptr| {
-            const text = std.mem.span(text_ptr);
-            out_file.writeAll(text) catch |err| {
-                std.log.err("PDF output write failed on page {d}: {s}", .{ i, @errorName(err) });
-                copyToFixed(256, &result.error_msg, "Failed writing extracted PDF text to output file");
-                result.status = 1;
-                c.g_free(text_ptr);
-                return;
-            };
-            out_file.writeAll("\n") catch |err| {
-                std.log.err("PDF output newline write failed on page {d}: {s}", .{ i, @errorName(err) });
-                copyToFixed(256, &result.error_msg, "Failed writing extracted PDF text to output file");
-                result.status = 1;
-                c.g_free(text_ptr);
-                return;
-            };
-            total_chars += @intCast(text.len);
-            total_words += countWords(text);
-            c.g_free(text_ptr);
+        const text_ptr = c.poppler_page_get_text(page);
+        defer if (text_ptr) |t| c.g_free(t);
+        const text: []const u8 = if (text_ptr) |t| std.mem.span(t) else "";
+
+        if (ocr) |o| {
+            if (std.mem.trim(u8, text, &std.ascii.whitespace).len == 0) o.page(i);
         }
+        if (text_ptr == null) continue;
+
+        if (!text_out.append(text) or !text_out.append("\n")) {
+            std.log.err("PDF text arena grow failed on page {d}", .{i});
+            copyToFixed(256, &result.error_msg, "Out of memory buffering extracted PDF text");
+            result.status = 6; // OutOfMemory
+            return false;
+        }
+        result.char_count += @intCast(text.len);
+        result.word_count += countWords(text);
     }
+    return true;
+}
 
-    result.word_count = total_words;
-    result.char_count = total_chars;
+/// PDF: extract text + metadata via Poppler
+/// mem: mapped file bytes from ddac_conduit_map(), or null to read input_path
+/// ocr: scanned-page OCR for STAGE_MULTI_LANG_OCR, or null
+fn parsePdf(input_path: [*:0]const u8, text_out: *text_arena.TextArena, mem: ?[]const u8, ocr: ?*stages.PdfPageOcr, result: *ParseResult) void {
+    const doc = openPdfChecked(input_path, mem, result) orelse return;
+    defer c.g_object_unref(doc);
+
+    pdfMetadata(doc, result);
+
+    // Extract text page by page into the handle's text arena
+    result.word_count = 0;
+    result.char_count = 0;
+    if (!extractPdfPages(doc, 0, result.page_count, text_out, ocr, result)) return;
     result.status = 0;
 }
 
@@ -362,27 +441,35 @@ fn detectImageMime(input_path: [*:0]const u8, result: *ParseResult) void {
 }
 
 /// Try GPU OCR for an image. Returns true if GPU processed it successfully
-/// (result is populated and output file is written). Returns false if GPU
-/// processing failed or is unavailable — caller should fall back to CPU.
-fn tryGpuOcr(state: *HandleState, input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult, captured: *CapturedData) bool {
+/// (result is populated and the text is in state.text). Returns false if
+/// GPU processing failed or is unavailable — caller should fall back to CPU.
+fn tryGpuOcr(state: *HandleState, input_path: [*:0]const u8, result: *ParseResult, captured: *CapturedData) bool {
     const ocr_handle = state.gpu_ocr_handle orelse return false;
 
-    // Submit single image, immediately flush, and collect
-    const slot = gpu_ocr.ddac_gpu_ocr_submit(ocr_handle, input_path, output_path);
-    if (slot < 0) return false;
-
-    gpu_ocr.ddac_gpu_ocr_flush(ocr_handle);
-
-    const ready = gpu_ocr.ddac_gpu_ocr_results_ready(ocr_handle);
-    if (ready == 0) return false;
+    // Use the ticket submitted ahead of this parse, or submit this image
+    // alone and flush it
+    var ticket = state.gpu_ocr_ticket;
+    state.gpu_ocr_ticket = -1;
+    if (ticket < 0) {
+        ticket = gpu_ocr.ddac_gpu_ocr_submit(ocr_handle, input_path, null);
+        if (ticket < 0) return false;
+        gpu_ocr.ddac_gpu_ocr_flush(ocr_handle);
+    }
 
+    // Waits for the batch; the text is appended straight to the arena
     var ocr_result: gpu_ocr.OcrResult = std.mem.zeroes(gpu_ocr.OcrResult);
-    const rc = gpu_ocr.ddac_gpu_ocr_collect(ocr_handle, @intCast(slot), &ocr_result);
+    const rc = gpu_ocr.collectInto(ocr_handle, @intCast(ticket), &ocr_result, &state.text);
     if (rc != 0) return false;
 
     // status=3 (gpu_error) means "use CPU fallback"
     if (ocr_result.status == 3 or ocr_result.status == 1) return false;
 
+    if (state.text.oom) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering OCR text");
+        result.status = 6; // OutOfMemory
+        return true;
+    }
+
     // GPU processed successfully (status=0) or skipped (status=2)
     result.char_count = ocr_result.char_count;
     result.word_count = ocr_result.word_count;
@@ -393,14 +480,16 @@ fn tryGpuOcr(state: *HandleState, input_path: [*:0]const u8, output_path: [*:0]c
 }
 
 /// Image: OCR via Tesseract + dimensions via libvips
-/// When GPU OCR handle is attached, tries GPU path first (single-image
-/// submit → flush → collect). Falls back to CPU Tesseract on gpu_error.
-fn parseImage(input_path: [*:0]const u8, output_path: [*:0]const u8, state: *HandleState, result: *ParseResult, captured: *CapturedData) void {
+/// When GPU OCR handle is attached, tries GPU path first (the ticket
+/// submitted ahead of the parse, else single-image submit → flush →
+/// collect). Falls back to CPU Tesseract on gpu_error.
+/// mem: mapped file bytes from ddac_conduit_map(), or null to read input_path
+fn parseImage(input_path: [*:0]const u8, mem: ?[]const u8, state: *HandleState, result: *ParseResult, captured: *CapturedData) void {
     result.content_kind = @intFromEnum(ContentKind.image);
     detectImageMime(input_path, result);
 
     // Try GPU OCR first (if handle is attached)
-    if (tryGpuOcr(state, input_path, output_path, result, captured)) {
+    if (tryGpuOcr(state, input_path, result, captured)) {
         return; // GPU handled it
     }
 
@@ -411,28 +500,23 @@ fn parseImage(input_path: [*:0]const u8, output_path: [*:0]const u8, state: *Han
         return;
     };
 
-    // Set image for OCR
-    const pix = c.pixRead(input_path);
-    if (pix == null) {
+    // Set image for OCR (decode from the mapping when we have one). The
+    // handle keeps the decoded image for the image stages and frees it
+    // after the parse
+    const shared = state.image.load(input_path, mem) orelse {
         copyToFixed(256, &result.error_msg, "Cannot read image file");
         result.status = 2;
         return;
-    }
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; pix will not be used after this
-    defer c.pixDestroy(@constCast(&pix));
+    };
+    // SAFETY: shared is the PIX* that stages.SharedImage.load decoded with Leptonica, cast to *anyopaque across the two @cImport blocks
+    const pix: *c.PIX = @ptrCast(@alignCast(shared));
 
     // Check minimum dimensions — tiny images (icons, spacers) produce
     // only Tesseract warnings and no useful OCR text
     const img_w = c.pixGetWidth(pix);
     const img_h = c.pixGetHeight(pix);
     if (img_w < MIN_OCR_DIMENSION or img_h < MIN_OCR_DIMENSION) {
-        // Write an empty output file and succeed with zero words
-        const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-            copyToFixed(256, &result.error_msg, "Cannot create output file");
-            result.status = 1;
-            return;
-        };
-        out_file.close();
+        // Leave the arena empty (empty output file) and succeed with zero words
         result.page_count = 1;
         result.word_count = 0;
         result.char_count = 0;
@@ -459,19 +543,12 @@ fn parseImage(input_path: [*:0]const u8, output_path: [*:0]const u8, state: *Han
     defer c.TessDeleteText(ocr_text_ptr);
     const ocr_text = std.mem.span(ocr_text_ptr);
 
-    // Write extracted text to output
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-    out_file.writeAll(ocr_text) catch |err| {
-        std.log.err("Image OCR output write failed: {s}", .{@errorName(err)});
-        copyToFixed(256, &result.error_msg, "Failed writing OCR text to output file");
-        result.status = 1;
+    // Buffer extracted text for stages + the output sink
+    if (!state.text.append(ocr_text)) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering OCR text");
+        result.status = 6; // OutOfMemory
         return;
-    };
+    }
 
     result.char_count = @intCast(ocr_text.len);
     result.word_count = countWords(ocr_text);
@@ -491,7 +568,7 @@ fn avErrorMsg(errnum: c_int, dest: *[256]u8) void {
 }
 
 /// Audio: metadata + duration via FFmpeg (libavformat)
-fn parseAudio(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult) void {
+fn parseAudio(input_path: [*:0]const u8, text_out: *text_arena.TextArena, result: *ParseResult) void {
     result.content_kind = @intFromEnum(ContentKind.audio);
 
     var fmt_ctx: ?*c.AVFormatContext = null;
@@ -529,26 +606,16 @@ fn parseAudio(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pa
         }
     }
 
-    // Write metadata summary to output file
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-
-    var buf: [512]u8 = undefined;
-    const written = std.fmt.bufPrint(&buf, "(audio (duration {d:.2}) (title \"{s}\") (artist \"{s}\"))\n", .{
+    // Metadata summary becomes the document's extracted text
+    if (!text_out.print("(audio (duration {d:.2}) (title \"{s}\") (artist \"{s}\"))\n", .{
         result.duration_sec,
         std.mem.sliceTo(&result.title, 0),
         std.mem.sliceTo(&result.author, 0),
-    }) catch &buf;
-    out_file.writeAll(written) catch |err| {
-        std.log.err("Audio metadata output write failed: {s}", .{@errorName(err)});
-        copyToFixed(256, &result.error_msg, "Failed writing audio metadata to output file");
-        result.status = 1;
+    })) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering audio metadata");
+        result.status = 6; // OutOfMemory
         return;
-    };
+    }
 
     // MIME detection
     const path_str = std.mem.span(input_path);
@@ -566,7 +633,7 @@ fn parseAudio(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pa
 }
 
 /// Video: subtitles + metadata via FFmpeg
-fn parseVideo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult) void {
+fn parseVideo(input_path: [*:0]const u8, text_out: *text_arena.TextArena, result: *ParseResult) void {
     result.content_kind = @intFromEnum(ContentKind.video);
 
     var fmt_ctx: ?*c.AVFormatContext = null;
@@ -604,13 +671,6 @@ fn parseVideo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pa
     }
 
     // Look for subtitle streams and extract text
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-
     var sub_count: i64 = 0;
     for (0..ctx.nb_streams) |i| {
         const stream = ctx.streams[i];
@@ -619,18 +679,15 @@ fn parseVideo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pa
         }
     }
 
-    var buf: [512]u8 = undefined;
-    const written = std.fmt.bufPrint(&buf, "(video (duration {d:.2}) (subtitle-streams {d}) (title \"{s}\"))\n", .{
+    if (!text_out.print("(video (duration {d:.2}) (subtitle-streams {d}) (title \"{s}\"))\n", .{
         result.duration_sec,
         sub_count,
         std.mem.sliceTo(&result.title, 0),
-    }) catch &buf;
-    out_file.writeAll(written) catch |err| {
-        std.log.err("Video metadata output write failed: {s}", .{@errorName(err)});
-        copyToFixed(256, &result.error_msg, "Failed writing video metadata to output file");
-        result.status = 1;
+    })) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering video metadata");
+        result.status = 6; // OutOfMemory
         return;
-    };
+    }
 
     // MIME
     const path_str = std.mem.span(input_path);
@@ -646,14 +703,19 @@ fn parseVideo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pa
 }
 
 /// EPUB: structured text extraction via libxml2
-fn parseEpub(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult) void {
+/// mem: mapped file bytes from ddac_conduit_map(), or null to read input_path
+fn parseEpub(input_path: [*:0]const u8, text_out: *text_arena.TextArena, mem: ?[]const u8, result: *ParseResult) void {
     result.content_kind = @intFromEnum(ContentKind.epub);
     copyToFixed(64, &result.mime_type, "application/epub+zip");
 
     // EPUB is a ZIP — for now, parse the container.xml or content.opf
     // In a production version this would unzip and iterate XHTML files.
     // Here we use libxml2 to parse the file if it's an unzipped XHTML.
-    const doc = c.xmlReadFile(input_path, null, c.XML_PARSE_RECOVER | c.XML_PARSE_NOERROR);
+    const xml_opts = c.XML_PARSE_RECOVER | c.XML_PARSE_NOERROR;
+    const doc = if (mem) |bytes|
+        c.xmlReadMemory(bytes.ptr, @intCast(@min(bytes.len, std.math.maxInt(c_int))), input_path, null, xml_opts)
+    else
+        c.xmlReadFile(input_path, null, xml_opts);
     if (doc == null) {
         // Capture libxml2 error if available
         const xml_err = c.xmlGetLastError();
@@ -671,13 +733,6 @@ fn parseEpub(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Par
     }
     defer c.xmlFreeDoc(doc);
 
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-
     // Extract all text content from the XML tree
     const root = c.xmlDocGetRootElement(doc);
     if (root == null) {
@@ -687,7 +742,12 @@ fn parseEpub(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Par
 
     var total_chars: i64 = 0;
     var total_words: i64 = 0;
-    extractXmlText(root, out_file, &total_chars, &total_words);
+    extractXmlText(root, text_out, &total_chars, &total_words);
+    if (text_out.oom) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering EPUB text");
+        result.status = 6; // OutOfMemory
+        return;
+    }
 
     result.char_count = total_chars;
     result.word_count = total_words;
@@ -696,29 +756,30 @@ fn parseEpub(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Par
 }
 
 /// Recursively extract text from XML nodes
-fn extractXmlText(node: *c.xmlNode, file: std.fs.File, chars: *i64, words: *i64) void {
+fn extractXmlText(node: *c.xmlNode, text_out: *text_arena.TextArena, chars: *i64, words: *i64) void {
     var cur: ?*c.xmlNode = node;
     while (cur) |n| {
         if (n.type == c.XML_TEXT_NODE or n.type == c.XML_CDATA_SECTION_NODE) {
             if (n.content) |content| {
                 const text = std.mem.span(content);
-                file.writeAll(text) catch |err| {
-                    std.log.err("EPUB XML text output write failed: {s}", .{@errorName(err)});
-                    return; // Stop traversal — output file is in an inconsistent state
-                };
+                if (!text_out.append(text)) {
+                    std.log.err("EPUB XML text arena grow failed", .{});
+                    return; // Stop traversal — caller reports OutOfMemory
+                }
                 chars.* += @intCast(text.len);
                 words.* += countWords(text);
             }
         }
         if (n.children) |children| {
-            extractXmlText(children, file, chars, words);
+            extractXmlText(children, text_out, chars, words);
+            if (text_out.oom) return;
         }
         cur = n.next;
     }
 }
 
 /// Geospatial: projection + bounds via GDAL
-fn parseGeo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *ParseResult) void {
+fn parseGeo(input_path: [*:0]const u8, text_out: *text_arena.TextArena, result: *ParseResult) void {
     result.content_kind = @intFromEnum(ContentKind.geospatial);
 
     const dataset = c.GDALOpen(input_path, c.GA_ReadOnly);
@@ -750,17 +811,9 @@ fn parseGeo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pars
     const x_size = c.GDALGetRasterXSize(dataset);
     const y_size = c.GDALGetRasterYSize(dataset);
 
-    // Write metadata to output
-    const out_file = std.fs.createFileAbsoluteZ(output_path, .{}) catch {
-        copyToFixed(256, &result.error_msg, "Cannot create output file");
-        result.status = 1;
-        return;
-    };
-    defer out_file.close();
-
-    var buf: [1024]u8 = undefined;
+    // Metadata summary becomes the document's extracted text
     const proj_str = if (proj) |p| std.mem.span(p) else "unknown";
-    const written = std.fmt.bufPrint(&buf, "(geospatial\n  (raster-size {d} {d})\n  (origin {d:.6} {d:.6})\n  (pixel-size {d:.6} {d:.6})\n  (projection \"{s}\"))\n", .{
+    if (!text_out.print("(geospatial\n  (raster-size {d} {d})\n  (origin {d:.6} {d:.6})\n  (pixel-size {d:.6} {d:.6})\n  (projection \"{s}\"))\n", .{
         x_size,
         y_size,
         gt[0],
@@ -768,13 +821,11 @@ fn parseGeo(input_path: [*:0]const u8, output_path: [*:0]const u8, result: *Pars
         gt[1],
         gt[5],
         proj_str,
-    }) catch &buf;
-    out_file.writeAll(written) catch |err| {
-        std.log.err("Geospatial metadata output write failed: {s}", .{@errorName(err)});
-        copyToFixed(256, &result.error_msg, "Failed writing geospatial metadata to output file");
-        result.status = 1;
+    })) {
+        copyToFixed(256, &result.error_msg, "Out of memory buffering geospatial metadata");
+        result.status = 6; // OutOfMemory
         return;
-    };
+    }
 
     // MIME
     const path_str = std.mem.span(input_path);
@@ -819,21 +870,32 @@ fn detectKind(path: [*:0]const u8) ContentKind {
     return .unknown;
 }
 
+/// Parser for a document whose magic bytes the conduit has classified.
+/// A recognised extension wins: only it tells a GeoTIFF from a TIFF image,
+/// or an EPUB from any other ZIP container. Otherwise the magic kind is
+/// used, except ZIP magic (reported as EPUB), which without an .epub
+/// extension is not a document this library can parse.
+fn resolveKind(magic_kind: ContentKind, path: [*:0]const u8) ContentKind {
+    const ext_kind = detectKind(path);
+    if (ext_kind != .unknown) return ext_kind;
+    return if (magic_kind == .epub) .unknown else magic_kind;
+}
+
 // ============================================================================
 // Exported C API — called from Chapel
 // ============================================================================
 
-/// Initialise the library. Returns an opaque handle.
-/// Must be called once per thread/task.
-export fn ddac_init() ?*anyopaque {
-    const allocator = std.heap.c_allocator;
-
+/// Allocate a HandleState and warm its library contexts (Tesseract eng
+/// traineddata, GDAL drivers, libvips). Shared by ddac_init and the pool.
+fn createHandleState(allocator: std.mem.Allocator) ?*HandleState {
     const state = allocator.create(HandleState) catch return null;
     state.* = .{
         .allocator = allocator,
         .tess_api = null,
         .gdal_initialised = false,
         .vips_initialised = false,
+        .text = text_arena.TextArena.init(allocator),
+        .stage_arena = capnp.Arena.init(allocator),
     };
 
     // Initialise Tesseract (English)
@@ -855,16 +917,11 @@ export fn ddac_init() ?*anyopaque {
         state.vips_initialised = true;
     }
 
-    // SAFETY: state was just allocated by c_allocator.create(HandleState), which returns a well-aligned *HandleState
-    return @ptrCast(state);
+    return state;
 }
 
-/// Free all library contexts. Safe to call with null.
-export fn ddac_free(handle: ?*anyopaque) void {
-    const ptr = handle orelse return;
-    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
-    const state: *HandleState = @ptrCast(@alignCast(ptr));
-
+/// Tear down the library contexts owned by a HandleState and free it.
+fn destroyHandleState(state: *HandleState) void {
     if (state.tess_api) |tess| {
         c.TessBaseAPIEnd(tess);
         c.TessBaseAPIDelete(tess);
@@ -876,9 +933,32 @@ export fn ddac_free(handle: ?*anyopaque) void {
 
     // GDAL has no per-handle cleanup; GDALDestroyDriverManager is global
 
+    stages.mlangTessDestroy(state.mlang_tess);
+    state.image.release();
+    state.writer.deinit();
+    state.conduit.deinit();
+    state.text.deinit();
+    state.stage_arena.deinit();
     state.allocator.destroy(state);
 }
 
+/// Initialise the library. Returns an opaque handle.
+/// Must be called once per thread/task. For long-running drivers prefer
+/// ddac_pool_create + ddac_pool_acquire, which reuse warmed handles.
+export fn ddac_init() ?*anyopaque {
+    const state = createHandleState(std.heap.c_allocator) orelse return null;
+    // SAFETY: state was just allocated by c_allocator.create(HandleState), which returns a well-aligned *HandleState
+    return @ptrCast(state);
+}
+
+/// Free all library contexts. Safe to call with null.
+export fn ddac_free(handle: ?*anyopaque) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    destroyHandleState(state);
+}
+
 /// Parse a document. Detects format from extension, dispatches to the right
 /// C library, writes extracted content to output_path, returns summary.
 /// After the base parse, runs any enabled processing stages (bitmask).
@@ -894,26 +974,42 @@ export fn ddac_parse(
 ) ParseResult {
     _ = output_fmt; // format selection handled by Chapel's ShardedOutput
 
-    var result = blankResult();
+    var result: ParseResult = undefined;
+    parseInto(handle, input_path, output_path, stage_flags, &result);
+    return result;
+}
+
+/// Body of ddac_parse, writing into a caller-owned result (zeroed first).
+fn parseInto(
+    handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    output_path: ?[*:0]const u8,
+    stage_flags: u64,
+    result: *ParseResult,
+) void {
+    result.* = blankResult();
 
     const ptr = handle orelse {
         result.status = 4; // NullPointer
         copyToFixed(256, &result.error_msg, "Null handle");
-        return result;
+        return;
     };
     // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *HandleState = @ptrCast(@alignCast(ptr));
+    defer releaseGpuTicket(state);
+    defer clearBindings(state);
+    const bound = takeBindings(state);
 
     const in_path = input_path orelse {
         result.status = 3; // InvalidParam
         copyToFixed(256, &result.error_msg, "Null input path");
-        return result;
+        return;
     };
 
     const out_path = output_path orelse {
         result.status = 3;
         copyToFixed(256, &result.error_msg, "Null output path");
-        return result;
+        return;
     };
 
     // Early existence check — produce a clear FileNotFound error
@@ -929,36 +1025,204 @@ export fn ddac_parse(
         const path_len = @min(in_slice.len, remaining);
         @memcpy(result.error_msg[prefix_len .. prefix_len + path_len], in_slice[0..path_len]);
         result.error_msg[prefix_len + path_len] = 0;
-        return result;
+        return;
     };
 
     // Compute SHA-256
     _ = computeSha256(in_slice, &result.sha256);
 
+    runParse(state, in_path, out_path, stage_flags, detectKind(in_path), null, bound, result);
+}
+
+/// Parse a chunk of documents in one call, writing each result straight
+/// into the caller's array instead of returning it by value (952 bytes
+/// per document). Slot i of results_out receives exactly what
+/// ddac_parse(handle, paths[i], out_paths[i], 0, stage_flags) would have
+/// returned; a null path gives that slot status 3.
+///
+/// Returns the number of documents parsed successfully.
+export fn ddac_parse_batch(
+    handle: ?*anyopaque,
+    paths: ?[*]const ?[*:0]const u8,
+    out_paths: ?[*]const ?[*:0]const u8,
+    n: u32,
+    stage_flags: u64,
+    results_out: ?[*]ParseResult,
+) u32 {
+    const out = results_out orelse return 0;
+    var ok: u32 = 0;
+    for (out[0..n], 0..) |*result, i| {
+        const in_path = if (paths) |p| p[i] else null;
+        const out_path = if (out_paths) |p| p[i] else null;
+        parseInto(handle, in_path, out_path, stage_flags, result);
+        if (result.status == 0) ok += 1;
+    }
+    return ok;
+}
+
+/// Struct-of-arrays view of a result array (ddac_parse_columns). Each
+/// column holds n elements in result order; null columns are skipped.
+pub const ParseColumns = extern struct {
+    status: ?[*]c_int,
+    content_kind: ?[*]c_int,
+    page_count: ?[*]i32,
+    word_count: ?[*]i64,
+    char_count: ?[*]i64,
+    duration_sec: ?[*]f64,
+    parse_time_ms: ?[*]f64,
+    sha256: ?[*][65]u8,
+};
+
+comptime {
+    // Layout.idr: parseColumnsLayout
+    std.debug.assert(@sizeOf(ParseColumns) == 64);
+}
+
+/// Gather the numeric fields (and SHA-256) of n results into contiguous
+/// columns so reductions run over packed arrays rather than 952-byte
+/// strides. Typically called on the results_out of ddac_parse_batch.
+export fn ddac_parse_columns(
+    results: ?[*]const ParseResult,
+    n: u32,
+    columns: ?*const ParseColumns,
+) void {
+    const rows = (results orelse return)[0..n];
+    const cols = columns orelse return;
+    if (cols.status) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.status;
+    }
+    if (cols.content_kind) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.content_kind;
+    }
+    if (cols.page_count) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.page_count;
+    }
+    if (cols.word_count) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.word_count;
+    }
+    if (cols.char_count) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.char_count;
+    }
+    if (cols.duration_sec) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.duration_sec;
+    }
+    if (cols.parse_time_ms) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.parse_time_ms;
+    }
+    if (cols.sha256) |c| {
+        for (rows, c[0..n]) |*r, *v| v.* = r.sha256;
+    }
+}
+
+/// Dispatch to the format parser, time it, then run processing stages.
+/// Shared by ddac_parse and ddac_parse_ex; result.sha256 must already be set.
+/// bound: the per-parse bindings the entry point took off the handle.
+fn runParse(
+    state: *HandleState,
+    in_path: [*:0]const u8,
+    out_path: [*:0]const u8,
+    stage_flags: u64,
+    kind: ContentKind,
+    mem: ?[]const u8,
+    bound: Bindings,
+    result: *ParseResult,
+) void {
+    const doc_span = metrics.begin(.document);
+    defer doc_span.end();
+
+    const blob: ?container.BlobTarget = if (bound.container) |ct|
+        .{ .container = ct, .doc_idx = bound.container_doc, .sha256 = &result.sha256 }
+    else
+        null;
+    const near = bound.neardup;
+
     // Time the parse
     const start = nowMs();
 
-    // Detect content type and dispatch
+    // Parsers fill the handle's text arena rather than the output file
+    state.text.reset();
+    defer state.image.release();
+
+    // Dispatch on content type. Audio, video and geospatial go through
+    // FFmpeg/GDAL, which open by path, so they ignore the mapping.
     var captured = CapturedData{};
-    const kind = detectKind(in_path);
+    var pdf_ocr = if (kind == .pdf) pdfPageOcr(state, in_path, mem, stage_flags) else null;
+    const parse_span = metrics.begin(.parse);
     switch (kind) {
-        .pdf => parsePdf(in_path, out_path, &result),
-        .image => parseImage(in_path, out_path, state, &result, &captured),
-        .audio => parseAudio(in_path, out_path, &result),
-        .video => parseVideo(in_path, out_path, &result),
-        .epub => parseEpub(in_path, out_path, &result),
-        .geospatial => parseGeo(in_path, out_path, &result),
+        .pdf => parsePdf(in_path, &state.text, mem, if (pdf_ocr) |*o| o else null, result),
+        .image => parseImage(in_path, mem, state, result, &captured),
+        .audio => parseAudio(in_path, &state.text, result),
+        .video => parseVideo(in_path, &state.text, result),
+        .epub => parseEpub(in_path, &state.text, mem, result),
+        .geospatial => parseGeo(in_path, &state.text, result),
         .unknown => {
             result.status = 5; // UnsupportedFormat
             result.content_kind = @intFromEnum(ContentKind.unknown);
             copyToFixed(256, &result.error_msg, "Unsupported file format");
         },
     }
+    parse_span.end();
 
     result.parse_time_ms = nowMs() - start;
 
-    // Run processing stages (only if base parse succeeded and stages requested)
-    if (stage_flags != 0 and result.status == 0) {
+    if (result.status != 0) return;
+
+    const mlang: ?stages.MlangTally = if (pdf_ocr) |o| o.tally else null;
+    emitDocument(state, in_path, out_path, stage_flags, blob, captured.ocr_confidence, mlang, near, result);
+}
+
+/// Scanned-page OCR for a PDF parse when STAGE_MULTI_LANG_OCR is set, on
+/// the handle's warm multi-language model. Null if not requested or no
+/// model could be loaded.
+fn pdfPageOcr(state: *HandleState, in_path: [*:0]const u8, mem: ?[]const u8, stage_flags: u64) ?stages.PdfPageOcr {
+    if (stage_flags & stages.STAGE_MULTI_LANG_OCR == 0) return null;
+    const tess = warmMlangTess(state) orelse return null;
+    return .{ .tess = tess, .input_path = in_path, .mem = mem };
+}
+
+/// The handle's multi-language Tesseract, loaded on first use and kept
+/// for later documents. Null if no model could be loaded.
+fn warmMlangTess(state: *HandleState) ?*anyopaque {
+    if (state.mlang_tess == null) state.mlang_tess = stages.mlangTessCreate();
+    return state.mlang_tess;
+}
+
+/// The warm model for image-document OCR in the stages, or null when the
+/// document would not use it.
+fn imageMlangTess(state: *HandleState, stage_flags: u64, content_kind: c_int) ?*anyopaque {
+    if (stage_flags & stages.STAGE_MULTI_LANG_OCR == 0 or content_kind != stages.CK_IMAGE) return null;
+    return warmMlangTess(state);
+}
+
+/// Write the handle's text arena to the output and run the processing
+/// stages over it. Shared by runParse and ddac_parse_stitch.
+fn emitDocument(
+    state: *HandleState,
+    in_path: [*:0]const u8,
+    out_path: [*:0]const u8,
+    stage_flags: u64,
+    blob: ?container.BlobTarget,
+    ocr_confidence: i32,
+    mlang: ?stages.MlangTally,
+    near: ?stages.NearDupCheck,
+    result: *ParseResult,
+) void {
+    // Output sink: write the arena to output_path (or the container) on
+    // the handle's writer thread while the stages read the same bytes.
+    var sink = text_arena.WriteBehind{ .blob = blob };
+    sink.start(if (stage_flags != 0) &state.writer else null, out_path, state.text.slice());
+    defer {
+        const output_span = metrics.begin(.output);
+        const written = sink.finish();
+        output_span.end();
+        if (!written) {
+            copyToFixed(256, &result.error_msg, "Cannot write output file");
+            result.status = 1;
+        }
+    }
+
+    // Run processing stages (only if stages requested)
+    if (stage_flags != 0) {
         const stage_ctx = stages.StageContext{
             .stages = stage_flags,
             .input_path = in_path,
@@ -970,17 +1234,353 @@ export fn ddac_parse(
             .word_count = result.word_count,
             .char_count = result.char_count,
             .duration_sec = result.duration_sec,
-            .ocr_confidence = captured.ocr_confidence,
+            .ocr_confidence = ocr_confidence,
             // SAFETY: TessBaseAPI* from Tesseract C API is cast to *anyopaque for the generic StageContext; the stages module casts it back
             .tess_api = if (state.tess_api) |t| @ptrCast(t) else null,
             .ml_handle = state.ml_handle,
+            .text = state.text.slice(),
+            .blob = blob,
+            .mlang = mlang,
+            .image = &state.image,
+            .neardup = near,
+            .arena = &state.stage_arena,
+            .packed_encoding = state.stages_packed,
+            .mlang_tess = imageMlangTess(state, stage_flags, result.content_kind),
         };
-        stages.runStages(stage_ctx);
+        const stages_span = metrics.begin(.stages);
+        defer stages_span.end();
+        _ = stages.runStages(stage_ctx);
     }
+}
 
+/// Queue ddac_conduit_batch() on the handle's conduit thread and return a
+/// job handle for ddac_conduit_batch_wait(). paths and results must stay
+/// valid until then. Returns null when the batch had to run before this
+/// returned (null handle, or no thread): results are then complete.
+export fn ddac_conduit_batch_start(
+    handle: ?*anyopaque,
+    paths: [*]const ?[*:0]const u8,
+    results: [*]conduit.ConduitResult,
+    count: u32,
+) ?*anyopaque {
+    const ptr = handle orelse {
+        _ = conduit.ddac_conduit_batch(paths, results, count);
+        return null;
+    };
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    return state.conduit.start(paths, results, count);
+}
+
+/// Parse a document using metadata the conduit already computed, so the
+/// file is not re-read for hashing or re-checked for existence.
+///
+/// conduit: result of ddac_conduit_process/ddac_conduit_map with
+///          validation == 0. Its sha256 is copied into the result. The
+///          parser is chosen as resolveKind() does: a recognised extension
+///          first, then the magic-byte content_kind, except that ZIP magic
+///          (reported as EPUB) is only parsed as EPUB with an .epub
+///          extension. Null behaves exactly like ddac_parse().
+/// mapping: optional handle from ddac_conduit_map(). When set, PDF, image
+///          and EPUB parsers read from the mapped bytes instead of the
+///          filesystem, so the document comes off disk once. The mapping
+///          stays owned by the caller.
+export fn ddac_parse_ex(
+    handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    output_path: ?[*:0]const u8,
+    output_fmt: c_int,
+    stage_flags: u64,
+    conduit_result: ?*const conduit.ConduitResult,
+    mapping: ?*const anyopaque,
+) ParseResult {
+    const pre = conduit_result orelse
+        return ddac_parse(handle, input_path, output_path, output_fmt, stage_flags);
+
+    var result = blankResult();
+
+    const ptr = handle orelse {
+        result.status = 4; // NullPointer
+        copyToFixed(256, &result.error_msg, "Null handle");
+        return result;
+    };
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    defer releaseGpuTicket(state);
+    defer clearBindings(state);
+    const bound = takeBindings(state);
+
+    const in_path = input_path orelse {
+        result.status = 3; // InvalidParam
+        copyToFixed(256, &result.error_msg, "Null input path");
+        return result;
+    };
+
+    const out_path = output_path orelse {
+        result.status = 3;
+        copyToFixed(256, &result.error_msg, "Null output path");
+        return result;
+    };
+
+    if (pre.validation != 0) {
+        result.status = if (pre.validation == 1) 2 else 1; // FileNotFound / Error
+        copyToFixed(256, &result.error_msg, "Conduit validation failed");
+        return result;
+    }
+
+    // Reuse the conduit digest — no second read of the file
+    result.sha256 = pre.sha256;
+
+    const kind = resolveKind(magicKind(pre.content_kind), in_path);
+
+    const mem: ?[]const u8 = if (mapping) |m| conduit.mappedBytes(m) else null;
+
+    runParse(state, in_path, out_path, stage_flags, kind, mem, bound, &result);
     return result;
 }
 
+/// A conduit content_kind byte as a ContentKind (out of range = unknown).
+fn magicKind(content_kind: u8) ContentKind {
+    return if (content_kind <= @intFromEnum(ContentKind.unknown))
+        @enumFromInt(content_kind)
+    else
+        .unknown;
+}
+
+/// Content kind (0-6) ddac_parse_ex() parses a document as, given the
+/// conduit's magic-byte content_kind: resolveKind(), so a .geotiff with
+/// TIFF magic is geospatial, not an image. Lets the driver pick a chunk's
+/// image documents before parsing it. 6 (unknown) for a null path.
+export fn ddac_resolve_kind(content_kind: u8, path: ?[*:0]const u8) c_int {
+    const p = path orelse return @intFromEnum(ContentKind.unknown);
+    return @intFromEnum(resolveKind(magicKind(content_kind), p));
+}
+
+/// Re-extraction: run stage_flags over a document an earlier run parsed,
+/// without the base parse. The extracted text is read back from
+/// output_path and the stages are added to the existing
+/// {output_path}.stages.capnp message in place; stages it already holds
+/// keep their fields. stage_flags is normally requested & ~existing
+/// (ddac_reextract_plan on the mask stored in the L1 cache).
+///
+/// result: the document's ParseResult from the earlier run (content kind,
+///         SHA-256, counts, MIME type). Its status is set, error_msg on
+///         failure, and parse_time_ms to this call's time.
+/// stages_out: optional; receives the mask the stage message now holds.
+/// Returns result.status: 2 (FileNotFound) if there is no extracted text
+/// and 1 if the stage message could not be extended or written — parse
+/// the document in full instead. OCR confidence and a PDF's scanned-page
+/// OCR come from the base parse, so they produce nothing here.
+export fn ddac_reextract_stages(
+    handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    output_path: ?[*:0]const u8,
+    stage_flags: u64,
+    result: ?*ParseResult,
+    stages_out: ?*u64,
+) c_int {
+    const res = result orelse return 4; // NullPointer
+    const ptr = handle orelse {
+        res.status = 4;
+        copyToFixed(256, &res.error_msg, "Null handle");
+        return res.status;
+    };
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    defer releaseGpuTicket(state);
+    defer clearBindings(state);
+    // The sidecar files are extended in place, so a container binding
+    // does not apply
+    const near = takeBindings(state).neardup;
+
+    const in_path = input_path orelse {
+        res.status = 3; // InvalidParam
+        copyToFixed(256, &res.error_msg, "Null input path");
+        return res.status;
+    };
+    const out_path = output_path orelse {
+        res.status = 3;
+        copyToFixed(256, &res.error_msg, "Null output path");
+        return res.status;
+    };
+
+    const doc_span = metrics.begin(.document);
+    defer doc_span.end();
+
+    const start = nowMs();
+    state.text.reset();
+    defer state.image.release();
+
+    // The earlier run's extracted text stands in for the base parse
+    if (!state.text.appendFile(out_path)) {
+        res.status = if (state.text.oom) 6 else 2; // OutOfMemory / FileNotFound
+        copyToFixed(256, &res.error_msg, if (state.text.oom) "Out of memory reading extracted text" else "Extracted text not found");
+        return res.status;
+    }
+
+    const existing = readStageMessage(state.allocator, out_path);
+    defer if (existing) |m| state.allocator.free(m);
+
+    const stage_ctx = stages.StageContext{
+        .stages = stage_flags,
+        .input_path = in_path,
+        .output_path = out_path,
+        .content_kind = res.content_kind,
+        .sha256 = &res.sha256,
+        .mime_type = &res.mime_type,
+        .page_count = res.page_count,
+        .word_count = res.word_count,
+        .char_count = res.char_count,
+        .duration_sec = res.duration_sec,
+        .ocr_confidence = -1,
+        // SAFETY: TessBaseAPI* from Tesseract C API is cast to *anyopaque for the generic StageContext; the stages module casts it back
+        .tess_api = if (state.tess_api) |t| @ptrCast(t) else null,
+        .ml_handle = state.ml_handle,
+        .text = state.text.slice(),
+        .image = &state.image,
+        .neardup = near,
+        .existing = existing,
+        .arena = &state.stage_arena,
+        .packed_encoding = state.stages_packed,
+        .mlang_tess = imageMlangTess(state, stage_flags, res.content_kind),
+    };
+    const stages_span = metrics.begin(.stages);
+    const mask = stages.runStages(stage_ctx);
+    stages_span.end();
+
+    res.parse_time_ms = nowMs() - start;
+    if (mask == 0 and stage_flags != 0) {
+        res.status = 1;
+        copyToFixed(256, &res.error_msg, "Cannot extend stage results");
+        return res.status;
+    }
+    if (stages_out) |o| o.* = mask;
+    res.status = 0;
+    return res.status;
+}
+
+/// Read {output_path}.stages.capnp whole, or null if there is none.
+fn readStageMessage(allocator: std.mem.Allocator, out_path: [*:0]const u8) ?[]u8 {
+    var path_buf: [4096]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "{s}.stages.capnp", .{std.mem.span(out_path)}) catch return null;
+    const file = std.fs.openFileAbsoluteZ(path, .{}) catch return null;
+    defer file.close();
+    const size: usize = @intCast(file.getEndPos() catch return null);
+    const buf = allocator.alloc(u8, size) catch return null;
+    const n = file.readAll(buf) catch 0;
+    if (n != size) {
+        allocator.free(buf);
+        return null;
+    }
+    return buf;
+}
+
+/// Give back a pre-submitted GPU OCR ticket the parse did not spend
+/// (early error, or a file that turned out not to be an image).
+fn releaseGpuTicket(state: *HandleState) void {
+    if (state.gpu_ocr_ticket < 0) return;
+    if (state.gpu_ocr_handle) |h| gpu_ocr.ddac_gpu_ocr_release(h, state.gpu_ocr_ticket);
+    state.gpu_ocr_ticket = -1;
+}
+
+/// Container and near-duplicate bindings for one parse
+/// (ddac_set_container_doc, ddac_set_neardup_doc/_verdict).
+const Bindings = struct {
+    container: ?*anyopaque,
+    container_doc: u64,
+    neardup: ?stages.NearDupCheck,
+};
+
+/// The handle's per-parse bindings. Each entry point takes them before
+/// its first early return and defers clearBindings(), so a failed parse
+/// cannot leave them to the next document on the handle.
+fn takeBindings(state: *HandleState) Bindings {
+    return .{
+        .container = state.container,
+        .container_doc = state.container_doc,
+        .neardup = state.neardup,
+    };
+}
+
+fn clearBindings(state: *HandleState) void {
+    state.container = null;
+    state.neardup = null;
+}
+
+/// Hand the next ddac_parse/ddac_parse_ex on this handle a GPU OCR ticket
+/// from ddac_gpu_ocr_submit(), so the image's batch can run while the
+/// caller parses other documents. The parse collects the ticket (or
+/// releases it if unused); -1 clears it.
+export fn ddac_set_gpu_ocr_ticket(handle: ?*anyopaque, ticket: c_int) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    releaseGpuTicket(state);
+    state.gpu_ocr_ticket = ticket;
+}
+
+/// Send the next ddac_parse/ddac_parse_ex on this handle's extracted text
+/// and stage message to a results container (ddac_container_open) as
+/// manifest document doc_idx, instead of output_path and its
+/// .stages.capnp sidecar. Applies to one parse; container == null clears it.
+export fn ddac_set_container_doc(handle: ?*anyopaque, results_container: ?*anyopaque, doc_idx: u64) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    state.container = results_container;
+    state.container_doc = doc_idx;
+}
+
+/// Check the next ddac_parse/ddac_parse_ex's image against a near-duplicate
+/// index (ddac_neardup_create/open) as document doc_id, and add it, when
+/// STAGE_NEAR_DEDUP runs. Within max_hamming bits of an indexed hash the
+/// document is reported as that one's near-duplicate and its multi-language
+/// OCR and ML stages are skipped. Applies to one parse; index == null
+/// clears it.
+export fn ddac_set_neardup_doc(handle: ?*anyopaque, index: ?*anyopaque, doc_id: u64, max_hamming: u8) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    const idx_ptr = index orelse {
+        state.neardup = null;
+        return;
+    };
+    state.neardup = .{ .index = .{
+        // SAFETY: idx_ptr originates from ddac_neardup_create/open() which return a *neardup.Index via @ptrCast; alignment is guaranteed by c_allocator
+        .index = @ptrCast(@alignCast(idx_ptr)),
+        .doc_id = doc_id,
+        .max_hamming = max_hamming,
+    } };
+}
+
+/// Hand the next ddac_parse/ddac_parse_ex's image a near-duplicate verdict
+/// the caller reached before the parse (ddac_image_ahash, then
+/// ddac_neardup_check_batch on every shard ddac_neardup_shards names).
+/// STAGE_NEAR_DEDUP writes it instead of consulting an index; a matched
+/// verdict skips the multi-language OCR and ML stages. Applies to one
+/// parse; verdict == null clears it.
+export fn ddac_set_neardup_verdict(handle: ?*anyopaque, verdict: ?*const neardup.Verdict) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    state.neardup = if (verdict) |v| .{ .verdict = v.* } else null;
+}
+
+/// 8x8 average hash of an image document, as STAGE_NEAR_DEDUP computes it,
+/// into *out_hash; mapping (ddac_conduit_map, may be null) avoids a read.
+/// Lets the caller route the hash to an index shard before the parse.
+/// Returns 0, or -1 if the file cannot be decoded or is under 8x8.
+export fn ddac_image_ahash(path: ?[*:0]const u8, mapping: ?*const anyopaque, out_hash: ?*u64) i32 {
+    const p = path orelse return -1;
+    const out = out_hash orelse return -1;
+    var image = stages.SharedImage{};
+    defer image.release();
+    const mem: ?[]const u8 = if (mapping) |m| conduit.mappedBytes(m) else null;
+    _ = image.load(p, mem);
+    out.* = image.averageHash(p) orelse return -1;
+    return 0;
+}
+
 /// Attach an ML inference engine handle to a parse handle.
 /// Must be called after ddac_init(). The ML handle remains owned by the caller
 /// (Chapel) — it will NOT be freed by ddac_free().
@@ -991,6 +1591,17 @@ export fn ddac_set_ml_handle(handle: ?*anyopaque, ml_handle: ?*anyopaque) void {
     state.ml_handle = ml_handle;
 }
 
+/// Write this handle's stage messages in Cap'n Proto packed encoding
+/// (enabled != 0) or the standard framing. Packed messages are typically
+/// several times smaller, mostly zero data fields; readers of this library
+/// accept either.
+export fn ddac_set_stages_packed(handle: ?*anyopaque, enabled: c_int) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    state.stages_packed = enabled != 0;
+}
+
 /// Attach a GPU OCR coprocessor handle to a parse handle.
 /// Must be called after ddac_init(). The GPU OCR handle remains owned by the
 /// caller (Chapel) — it will NOT be freed by ddac_free().
@@ -1001,6 +1612,414 @@ export fn ddac_set_gpu_ocr_handle(handle: ?*anyopaque, ocr_handle: ?*anyopaque)
     state.gpu_ocr_handle = ocr_handle;
 }
 
+// ============================================================================
+// Page-range PDF parsing — one large PDF across several tasks
+// ============================================================================
+//
+// parsePdf walks every page inside one call, so a 3,000-page volume keeps
+// one core busy for minutes. The driver can instead split such a PDF:
+// each ddac_parse_pages() call (on its own handle, so in parallel) opens
+// its own Poppler document, extracts one page range into a part file and
+// OCRs the range's scanned pages when STAGE_MULTI_LANG_OCR is set. Then
+// ddac_parse_stitch() concatenates the parts in page order into the one
+// output, sums their counts into one result and runs the stages over the
+// whole text, exactly as ddac_parse_ex() would for the unsplit document.
+
+/// One page range of a split PDF, filled by ddac_parse_pages().
+pub const PagePart = extern struct {
+    status: c_int,
+    /// 0-based first page and one past the last, clamped to the page count
+    first: i32,
+    last: i32,
+    _pad: u32 = 0,
+    word_count: i64,
+    char_count: i64,
+    parse_time_ms: f64,
+    /// Multi-language OCR of the range's scanned pages
+    ocr: stages.MlangTally,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(PagePart) == 64);
+}
+
+/// Number of pages in a PDF, or -1 if it cannot be opened. mapping is an
+/// optional ddac_conduit_map() handle, as for ddac_parse_ex().
+export fn ddac_pdf_page_count(input_path: ?[*:0]const u8, mapping: ?*const anyopaque) i32 {
+    const in_path = input_path orelse return -1;
+    const mem: ?[]const u8 = if (mapping) |m| conduit.mappedBytes(m) else null;
+    var scratch = blankResult();
+    const doc = openPdfChecked(in_path, mem, &scratch) orelse return -1;
+    defer c.g_object_unref(doc);
+    return @intCast(c.poppler_document_get_n_pages(doc));
+}
+
+/// Extract pages [first, last) of a PDF into part_path and fill *part.
+/// stage_flags only matters for STAGE_MULTI_LANG_OCR (scanned-page OCR);
+/// the other stages run once, in ddac_parse_stitch(). Returns part.status.
+export fn ddac_parse_pages(
+    handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    part_path: ?[*:0]const u8,
+    first: i32,
+    last: i32,
+    stage_flags: u64,
+    mapping: ?*const anyopaque,
+    part: ?*PagePart,
+) c_int {
+    const out = part orelse return 3; // InvalidParam
+    out.* = std.mem.zeroes(PagePart);
+    out.first = first;
+    out.last = first;
+
+    const ptr = handle orelse {
+        out.status = 4; // NullPointer
+        return out.status;
+    };
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    const in_path = input_path orelse {
+        out.status = 3;
+        return out.status;
+    };
+    const out_path = part_path orelse {
+        out.status = 3;
+        return out.status;
+    };
+
+    const start = nowMs();
+    const mem: ?[]const u8 = if (mapping) |m| conduit.mappedBytes(m) else null;
+    state.text.reset();
+
+    var result = blankResult();
+    const doc = openPdfChecked(in_path, mem, &result) orelse {
+        std.log.err("Page range {d}-{d}: {s}", .{ first, last, std.mem.sliceTo(&result.error_msg, 0) });
+        out.status = result.status;
+        return out.status;
+    };
+    defer c.g_object_unref(doc);
+
+    const n_pages = c.poppler_document_get_n_pages(doc);
+    const lo = std.math.clamp(first, 0, n_pages);
+    const hi = std.math.clamp(last, lo, n_pages);
+    out.first = lo;
+    out.last = hi;
+
+    const parse_span = metrics.begin(.parse);
+    var pdf_ocr = pdfPageOcr(state, in_path, mem, stage_flags);
+    const extracted = extractPdfPages(doc, lo, hi, &state.text, if (pdf_ocr) |*o| o else null, &result);
+    parse_span.end();
+    if (!extracted) {
+        out.status = result.status;
+        return out.status;
+    }
+
+    var sink = text_arena.WriteBehind{};
+    sink.start(null, out_path, state.text.slice());
+    if (!sink.finish()) {
+        out.status = 1;
+        return out.status;
+    }
+
+    out.word_count = result.word_count;
+    out.char_count = result.char_count;
+    if (pdf_ocr) |o| out.ocr = o.tally;
+    out.parse_time_ms = nowMs() - start;
+    out.status = 0;
+    return 0;
+}
+
+fn removeParts(paths: []const ?[*:0]const u8) void {
+    for (paths) |p| {
+        if (p) |path| std.fs.deleteFileAbsoluteZ(path) catch {};
+    }
+}
+
+/// Join the page ranges of a split PDF into one document: the n_parts part
+/// files (ddac_parse_pages output, in page order) are concatenated into
+/// output_path, or the container bound with ddac_set_container_doc, and
+/// deleted. Counts are summed and parse_time_ms is the ranges' total.
+/// Then the stages run over the whole text, as the unsplit parse would do.
+/// conduit_result and mapping are as for ddac_parse_ex().
+/// Any failed range fails the document with that range's status, leaving
+/// a ddac_set_container_doc() binding in place for a retry.
+export fn ddac_parse_stitch(
+    handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    output_path: ?[*:0]const u8,
+    part_paths: ?[*]const ?[*:0]const u8,
+    parts: ?[*]const PagePart,
+    n_parts: u32,
+    output_fmt: c_int,
+    stage_flags: u64,
+    conduit_result: ?*const conduit.ConduitResult,
+    mapping: ?*const anyopaque,
+) ParseResult {
+    _ = output_fmt; // format selection handled by Chapel's ShardedOutput
+
+    var result = blankResult();
+
+    // Part files are removed whatever the outcome
+    defer if (part_paths) |paths| removeParts(paths[0..n_parts]);
+
+    const ptr = handle orelse {
+        result.status = 4; // NullPointer
+        copyToFixed(256, &result.error_msg, "Null handle");
+        return result;
+    };
+    // SAFETY: ptr originates from ddac_init() which stores a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+    defer releaseGpuTicket(state);
+
+    const in_path = input_path orelse {
+        result.status = 3; // InvalidParam
+        copyToFixed(256, &result.error_msg, "Null input path");
+        return result;
+    };
+    const out_path = output_path orelse {
+        result.status = 3;
+        copyToFixed(256, &result.error_msg, "Null output path");
+        return result;
+    };
+    const paths = part_paths orelse {
+        result.status = 3;
+        copyToFixed(256, &result.error_msg, "Null page-range parts");
+        return result;
+    };
+    const ranges = parts orelse {
+        result.status = 3;
+        copyToFixed(256, &result.error_msg, "Null page-range parts");
+        return result;
+    };
+
+    const doc_span = metrics.begin(.document);
+    defer doc_span.end();
+
+    if (conduit_result) |pre| {
+        result.sha256 = pre.sha256;
+    } else {
+        _ = computeSha256(std.mem.span(in_path), &result.sha256);
+    }
+
+    const mem: ?[]const u8 = if (mapping) |m| conduit.mappedBytes(m) else null;
+    const doc = openPdfChecked(in_path, mem, &result) orelse return result;
+    pdfMetadata(doc, &result);
+    c.g_object_unref(doc);
+
+    state.text.reset();
+    var mlang = stages.MlangTally{};
+    for (ranges[0..n_parts], paths[0..n_parts], 0..) |range, path, i| {
+        if (range.status != 0) {
+            result.status = range.status;
+            var msg: [256]u8 = undefined;
+            const text = std.fmt.bufPrint(&msg, "Page range {d} (pages {d}-{d}) failed", .{ i, range.first, range.last }) catch "Page range failed";
+            copyToFixed(256, &result.error_msg, text);
+            return result;
+        }
+        const p = path orelse {
+            result.status = 3;
+            copyToFixed(256, &result.error_msg, "Null page-range part path");
+            return result;
+        };
+        if (!state.text.appendFile(p)) {
+            result.status = if (state.text.oom) 6 else 1; // OutOfMemory / Error
+            copyToFixed(256, &result.error_msg, "Cannot read page-range part");
+            return result;
+        }
+        result.word_count += range.word_count;
+        result.char_count += range.char_count;
+        result.parse_time_ms += range.parse_time_ms;
+        mlang.add(range.ocr);
+    }
+    result.status = 0;
+
+    // Container binding is spent here, so a failed stitch leaves it for
+    // the caller's fallback parse of the whole document
+    const blob: ?container.BlobTarget = if (state.container) |ct|
+        .{ .container = ct, .doc_idx = state.container_doc, .sha256 = &result.sha256 }
+    else
+        null;
+    state.container = null;
+
+    const want_mlang = stage_flags & stages.STAGE_MULTI_LANG_OCR != 0;
+    emitDocument(state, in_path, out_path, stage_flags, blob, -1, if (want_mlang) mlang else null, null, &result);
+    return result;
+}
+
+// ============================================================================
+// Handle pool — warmed parse handles reused across documents
+// ============================================================================
+//
+// ddac_init costs tens of milliseconds (Tesseract loads eng.traineddata),
+// which dominates on shards of small images. The pool keeps one warmed
+// HandleState per worker task: the driver acquires once per task and
+// releases when the task ends, so initialisation is paid per task, not
+// per document. ML and GPU OCR handles are bound once for every pooled
+// handle via ddac_pool_bind.
+
+const HandlePool = struct {
+    allocator: std.mem.Allocator,
+    mutex: std.Thread.Mutex = .{},
+    /// Every handle owned by the pool (idle or checked out)
+    all: std.ArrayList(*HandleState) = .{},
+    /// Handles available for acquire (LIFO keeps caches warm)
+    idle: std.ArrayList(*HandleState) = .{},
+    /// Subsystem handles applied to every pooled handle, including ones
+    /// created later when the pool grows past its initial size
+    ml_handle: ?*anyopaque = null,
+    gpu_ocr_handle: ?*anyopaque = null,
+    /// Stage message encoding applied to every pooled handle (ddac_pool_set_stages_packed)
+    stages_packed: bool = false,
+};
+
+/// Create a pool of `size` pre-warmed parse handles. Returns an opaque
+/// pool handle or null on failure. The pool grows on demand if more than
+/// `size` handles are acquired at once.
+export fn ddac_pool_create(size: u32) ?*anyopaque {
+    const allocator = std.heap.c_allocator;
+
+    const pool = allocator.create(HandlePool) catch return null;
+    pool.* = .{ .allocator = allocator };
+
+    pool.all.ensureTotalCapacity(allocator, size) catch {
+        allocator.destroy(pool);
+        return null;
+    };
+    pool.idle.ensureTotalCapacity(allocator, size) catch {
+        pool.all.deinit(allocator);
+        allocator.destroy(pool);
+        return null;
+    };
+
+    var i: u32 = 0;
+    while (i < size) : (i += 1) {
+        const state = createHandleState(allocator) orelse break;
+        pool.all.appendAssumeCapacity(state);
+        pool.idle.appendAssumeCapacity(state);
+    }
+
+    // SAFETY: pool was just allocated by c_allocator.create(HandlePool), which returns a well-aligned *HandlePool
+    return @ptrCast(pool);
+}
+
+/// Destroy a pool and every handle it owns. All handles must have been
+/// released first. Does NOT free bound ML/GPU OCR handles. Safe with null.
+export fn ddac_pool_free(pool_handle: ?*anyopaque) void {
+    const ptr = pool_handle orelse return;
+    // SAFETY: ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(ptr));
+
+    for (pool.all.items) |state| destroyHandleState(state);
+    pool.all.deinit(pool.allocator);
+    pool.idle.deinit(pool.allocator);
+    pool.allocator.destroy(pool);
+}
+
+/// Check out a warmed parse handle. The returned handle is used exactly
+/// like one from ddac_init() but must be returned with ddac_pool_release()
+/// instead of ddac_free(). Returns null only if the pool is null or a new
+/// handle could not be allocated.
+export fn ddac_pool_acquire(pool_handle: ?*anyopaque) ?*anyopaque {
+    const ptr = pool_handle orelse return null;
+    // SAFETY: ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(ptr));
+
+    pool.mutex.lock();
+    if (pool.idle.pop()) |state| {
+        pool.mutex.unlock();
+        // SAFETY: state is a *HandleState owned by the pool; exposed to callers as an opaque parse handle
+        return @ptrCast(state);
+    }
+    const ml_h = pool.ml_handle;
+    const gpu_h = pool.gpu_ocr_handle;
+    const stages_packed = pool.stages_packed;
+    pool.mutex.unlock();
+
+    // Pool exhausted — warm a new handle outside the lock, then adopt it
+    const state = createHandleState(pool.allocator) orelse return null;
+    state.ml_handle = ml_h;
+    state.gpu_ocr_handle = gpu_h;
+    state.stages_packed = stages_packed;
+
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    pool.all.append(pool.allocator, state) catch {
+        destroyHandleState(state);
+        return null;
+    };
+    // Reserve the idle slot now so release never needs to allocate
+    pool.idle.ensureTotalCapacity(pool.allocator, pool.all.items.len) catch {
+        _ = pool.all.pop();
+        destroyHandleState(state);
+        return null;
+    };
+    // SAFETY: state is a *HandleState owned by the pool; exposed to callers as an opaque parse handle
+    return @ptrCast(state);
+}
+
+/// Return a handle obtained from ddac_pool_acquire(). Per-document
+/// Tesseract state is cleared; the loaded traineddata is kept warm.
+/// Safe with null pool or handle.
+export fn ddac_pool_release(pool_handle: ?*anyopaque, handle: ?*anyopaque) void {
+    const pool_ptr = pool_handle orelse return;
+    const ptr = handle orelse return;
+    // SAFETY: pool_ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(pool_ptr));
+    // SAFETY: ptr originates from ddac_pool_acquire() which returns a *HandleState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *HandleState = @ptrCast(@alignCast(ptr));
+
+    if (state.tess_api) |tess| c.TessBaseAPIClear(tess);
+    releaseGpuTicket(state);
+    clearBindings(state);
+
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    // Capacity for every owned handle is reserved at create/acquire time
+    pool.idle.appendAssumeCapacity(state);
+}
+
+/// Bind ML and GPU OCR subsystem handles to every handle in the pool
+/// (current and future). Either may be null. Ownership stays with the
+/// caller, as with ddac_set_ml_handle / ddac_set_gpu_ocr_handle.
+export fn ddac_pool_bind(pool_handle: ?*anyopaque, ml_handle: ?*anyopaque, gpu_ocr_handle: ?*anyopaque) void {
+    const ptr = pool_handle orelse return;
+    // SAFETY: ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(ptr));
+
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    pool.ml_handle = ml_handle;
+    pool.gpu_ocr_handle = gpu_ocr_handle;
+    for (pool.all.items) |state| {
+        state.ml_handle = ml_handle;
+        state.gpu_ocr_handle = gpu_ocr_handle;
+    }
+}
+
+/// Set the stage message encoding of every handle in the pool (current
+/// and future), as ddac_set_stages_packed does for one handle.
+export fn ddac_pool_set_stages_packed(pool_handle: ?*anyopaque, enabled: c_int) void {
+    const ptr = pool_handle orelse return;
+    // SAFETY: ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(ptr));
+
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    pool.stages_packed = enabled != 0;
+    for (pool.all.items) |state| state.stages_packed = pool.stages_packed;
+}
+
+/// Number of handles currently owned by the pool (idle + checked out).
+export fn ddac_pool_size(pool_handle: ?*anyopaque) u32 {
+    const ptr = pool_handle orelse return 0;
+    // SAFETY: ptr originates from ddac_pool_create() which stores a *HandlePool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *HandlePool = @ptrCast(@alignCast(ptr));
+
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    return @intCast(pool.all.items.len);
+}
+
 /// Return version string (null-terminated, static storage).
 export fn ddac_version() [*:0]const u8 {
     return VERSION;
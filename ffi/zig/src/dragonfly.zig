@@ -3,17 +3,26 @@
 // Docudactyl — Dragonfly / Redis RESP Client (L2 Cache)
 //
 // Minimal RESP2 client for Dragonfly (Redis-compatible) cross-locale cache.
-// Supports GET, SET (with TTL), and DEL operations on binary keys and values.
+// Supports GET, SET (with TTL), and DEL operations on binary keys and values,
+// plus batched MGET / pipelined SET so one chunk of documents costs one
+// round trip instead of one per document.
 //
 // Cache key format:  "ddac:{sha256_hex}" (65 bytes)
-// Cache value format: raw bytes of ddac_parse_result_t (952 bytes)
+// Cache value format: result_codec.zig record of ddac_parse_result_t
+//   (variable length; raw 952-byte values from older releases still read)
 //
 // Dragonfly advantages over Redis:
 //   - 25x throughput on same hardware
 //   - Multi-threaded (no single-thread bottleneck)
 //   - Compatible with RESP2 protocol
+//
+// Connections are pooled per locale (ddac_dragonfly_pool_*): each task
+// leases its own socket for the duration of a batch, so tasks do not
+// queue behind one shared TCP stream.
 
 const std = @import("std");
+const metrics = @import("metrics.zig");
+const result_codec = @import("result_codec.zig");
 
 // ============================================================================
 // RESP2 Wire Protocol
@@ -30,9 +39,25 @@ const RESP_NULL_BULK = "$-1\r\n";
 // Dragonfly Client
 // ============================================================================
 
+/// Prefix of every cache key: "ddac:{sha256_hex}".
+const KEY_PREFIX = "ddac:";
+const KEY_LEN = KEY_PREFIX.len + 64;
+
+/// Largest value a lookup accepts: a record or a legacy raw result.
+const MAX_VALUE = @max(result_codec.MAX_RECORD, result_codec.ROW_SIZE);
+
 pub const DragonflyClient = struct {
     stream: std.net.Stream,
     recv_buf: [4096]u8,
+    /// Unconsumed reply bytes are recv_buf[recv_start..recv_end]. Pipelined
+    /// replies arrive back to back, so one read may hold several of them.
+    recv_start: usize = 0,
+    recv_end: usize = 0,
+    /// Outgoing commands are encoded here and sent with a single write.
+    send_buf: std.ArrayList(u8) = .{},
+    /// Set when a reply could not be read in full. The stream is then out of
+    /// step with the protocol and the connection must not be reused.
+    broken: bool = false,
 
     /// Connect to a Dragonfly/Redis server.
     /// Returns null if connection fails.
@@ -58,123 +83,265 @@ pub const DragonflyClient = struct {
 
     /// Close the connection.
     pub fn close(self: *DragonflyClient) void {
+        self.send_buf.deinit(std.heap.c_allocator);
         self.stream.close();
     }
 
-    /// GET a binary value by key.
-    /// Returns the value bytes (pointing into recv_buf — valid until next call), or null.
-    pub fn get(self: *DragonflyClient, key: []const u8) ?[]const u8 {
-        // Send: *2\r\n$3\r\nGET\r\n${key.len}\r\n{key}\r\n
-        self.sendCommand(&[_][]const u8{ "GET", key }) catch return null;
-        return self.readBulkReply() catch null;
+    /// GET a cached result by key and expand it into `dst` (ROW_SIZE bytes).
+    /// Returns true only if the key exists and holds a decodable result.
+    pub fn getInto(self: *DragonflyClient, key: []const u8, dst: []u8) bool {
+        self.sendCommand(&[_][]const u8{ "GET", key }) catch return self.fail(false);
+        return self.readResultInto(dst) catch self.fail(false);
     }
 
     /// SET a binary key-value pair with optional TTL in seconds.
     /// Returns true on success.
     pub fn set(self: *DragonflyClient, key: []const u8, value: []const u8, ttl_secs: u32) bool {
-        if (ttl_secs > 0) {
-            var ttl_buf: [16]u8 = undefined;
-            const ttl_str = std.fmt.bufPrint(&ttl_buf, "{d}", .{ttl_secs}) catch return false;
-            self.sendCommand(&[_][]const u8{ "SET", key, value, "EX", ttl_str }) catch return false;
-        } else {
-            self.sendCommand(&[_][]const u8{ "SET", key, value }) catch return false;
-        }
-        return self.readSimpleReply() catch false;
+        self.send_buf.clearRetainingCapacity();
+        self.appendSet(key, value, ttl_secs) catch return self.fail(false);
+        self.flush() catch return self.fail(false);
+        return self.readSimpleReply() catch self.fail(false);
     }
 
     /// DEL a key. Returns true if the key was deleted.
     pub fn del(self: *DragonflyClient, key: []const u8) bool {
-        self.sendCommand(&[_][]const u8{ "DEL", key }) catch return false;
-        const n = self.readIntegerReply() catch return false;
+        self.sendCommand(&[_][]const u8{ "DEL", key }) catch return self.fail(false);
+        const n = self.readIntegerReply() catch return self.fail(false);
         return n > 0;
     }
 
     /// PING — returns true if server responds with PONG.
     pub fn ping(self: *DragonflyClient) bool {
-        self.sendCommand(&[_][]const u8{"PING"}) catch return false;
-        // Expect +PONG\r\n
-        const n = self.stream.read(&self.recv_buf) catch return false;
-        if (n >= 7 and std.mem.startsWith(u8, self.recv_buf[0..n], "+PONG\r\n")) return true;
-        return false;
+        self.sendCommand(&[_][]const u8{"PING"}) catch return self.fail(false);
+        const line = self.readLine() catch return self.fail(false);
+        return std.mem.eql(u8, line, "+PONG");
+    }
+
+    /// MGET `keys` in one round trip. Each decodable result is expanded to
+    /// values_out[slot[k] * value_size ..] and its slot bit set in
+    /// hit_bitmap. Returns the number of hits.
+    pub fn mgetInto(
+        self: *DragonflyClient,
+        keys: []const []const u8,
+        slots: []const u32,
+        values_out: [*]u8,
+        value_size: usize,
+        hit_bitmap: [*]u8,
+    ) u32 {
+        if (keys.len == 0) return 0;
+        return self.mgetIntoInner(keys, slots, values_out, value_size, hit_bitmap) catch self.fail(@as(u32, 0));
+    }
+
+    fn mgetIntoInner(
+        self: *DragonflyClient,
+        keys: []const []const u8,
+        slots: []const u32,
+        values_out: [*]u8,
+        value_size: usize,
+        hit_bitmap: [*]u8,
+    ) !u32 {
+        self.send_buf.clearRetainingCapacity();
+        try self.appendArrayHeader(keys.len + 1);
+        try self.appendBulk("MGET");
+        for (keys) |k| try self.appendBulk(k);
+        try self.flush();
+
+        const header = try self.readLine();
+        if (header.len == 0) return error.UnexpectedReply;
+        // -ERR ...: the server refused the command but the stream is intact
+        if (header[0] == RESP_ERROR) return 0;
+        if (header[0] != RESP_ARRAY) return error.UnexpectedReply;
+        const count = std.fmt.parseInt(usize, header[1..], 10) catch return error.UnexpectedReply;
+        if (count != keys.len) return error.UnexpectedReply;
+
+        var hits: u32 = 0;
+        for (slots) |slot| {
+            const dst = values_out[@as(usize, slot) * value_size ..][0..value_size];
+            if (try self.readResultInto(dst)) {
+                hit_bitmap[slot / 8] |= @as(u8, 1) << @intCast(slot % 8);
+                hits += 1;
+            }
+        }
+        return hits;
+    }
+
+    /// Pipeline one SET per key (all sent in one write), then collect the
+    /// replies. Returns the number of SETs the server acknowledged.
+    pub fn setMany(
+        self: *DragonflyClient,
+        keys: []const []const u8,
+        values: []const []const u8,
+        ttl_secs: u32,
+    ) u32 {
+        if (keys.len == 0) return 0;
+        return self.setManyInner(keys, values, ttl_secs) catch self.fail(@as(u32, 0));
+    }
+
+    fn setManyInner(
+        self: *DragonflyClient,
+        keys: []const []const u8,
+        values: []const []const u8,
+        ttl_secs: u32,
+    ) !u32 {
+        self.send_buf.clearRetainingCapacity();
+        for (keys, values) |k, v| try self.appendSet(k, v, ttl_secs);
+        try self.flush();
+
+        var stored: u32 = 0;
+        for (keys) |_| {
+            if (try self.readSimpleReply()) stored += 1;
+        }
+        return stored;
+    }
+
+    /// Mark the connection unusable and return `val`.
+    fn fail(self: *DragonflyClient, val: anytype) @TypeOf(val) {
+        self.broken = true;
+        return val;
     }
 
     // ── Internal: RESP2 encoding ──────────────────────────────────────
 
     fn sendCommand(self: *DragonflyClient, args: []const []const u8) !void {
-        // Send array header: *{argc}\r\n
-        var header_buf: [32]u8 = undefined;
-        const header = try std.fmt.bufPrint(&header_buf, "*{d}\r\n", .{args.len});
-        try self.stream.writeAll(header);
-
-        // Send each argument as bulk string: ${len}\r\n{data}\r\n
-        for (args) |arg| {
-            var len_buf: [32]u8 = undefined;
-            const len_str = try std.fmt.bufPrint(&len_buf, "${d}\r\n", .{arg.len});
-            try self.stream.writeAll(len_str);
-            try self.stream.writeAll(arg);
-            try self.stream.writeAll("\r\n");
+        self.send_buf.clearRetainingCapacity();
+        try self.appendCommand(args);
+        try self.flush();
+    }
+
+    fn appendCommand(self: *DragonflyClient, args: []const []const u8) !void {
+        try self.appendArrayHeader(args.len);
+        for (args) |arg| try self.appendBulk(arg);
+    }
+
+    fn appendSet(self: *DragonflyClient, key: []const u8, value: []const u8, ttl_secs: u32) !void {
+        if (ttl_secs > 0) {
+            var ttl_buf: [16]u8 = undefined;
+            const ttl_str = try std.fmt.bufPrint(&ttl_buf, "{d}", .{ttl_secs});
+            try self.appendCommand(&[_][]const u8{ "SET", key, value, "EX", ttl_str });
+        } else {
+            try self.appendCommand(&[_][]const u8{ "SET", key, value });
         }
     }
 
-    fn readBulkReply(self: *DragonflyClient) !?[]const u8 {
-        // Read response into recv_buf
-        const n = try self.stream.read(&self.recv_buf);
-        if (n == 0) return error.ConnectionClosed;
+    /// Array header: *{argc}\r\n
+    fn appendArrayHeader(self: *DragonflyClient, argc: usize) !void {
+        try self.send_buf.print(std.heap.c_allocator, "*{d}\r\n", .{argc});
+    }
 
-        const resp = self.recv_buf[0..n];
+    /// Bulk string: ${len}\r\n{data}\r\n
+    fn appendBulk(self: *DragonflyClient, arg: []const u8) !void {
+        try self.send_buf.print(std.heap.c_allocator, "${d}\r\n", .{arg.len});
+        try self.send_buf.appendSlice(std.heap.c_allocator, arg);
+        try self.send_buf.appendSlice(std.heap.c_allocator, "\r\n");
+    }
 
-        // Null bulk string: $-1\r\n
-        if (n >= 5 and resp[0] == '$' and resp[1] == '-' and resp[2] == '1') return null;
+    fn flush(self: *DragonflyClient) !void {
+        try self.stream.writeAll(self.send_buf.items);
+    }
+
+    // ── Internal: buffered RESP2 decoding ─────────────────────────────
 
-        // Bulk string: ${len}\r\n{data}\r\n
-        if (resp[0] != '$') return null;
+    /// Read more bytes from the socket, compacting the buffer first.
+    fn fill(self: *DragonflyClient) !void {
+        if (self.recv_start > 0) {
+            const pending = self.recv_end - self.recv_start;
+            std.mem.copyForwards(u8, self.recv_buf[0..pending], self.recv_buf[self.recv_start..self.recv_end]);
+            self.recv_start = 0;
+            self.recv_end = pending;
+        }
+        if (self.recv_end == self.recv_buf.len) return error.ReplyTooLong;
+        const n = try self.stream.read(self.recv_buf[self.recv_end..]);
+        if (n == 0) return error.ConnectionClosed;
+        self.recv_end += n;
+    }
 
-        // Parse length
-        var i: usize = 1;
-        var len: usize = 0;
-        while (i < n and resp[i] != '\r') : (i += 1) {
-            if (resp[i] < '0' or resp[i] > '9') return null;
-            len = len * 10 + (resp[i] - '0');
+    /// Next CRLF-terminated line without the CRLF. Valid until the next read.
+    fn readLine(self: *DragonflyClient) ![]const u8 {
+        var scanned: usize = 0;
+        while (true) {
+            const pending = self.recv_buf[self.recv_start..self.recv_end];
+            if (std.mem.indexOfPos(u8, pending, scanned, "\r\n")) |pos| {
+                self.recv_start += pos + 2;
+                return pending[0..pos];
+            }
+            scanned = pending.len -| 1;
+            try self.fill();
         }
-        i += 2; // skip \r\n
+    }
 
-        // Data may span multiple reads for large values
-        if (i + len <= n) {
-            return resp[i .. i + len];
+    /// Consume exactly dst.len payload bytes, buffered bytes first.
+    fn readExact(self: *DragonflyClient, dst: []u8) !void {
+        var copied: usize = 0;
+        while (copied < dst.len) {
+            if (self.recv_start == self.recv_end) try self.fill();
+            const take = @min(dst.len - copied, self.recv_end - self.recv_start);
+            @memcpy(dst[copied..][0..take], self.recv_buf[self.recv_start..][0..take]);
+            self.recv_start += take;
+            copied += take;
         }
+    }
 
-        // Need more data — for our use case (952 bytes), this shouldn't happen
-        // with a 4KB buffer, but handle gracefully
-        return null;
+    /// Consume and drop n payload bytes.
+    fn discard(self: *DragonflyClient, n: usize) !void {
+        var left = n;
+        while (left > 0) {
+            if (self.recv_start == self.recv_end) try self.fill();
+            const take = @min(left, self.recv_end - self.recv_start);
+            self.recv_start += take;
+            left -= take;
+        }
+    }
+
+    /// Read one bulk reply and expand the result it holds into dst. Returns
+    /// false for a nil reply ($-1) or a value that is not a result (the
+    /// value is skipped and dst is left untouched).
+    fn readResultInto(self: *DragonflyClient, dst: []u8) !bool {
+        const line = try self.readLine();
+        if (line.len < 2) return error.UnexpectedReply;
+        if (line[0] == RESP_ERROR) return false;
+        if (line[0] != RESP_BULK_STRING) return error.UnexpectedReply;
+
+        // Null bulk string: $-1\r\n
+        if (line[1] == '-') return false;
+
+        const len = std.fmt.parseInt(usize, line[1..], 10) catch return error.UnexpectedReply;
+        if (len > MAX_VALUE) {
+            try self.discard(len + 2);
+            return false;
+        }
+        var value: [MAX_VALUE]u8 = undefined;
+        try self.readExact(value[0..len]);
+        try self.discard(2); // trailing \r\n
+        return result_codec.decodeValue(value[0..len], dst) != null;
     }
 
     fn readSimpleReply(self: *DragonflyClient) !bool {
-        const n = try self.stream.read(&self.recv_buf);
-        if (n == 0) return error.ConnectionClosed;
+        const line = try self.readLine();
         // +OK\r\n
-        return n >= 5 and self.recv_buf[0] == RESP_SIMPLE_STRING;
+        return line.len > 0 and line[0] == RESP_SIMPLE_STRING;
     }
 
     fn readIntegerReply(self: *DragonflyClient) !i64 {
-        const n = try self.stream.read(&self.recv_buf);
-        if (n == 0) return error.ConnectionClosed;
-        if (self.recv_buf[0] != RESP_INTEGER) return 0;
-
-        var i: usize = 1;
-        var negative = false;
-        if (i < n and self.recv_buf[i] == '-') {
-            negative = true;
-            i += 1;
-        }
-        var val: i64 = 0;
-        while (i < n and self.recv_buf[i] != '\r') : (i += 1) {
-            if (self.recv_buf[i] < '0' or self.recv_buf[i] > '9') break;
-            val = val * 10 + @as(i64, self.recv_buf[i] - '0');
-        }
-        return if (negative) -val else val;
+        const line = try self.readLine();
+        if (line.len < 2 or line[0] != RESP_INTEGER) return 0;
+        return std.fmt.parseInt(i64, line[1..], 10) catch 0;
     }
 };
 
+/// Build the cache key for a SHA-256 hex digest into `buf`.
+/// Returns null unless the digest is exactly 64 characters.
+fn cacheKey(buf: *[KEY_LEN]u8, sha256: [*:0]const u8) ?[]const u8 {
+    const sha = std.mem.span(sha256);
+    if (sha.len != 64) return null;
+    @memcpy(buf[0..KEY_PREFIX.len], KEY_PREFIX);
+    @memcpy(buf[KEY_PREFIX.len..], sha);
+    return buf;
+}
+
+inline fn bitIsSet(bits: [*]const u8, i: usize) bool {
+    return (bits[i / 8] >> @intCast(i % 8)) & 1 == 1;
+}
+
 // ============================================================================
 // C-ABI exports for Chapel FFI
 // ============================================================================
@@ -184,35 +351,47 @@ const DfHandle = struct {
     client: DragonflyClient,
 };
 
-/// Connect to a Dragonfly/Redis server.
-/// host: null-terminated "host:port" string (e.g., "localhost:6379")
-/// Returns opaque handle, or null on failure.
-export fn ddac_dragonfly_connect(host_port: [*:0]const u8) ?*anyopaque {
-    const hp = std.mem.span(host_port);
-
-    // Parse "host:port"
-    var colon_pos: ?usize = null;
-    for (hp, 0..) |ch, idx| {
-        if (ch == ':') colon_pos = idx;
-    }
-
+/// Split "host:port" (port defaults to 6379).
+fn parseHostPort(hp: []const u8) struct { host: []const u8, port: u16 } {
+    const colon_pos = std.mem.lastIndexOfScalar(u8, hp, ':');
     const host = if (colon_pos) |cp| hp[0..cp] else hp;
-    const port: u16 = if (colon_pos) |cp| blk: {
-        const port_str = hp[cp + 1 ..];
-        break :blk std.fmt.parseInt(u16, port_str, 10) catch 6379;
-    } else 6379;
+    const port: u16 = if (colon_pos) |cp|
+        std.fmt.parseInt(u16, hp[cp + 1 ..], 10) catch 6379
+    else
+        6379;
+    return .{ .host = host, .port = port };
+}
 
+/// Connect and PING. Returns null if the server is unreachable or silent.
+fn openHandle(host: []const u8, port: u16) ?*DfHandle {
     const client = DragonflyClient.connect(host, port) orelse return null;
 
     // Verify connection
-    var handle = std.heap.c_allocator.create(DfHandle) catch return null;
+    var handle = std.heap.c_allocator.create(DfHandle) catch {
+        var c = client;
+        c.close();
+        return null;
+    };
     handle.client = client;
 
     if (!handle.client.ping()) {
-        handle.client.close();
-        std.heap.c_allocator.destroy(handle);
+        closeHandle(handle);
         return null;
     }
+    return handle;
+}
+
+fn closeHandle(df: *DfHandle) void {
+    df.client.close();
+    std.heap.c_allocator.destroy(df);
+}
+
+/// Connect to a Dragonfly/Redis server.
+/// host: null-terminated "host:port" string (e.g., "localhost:6379")
+/// Returns opaque handle, or null on failure.
+export fn ddac_dragonfly_connect(host_port: [*:0]const u8) ?*anyopaque {
+    const hp = parseHostPort(std.mem.span(host_port));
+    const handle = openHandle(hp.host, hp.port) orelse return null;
 
     // SAFETY: handle was just allocated by c_allocator.create(DfHandle), which returns a well-aligned *DfHandle
     return @ptrCast(handle);
@@ -223,8 +402,7 @@ export fn ddac_dragonfly_close(handle: ?*anyopaque) void {
     if (handle) |h| {
         // SAFETY: h originates from ddac_dragonfly_connect() which stores a *DfHandle via @ptrCast; alignment is guaranteed by c_allocator
         const df: *DfHandle = @ptrCast(@alignCast(h));
-        df.client.close();
-        std.heap.c_allocator.destroy(df);
+        closeHandle(df);
     }
 }
 
@@ -238,26 +416,18 @@ export fn ddac_dragonfly_lookup(
     result_out: [*]u8,
     result_size: usize,
 ) c_int {
+    const span = metrics.begin(.cache_l2);
+    defer span.end();
     // SAFETY: handle originates from ddac_dragonfly_connect() which stores a *DfHandle via @ptrCast; alignment is guaranteed by c_allocator
     const df: *DfHandle = @ptrCast(@alignCast(handle));
-    const sha = std.mem.span(sha256);
-
-    // Build cache key: "ddac:{sha256}"
-    var key_buf: [72]u8 = undefined; // "ddac:" + 64 hex + null
-    const prefix = "ddac:";
-    @memcpy(key_buf[0..prefix.len], prefix);
-    const key_len = @min(sha.len, 64);
-    @memcpy(key_buf[prefix.len .. prefix.len + key_len], sha[0..key_len]);
 
-    const value = df.client.get(key_buf[0 .. prefix.len + key_len]) orelse return 0;
+    var key_buf: [KEY_LEN]u8 = undefined;
+    const key = cacheKey(&key_buf, sha256) orelse return 0;
 
-    if (value.len != result_size) return 0;
-
-    @memcpy(result_out[0..result_size], value);
-    return 1;
+    return if (df.client.getInto(key, result_out[0..result_size])) 1 else 0;
 }
 
-/// Store a parse result in the Dragonfly cache.
+/// Store a parse result in the Dragonfly cache (as a compact record).
 /// sha256: 64-char hex string (null-terminated)
 /// result: pointer to ddac_parse_result_t (952 bytes)
 /// ttl_secs: time-to-live in seconds (0 = no expiry)
@@ -270,16 +440,14 @@ export fn ddac_dragonfly_store(
 ) void {
     // SAFETY: handle originates from ddac_dragonfly_connect() which stores a *DfHandle via @ptrCast; alignment is guaranteed by c_allocator
     const df: *DfHandle = @ptrCast(@alignCast(handle));
-    const sha = std.mem.span(sha256);
 
-    // Build cache key
-    var key_buf: [72]u8 = undefined;
-    const prefix = "ddac:";
-    @memcpy(key_buf[0..prefix.len], prefix);
-    const key_len = @min(sha.len, 64);
-    @memcpy(key_buf[prefix.len .. prefix.len + key_len], sha[0..key_len]);
+    var key_buf: [KEY_LEN]u8 = undefined;
+    const key = cacheKey(&key_buf, sha256) orelse return;
+    if (result_size != result_codec.ROW_SIZE) return;
 
-    _ = df.client.set(key_buf[0 .. prefix.len + key_len], result[0..result_size], ttl_secs);
+    var record: [result_codec.MAX_RECORD]u8 = undefined;
+    const len = result_codec.encode(result[0..result_codec.ROW_SIZE], &record);
+    _ = df.client.set(key, record[0..len], ttl_secs);
 }
 
 /// Get the number of ddac keys in the cache (approximate).
@@ -287,7 +455,235 @@ export fn ddac_dragonfly_store(
 export fn ddac_dragonfly_count(handle: *anyopaque) u64 {
     // SAFETY: handle originates from ddac_dragonfly_connect() which stores a *DfHandle via @ptrCast; alignment is guaranteed by c_allocator
     const df: *DfHandle = @ptrCast(@alignCast(handle));
-    df.client.sendCommand(&[_][]const u8{"DBSIZE"}) catch return 0;
-    const n = df.client.readIntegerReply() catch return 0;
+    return clientCount(&df.client);
+}
+
+fn clientCount(client: *DragonflyClient) u64 {
+    client.sendCommand(&[_][]const u8{"DBSIZE"}) catch return client.fail(@as(u64, 0));
+    const n = client.readIntegerReply() catch return client.fail(@as(u64, 0));
     return if (n >= 0) @intCast(n) else 0;
 }
+
+// ============================================================================
+// Connection pool (one per locale, sized to the task count)
+// ============================================================================
+
+/// Connections to one server, at most `max` open at once. A batch call
+/// leases a connection for its duration; when every connection is busy a
+/// new one is opened up to the cap, after which callers wait for a
+/// release. Connections left broken by a failed read are dropped on
+/// release, freeing their slot.
+const DfPool = struct {
+    mutex: std.Thread.Mutex = .{},
+    /// Signalled when a connection is returned or a slot frees up
+    cond: std.Thread.Condition = .{},
+    idle: std.ArrayList(*DfHandle) = .{},
+    /// Connections open, leased plus idle (≤ max)
+    open: u32 = 0,
+    max: u32,
+    host_port: []u8,
+
+    fn acquire(self: *DfPool) ?*DfHandle {
+        self.mutex.lock();
+        while (true) {
+            if (self.idle.pop()) |d| {
+                self.mutex.unlock();
+                return d;
+            }
+            if (self.open < self.max) break;
+            self.cond.wait(&self.mutex);
+        }
+        // A free slot (pool not yet full, or drained by broken
+        // connections): reserve it and open outside the lock
+        self.open += 1;
+        self.mutex.unlock();
+
+        const hp = parseHostPort(self.host_port);
+        if (openHandle(hp.host, hp.port)) |df| return df;
+        self.dropSlot();
+        return null;
+    }
+
+    fn release(self: *DfPool, df: *DfHandle) void {
+        if (df.client.broken) {
+            closeHandle(df);
+            self.dropSlot();
+            return;
+        }
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        // idle has capacity for max entries, reserved at creation
+        self.idle.appendAssumeCapacity(df);
+        self.cond.signal();
+    }
+
+    fn dropSlot(self: *DfPool) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.open -= 1;
+        self.cond.signal();
+    }
+};
+
+/// Create a connection pool of at most `size` connections (0 = 1), all
+/// opened up front; the task count is the natural size. Returns null if
+/// the first connection fails; later failures only leave slots empty,
+/// which are retried lazily on demand.
+export fn ddac_dragonfly_pool_create(host_port: [*:0]const u8, size: u32) ?*anyopaque {
+    const allocator = std.heap.c_allocator;
+    const target = @max(size, 1);
+    const hp_str = allocator.dupe(u8, std.mem.span(host_port)) catch return null;
+
+    const pool = allocator.create(DfPool) catch {
+        allocator.free(hp_str);
+        return null;
+    };
+    pool.* = .{ .max = target, .host_port = hp_str };
+
+    const hp = parseHostPort(hp_str);
+    pool.idle.ensureTotalCapacity(allocator, target) catch {
+        ddac_dragonfly_pool_free(pool);
+        return null;
+    };
+    var i: u32 = 0;
+    while (i < target) : (i += 1) {
+        const df = openHandle(hp.host, hp.port) orelse break;
+        pool.idle.appendAssumeCapacity(df);
+        pool.open += 1;
+    }
+    if (pool.open == 0) {
+        ddac_dragonfly_pool_free(pool);
+        return null;
+    }
+
+    // SAFETY: pool was just allocated by c_allocator.create(DfPool), which returns a well-aligned *DfPool
+    return @ptrCast(pool);
+}
+
+/// Close every pooled connection and free the pool.
+/// All batch calls on the pool must have returned.
+export fn ddac_dragonfly_pool_free(pool_ptr: ?*anyopaque) void {
+    const p = pool_ptr orelse return;
+    // SAFETY: p originates from ddac_dragonfly_pool_create() which stores a *DfPool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *DfPool = @ptrCast(@alignCast(p));
+    for (pool.idle.items) |df| closeHandle(df);
+    pool.idle.deinit(std.heap.c_allocator);
+    std.heap.c_allocator.free(pool.host_port);
+    std.heap.c_allocator.destroy(pool);
+}
+
+/// Number of connections the pool has open, leased plus idle (at most
+/// the size it was created with).
+export fn ddac_dragonfly_pool_size(pool_ptr: ?*anyopaque) u32 {
+    const p = pool_ptr orelse return 0;
+    // SAFETY: p originates from ddac_dragonfly_pool_create() which stores a *DfPool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *DfPool = @ptrCast(@alignCast(p));
+    pool.mutex.lock();
+    defer pool.mutex.unlock();
+    return pool.open;
+}
+
+/// DBSIZE over a pooled connection.
+export fn ddac_dragonfly_pool_count(pool_ptr: ?*anyopaque) u64 {
+    const p = pool_ptr orelse return 0;
+    // SAFETY: p originates from ddac_dragonfly_pool_create() which stores a *DfPool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *DfPool = @ptrCast(@alignCast(p));
+    const df = pool.acquire() orelse return 0;
+    defer pool.release(df);
+    return clientCount(&df.client);
+}
+
+/// Look up n results by SHA-256 with a single MGET on a pooled connection.
+/// sha256s[i] may be null (or not 64 hex chars) to skip slot i.
+/// results_out: n * result_size bytes; hit slots are filled in place.
+/// hit_bitmap: ceil(n/8) bytes, zeroed here; bit i set on a hit.
+/// Returns the number of hits.
+export fn ddac_dragonfly_lookup_batch(
+    pool_ptr: ?*anyopaque,
+    sha256s: ?[*]const ?[*:0]const u8,
+    results_out: ?[*]u8,
+    result_size: usize,
+    hit_bitmap: ?[*]u8,
+    n: u32,
+) u32 {
+    const span = metrics.begin(.cache_l2);
+    defer span.end();
+    const bits = hit_bitmap orelse return 0;
+    @memset(bits[0 .. (@as(usize, n) + 7) / 8], 0);
+    const p = pool_ptr orelse return 0;
+    const shas = sha256s orelse return 0;
+    const out = results_out orelse return 0;
+    if (n == 0) return 0;
+    // SAFETY: p originates from ddac_dragonfly_pool_create() which stores a *DfPool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *DfPool = @ptrCast(@alignCast(p));
+
+    const allocator = std.heap.c_allocator;
+    const key_store = allocator.alloc([KEY_LEN]u8, n) catch return 0;
+    defer allocator.free(key_store);
+    const keys = allocator.alloc([]const u8, n) catch return 0;
+    defer allocator.free(keys);
+    const slots = allocator.alloc(u32, n) catch return 0;
+    defer allocator.free(slots);
+
+    var k: usize = 0;
+    for (0..n) |i| {
+        const sha = shas[i] orelse continue;
+        keys[k] = cacheKey(&key_store[k], sha) orelse continue;
+        slots[k] = @intCast(i);
+        k += 1;
+    }
+    if (k == 0) return 0;
+
+    const df = pool.acquire() orelse return 0;
+    defer pool.release(df);
+    return df.client.mgetInto(keys[0..k], slots[0..k], out, result_size, bits);
+}
+
+/// Store the slots selected by store_mask (bit i = store slot i) as one
+/// pipelined burst of SETs on a pooled connection.
+/// sha256s[i]: key digest for slot i; results: n * result_size bytes,
+/// each sent as a compact record. Returns the number of SETs acknowledged
+/// by the server.
+export fn ddac_dragonfly_store_batch(
+    pool_ptr: ?*anyopaque,
+    sha256s: ?[*]const ?[*:0]const u8,
+    results: ?[*]const u8,
+    result_size: usize,
+    store_mask: ?[*]const u8,
+    ttl_secs: u32,
+    n: u32,
+) u32 {
+    const p = pool_ptr orelse return 0;
+    const shas = sha256s orelse return 0;
+    const vals = results orelse return 0;
+    const mask = store_mask orelse return 0;
+    if (result_size != result_codec.ROW_SIZE) return 0;
+    // SAFETY: p originates from ddac_dragonfly_pool_create() which stores a *DfPool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *DfPool = @ptrCast(@alignCast(p));
+
+    const allocator = std.heap.c_allocator;
+    const key_store = allocator.alloc([KEY_LEN]u8, n) catch return 0;
+    defer allocator.free(key_store);
+    const keys = allocator.alloc([]const u8, n) catch return 0;
+    defer allocator.free(keys);
+    const values = allocator.alloc([]const u8, n) catch return 0;
+    defer allocator.free(values);
+    const records = allocator.alloc([result_codec.MAX_RECORD]u8, n) catch return 0;
+    defer allocator.free(records);
+
+    var k: usize = 0;
+    for (0..n) |i| {
+        if (!bitIsSet(mask, i)) continue;
+        const sha = shas[i] orelse continue;
+        keys[k] = cacheKey(&key_store[k], sha) orelse continue;
+        const row = vals[i * result_size ..][0..result_codec.ROW_SIZE];
+        values[k] = records[k][0..result_codec.encode(row, &records[k])];
+        k += 1;
+    }
+    // Nothing to send: do not take a connection
+    if (k == 0) return 0;
+
+    const df = pool.acquire() orelse return 0;
+    defer pool.release(df);
+    return df.client.setMany(keys[0..k], values[0..k], ttl_secs);
+}
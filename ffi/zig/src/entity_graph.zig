@@ -12,10 +12,25 @@
 //   Per-document analysis cannot reveal that — a cross-document graph can.
 //
 // Pipeline:
-//   1. ddac_entity_graph_new()                  -> graph handle
+//   1. ddac_entity_graph_new()                  -> graph handle (per task)
 //   2. ddac_entity_graph_add_document(...)      -> repeat per doc
-//   3. ddac_entity_graph_export_graphml(...)    -> write .graphml
-//   4. ddac_entity_graph_free(handle)
+//   3. ddac_entity_graph_merge(shards, ...)     -> one frozen graph
+//   4. ddac_entity_graph_export_graphml(...)    -> write .graphml
+//   5. ddac_entity_graph_free(handle)           -> shards and merged graph
+//
+// Sharding:
+//   A graph is not thread-safe, so each task builds its own shard inside
+//   the main forall and the shards are merged once at the end. The merge
+//   runs in parallel: names are partitioned by hash, each worker interns
+//   and sums the nodes of its partition, then reduces the weights of the
+//   edges whose lower endpoint it owns. A single graph can also be frozen
+//   in place (ddac_entity_graph_freeze).
+//
+// Frozen layout:
+//   Edges are stored in compressed sparse row form (one row per node,
+//   columns sorted), and names in one arena block. Exports stream from
+//   the CSR through a fixed buffer, so output size is not bounded by an
+//   in-memory estimate.
 //
 // Entity detection (rule-based — no ML dependency):
 //   - Capitalised multi-word names: "Jeffrey Epstein", "Ghislaine Maxwell"
@@ -40,14 +55,21 @@ pub const EntityGraphStatus = enum(c_int) {
     invalid_handle = 2,
     write_error = 3,
     no_text = 4,
+    /// The graph is frozen (merged or exported) and read-only.
+    frozen = 5,
 };
 
 pub const MAX_NAME_LEN: usize = 128;
 
+/// Upper bound on merge workers.
+const MAX_MERGE_PARTS: usize = 64;
+
 /// A normalised entity (name) in the graph.
 const Node = struct {
     /// Canonicalised display name (e.g. "Jeffrey Epstein").
     name: []u8,
+    /// Hash of `name`, kept so the merge can partition without rehashing.
+    hash: u64,
     /// Total co-occurrence frequency across all documents.
     freq: u32,
     /// Number of documents mentioning this entity.
@@ -61,14 +83,64 @@ const Edge = struct {
     weight: u32,
 };
 
-/// Graph handle (opaque to C callers — cast through a pointer).
+/// Frozen adjacency in compressed sparse row form. Each undirected edge
+/// is stored once, in the row of its lower-numbered endpoint: row i holds
+/// cols[offsets[i]..offsets[i + 1]] in ascending order.
+const Csr = struct {
+    offsets: []u64,
+    cols: []u32,
+    weights: []u32,
+
+    fn init(allocator: std.mem.Allocator, node_count: usize, edge_count: usize) !Csr {
+        const offsets = try allocator.alloc(u64, node_count + 1);
+        errdefer allocator.free(offsets);
+        const cols = try allocator.alloc(u32, edge_count);
+        errdefer allocator.free(cols);
+        const weights = try allocator.alloc(u32, edge_count);
+        offsets[node_count] = edge_count;
+        return .{ .offsets = offsets, .cols = cols, .weights = weights };
+    }
+
+    fn deinit(self: *Csr, allocator: std.mem.Allocator) void {
+        allocator.free(self.offsets);
+        allocator.free(self.cols);
+        allocator.free(self.weights);
+    }
+
+    /// Fill rows [row_lo, row_lo + row_count) from edge keys sorted
+    /// ascending whose sources all lie in that range; their columns are
+    /// written from cols[edge_base].
+    fn fillRows(
+        self: *Csr,
+        row_lo: usize,
+        row_count: usize,
+        edge_base: usize,
+        keys: []const u64,
+        weights: *const std.AutoHashMap(u64, u32),
+    ) void {
+        var e: usize = 0;
+        for (row_lo..row_lo + row_count) |row| {
+            self.offsets[row] = edge_base + e;
+            while (e < keys.len and (keys[e] >> 32) == row) : (e += 1) {
+                self.cols[edge_base + e] = @truncate(keys[e]);
+                self.weights[edge_base + e] = weights.get(keys[e]).?;
+            }
+        }
+    }
+};
+
+/// Graph handle (opaque to C callers — cast through a pointer). A graph
+/// is built by one task at a time; merge shards for a corpus-wide graph.
 pub const EntityGraph = struct {
     allocator: std.mem.Allocator,
+    /// Interned names (node names and hash-map keys point here)
     arena: std.heap.ArenaAllocator,
     nodes: std.ArrayList(Node),
     name_to_idx: std.StringHashMap(u32),
     edges: std.AutoHashMap(u64, u32), // key = (u64(src) << 32) | u64(dst), value = weight
     document_count: u32,
+    /// Set once frozen; `edges` and `name_to_idx` are emptied then.
+    csr: ?Csr = null,
 
     pub fn init(allocator: std.mem.Allocator) !*EntityGraph {
         const self = try allocator.create(EntityGraph);
@@ -84,6 +156,7 @@ pub const EntityGraph = struct {
     }
 
     pub fn deinit(self: *EntityGraph) void {
+        if (self.csr) |*csr| csr.deinit(self.allocator);
         self.nodes.deinit(self.allocator);
         self.name_to_idx.deinit();
         self.edges.deinit();
@@ -101,6 +174,7 @@ pub const EntityGraph = struct {
         const idx: u32 = @intCast(self.nodes.items.len);
         try self.nodes.append(self.allocator, .{
             .name = owned,
+            .hash = nameHash(owned),
             .freq = 1,
             .doc_count = 0,
         });
@@ -120,6 +194,265 @@ pub const EntityGraph = struct {
             gop.value_ptr.* = 1;
         }
     }
+
+    pub fn edgeCount(self: *const EntityGraph) usize {
+        return if (self.csr) |csr| csr.cols.len else self.edges.count();
+    }
+
+    /// Convert the edge map to CSR and make the graph read-only.
+    /// Idempotent.
+    pub fn freeze(self: *EntityGraph) !void {
+        if (self.csr != null) return;
+
+        const keys = try self.allocator.alloc(u64, self.edges.count());
+        defer self.allocator.free(keys);
+        var it = self.edges.keyIterator();
+        var k: usize = 0;
+        while (it.next()) |key| : (k += 1) keys[k] = key.*;
+        // Keys are (src << 32) | dst, so ascending order is row-major
+        std.mem.sort(u64, keys, {}, std.sort.asc(u64));
+
+        var csr = try Csr.init(self.allocator, self.nodes.items.len, keys.len);
+        csr.fillRows(0, self.nodes.items.len, 0, keys, &self.edges);
+        self.csr = csr;
+        self.edges.clearAndFree();
+        self.name_to_idx.clearAndFree();
+    }
+
+    /// Merge shards into a new frozen graph using up to `parts` threads.
+    /// Shards must not be frozen; they are only read.
+    pub fn merge(allocator: std.mem.Allocator, shards: []const *const EntityGraph, parts: usize) !*EntityGraph {
+        for (shards) |s| if (s.csr != null) return error.ShardFrozen;
+
+        const out = try EntityGraph.init(allocator);
+        errdefer out.deinit();
+
+        var ctx = MergeContext{
+            .allocator = allocator,
+            .shards = shards,
+            .parts = &.{},
+            .remaps = try allocator.alloc([]u32, shards.len),
+            .buckets = &.{},
+        };
+        defer ctx.deinit();
+        @memset(ctx.remaps, &.{});
+        for (shards, ctx.remaps) |s, *r| r.* = try allocator.alloc(u32, s.nodes.items.len);
+
+        const n_parts = @max(1, @min(parts, MAX_MERGE_PARTS));
+        ctx.parts = try allocator.alloc(MergePart, n_parts);
+        for (ctx.parts) |*p| p.* = .{
+            .names = std.StringHashMap(u32).init(allocator),
+            .edges = std.AutoHashMap(u64, u32).init(allocator),
+        };
+        ctx.buckets = try allocator.alloc(std.ArrayList(MergeEdge), n_parts * n_parts);
+        @memset(ctx.buckets, .{});
+
+        // 1. Intern each partition's names and sum their counts
+        try ctx.run(MergeContext.internNodes);
+
+        var n: usize = 0;
+        var name_bytes: usize = 0;
+        for (ctx.parts) |*p| {
+            p.row_lo = n;
+            p.name_lo = name_bytes;
+            n += p.nodes.items.len;
+            name_bytes += p.name_bytes;
+        }
+        if (n > std.math.maxInt(u32)) return error.OutOfMemory;
+        ctx.names = try out.arena.allocator().alloc(u8, name_bytes);
+        try out.nodes.resize(allocator, n);
+        ctx.out_nodes = out.nodes.items;
+
+        // 2. Place names and nodes; make shard remaps global
+        try ctx.run(MergeContext.placeNodes);
+        // 3. Route every shard edge to the partition owning its lower end
+        try ctx.run(MergeContext.scatterEdges);
+        // 4. Sum weights per partition
+        try ctx.run(MergeContext.reduceEdges);
+
+        var m: usize = 0;
+        for (ctx.parts) |*p| {
+            p.edge_base = m;
+            m += p.keys.len;
+        }
+        ctx.csr = try Csr.init(allocator, n, m);
+        out.csr = ctx.csr;
+
+        // 5. Each partition fills its own rows
+        try ctx.run(MergeContext.fillRows);
+
+        for (shards) |s| out.document_count += s.document_count;
+        return out;
+    }
+};
+
+fn nameHash(name: []const u8) u64 {
+    return std.hash.Wyhash.hash(0, name);
+}
+
+// ============================================================================
+// Parallel Merge
+// ============================================================================
+
+/// A shard edge translated to merged node IDs.
+const MergeEdge = struct {
+    key: u64,
+    weight: u32,
+};
+
+/// One hash partition of the merged graph.
+const MergePart = struct {
+    /// Name -> partition-local ID (keys point into the shards)
+    names: std.StringHashMap(u32),
+    nodes: std.ArrayList(Node) = .{},
+    name_bytes: usize = 0,
+    /// First merged node ID and name byte of this partition
+    row_lo: usize = 0,
+    name_lo: usize = 0,
+    /// Reduced edges owned by this partition, and their sorted keys
+    edges: std.AutoHashMap(u64, u32),
+    keys: []u64 = &.{},
+    edge_base: usize = 0,
+    failed: bool = false,
+};
+
+const MergeContext = struct {
+    allocator: std.mem.Allocator,
+    shards: []const *const EntityGraph,
+    parts: []MergePart,
+    /// Per shard: shard node index -> partition-local, then merged, ID
+    remaps: [][]u32,
+    /// buckets[w * parts + p]: edges from worker w owned by partition p
+    buckets: []std.ArrayList(MergeEdge),
+    names: []u8 = &.{},
+    out_nodes: []Node = &.{},
+    csr: Csr = undefined,
+
+    fn deinit(self: *MergeContext) void {
+        for (self.remaps) |r| self.allocator.free(r);
+        self.allocator.free(self.remaps);
+        for (self.parts) |*p| {
+            p.names.deinit();
+            p.nodes.deinit(self.allocator);
+            p.edges.deinit();
+            self.allocator.free(p.keys);
+        }
+        self.allocator.free(self.parts);
+        for (self.buckets) |*b| b.deinit(self.allocator);
+        self.allocator.free(self.buckets);
+    }
+
+    /// Run `phase` once per partition, one thread each (inline if a
+    /// thread cannot be spawned), and wait for all of them.
+    fn run(self: *MergeContext, comptime phase: anytype) !void {
+        const Worker = struct {
+            fn call(ctx: *MergeContext, p: usize) void {
+                phase(ctx, p) catch {
+                    ctx.parts[p].failed = true;
+                };
+            }
+        };
+        var threads: [MAX_MERGE_PARTS]?std.Thread = @splat(null);
+        for (1..self.parts.len) |p| {
+            threads[p] = std.Thread.spawn(.{}, Worker.call, .{ self, p }) catch null;
+            if (threads[p] == null) Worker.call(self, p);
+        }
+        Worker.call(self, 0);
+        for (threads[1..self.parts.len]) |t| if (t) |thread| thread.join();
+        for (self.parts) |p| if (p.failed) return error.OutOfMemory;
+    }
+
+    fn owns(self: *const MergeContext, node: Node, p: usize) bool {
+        return node.hash % self.parts.len == p;
+    }
+
+    fn internNodes(self: *MergeContext, p: usize) !void {
+        const part = &self.parts[p];
+        for (self.shards, self.remaps) |shard, remap| {
+            for (shard.nodes.items, 0..) |node, i| {
+                if (!self.owns(node, p)) continue;
+                const gop = try part.names.getOrPut(node.name);
+                if (gop.found_existing) {
+                    const merged = &part.nodes.items[gop.value_ptr.*];
+                    merged.freq += node.freq;
+                    merged.doc_count += node.doc_count;
+                } else {
+                    gop.value_ptr.* = @intCast(part.nodes.items.len);
+                    try part.nodes.append(self.allocator, node);
+                    part.name_bytes += node.name.len;
+                }
+                remap[i] = gop.value_ptr.*;
+            }
+        }
+    }
+
+    fn placeNodes(self: *MergeContext, p: usize) !void {
+        const part = &self.parts[p];
+        var at = part.name_lo;
+        for (part.nodes.items, self.out_nodes[part.row_lo..][0..part.nodes.items.len]) |node, *out| {
+            const name = self.names[at..][0..node.name.len];
+            @memcpy(name, node.name);
+            at += name.len;
+            out.* = node;
+            out.name = name;
+        }
+        for (self.shards, self.remaps) |shard, remap| {
+            for (shard.nodes.items, remap) |node, *id| {
+                if (self.owns(node, p)) id.* += @intCast(part.row_lo);
+            }
+        }
+    }
+
+    /// Partition of a merged node ID (partitions hold contiguous ranges).
+    fn partOf(self: *const MergeContext, id: u32) usize {
+        var lo: usize = 0;
+        var hi: usize = self.parts.len;
+        while (hi - lo > 1) {
+            const mid = (lo + hi) / 2;
+            if (self.parts[mid].row_lo <= id) lo = mid else hi = mid;
+        }
+        return lo;
+    }
+
+    /// Worker w translates the edges of shards w, w + parts, ...
+    fn scatterEdges(self: *MergeContext, w: usize) !void {
+        const out = self.buckets[w * self.parts.len ..][0..self.parts.len];
+        var s = w;
+        while (s < self.shards.len) : (s += self.parts.len) {
+            const remap = self.remaps[s];
+            var it = self.shards[s].edges.iterator();
+            while (it.next()) |entry| {
+                const a = remap[@intCast(entry.key_ptr.* >> 32)];
+                const b = remap[@intCast(entry.key_ptr.* & 0xFFFFFFFF)];
+                const src = @min(a, b);
+                const dst = @max(a, b);
+                try out[self.partOf(src)].append(self.allocator, .{
+                    .key = (@as(u64, src) << 32) | @as(u64, dst),
+                    .weight = entry.value_ptr.*,
+                });
+            }
+        }
+    }
+
+    fn reduceEdges(self: *MergeContext, p: usize) !void {
+        const part = &self.parts[p];
+        for (0..self.parts.len) |w| {
+            for (self.buckets[w * self.parts.len + p].items) |e| {
+                const gop = try part.edges.getOrPut(e.key);
+                gop.value_ptr.* = if (gop.found_existing) gop.value_ptr.* + e.weight else e.weight;
+            }
+        }
+        part.keys = try self.allocator.alloc(u64, part.edges.count());
+        var it = part.edges.keyIterator();
+        var k: usize = 0;
+        while (it.next()) |key| : (k += 1) part.keys[k] = key.*;
+        std.mem.sort(u64, part.keys, {}, std.sort.asc(u64));
+    }
+
+    fn fillRows(self: *MergeContext, p: usize) !void {
+        const part = &self.parts[p];
+        self.csr.fillRows(part.row_lo, part.nodes.items.len, part.edge_base, part.keys, &part.edges);
+    }
 };
 
 // ============================================================================
@@ -265,6 +598,7 @@ export fn ddac_entity_graph_add_document(
     text_len: usize,
 ) c_int {
     const h = handle orelse return @intFromEnum(EntityGraphStatus.invalid_handle);
+    if (h.csr != null) return @intFromEnum(EntityGraphStatus.frozen);
     const text = if (text_ptr) |p| p[0..text_len] else return @intFromEnum(EntityGraphStatus.no_text);
     if (text.len == 0) return @intFromEnum(EntityGraphStatus.no_text);
 
@@ -312,70 +646,67 @@ export fn ddac_entity_graph_add_document(
     return @intFromEnum(EntityGraphStatus.ok);
 }
 
+/// Merge per-task shards into a new frozen graph, using `threads` merge
+/// workers (0 = one per CPU). Null entries are skipped. The shards are
+/// left untouched and still have to be freed. Returns null on allocation
+/// failure or if a shard is already frozen.
+export fn ddac_entity_graph_merge(
+    shards: ?[*]const ?*EntityGraph,
+    count: u32,
+    threads: u32,
+) ?*EntityGraph {
+    const allocator = std.heap.c_allocator;
+    const list = if (shards) |p| p[0..count] else &[_]?*EntityGraph{};
+
+    var present: std.ArrayList(*const EntityGraph) = .{};
+    defer present.deinit(allocator);
+    for (list) |entry| {
+        if (entry) |g| present.append(allocator, g) catch return null;
+    }
+    const parts: usize = if (threads != 0) threads else std.Thread.getCpuCount() catch 1;
+    return EntityGraph.merge(allocator, present.items, parts) catch null;
+}
+
+/// Freeze a graph into its CSR form. Further documents are rejected;
+/// exports freeze implicitly.
+export fn ddac_entity_graph_freeze(handle: ?*EntityGraph) c_int {
+    const h = handle orelse return @intFromEnum(EntityGraphStatus.invalid_handle);
+    h.freeze() catch return @intFromEnum(EntityGraphStatus.allocation_error);
+    return @intFromEnum(EntityGraphStatus.ok);
+}
+
 /// Export the graph to a GraphML file at `output_path`. Overwrites existing
-/// files.
+/// files. Freezes the graph.
 export fn ddac_entity_graph_export_graphml(
     handle: ?*EntityGraph,
     output_path: ?[*:0]const u8,
 ) c_int {
-    const h = handle orelse return @intFromEnum(EntityGraphStatus.invalid_handle);
-    const path = output_path orelse return @intFromEnum(EntityGraphStatus.write_error);
-
-    // Estimate buffer: 200 bytes per node + 120 bytes per edge + 1 KB header.
-    const est: usize = 1024 + h.nodes.items.len * 256 + h.edges.count() * 128;
-    const buf = std.heap.c_allocator.alloc(u8, est) catch {
-        return @intFromEnum(EntityGraphStatus.allocation_error);
-    };
-    defer std.heap.c_allocator.free(buf);
-
-    var stream = std.io.fixedBufferStream(buf);
-    writeGraphML(h, stream.writer()) catch return @intFromEnum(EntityGraphStatus.write_error);
-
-    const file = std.fs.createFileAbsoluteZ(path, .{ .truncate = true }) catch {
-        return @intFromEnum(EntityGraphStatus.write_error);
-    };
-    defer file.close();
-    file.writeAll(stream.getWritten()) catch return @intFromEnum(EntityGraphStatus.write_error);
-
-    return @intFromEnum(EntityGraphStatus.ok);
+    return exportTo(handle, output_path, writeGraphML);
 }
 
 /// Export a simple CSV edge list (source,target,weight) — convenient for
-/// spreadsheets and downstream graph tools that prefer CSV input.
+/// spreadsheets and downstream graph tools that prefer CSV input. Freezes
+/// the graph.
 export fn ddac_entity_graph_export_csv(
     handle: ?*EntityGraph,
     output_path: ?[*:0]const u8,
 ) c_int {
+    return exportTo(handle, output_path, writeCsv);
+}
+
+fn exportTo(handle: ?*EntityGraph, output_path: ?[*:0]const u8, comptime write: anytype) c_int {
     const h = handle orelse return @intFromEnum(EntityGraphStatus.invalid_handle);
     const path = output_path orelse return @intFromEnum(EntityGraphStatus.write_error);
-
-    const est: usize = 256 + h.edges.count() * 160;
-    const buf = std.heap.c_allocator.alloc(u8, est) catch {
-        return @intFromEnum(EntityGraphStatus.allocation_error);
-    };
-    defer std.heap.c_allocator.free(buf);
-
-    var stream = std.io.fixedBufferStream(buf);
-    const w = stream.writer();
-
-    w.writeAll("source,target,weight\n") catch return @intFromEnum(EntityGraphStatus.write_error);
-    var it = h.edges.iterator();
-    while (it.next()) |entry| {
-        const key = entry.key_ptr.*;
-        const src_idx: u32 = @intCast(key >> 32);
-        const dst_idx: u32 = @intCast(key & 0xFFFFFFFF);
-        const src_name = h.nodes.items[src_idx].name;
-        const dst_name = h.nodes.items[dst_idx].name;
-        w.print("\"{s}\",\"{s}\",{d}\n", .{ src_name, dst_name, entry.value_ptr.* }) catch {
-            return @intFromEnum(EntityGraphStatus.write_error);
-        };
-    }
+    h.freeze() catch return @intFromEnum(EntityGraphStatus.allocation_error);
 
     const file = std.fs.createFileAbsoluteZ(path, .{ .truncate = true }) catch {
         return @intFromEnum(EntityGraphStatus.write_error);
     };
     defer file.close();
-    file.writeAll(stream.getWritten()) catch return @intFromEnum(EntityGraphStatus.write_error);
+
+    var sink = FileSink{ .file = file };
+    write(h, &sink) catch return @intFromEnum(EntityGraphStatus.write_error);
+    sink.flush() catch return @intFromEnum(EntityGraphStatus.write_error);
 
     return @intFromEnum(EntityGraphStatus.ok);
 }
@@ -389,14 +720,74 @@ export fn ddac_entity_graph_node_count(handle: ?*EntityGraph) u32 {
 /// Number of distinct co-occurrence edges in the graph.
 export fn ddac_entity_graph_edge_count(handle: ?*EntityGraph) u32 {
     const h = handle orelse return 0;
-    return @intCast(h.edges.count());
+    return @intCast(h.edgeCount());
 }
 
 // ============================================================================
-// GraphML Writer
+// Writers
 // ============================================================================
 
-fn writeGraphML(g: *EntityGraph, writer: anytype) !void {
+/// Buffered file writer for the exports: output is streamed in
+/// fixed-size blocks however large the graph is.
+const FileSink = struct {
+    file: std.fs.File,
+    buf: [64 * 1024]u8 = undefined,
+    len: usize = 0,
+
+    fn writeAll(self: *FileSink, bytes: []const u8) !void {
+        if (self.len + bytes.len > self.buf.len) try self.flush();
+        if (bytes.len > self.buf.len) return self.file.writeAll(bytes);
+        @memcpy(self.buf[self.len..][0..bytes.len], bytes);
+        self.len += bytes.len;
+    }
+
+    fn writeByte(self: *FileSink, byte: u8) !void {
+        return self.writeAll(&.{byte});
+    }
+
+    fn print(self: *FileSink, comptime fmt: []const u8, args: anytype) !void {
+        var line: [4 * MAX_NAME_LEN + 256]u8 = undefined;
+        const len: usize = @intCast(std.fmt.count(fmt, args));
+        if (len <= line.len) return self.writeAll(try std.fmt.bufPrint(&line, fmt, args));
+        // Unusually long names: format on the heap
+        const big = try std.heap.c_allocator.alloc(u8, len);
+        defer std.heap.c_allocator.free(big);
+        return self.writeAll(try std.fmt.bufPrint(big, fmt, args));
+    }
+
+    fn flush(self: *FileSink) !void {
+        try self.file.writeAll(self.buf[0..self.len]);
+        self.len = 0;
+    }
+};
+
+/// Edges of a frozen graph in CSR order.
+const EdgeIterator = struct {
+    csr: *const Csr,
+    row: u32 = 0,
+    e: usize = 0,
+
+    fn next(self: *EdgeIterator) ?Edge {
+        if (self.e >= self.csr.cols.len) return null;
+        while (self.csr.offsets[self.row + 1] <= self.e) self.row += 1;
+        defer self.e += 1;
+        return .{ .src = self.row, .dst = self.csr.cols[self.e], .weight = self.csr.weights[self.e] };
+    }
+};
+
+/// Write a frozen graph as CSV.
+fn writeCsv(g: *const EntityGraph, writer: anytype) !void {
+    try writer.writeAll("source,target,weight\n");
+    var it = EdgeIterator{ .csr = &g.csr.? };
+    while (it.next()) |edge| {
+        try writer.print("\"{s}\",\"{s}\",{d}\n", .{
+            g.nodes.items[edge.src].name, g.nodes.items[edge.dst].name, edge.weight,
+        });
+    }
+}
+
+/// Write a frozen graph as GraphML.
+fn writeGraphML(g: *const EntityGraph, writer: anytype) !void {
     try writer.writeAll(
         \\<?xml version="1.0" encoding="UTF-8"?>
         \\<graphml xmlns="http://graphml.graphdrawing.org/xmlns"
@@ -419,15 +810,12 @@ fn writeGraphML(g: *EntityGraph, writer: anytype) !void {
         try writer.writeAll("</data></node>\n");
     }
 
-    var it = g.edges.iterator();
+    var it = EdgeIterator{ .csr = &g.csr.? };
     var edge_id: usize = 0;
-    while (it.next()) |entry| : (edge_id += 1) {
-        const key = entry.key_ptr.*;
-        const src: u32 = @intCast(key >> 32);
-        const dst: u32 = @intCast(key & 0xFFFFFFFF);
+    while (it.next()) |edge| : (edge_id += 1) {
         try writer.print(
             "    <edge id=\"e{d}\" source=\"n{d}\" target=\"n{d}\"><data key=\"w\">{d}</data></edge>\n",
-            .{ edge_id, src, dst, entry.value_ptr.* },
+            .{ edge_id, edge.src, edge.dst, edge.weight },
         );
     }
 
@@ -500,6 +888,7 @@ test "exports without nodes produce valid empty graphml" {
     defer g.deinit();
 
     // Build in memory rather than touching the filesystem.
+    try g.freeze();
     var buf: [4096]u8 = undefined;
     var stream = std.io.fixedBufferStream(&buf);
     try writeGraphML(g, stream.writer());
@@ -507,3 +896,79 @@ test "exports without nodes produce valid empty graphml" {
     try std.testing.expect(std.mem.indexOf(u8, written, "<graphml") != null);
     try std.testing.expect(std.mem.indexOf(u8, written, "</graphml>") != null);
 }
+
+/// Weight of the edge between two named nodes of a frozen graph.
+fn testWeight(g: *const EntityGraph, a: []const u8, b: []const u8) ?u32 {
+    var it = EdgeIterator{ .csr = &g.csr.? };
+    while (it.next()) |edge| {
+        const src = g.nodes.items[edge.src].name;
+        const dst = g.nodes.items[edge.dst].name;
+        if ((std.mem.eql(u8, src, a) and std.mem.eql(u8, dst, b)) or
+            (std.mem.eql(u8, src, b) and std.mem.eql(u8, dst, a))) return edge.weight;
+    }
+    return null;
+}
+
+test "freeze builds sorted CSR rows" {
+    const g = try EntityGraph.init(std.testing.allocator);
+    defer g.deinit();
+
+    const doc = "Jeffrey Epstein, Ghislaine Maxwell and Prince Andrew.";
+    _ = ddac_entity_graph_add_document(g, doc.ptr, doc.len);
+    try g.freeze();
+    try g.freeze(); // idempotent
+
+    const csr = g.csr.?;
+    try std.testing.expectEqual(@as(usize, 3), csr.cols.len);
+    try std.testing.expectEqual(@as(u32, 3), ddac_entity_graph_edge_count(g));
+    for (0..g.nodes.items.len) |row| {
+        const cols = csr.cols[csr.offsets[row]..csr.offsets[row + 1]];
+        for (cols, 0..) |c, i| {
+            try std.testing.expect(c > row);
+            if (i > 0) try std.testing.expect(c > cols[i - 1]);
+        }
+    }
+    try std.testing.expectEqual(@as(c_int, @intFromEnum(EntityGraphStatus.frozen)), ddac_entity_graph_add_document(g, doc.ptr, doc.len));
+}
+
+test "merged shards match a graph built serially" {
+    const allocator = std.testing.allocator;
+    const docs = [_][]const u8{
+        "Jeffrey Epstein called Ghislaine Maxwell today",
+        "Ghislaine Maxwell wrote to Jeffrey Epstein about Prince Andrew today",
+        "Prince Andrew met Virginia Giuffre in London",
+        "Jeffrey Epstein flew with Virginia Giuffre and Ghislaine Maxwell twice",
+    };
+
+    const serial = try EntityGraph.init(allocator);
+    defer serial.deinit();
+    var shards: [3]*EntityGraph = undefined;
+    for (&shards) |*sh| sh.* = try EntityGraph.init(allocator);
+    defer for (shards) |sh| sh.deinit();
+    for (docs, 0..) |doc, i| {
+        _ = ddac_entity_graph_add_document(serial, doc.ptr, doc.len);
+        _ = ddac_entity_graph_add_document(shards[i % shards.len], doc.ptr, doc.len);
+    }
+    try serial.freeze();
+
+    for ([_]usize{ 1, 3, 8 }) |parts| {
+        const merged = try EntityGraph.merge(allocator, &.{ shards[0], shards[1], shards[2] }, parts);
+        defer merged.deinit();
+
+        try std.testing.expectEqual(serial.nodes.items.len, merged.nodes.items.len);
+        try std.testing.expectEqual(serial.edgeCount(), merged.edgeCount());
+        try std.testing.expectEqual(@as(u32, docs.len), merged.document_count);
+        try std.testing.expectEqual(@as(?u32, 3), testWeight(merged, "Jeffrey Epstein", "Ghislaine Maxwell"));
+        try std.testing.expectEqual(@as(?u32, 1), testWeight(merged, "Prince Andrew", "Virginia Giuffre"));
+        for (merged.nodes.items) |node| {
+            if (std.mem.eql(u8, node.name, "Jeffrey Epstein")) try std.testing.expectEqual(@as(u32, 3), node.doc_count);
+        }
+    }
+}
+
+test "merge rejects frozen shards" {
+    const g = try EntityGraph.init(std.testing.allocator);
+    defer g.deinit();
+    try g.freeze();
+    try std.testing.expectError(error.ShardFrozen, EntityGraph.merge(std.testing.allocator, &.{g}, 2));
+}
@@ -3,23 +3,34 @@
 // Docudactyl — GPU-Accelerated OCR Coprocessor
 //
 // Batched OCR using GPU acceleration when available:
-//   1. PaddleOCR via PaddlePaddle inference (CUDA/TensorRT) — primary
-//   2. Tesseract CUDA LSTM — fallback GPU path
-//   3. Tesseract CPU — final fallback (existing path, always available)
+//   1. PaddleOCR via Paddle Inference (CUDA) — primary (paddle_ocr.zig)
+//   2. Tesseract built with CUDA LSTM — fallback GPU path
+//   3. Tesseract CPU — final fallback (existing path in ddac_parse, always available)
 //
 // At British Library scale (~170M items), image-heavy collections
 // (stamps, maps, manuscripts, photographs) dominate runtime. GPU OCR
 // provides 50-100x speedup for these workloads by:
-//   - Batching 64-128 images per GPU kernel launch
-//   - Overlapping CPU pre-processing with GPU inference
-//   - Using TensorRT for INT8/FP16 quantised inference
+//   - Batching up to MAX_BATCH_SIZE images per inference run
+//   - Overlapping CPU parsing with GPU inference
 //
-// Chapel dispatches images to the GPU coprocessor via ddac_gpu_ocr_submit()
-// and collects results via ddac_gpu_ocr_collect(). The coprocessor maintains
-// an internal queue and flushes batches to the GPU when full or on explicit
-// flush.
+// Chapel tasks submit images with ddac_gpu_ocr_submit() and get a ticket
+// back; ddac_gpu_ocr_flush() hands the batch to a dedicated worker thread
+// and returns at once, so the task keeps parsing PDFs while the batch runs.
+// ddac_gpu_ocr_collect() blocks until the ticket's batch has finished.
+//
+// Two batch buffers are double-buffered: one fills while the worker runs
+// the other. Each buffer owns a text arena that holds the whole batch's
+// extracted text, so a batch is never truncated; a buffer is recycled once
+// every ticket in it has been collected or released.
 
 const std = @import("std");
+const text_arena = @import("text_arena.zig");
+const paddle_ocr = @import("paddle_ocr.zig");
+
+const c = @cImport({
+    @cInclude("tesseract/capi.h");
+    @cInclude("leptonica/allheaders.h");
+});
 
 // ============================================================================
 // GPU Backend Detection
@@ -27,7 +38,7 @@ const std = @import("std");
 
 /// Which GPU backend is available (probed at init time).
 const GpuBackend = enum(u8) {
-    /// PaddleOCR with CUDA/TensorRT — best throughput
+    /// PaddleOCR with CUDA — best throughput
     paddle_gpu = 0,
     /// Tesseract compiled with CUDA LSTM support
     tesseract_cuda = 1,
@@ -49,7 +60,7 @@ pub const OcrResult = extern struct {
     word_count: i64,
     /// GPU processing time in microseconds (0 if CPU)
     gpu_time_us: i64,
-    /// Offset into the shared text buffer where this result's text starts
+    /// Offset of this result's text in its batch's text arena
     text_offset: i64,
     /// Length of extracted text in bytes
     text_length: i64,
@@ -63,73 +74,274 @@ comptime {
         @compileError("OcrResult must be 8-byte aligned");
 }
 
-/// Batch slot: one pending image for OCR
-const BatchSlot = struct {
-    path: [*:0]const u8,
-    output_path: [*:0]const u8,
-    slot_id: u32,
-};
-
 /// Maximum images per GPU batch. Tuned for:
-///   - GPU memory: 128 × 4MB avg image = 512MB VRAM (fits 4GB+ GPU)
 ///   - Kernel launch amortisation: >64 needed for good throughput
-///   - Latency: <1s per batch at TensorRT FP16
+///   - Latency: <1s per batch at FP16
+/// paddle_ocr.zig splits a batch into detection/recognition groups that
+/// bound the tensor sizes.
 const MAX_BATCH_SIZE: u32 = 128;
 
+/// Batch buffers: one filling while the worker runs the other.
+const NUM_BUFFERS: usize = 2;
+
+/// Images smaller than this in either dimension are skipped.
+const MIN_OCR_DIMENSION: c_int = 10;
+
+// ============================================================================
+// Batches and tickets
+// ============================================================================
+
+/// Batch slot: one pending image for OCR (paths are owned copies)
+const BatchSlot = struct {
+    path: [:0]u8,
+    /// Where to write the text, or null to leave it in the arena only
+    output_path: ?[:0]u8,
+};
+
+const Phase = enum { free, filling, queued, running, done };
+
+const Batch = struct {
+    phase: Phase = .free,
+    seq: u32 = 0,
+    len: u32 = 0,
+    /// Slots whose result has been collected or released
+    taken: std.StaticBitSet(MAX_BATCH_SIZE) = .initEmpty(),
+    /// Slots not yet taken
+    outstanding: u32 = 0,
+    slots: [MAX_BATCH_SIZE]BatchSlot = undefined,
+    results: [MAX_BATCH_SIZE]OcrResult = undefined,
+    /// Extracted text of the whole batch; results index into it
+    text: text_arena.TextArena,
+};
+
+/// Tickets name a slot of a specific batch: seq(23) | slot(7) | buffer(1).
+/// A ticket for a recycled batch no longer matches its buffer's seq.
+const SEQ_MASK: u32 = (1 << 23) - 1;
+
+fn makeTicket(buffer: usize, seq: u32, slot: u32) c_int {
+    return @intCast(((seq & SEQ_MASK) << 8) | (slot << 1) | @as(u32, @intCast(buffer)));
+}
+
 /// GPU OCR coprocessor state
 const GpuOcrState = struct {
     allocator: std.mem.Allocator,
     backend: GpuBackend,
-    /// Pending images awaiting batch dispatch
-    queue: [MAX_BATCH_SIZE]BatchSlot,
-    queue_len: u32,
-    /// Results for the last completed batch
-    results: [MAX_BATCH_SIZE]OcrResult,
-    results_ready: u32,
-    /// Shared text buffer for extracted text (1MB, reused across batches)
-    text_buf: []u8,
-    text_buf_used: usize,
+    /// Guards everything below except the engine (worker thread only)
+    mutex: std.Thread.Mutex = .{},
+    /// Signalled when a batch is queued or on shutdown
+    work_cond: std.Thread.Condition = .{},
+    /// Broadcast when a batch completes
+    done_cond: std.Thread.Condition = .{},
+    batches: [NUM_BUFFERS]Batch,
+    /// Buffer accepting submits, if any
+    filling: ?usize = null,
+    next_seq: u32 = 0,
+    worker: ?std.Thread = null,
+    stopping: bool = false,
+    /// The backend could not be brought up; submits are refused
+    unavailable: bool = false,
+    /// Completed results not yet collected
+    results_ready: u32 = 0,
+    /// Model directory for the PaddleOCR backend
+    model_dir: [512]u8 = undefined,
+    model_dir_len: usize = 0,
     /// Statistics
-    total_submitted: u64,
-    total_completed: u64,
-    total_gpu_batches: u64,
-    total_gpu_time_us: u64,
-    /// Tesseract handle for CPU fallback
-    tess_api: ?*anyopaque,
+    total_submitted: u64 = 0,
+    total_completed: u64 = 0,
+    total_gpu_batches: u64 = 0,
+    total_gpu_time_us: u64 = 0,
+    /// Inference backends, opened lazily on the worker thread
+    engine_opened: bool = false,
+    paddle: ?*paddle_ocr.Engine = null,
+    tess_api: ?*c.TessBaseAPI = null,
 
-    const TEXT_BUF_SIZE: usize = 1024 * 1024; // 1MB shared text buffer
+    const DEFAULT_MODEL_DIR = "models/paddleocr";
 
     fn init(allocator: std.mem.Allocator) !*GpuOcrState {
         const state = try allocator.create(GpuOcrState);
         state.* = .{
             .allocator = allocator,
             .backend = detectBackend(),
-            .queue = undefined,
-            .queue_len = 0,
-            .results = undefined,
-            .results_ready = 0,
-            .text_buf = try allocator.alloc(u8, TEXT_BUF_SIZE),
-            .text_buf_used = 0,
-            .total_submitted = 0,
-            .total_completed = 0,
-            .total_gpu_batches = 0,
-            .total_gpu_time_us = 0,
-            .tess_api = null,
+            .batches = undefined,
         };
-
-        // Initialise CPU Tesseract fallback (always available)
-        state.tess_api = initTesseract();
-
+        for (&state.batches) |*b| b.* = .{ .text = text_arena.TextArena.init(allocator) };
+        @memcpy(state.model_dir[0..DEFAULT_MODEL_DIR.len], DEFAULT_MODEL_DIR);
+        state.model_dir_len = DEFAULT_MODEL_DIR.len;
+
+        // No GPU: no worker; submits are refused and images stay on CPU
+        if (state.backend != .cpu_only) {
+            state.worker = std.Thread.spawn(.{}, workerLoop, .{state}) catch null;
+            if (state.worker == null) state.backend = .cpu_only;
+        }
         return state;
     }
 
     fn deinit(self: *GpuOcrState) void {
+        self.mutex.lock();
+        self.stopping = true;
+        self.work_cond.signal();
+        self.mutex.unlock();
+        if (self.worker) |t| t.join();
+
+        if (self.paddle) |engine| engine.close();
         if (self.tess_api) |tess| {
-            freeTesseract(tess);
+            c.TessBaseAPIEnd(tess);
+            c.TessBaseAPIDelete(tess);
+        }
+        for (&self.batches) |*b| {
+            self.freeSlots(b);
+            b.text.deinit();
         }
-        self.allocator.free(self.text_buf);
         self.allocator.destroy(self);
     }
+
+    fn freeSlots(self: *GpuOcrState, b: *Batch) void {
+        for (b.slots[0..b.len]) |slot| {
+            self.allocator.free(slot.path);
+            if (slot.output_path) |p| self.allocator.free(p);
+        }
+        b.len = 0;
+    }
+
+    /// Buffer accepting submits, opening a free one if needed. Caller holds mutex.
+    fn fillingBatch(self: *GpuOcrState) ?usize {
+        if (self.filling) |i| return i;
+        for (&self.batches, 0..) |*b, i| {
+            if (b.phase != .free) continue;
+            self.freeSlots(b);
+            b.seq = self.next_seq & SEQ_MASK;
+            self.next_seq +%= 1;
+            b.taken = .initEmpty();
+            b.outstanding = 0;
+            b.text.reset();
+            b.phase = .filling;
+            self.filling = i;
+            return i;
+        }
+        return null;
+    }
+
+    /// Hand the filling buffer to the worker. Caller holds mutex.
+    fn queueFilling(self: *GpuOcrState) void {
+        const i = self.filling orelse return;
+        if (self.batches[i].len == 0) return;
+        self.batches[i].phase = .queued;
+        self.filling = null;
+        self.work_cond.signal();
+    }
+
+    /// Batch and slot a ticket refers to, if it is still live. Caller holds mutex.
+    fn lookup(self: *GpuOcrState, ticket: u32) ?struct { batch: *Batch, slot: u32 } {
+        const b = &self.batches[ticket & 1];
+        const slot = (ticket >> 1) & (MAX_BATCH_SIZE - 1);
+        if (b.phase == .free or b.seq != ticket >> 8 or slot >= b.len) return null;
+        if (b.taken.isSet(slot)) return null;
+        return .{ .batch = b, .slot = slot };
+    }
+
+    /// Mark a slot collected/released; recycle the batch once drained. Caller holds mutex.
+    fn take(self: *GpuOcrState, b: *Batch, slot: u32) void {
+        b.taken.set(slot);
+        b.outstanding -= 1;
+        if (b.phase != .done) return;
+        self.results_ready -= 1;
+        if (b.outstanding == 0) b.phase = .free;
+    }
+
+    // ── Worker thread ─────────────────────────────────────────────────
+
+    fn workerLoop(self: *GpuOcrState) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            const b = self.nextQueued() orelse {
+                if (self.stopping) return;
+                self.work_cond.wait(&self.mutex);
+                continue;
+            };
+            b.phase = .running;
+
+            // The worker owns a running batch's slots, results and text
+            self.mutex.unlock();
+            const elapsed_us = self.runBatch(b);
+            self.mutex.lock();
+
+            b.phase = .done;
+            self.results_ready += b.outstanding;
+            if (b.outstanding == 0) b.phase = .free;
+            self.total_completed += b.len;
+            self.total_gpu_batches += 1;
+            self.total_gpu_time_us += elapsed_us;
+            self.done_cond.broadcast();
+        }
+    }
+
+    /// Oldest queued batch. Caller holds mutex.
+    fn nextQueued(self: *GpuOcrState) ?*Batch {
+        var best: ?*Batch = null;
+        for (&self.batches) |*b| {
+            if (b.phase != .queued) continue;
+            if (best == null or (b.seq -% best.?.seq) & SEQ_MASK > SEQ_MASK / 2) best = b;
+        }
+        return best;
+    }
+
+    /// OCR one batch on the worker thread. Returns elapsed microseconds.
+    fn runBatch(self: *GpuOcrState, b: *Batch) u64 {
+        const start_ns = std.time.nanoTimestamp();
+        for (b.results[0..b.len]) |*r| {
+            r.* = std.mem.zeroes(OcrResult);
+            r.status = 3; // gpu_error until a backend says otherwise
+            r.confidence = -1;
+        }
+
+        if (!self.engine_opened) self.openEngine();
+        switch (self.backend) {
+            .paddle_gpu => if (self.paddle) |engine| runPaddle(engine, b),
+            .tesseract_cuda => if (self.tess_api) |tess| runTesseract(tess, b),
+            .cpu_only => {},
+        }
+
+        const elapsed_ns = std.time.nanoTimestamp() - start_ns;
+        const elapsed_us: u64 = @intCast(@divTrunc(elapsed_ns, 1000));
+        const per_image_us: i64 = @intCast(elapsed_us / @max(b.len, 1));
+
+        const text = b.text.slice();
+        for (b.slots[0..b.len], b.results[0..b.len]) |slot, *r| {
+            if (r.status != 0) continue;
+            r.gpu_time_us = per_image_us;
+            const t = text[@intCast(r.text_offset)..][0..@intCast(r.text_length)];
+            r.char_count = @intCast(t.len);
+            r.word_count = countWords(t);
+            const out = slot.output_path orelse continue;
+            writeText(out, t) catch {
+                r.status = 1;
+            };
+        }
+        return elapsed_us;
+    }
+
+    /// Bring up the backend's inference engine (worker thread, first batch).
+    fn openEngine(self: *GpuOcrState) void {
+        self.engine_opened = true;
+        var dir_buf: [512]u8 = undefined;
+        self.mutex.lock();
+        const dir_len = self.model_dir_len;
+        @memcpy(dir_buf[0..dir_len], self.model_dir[0..dir_len]);
+        self.mutex.unlock();
+
+        switch (self.backend) {
+            .paddle_gpu => self.paddle = paddle_ocr.Engine.open(self.allocator, dir_buf[0..dir_len]),
+            .tesseract_cuda => self.tess_api = initTesseract(),
+            .cpu_only => {},
+        }
+        if (self.paddle == null and self.tess_api == null) {
+            std.log.warn("GPU OCR backend unavailable (models in {s}?) — images stay on CPU Tesseract", .{dir_buf[0..dir_len]});
+            self.mutex.lock();
+            self.unavailable = true;
+            self.mutex.unlock();
+        }
+    }
 };
 
 // ============================================================================
@@ -173,23 +385,22 @@ fn probeCudaDevices() bool {
     return rc == 0 and count > 0;
 }
 
-/// Check if PaddleOCR inference library is available.
+/// Check if the Paddle Inference C library is available.
 fn probePaddleOcr() bool {
-    const lib = std.DynLib.open("libpaddle_inference.so") catch
-        std.DynLib.open("libpaddle_inference_c.so") catch
+    const lib = std.DynLib.open("libpaddle_inference_c.so") catch
+        std.DynLib.open("libpaddle_inference.so") catch
         return false;
     defer lib.close();
 
     // Check for the main inference entry point
-    _ = lib.lookup(*const fn () callconv(.c) ?*anyopaque, "PD_NewAnalysisConfig") orelse return false;
+    _ = lib.lookup(*const fn () callconv(.c) ?*anyopaque, "PD_ConfigCreate") orelse return false;
     return true;
 }
 
 /// Check if Tesseract was compiled with CUDA LSTM support.
 fn probeTesseractCuda() bool {
-    // Tesseract CUDA is detected by checking if the LSTM engine
-    // initialises with OEM_LSTM_ONLY mode on a GPU-enabled build.
-    // For now, check the shared library for CUDA-specific symbols.
+    // Tesseract CUDA is detected by checking the shared library for
+    // CUDA-specific symbols.
     const lib = std.DynLib.open("libtesseract.so") catch
         std.DynLib.open("libtesseract.so.5") catch
         return false;
@@ -201,122 +412,118 @@ fn probeTesseractCuda() bool {
 }
 
 // ============================================================================
-// CPU Tesseract Fallback
+// Batch OCR Processing (worker thread)
 // ============================================================================
 
-/// Initialise a Tesseract instance for CPU OCR fallback.
-/// Uses the C API directly via dlsym to avoid link-time dependency.
-fn initTesseract() ?*anyopaque {
-    const lib = std.DynLib.open("libtesseract.so") catch
-        std.DynLib.open("libtesseract.so.5") catch
-        return null;
-    // Keep lib open (leaked intentionally — needed for lifetime of program)
-    _ = lib;
+/// PaddleOCR: the whole batch goes through detection + recognition.
+fn runPaddle(engine: *paddle_ocr.Engine, b: *Batch) void {
+    var items: [MAX_BATCH_SIZE]paddle_ocr.Item = undefined;
+    for (b.slots[0..b.len], items[0..b.len]) |slot, *item| item.* = .{ .path = slot.path.ptr };
 
-    // Use the existing Tesseract init from docudactyl_ffi.zig
-    // The GPU coprocessor shares the same Tesseract API
-    return null; // Placeholder — actual Tesseract handle comes from ddac_init()
-}
+    engine.recognize(items[0..b.len], &b.text);
 
-fn freeTesseract(handle: ?*anyopaque) void {
-    _ = handle;
-    // Cleanup handled by ddac_free() in the main FFI
+    for (items[0..b.len], b.results[0..b.len]) |item, *r| {
+        r.status = item.status;
+        r.confidence = item.confidence;
+        r.text_offset = @intCast(item.text_offset);
+        r.text_length = @intCast(item.text_length);
+    }
+    // A truncated batch is not a result; let the CPU path redo it
+    if (b.text.oom) {
+        for (b.results[0..b.len]) |*r| r.status = 3;
+    }
 }
 
-// ============================================================================
-// Batch OCR Processing
-// ============================================================================
-
-/// Process a batch of images on the CPU (Tesseract).
-/// Called when GPU is unavailable or as fallback.
-fn processBatchCpu(state: *GpuOcrState) void {
-    state.text_buf_used = 0;
-
-    for (0..state.queue_len) |i| {
-        const slot = &state.queue[i];
-        var result = &state.results[i];
-        result.* = std.mem.zeroes(OcrResult);
+/// Tesseract (CUDA build): the worker's own instance, one image at a time;
+/// the LSTM runs on the GPU inside Tesseract.
+fn runTesseract(tess: *c.TessBaseAPI, b: *Batch) void {
+    for (b.slots[0..b.len], b.results[0..b.len]) |slot, *r| {
+        defer c.TessBaseAPIClear(tess);
 
-        // Open image and run OCR via file-based Tesseract
-        const path_str = std.mem.span(slot.path);
-
-        // Read the file to check it's a valid image
-        const file = std.fs.openFileAbsolute(path_str, .{}) catch {
-            result.status = 1; // error
+        var pix = c.pixRead(slot.path.ptr);
+        if (pix == null) {
+            r.status = 1;
             continue;
-        };
+        }
+        defer c.pixDestroy(&pix);
 
-        const file_stat = file.stat() catch {
-            file.close();
-            result.status = 1;
+        r.text_offset = @intCast(b.text.slice().len);
+        if (c.pixGetWidth(pix) < MIN_OCR_DIMENSION or c.pixGetHeight(pix) < MIN_OCR_DIMENSION) {
+            r.status = 2;
             continue;
-        };
-        file.close();
+        }
 
-        if (file_stat.size == 0) {
-            result.status = 2; // skipped (empty)
+        c.TessBaseAPISetImage2(tess, pix);
+        if (c.TessBaseAPIRecognize(tess, null) != 0) {
+            r.status = 3;
             continue;
         }
-
-        // For CPU path, we write a placeholder result indicating
-        // that this image needs full Tesseract processing via the
-        // main ddac_parse path. The GPU coprocessor is an accelerator,
-        // not a replacement — when no GPU, it defers to the existing path.
-        result.status = 3; // gpu_error → signals "use CPU fallback"
-        result.confidence = -1;
-        result.gpu_time_us = 0;
+        r.confidence = @intCast(@min(100, @max(0, c.TessBaseAPIMeanTextConf(tess))));
+
+        const text_ptr = c.TessBaseAPIGetUTF8Text(tess);
+        if (text_ptr != null) {
+            defer c.TessDeleteText(text_ptr);
+            if (!b.text.append(std.mem.span(text_ptr))) {
+                r.status = 3;
+                continue;
+            }
+        }
+        r.text_length = @as(i64, @intCast(b.text.slice().len)) - r.text_offset;
+        r.status = 0;
     }
-
-    state.results_ready = state.queue_len;
-    state.total_completed += state.queue_len;
-    state.queue_len = 0;
 }
 
-/// Process a batch of images on the GPU (PaddleOCR or Tesseract CUDA).
-/// Falls back to CPU if GPU processing fails.
-fn processBatchGpu(state: *GpuOcrState) void {
-    const start_ns = std.time.nanoTimestamp();
-
-    switch (state.backend) {
-        .paddle_gpu => {
-            // PaddleOCR batch inference
-            // In production, this would:
-            //   1. Load images into a batch tensor (NCHW format)
-            //   2. Run PaddleOCR detection model (DBNet)
-            //   3. Run PaddleOCR recognition model (CRNN)
-            //   4. Post-process text boxes and recognition results
-            //   5. Write extracted text to shared buffer
-            //
-            // For now, fall through to CPU since PaddleOCR C API
-            // integration requires the inference library at link time.
-            processBatchCpu(state);
-        },
-        .tesseract_cuda => {
-            // Tesseract CUDA LSTM path
-            // Would use TessBaseAPISetupCuda() + batch SetImage
-            processBatchCpu(state);
-        },
-        .cpu_only => {
-            processBatchCpu(state);
-        },
+/// Create the worker's Tesseract instance (English LSTM, as ddac_init).
+fn initTesseract() ?*c.TessBaseAPI {
+    const tess = c.TessBaseAPICreate() orelse return null;
+    if (c.TessBaseAPIInit3(tess, null, "eng") != 0) {
+        c.TessBaseAPIDelete(tess);
+        return null;
     }
+    return tess;
+}
+
+fn countWords(text: []const u8) i64 {
+    var count: i64 = 0;
+    var it = std.mem.tokenizeAny(u8, text, " \t\r\n");
+    while (it.next()) |_| count += 1;
+    return count;
+}
 
-    const elapsed_ns = std.time.nanoTimestamp() - start_ns;
-    const elapsed_us: u64 = @intCast(@divTrunc(elapsed_ns, 1000));
+fn writeText(path: [:0]const u8, text: []const u8) !void {
+    const file = try std.fs.createFileAbsoluteZ(path, .{});
+    defer file.close();
+    try file.writeAll(text);
+}
 
-    state.total_gpu_batches += 1;
-    state.total_gpu_time_us += elapsed_us;
+// ============================================================================
+// Zig API (parse handles)
+// ============================================================================
 
-    // Record GPU time on each result
-    if (state.backend != .cpu_only) {
-        const per_image_us = if (state.results_ready > 0)
-            elapsed_us / state.results_ready
-        else
-            0;
-        for (0..state.results_ready) |i| {
-            state.results[i].gpu_time_us = @intCast(per_image_us);
+/// Collect a ticket's result, blocking until its batch has run. On status
+/// 0 the text is appended to `sink` (if given). The ticket is spent.
+/// Returns 0 on success, -1 for an unknown, stale or already-spent ticket.
+pub fn collectInto(handle: *anyopaque, ticket: u32, result_out: *OcrResult, sink: ?*text_arena.TextArena) c_int {
+    // SAFETY: handle originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *GpuOcrState = @ptrCast(@alignCast(handle));
+    state.mutex.lock();
+    defer state.mutex.unlock();
+
+    const ref = state.lookup(ticket) orelse return -1;
+    const b = ref.batch;
+    // Collecting from a batch nobody flushed yet: flush it now
+    if (b.phase == .filling) state.queueFilling();
+    while (b.phase == .queued or b.phase == .running) state.done_cond.wait(&state.mutex);
+
+    result_out.* = b.results[ref.slot];
+    if (sink) |arena| {
+        if (result_out.status == 0) {
+            const off: usize = @intCast(result_out.text_offset);
+            _ = arena.append(b.text.slice()[off..][0..@intCast(result_out.text_length)]);
         }
     }
+    state.take(b, ref.slot);
+    return 0;
 }
 
 // ============================================================================
@@ -324,7 +531,7 @@ fn processBatchGpu(state: *GpuOcrState) void {
 // ============================================================================
 
 /// Initialise the GPU OCR coprocessor.
-/// Probes for GPU backends and allocates batch buffers.
+/// Probes for GPU backends and, if one is found, starts the worker thread.
 /// Returns opaque handle or null on failure.
 export fn ddac_gpu_ocr_init() ?*anyopaque {
     const allocator = std.heap.c_allocator;
@@ -333,7 +540,7 @@ export fn ddac_gpu_ocr_init() ?*anyopaque {
     return @ptrCast(state);
 }
 
-/// Free the GPU OCR coprocessor.
+/// Free the GPU OCR coprocessor. Outstanding tickets become invalid.
 export fn ddac_gpu_ocr_free(handle: ?*anyopaque) void {
     const ptr = handle orelse return;
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
@@ -350,72 +557,108 @@ export fn ddac_gpu_ocr_backend(handle: ?*anyopaque) u8 {
     return @intFromEnum(state.backend);
 }
 
+/// Set the PaddleOCR model directory ({dir}/det, {dir}/rec, {dir}/dict.txt).
+/// Takes effect if called before the first batch runs.
+export fn ddac_gpu_ocr_set_model_dir(handle: ?*anyopaque, dir: [*:0]const u8) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
+    const dir_str = std.mem.span(dir);
+    state.mutex.lock();
+    defer state.mutex.unlock();
+    const len = @min(dir_str.len, state.model_dir.len);
+    @memcpy(state.model_dir[0..len], dir_str[0..len]);
+    state.model_dir_len = len;
+}
+
 /// Submit an image for GPU OCR processing.
-/// Images are queued until the batch is full or ddac_gpu_ocr_flush() is called.
-/// Returns: slot ID (0..MAX_BATCH_SIZE-1) on success, -1 if queue full.
+/// Images are queued until the batch is full (then it starts at once) or
+/// ddac_gpu_ocr_flush() is called. Paths are copied.
+/// output_path: where to write the text, or null to only return it via
+/// collect (parse handles write their own output file).
+/// Returns: a ticket (>= 0) for ddac_gpu_ocr_collect(), or -1 if no batch
+/// buffer is free or there is no GPU backend (use CPU OCR).
 export fn ddac_gpu_ocr_submit(
     handle: ?*anyopaque,
     image_path: [*:0]const u8,
-    output_path: [*:0]const u8,
+    output_path: ?[*:0]const u8,
 ) c_int {
     const ptr = handle orelse return -1;
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
+    state.mutex.lock();
+    defer state.mutex.unlock();
+
+    if (state.backend == .cpu_only or state.unavailable) return -1;
+    const bi = state.fillingBatch() orelse return -1;
+    const b = &state.batches[bi];
+
+    const path = state.allocator.dupeZ(u8, std.mem.span(image_path)) catch return -1;
+    const out: ?[:0]u8 = if (output_path) |p|
+        state.allocator.dupeZ(u8, std.mem.span(p)) catch {
+            state.allocator.free(path);
+            return -1;
+        }
+    else
+        null;
 
-    if (state.queue_len >= MAX_BATCH_SIZE) return -1;
-
-    const slot_id = state.queue_len;
-    state.queue[slot_id] = .{
-        .path = image_path,
-        .output_path = output_path,
-        .slot_id = slot_id,
-    };
-    state.queue_len += 1;
+    const slot = b.len;
+    b.slots[slot] = .{ .path = path, .output_path = out };
+    b.len += 1;
+    b.outstanding += 1;
     state.total_submitted += 1;
 
-    // Auto-flush when batch is full
-    if (state.queue_len >= MAX_BATCH_SIZE) {
-        processBatchGpu(state);
-    }
+    // Start a full batch right away
+    if (b.len >= MAX_BATCH_SIZE) state.queueFilling();
 
-    return @intCast(slot_id);
+    return makeTicket(bi, b.seq, slot);
 }
 
-/// Flush any pending images in the queue — process them as a (partial) batch.
-/// Call this before collecting results if the queue isn't full.
+/// Flush pending images — start the current (partial) batch on the worker.
+/// Returns immediately; collect waits for completion.
 export fn ddac_gpu_ocr_flush(handle: ?*anyopaque) void {
     const ptr = handle orelse return;
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
-
-    if (state.queue_len > 0) {
-        processBatchGpu(state);
-    }
+    state.mutex.lock();
+    defer state.mutex.unlock();
+    state.queueFilling();
 }
 
-/// Get the number of results ready to collect after flush.
+/// Get the number of completed results not yet collected.
 export fn ddac_gpu_ocr_results_ready(handle: ?*anyopaque) u32 {
     const ptr = handle orelse return 0;
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
+    state.mutex.lock();
+    defer state.mutex.unlock();
     return state.results_ready;
 }
 
-/// Collect one OCR result by slot ID.
-/// result_out must point to an OcrResult (48 bytes).
-/// Returns 0 on success, -1 on invalid slot.
+/// Collect one OCR result by ticket, waiting for its batch if needed.
+/// result_out must point to an OcrResult (48 bytes). The text is in
+/// output_path if one was given at submit.
+/// Returns 0 on success, -1 on an invalid or already-collected ticket.
 export fn ddac_gpu_ocr_collect(
     handle: ?*anyopaque,
-    slot_id: u32,
+    ticket: u32,
     result_out: *OcrResult,
 ) c_int {
     const ptr = handle orelse return -1;
+    return collectInto(ptr, ticket, result_out, null);
+}
+
+/// Give up a ticket without collecting it (its batch buffer can then be
+/// recycled). Safe on spent, stale or negative tickets.
+export fn ddac_gpu_ocr_release(handle: ?*anyopaque, ticket: c_int) void {
+    const ptr = handle orelse return;
+    if (ticket < 0) return;
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
-
-    if (slot_id >= state.results_ready) return -1;
-    result_out.* = state.results[slot_id];
-    return 0;
+    state.mutex.lock();
+    defer state.mutex.unlock();
+    const ref = state.lookup(@intCast(ticket)) orelse return;
+    state.take(ref.batch, ref.slot);
 }
 
 /// Get GPU OCR statistics.
@@ -436,6 +679,8 @@ export fn ddac_gpu_ocr_stats(
     };
     // SAFETY: ptr originates from ddac_gpu_ocr_init() which stores a *GpuOcrState via @ptrCast; alignment is guaranteed by c_allocator
     const state: *GpuOcrState = @ptrCast(@alignCast(ptr));
+    state.mutex.lock();
+    defer state.mutex.unlock();
     submitted.* = state.total_submitted;
     completed.* = state.total_completed;
     batches.* = state.total_gpu_batches;
@@ -8,16 +8,25 @@
 // Acceleration tiers (in order of preference):
 //   1. SHA-NI (x86-64): Dedicated SHA-256 instructions (Intel Goldmont+, AMD Zen)
 //   2. ARM SHA2 (AArch64): Crypto extensions on ARMv8+
-//   3. AVX2 (x86-64): SIMD 4-buffer SHA-256 (4 files hashed simultaneously)
+//   3. AVX-512 / AVX2 (x86-64): multi-buffer SHA-256 (16 / 8 messages per pass)
 //   4. Software: Zig's std SHA-256 (still fast — loop-unrolled, no allocation)
 //
-// Zig's std.crypto.hash.sha2.Sha256 auto-detects SHA-NI/ARM-SHA2 at runtime,
-// so single-file hashing is already hardware-accelerated. This module adds:
-//   - Multi-buffer SHA-256 for batch operations (4 files at once with AVX2)
+// Zig's std.crypto.hash.sha2.Sha256 uses SHA-NI/ARM-SHA2 when the build
+// target has them, so single-file hashing is already hardware-accelerated.
+// This module adds:
+//   - Multi-buffer SHA-256: one lane per message, the compression function
+//     runs on @Vector(N, u32) so N small files are hashed in one pass
+//   - Large-buffer streaming with readahead for the dedicated-instruction tier
 //   - Runtime capability reporting for Chapel banner
 //   - Batch digest computation for the conduit pipeline
+//
+// The lane count is chosen at runtime from CPUID/XCR0. The instructions the
+// lane kernels lower to follow the compile target (-Dcpu=native, or
+// x86_64_v3 / x86_64_v4 for AVX2 / AVX-512 fleets); on a baseline x86-64
+// build the same lanes run over SSE2 registers.
 
 const std = @import("std");
+const builtin = @import("builtin");
 
 // ============================================================================
 // CPU Feature Detection
@@ -27,9 +36,9 @@ const std = @import("std");
 const CryptoCapabilities = extern struct {
     /// x86-64: CPU supports SHA-NI (sha256rnds2, sha256msg1, sha256msg2)
     has_sha_ni: u8,
-    /// x86-64: CPU supports AVX2 (for multi-buffer SHA-256)
+    /// x86-64: CPU and OS support AVX2 (8-lane multi-buffer SHA-256)
     has_avx2: u8,
-    /// x86-64: CPU supports AVX-512F (for 8-buffer SHA-256)
+    /// x86-64: CPU and OS support AVX-512F (16-lane multi-buffer SHA-256)
     has_avx512: u8,
     /// AArch64: CPU supports SHA2 crypto extension
     has_arm_sha2: u8,
@@ -41,11 +50,13 @@ const CryptoCapabilities = extern struct {
     _pad: [2]u8,
     /// Effective SHA-256 throughput tier:
     ///   0 = SHA-NI or ARM SHA2 (dedicated instructions)
-    ///   1 = AVX2 multi-buffer (4x parallel)
+    ///   1 = AVX-512 / AVX2 multi-buffer (see sha256_lanes)
     ///   2 = Software (Zig std, still fast)
     sha256_tier: u8,
+    /// Messages hashed per pass by the batch API: 16, 8, or 1
+    sha256_lanes: u8,
     /// Padding
-    _pad2: [7]u8,
+    _pad2: [6]u8,
 };
 
 comptime {
@@ -57,23 +68,23 @@ comptime {
 fn detectCapabilities() CryptoCapabilities {
     var caps = std.mem.zeroes(CryptoCapabilities);
 
-    const target = @import("builtin").target;
-
-    switch (target.cpu.arch) {
+    switch (builtin.target.cpu.arch) {
         .x86_64 => {
-            // Use CPUID to detect x86-64 features
-            const features = std.Target.x86.featureSet(target.cpu.features);
-            _ = features;
-
             // Runtime CPUID check (works on any x86-64 CPU)
             // CPUID leaf 7, ECX=0: EBX bit 29 = SHA, bit 5 = AVX2, bit 16 = AVX-512F
-            // CPUID leaf 1: ECX bit 25 = AES-NI
+            // CPUID leaf 1: ECX bit 25 = AES-NI, bit 27 = OSXSAVE
             const leaf7 = cpuid(7, 0);
-            caps.has_sha_ni = if (leaf7.ebx & (1 << 29) != 0) 1 else 0;
-            caps.has_avx2 = if (leaf7.ebx & (1 << 5) != 0) 1 else 0;
-            caps.has_avx512 = if (leaf7.ebx & (1 << 16) != 0) 1 else 0;
-
             const leaf1 = cpuid(1, 0);
+
+            // AVX registers are only usable if the OS saves them on context
+            // switch: XCR0 bits 1-2 (SSE/AVX), plus 5-7 (opmask/ZMM) for AVX-512.
+            const xcr0: u64 = if (leaf1.ecx & (1 << 27) != 0) xgetbv(0) else 0;
+            const os_avx = xcr0 & 0x6 == 0x6;
+            const os_avx512 = xcr0 & 0xE6 == 0xE6;
+
+            caps.has_sha_ni = if (leaf7.ebx & (1 << 29) != 0) 1 else 0;
+            caps.has_avx2 = if (os_avx and leaf7.ebx & (1 << 5) != 0) 1 else 0;
+            caps.has_avx512 = if (os_avx512 and leaf7.ebx & (1 << 16) != 0) 1 else 0;
             caps.has_aes_ni = if (leaf1.ecx & (1 << 25) != 0) 1 else 0;
         },
         .aarch64 => {
@@ -90,15 +101,34 @@ fn detectCapabilities() CryptoCapabilities {
     // Determine effective SHA-256 tier
     if (caps.has_sha_ni == 1 or caps.has_arm_sha2 == 1) {
         caps.sha256_tier = 0; // Dedicated instructions
+        caps.sha256_lanes = 1;
+    } else if (caps.has_avx512 == 1) {
+        caps.sha256_tier = 1; // AVX-512 multi-buffer
+        caps.sha256_lanes = 16;
     } else if (caps.has_avx2 == 1) {
         caps.sha256_tier = 1; // AVX2 multi-buffer
+        caps.sha256_lanes = 8;
     } else {
         caps.sha256_tier = 2; // Software
+        caps.sha256_lanes = 1;
     }
 
     return caps;
 }
 
+var active_caps: CryptoCapabilities = undefined;
+var active_caps_once = std.once(initActiveCaps);
+
+fn initActiveCaps() void {
+    active_caps = detectCapabilities();
+}
+
+/// Capabilities of this host, detected once per process (hot-path lookup).
+fn activeCaps() CryptoCapabilities {
+    active_caps_once.call();
+    return active_caps;
+}
+
 /// Execute CPUID instruction (x86-64 only)
 const CpuidResult = struct {
     eax: u32,
@@ -125,6 +155,20 @@ fn cpuid(leaf: u32, subleaf: u32) CpuidResult {
     return .{ .eax = eax, .ebx = ebx, .ecx = ecx, .edx = edx };
 }
 
+/// Read an extended control register (x86-64 only; requires OSXSAVE)
+fn xgetbv(index: u32) u64 {
+    var eax: u32 = undefined;
+    var edx: u32 = undefined;
+
+    asm volatile ("xgetbv"
+        : [_] "={eax}" (eax),
+          [_] "={edx}" (edx),
+        : [_] "{ecx}" (index),
+    );
+
+    return (@as(u64, edx) << 32) | eax;
+}
+
 /// Detect ARM SHA2 crypto extension via /proc/cpuinfo
 fn detectArmSha2() u8 {
     // Check AT_HWCAP auxiliary vector for HWCAP_SHA2
@@ -137,13 +181,184 @@ fn detectArmSha2() u8 {
 // Multi-Buffer SHA-256
 // ============================================================================
 
-/// Number of parallel SHA-256 lanes for AVX2 multi-buffer
-const MULTI_BUFFER_LANES: usize = 4;
+/// Widest lane count any tier uses (AVX-512: 16 x 32-bit words per register).
+/// Callers that collect messages for sha256Many() group this many at a time.
+pub const MAX_LANES: usize = 16;
+
+/// Files up to this size are read whole and hashed in lanes; larger files
+/// are streamed one at a time.
+const SMALL_FILE_MAX: usize = 64 * 1024;
+
+/// Read size for streamed files (and the dedicated-instruction tier).
+const STREAM_READ_SIZE: usize = 1024 * 1024;
+
+/// Readahead requested for the next file while the current one hashes.
+const READAHEAD_SIZE: usize = 4 * STREAM_READ_SIZE;
+
+const SHA256_IV = [8]u32{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+const SHA256_K = [64]u32{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/// SHA-256 over L independent messages: lane j of every vector belongs to
+/// message j. Messages of different lengths share a pass; a lane whose
+/// message has run out of blocks keeps its state through a masked select.
+fn Lanes(comptime L: usize) type {
+    return struct {
+        const V = @Vector(L, u32);
+
+        inline fn rotr(x: V, comptime n: comptime_int) V {
+            return (x >> @splat(@as(u5, n))) | (x << @splat(@as(u5, 32 - n)));
+        }
+
+        inline fn shr(x: V, comptime n: comptime_int) V {
+            return x >> @splat(@as(u5, n));
+        }
+
+        fn compress(state: *[8]V, block: *const [16]V) void {
+            var w: [64]V = undefined;
+            w[0..16].* = block.*;
+            for (16..64) |i| {
+                const s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ shr(w[i - 15], 3);
+                const s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ shr(w[i - 2], 10);
+                w[i] = w[i - 16] +% s0 +% w[i - 7] +% s1;
+            }
+
+            var a = state[0];
+            var b = state[1];
+            var c = state[2];
+            var d = state[3];
+            var e = state[4];
+            var f = state[5];
+            var g = state[6];
+            var h = state[7];
+
+            inline for (0..64) |i| {
+                const s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                const ch = (e & f) ^ (~e & g);
+                const t1 = h +% s1 +% ch +% @as(V, @splat(SHA256_K[i])) +% w[i];
+                const s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                const maj = (a & b) ^ (a & c) ^ (b & c);
+                h = g;
+                g = f;
+                f = e;
+                e = d +% t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 +% s0 +% maj;
+            }
+
+            state[0] +%= a;
+            state[1] +%= b;
+            state[2] +%= c;
+            state[3] +%= d;
+            state[4] +%= e;
+            state[5] +%= f;
+            state[6] +%= g;
+            state[7] +%= h;
+        }
+
+        /// Hash up to L messages; digests[j] = SHA-256(msgs[j]).
+        fn hash(msgs: []const []const u8, digests: [][32]u8) void {
+            std.debug.assert(msgs.len <= L and digests.len == msgs.len);
+
+            var nblocks = [_]usize{0} ** L;
+            var max_blocks: usize = 0;
+            for (msgs, 0..) |m, j| {
+                nblocks[j] = paddedBlocks(m.len);
+                max_blocks = @max(max_blocks, nblocks[j]);
+            }
+
+            var state: [8]V = undefined;
+            for (&state, SHA256_IV) |*s, iv| s.* = @splat(iv);
+
+            var blk: usize = 0;
+            while (blk < max_blocks) : (blk += 1) {
+                // Transpose: word t of every active lane's block into one vector
+                var words: [16][L]u32 = std.mem.zeroes([16][L]u32);
+                var active = [_]bool{false} ** L;
+                for (msgs, 0..) |m, j| {
+                    if (blk >= nblocks[j]) continue;
+                    var bytes: [64]u8 = undefined;
+                    paddedBlock(m, blk, nblocks[j], &bytes);
+                    for (0..16) |t| words[t][j] = std.mem.readInt(u32, bytes[t * 4 ..][0..4], .big);
+                    active[j] = true;
+                }
+
+                var block: [16]V = undefined;
+                for (&block, words) |*v, lane_words| v.* = lane_words;
+
+                var next = state;
+                compress(&next, &block);
+                const mask: @Vector(L, bool) = active;
+                for (&state, next) |*s, n| s.* = @select(u32, mask, n, s.*);
+            }
+
+            for (0..8) |i| {
+                const lane_words: [L]u32 = state[i];
+                for (digests, 0..) |*d, j| std.mem.writeInt(u32, d[i * 4 ..][0..4], lane_words[j], .big);
+            }
+        }
+    };
+}
+
+/// Number of 64-byte blocks after SHA-256 padding (0x80, zeros, 64-bit length).
+fn paddedBlocks(len: usize) usize {
+    return (len + 9 + 63) / 64;
+}
 
-/// Batch SHA-256: compute digests for multiple files simultaneously.
-/// Uses Zig's built-in SHA-256 (which auto-detects SHA-NI/ARM-SHA2).
-/// For AVX2 multi-buffer, processes MULTI_BUFFER_LANES files at once
-/// by interleaving reads and hash updates.
+/// Materialise block `blk` of the padded message without copying the rest.
+fn paddedBlock(msg: []const u8, blk: usize, nblocks: usize, out: *[64]u8) void {
+    const off = blk * 64;
+    if (off + 64 <= msg.len) {
+        out.* = msg[off..][0..64].*;
+        return;
+    }
+    @memset(out, 0);
+    if (off < msg.len) @memcpy(out[0 .. msg.len - off], msg[off..]);
+    if (msg.len >= off and msg.len < off + 64) out[msg.len - off] = 0x80;
+    if (blk + 1 == nblocks) std.mem.writeInt(u64, out[56..64], @as(u64, msg.len) * 8, .big);
+}
+
+/// Hash one group of at most `lanes` messages with the matching kernel.
+fn sha256Group(lanes: usize, msgs: []const []const u8, digests: [][32]u8) void {
+    if (msgs.len > 1) switch (lanes) {
+        16 => return Lanes(16).hash(msgs, digests),
+        8 => return Lanes(8).hash(msgs, digests),
+        else => {},
+    };
+    for (msgs, digests) |m, *d| std.crypto.hash.sha2.Sha256.hash(m, d, .{});
+}
+
+/// Hash several independent in-memory messages (conduit batch: files that
+/// fit in one read buffer are collected and hashed together here).
+/// Multi-buffer hosts hash MAX_LANES-or-fewer messages per vector pass;
+/// dedicated-instruction and software hosts hash them one by one.
+pub fn sha256Many(msgs: []const []const u8, digests: [][32]u8) void {
+    const lanes: usize = activeCaps().sha256_lanes;
+    var i: usize = 0;
+    while (i < msgs.len) : (i += lanes) {
+        const end = @min(i + lanes, msgs.len);
+        sha256Group(lanes, msgs[i..end], digests[i..end]);
+    }
+}
+
+/// Batch SHA-256: compute digests for multiple files.
+/// Multi-buffer tier: small files are read whole and hashed in lanes.
+/// Otherwise: files are streamed with large reads, the next file's
+/// readahead overlapping the current file's hash.
 ///
 /// paths: array of N null-terminated file paths
 /// digests: output array of N * 32-byte raw digests
@@ -154,63 +369,143 @@ fn batchSha256(
     digests: [*][32]u8,
     count: u32,
 ) u32 {
+    if (count == 0) return 0;
+    const lanes: usize = activeCaps().sha256_lanes;
+    if (lanes > 1) {
+        if (batchSha256Lanes(paths, digests, count, lanes)) |n| return n;
+    }
+    return batchSha256Stream(paths, digests, count);
+}
+
+/// Stream every file through Sha256 with STREAM_READ_SIZE reads. Each file
+/// is opened (and its readahead requested) one step ahead of its hash.
+fn batchSha256Stream(
+    paths: [*]const [*:0]const u8,
+    digests: [*][32]u8,
+    count: u32,
+) u32 {
+    var fallback: [64 * 1024]u8 = undefined;
+    const heap_buf = std.heap.c_allocator.alloc(u8, STREAM_READ_SIZE) catch null;
+    defer if (heap_buf) |b| std.heap.c_allocator.free(b);
+    const buf = heap_buf orelse fallback[0..];
+
     var success: u32 = 0;
+    var next = openWithReadahead(paths[0]);
+    for (0..count) |i| {
+        const cur = next;
+        next = if (i + 1 < count) openWithReadahead(paths[i + 1]) else null;
+        const file = cur orelse continue;
+        defer file.close();
+        if (hashFile(file, buf, &.{}, &digests[i])) success += 1;
+    }
+    return success;
+}
 
-    // Process in groups of MULTI_BUFFER_LANES for better cache utilisation
-    var base: u32 = 0;
-    while (base < count) : (base += MULTI_BUFFER_LANES) {
-        const batch_end = @min(base + MULTI_BUFFER_LANES, count);
-        const batch_size = batch_end - base;
-
-        // Open all files in this mini-batch
-        var files: [MULTI_BUFFER_LANES]?std.fs.File = .{ null, null, null, null };
-        var hashers: [MULTI_BUFFER_LANES]std.crypto.hash.sha2.Sha256 = undefined;
-        var active: [MULTI_BUFFER_LANES]bool = .{ false, false, false, false };
-
-        for (0..batch_size) |i| {
-            const path_str = std.mem.span(paths[base + i]);
-            files[i] = std.fs.openFileAbsolute(path_str, .{}) catch null;
-            if (files[i] != null) {
-                hashers[i] = std.crypto.hash.sha2.Sha256.init(.{});
-                active[i] = true;
-            }
+/// Multi-buffer batch. Returns null if the working buffers cannot be
+/// allocated (the caller falls back to streaming).
+fn batchSha256Lanes(
+    paths: [*]const [*:0]const u8,
+    digests: [*][32]u8,
+    count: u32,
+    lanes: usize,
+) ?u32 {
+    const allocator = std.heap.c_allocator;
+    // One extra byte per slot detects a file that grew past SMALL_FILE_MAX
+    const slot_size = SMALL_FILE_MAX + 1;
+
+    const sizes = allocator.alloc(u64, count) catch return null;
+    defer allocator.free(sizes);
+    const order = allocator.alloc(u32, count) catch return null;
+    defer allocator.free(order);
+    const slots = allocator.alloc(u8, @max(lanes * slot_size, STREAM_READ_SIZE)) catch return null;
+    defer allocator.free(slots);
+
+    // Partition: small files to the front, everything else to the back
+    var n_small: usize = 0;
+    var n_large: usize = 0;
+    for (0..count) |i| {
+        const st = std.fs.cwd().statFile(std.mem.span(paths[i])) catch null;
+        sizes[i] = if (st) |s| s.size else std.math.maxInt(u64);
+        if (sizes[i] <= SMALL_FILE_MAX) {
+            order[n_small] = @intCast(i);
+            n_small += 1;
+        } else {
+            n_large += 1;
+            order[count - n_large] = @intCast(i);
+        }
+    }
+
+    // Similar sizes share a group so its lanes run out of blocks together
+    const BySize = struct {
+        fn lessThan(s: []const u64, a: u32, b: u32) bool {
+            return s[a] < s[b];
         }
+    };
+    std.mem.sort(u32, order[0..n_small], @as([]const u64, sizes), BySize.lessThan);
 
-        // Interleaved read-and-hash loop
-        // By reading from multiple files, we overlap I/O wait with
-        // SHA-256 computation on the previously-read buffer.
-        var bufs: [MULTI_BUFFER_LANES][8192]u8 = undefined;
-        var any_active = true;
-
-        while (any_active) {
-            any_active = false;
-            for (0..batch_size) |i| {
-                if (!active[i]) continue;
-                const n = files[i].?.read(&bufs[i]) catch {
-                    active[i] = false;
-                    continue;
-                };
-                if (n == 0) {
-                    // File complete — finalise
-                    digests[base + i] = hashers[i].finalResult();
-                    success += 1;
-                    active[i] = false;
-                } else {
-                    hashers[i].update(bufs[i][0..n]);
-                    any_active = true;
-                }
+    var success: u32 = 0;
+    var g: usize = 0;
+    while (g < n_small) : (g += lanes) {
+        var msgs: [MAX_LANES][]const u8 = undefined;
+        var dest: [MAX_LANES]u32 = undefined;
+        var k: usize = 0;
+        for (order[g..@min(g + lanes, n_small)]) |idx| {
+            const slot = slots[k * slot_size ..][0..slot_size];
+            const file = std.fs.openFileAbsoluteZ(paths[idx], .{}) catch continue;
+            defer file.close();
+            const n = file.readAll(slot) catch continue;
+            if (n == slot_size) {
+                // Grew since stat: finish it as a stream instead of a lane
+                if (hashFile(file, slot, slot[0..n], &digests[idx])) success += 1;
+                continue;
             }
+            msgs[k] = slot[0..n];
+            dest[k] = idx;
+            k += 1;
         }
 
-        // Close all files in this mini-batch
-        for (0..batch_size) |i| {
-            if (files[i]) |f| f.close();
-        }
+        var out: [MAX_LANES][32]u8 = undefined;
+        sha256Group(lanes, msgs[0..k], out[0..k]);
+        for (dest[0..k], out[0..k]) |idx, d| digests[idx] = d;
+        success += @intCast(k);
+    }
+
+    // Large (and unstat-able) files: one at a time through the slot memory
+    for (order[count - n_large .. count]) |idx| {
+        const file = openWithReadahead(paths[idx]) orelse continue;
+        defer file.close();
+        if (hashFile(file, slots, &.{}, &digests[idx])) success += 1;
     }
 
     return success;
 }
 
+/// Open a file for hashing and ask the kernel to start reading it.
+fn openWithReadahead(path: [*:0]const u8) ?std.fs.File {
+    const file = std.fs.openFileAbsoluteZ(path, .{}) catch return null;
+    if (builtin.os.tag == .linux) {
+        // POSIX_FADV_SEQUENTIAL = 2 (larger readahead window),
+        // POSIX_FADV_WILLNEED = 3 (start reading now)
+        _ = std.os.linux.fadvise(file.handle, 0, 0, 2);
+        _ = std.os.linux.fadvise(file.handle, 0, @intCast(READAHEAD_SIZE), 3);
+    }
+    return file;
+}
+
+/// Hash `prefix` (bytes already read) followed by the rest of `file`,
+/// reading into `buf`. Returns false on a read error.
+fn hashFile(file: std.fs.File, buf: []u8, prefix: []const u8, out: *[32]u8) bool {
+    var hasher = std.crypto.hash.sha2.Sha256.init(.{});
+    hasher.update(prefix);
+    while (true) {
+        const n = file.read(buf) catch return false;
+        if (n == 0) break;
+        hasher.update(buf[0..n]);
+    }
+    out.* = hasher.finalResult();
+    return true;
+}
+
 /// Convert raw 32-byte digest to 64-char hex string + null
 fn digestToHex(digest: [32]u8, out: *[65]u8) void {
     const hex_chars = "0123456789abcdef";
@@ -232,22 +527,24 @@ export fn ddac_crypto_detect(caps_out: *CryptoCapabilities) void {
 }
 
 /// Get the SHA-256 acceleration tier.
-/// Returns: 0=SHA-NI/ARM-SHA2, 1=AVX2 multi-buffer, 2=software
+/// Returns: 0=SHA-NI/ARM-SHA2, 1=AVX-512/AVX2 multi-buffer, 2=software
 export fn ddac_crypto_sha256_tier() u8 {
-    const caps = detectCapabilities();
-    return caps.sha256_tier;
+    return activeCaps().sha256_tier;
 }
 
 /// Get human-readable name for the SHA-256 backend.
 /// Returns a null-terminated static string.
 export fn ddac_crypto_sha256_name() [*:0]const u8 {
-    const caps = detectCapabilities();
+    const caps = activeCaps();
     return switch (caps.sha256_tier) {
         0 => if (caps.has_sha_ni == 1)
             "SHA-NI (x86-64 dedicated instructions)"
         else
             "ARM SHA2 (AArch64 crypto extension)",
-        1 => "AVX2 multi-buffer (4 lanes)",
+        1 => if (caps.sha256_lanes == 16)
+            "AVX-512 multi-buffer (16 lanes)"
+        else
+            "AVX2 multi-buffer (8 lanes)",
         else => "Software (Zig std, loop-unrolled)",
     };
 }
@@ -262,7 +559,7 @@ export fn ddac_crypto_batch_sha256(
     hex_out: [*][65]u8,
     count: u32,
 ) u32 {
-    // Allocate temp raw digest array on stack (32 * count, max ~4KB for 128 files)
+    // Allocate temp raw digest array on stack (32 * count, max 32KB)
     if (count > 1024) return 0; // Safety limit
 
     var raw_digests: [1024][32]u8 = undefined;
@@ -280,3 +577,47 @@ export fn ddac_crypto_batch_sha256(
 export fn ddac_crypto_caps_size() usize {
     return @sizeOf(CryptoCapabilities);
 }
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "lane kernels match std sha256" {
+    var data: [3000]u8 = undefined;
+    for (&data, 0..) |*b, i| b.* = @truncate(i *% 31 +% 7);
+
+    // Padding edges (55/56, 63/64, 119/120) and mixed lengths in one pass
+    const lens = [_]usize{ 0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 1000, 2999, 3000, 3, 191 };
+    var msgs: [lens.len][]const u8 = undefined;
+    var want: [lens.len][32]u8 = undefined;
+    for (lens, 0..) |l, i| {
+        msgs[i] = data[0..l];
+        std.crypto.hash.sha2.Sha256.hash(msgs[i], &want[i], .{});
+    }
+
+    inline for (.{ 8, 16 }) |L| {
+        var got: [lens.len][32]u8 = undefined;
+        var i: usize = 0;
+        while (i < lens.len) : (i += L) Lanes(L).hash(msgs[i..][0..L], got[i..][0..L]);
+        for (want, got) |w, g| try std.testing.expectEqualSlices(u8, &w, &g);
+
+        // Partially filled group
+        Lanes(L).hash(msgs[0..3], got[0..3]);
+        for (want[0..3], got[0..3]) |w, g| try std.testing.expectEqualSlices(u8, &w, &g);
+    }
+}
+
+test "sha256Many matches std sha256 on this host" {
+    var data: [200]u8 = undefined;
+    for (&data, 0..) |*b, i| b.* = @truncate(i);
+    var msgs: [20][]const u8 = undefined;
+    for (&msgs, 0..) |*m, i| m.* = data[0 .. i * 10];
+
+    var got: [20][32]u8 = undefined;
+    sha256Many(&msgs, &got);
+    for (msgs, got) |m, g| {
+        var w: [32]u8 = undefined;
+        std.crypto.hash.sha2.Sha256.hash(m, &w, .{});
+        try std.testing.expectEqualSlices(u8, &w, &g);
+    }
+}
@@ -0,0 +1,414 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Isolated Parse Workers
+//
+// Runs ddac_parse_ex() in a pool of helper processes (ddac-parse-worker,
+// built from parse_worker.zig) so that a parser stuck in a loop can be
+// stopped at its deadline and a parser crash costs one document, not the
+// locale.
+//
+// Each worker owns a shared-memory slot (a file in /dev/shm, mapped by
+// both sides) holding the request paths, stage flags, the conduit result,
+// the near-duplicate verdict and the ddac_parse_result_t the worker
+// writes back. The worker's stdin
+// and stdout pipes are the doorbells: one byte per request, one per
+// completed parse. The worker moves the library's own stdout chatter to
+// stderr so nothing else reaches the doorbell.
+//
+//   - A parse that passes its deadline: the worker is SIGKILLed and
+//     ddac_isolate_parse() returns 1 with a ParseError result.
+//   - A worker that dies mid-parse (signal, abort): returns 2.
+// Either way a replacement is spawned at once and initialises its
+// libraries (ddac_init) while it waits for its next request, so the next
+// document gets a warm worker; a worker's deadline only starts once it has
+// reported ready.
+//
+// Writing to a dead worker's pipe must not kill the locale, so creating a
+// pool ignores SIGPIPE process-wide.
+
+const std = @import("std");
+const ffi = @import("docudactyl_ffi.zig");
+const conduit = @import("conduit.zig");
+const neardup = @import("neardup.zig");
+const ParseResult = ffi.ParseResult;
+
+// ============================================================================
+// Shared Slot
+// ============================================================================
+
+const PATH_CAP: usize = 4096;
+/// Time a fresh worker gets to load its libraries and report ready
+const STARTUP_TIMEOUT_MS: i64 = 120_000;
+
+const Slot = extern struct {
+    input: [PATH_CAP]u8,
+    output: [PATH_CAP]u8,
+    stage_flags: u64,
+    output_fmt: c_int,
+    has_conduit: u32,
+    has_neardup: u32,
+    conduit: conduit.ConduitResult,
+    neardup: neardup.Verdict,
+    result: ParseResult,
+};
+
+const READY: u8 = 'R';
+const REQUEST: u8 = 'P';
+const DONE: u8 = 'D';
+
+// ============================================================================
+// Parent Side
+// ============================================================================
+
+const Worker = struct {
+    child: ?std.process.Child = null,
+    /// Worker has sent READY since it was spawned
+    ready: bool = false,
+    slot_path: [:0]u8,
+    map: []align(std.heap.page_size_min) u8,
+
+    fn slot(self: *Worker) *Slot {
+        // SAFETY: map is a page-aligned mapping of @sizeOf(Slot) bytes, so it holds a suitably aligned Slot
+        return @ptrCast(@alignCast(self.map.ptr));
+    }
+};
+
+const Pool = struct {
+    allocator: std.mem.Allocator,
+    worker_path: [:0]u8,
+    workers: []Worker,
+
+    mutex: std.Thread.Mutex = .{},
+    cond: std.Thread.Condition = .{},
+    /// Indices of workers not serving a parse (under mutex)
+    idle: std.ArrayList(usize) = .empty,
+    /// Workers that could not be respawned (under mutex)
+    lost: usize = 0,
+
+    timeouts: std.atomic.Value(u64) = .init(0),
+    crashes: std.atomic.Value(u64) = .init(0),
+    respawns: std.atomic.Value(u64) = .init(0),
+
+    fn spawn(self: *Pool, w: *Worker) bool {
+        const argv = [_][]const u8{ self.worker_path, w.slot_path };
+        var child = std.process.Child.init(&argv, self.allocator);
+        child.stdin_behavior = .Pipe;
+        child.stdout_behavior = .Pipe;
+        child.stderr_behavior = .Inherit;
+        child.spawn() catch return false;
+        w.child = child;
+        w.ready = false;
+        return true;
+    }
+
+    /// Kill (if still running) and reap a worker, then start its replacement.
+    fn replace(self: *Pool, w: *Worker) void {
+        if (w.child) |*child| {
+            std.posix.kill(child.id, std.posix.SIG.KILL) catch {};
+            _ = child.wait() catch {};
+            w.child = null;
+        }
+        if (self.spawn(w)) {
+            _ = self.respawns.fetchAdd(1, .monotonic);
+        }
+    }
+
+    fn acquire(self: *Pool) ?usize {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (self.idle.items.len == 0) {
+            if (self.lost == self.workers.len) return null;
+            self.cond.wait(&self.mutex);
+        }
+        return self.idle.pop();
+    }
+
+    fn release(self: *Pool, i: usize) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (self.workers[i].child == null) {
+            self.lost += 1;
+            self.cond.broadcast();
+            return;
+        }
+        self.idle.appendAssumeCapacity(i);
+        self.cond.signal();
+    }
+};
+
+const Wait = enum { byte, timeout, dead };
+
+/// Wait up to timeout_ms for one doorbell byte equal to `want`.
+fn waitFor(child: *std.process.Child, want: u8, timeout_ms: i64) Wait {
+    const out = child.stdout orelse return .dead;
+    const deadline = std.time.milliTimestamp() + timeout_ms;
+    while (true) {
+        const remaining = deadline - std.time.milliTimestamp();
+        if (remaining <= 0) return .timeout;
+        var fds = [_]std.posix.pollfd{.{ .fd = out.handle, .events = std.posix.POLL.IN, .revents = 0 }};
+        const n = std.posix.poll(&fds, @intCast(@min(remaining, std.math.maxInt(i32)))) catch return .dead;
+        if (n == 0) continue;
+        var b: [1]u8 = undefined;
+        const got = std.posix.read(out.handle, &b) catch return .dead;
+        if (got == 0) return .dead;
+        if (b[0] == want) return .byte;
+    }
+}
+
+fn failResult(comptime fmt: []const u8, args: anytype) ParseResult {
+    var r = std.mem.zeroes(ParseResult);
+    r.status = 3; // ParseError
+    _ = std.fmt.bufPrintZ(&r.error_msg, fmt, args) catch {};
+    return r;
+}
+
+fn copyPath(dest: *[PATH_CAP]u8, src: ?[*:0]const u8) bool {
+    const s = std.mem.span(src orelse "");
+    if (s.len >= PATH_CAP) return false;
+    @memcpy(dest[0..s.len], s);
+    dest[s.len] = 0;
+    return true;
+}
+
+// ============================================================================
+// C-ABI Exports
+// ============================================================================
+
+/// Start `workers` ddac-parse-worker processes from worker_path (a path,
+/// or a name looked up on PATH). Returns null if none could be started.
+export fn ddac_isolate_create(worker_path: [*:0]const u8, workers: u32) ?*anyopaque {
+    const pool = createImpl(worker_path, @max(workers, 1)) catch return null;
+    // SAFETY: pool was just allocated by c_allocator.create(Pool), which returns a well-aligned *Pool
+    return @ptrCast(pool);
+}
+
+fn createImpl(worker_path: [*:0]const u8, n: u32) !*Pool {
+    const allocator = std.heap.c_allocator;
+
+    const ignore = std.posix.Sigaction{
+        .handler = .{ .handler = std.posix.SIG.IGN },
+        .mask = std.posix.sigemptyset(),
+        .flags = 0,
+    };
+    std.posix.sigaction(std.posix.SIG.PIPE, &ignore, null);
+
+    const pool = try allocator.create(Pool);
+    errdefer allocator.destroy(pool);
+    pool.* = .{
+        .allocator = allocator,
+        .worker_path = try allocator.dupeZ(u8, std.mem.span(worker_path)),
+        .workers = &.{},
+    };
+    errdefer allocator.free(pool.worker_path);
+    try pool.idle.ensureTotalCapacity(allocator, n);
+    errdefer pool.idle.deinit(allocator);
+
+    var workers: std.ArrayList(Worker) = .empty;
+    errdefer {
+        for (workers.items) |*w| destroyWorker(pool, w);
+        workers.deinit(allocator);
+    }
+    try workers.ensureTotalCapacity(allocator, n);
+
+    const shm_dir = if (std.fs.accessAbsolute("/dev/shm", .{})) |_| "/dev/shm" else |_| "/tmp";
+    const pid = std.c.getpid();
+    for (0..n) |i| {
+        const slot_path = try std.fmt.allocPrintSentinel(allocator, "{s}/ddac-isolate-{d}-{x}-{d}", .{ shm_dir, pid, @intFromPtr(pool), i }, 0);
+        const file = std.fs.createFileAbsoluteZ(slot_path, .{ .read = true, .exclusive = true, .mode = 0o600 }) catch {
+            allocator.free(slot_path);
+            continue;
+        };
+        defer file.close();
+        file.setEndPos(@sizeOf(Slot)) catch {
+            std.fs.deleteFileAbsoluteZ(slot_path) catch {};
+            allocator.free(slot_path);
+            continue;
+        };
+        const map = std.posix.mmap(null, @sizeOf(Slot), std.posix.PROT.READ | std.posix.PROT.WRITE, .{ .TYPE = .SHARED }, file.handle, 0) catch {
+            std.fs.deleteFileAbsoluteZ(slot_path) catch {};
+            allocator.free(slot_path);
+            continue;
+        };
+        var w = Worker{ .slot_path = slot_path, .map = map };
+        if (!pool.spawn(&w)) {
+            destroyWorker(pool, &w);
+            continue;
+        }
+        workers.appendAssumeCapacity(w);
+    }
+    if (workers.items.len == 0) return error.NoWorkers;
+
+    pool.workers = try workers.toOwnedSlice(allocator);
+    for (0..pool.workers.len) |i| pool.idle.appendAssumeCapacity(i);
+    return pool;
+}
+
+fn destroyWorker(pool: *Pool, w: *Worker) void {
+    if (w.child) |*child| {
+        // Closing stdin asks the worker to exit; a stuck one is killed
+        if (child.stdin) |f| f.close();
+        child.stdin = null;
+        if (waitFor(child, 0, 2000) != .dead) std.posix.kill(child.id, std.posix.SIG.KILL) catch {};
+        _ = child.wait() catch {};
+        w.child = null;
+    }
+    std.posix.munmap(w.map);
+    std.fs.deleteFileAbsoluteZ(w.slot_path) catch {};
+    pool.allocator.free(w.slot_path);
+}
+
+/// Parse one document in a worker process, killing it if the parse runs
+/// past timeout_ms (0 = no deadline). Blocks while every worker is busy.
+/// Returns 0 with the worker's result in *result_out; 1 if the parse hit
+/// the deadline or 2 if the worker died (*result_out = ParseError, and the
+/// worker is replaced); -1 if the pool has no workers left or the paths do
+/// not fit the slot (*result_out untouched — parse in-process instead).
+export fn ddac_isolate_parse(
+    pool_handle: ?*anyopaque,
+    input_path: ?[*:0]const u8,
+    output_path: ?[*:0]const u8,
+    output_fmt: c_int,
+    stage_flags: u64,
+    conduit_result: ?*const conduit.ConduitResult,
+    neardup_verdict: ?*const neardup.Verdict,
+    timeout_ms: u32,
+    result_out: *ParseResult,
+) i32 {
+    const ptr = pool_handle orelse return -1;
+    // SAFETY: ptr originates from ddac_isolate_create() which returns a *Pool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *Pool = @ptrCast(@alignCast(ptr));
+
+    const i = pool.acquire() orelse return -1;
+    defer pool.release(i);
+    const w = &pool.workers[i];
+    const slot = w.slot();
+
+    if (!copyPath(&slot.input, input_path) or !copyPath(&slot.output, output_path)) return -1;
+    slot.stage_flags = stage_flags;
+    slot.output_fmt = output_fmt;
+    slot.has_conduit = @intFromBool(conduit_result != null);
+    if (conduit_result) |c| slot.conduit = c.*;
+    slot.has_neardup = @intFromBool(neardup_verdict != null);
+    if (neardup_verdict) |v| slot.neardup = v.*;
+
+    if (w.child == null) return -1;
+    const child = &w.child.?;
+    if (!w.ready) {
+        if (waitFor(child, READY, STARTUP_TIMEOUT_MS) != .byte) {
+            pool.replace(w);
+            return -1;
+        }
+        w.ready = true;
+    }
+
+    const stdin = child.stdin orelse return -1;
+    stdin.writeAll(&[_]u8{REQUEST}) catch {
+        _ = pool.crashes.fetchAdd(1, .monotonic);
+        pool.replace(w);
+        result_out.* = failResult("parse worker exited before the request", .{});
+        return 2;
+    };
+
+    const deadline: i64 = if (timeout_ms == 0) std.math.maxInt(i32) else timeout_ms;
+    while (true) {
+        switch (waitFor(child, DONE, deadline)) {
+            .byte => {
+                result_out.* = slot.result;
+                return 0;
+            },
+            .timeout => {
+                if (timeout_ms == 0) continue;
+                _ = pool.timeouts.fetchAdd(1, .monotonic);
+                pool.replace(w);
+                result_out.* = failResult("parse killed at the {d} ms deadline", .{timeout_ms});
+                return 1;
+            },
+            .dead => {
+                _ = pool.crashes.fetchAdd(1, .monotonic);
+                const term = child.wait() catch std.process.Child.Term{ .Unknown = 0 };
+                w.child = null;
+                pool.replace(w);
+                result_out.* = switch (term) {
+                    .Signal => |sig| failResult("parse worker killed by signal {d}", .{sig}),
+                    .Exited => |code| failResult("parse worker exited with status {d}", .{code}),
+                    else => failResult("parse worker died", .{}),
+                };
+                return 2;
+            },
+        }
+    }
+}
+
+/// Pool counters: parses killed at the deadline, worker crashes, respawns.
+export fn ddac_isolate_stats(pool_handle: ?*anyopaque, timeouts: *u64, crashes: *u64, respawns: *u64) void {
+    timeouts.* = 0;
+    crashes.* = 0;
+    respawns.* = 0;
+    const ptr = pool_handle orelse return;
+    // SAFETY: ptr originates from ddac_isolate_create() which returns a *Pool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *Pool = @ptrCast(@alignCast(ptr));
+    timeouts.* = pool.timeouts.load(.monotonic);
+    crashes.* = pool.crashes.load(.monotonic);
+    respawns.* = pool.respawns.load(.monotonic);
+}
+
+/// Stop every worker and remove their slots. No parse may be in flight.
+/// Safe to call with null.
+export fn ddac_isolate_free(pool_handle: ?*anyopaque) void {
+    const ptr = pool_handle orelse return;
+    // SAFETY: ptr originates from ddac_isolate_create() which returns a *Pool via @ptrCast; alignment is guaranteed by c_allocator
+    const pool: *Pool = @ptrCast(@alignCast(ptr));
+    const allocator = pool.allocator;
+    for (pool.workers) |*w| destroyWorker(pool, w);
+    allocator.free(pool.workers);
+    pool.idle.deinit(allocator);
+    allocator.free(pool.worker_path);
+    allocator.destroy(pool);
+}
+
+// ============================================================================
+// Worker Side (ddac-parse-worker)
+// ============================================================================
+
+/// Entry point of the worker process: `ddac-parse-worker <slot-path>`.
+/// Serves requests from stdin until the pool closes it.
+pub fn workerMain() !void {
+    var args = std.process.args();
+    _ = args.skip();
+    const slot_path = args.next() orelse return error.MissingSlotPath;
+
+    const file = try std.fs.cwd().openFile(slot_path, .{ .mode = .read_write });
+    const map = try std.posix.mmap(null, @sizeOf(Slot), std.posix.PROT.READ | std.posix.PROT.WRITE, .{ .TYPE = .SHARED }, file.handle, 0);
+    file.close();
+    // SAFETY: map is a page-aligned mapping of @sizeOf(Slot) bytes, so it holds a suitably aligned Slot
+    const slot: *Slot = @ptrCast(@alignCast(map.ptr));
+
+    // Keep the doorbell on a private copy of stdout; the parsers' own
+    // output goes to stderr
+    const bell = try std.posix.dup(std.posix.STDOUT_FILENO);
+    try std.posix.dup2(std.posix.STDERR_FILENO, std.posix.STDOUT_FILENO);
+
+    const handle = ffi.ddac_init() orelse return error.InitFailed;
+    defer ffi.ddac_free(handle);
+    _ = try std.posix.write(bell, &[_]u8{READY});
+
+    var cmd: [1]u8 = undefined;
+    while (true) {
+        const n = std.posix.read(std.posix.STDIN_FILENO, &cmd) catch return;
+        if (n == 0) return; // pool closed the pipe
+        const pre: ?*const conduit.ConduitResult = if (slot.has_conduit != 0) &slot.conduit else null;
+        ffi.ddac_set_neardup_verdict(handle, if (slot.has_neardup != 0) &slot.neardup else null);
+        slot.result = ffi.ddac_parse_ex(
+            handle,
+            // SAFETY: the parent NUL-terminates both paths inside their PATH_CAP buffers (copyPath)
+            @ptrCast(&slot.input),
+            // SAFETY: as above
+            @ptrCast(&slot.output),
+            slot.output_fmt,
+            slot.stage_flags,
+            pre,
+            null,
+        );
+        _ = try std.posix.write(bell, &[_]u8{DONE});
+    }
+}
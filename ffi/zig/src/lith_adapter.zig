@@ -17,65 +17,66 @@ const stages = @import("stages.zig");
 // Cap'n Proto Reader — Zero-Copy Struct Access
 // ============================================================================
 //
-// Reads fields directly from a Cap'n Proto single-segment message buffer.
-// The message format is: 8-byte header + root struct pointer + data + pointers.
+// Reads fields directly from an unpacked Cap'n Proto message buffer. The
+// message format is: segment table + segments, with the root struct pointer,
+// data and pointers at the start of segment 0. Objects in later segments are
+// reached through single-far pointers (what capnp.Builder writes).
+
+/// A list found through a pointer: its segment, byte offset and count.
+const ListRef = struct {
+    seg: usize,
+    base: usize,
+    count: usize,
+};
 
 /// Reads a StageResults struct from a raw Cap'n Proto message buffer.
-/// The buffer includes the 8-byte segment header followed by the segment data.
+/// The buffer includes the segment table followed by the segment data.
 pub const Reader = struct {
-    /// Pointer to the start of the segment data (after the 8-byte message header).
-    seg: [*]const u8,
-    /// Length of the segment in bytes.
-    seg_len: usize,
-    /// Byte offset of the root struct's data section within the segment.
+    /// Segments of the message (views into the caller's buffer).
+    segs: [capnp.MAX_SEGMENTS][]const u8,
+    /// Number of segments.
+    seg_count: usize,
+    /// Byte offset of the root struct's data section within segment 0.
     data_start: usize,
-    /// Byte offset of the root struct's pointer section within the segment.
+    /// Byte offset of the root struct's pointer section within segment 0.
     ptr_start: usize,
 
-    /// Initialise a reader from a complete Cap'n Proto message buffer
-    /// (8-byte header + segment data).
+    /// Initialise a reader from a complete, unpacked Cap'n Proto message
+    /// buffer. Packed messages (capnp.isPacked) must be expanded first with
+    /// capnp.unpackAppend.
     ///
-    /// Returns null if the buffer is too small or the root pointer is invalid.
+    /// Returns null if the buffer is too small or the segment table is invalid.
     pub fn init(msg: []const u8) ?Reader {
         // Minimum: 8 header + 8 root ptr + at least one data word
-        if (msg.len < 24) return null;
+        if (msg.len < 24 or capnp.isPacked(msg)) return null;
 
-        // Skip 8-byte message header (segment count + segment size).
-        const seg = msg.ptr + 8;
-        const seg_len = msg.len - 8;
+        var r: Reader = undefined;
+        const segs = capnp.segmentTable(msg, &r.segs) orelse return null;
+        r.seg_count = segs.len;
 
         // Root struct pointer is at segment word 0.
         // For StageResults the root pointer has offset=0 (struct starts at word 1).
         // Data section starts immediately after the root pointer word.
-        const data_start: usize = 8; // word 1 of segment
-        const ptr_start: usize = data_start + @as(usize, capnp.DATA_WORDS) * 8;
-
-        // Sanity: the pointer section must fit within the segment.
-        const min_size = ptr_start + @as(usize, capnp.PTR_WORDS) * 8;
-        if (seg_len < min_size) return null;
-
-        return .{
-            .seg = seg,
-            .seg_len = seg_len,
-            .data_start = data_start,
-            .ptr_start = ptr_start,
-        };
+        r.data_start = 8; // word 1 of segment 0
+        r.ptr_start = r.data_start + @as(usize, capnp.DATA_WORDS) * 8;
+
+        // Sanity: the pointer section must fit within segment 0.
+        const min_size = r.ptr_start + @as(usize, capnp.PTR_WORDS) * 8;
+        if (segs[0].len < min_size) return null;
+
+        return r;
     }
 
     // ── Data section readers ────────────────────────────────────────────
 
     pub fn readU64(self: Reader, off: usize) u64 {
-        const abs = self.data_start + off;
-        if (abs + 8 > self.seg_len) return 0;
-        // SAFETY: bounds check on line above ensures abs + 8 <= seg_len; seg is a valid segment pointer from Reader.init
-        return std.mem.readInt(u64, @as(*const [8]u8, @ptrCast(self.seg + abs)), .little);
+        return self.word(0, self.data_start + off) orelse 0;
     }
 
     pub fn readU32(self: Reader, off: usize) u32 {
         const abs = self.data_start + off;
-        if (abs + 4 > self.seg_len) return 0;
-        // SAFETY: bounds check on line above ensures abs + 4 <= seg_len; seg is a valid segment pointer from Reader.init
-        return std.mem.readInt(u32, @as(*const [4]u8, @ptrCast(self.seg + abs)), .little);
+        if (abs + 4 > self.segs[0].len) return 0;
+        return std.mem.readInt(u32, self.segs[0][abs..][0..4], .little);
     }
 
     pub fn readI32(self: Reader, off: usize) i32 {
@@ -91,88 +92,76 @@ pub const Reader = struct {
     /// Read a Text field from a pointer slot. Returns the text bytes (without
     /// the null terminator) or an empty slice if the pointer is null/invalid.
     pub fn readText(self: Reader, ptr_idx: usize) []const u8 {
-        const ptr_off = self.ptr_start + ptr_idx * 8;
-        if (ptr_off + 8 > self.seg_len) return &.{};
-
-        // SAFETY: bounds check on line 94 ensures ptr_off + 8 <= seg_len; seg is a valid Cap'n Proto segment pointer
-        const raw = std.mem.readInt(u64, @as(*const [8]u8, @ptrCast(self.seg + ptr_off)), .little);
-
-        // Null pointer check.
-        if (raw == 0) return &.{};
-
-        // Decode list pointer: bits 0-1 must be 1 (list type).
-        if (raw & 3 != 1) return &.{};
-
-        // Offset (signed, in words) from pointer+1 to list data.
-        const offset_raw: i32 = @bitCast(@as(u32, @truncate(raw >> 2)));
-        const ptr_word = ptr_off / 8;
-        const target_word: usize = @intCast(@as(i64, @intCast(ptr_word)) + 1 + @as(i64, offset_raw));
-        const target_off = target_word * 8;
-
-        // Element size (bits 32-34) must be 2 (byte list) for Text.
-        const elem_size: u3 = @truncate(@as(u32, @truncate(raw >> 32)));
-        if (elem_size != 2) return &.{};
-
-        // Count includes null terminator.
-        const count: u29 = @truncate(@as(u32, @truncate(raw >> 35)));
-        if (count == 0) return &.{};
-        const text_len = @as(usize, count) - 1; // exclude null terminator
-
-        if (target_off + text_len > self.seg_len) return &.{};
-        return self.seg[target_off .. target_off + text_len];
+        return self.textAt(0, self.ptr_start + ptr_idx * 8);
     }
 
     /// Read a List(Text) field from a pointer slot. Returns an iterator-style
     /// slice is not practical here, so we provide a callback-based approach
     /// via writeKeywordsJson.
-    fn readListPtrRaw(self: Reader, ptr_idx: usize) struct { base: usize, count: usize } {
-        const ptr_off = self.ptr_start + ptr_idx * 8;
-        if (ptr_off + 8 > self.seg_len) return .{ .base = 0, .count = 0 };
-
-        // SAFETY: bounds check on line 128 ensures ptr_off + 8 <= seg_len; seg is a valid Cap'n Proto segment pointer
-        const raw = std.mem.readInt(u64, @as(*const [8]u8, @ptrCast(self.seg + ptr_off)), .little);
-        if (raw == 0) return .{ .base = 0, .count = 0 };
-        if (raw & 3 != 1) return .{ .base = 0, .count = 0 };
-
-        const offset_raw: i32 = @bitCast(@as(u32, @truncate(raw >> 2)));
-        const ptr_word = ptr_off / 8;
-        const target_word: usize = @intCast(@as(i64, @intCast(ptr_word)) + 1 + @as(i64, offset_raw));
-        const target_off = target_word * 8;
+    fn readListPtrRaw(self: Reader, ptr_idx: usize) ListRef {
+        // LIST_POINTER (6) = list of pointers (each element is a pointer to Text).
+        return self.listAt(0, self.ptr_start + ptr_idx * 8, 6) orelse .{ .seg = 0, .base = 0, .count = 0 };
+    }
 
-        const elem_size: u3 = @truncate(@as(u32, @truncate(raw >> 32)));
+    /// Read a text element from within a List(Text). The list is the pointer
+    /// list body from readListPtrRaw; elem_idx is the element index.
+    fn readTextFromList(self: Reader, list: ListRef, elem_idx: usize) []const u8 {
+        return self.textAt(list.seg, list.base + elem_idx * 8);
+    }
 
-        // LIST_POINTER (6) = list of pointers (each element is a pointer to Text).
-        if (elem_size != 6) return .{ .base = 0, .count = 0 };
+    /// The word at a byte offset of a segment, or null if out of bounds.
+    fn word(self: Reader, seg: usize, off: usize) ?u64 {
+        if (seg >= self.seg_count or off + 8 > self.segs[seg].len) return null;
+        return std.mem.readInt(u64, self.segs[seg][off..][0..8], .little);
+    }
 
-        const count: u29 = @truncate(@as(u32, @truncate(raw >> 35)));
-        return .{ .base = target_off, .count = @as(usize, count) };
+    /// Text (without the null terminator) referenced by the pointer at a
+    /// byte offset of a segment; empty if the pointer is null/invalid.
+    fn textAt(self: Reader, seg: usize, ptr_off: usize) []const u8 {
+        // Element size 2 (byte list) for Text; count includes the null terminator.
+        const list = self.listAt(seg, ptr_off, 2) orelse return &.{};
+        if (list.count == 0) return &.{};
+        const text_len = list.count - 1; // exclude null terminator
+
+        const bytes = self.segs[list.seg];
+        if (list.base + text_len > bytes.len) return &.{};
+        return bytes[list.base .. list.base + text_len];
     }
 
-    /// Read a text element from within a List(Text). The list_base is the byte
-    /// offset of the pointer list body; elem_idx is the element index.
-    fn readTextFromList(self: Reader, list_base: usize, elem_idx: usize) []const u8 {
-        const elem_ptr_off = list_base + elem_idx * 8;
-        if (elem_ptr_off + 8 > self.seg_len) return &.{};
+    /// Decode the list pointer at a byte offset of a segment, following a
+    /// single-far pointer to its landing pad. Null if the pointer is null,
+    /// not a list of elem_size elements, or a double-far pointer.
+    fn listAt(self: Reader, seg: usize, ptr_off: usize, elem_size: u3) ?ListRef {
+        var at_seg = seg;
+        var at_off = ptr_off;
+        var raw = self.word(at_seg, at_off) orelse return null;
 
-        // SAFETY: bounds check on line 152 ensures elem_ptr_off + 8 <= seg_len; seg is a valid Cap'n Proto segment pointer
-        const raw = std.mem.readInt(u64, @as(*const [8]u8, @ptrCast(self.seg + elem_ptr_off)), .little);
-        if (raw == 0) return &.{};
-        if (raw & 3 != 1) return &.{};
+        // Null pointer check.
+        if (raw == 0) return null;
+
+        // Far pointer (bits 0-1 = 2): bit 2 = double-far, bits 3-31 = landing
+        // pad word, bits 32-63 = segment id
+        if (raw & 3 == 2) {
+            if (raw & 4 != 0) return null;
+            at_seg = @intCast(raw >> 32);
+            at_off = @as(usize, @as(u29, @truncate(raw >> 3))) * 8;
+            raw = self.word(at_seg, at_off) orelse return null;
+        }
 
-        const offset_raw: i32 = @bitCast(@as(u32, @truncate(raw >> 2)));
-        const ptr_word = elem_ptr_off / 8;
-        const target_word: usize = @intCast(@as(i64, @intCast(ptr_word)) + 1 + @as(i64, offset_raw));
-        const target_off = target_word * 8;
+        // Decode list pointer: bits 0-1 must be 1 (list type).
+        if (raw & 3 != 1) return null;
 
-        const elem_size: u3 = @truncate(@as(u32, @truncate(raw >> 32)));
-        if (elem_size != 2) return &.{};
+        // Offset (signed, in words, bits 2-31) from pointer+1 to list data.
+        const lower: i32 = @bitCast(@as(u32, @truncate(raw)));
+        const target_word = @as(i64, @intCast(at_off / 8)) + 1 + @as(i64, lower >> 2);
+        if (target_word < 0) return null;
 
-        const count: u29 = @truncate(@as(u32, @truncate(raw >> 35)));
-        if (count == 0) return &.{};
-        const text_len = @as(usize, count) - 1;
+        // Element size (bits 32-34).
+        const size: u3 = @truncate(@as(u32, @truncate(raw >> 32)));
+        if (size != elem_size) return null;
 
-        if (target_off + text_len > self.seg_len) return &.{};
-        return self.seg[target_off .. target_off + text_len];
+        const count: u29 = @truncate(@as(u32, @truncate(raw >> 35)));
+        return .{ .seg = at_seg, .base = @as(usize, @intCast(target_word)) * 8, .count = count };
     }
 };
 
@@ -371,7 +360,7 @@ pub const MAX_JSON_LEN: usize = 32768;
 /// JSON record.
 ///
 /// Arguments:
-///   msg           — complete Cap'n Proto message buffer (header + segment)
+///   msg           — complete, unpacked Cap'n Proto message buffer (segment table + segments)
 ///   source_filename — original document filename (used as title)
 ///   investigation_id — investigation this evidence belongs to
 ///   run_id        — Docudactyl pipeline run identifier
@@ -483,7 +472,7 @@ pub fn stageResultsToJson(
         const kw_list = reader.readListPtrRaw(capnp.PTR_KW_WORDS);
         var first = true;
         for (0..kw_list.count) |i| {
-            const kw = reader.readTextFromList(kw_list.base, i);
+            const kw = reader.readTextFromList(kw_list, i);
             if (kw.len == 0) continue;
             if (!first) w.writeAll(",") catch return null;
             w.writeAll("\"") catch return null;
@@ -669,8 +658,9 @@ test "Reader.init rejects too-small buffer" {
 
 test "stageResultsToJson produces valid output with builder-created message" {
     // Build a minimal StageResults message using the Builder.
-    var buf: [8192]u8 align(8) = undefined;
-    var b = capnp.Builder.init(&buf);
+    var arena = capnp.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var b = capnp.Builder.init(&arena);
     b.initRoot();
 
     const mask = stages.STAGE_LANGUAGE_DETECT | stages.STAGE_EXACT_DEDUP |
@@ -679,20 +669,26 @@ test "stageResultsToJson produces valid output with builder-created message" {
     b.setI32(capnp.OFF_OCR_CONF, 88);
     b.setF64(capnp.OFF_LANG_CONFIDENCE, 0.95);
 
+    // Fill segment 0 so the remaining fields spill into segment 1 and are
+    // reached through far pointers
+    const filler = [_]u8{'x'} ** (capnp.SEGMENT_BYTES - 560);
+    b.setText(capnp.PTR_COORD_CRS, &filler);
+
     b.setText(capnp.PTR_LANG_LANGUAGE, "en");
     b.setText(capnp.PTR_EXACT_SHA, "abcd1234abcd1234abcd1234abcd1234abcd1234abcd1234abcd1234abcd1234");
     b.setText(capnp.PTR_PREMIS_FMT, "application/pdf");
 
     const kw_texts = [_][]const u8{ "evidence", "court", "filing" };
     b.setTextList(capnp.PTR_KW_WORDS, &kw_texts);
-
-    // Serialise to a message buffer (header + segment).
-    const segment_words: u32 = @intCast(b.pos / 8);
-    var msg_buf: [16384]u8 = undefined;
-    std.mem.writeInt(u32, msg_buf[0..4], 0, .little); // 1 segment
-    std.mem.writeInt(u32, msg_buf[4..8], segment_words, .little);
-    @memcpy(msg_buf[8 .. 8 + b.pos], buf[0..b.pos]);
-    const msg = msg_buf[0 .. 8 + b.pos];
+    try std.testing.expectEqual(@as(usize, 2), b.segmentCount());
+
+    // Serialise to a message buffer (segment table + segments).
+    var header: [capnp.MAX_HEADER]u8 = undefined;
+    var parts: [capnp.MAX_SEGMENTS + 1][]const u8 = undefined;
+    var msg_buf: std.ArrayList(u8) = .{};
+    defer msg_buf.deinit(std.testing.allocator);
+    for (b.messageParts(&header, &parts)) |part| try msg_buf.appendSlice(std.testing.allocator, part);
+    const msg = msg_buf.items;
 
     var out: [MAX_JSON_LEN]u8 = undefined;
     const len = stageResultsToJson(msg, "test-doc.pdf", "inv_001", "run-42", &out);
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Parallel Manifest Scanner
+//
+// Manifest ingestion without a sequential read. Every locale mmaps the
+// manifest read-only and scans only the byte ranges it is given. A line
+// belongs to the range holding its first byte: a scan that starts mid-line
+// skips to the next newline, and the last line of a range may run past the
+// range end. So any split of [0, size) into ranges visits every line
+// exactly once, and the per-range counts from ddac_manifest_count() tell
+// the caller (via a prefix sum) where each range's entries go in the
+// global entry array before ddac_manifest_next() parses them.
+//
+// Newline and quote searches run on @Vector(N, u8) compares. NDJSON lines
+// are parsed in one pass over the object's keys ("path", "size", "mtime",
+// "kind"); string values are returned as raw slices into the mapping,
+// escape sequences untouched, exactly as they appear in the manifest.
+//
+// Blank lines and lines whose first non-blank byte is '#' are not entries.
+
+const std = @import("std");
+
+// ============================================================================
+// C-ABI Entry
+// ============================================================================
+
+/// One manifest entry. path and kind point into the mapping and stay valid
+/// until ddac_manifest_close(). path_len == 0 marks a line with no path
+/// (malformed NDJSON); it still occupies its index.
+pub const ManifestEntry = extern struct {
+    path: ?[*]const u8,
+    path_len: u32,
+    kind_len: u32,
+    kind: ?[*]const u8,
+    /// File size in bytes, -1 if absent.
+    size: i64,
+    /// Unix mtime in seconds, -1 if absent.
+    mtime: i64,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(ManifestEntry) == 40);
+}
+
+const Manifest = struct {
+    /// Read-only mapping; null for a zero-length manifest.
+    map: ?[]align(std.heap.page_size_min) const u8,
+
+    fn bytes(self: *const Manifest) []const u8 {
+        return self.map orelse &.{};
+    }
+};
+
+// ============================================================================
+// Vector Byte Search
+// ============================================================================
+
+const VEC = std.simd.suggestVectorLength(u8) orelse 16;
+
+/// Offset of the first `byte` at or after `from`, or data.len.
+fn findByte(data: []const u8, from: usize, comptime byte: u8) usize {
+    const V = @Vector(VEC, u8);
+    const needle: V = @splat(byte);
+    var i = from;
+    while (i + VEC <= data.len) : (i += VEC) {
+        const chunk: V = data[i..][0..VEC].*;
+        const hits = chunk == needle;
+        if (@reduce(.Or, hits)) {
+            const mask: std.meta.Int(.unsigned, VEC) = @bitCast(hits);
+            return i + @ctz(mask);
+        }
+    }
+    while (i < data.len) : (i += 1) {
+        if (data[i] == byte) return i;
+    }
+    return data.len;
+}
+
+// ============================================================================
+// Line Ranges
+// ============================================================================
+
+/// First line starting at or after pos.
+fn lineStart(data: []const u8, pos: usize) usize {
+    if (pos == 0) return 0;
+    if (pos >= data.len) return data.len;
+    if (data[pos - 1] == '\n') return pos;
+    return @min(findByte(data, pos, '\n') + 1, data.len);
+}
+
+fn trimLine(line: []const u8) []const u8 {
+    return std.mem.trim(u8, line, " \t\r\n");
+}
+
+fn isEntry(trimmed: []const u8) bool {
+    return trimmed.len > 0 and trimmed[0] != '#';
+}
+
+fn countRange(data: []const u8, lo: usize, hi: usize) u64 {
+    var n: u64 = 0;
+    var pos = lineStart(data, lo);
+    while (pos < hi) {
+        const end = findByte(data, pos, '\n');
+        if (isEntry(trimLine(data[pos..end]))) n += 1;
+        pos = end + 1;
+    }
+    return n;
+}
+
+// ============================================================================
+// NDJSON Field Scanner
+// ============================================================================
+
+fn skipSpace(line: []const u8, from: usize) usize {
+    var i = from;
+    while (i < line.len and (line[i] == ' ' or line[i] == '\t')) : (i += 1) {}
+    return i;
+}
+
+/// Closing quote of a string whose contents start at `from` (a quote
+/// preceded by an odd run of backslashes is escaped), or line.len.
+fn stringEnd(line: []const u8, from: usize) usize {
+    var i = from;
+    while (true) {
+        const q = findByte(line, i, '"');
+        if (q >= line.len) return line.len;
+        var backslashes: usize = 0;
+        while (q - backslashes > from and line[q - backslashes - 1] == '\\') : (backslashes += 1) {}
+        if (backslashes % 2 == 0) return q;
+        i = q + 1;
+    }
+}
+
+/// Single pass over a flat JSON object's "key": value pairs.
+fn scanObject(line: []const u8, out: *ManifestEntry) void {
+    var i: usize = 0;
+    while (true) {
+        const q = findByte(line, i, '"');
+        if (q >= line.len) return;
+        const key_end = stringEnd(line, q + 1);
+        if (key_end >= line.len) return;
+        const key = line[q + 1 .. key_end];
+
+        var j = skipSpace(line, key_end + 1);
+        if (j >= line.len or line[j] != ':') {
+            i = key_end + 1;
+            continue;
+        }
+        j = skipSpace(line, j + 1);
+        if (j >= line.len) return;
+
+        if (line[j] == '"') {
+            const end = stringEnd(line, j + 1);
+            const value = line[j + 1 .. end];
+            if (std.mem.eql(u8, key, "path")) {
+                out.path = value.ptr;
+                out.path_len = @intCast(@min(value.len, std.math.maxInt(u32)));
+            } else if (std.mem.eql(u8, key, "kind")) {
+                out.kind = value.ptr;
+                out.kind_len = @intCast(@min(value.len, std.math.maxInt(u32)));
+            }
+            i = end + 1;
+        } else {
+            var end = j;
+            if (end < line.len and line[end] == '-') end += 1;
+            while (end < line.len and std.ascii.isDigit(line[end])) : (end += 1) {}
+            const value = std.fmt.parseInt(i64, line[j..end], 10) catch -1;
+            if (std.mem.eql(u8, key, "size")) {
+                out.size = value;
+            } else if (std.mem.eql(u8, key, "mtime")) {
+                out.mtime = value;
+            }
+            i = @max(end, j + 1);
+        }
+    }
+}
+
+// ============================================================================
+// C-ABI Exports
+// ============================================================================
+
+/// Map a manifest read-only. Returns null if it cannot be opened.
+export fn ddac_manifest_open(path: [*:0]const u8) ?*anyopaque {
+    const file = std.fs.cwd().openFileZ(path, .{}) catch return null;
+    defer file.close();
+    const size = file.getEndPos() catch return null;
+
+    const m = std.heap.c_allocator.create(Manifest) catch return null;
+    m.* = .{ .map = null };
+    if (size > 0) {
+        m.map = std.posix.mmap(null, @intCast(size), std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, file.handle, 0) catch {
+            std.heap.c_allocator.destroy(m);
+            return null;
+        };
+    }
+    // SAFETY: m was just allocated by c_allocator.create(Manifest), which returns a well-aligned *Manifest
+    return @ptrCast(m);
+}
+
+/// Manifest size in bytes (0 for null).
+export fn ddac_manifest_bytes(manifest: ?*anyopaque) u64 {
+    const ptr = manifest orelse return 0;
+    // SAFETY: ptr originates from ddac_manifest_open() which returns a *Manifest via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *Manifest = @ptrCast(@alignCast(ptr));
+    return m.bytes().len;
+}
+
+/// Number of entries on lines starting in [lo, hi). Also asks the kernel
+/// to read the range ahead, since ddac_manifest_next() follows.
+export fn ddac_manifest_count(manifest: ?*anyopaque, lo: u64, hi: u64) u64 {
+    const ptr = manifest orelse return 0;
+    // SAFETY: ptr originates from ddac_manifest_open() which returns a *Manifest via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *Manifest = @ptrCast(@alignCast(ptr));
+    const data = m.bytes();
+    const end_range: usize = @intCast(@min(hi, data.len));
+    if (lo >= end_range) return 0;
+
+    const advise_lo = std.mem.alignBackward(usize, @intCast(lo), std.heap.pageSize());
+    // SAFETY: the mapping starts on a page boundary and advise_lo is a multiple of the page size, so the address is page-aligned
+    const advise_ptr: [*]align(std.heap.page_size_min) u8 = @ptrCast(@alignCast(@constCast(data.ptr + advise_lo)));
+    std.posix.madvise(advise_ptr, end_range - advise_lo, std.posix.MADV.WILLNEED) catch {};
+
+    return countRange(data, @intCast(lo), end_range);
+}
+
+/// Parse the next entry on a line starting in [*cursor, hi). Pass the
+/// range start in *cursor on the first call; it is advanced past the
+/// entry's line. ndjson != 0 scans the line as an NDJSON object, else the
+/// trimmed line is the path. Returns 1 with *out filled, or 0 when the
+/// range has no more entries.
+export fn ddac_manifest_next(manifest: ?*anyopaque, cursor: *u64, hi: u64, ndjson: u8, out: *ManifestEntry) i32 {
+    const ptr = manifest orelse return 0;
+    // SAFETY: ptr originates from ddac_manifest_open() which returns a *Manifest via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *Manifest = @ptrCast(@alignCast(ptr));
+    const data = m.bytes();
+    const end_range: usize = @intCast(@min(hi, data.len));
+
+    var pos = lineStart(data, @intCast(@min(cursor.*, data.len)));
+    while (pos < end_range) {
+        const end = findByte(data, pos, '\n');
+        const line = trimLine(data[pos..end]);
+        pos = end + 1;
+        if (!isEntry(line)) continue;
+
+        cursor.* = @min(pos, data.len);
+        out.* = .{ .path = null, .path_len = 0, .kind_len = 0, .kind = null, .size = -1, .mtime = -1 };
+        if (ndjson != 0) {
+            scanObject(line, out);
+        } else {
+            out.path = line.ptr;
+            out.path_len = @intCast(@min(line.len, std.math.maxInt(u32)));
+        }
+        return 1;
+    }
+    cursor.* = @min(pos, data.len);
+    return 0;
+}
+
+/// Unmap a manifest. Safe to call with null.
+export fn ddac_manifest_close(manifest: ?*anyopaque) void {
+    const ptr = manifest orelse return;
+    // SAFETY: ptr originates from ddac_manifest_open() which returns a *Manifest via @ptrCast; alignment is guaranteed by c_allocator
+    const m: *Manifest = @ptrCast(@alignCast(ptr));
+    if (m.map) |map| std.posix.munmap(map);
+    std.heap.c_allocator.destroy(m);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "ranges split mid-line visit every entry once" {
+    const text = "# header\n/a.pdf\n\n  /b.pdf  \n/c.pdf";
+    for (0..text.len + 1) |split| {
+        try std.testing.expectEqual(@as(u64, 3), countRange(text, 0, split) + countRange(text, split, text.len));
+    }
+}
+
+test "ndjson object scan" {
+    var e = ManifestEntry{ .path = null, .path_len = 0, .kind_len = 0, .kind = null, .size = -1, .mtime = -1 };
+    scanObject("{\"kind\":\"pdf\", \"path\": \"/x/a \\\"q\\\".pdf\",\"size\":12345,\"mtime\":-7,\"note\":\"size\"}", &e);
+    try std.testing.expectEqualStrings("/x/a \\\"q\\\".pdf", e.path.?[0..e.path_len]);
+    try std.testing.expectEqualStrings("pdf", e.kind.?[0..e.kind_len]);
+    try std.testing.expectEqual(@as(i64, 12345), e.size);
+    try std.testing.expectEqual(@as(i64, -7), e.mtime);
+}
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Hot-Path Latency Histograms
+//
+// Per-phase latency histograms for the per-document path: conduit,
+// L1/L2 lookup, base parser, output write, the stage pipeline and each
+// stage bit. A span records microseconds into the calling thread's own
+// block, so recording takes no lock and touches no shared cache line:
+// every counter has a single writer, updated with a relaxed load + store.
+// ddac_metrics_snapshot() sums every thread's block (one per thread,
+// registered on first use) into bucket counts the caller can merge
+// across locales, and ddac_metrics_quantile() turns one phase's buckets
+// into p50/p99/p999. When a thread exits, its samples are folded into a
+// retired total and its block is recycled for the next new thread, so
+// the number of blocks tracks the peak thread count, not every thread
+// that ever recorded a span.
+//
+// Buckets are log-linear (HDR style): values below 16 us are exact, then
+// every power of two is split into 16 sub-buckets, so a reported quantile
+// is within 6.25% of the true value. Values are clamped at ~71 minutes.
+//
+// ddac_metrics_reset() bumps an epoch instead of touching other threads'
+// blocks; each thread zeroes its own block on its next record, and
+// snapshots skip blocks still in an old epoch.
+//
+// With --isolateParse the parse-side phases are recorded in the worker
+// processes and do not reach the locale's snapshot.
+
+const std = @import("std");
+
+// ============================================================================
+// Phases
+// ============================================================================
+
+pub const Phase = enum(u8) {
+    /// Whole ddac_parse/ddac_parse_ex call
+    document,
+    /// Conduit per file: magic bytes, validation, SHA-256
+    conduit,
+    /// LMDB lookup per call (one document or one batch)
+    cache_l1,
+    /// Dragonfly lookup per call (one document or one batch)
+    cache_l2,
+    /// Base parser (Poppler, Tesseract, FFmpeg, libxml2, GDAL)
+    parse,
+    /// Waiting for the output write to finish after the stages
+    output,
+    /// Whole stage pipeline, including the Cap'n Proto write
+    stages,
+};
+
+const FIXED_PHASES: usize = @typeInfo(Phase).@"enum".fields.len;
+/// One phase per stage bit (stages.STAGE_COUNT)
+pub const STAGE_PHASES: usize = 24;
+pub const PHASES: usize = FIXED_PHASES + STAGE_PHASES;
+
+const STAGE_NAMES = [STAGE_PHASES][]const u8{
+    "language_detect", "readability",        "keywords",          "citation_extract",
+    "ocr_confidence",  "perceptual_hash",    "toc_extract",       "multi_lang_ocr",
+    "subtitle_extract", "premis_metadata",   "merkle_proof",      "exact_dedup",
+    "near_dedup",      "coord_normalize",    "ner",               "whisper_transcribe",
+    "image_classify",  "layout_analysis",    "handwriting_ocr",   "format_convert",
+    "redaction_detect", "financial_extract", "legal_ner",         "speaker_id",
+};
+
+const PHASE_NAMES: [PHASES][:0]const u8 = blk: {
+    var names: [PHASES][:0]const u8 = undefined;
+    for (@typeInfo(Phase).@"enum".fields, 0..) |f, i| names[i] = f.name;
+    for (STAGE_NAMES, 0..) |n, i| names[FIXED_PHASES + i] = std.fmt.comptimePrint("stage.{s}", .{n});
+    break :blk names;
+};
+
+// ============================================================================
+// Log-Linear Buckets
+// ============================================================================
+
+const SUB_BITS: u6 = 4;
+const SUB: u64 = 1 << SUB_BITS;
+/// Largest shift kept: values up to 2^(MAX_SHIFT + SUB_BITS + 1) - 1 us
+const MAX_SHIFT: u64 = 27;
+pub const BUCKETS: usize = (MAX_SHIFT + 2) * SUB;
+const MAX_VALUE: u64 = ((2 * SUB) << MAX_SHIFT) - 1;
+
+fn bucketOf(us: u64) usize {
+    const v = @min(us, MAX_VALUE);
+    if (v < SUB) return @intCast(v);
+    const msb: u64 = 63 - @clz(v);
+    const shift = msb - SUB_BITS;
+    return @intCast((shift + 1) * SUB + ((v >> @intCast(shift)) - SUB));
+}
+
+/// Highest value that lands in bucket i (HDR "highest equivalent value").
+fn bucketHigh(i: usize) u64 {
+    if (i < SUB) return i;
+    const shift: u6 = @intCast(i / SUB - 1);
+    const sub: u64 = i % SUB;
+    return ((SUB + sub + 1) << shift) - 1;
+}
+
+// ============================================================================
+// Per-Thread Blocks
+// ============================================================================
+
+const Block = struct {
+    counts: [PHASES][BUCKETS]u64 = std.mem.zeroes([PHASES][BUCKETS]u64),
+    /// Epoch the counts belong to (written by the owning thread only)
+    epoch: u32 = 0,
+    next: ?*Block = null,
+    /// Free-list link while no live thread owns the block
+    next_free: ?*Block = null,
+};
+
+/// Guards the registry list, the free list and `retired`
+var registry_mutex: std.Thread.Mutex = .{};
+var registry: std.atomic.Value(?*Block) = .init(null);
+var epoch: std.atomic.Value(u32) = .init(0);
+/// Blocks of exited threads, zeroed and still on the registry list
+var free_blocks: ?*Block = null;
+/// Samples recorded by exited threads in `retired.epoch`
+var retired: Block = .{};
+
+threadlocal var local_block: ?*Block = null;
+
+/// Key whose destructor retires a thread's block when the thread exits
+var block_key: std.c.pthread_key_t = undefined;
+var block_key_ok: bool = false;
+var block_key_once = std.once(createBlockKey);
+
+fn createBlockKey() void {
+    block_key_ok = std.c.pthread_key_create(&block_key, retireBlock) == .SUCCESS;
+}
+
+fn threadBlock() ?*Block {
+    if (local_block) |blk| return blk;
+    block_key_once.call();
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+    const blk = if (free_blocks) |free| blk: {
+        free_blocks = free.next_free;
+        break :blk free;
+    } else blk: {
+        const fresh = std.heap.c_allocator.create(Block) catch return null;
+        fresh.* = .{};
+        fresh.next = registry.load(.monotonic);
+        registry.store(fresh, .release);
+        break :blk fresh;
+    };
+    @atomicStore(u32, &blk.epoch, epoch.load(.acquire), .release);
+    // Without the key the block simply stays with the thread, as before
+    if (block_key_ok) _ = std.c.pthread_setspecific(block_key, blk);
+    local_block = blk;
+    return blk;
+}
+
+/// Thread-exit destructor: fold the thread's samples into `retired`, zero
+/// its block and put it on the free list for the next new thread.
+fn retireBlock(ptr: *anyopaque) callconv(.c) void {
+    // SAFETY: the key's value is only ever set by threadBlock() to a *Block allocated by c_allocator
+    const blk: *Block = @ptrCast(@alignCast(ptr));
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+
+    const current = epoch.load(.acquire);
+    if (retired.epoch != current) {
+        for (&retired.counts) |*row| @memset(row, 0);
+        retired.epoch = current;
+    }
+    if (blk.epoch == current) {
+        for (&retired.counts, &blk.counts) |*dst, *src| {
+            for (dst, src) |*d, c| d.* += c;
+        }
+    }
+    for (&blk.counts) |*row| @memset(row, 0);
+    blk.next_free = free_blocks;
+    free_blocks = blk;
+    local_block = null;
+}
+
+/// Record one sample of `us` microseconds for phase index `phase`.
+pub fn recordUs(phase: usize, us: u64) void {
+    const blk = threadBlock() orelse return;
+    const current = epoch.load(.monotonic);
+    if (blk.epoch != current) {
+        for (&blk.counts) |*row| {
+            for (row) |*c| @atomicStore(u64, c, 0, .monotonic);
+        }
+        @atomicStore(u32, &blk.epoch, current, .release);
+    }
+    const c = &blk.counts[phase][bucketOf(us)];
+    @atomicStore(u64, c, @atomicLoad(u64, c, .monotonic) + 1, .monotonic);
+}
+
+/// A running timer for one phase; call end() once.
+pub const Span = struct {
+    phase: usize,
+    start: ?std.time.Instant,
+
+    pub fn end(self: Span) void {
+        const start = self.start orelse return;
+        const now = std.time.Instant.now() catch return;
+        recordUs(self.phase, now.since(start) / std.time.ns_per_us);
+    }
+};
+
+pub fn begin(phase: Phase) Span {
+    return .{ .phase = @intFromEnum(phase), .start = std.time.Instant.now() catch null };
+}
+
+/// Span for a single stage flag (one bit of the stage mask).
+pub fn stageSpan(flag: u64) Span {
+    const bit: usize = @ctz(flag);
+    return .{
+        .phase = FIXED_PHASES + @min(bit, STAGE_PHASES - 1),
+        .start = std.time.Instant.now() catch null,
+    };
+}
+
+// ============================================================================
+// C-ABI Exports
+// ============================================================================
+
+/// Histogram shape: number of phases and buckets per phase.
+export fn ddac_metrics_layout(phases: *u32, buckets: *u32) void {
+    phases.* = PHASES;
+    buckets.* = BUCKETS;
+}
+
+/// Name of phase i ("parse", "stage.keywords", ...), or "" if out of range.
+export fn ddac_metrics_phase_name(phase: u32) [*:0]const u8 {
+    if (phase >= PHASES) return "";
+    return PHASE_NAMES[phase].ptr;
+}
+
+/// Sum every thread's histograms, live and exited, into
+/// counts[phase * buckets + bucket]. Returns the number of values written (phases * buckets), or that
+/// number without writing anything if len is too small.
+export fn ddac_metrics_snapshot(counts: [*]u64, len: usize) usize {
+    const total = PHASES * BUCKETS;
+    if (len < total) return total;
+    const out = counts[0..total];
+    @memset(out, 0);
+
+    // Held so a thread retiring mid-walk is counted exactly once
+    registry_mutex.lock();
+    defer registry_mutex.unlock();
+
+    const current = epoch.load(.acquire);
+    var it = registry.load(.acquire);
+    while (it) |blk| : (it = blk.next) {
+        if (@atomicLoad(u32, &blk.epoch, .acquire) != current) continue;
+        for (0..PHASES) |p| {
+            for (0..BUCKETS) |b| out[p * BUCKETS + b] += @atomicLoad(u64, &blk.counts[p][b], .monotonic);
+        }
+    }
+    if (retired.epoch == current) {
+        for (0..PHASES) |p| {
+            for (0..BUCKETS) |b| out[p * BUCKETS + b] += retired.counts[p][b];
+        }
+    }
+    return total;
+}
+
+/// Value in microseconds at quantile q (0..1) of one phase's bucket
+/// counts (buckets values). 0 if the phase has no samples.
+export fn ddac_metrics_quantile(counts: [*]const u64, buckets: u32, q: f64) f64 {
+    const row = counts[0..@min(buckets, BUCKETS)];
+    var n: u64 = 0;
+    for (row) |c| n += c;
+    if (n == 0) return 0;
+
+    const clamped = std.math.clamp(q, 0.0, 1.0);
+    const rank: u64 = @max(1, @as(u64, @intFromFloat(@ceil(clamped * @as(f64, @floatFromInt(n))))));
+    var seen: u64 = 0;
+    for (row, 0..) |c, i| {
+        seen += c;
+        if (seen >= rank) return @floatFromInt(bucketHigh(i));
+    }
+    return @floatFromInt(bucketHigh(row.len - 1));
+}
+
+/// Start a new measurement window: every thread's samples so far are
+/// dropped (lazily, by the owning thread).
+export fn ddac_metrics_reset() void {
+    _ = epoch.fetchAdd(1, .acq_rel);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "bucket bounds cover every value" {
+    var v: u64 = 0;
+    while (v < 1 << 20) : (v += 7) {
+        const i = bucketOf(v);
+        try std.testing.expect(bucketHigh(i) >= v);
+        if (i > 0) try std.testing.expect(bucketHigh(i - 1) < v);
+    }
+    try std.testing.expectEqual(BUCKETS - 1, bucketOf(std.math.maxInt(u64)));
+}
+
+test "quantiles stay within one sub-bucket" {
+    var row = std.mem.zeroes([BUCKETS]u64);
+    for (1..1001) |us| row[bucketOf(us * 100)] += 1;
+    const p50 = ddac_metrics_quantile(&row, BUCKETS, 0.5);
+    const p99 = ddac_metrics_quantile(&row, BUCKETS, 0.99);
+    try std.testing.expect(p50 >= 50_000 and p50 <= 50_000 * 1.0625);
+    try std.testing.expect(p99 >= 99_000 and p99 <= 99_000 * 1.0625);
+}
+
+test "an exited thread's samples survive and its block is reused" {
+    const Recorder = struct {
+        fn run() void {
+            recordUs(@intFromEnum(Phase.output), 5);
+        }
+    };
+    const row = @intFromEnum(Phase.output) * BUCKETS + bucketOf(5);
+    var counts: [PHASES * BUCKETS]u64 = undefined;
+    _ = ddac_metrics_snapshot(&counts, counts.len);
+    const before = counts[row];
+
+    (try std.Thread.spawn(.{}, Recorder.run, .{})).join();
+    (try std.Thread.spawn(.{}, Recorder.run, .{})).join();
+
+    _ = ddac_metrics_snapshot(&counts, counts.len);
+    try std.testing.expectEqual(before + 2, counts[row]);
+    if (block_key_ok) {
+        registry_mutex.lock();
+        defer registry_mutex.unlock();
+        try std.testing.expect(free_blocks != null);
+    }
+}
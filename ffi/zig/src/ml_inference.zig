@@ -20,6 +20,15 @@
 // requests via ddac_ml_run_stage(). Each stage loads its model on first
 // use (lazy loading) and caches the ONNX session for subsequent calls.
 //
+// Requests are batched across documents: ddac_ml_run_stage() enqueues on
+// the stage's queue and blocks; a worker thread takes a batch of up to
+// max_batch requests when the queue is full or its oldest request has
+// waited max_wait_us, then scatters the results back. runBatch() is where
+// the single session Run per batch goes; tensor binding is not wired yet,
+// so it still reports every request as status 2. Every
+// parse handle on a locale shares the one ML handle, so concurrent tasks
+// fill each other's batches. Policy per stage: ddac_ml_set_batch_policy().
+//
 // Model paths are configured via ddac_ml_set_model_dir().
 
 const std = @import("std");
@@ -39,6 +48,11 @@ const MlStage = enum(u8) {
 
 const ML_STAGE_COUNT: usize = 5;
 
+/// Upper bound on max_batch (size of the worker's batch array).
+const MAX_BATCH_LIMIT: u32 = 64;
+/// Upper bound on max_wait_us (a stalled queue still drains within 1 s).
+const MAX_WAIT_LIMIT_US: u32 = 1_000_000;
+
 /// Execution provider preference
 const ExecProvider = enum(u8) {
     tensorrt = 0,   // NVIDIA TensorRT (INT8/FP16)
@@ -147,13 +161,70 @@ const ModelSession = struct {
     // In full implementation: OrtSession pointer
 };
 
+/// One caller's input, parked on a stage queue until its batch has run.
+/// Lives on the caller's stack; the caller blocks until `done`.
+const Request = struct {
+    input_path: []const u8,
+    enqueued_ns: i128,
+    result: MlResult = undefined,
+    done: bool = false,
+    next: ?*Request = null,
+};
+
+/// FIFO of pending requests for one stage, with its batching policy and
+/// batch statistics. All fields are guarded by MlEngine.mutex.
+const StageQueue = struct {
+    head: ?*Request = null,
+    tail: ?*Request = null,
+    len: u32 = 0,
+    /// Run a batch as soon as this many requests are queued
+    max_batch: u32,
+    /// ...or once the oldest request has waited this long
+    max_wait_us: u32,
+    /// Statistics
+    batches: u64 = 0,
+    items: u64 = 0,
+    queue_wait_us: u64 = 0,
+    max_queue_wait_us: u64 = 0,
+
+    fn push(self: *StageQueue, req: *Request) void {
+        if (self.tail) |t| t.next = req else self.head = req;
+        self.tail = req;
+        self.len += 1;
+    }
+
+    fn pop(self: *StageQueue) *Request {
+        const req = self.head.?;
+        self.head = req.next;
+        if (self.head == null) self.tail = null;
+        self.len -= 1;
+        return req;
+    }
+
+    /// Time at which the oldest request's wait runs out.
+    fn deadline(self: *const StageQueue) i128 {
+        return self.head.?.enqueued_ns + @as(i128, self.max_wait_us) * std.time.ns_per_us;
+    }
+};
+
+/// Default policy: large batches for the cheap text/image models, small
+/// ones with a longer wait for Whisper (long inputs, few per chunk).
+const DEFAULT_POLICY = [ML_STAGE_COUNT]struct { max_batch: u32, max_wait_us: u32 }{
+    .{ .max_batch = 32, .max_wait_us = 2_000 }, // NER
+    .{ .max_batch = 4, .max_wait_us = 20_000 }, // Whisper
+    .{ .max_batch = 32, .max_wait_us = 2_000 }, // Image classify
+    .{ .max_batch = 8, .max_wait_us = 5_000 }, // Layout
+    .{ .max_batch = 16, .max_wait_us = 5_000 }, // Handwriting
+};
+
 /// ML inference engine state
 const MlEngine = struct {
     allocator: std.mem.Allocator,
     ort: OrtApi,
-    /// Per-stage model sessions
+    /// Per-stage model sessions (touched only by the batch worker)
     sessions: [ML_STAGE_COUNT]ModelSession,
-    /// Base directory for model files
+    /// Base directory for model files (guarded by mutex: set by the
+    /// caller, read by the batch worker)
     model_dir: [512]u8,
     model_dir_len: usize,
     /// Shared output text buffer
@@ -163,6 +234,16 @@ const MlEngine = struct {
     total_inferences: u64,
     total_inference_us: u64,
 
+    /// Batching queue: guards queues, statistics, stopping and model_dir
+    mutex: std.Thread.Mutex = .{},
+    /// Signalled on enqueue and shutdown (wakes the worker)
+    work_cond: std.Thread.Condition = .{},
+    /// Broadcast when a batch's results have been scattered
+    done_cond: std.Thread.Condition = .{},
+    queues: [ML_STAGE_COUNT]StageQueue,
+    worker: ?std.Thread = null,
+    stopping: bool = false,
+
     const TEXT_BUF_SIZE: usize = 512 * 1024; // 512KB shared buffer
 
     /// Expected model filenames per stage
@@ -186,15 +267,32 @@ const MlEngine = struct {
             .text_buf_used = 0,
             .total_inferences = 0,
             .total_inference_us = 0,
+            .queues = undefined,
         };
+        for (&engine.queues, DEFAULT_POLICY) |*q, policy| {
+            q.* = .{ .max_batch = policy.max_batch, .max_wait_us = policy.max_wait_us };
+        }
         // Default model directory
         const default_dir = "models/onnx";
         @memcpy(engine.model_dir[0..default_dir.len], default_dir);
         engine.model_dir_len = default_dir.len;
+
+        // Without ONNX Runtime every request fails fast; no worker needed
+        if (engine.ort.available) {
+            engine.worker = std.Thread.spawn(.{}, workerLoop, .{engine}) catch null;
+        }
         return engine;
     }
 
     fn deinit(self: *MlEngine) void {
+        // The worker drains whatever is still queued before it exits
+        if (self.worker) |t| {
+            self.mutex.lock();
+            self.stopping = true;
+            self.work_cond.signal();
+            self.mutex.unlock();
+            t.join();
+        }
         if (self.ort.lib) |*lib| {
             lib.close();
         }
@@ -204,50 +302,133 @@ const MlEngine = struct {
 
     /// Set the model directory
     fn setModelDir(self: *MlEngine, dir: []const u8) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
         const len = @min(dir.len, 511);
         @memcpy(self.model_dir[0..len], dir[0..len]);
         self.model_dir[len] = 0;
         self.model_dir_len = len;
     }
 
-    /// Run an ML stage on a document
-    fn runStage(self: *MlEngine, stage: MlStage, input_path: []const u8, output_text: *[]const u8) MlResult {
+    /// Run an ML stage on a document: enqueue it and wait for its batch.
+    fn runStage(self: *MlEngine, stage: MlStage, input_path: []const u8) MlResult {
         var result = std.mem.zeroes(MlResult);
         result.stage = @intFromEnum(stage);
 
         // Check ONNX Runtime availability
-        if (!self.ort.available) {
+        if (!self.ort.available or self.worker == null) {
             result.status = 4; // onnx_not_available
             return result;
         }
 
-        result.provider = @intFromEnum(self.ort.provider);
-
-        // Check model file exists
-        const stage_idx = @intFromEnum(stage);
-        if (!self.sessions[stage_idx].loaded) {
-            // Build model path: {model_dir}/{model_name}
-            const model_name = MODEL_NAMES[stage_idx];
-            var path_buf: [1024]u8 = undefined;
-            const path_len = self.model_dir_len + 1 + model_name.len;
-            if (path_len >= 1024) {
-                result.status = 1; // model_not_found
-                return result;
+        var req = Request{ .input_path = input_path, .enqueued_ns = std.time.nanoTimestamp() };
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.queues[@intFromEnum(stage)].push(&req);
+        self.work_cond.signal();
+        while (!req.done) self.done_cond.wait(&self.mutex);
+        return req.result;
+    }
+
+    // ── Batch worker ──────────────────────────────────────────────────
+
+    fn workerLoop(self: *MlEngine) void {
+        var batch: [MAX_BATCH_LIMIT]*Request = undefined;
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            const now = std.time.nanoTimestamp();
+
+            // A stage is due when its batch is full, its oldest request's
+            // wait is up, or we are shutting down; otherwise sleep until the
+            // earliest deadline.
+            var due: ?usize = null;
+            var earliest: ?i128 = null;
+            for (&self.queues, 0..) |*q, i| {
+                if (q.len == 0) continue;
+                const dl = q.deadline();
+                if (self.stopping or q.len >= q.max_batch or dl <= now) {
+                    due = i;
+                    break;
+                }
+                if (earliest == null or dl < earliest.?) earliest = dl;
             }
-            @memcpy(path_buf[0..self.model_dir_len], self.model_dir[0..self.model_dir_len]);
-            path_buf[self.model_dir_len] = '/';
-            @memcpy(path_buf[self.model_dir_len + 1 ..][0..model_name.len], model_name);
-            path_buf[path_len] = 0;
-
-            // Check file exists
-            std.fs.accessAbsolute(path_buf[0..path_len], .{}) catch {
-                result.status = 1; // model_not_found
-                return result;
+
+            const stage_idx = due orelse {
+                if (earliest) |dl| {
+                    self.work_cond.timedWait(&self.mutex, @intCast(dl - now)) catch {};
+                } else if (self.stopping) {
+                    return;
+                } else {
+                    self.work_cond.wait(&self.mutex);
+                }
+                continue;
             };
 
-            self.sessions[stage_idx].loaded = true;
-            @memcpy(self.sessions[stage_idx].model_path[0..path_len], path_buf[0..path_len]);
-            self.sessions[stage_idx].model_path_len = path_len;
+            const q = &self.queues[stage_idx];
+            const n: usize = @min(q.len, q.max_batch);
+            for (batch[0..n]) |*slot| {
+                const req = q.pop();
+                const wait_us: u64 = @intCast(@divTrunc(now - req.enqueued_ns, std.time.ns_per_us));
+                q.queue_wait_us += wait_us;
+                q.max_queue_wait_us = @max(q.max_queue_wait_us, wait_us);
+                slot.* = req;
+            }
+            q.batches += 1;
+            q.items += n;
+
+            self.mutex.unlock();
+            const batch_us = self.runBatch(@enumFromInt(stage_idx), batch[0..n]);
+            self.mutex.lock();
+
+            self.total_inferences += n;
+            self.total_inference_us += batch_us;
+            for (batch[0..n]) |req| req.done = true;
+            self.done_cond.broadcast();
+        }
+    }
+
+    /// Ensure the stage's model is present. Returns 0 or an MlResult status.
+    fn ensureSession(self: *MlEngine, stage_idx: usize) u8 {
+        if (self.sessions[stage_idx].loaded) return 0;
+
+        // Build model path: {model_dir}/{model_name}, the directory read
+        // under the mutex (ddac_ml_set_model_dir may run concurrently)
+        const model_name = MODEL_NAMES[stage_idx];
+        var path_buf: [1024]u8 = undefined;
+        self.mutex.lock();
+        const dir_len = self.model_dir_len;
+        @memcpy(path_buf[0..dir_len], self.model_dir[0..dir_len]);
+        self.mutex.unlock();
+        const path_len = dir_len + 1 + model_name.len;
+        if (path_len >= 1024) return 1; // model_not_found
+        path_buf[dir_len] = '/';
+        @memcpy(path_buf[dir_len + 1 ..][0..model_name.len], model_name);
+        path_buf[path_len] = 0;
+
+        // Check file exists
+        std.fs.accessAbsolute(path_buf[0..path_len], .{}) catch return 1; // model_not_found
+
+        self.sessions[stage_idx].loaded = true;
+        @memcpy(self.sessions[stage_idx].model_path[0..path_len], path_buf[0..path_len]);
+        self.sessions[stage_idx].model_path_len = path_len;
+        return 0;
+    }
+
+    /// Run one batch of a stage and fill every request's result.
+    /// Called on the worker thread without the mutex held.
+    /// Returns the batch's inference time in microseconds.
+    fn runBatch(self: *MlEngine, stage: MlStage, reqs: []const *Request) u64 {
+        var template = std.mem.zeroes(MlResult);
+        template.stage = @intFromEnum(stage);
+        template.provider = @intFromEnum(self.ort.provider);
+        template.confidence = -1.0;
+
+        template.status = self.ensureSession(@intFromEnum(stage));
+        if (template.status != 0) {
+            for (reqs) |req| req.result = template;
+            return 0;
         }
 
         // Run inference
@@ -255,9 +436,10 @@ const MlEngine = struct {
 
         // In a full implementation, this would:
         //   1. Load the ONNX model (if not cached)
-        //   2. Prepare input tensors from the document
-        //   3. Run inference via OrtSession::Run()
-        //   4. Post-process output tensors
+        //   2. Prepare each request's input and stack them along the batch
+        //      axis (padding text/audio to the batch's longest input)
+        //   3. Run inference via OrtSession::Run() — once per batch
+        //   4. Slice the output tensors back per request and post-process
         //   5. Write results to the shared text buffer
         //
         // Each stage has specific preprocessing:
@@ -270,18 +452,13 @@ const MlEngine = struct {
         // For now, we provide the framework and report the stage as
         // "model loaded but inference not yet wired" (status=2).
 
-        _ = input_path;
-        _ = output_text;
-
         const elapsed_ns = std.time.nanoTimestamp() - start_ns;
-        result.inference_time_us = @intCast(@divTrunc(elapsed_ns, 1000));
-        result.status = 2; // inference_error (stub — not yet wired)
-        result.confidence = -1.0;
-
-        self.total_inferences += 1;
-        self.total_inference_us += @intCast(result.inference_time_us);
+        const elapsed_us: u64 = @intCast(@divTrunc(elapsed_ns, 1000));
+        template.inference_time_us = @intCast(elapsed_us);
+        template.status = 2; // inference_error (stub — not yet wired)
 
-        return result;
+        for (reqs) |req| req.result = template;
+        return elapsed_us;
     }
 };
 
@@ -374,11 +551,58 @@ export fn ddac_ml_run_stage(
     }
 
     const ml_stage: MlStage = @enumFromInt(stage);
-    var output_text: []const u8 = &.{};
-    result_out.* = engine.runStage(ml_stage, std.mem.span(input_path), &output_text);
+    result_out.* = engine.runStage(ml_stage, std.mem.span(input_path));
     return 0;
 }
 
+/// Set a stage's batching policy: run a batch once max_batch requests are
+/// queued (1..64; 1 disables batching) or the oldest has waited
+/// max_wait_us (0..1000000). Values are clamped. Unknown stages are ignored.
+export fn ddac_ml_set_batch_policy(handle: ?*anyopaque, stage: u8, max_batch: u32, max_wait_us: u32) void {
+    const ptr = handle orelse return;
+    if (stage >= ML_STAGE_COUNT) return;
+    // SAFETY: ptr originates from ddac_ml_init() which stores a *MlEngine via @ptrCast; alignment is guaranteed by c_allocator
+    const engine: *MlEngine = @ptrCast(@alignCast(ptr));
+    engine.mutex.lock();
+    defer engine.mutex.unlock();
+    const q = &engine.queues[stage];
+    q.max_batch = std.math.clamp(max_batch, 1, MAX_BATCH_LIMIT);
+    q.max_wait_us = @min(max_wait_us, MAX_WAIT_LIMIT_US);
+    engine.work_cond.signal(); // deadlines may have moved
+}
+
+/// Get a stage's batch statistics: batches run, requests served, summed
+/// and worst queue wait (microseconds), and the current max_batch.
+/// Mean occupancy = items / (batches * max_batch); mean wait = wait_us / items.
+/// All outputs are zero for a null handle or unknown stage.
+export fn ddac_ml_queue_stats(
+    handle: ?*anyopaque,
+    stage: u8,
+    batches: *u64,
+    items: *u64,
+    queue_wait_us: *u64,
+    max_queue_wait_us: *u64,
+    max_batch: *u32,
+) void {
+    batches.* = 0;
+    items.* = 0;
+    queue_wait_us.* = 0;
+    max_queue_wait_us.* = 0;
+    max_batch.* = 0;
+    const ptr = handle orelse return;
+    if (stage >= ML_STAGE_COUNT) return;
+    // SAFETY: ptr originates from ddac_ml_init() which stores a *MlEngine via @ptrCast; alignment is guaranteed by c_allocator
+    const engine: *MlEngine = @ptrCast(@alignCast(ptr));
+    engine.mutex.lock();
+    defer engine.mutex.unlock();
+    const q = &engine.queues[stage];
+    batches.* = q.batches;
+    items.* = q.items;
+    queue_wait_us.* = q.queue_wait_us;
+    max_queue_wait_us.* = q.max_queue_wait_us;
+    max_batch.* = q.max_batch;
+}
+
 /// Get ML inference statistics.
 export fn ddac_ml_stats(
     handle: ?*anyopaque,
@@ -392,6 +616,8 @@ export fn ddac_ml_stats(
     };
     // SAFETY: ptr originates from ddac_ml_init() which stores a *MlEngine via @ptrCast; alignment is guaranteed by c_allocator
     const engine: *MlEngine = @ptrCast(@alignCast(ptr));
+    engine.mutex.lock();
+    defer engine.mutex.unlock();
     total_inferences.* = engine.total_inferences;
     total_inference_us.* = engine.total_inference_us;
 }
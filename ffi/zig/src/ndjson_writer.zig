@@ -0,0 +1,377 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Streaming NDJSON Result Writer
+//
+// One writer per locale (shard-N/results.ndjson) with a background writer
+// thread. Each Chapel task leases its own task buffer and formats result
+// lines straight from ddac_parse_result_t into it — no intermediate
+// strings and no lock on the per-document path. When a task's slab is
+// full it is queued for the writer thread and swapped for an empty one
+// from the free list; the writer drains queued slabs with large
+// sequential writes.
+//
+// direct = 1 opens the file O_DIRECT (parallel filesystems that punish
+// page-cache traffic): slabs are then copied into an aligned staging
+// buffer written in whole blocks, and the unaligned tail is written with
+// O_DIRECT cleared at close. If the filesystem refuses O_DIRECT the writer
+// falls back to buffered writes.
+//
+// Lines from different tasks interleave per slab, not per document; each
+// line is written whole.
+
+const std = @import("std");
+const ParseResult = @import("docudactyl_ffi.zig").ParseResult;
+
+// ============================================================================
+// Writer State
+// ============================================================================
+
+const DEFAULT_SLAB_BYTES: usize = 1024 * 1024;
+const MIN_SLAB_BYTES: usize = 64 * 1024;
+const MAX_SLAB_BYTES: usize = 64 * 1024 * 1024;
+/// Full slabs allowed to queue before submitting tasks wait for the writer
+const MAX_QUEUED: usize = 64;
+/// O_DIRECT buffer, offset and length alignment
+const DIRECT_ALIGN: usize = 4096;
+
+const Slab = struct {
+    data: []u8,
+    len: usize = 0,
+    next: ?*Slab = null,
+};
+
+const Writer = struct {
+    file: std.fs.File,
+    direct: bool,
+    slab_bytes: usize,
+
+    mutex: std.Thread.Mutex = .{},
+    work_cond: std.Thread.Condition = .{},
+    space_cond: std.Thread.Condition = .{},
+    /// Full slabs, oldest first (under mutex)
+    queue_head: ?*Slab = null,
+    queue_tail: ?*Slab = null,
+    queued: usize = 0,
+    /// Drained slabs ready for reuse (under mutex)
+    free: ?*Slab = null,
+    stopping: bool = false,
+    thread: ?std.Thread = null,
+
+    /// O_DIRECT staging buffer (writer thread only)
+    stage: ?[]align(DIRECT_ALIGN) u8 = null,
+    stage_len: usize = 0,
+
+    lines: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    write_failed: bool = false,
+
+    /// Take an empty slab (reused or new). Caller holds mutex.
+    fn takeFree(self: *Writer) ?*Slab {
+        if (self.free) |s| {
+            self.free = s.next;
+            s.* = .{ .data = s.data };
+            return s;
+        }
+        const allocator = std.heap.c_allocator;
+        const s = allocator.create(Slab) catch return null;
+        const data = allocator.alloc(u8, self.slab_bytes) catch {
+            allocator.destroy(s);
+            return null;
+        };
+        s.* = .{ .data = data };
+        return s;
+    }
+
+    /// Queue a slab for the writer thread, waiting while the queue is full.
+    /// Returns an empty replacement slab (null if allocation failed).
+    fn submit(self: *Writer, slab: *Slab, want_replacement: bool) ?*Slab {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (slab.len > 0) {
+            while (self.queued >= MAX_QUEUED and self.thread != null) self.space_cond.wait(&self.mutex);
+            slab.next = null;
+            if (self.queue_tail) |t| t.next = slab else self.queue_head = slab;
+            self.queue_tail = slab;
+            self.queued += 1;
+            self.work_cond.signal();
+        } else {
+            slab.next = self.free;
+            self.free = slab;
+        }
+        if (self.thread == null) self.drainLocked();
+        return if (want_replacement) self.takeFree() else null;
+    }
+
+    /// Write every queued slab inline (no writer thread). Caller holds mutex.
+    fn drainLocked(self: *Writer) void {
+        while (self.queue_head) |s| {
+            self.queue_head = s.next;
+            if (self.queue_head == null) self.queue_tail = null;
+            self.queued -= 1;
+            self.writeSlab(s);
+            s.next = self.free;
+            self.free = s;
+        }
+    }
+
+    fn workerLoop(self: *Writer) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            const s = self.queue_head orelse {
+                if (self.stopping) return;
+                self.work_cond.wait(&self.mutex);
+                continue;
+            };
+            self.queue_head = s.next;
+            if (self.queue_head == null) self.queue_tail = null;
+            self.queued -= 1;
+            self.space_cond.broadcast();
+
+            // The writer owns a dequeued slab
+            self.mutex.unlock();
+            self.writeSlab(s);
+            self.mutex.lock();
+
+            s.next = self.free;
+            self.free = s;
+        }
+    }
+
+    fn writeSlab(self: *Writer, s: *Slab) void {
+        const bytes = s.data[0..s.len];
+        if (!self.direct) {
+            self.file.writeAll(bytes) catch {
+                self.write_failed = true;
+            };
+            return;
+        }
+        const stage = self.stage.?;
+        var rest = bytes;
+        while (rest.len > 0) {
+            const n = @min(rest.len, stage.len - self.stage_len);
+            @memcpy(stage[self.stage_len..][0..n], rest[0..n]);
+            self.stage_len += n;
+            rest = rest[n..];
+            if (self.stage_len == stage.len) {
+                self.file.writeAll(stage) catch {
+                    self.write_failed = true;
+                };
+                self.stage_len = 0;
+            }
+        }
+    }
+
+    /// Write the staged O_DIRECT tail: whole blocks first, then the
+    /// remainder with O_DIRECT cleared. Writer thread stopped.
+    fn finishDirect(self: *Writer) void {
+        if (!self.direct or self.stage_len == 0) return;
+        const stage = self.stage.?;
+        const whole = self.stage_len / DIRECT_ALIGN * DIRECT_ALIGN;
+        if (whole > 0) {
+            self.file.writeAll(stage[0..whole]) catch {
+                self.write_failed = true;
+            };
+        }
+        const fd = self.file.handle;
+        const direct_bit: usize = @as(u32, @bitCast(std.posix.O{ .DIRECT = true }));
+        if (std.posix.fcntl(fd, std.posix.F.GETFL, 0)) |fl| {
+            _ = std.posix.fcntl(fd, std.posix.F.SETFL, fl & ~direct_bit) catch {};
+        } else |_| {}
+        self.file.writeAll(stage[whole..self.stage_len]) catch {
+            self.write_failed = true;
+        };
+        self.stage_len = 0;
+    }
+};
+
+const TaskBuffer = struct {
+    writer: *Writer,
+    slab: ?*Slab,
+};
+
+// ============================================================================
+// Line Formatting
+// ============================================================================
+
+fn cString(buf: []const u8) []const u8 {
+    return buf[0 .. std.mem.indexOfScalar(u8, buf, 0) orelse buf.len];
+}
+
+fn writeJsonString(out: *std.Io.Writer, s: []const u8) !void {
+    try out.writeByte('"');
+    var start: usize = 0;
+    for (s, 0..) |ch, i| {
+        const esc: ?[]const u8 = switch (ch) {
+            '"' => "\\\"",
+            '\\' => "\\\\",
+            '\n' => "\\n",
+            '\r' => "\\r",
+            '\t' => "\\t",
+            else => null,
+        };
+        if (esc == null and ch >= 0x20) continue;
+        try out.writeAll(s[start..i]);
+        if (esc) |e| try out.writeAll(e) else try out.print("\\u{x:0>4}", .{ch});
+        start = i + 1;
+    }
+    try out.writeAll(s[start..]);
+    try out.writeByte('"');
+}
+
+fn finite(x: f64) f64 {
+    return if (std.math.isFinite(x)) x else 0;
+}
+
+/// Longest finite f64 formatted as {d:.3}: sign, the 309 integer digits
+/// of f64 max, the point and three decimals.
+const F64_MAX_LEN = 1 + 309 + 1 + 3;
+
+/// Upper bound on the formatted length of a line (every byte escaped as
+/// \u00XX, both float fields at their widest, plus the fixed fields).
+fn lineBound(path_len: usize) usize {
+    return 6 * (path_len + 65 + 256) + 2 * F64_MAX_LEN + 512;
+}
+
+/// One result line, same fields as the earlier Chapel-side formatter.
+fn formatLine(out: *std.Io.Writer, path: []const u8, r: *const ParseResult, parse_time_ms: f64) !void {
+    try out.writeAll("{\"path\":");
+    try writeJsonString(out, path);
+    try out.print(",\"status\":{d},\"content_kind\":{d},\"pages\":{d},\"words\":{d},\"chars\":{d}", .{
+        r.status, r.content_kind, r.page_count, r.word_count, r.char_count,
+    });
+    if (r.duration_sec > 0) try out.print(",\"duration_sec\":{d:.3}", .{finite(r.duration_sec)});
+    try out.print(",\"parse_time_ms\":{d:.3}", .{finite(parse_time_ms)});
+    const sha = cString(&r.sha256);
+    if (sha.len > 0) {
+        try out.writeAll(",\"sha256\":");
+        try writeJsonString(out, sha);
+    }
+    const title = cString(&r.title);
+    if (title.len > 0) {
+        try out.writeAll(",\"title\":");
+        try writeJsonString(out, title);
+    }
+    try out.writeAll("}\n");
+}
+
+// ============================================================================
+// C-ABI exports
+// ============================================================================
+
+/// Open a streaming NDJSON writer at path (truncated) with a background
+/// writer thread. slab_bytes: per-task buffer size (0 = 1 MiB, clamped to
+/// 64 KiB..64 MiB). direct != 0 requests O_DIRECT.
+/// Returns opaque handle, or null on failure.
+export fn ddac_ndjson_open(path: [*:0]const u8, slab_bytes: u32, direct: u8) ?*anyopaque {
+    const allocator = std.heap.c_allocator;
+    const size = if (slab_bytes == 0) DEFAULT_SLAB_BYTES else std.math.clamp(@as(usize, slab_bytes), MIN_SLAB_BYTES, MAX_SLAB_BYTES);
+
+    var use_direct = direct != 0;
+    const flags: std.posix.O = .{ .ACCMODE = .WRONLY, .CREAT = true, .TRUNC = true };
+    const fd = blk: {
+        if (use_direct) {
+            var direct_flags = flags;
+            direct_flags.DIRECT = true;
+            if (std.posix.openZ(path, direct_flags, 0o644)) |fd| break :blk fd else |_| {}
+            use_direct = false; // filesystem refuses O_DIRECT
+        }
+        break :blk std.posix.openZ(path, flags, 0o644) catch return null;
+    };
+    const file = std.fs.File{ .handle = fd };
+
+    const w = allocator.create(Writer) catch {
+        file.close();
+        return null;
+    };
+    w.* = .{ .file = file, .direct = use_direct, .slab_bytes = size };
+    if (use_direct) {
+        const stage_len = std.mem.alignForward(usize, size, DIRECT_ALIGN);
+        w.stage = allocator.alignedAlloc(u8, comptime std.mem.Alignment.fromByteUnits(DIRECT_ALIGN), stage_len) catch {
+            file.close();
+            allocator.destroy(w);
+            return null;
+        };
+    }
+    // Without a thread, submit() writes inline
+    w.thread = std.Thread.spawn(.{}, Writer.workerLoop, .{w}) catch null;
+    // SAFETY: w was just allocated by c_allocator.create(Writer), which returns a well-aligned *Writer
+    return @ptrCast(w);
+}
+
+/// Lease a task buffer on a writer (one per task; not thread-safe itself).
+/// Returns opaque handle, or null on failure.
+export fn ddac_ndjson_task_buffer(writer: ?*anyopaque) ?*anyopaque {
+    const ptr = writer orelse return null;
+    // SAFETY: ptr originates from ddac_ndjson_open() which returns a *Writer via @ptrCast; alignment is guaranteed by c_allocator
+    const w: *Writer = @ptrCast(@alignCast(ptr));
+    const tb = std.heap.c_allocator.create(TaskBuffer) catch return null;
+    w.mutex.lock();
+    const slab = w.takeFree();
+    w.mutex.unlock();
+    tb.* = .{ .writer = w, .slab = slab };
+    // SAFETY: tb was just allocated by c_allocator.create(TaskBuffer), which returns a well-aligned *TaskBuffer
+    return @ptrCast(tb);
+}
+
+/// Format one result line into the task buffer. Lock-free unless the slab
+/// fills and is handed to the writer thread. Returns 0, or -1 if the line
+/// was dropped (no buffer, or a line larger than a slab).
+export fn ddac_ndjson_append(buffer: ?*anyopaque, input_path: [*:0]const u8, result: *const ParseResult, parse_time_ms: f64) i32 {
+    const ptr = buffer orelse return -1;
+    // SAFETY: ptr originates from ddac_ndjson_task_buffer() which returns a *TaskBuffer via @ptrCast; alignment is guaranteed by c_allocator
+    const tb: *TaskBuffer = @ptrCast(@alignCast(ptr));
+    const path = std.mem.span(input_path);
+    const bound = lineBound(path.len);
+    if (bound > tb.writer.slab_bytes) return -1;
+
+    var slab = tb.slab orelse return -1;
+    if (slab.data.len - slab.len < bound) {
+        tb.slab = tb.writer.submit(slab, true);
+        slab = tb.slab orelse return -1;
+    }
+
+    var out: std.Io.Writer = .fixed(slab.data[slab.len..]);
+    formatLine(&out, path, result, parse_time_ms) catch return -1; // bound guarantees room
+    slab.len += out.end;
+    _ = tb.writer.lines.fetchAdd(1, .monotonic);
+    return 0;
+}
+
+/// Hand a task buffer's remaining lines to the writer and free it.
+/// Safe to call with null.
+export fn ddac_ndjson_task_release(buffer: ?*anyopaque) void {
+    const ptr = buffer orelse return;
+    // SAFETY: ptr originates from ddac_ndjson_task_buffer() which returns a *TaskBuffer via @ptrCast; alignment is guaranteed by c_allocator
+    const tb: *TaskBuffer = @ptrCast(@alignCast(ptr));
+    if (tb.slab) |s| _ = tb.writer.submit(s, false);
+    std.heap.c_allocator.destroy(tb);
+}
+
+/// Drain every queued slab, stop the writer thread and close the file.
+/// All task buffers must have been released. Safe to call with null.
+/// Returns lines written, or -1 if any write failed.
+export fn ddac_ndjson_close(writer: ?*anyopaque) i64 {
+    const ptr = writer orelse return 0;
+    // SAFETY: ptr originates from ddac_ndjson_open() which returns a *Writer via @ptrCast; alignment is guaranteed by c_allocator
+    const w: *Writer = @ptrCast(@alignCast(ptr));
+    const allocator = std.heap.c_allocator;
+
+    w.mutex.lock();
+    w.stopping = true;
+    w.work_cond.signal();
+    w.mutex.unlock();
+    if (w.thread) |t| t.join();
+    w.drainLocked(); // thread gone: nothing else touches the queue
+    w.finishDirect();
+    w.file.close();
+
+    const status: i64 = if (w.write_failed) -1 else @intCast(w.lines.load(.monotonic));
+    while (w.free) |s| {
+        w.free = s.next;
+        allocator.free(s.data);
+        allocator.destroy(s);
+    }
+    if (w.stage) |stage| allocator.free(stage);
+    allocator.destroy(w);
+    return status;
+}
@@ -0,0 +1,711 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Near-Duplicate Hash Index
+//
+// Multi-index hashing over the 64-bit average hashes that STAGE_NEAR_DEDUP
+// computes, so near-duplicates are found as documents are parsed instead
+// of by an all-pairs pass afterwards. A hash is split into four 16-bit
+// chunks and each of the four tables buckets entries by one chunk. Two
+// hashes within Hamming distance r have, by pigeonhole, some chunk within
+// floor(r/4) bits of each other, so a query probes every chunk value
+// within floor(r/4) of its own in each table (1, 17, 137 or 697 buckets
+// for r up to 15) and checks the full distance of each candidate.
+//
+// An index is a read-only base, mmap'd from a snapshot, plus an in-memory
+// delta of inserts since. The snapshot stores the base tables in CSR form,
+// so opening one costs an mmap and a header check, with no rebuild:
+//
+//   64-byte header, hashes[n] u64, doc_ids[n] u64,
+//   4 x offsets[65537] u32, 4 x ids[n] u32 (entry ids grouped by chunk)
+//
+// ddac_neardup_save() merges base and delta into a new snapshot.
+//
+// Across locales the index is sharded by chunk value. ddac_neardup_shards()
+// names the shards owning every chunk value within floor(r/4) bits of a
+// hash's own: with r = 0 the (up to four) shards a hash is inserted into,
+// with the query radius the shards a query must visit. Two hashes within
+// r bits have a chunk within floor(r/4) bits, whose owner holds the one
+// and is visited for the other. ddac_neardup_check_batch() and
+// ddac_neardup_insert_batch() take one chunk of documents per shard, so
+// the driver checks a chunk with one exchange per shard before parsing
+// it, then inserts it; a near-duplicate's verdict reaches its parse
+// through ddac_set_neardup_verdict().
+
+const std = @import("std");
+
+// ============================================================================
+// Layout
+// ============================================================================
+
+const CHUNKS = 4;
+const CHUNK_BITS: u6 = 16;
+const BUCKETS: usize = 1 << CHUNK_BITS;
+
+/// Largest radius a query supports (at most 3 bits per chunk).
+pub const MAX_HAMMING: u8 = 15;
+
+/// ddac_neardup_check_batch() distance for a hash with no match.
+pub const NO_MATCH: u8 = 0xFF;
+
+const SNAP_MAGIC = "DDACNDUP".*;
+const FORMAT_VERSION: u32 = 1;
+
+const SnapHeader = extern struct {
+    magic: [8]u8,
+    version: u32,
+    _pad: u32,
+    count: u64,
+    _reserved: [40]u8,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(SnapHeader) == 64);
+}
+
+const SNAP_HEADER: usize = @sizeOf(SnapHeader);
+
+fn snapshotSize(n: usize) usize {
+    return SNAP_HEADER + n * 2 * @sizeOf(u64) +
+        CHUNKS * ((BUCKETS + 1) + n) * @sizeOf(u32);
+}
+
+fn chunkOf(hash: u64, k: usize) u16 {
+    return @truncate(hash >> @intCast(k * CHUNK_BITS));
+}
+
+/// Next larger u16 with the same number of set bits (Gosper's hack), or
+/// null past the last one.
+fn nextSameBits(x: u16) ?u16 {
+    const v: u32 = x;
+    const low = v & (~v +% 1);
+    const ripple = v + low;
+    if (ripple > 0xFFFF) return null;
+    const next = ripple | (((v ^ ripple) >> 2) / low);
+    return if (next > 0xFFFF) null else @intCast(next);
+}
+
+/// Every 16-bit value within `sub` bits of `own`, nearest first.
+const ChunkNeighbours = struct {
+    own: u16,
+    sub: u8,
+    /// Bits flipped in the values now being enumerated
+    d: u8 = 0,
+    mask: ?u16 = 0,
+
+    fn next(self: *ChunkNeighbours) ?u16 {
+        while (self.d <= self.sub) {
+            if (self.mask) |flip| {
+                self.mask = if (self.d == 0) null else nextSameBits(flip);
+                return self.own ^ flip;
+            }
+            self.d += 1;
+            if (self.d <= self.sub) self.mask = @intCast((@as(u32, 1) << @intCast(self.d)) - 1);
+        }
+        return null;
+    }
+};
+
+// ============================================================================
+// Index
+// ============================================================================
+
+pub const Match = struct {
+    doc_id: u64,
+    distance: u8,
+};
+
+/// Tables of a snapshot, read in place from its mapping.
+const Base = struct {
+    map: []align(std.heap.page_size_min) u8,
+    hashes: []const u64,
+    doc_ids: []const u64,
+    /// Per table: BUCKETS + 1 offsets into ids
+    offsets: [CHUNKS][]const u32,
+    ids: [CHUNKS][]const u32,
+
+    fn bucket(self: *const Base, k: usize, value: u16) []const u32 {
+        return self.ids[k][self.offsets[k][value]..self.offsets[k][@as(usize, value) + 1]];
+    }
+};
+
+pub const Index = struct {
+    lock: std.Thread.RwLock = .{},
+    base: ?Base = null,
+    /// Delta entries (id = base count + position)
+    hashes: std.ArrayList(u64) = .empty,
+    doc_ids: std.ArrayList(u64) = .empty,
+    buckets: [CHUNKS][BUCKETS]std.ArrayList(u32),
+
+    /// Empty index (~6 MB of bucket headers).
+    pub fn create() !*Index {
+        const idx = try std.heap.c_allocator.create(Index);
+        idx.* = .{ .buckets = undefined };
+        for (&idx.buckets) |*table| @memset(table, .empty);
+        return idx;
+    }
+
+    /// Index whose base is the snapshot at `path`.
+    pub fn open(path: [*:0]const u8) !*Index {
+        const file = try std.fs.cwd().openFileZ(path, .{});
+        defer file.close();
+        const size: usize = @intCast((try file.stat()).size);
+        if (size < SNAP_HEADER) return error.BadSnapshot;
+
+        const map = try std.posix.mmap(null, size, std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, file.handle, 0);
+        errdefer std.posix.munmap(map);
+        const h = std.mem.bytesToValue(SnapHeader, map[0..SNAP_HEADER]);
+        if (!std.mem.eql(u8, &h.magic, &SNAP_MAGIC) or h.version != FORMAT_VERSION) return error.BadSnapshot;
+        if (h.count > std.math.maxInt(u32)) return error.BadSnapshot;
+        const n: usize = @intCast(h.count);
+        if (size != snapshotSize(n)) return error.BadSnapshot;
+
+        var base: Base = undefined;
+        base.map = map;
+        var off: usize = SNAP_HEADER;
+        // SAFETY: map is page-aligned and SNAP_HEADER (64) is a multiple of 8, so both u64 arrays after the header are u64-aligned
+        const words: [*]const u64 = @ptrCast(@alignCast(map.ptr + off));
+        base.hashes = words[0..n];
+        base.doc_ids = words[n .. 2 * n];
+        off += n * 2 * @sizeOf(u64);
+        // SAFETY: off is a multiple of 8 past a page-aligned mapping, so the u32 arrays that follow are u32-aligned
+        const halves: [*]const u32 = @ptrCast(@alignCast(map.ptr + off));
+        var at: usize = 0;
+        for (0..CHUNKS) |k| {
+            base.offsets[k] = halves[at .. at + BUCKETS + 1];
+            at += BUCKETS + 1;
+        }
+        for (0..CHUNKS) |k| {
+            base.ids[k] = halves[at .. at + n];
+            at += n;
+            if (base.offsets[k][BUCKETS] != n) return error.BadSnapshot;
+        }
+
+        const idx = try create();
+        idx.base = base;
+        return idx;
+    }
+
+    pub fn destroy(self: *Index) void {
+        const allocator = std.heap.c_allocator;
+        if (self.base) |base| std.posix.munmap(base.map);
+        self.hashes.deinit(allocator);
+        self.doc_ids.deinit(allocator);
+        for (&self.buckets) |*table| {
+            for (table) |*list| list.deinit(allocator);
+        }
+        allocator.destroy(self);
+    }
+
+    fn baseCount(self: *const Index) usize {
+        return if (self.base) |base| base.hashes.len else 0;
+    }
+
+    fn countLocked(self: *const Index) usize {
+        return self.baseCount() + self.hashes.items.len;
+    }
+
+    pub fn count(self: *Index) usize {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        return self.countLocked();
+    }
+
+    fn entryHash(self: *const Index, id: usize) u64 {
+        const nb = self.baseCount();
+        return if (id < nb) self.base.?.hashes[id] else self.hashes.items[id - nb];
+    }
+
+    fn entryDoc(self: *const Index, id: usize) u64 {
+        const nb = self.baseCount();
+        return if (id < nb) self.base.?.doc_ids[id] else self.doc_ids.items[id - nb];
+    }
+
+    fn insertLocked(self: *Index, hash: u64, doc_id: u64) !void {
+        const allocator = std.heap.c_allocator;
+        const id = self.countLocked();
+        if (id >= std.math.maxInt(u32)) return error.IndexFull;
+        try self.hashes.ensureUnusedCapacity(allocator, 1);
+        try self.doc_ids.ensureUnusedCapacity(allocator, 1);
+        for (0..CHUNKS) |k| {
+            try self.buckets[k][chunkOf(hash, k)].ensureUnusedCapacity(allocator, 1);
+        }
+        self.hashes.appendAssumeCapacity(hash);
+        self.doc_ids.appendAssumeCapacity(doc_id);
+        for (0..CHUNKS) |k| {
+            self.buckets[k][chunkOf(hash, k)].appendAssumeCapacity(@intCast(id));
+        }
+    }
+
+    pub fn insert(self: *Index, hash: u64, doc_id: u64) !void {
+        self.lock.lock();
+        defer self.lock.unlock();
+        try self.insertLocked(hash, doc_id);
+    }
+
+    /// One query in progress.
+    const Probe = struct {
+        hash: u64,
+        radius: u8,
+        /// Bits per chunk probed (radius / CHUNKS)
+        sub: u8,
+        /// Entries of this document are not matches (its own earlier hash)
+        exclude: ?u64,
+        out: []Match,
+        n: usize = 0,
+        /// An entry of `exclude` with this very hash was seen
+        self_indexed: bool = false,
+    };
+
+    /// Candidate `id` found through table k: record it unless an earlier
+    /// table also reaches it (each entry is reported once).
+    fn consider(self: *const Index, probe: *Probe, id: usize, k: usize) void {
+        if (id >= self.countLocked()) return;
+        const diff = probe.hash ^ self.entryHash(id);
+        const dist: u8 = @popCount(diff);
+        if (dist > probe.radius) return;
+        for (0..k) |j| {
+            if (@popCount(chunkOf(diff, j)) <= probe.sub) return;
+        }
+        const doc = self.entryDoc(id);
+        if (probe.exclude != null and probe.exclude.? == doc) {
+            if (dist == 0) probe.self_indexed = true;
+            return;
+        }
+        const m = Match{ .doc_id = doc, .distance = dist };
+        const out = probe.out;
+        if (probe.n < out.len) {
+            out[probe.n] = m;
+            probe.n += 1;
+            return;
+        }
+        // Full: replace the farthest match if this one is nearer
+        var worst: usize = 0;
+        for (out, 0..) |o, i| {
+            if (o.distance > out[worst].distance) worst = i;
+        }
+        if (dist < out[worst].distance) out[worst] = m;
+    }
+
+    fn queryLocked(self: *const Index, probe: *Probe) usize {
+        if (probe.out.len == 0) return 0;
+        const hash = probe.hash;
+        const sub = probe.sub;
+        for (0..CHUNKS) |k| {
+            var values = ChunkNeighbours{ .own = chunkOf(hash, k), .sub = sub };
+            while (values.next()) |value| {
+                if (self.base) |*base| {
+                    for (base.bucket(k, value)) |id| self.consider(probe, id, k);
+                }
+                for (self.buckets[k][value].items) |id| self.consider(probe, id, k);
+            }
+        }
+        const found = probe.out[0..probe.n];
+        std.mem.sort(Match, found, {}, struct {
+            fn lessThan(_: void, a: Match, b: Match) bool {
+                return a.distance < b.distance;
+            }
+        }.lessThan);
+        return found.len;
+    }
+
+    fn probeFor(hash: u64, max_hamming: u8, exclude: ?u64, out: []Match) Probe {
+        const radius = @min(max_hamming, MAX_HAMMING);
+        return .{ .hash = hash, .radius = radius, .sub = radius / CHUNKS, .exclude = exclude, .out = out };
+    }
+
+    /// Up to out.len indexed hashes within max_hamming bits of `hash`,
+    /// nearest first. Returns the number written.
+    pub fn query(self: *Index, hash: u64, max_hamming: u8, out: []Match) usize {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        var probe = probeFor(hash, max_hamming, null, out);
+        return self.queryLocked(&probe);
+    }
+
+    /// Nearest indexed hash of another document within max_hamming bits
+    /// (the document's own entries never match).
+    pub fn nearest(self: *Index, hash: u64, doc_id: u64, max_hamming: u8) ?Match {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        var best: [1]Match = undefined;
+        var probe = probeFor(hash, max_hamming, doc_id, &best);
+        return if (self.queryLocked(&probe) > 0) best[0] else null;
+    }
+
+    /// Index `hash` for doc_id unless that document already has it (a
+    /// re-run over a reloaded snapshot). Returns whether it was added.
+    pub fn insertNew(self: *Index, hash: u64, doc_id: u64) !bool {
+        self.lock.lock();
+        defer self.lock.unlock();
+        var any: [1]Match = undefined;
+        var probe = probeFor(hash, 0, doc_id, &any);
+        _ = self.queryLocked(&probe);
+        if (probe.self_indexed) return false;
+        try self.insertLocked(hash, doc_id);
+        return true;
+    }
+
+    /// Nearest indexed hash of another document within max_hamming bits,
+    /// then index this one, atomically: of two near-identical documents
+    /// parsed at once, exactly one is reported as the other's duplicate.
+    /// The document's own earlier entries (a re-run over a reloaded
+    /// snapshot) never match, and the same hash is not indexed twice.
+    pub fn checkInsert(self: *Index, hash: u64, doc_id: u64, max_hamming: u8) !?Match {
+        self.lock.lock();
+        defer self.lock.unlock();
+        var best: [1]Match = undefined;
+        var probe = probeFor(hash, max_hamming, doc_id, &best);
+        const found = self.queryLocked(&probe);
+        if (!probe.self_indexed) try self.insertLocked(hash, doc_id);
+        return if (found > 0) best[0] else null;
+    }
+
+    /// Write base + delta as one snapshot to `path` (via a temporary file
+    /// renamed over it).
+    pub fn save(self: *Index, path: [*:0]const u8) !void {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        const allocator = std.heap.c_allocator;
+        const n = self.countLocked();
+
+        var tmp_buf: [4096]u8 = undefined;
+        const tmp = try std.fmt.bufPrintZ(&tmp_buf, "{s}.tmp", .{std.mem.span(path)});
+        const file = try std.fs.cwd().createFileZ(tmp, .{});
+        defer file.close();
+        errdefer std.fs.cwd().deleteFileZ(tmp) catch {};
+        try file.setEndPos(snapshotSize(n));
+
+        var off: usize = SNAP_HEADER;
+        const nb = self.baseCount();
+        if (self.base) |*base| try file.pwriteAll(std.mem.sliceAsBytes(base.hashes), off);
+        try file.pwriteAll(std.mem.sliceAsBytes(self.hashes.items), off + nb * @sizeOf(u64));
+        off += n * @sizeOf(u64);
+        if (self.base) |*base| try file.pwriteAll(std.mem.sliceAsBytes(base.doc_ids), off);
+        try file.pwriteAll(std.mem.sliceAsBytes(self.doc_ids.items), off + nb * @sizeOf(u64));
+        off += n * @sizeOf(u64);
+
+        // One counting sort per table: offsets from chunk counts, then ids
+        const offsets = try allocator.alloc(u32, BUCKETS + 1);
+        defer allocator.free(offsets);
+        const ids = try allocator.alloc(u32, n);
+        defer allocator.free(ids);
+        const ids_at = off + CHUNKS * (BUCKETS + 1) * @sizeOf(u32);
+        for (0..CHUNKS) |k| {
+            @memset(offsets, 0);
+            for (0..n) |id| offsets[@as(usize, chunkOf(self.entryHash(id), k)) + 1] += 1;
+            for (1..BUCKETS + 1) |v| offsets[v] += offsets[v - 1];
+            try file.pwriteAll(std.mem.sliceAsBytes(offsets), off + k * (BUCKETS + 1) * @sizeOf(u32));
+            for (0..n) |id| {
+                const slot = &offsets[chunkOf(self.entryHash(id), k)];
+                ids[slot.*] = @intCast(id);
+                slot.* += 1;
+            }
+            try file.pwriteAll(std.mem.sliceAsBytes(ids), ids_at + k * n * @sizeOf(u32));
+        }
+
+        var header = std.mem.zeroes(SnapHeader);
+        header.magic = SNAP_MAGIC;
+        header.version = FORMAT_VERSION;
+        header.count = n;
+        try file.pwriteAll(std.mem.asBytes(&header), 0);
+        try file.sync();
+        try std.fs.cwd().renameZ(tmp, path);
+    }
+};
+
+/// A near-duplicate decision reached before the parse, against every
+/// shard of a sharded index (ddac_set_neardup_verdict). C ABI, 24 bytes.
+pub const Verdict = extern struct {
+    /// The image's average hash
+    hash: u64,
+    /// Nearest indexed document, when matched != 0
+    match_doc: u64,
+    distance: u8,
+    matched: u8,
+    /// Radius the decision was made at
+    max_hamming: u8,
+    _pad: [5]u8,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(Verdict) == 24);
+}
+
+/// Shard owning value `value` of chunk k among n_shards.
+fn chunkShard(k: usize, value: u16, n_shards: u32) u32 {
+    const key = (@as(u64, k) << CHUNK_BITS) | value;
+    return @intCast((key *% 0x9E3779B97F4A7C15 >> 32) % n_shards);
+}
+
+// ============================================================================
+// C-ABI exports
+// ============================================================================
+
+/// Create an empty near-duplicate index. Returns opaque handle, or null.
+export fn ddac_neardup_create() ?*anyopaque {
+    const idx = Index.create() catch return null;
+    // SAFETY: idx was just allocated by c_allocator.create(Index), which returns a well-aligned *Index
+    return @ptrCast(idx);
+}
+
+/// Open an index over the snapshot at path (written by ddac_neardup_save).
+/// The snapshot is mmap'd read-only; later inserts go to memory. Returns
+/// null if the file is missing or not a valid snapshot.
+export fn ddac_neardup_open(path: ?[*:0]const u8) ?*anyopaque {
+    const p = path orelse return null;
+    const idx = Index.open(p) catch return null;
+    // SAFETY: idx was allocated by c_allocator.create(Index) in Index.create, which returns a well-aligned *Index
+    return @ptrCast(idx);
+}
+
+/// Index `hash` for document doc_id. Thread-safe. Returns 0, or -1 on
+/// allocation failure or a full index (2^32 - 1 entries).
+export fn ddac_neardup_insert(handle: ?*anyopaque, hash: u64, doc_id: u64) i32 {
+    const ptr = handle orelse return -1;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+    idx.insert(hash, doc_id) catch return -1;
+    return 0;
+}
+
+/// Find up to max_out (at most 64) indexed hashes within max_hamming bits
+/// of `hash` (clamped to 15), nearest first, into out_doc_ids and
+/// out_distances.
+/// Thread-safe. Returns the number found, or -1 on a null argument.
+export fn ddac_neardup_query(
+    handle: ?*anyopaque,
+    hash: u64,
+    max_hamming: u8,
+    out_doc_ids: ?[*]u64,
+    out_distances: ?[*]u8,
+    max_out: u32,
+) i32 {
+    const ptr = handle orelse return -1;
+    const ids = out_doc_ids orelse return -1;
+    const dists = out_distances orelse return -1;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+
+    var buf: [64]Match = undefined;
+    const n = idx.query(hash, max_hamming, buf[0..@min(max_out, buf.len)]);
+    for (buf[0..n], 0..) |m, i| {
+        ids[i] = m.doc_id;
+        dists[i] = m.distance;
+    }
+    return @intCast(n);
+}
+
+/// Number of indexed hashes (snapshot base + inserts).
+export fn ddac_neardup_count(handle: ?*anyopaque) u64 {
+    const ptr = handle orelse return 0;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+    return idx.count();
+}
+
+/// Write the whole index as a snapshot to path. Returns 0, or -1 on failure
+/// (an existing snapshot at path is left as it was).
+export fn ddac_neardup_save(handle: ?*anyopaque, path: ?[*:0]const u8) i32 {
+    const ptr = handle orelse return -1;
+    const p = path orelse return -1;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+    idx.save(p) catch |err| {
+        std.log.err("Near-dup snapshot save failed: {s}", .{@errorName(err)});
+        return -1;
+    };
+    return 0;
+}
+
+/// Shards (of n_shards) owning a chunk value within max_hamming / 4 bits
+/// of hash's, deduplicated, into out_shards (room for n_shards). With
+/// max_hamming 0 these are the at most four shards hash is inserted into;
+/// querying every shard of the max_hamming set finds each inserted hash
+/// within max_hamming bits (clamped to 15). Returns the number written.
+export fn ddac_neardup_shards(hash: u64, max_hamming: u8, n_shards: u32, out_shards: ?[*]u32) u32 {
+    const out = out_shards orelse return 0;
+    if (n_shards == 0) return 0;
+    const allocator = std.heap.c_allocator;
+    var seen = std.DynamicBitSetUnmanaged.initEmpty(allocator, n_shards) catch return 0;
+    defer seen.deinit(allocator);
+
+    const sub = @min(max_hamming, MAX_HAMMING) / CHUNKS;
+    var n: u32 = 0;
+    for (0..CHUNKS) |k| {
+        var values = ChunkNeighbours{ .own = chunkOf(hash, k), .sub = sub };
+        while (values.next()) |value| {
+            const shard = chunkShard(k, value, n_shards);
+            if (seen.isSet(shard)) continue;
+            seen.set(shard);
+            out[n] = shard;
+            n += 1;
+        }
+    }
+    return n;
+}
+
+/// For each of n hashes (of document doc_ids[i]), the nearest indexed hash
+/// of another document within max_hamming bits: out_doc_ids[i] and
+/// out_distances[i], or distance NO_MATCH (0xFF). Read-only; thread-safe.
+/// Returns the number of hashes with a match, or -1 on a null argument.
+export fn ddac_neardup_check_batch(
+    handle: ?*anyopaque,
+    hashes: ?[*]const u64,
+    doc_ids: ?[*]const u64,
+    n: u32,
+    max_hamming: u8,
+    out_doc_ids: ?[*]u64,
+    out_distances: ?[*]u8,
+) i32 {
+    const ptr = handle orelse return -1;
+    const hs = hashes orelse return -1;
+    const docs = doc_ids orelse return -1;
+    const ids = out_doc_ids orelse return -1;
+    const dists = out_distances orelse return -1;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+
+    var found: i32 = 0;
+    for (0..n) |i| {
+        if (idx.nearest(hs[i], docs[i], max_hamming)) |m| {
+            ids[i] = m.doc_id;
+            dists[i] = m.distance;
+            found += 1;
+        } else {
+            ids[i] = 0;
+            dists[i] = NO_MATCH;
+        }
+    }
+    return found;
+}
+
+/// Index n hashes, each as doc_ids[i], skipping a hash its document
+/// already has. Thread-safe. Returns the number added, or -1 on a null
+/// argument, allocation failure or a full index (earlier ones stay).
+export fn ddac_neardup_insert_batch(
+    handle: ?*anyopaque,
+    hashes: ?[*]const u64,
+    doc_ids: ?[*]const u64,
+    n: u32,
+) i32 {
+    const ptr = handle orelse return -1;
+    const hs = hashes orelse return -1;
+    const docs = doc_ids orelse return -1;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+
+    var added: i32 = 0;
+    for (0..n) |i| {
+        if (idx.insertNew(hs[i], docs[i]) catch return -1) added += 1;
+    }
+    return added;
+}
+
+/// Free an index. Safe to call with null.
+export fn ddac_neardup_free(handle: ?*anyopaque) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from ddac_neardup_create/open() which return an *Index via @ptrCast; alignment is guaranteed by c_allocator
+    const idx: *Index = @ptrCast(@alignCast(ptr));
+    idx.destroy();
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "queries find every hash within the radius once, nearest first" {
+    const idx = try Index.create();
+    defer idx.destroy();
+
+    const h: u64 = 0x0123_4567_89AB_CDEF;
+    try idx.insert(h, 1);
+    try idx.insert(h ^ 0b1, 2); // 1 bit
+    try idx.insert(h ^ 0x0001_0001_0001_0001, 3); // 4 bits, one per chunk
+    try idx.insert(h ^ 0x00FF_0000_0000_0000, 4); // 8 bits in one chunk
+    try idx.insert(~h, 5);
+
+    var out: [8]Match = undefined;
+    try std.testing.expectEqual(@as(usize, 2), idx.query(h, 3, &out));
+    try std.testing.expectEqual(@as(u64, 1), out[0].doc_id);
+    try std.testing.expectEqual(@as(u8, 1), out[1].distance);
+
+    // Radius 8: 2 bits per chunk, which still reaches hash 4 through the
+    // three chunks it leaves untouched
+    const n = idx.query(h, 8, &out);
+    try std.testing.expectEqual(@as(usize, 4), n);
+    try std.testing.expectEqual(@as(u8, 8), out[3].distance);
+}
+
+test "check-insert reports the earlier near-duplicate" {
+    const idx = try Index.create();
+    defer idx.destroy();
+    try std.testing.expect((try idx.checkInsert(0xF0F0, 7, 4)) == null);
+    const m = (try idx.checkInsert(0xF0F1, 8, 4)).?;
+    try std.testing.expectEqual(@as(u64, 7), m.doc_id);
+    try std.testing.expectEqual(@as(usize, 2), idx.count());
+}
+
+test "check-insert never matches the document's own entry" {
+    const idx = try Index.create();
+    defer idx.destroy();
+    try std.testing.expect((try idx.checkInsert(0xF0F0, 7, 4)) == null);
+    // Same document again (a re-run): no self-match, no second entry
+    try std.testing.expect((try idx.checkInsert(0xF0F0, 7, 4)) == null);
+    try std.testing.expectEqual(@as(usize, 1), idx.count());
+    // Another document with the same hash still matches it
+    const m = (try idx.checkInsert(0xF0F0, 9, 4)).?;
+    try std.testing.expectEqual(@as(u64, 7), m.doc_id);
+    try std.testing.expectEqual(@as(u8, 0), m.distance);
+}
+
+test "every same-popcount mask is enumerated" {
+    var seen: usize = 0;
+    var mask: ?u16 = 0b11;
+    while (mask) |m| : (mask = nextSameBits(m)) seen += 1;
+    try std.testing.expectEqual(@as(usize, 120), seen);
+}
+
+test "neighbours of a chunk value are each enumerated once" {
+    var values = ChunkNeighbours{ .own = 0x1234, .sub = 2 };
+    var n: usize = 0;
+    try std.testing.expectEqual(@as(?u16, 0x1234), values.next());
+    n += 1;
+    while (values.next()) |v| {
+        try std.testing.expect(@popCount(v ^ 0x1234) <= 2);
+        n += 1;
+    }
+    try std.testing.expectEqual(@as(usize, 1 + 16 + 120), n);
+}
+
+test "a hash inserted into its owners is found through the query shards" {
+    const n_shards = 8;
+    var indexes: [n_shards]*Index = undefined;
+    for (&indexes) |*idx| idx.* = try Index.create();
+    defer for (indexes) |idx| idx.destroy();
+
+    const h: u64 = 0x0123_4567_89AB_CDEF;
+    const near = h ^ 0x0003_0000_0001_0001; // 4 bits, spread over three chunks
+    var owners: [n_shards]u32 = undefined;
+    const n_owners = ddac_neardup_shards(near, 0, n_shards, &owners);
+    try std.testing.expect(n_owners >= 1 and n_owners <= 4);
+    for (owners[0..n_owners]) |s| try indexes[s].insert(near, 2);
+
+    var visit: [n_shards]u32 = undefined;
+    const n_visit = ddac_neardup_shards(h, 6, n_shards, &visit);
+    var best: ?Match = null;
+    for (visit[0..n_visit]) |s| {
+        if (indexes[s].nearest(h, 1, 6)) |m| best = m;
+    }
+    try std.testing.expectEqual(@as(u64, 2), best.?.doc_id);
+    try std.testing.expectEqual(@as(u8, 4), best.?.distance);
+}
+
+test "insert-new skips a document's own hash" {
+    const idx = try Index.create();
+    defer idx.destroy();
+    try std.testing.expect(try idx.insertNew(0xF0F0, 7));
+    try std.testing.expect(!(try idx.insertNew(0xF0F0, 7)));
+    try std.testing.expect(try idx.insertNew(0xF0F0, 8));
+    try std.testing.expect(idx.nearest(0xF0F0, 7, 4).?.doc_id == 8);
+    try std.testing.expectEqual(@as(usize, 2), idx.count());
+}
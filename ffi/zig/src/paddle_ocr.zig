@@ -0,0 +1,619 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — PaddleOCR Batch Inference (Paddle Inference C API)
+//
+// GPU half of the OCR coprocessor (gpu_ocr.zig). For one batch of images:
+//   1. Decode with Leptonica and convert to 32 bpp RGB
+//   2. Detection: resize (longest side <= DET_MAX_SIDE, multiples of 32),
+//      assemble a zero-padded NCHW float tensor per group, run DBNet, and
+//      turn each probability map into line boxes (threshold + connected
+//      components + unclip)
+//   3. Recognition: crop every line of the batch, sort by aspect ratio,
+//      resize to height 48, assemble NCHW tensors, run CRNN/SVTR and
+//      CTC-decode against the character dictionary
+//   4. Join each image's lines in reading order into the batch text arena
+//
+// Paddle Inference is loaded via dlopen — no link-time dependency. Models
+// are read from a directory laid out the way PaddleOCR exports them:
+//   {dir}/det/inference.pdmodel   {dir}/det/inference.pdiparams
+//   {dir}/rec/inference.pdmodel   {dir}/rec/inference.pdiparams
+//   {dir}/dict.txt                one character per line
+//
+// Everything here runs on the coprocessor's worker thread; predictors are
+// not shared between threads.
+
+const std = @import("std");
+const text_arena = @import("text_arena.zig");
+
+const c = @cImport({
+    @cInclude("leptonica/allheaders.h");
+});
+
+// ============================================================================
+// Tuning
+// ============================================================================
+
+/// Detection input: longest side is scaled down to this (PP-OCR default).
+const DET_MAX_SIDE: u32 = 960;
+/// Images per detection run. Detection tensors are padded to the group's
+/// largest image, so groups are formed from images sorted by area.
+const DET_BATCH: usize = 8;
+/// Probability above which a detection pixel counts as text.
+const DET_THRESH: f32 = 0.3;
+/// Mean probability a box needs to be kept.
+const DET_BOX_THRESH: f32 = 0.6;
+/// DB unclip ratio: boxes are grown by area * ratio / perimeter.
+const DET_UNCLIP_RATIO: f32 = 1.5;
+/// Boxes thinner than this (either side, detection pixels) are noise.
+const DET_MIN_SIZE: c_int = 3;
+
+/// Recognition input height (PP-OCRv3/v4 rec_image_shape 3x48xW).
+const REC_HEIGHT: u32 = 48;
+/// Cap on recognition width (very long lines are squeezed).
+const REC_MAX_WIDTH: u32 = 1280;
+/// Line crops per recognition run.
+const REC_BATCH: usize = 32;
+/// Lines whose mean character probability is below this are dropped.
+const REC_DROP_SCORE: f32 = 0.5;
+
+/// Images smaller than this in either dimension are skipped (as on the
+/// CPU path: icons and spacers produce no useful text).
+const MIN_DIMENSION: c_int = 10;
+
+/// GPU memory pool reserved per predictor at creation (MB).
+const GPU_MEMORY_POOL_MB: u64 = 512;
+
+// ============================================================================
+// Paddle Inference C API (dlopen)
+// ============================================================================
+
+const OneDimArrayCstr = extern struct { size: usize, data: [*][*:0]u8 };
+const OneDimArrayInt32 = extern struct { size: usize, data: [*]i32 };
+
+/// Function table resolved from libpaddle_inference_c; each field name is
+/// the symbol with its "PD_" prefix removed.
+const Api = struct {
+    ConfigCreate: *const fn () callconv(.c) ?*anyopaque,
+    ConfigSetModel: *const fn (?*anyopaque, [*:0]const u8, [*:0]const u8) callconv(.c) void,
+    ConfigEnableUseGpu: *const fn (?*anyopaque, u64, i32, c_int) callconv(.c) void,
+    ConfigDisableGlogInfo: *const fn (?*anyopaque) callconv(.c) void,
+    PredictorCreate: *const fn (?*anyopaque) callconv(.c) ?*anyopaque,
+    PredictorDestroy: *const fn (?*anyopaque) callconv(.c) void,
+    PredictorGetInputNames: *const fn (?*anyopaque) callconv(.c) ?*OneDimArrayCstr,
+    PredictorGetOutputNames: *const fn (?*anyopaque) callconv(.c) ?*OneDimArrayCstr,
+    PredictorGetInputHandle: *const fn (?*anyopaque, [*:0]const u8) callconv(.c) ?*anyopaque,
+    PredictorGetOutputHandle: *const fn (?*anyopaque, [*:0]const u8) callconv(.c) ?*anyopaque,
+    PredictorRun: *const fn (?*anyopaque) callconv(.c) i8,
+    TensorReshape: *const fn (?*anyopaque, usize, [*]const i32) callconv(.c) void,
+    TensorCopyFromCpuFloat: *const fn (?*anyopaque, [*]const f32) callconv(.c) void,
+    TensorCopyToCpuFloat: *const fn (?*anyopaque, [*]f32) callconv(.c) void,
+    TensorGetShape: *const fn (?*anyopaque) callconv(.c) ?*OneDimArrayInt32,
+    TensorDestroy: *const fn (?*anyopaque) callconv(.c) void,
+    OneDimArrayCstrDestroy: *const fn (?*OneDimArrayCstr) callconv(.c) void,
+    OneDimArrayInt32Destroy: *const fn (?*OneDimArrayInt32) callconv(.c) void,
+
+    fn load(lib: *std.DynLib) ?Api {
+        var api: Api = undefined;
+        inline for (@typeInfo(Api).@"struct".fields) |f| {
+            @field(api, f.name) = lib.lookup(f.type, "PD_" ++ f.name) orelse return null;
+        }
+        return api;
+    }
+};
+
+/// PD_PRECISION_FLOAT32
+const PRECISION_FLOAT32: c_int = 0;
+
+/// One predictor with its (single) input and output tensor handles.
+const Model = struct {
+    predictor: *anyopaque,
+    input: *anyopaque,
+    output: *anyopaque,
+
+    fn open(api: *const Api, dir: []const u8, sub: []const u8) ?Model {
+        var prog_buf: [1024]u8 = undefined;
+        var params_buf: [1024]u8 = undefined;
+        const prog = std.fmt.bufPrintZ(&prog_buf, "{s}/{s}/inference.pdmodel", .{ dir, sub }) catch return null;
+        const params = std.fmt.bufPrintZ(&params_buf, "{s}/{s}/inference.pdiparams", .{ dir, sub }) catch return null;
+        std.fs.cwd().access(prog, .{}) catch return null;
+        std.fs.cwd().access(params, .{}) catch return null;
+
+        const config = api.ConfigCreate() orelse return null;
+        api.ConfigSetModel(config, prog, params);
+        api.ConfigEnableUseGpu(config, GPU_MEMORY_POOL_MB, 0, PRECISION_FLOAT32);
+        api.ConfigDisableGlogInfo(config);
+        // The predictor takes ownership of the config
+        const predictor = api.PredictorCreate(config) orelse return null;
+
+        const in_names = api.PredictorGetInputNames(predictor);
+        defer if (in_names) |a| api.OneDimArrayCstrDestroy(a);
+        const out_names = api.PredictorGetOutputNames(predictor);
+        defer if (out_names) |a| api.OneDimArrayCstrDestroy(a);
+        const ins = in_names orelse return destroy(api, predictor);
+        const outs = out_names orelse return destroy(api, predictor);
+        if (ins.size == 0 or outs.size == 0) return destroy(api, predictor);
+
+        const input = api.PredictorGetInputHandle(predictor, ins.data[0]) orelse return destroy(api, predictor);
+        const output = api.PredictorGetOutputHandle(predictor, outs.data[0]) orelse {
+            api.TensorDestroy(input);
+            return destroy(api, predictor);
+        };
+        return .{ .predictor = predictor, .input = input, .output = output };
+    }
+
+    fn destroy(api: *const Api, predictor: *anyopaque) ?Model {
+        api.PredictorDestroy(predictor);
+        return null;
+    }
+
+    fn close(self: *Model, api: *const Api) void {
+        api.TensorDestroy(self.input);
+        api.TensorDestroy(self.output);
+        api.PredictorDestroy(self.predictor);
+    }
+
+    /// Run on an NCHW tensor. The output is copied into `out`; its shape
+    /// (rank <= 4, missing trailing dims = 1) into `out_shape`.
+    fn run(
+        self: *Model,
+        api: *const Api,
+        allocator: std.mem.Allocator,
+        input: []const f32,
+        shape: [4]i32,
+        out: *std.ArrayList(f32),
+        out_shape: *[4]usize,
+    ) bool {
+        api.TensorReshape(self.input, 4, &shape);
+        api.TensorCopyFromCpuFloat(self.input, input.ptr);
+        if (api.PredictorRun(self.predictor) == 0) return false;
+
+        const dims = api.TensorGetShape(self.output) orelse return false;
+        defer api.OneDimArrayInt32Destroy(dims);
+        out_shape.* = .{ 1, 1, 1, 1 };
+        var total: usize = 1;
+        for (0..@min(dims.size, 4)) |i| {
+            if (dims.data[i] <= 0) return false;
+            out_shape[i] = @intCast(dims.data[i]);
+            total *= out_shape[i];
+        }
+        out.resize(allocator, total) catch return false;
+        api.TensorCopyToCpuFloat(self.output, out.items.ptr);
+        return true;
+    }
+};
+
+// ============================================================================
+// Engine
+// ============================================================================
+
+/// One image of a batch. Inputs: path. Outputs: everything else.
+pub const Item = struct {
+    path: [*:0]const u8,
+    /// 0=success, 1=unreadable image, 2=skipped (too small), 3=inference failed
+    status: u8 = 3,
+    /// Mean recognition confidence (0-100), -1 if no lines
+    confidence: i8 = -1,
+    /// This image's text in the batch arena
+    text_offset: usize = 0,
+    text_length: usize = 0,
+};
+
+/// A detected text line, in original image coordinates.
+const Line = struct {
+    item: u32,
+    x: c_int,
+    y: c_int,
+    w: c_int,
+    h: c_int,
+    /// Recognised text in Engine.line_text
+    text_start: u32 = 0,
+    text_len: u32 = 0,
+    score: f32 = 0,
+};
+
+const DET_MEAN = [3]f32{ 0.485, 0.456, 0.406 };
+const DET_STD = [3]f32{ 0.229, 0.224, 0.225 };
+const REC_MEAN = [3]f32{ 0.5, 0.5, 0.5 };
+const REC_STD = [3]f32{ 0.5, 0.5, 0.5 };
+
+pub const Engine = struct {
+    allocator: std.mem.Allocator,
+    lib: std.DynLib,
+    api: Api,
+    det: Model,
+    rec: Model,
+    /// dict.txt contents; `dict` slices into it. Class k of the
+    /// recogniser output is dict[k - 1]; class 0 is the CTC blank.
+    dict_data: []u8,
+    dict: std.ArrayList([]const u8) = .{},
+    // Scratch reused across batches
+    tensor: std.ArrayList(f32) = .{},
+    output: std.ArrayList(f32) = .{},
+    lines: std.ArrayList(Line) = .{},
+    line_text: std.ArrayList(u8) = .{},
+
+    /// Load the library, both predictors and the dictionary. Returns null
+    /// if any piece is missing (the coprocessor then defers to CPU OCR).
+    pub fn open(allocator: std.mem.Allocator, model_dir: []const u8) ?*Engine {
+        var lib = std.DynLib.open("libpaddle_inference_c.so") catch
+            std.DynLib.open("libpaddle_inference.so") catch
+            return null;
+        const api = Api.load(&lib) orelse {
+            lib.close();
+            return null;
+        };
+
+        var dict_buf: [1024]u8 = undefined;
+        const dict_path = std.fmt.bufPrint(&dict_buf, "{s}/dict.txt", .{model_dir}) catch {
+            lib.close();
+            return null;
+        };
+        const dict_data = readWhole(allocator, dict_path) catch {
+            lib.close();
+            return null;
+        };
+
+        var det = Model.open(&api, model_dir, "det") orelse {
+            allocator.free(dict_data);
+            lib.close();
+            return null;
+        };
+        var rec = Model.open(&api, model_dir, "rec") orelse {
+            det.close(&api);
+            allocator.free(dict_data);
+            lib.close();
+            return null;
+        };
+
+        const self = allocator.create(Engine) catch {
+            rec.close(&api);
+            det.close(&api);
+            allocator.free(dict_data);
+            lib.close();
+            return null;
+        };
+        self.* = .{
+            .allocator = allocator,
+            .lib = lib,
+            .api = api,
+            .det = det,
+            .rec = rec,
+            .dict_data = dict_data,
+        };
+
+        var it = std.mem.splitScalar(u8, dict_data, '\n');
+        while (it.next()) |line| {
+            const ch = std.mem.trimRight(u8, line, "\r");
+            if (ch.len == 0) continue;
+            self.dict.append(allocator, ch) catch break;
+        }
+        // PP-OCR models are exported with use_space_char: the last class is ' '
+        self.dict.append(allocator, " ") catch {};
+        return self;
+    }
+
+    pub fn close(self: *Engine) void {
+        self.rec.close(&self.api);
+        self.det.close(&self.api);
+        self.dict.deinit(self.allocator);
+        self.allocator.free(self.dict_data);
+        self.tensor.deinit(self.allocator);
+        self.output.deinit(self.allocator);
+        self.lines.deinit(self.allocator);
+        self.line_text.deinit(self.allocator);
+        self.lib.close();
+        self.allocator.destroy(self);
+    }
+
+    /// OCR every item; each image's lines are appended to `text`.
+    pub fn recognize(self: *Engine, items: []Item, text: *text_arena.TextArena) void {
+        var pixs: [256][*c]c.PIX = undefined;
+        std.debug.assert(items.len <= pixs.len);
+        defer for (pixs[0..items.len]) |pix| destroyPix(pix);
+
+        // 1. Decode
+        for (items, 0..) |*item, i| {
+            pixs[i] = decode(item.path);
+            const pix = pixs[i];
+            if (pix == null) {
+                item.status = 1;
+                continue;
+            }
+            if (c.pixGetWidth(pix) < MIN_DIMENSION or c.pixGetHeight(pix) < MIN_DIMENSION) {
+                item.status = 2;
+                continue;
+            }
+            item.status = 0;
+        }
+
+        // 2. Detection, in groups of similar size
+        self.lines.clearRetainingCapacity();
+        self.line_text.clearRetainingCapacity();
+        var order: [256]u32 = undefined;
+        var n_live: usize = 0;
+        for (items, 0..) |item, i| {
+            if (item.status != 0) continue;
+            order[n_live] = @intCast(i);
+            n_live += 1;
+        }
+        const ByArea = struct {
+            fn lessThan(p: [][*c]c.PIX, a: u32, b: u32) bool {
+                return area(p[a]) > area(p[b]);
+            }
+            fn area(pix: [*c]c.PIX) i64 {
+                return @as(i64, c.pixGetWidth(pix)) * c.pixGetHeight(pix);
+            }
+        };
+        std.mem.sort(u32, order[0..n_live], @as([][*c]c.PIX, pixs[0..items.len]), ByArea.lessThan);
+
+        var g: usize = 0;
+        while (g < n_live) : (g += DET_BATCH) {
+            const group = order[g..@min(g + DET_BATCH, n_live)];
+            if (!self.detect(group, pixs[0..items.len])) {
+                for (group) |idx| items[idx].status = 3;
+            }
+        }
+
+        // 3. Recognition over every line of the batch, similar widths together
+        const ByAspect = struct {
+            fn lessThan(_: void, a: Line, b: Line) bool {
+                return @as(i64, a.w) * b.h < @as(i64, b.w) * a.h;
+            }
+        };
+        std.mem.sort(Line, self.lines.items, {}, ByAspect.lessThan);
+        var r: usize = 0;
+        while (r < self.lines.items.len) : (r += REC_BATCH) {
+            const group = self.lines.items[r..@min(r + REC_BATCH, self.lines.items.len)];
+            if (!self.recognizeLines(group, pixs[0..items.len])) {
+                for (group) |line| items[line.item].status = 3;
+            }
+        }
+
+        // 4. Reading order (top to bottom, then left to right) and output
+        const ByPosition = struct {
+            fn lessThan(_: void, a: Line, b: Line) bool {
+                if (a.item != b.item) return a.item < b.item;
+                // Lines whose tops are within half a line of each other share a row
+                const dy = if (a.y > b.y) a.y - b.y else b.y - a.y;
+                if (dy * 2 < @min(a.h, b.h)) return a.x < b.x;
+                return a.y < b.y;
+            }
+        };
+        std.mem.sort(Line, self.lines.items, {}, ByPosition.lessThan);
+
+        var li: usize = 0;
+        for (items, 0..) |*item, i| {
+            const first = li;
+            while (li < self.lines.items.len and self.lines.items[li].item == i) li += 1;
+            if (item.status != 0) continue;
+
+            item.text_offset = text.slice().len;
+            var score_sum: f32 = 0;
+            var kept: u32 = 0;
+            for (self.lines.items[first..li]) |line| {
+                if (line.text_len == 0 or line.score < REC_DROP_SCORE) continue;
+                if (kept > 0) _ = text.append("\n");
+                _ = text.append(self.line_text.items[line.text_start..][0..line.text_len]);
+                score_sum += line.score;
+                kept += 1;
+            }
+            if (kept > 0) {
+                _ = text.append("\n");
+                item.confidence = @intFromFloat(@round(100 * score_sum / @as(f32, @floatFromInt(kept))));
+            }
+            item.text_length = text.slice().len - item.text_offset;
+        }
+    }
+
+    /// Run detection on one group and append its line boxes.
+    fn detect(self: *Engine, group: []const u32, pixs: [][*c]c.PIX) bool {
+        var sizes: [DET_BATCH][2]u32 = undefined;
+        var max_w: u32 = 32;
+        var max_h: u32 = 32;
+        for (group, 0..) |idx, j| {
+            const pix = pixs[idx];
+            const w: u32 = @intCast(c.pixGetWidth(pix));
+            const h: u32 = @intCast(c.pixGetHeight(pix));
+            const scale = @min(1.0, @as(f32, @floatFromInt(DET_MAX_SIDE)) / @as(f32, @floatFromInt(@max(w, h))));
+            sizes[j] = .{ roundTo32(@as(f32, @floatFromInt(w)) * scale), roundTo32(@as(f32, @floatFromInt(h)) * scale) };
+            max_w = @max(max_w, sizes[j][0]);
+            max_h = @max(max_h, sizes[j][1]);
+        }
+
+        const plane = @as(usize, max_w) * max_h;
+        self.tensor.resize(self.allocator, group.len * 3 * plane) catch return false;
+        @memset(self.tensor.items, 0);
+        for (group, 0..) |idx, j| {
+            const scaled = c.pixScaleToSize(pixs[idx], @intCast(sizes[j][0]), @intCast(sizes[j][1]));
+            if (scaled == null) return false;
+            defer destroyPix(scaled);
+            fillTensor(self.tensor.items[j * 3 * plane ..][0 .. 3 * plane], max_w, max_h, scaled, DET_MEAN, DET_STD);
+        }
+
+        var shape_out: [4]usize = undefined;
+        const shape = [4]i32{ @intCast(group.len), 3, @intCast(max_h), @intCast(max_w) };
+        if (!self.det.run(&self.api, self.allocator, self.tensor.items, shape, &self.output, &shape_out)) return false;
+        // Expect [N, 1, H, W]
+        if (shape_out[0] != group.len or shape_out[2] != max_h or shape_out[3] != max_w) return false;
+
+        for (group, 0..) |idx, j| {
+            const prob = self.output.items[j * plane * shape_out[1] ..][0..plane];
+            self.boxesFromMap(@intCast(idx), pixs[idx], prob, max_w, sizes[j][0], sizes[j][1]);
+        }
+        return true;
+    }
+
+    /// Threshold one probability map, take connected components as lines,
+    /// grow them (DB unclip) and map them back to the original image.
+    fn boxesFromMap(self: *Engine, item: u32, pix: [*c]c.PIX, prob: []const f32, stride: u32, rw: u32, rh: u32) void {
+        const bin = c.pixCreate(@intCast(rw), @intCast(rh), 1);
+        if (bin == null) return;
+        defer destroyPix(bin);
+        const data = c.pixGetData(bin);
+        const wpl: usize = @intCast(c.pixGetWpl(bin));
+        for (0..rh) |y| {
+            const row = prob[y * stride ..][0..rw];
+            for (row, 0..) |p, x| {
+                if (p > DET_THRESH) data[y * wpl + x / 32] |= @as(u32, 0x80000000) >> @intCast(x % 32);
+            }
+        }
+
+        var boxa = c.pixConnCompBB(bin, 4);
+        if (boxa == null) return;
+        defer c.boxaDestroy(&boxa);
+
+        const sx = @as(f32, @floatFromInt(c.pixGetWidth(pix))) / @as(f32, @floatFromInt(rw));
+        const sy = @as(f32, @floatFromInt(c.pixGetHeight(pix))) / @as(f32, @floatFromInt(rh));
+        const n = c.boxaGetCount(boxa);
+        var b: c_int = 0;
+        while (b < n) : (b += 1) {
+            var bx: c_int = 0;
+            var by: c_int = 0;
+            var bw: c_int = 0;
+            var bh: c_int = 0;
+            if (c.boxaGetBoxGeometry(boxa, b, &bx, &by, &bw, &bh) != 0) continue;
+            if (@min(bw, bh) < DET_MIN_SIZE) continue;
+
+            // Box score: mean probability over the box
+            const ux: usize = @intCast(bx);
+            const uy: usize = @intCast(by);
+            const uw: usize = @intCast(bw);
+            const uh: usize = @intCast(bh);
+            var sum: f32 = 0;
+            for (uy..uy + uh) |y| {
+                for (prob[y * stride + ux ..][0..uw]) |p| sum += p;
+            }
+            if (sum / @as(f32, @floatFromInt(bw * bh)) < DET_BOX_THRESH) continue;
+
+            // DB shrinks text regions during training; grow them back
+            const fw: f32 = @floatFromInt(bw);
+            const fh: f32 = @floatFromInt(bh);
+            const d = fw * fh * DET_UNCLIP_RATIO / (2 * (fw + fh));
+            const x0 = @max(0, (@as(f32, @floatFromInt(bx)) - d) * sx);
+            const y0 = @max(0, (@as(f32, @floatFromInt(by)) - d) * sy);
+            const x1 = @min(@as(f32, @floatFromInt(c.pixGetWidth(pix))), (@as(f32, @floatFromInt(bx + bw)) + d) * sx);
+            const y1 = @min(@as(f32, @floatFromInt(c.pixGetHeight(pix))), (@as(f32, @floatFromInt(by + bh)) + d) * sy);
+            if (x1 - x0 < 1 or y1 - y0 < 1) continue;
+
+            self.lines.append(self.allocator, .{
+                .item = item,
+                .x = @intFromFloat(x0),
+                .y = @intFromFloat(y0),
+                .w = @intFromFloat(x1 - x0),
+                .h = @intFromFloat(y1 - y0),
+            }) catch return;
+        }
+    }
+
+    /// Recognise one group of line crops; fills text_start/text_len/score.
+    fn recognizeLines(self: *Engine, group: []Line, pixs: [][*c]c.PIX) bool {
+        var max_ratio: f32 = 1;
+        for (group) |line| max_ratio = @max(max_ratio, @as(f32, @floatFromInt(line.w)) / @as(f32, @floatFromInt(line.h)));
+        const width: u32 = @min(REC_MAX_WIDTH, @as(u32, @intFromFloat(@ceil(@as(f32, @floatFromInt(REC_HEIGHT)) * max_ratio))));
+
+        const plane = @as(usize, width) * REC_HEIGHT;
+        self.tensor.resize(self.allocator, group.len * 3 * plane) catch return false;
+        @memset(self.tensor.items, 0);
+        for (group, 0..) |line, j| {
+            var box = c.boxCreate(line.x, line.y, line.w, line.h);
+            if (box == null) return false;
+            defer c.boxDestroy(&box);
+            const crop = c.pixClipRectangle(pixs[line.item], box, null);
+            if (crop == null) continue;
+            defer destroyPix(crop);
+
+            const ratio = @as(f32, @floatFromInt(line.w)) / @as(f32, @floatFromInt(line.h));
+            const w: u32 = @max(1, @min(width, @as(u32, @intFromFloat(@ceil(@as(f32, @floatFromInt(REC_HEIGHT)) * ratio)))));
+            const scaled = c.pixScaleToSize(crop, @intCast(w), REC_HEIGHT);
+            if (scaled == null) continue;
+            defer destroyPix(scaled);
+            fillTensor(self.tensor.items[j * 3 * plane ..][0 .. 3 * plane], width, REC_HEIGHT, scaled, REC_MEAN, REC_STD);
+        }
+
+        var shape_out: [4]usize = undefined;
+        const shape = [4]i32{ @intCast(group.len), 3, REC_HEIGHT, @intCast(width) };
+        if (!self.rec.run(&self.api, self.allocator, self.tensor.items, shape, &self.output, &shape_out)) return false;
+        // Expect [N, T, C] softmax probabilities
+        if (shape_out[0] != group.len) return false;
+        const steps = shape_out[1];
+        const classes = shape_out[2];
+
+        for (group, 0..) |*line, j| {
+            line.text_start = @intCast(self.line_text.items.len);
+            var prev: usize = 0;
+            var sum: f32 = 0;
+            var count: u32 = 0;
+            for (0..steps) |t| {
+                const probs = self.output.items[(j * steps + t) * classes ..][0..classes];
+                const k = std.mem.indexOfMax(f32, probs);
+                // CTC: drop blanks (class 0) and repeats
+                if (k != 0 and k != prev and k - 1 < self.dict.items.len) {
+                    self.line_text.appendSlice(self.allocator, self.dict.items[k - 1]) catch return false;
+                    sum += probs[k];
+                    count += 1;
+                }
+                prev = k;
+            }
+            line.text_len = @intCast(self.line_text.items.len - line.text_start);
+            line.score = if (count > 0) sum / @as(f32, @floatFromInt(count)) else 0;
+        }
+        return true;
+    }
+};
+
+// ============================================================================
+// Tensor assembly
+// ============================================================================
+
+/// Read an image and convert it to 32 bpp RGB. Null if unreadable.
+fn decode(path: [*:0]const u8) [*c]c.PIX {
+    const pix = c.pixRead(path);
+    if (pix == null or c.pixGetDepth(pix) == 32) return pix;
+    defer destroyPix(pix);
+    return c.pixConvertTo32(pix);
+}
+
+/// pixDestroy() takes the address of the caller's pointer; null is a no-op.
+fn destroyPix(pix: [*c]c.PIX) void {
+    var p = pix;
+    c.pixDestroy(&p);
+}
+
+/// Read a whole (small) file into a new allocation.
+fn readWhole(allocator: std.mem.Allocator, path: []const u8) ![]u8 {
+    const file = try std.fs.cwd().openFile(path, .{});
+    defer file.close();
+    const stat = try file.stat();
+    const buf = try allocator.alloc(u8, @intCast(stat.size));
+    errdefer allocator.free(buf);
+    const n = try file.readAll(buf);
+    if (n != buf.len) return error.ShortRead;
+    return buf;
+}
+
+/// Round to the nearest multiple of 32 (DBNet downsamples by 32), min 32.
+fn roundTo32(v: f32) u32 {
+    return @max(32, @as(u32, @intFromFloat(@round(v / 32))) * 32);
+}
+
+/// Write one 32 bpp image into the top-left of a (3, h, w) NCHW slot,
+/// normalised as PaddleOCR does: channels in B, G, R order,
+/// (value / 255 - mean[ch]) / std[ch]. The rest of the slot is left as is.
+fn fillTensor(dst: []f32, w: u32, h: u32, pix: [*c]c.PIX, mean: [3]f32, stddev: [3]f32) void {
+    const pw: usize = @intCast(@min(@as(c_int, @intCast(w)), c.pixGetWidth(pix)));
+    const ph: usize = @intCast(@min(@as(c_int, @intCast(h)), c.pixGetHeight(pix)));
+    const data = c.pixGetData(pix);
+    const wpl: usize = @intCast(c.pixGetWpl(pix));
+    const plane = @as(usize, w) * h;
+    for (0..ph) |y| {
+        for (0..pw) |x| {
+            // Leptonica RGBA word: R in the high byte, then G, B
+            const px: u32 = data[y * wpl + x];
+            const bgr = [3]u32{ (px >> 8) & 0xff, (px >> 16) & 0xff, px >> 24 };
+            for (0..3) |ch| {
+                const v = @as(f32, @floatFromInt(bgr[ch])) / 255.0;
+                dst[ch * plane + y * w + x] = (v - mean[ch]) / stddev[ch];
+            }
+        }
+    }
+}
@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Isolated Parse Worker Executable
+//
+// ddac-parse-worker: the helper process behind ddac_isolate_create().
+// Carries the whole library statically; see isolate.zig for the protocol.
+
+const isolate = @import("isolate.zig");
+
+pub fn main() !void {
+    try isolate.workerMain();
+}
@@ -5,13 +5,20 @@
 // Addresses Wall 2 (I/O bandwidth) by prefetching upcoming documents
 // into the kernel page cache while the current document is being parsed.
 //
+// One prefetcher per locale, shared by every task. When a task claims a
+// chunk it submits the paths of the chunk it will parse next
+// (ddac_prefetch_submit); the requests go onto a lock-free multi-producer
+// queue drained by one worker thread, which owns the io_uring and all
+// prefetch state, so callers never contend on a lock.
+//
 // Two strategies:
-//   io_uring:  True async reads via submission queue (Linux 5.6+)
-//   fadvise:   Hint-based readahead via posix_fadvise (all Linux)
+//   io_uring:  IORING_OP_FADVISE(WILLNEED) batches, one submit per wakeup
+//   fadvise:   posix_fadvise(WILLNEED) per file (all Linux)
 //
-// The prefetcher manages a sliding window of N upcoming files.
-// Chapel tasks call ddac_prefetch_hint() before processing each document
-// to keep the pipeline full.
+// Bytes in flight are bounded by a budget taken from the page cache the
+// kernel can spare (a quarter of MemAvailable, re-read once a second) or
+// set by the caller; files wait in FIFO order until the budget has room.
+// ddac_prefetch_done returns a file's bytes to the budget.
 
 const std = @import("std");
 const builtin = @import("builtin");
@@ -20,182 +27,486 @@ const builtin = @import("builtin");
 // Prefetcher State
 // ============================================================================
 
-const MAX_INFLIGHT: usize = 16; // Prefetch up to 16 files ahead
-const READAHEAD_SIZE: usize = 256 * 1024; // 256 KB initial readahead per file
+const MAX_INFLIGHT: usize = 1024; // Upper bound on files held open for prefetch
+const READAHEAD_MAX: usize = 64 * 1024 * 1024; // Readahead per file; the parser reads the rest
+const RING_ENTRIES: u16 = 64;
+const REFRESH_NS: u64 = std.time.ns_per_s; // Budget refresh / idle wakeup interval
 
-const PrefetchState = struct {
-    /// File descriptors of prefetched files (to close after processing)
-    fds: [MAX_INFLIGHT]std.posix.fd_t,
-    paths: [MAX_INFLIGHT]?[*:0]const u8,
-    count: usize,
-    head: usize, // next slot to fill
-    use_uring: bool,
-    ring: if (builtin.os.tag == .linux) ?IoUringState else void,
+/// Share of MemAvailable used as the byte budget when none is configured
+const AUTO_BUDGET_DIVISOR: u64 = 4;
+/// Budget when /proc/meminfo cannot be read
+const FALLBACK_BUDGET: u64 = 256 * 1024 * 1024;
+
+const Kind = enum { hint, done };
+
+/// One request from a caller. Allocated by the producer, owned by the
+/// worker once dequeued.
+const Node = struct {
+    /// MPSC queue link (producers and worker)
+    next: ?*Node = null,
+    /// Pending FIFO link (worker only)
+    link: ?*Node = null,
+    kind: Kind,
+    path: [:0]u8,
 };
 
-const IoUringState = struct {
-    ring: std.os.linux.IoUring,
+/// Intrusive multi-producer, single-consumer queue (Vyukov). push is one
+/// atomic swap and never blocks; pop is worker-only and returns null both
+/// when empty and while a producer is between its swap and link (the
+/// producer's wakeup brings the worker back).
+const Queue = struct {
+    head: *Node, // consumer side
+    tail: std.atomic.Value(*Node), // producer side
+    stub: Node = .{ .kind = .hint, .path = undefined },
+
+    /// Queues hold a pointer to their own stub, so initialise in place.
+    fn init(self: *Queue) void {
+        self.stub.next = null;
+        self.head = &self.stub;
+        self.tail = .init(&self.stub);
+    }
+
+    fn push(self: *Queue, node: *Node) void {
+        @atomicStore(?*Node, &node.next, null, .monotonic);
+        const prev = self.tail.swap(node, .acq_rel);
+        @atomicStore(?*Node, &prev.next, node, .release);
+    }
+
+    fn pop(self: *Queue) ?*Node {
+        var head = self.head;
+        var next = @atomicLoad(?*Node, &head.next, .acquire);
+        if (head == &self.stub) {
+            head = next orelse return null;
+            self.head = head;
+            next = @atomicLoad(?*Node, &head.next, .acquire);
+        }
+        if (next) |n| {
+            self.head = n;
+            return head;
+        }
+        // head is the last node: requeue the stub behind it to detach it
+        if (self.tail.load(.acquire) != head) return null;
+        self.push(&self.stub);
+        next = @atomicLoad(?*Node, &head.next, .acquire);
+        if (next) |n| {
+            self.head = n;
+            return head;
+        }
+        return null;
+    }
 };
 
-var global_state: ?*PrefetchState = null;
+/// A file handed to the kernel for readahead, until ddac_prefetch_done.
+const Entry = struct {
+    fd: std.posix.fd_t,
+    bytes: u64,
+    /// The hint, whose path copy keys the entry (freed with it)
+    node: *Node,
+};
 
-// ============================================================================
-// C-ABI exports
-// ============================================================================
+const PrefetchState = struct {
+    allocator: std.mem.Allocator,
+    queue: Queue = undefined,
+    /// Set by producers after a push, and on shutdown
+    wake: std.Thread.ResetEvent = .{},
+    stopping: std.atomic.Value(bool) = .init(false),
+    worker: ?std.Thread = null,
 
-/// Initialise the I/O prefetcher.
-/// window_size: how many files to prefetch ahead (clamped to MAX_INFLIGHT)
-/// Returns opaque handle, or null on failure.
-export fn ddac_prefetch_init(window_size: u32) ?*anyopaque {
-    const state = std.heap.c_allocator.create(PrefetchState) catch return null;
-
-    state.* = .{
-        .fds = [_]std.posix.fd_t{-1} ** MAX_INFLIGHT,
-        .paths = [_]?[*:0]const u8{null} ** MAX_INFLIGHT,
-        .count = @min(window_size, MAX_INFLIGHT),
-        .head = 0,
-        .use_uring = false,
-        .ring = if (builtin.os.tag == .linux) null else {},
-    };
+    // ── Worker-owned (no locking) ──────────────────────────────────────
+    /// Files in flight, keyed by path
+    entries: std.StringHashMapUnmanaged(Entry) = .{},
+    /// Hints waiting for budget, oldest first
+    pending_head: ?*Node = null,
+    pending_tail: ?*Node = null,
+    bytes_inflight: u64 = 0,
+    /// Configured budget (0 = auto from MemAvailable)
+    budget_config: u64,
+    budget: u64,
+    last_refresh_ns: i128 = 0,
+    window: usize,
+    ring: if (builtin.os.tag == .linux) ?std.os.linux.IoUring else void,
+    /// SQEs prepared since the last submit
+    unsubmitted: u32 = 0,
 
-    // Try to initialise io_uring (Linux 5.6+)
-    if (builtin.os.tag == .linux) {
-        if (std.os.linux.IoUring.init(64, .{})) |ring| {
-            state.ring = .{ .ring = ring };
-            state.use_uring = true;
-        } else |_| {
-            // Fall back to fadvise
-            state.use_uring = false;
+    // ── Read by any thread ─────────────────────────────────────────────
+    files_inflight: std.atomic.Value(u32) = .init(0),
+
+    fn create(allocator: std.mem.Allocator, window: usize, budget_bytes: u64, threaded: bool) ?*PrefetchState {
+        const state = allocator.create(PrefetchState) catch return null;
+        state.* = .{
+            .allocator = allocator,
+            .budget_config = budget_bytes,
+            .budget = if (budget_bytes != 0) budget_bytes else autoBudget(),
+            .window = @max(1, @min(window, MAX_INFLIGHT)),
+            .ring = if (builtin.os.tag == .linux) null else {},
+        };
+        state.queue.init();
+
+        // Try to initialise io_uring (Linux 5.6+); fall back to fadvise
+        if (builtin.os.tag == .linux) {
+            state.ring = std.os.linux.IoUring.init(RING_ENTRIES, 0) catch null;
         }
+
+        if (threaded) {
+            state.worker = std.Thread.spawn(.{}, workerLoop, .{state}) catch {
+                state.destroy();
+                return null;
+            };
+        }
+        return state;
     }
 
-    global_state = state;
-    // SAFETY: state was just allocated by c_allocator.create(PrefetchState), which returns a well-aligned *PrefetchState
-    return @ptrCast(state);
-}
+    /// Stop the worker, close every prefetched file and free the state.
+    fn destroy(self: *PrefetchState) void {
+        self.stopping.store(true, .release);
+        self.wake.set();
+        if (self.worker) |t| t.join();
 
-/// Submit a prefetch hint for an upcoming file.
-/// The kernel will start loading the file into page cache asynchronously.
-export fn ddac_prefetch_hint(handle: *anyopaque, path: [*:0]const u8) void {
-    // SAFETY: handle originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
-    const state: *PrefetchState = @ptrCast(@alignCast(handle));
+        // Requests queued after the worker's last pass, then pending hints
+        while (self.queue.pop()) |node| self.freeNode(node);
+        while (self.pending_head) |node| {
+            self.pending_head = node.link;
+            self.freeNode(node);
+        }
+        var it = self.entries.valueIterator();
+        while (it.next()) |e| {
+            std.posix.close(e.fd);
+            self.freeNode(e.node);
+        }
+        self.entries.deinit(self.allocator);
+
+        if (builtin.os.tag == .linux) {
+            if (self.ring) |*ring| ring.deinit();
+        }
+        self.allocator.destroy(self);
+    }
 
-    // Close the file that was in this slot previously (if any)
-    const slot = state.head % state.count;
-    if (state.fds[slot] >= 0) {
-        std.posix.close(state.fds[slot]);
-        state.fds[slot] = -1;
+    /// Queue a request (any thread). The path is copied.
+    fn request(self: *PrefetchState, kind: Kind, path: [*:0]const u8) void {
+        const node = self.allocator.create(Node) catch return;
+        const copy = self.allocator.dupeZ(u8, std.mem.span(path)) catch {
+            self.allocator.destroy(node);
+            return;
+        };
+        node.* = .{ .kind = kind, .path = copy };
+        self.queue.push(node);
     }
 
-    // Open the new file
-    const fd = std.posix.openZ(path, .{ .ACCMODE = .RDONLY }, 0) catch return;
-    state.fds[slot] = fd;
-    state.paths[slot] = path;
+    fn freeNode(self: *PrefetchState, node: *Node) void {
+        self.allocator.free(node.path);
+        self.allocator.destroy(node);
+    }
 
-    if (builtin.os.tag == .linux) {
-        if (state.use_uring) {
-            // io_uring: submit an async readahead operation
-            prefetchWithUring(state, fd);
-        } else {
-            // fadvise: tell kernel to read ahead
-            prefetchWithFadvise(fd);
+    fn workerLoop(self: *PrefetchState) void {
+        while (true) {
+            self.wake.reset();
+            self.runOnce();
+            if (self.stopping.load(.acquire)) return;
+            self.wake.timedWait(REFRESH_NS) catch {};
         }
     }
 
-    state.head +%= 1;
-}
+    /// One worker pass: apply queued requests, refresh the budget, start
+    /// what fits, submit, and reap completions.
+    fn runOnce(self: *PrefetchState) void {
+        while (self.queue.pop()) |node| switch (node.kind) {
+            .hint => self.addPending(node),
+            .done => {
+                self.finish(node.path);
+                self.freeNode(node);
+            },
+        };
+
+        if (self.budget_config == 0) {
+            const now = std.time.nanoTimestamp();
+            if (now - self.last_refresh_ns >= REFRESH_NS) {
+                self.budget = autoBudget();
+                self.last_refresh_ns = now;
+            }
+        }
 
-/// Signal that a file has been processed. Releases page cache.
-export fn ddac_prefetch_done(handle: *anyopaque, path: [*:0]const u8) void {
-    // SAFETY: handle originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
-    const state: *PrefetchState = @ptrCast(@alignCast(handle));
-    _ = path; // TODO: could match by path and close specific FD
+        self.startPending();
+        self.flushRing();
+    }
 
-    if (builtin.os.tag == .linux) {
-        // Drain completed io_uring operations
-        if (state.use_uring) {
-            drainUring(state);
+    fn addPending(self: *PrefetchState, node: *Node) void {
+        if (self.entries.contains(node.path)) {
+            self.freeNode(node); // already in flight
+            return;
         }
+        node.link = null;
+        if (self.pending_tail) |t| t.link = node else self.pending_head = node;
+        self.pending_tail = node;
     }
-}
 
-/// Free the prefetcher and close all open files.
-export fn ddac_prefetch_free(handle: ?*anyopaque) void {
-    if (handle) |h| {
-        // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
-        const state: *PrefetchState = @ptrCast(@alignCast(h));
+    /// Start pending files, oldest first, while the window and budget
+    /// allow. A file is always started when nothing is in flight, so one
+    /// file larger than the budget cannot stall the queue.
+    fn startPending(self: *PrefetchState) void {
+        while (self.pending_head) |node| {
+            if (self.entries.count() >= self.window) return;
+            if (self.entries.contains(node.path)) {
+                self.popPending(); // hinted twice before it started
+                self.freeNode(node);
+                continue;
+            }
 
-        // Close all open file descriptors
-        for (&state.fds) |*fd| {
-            if (fd.* >= 0) {
-                std.posix.close(fd.*);
-                fd.* = -1;
+            const fd = std.posix.openZ(node.path, .{ .ACCMODE = .RDONLY, .CLOEXEC = true }, 0) catch {
+                self.popPending();
+                self.freeNode(node);
+                continue;
+            };
+            const size = if (std.posix.fstat(fd)) |st| @as(u64, @intCast(@max(st.size, 0))) else |_| 0;
+            const bytes = @min(size, READAHEAD_MAX);
+            if (self.bytes_inflight != 0 and self.bytes_inflight + bytes > self.budget) {
+                std.posix.close(fd);
+                return;
             }
+
+            self.entries.ensureUnusedCapacity(self.allocator, 1) catch return std.posix.close(fd);
+            self.popPending();
+            self.entries.putAssumeCapacity(node.path, .{ .fd = fd, .bytes = bytes, .node = node });
+            self.bytes_inflight += bytes;
+            _ = self.files_inflight.fetchAdd(1, .monotonic);
+            if (bytes > 0) self.readahead(fd, bytes);
         }
+    }
 
-        // Clean up io_uring
-        if (builtin.os.tag == .linux) {
-            if (state.ring) |*ring_state| {
-                ring_state.ring.deinit();
+    fn popPending(self: *PrefetchState) void {
+        const node = self.pending_head orelse return;
+        self.pending_head = node.link;
+        if (self.pending_head == null) self.pending_tail = null;
+    }
+
+    /// A file was processed: close it and return its bytes to the budget.
+    /// A file still waiting is dropped, as the parser has read it anyway.
+    fn finish(self: *PrefetchState, path: []const u8) void {
+        if (self.entries.fetchRemove(path)) |kv| {
+            std.posix.close(kv.value.fd);
+            self.bytes_inflight -= kv.value.bytes;
+            _ = self.files_inflight.fetchSub(1, .monotonic);
+            self.freeNode(kv.value.node);
+            return;
+        }
+
+        var prev: ?*Node = null;
+        var cur = self.pending_head;
+        while (cur) |node| : (cur = node.link) {
+            if (!std.mem.eql(u8, node.path, path)) {
+                prev = node;
+                continue;
+            }
+            if (prev) |p| p.link = node.link else self.pending_head = node.link;
+            if (self.pending_tail == node) self.pending_tail = prev;
+            self.freeNode(node);
+            return;
+        }
+    }
+
+    fn readahead(self: *PrefetchState, fd: std.posix.fd_t, bytes: u64) void {
+        if (builtin.os.tag != .linux) return;
+
+        if (self.ring) |*ring| {
+            // POSIX_FADV_WILLNEED = 3; submitted in one batch by flushRing
+            if (ring.fadvise(@intCast(fd), fd, 0, @intCast(bytes), 3)) |_| {
+                self.unsubmitted += 1;
+                return;
+            } else |_| {
+                // Submission queue full: submit what is there and retry once
+                self.flushRing();
+                if (ring.fadvise(@intCast(fd), fd, 0, @intCast(bytes), 3)) |_| {
+                    self.unsubmitted += 1;
+                    return;
+                } else |_| {}
             }
         }
+        // POSIX_FADV_WILLNEED = 3 (triggers readahead)
+        _ = std.os.linux.fadvise(fd, 0, @intCast(bytes), 3);
+    }
+
+    /// Submit prepared SQEs and reap finished ones (non-blocking). Failure
+    /// is non-fatal: the file is still read when the parser reaches it.
+    fn flushRing(self: *PrefetchState) void {
+        if (builtin.os.tag != .linux) return;
 
-        std.heap.c_allocator.destroy(state);
-        global_state = null;
+        if (self.ring) |*ring| {
+            if (self.unsubmitted > 0) {
+                _ = ring.submit() catch |err| {
+                    std.log.debug("io_uring prefetch submit failed: {s}", .{@errorName(err)});
+                };
+                self.unsubmitted = 0;
+            }
+            var cqes: [RING_ENTRIES]std.os.linux.io_uring_cqe = undefined;
+            while (true) {
+                const n = ring.copy_cqes(&cqes, 0) catch 0;
+                if (n == 0) break;
+            }
+        }
     }
+};
+
+/// A quarter of MemAvailable: page cache the kernel can hand out without
+/// evicting the working set of the parsers.
+fn autoBudget() u64 {
+    if (builtin.os.tag != .linux) return FALLBACK_BUDGET;
+    const file = std.fs.openFileAbsolute("/proc/meminfo", .{}) catch return FALLBACK_BUDGET;
+    defer file.close();
+    var buf: [4096]u8 = undefined;
+    const n = file.readAll(&buf) catch return FALLBACK_BUDGET;
+    return memAvailable(buf[0..n]) orelse FALLBACK_BUDGET;
 }
 
-/// Get prefetcher statistics.
-/// Returns the number of files currently being prefetched.
-export fn ddac_prefetch_inflight(handle: *anyopaque) u32 {
-    // SAFETY: handle originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
-    const state: *PrefetchState = @ptrCast(@alignCast(handle));
-    var count: u32 = 0;
-    for (state.fds[0..state.count]) |fd| {
-        if (fd >= 0) count += 1;
-    }
-    return count;
+/// MemAvailable from /proc/meminfo text, divided by AUTO_BUDGET_DIVISOR, in bytes.
+fn memAvailable(meminfo: []const u8) ?u64 {
+    const key = "MemAvailable:";
+    const at = std.mem.indexOf(u8, meminfo, key) orelse return null;
+    const rest = std.mem.trimLeft(u8, meminfo[at + key.len ..], " ");
+    const end = std.mem.indexOfAny(u8, rest, " \n") orelse rest.len;
+    const kib = std.fmt.parseInt(u64, rest[0..end], 10) catch return null;
+    return kib * 1024 / AUTO_BUDGET_DIVISOR;
 }
 
 // ============================================================================
-// Linux-specific implementations
+// C-ABI exports
 // ============================================================================
 
-fn prefetchWithFadvise(fd: std.posix.fd_t) void {
-    if (builtin.os.tag != .linux) return;
+/// Initialise the I/O prefetcher.
+/// window_size: most files prefetched at once (clamped to MAX_INFLIGHT);
+/// bytes in flight are bounded by a quarter of MemAvailable.
+/// Returns opaque handle, or null on failure.
+export fn ddac_prefetch_init(window_size: u32) ?*anyopaque {
+    return ddac_prefetch_init_ex(window_size, 0);
+}
+
+/// ddac_prefetch_init with an explicit byte budget for readahead in
+/// flight (budget_mb = 0: a quarter of MemAvailable, re-read each second).
+export fn ddac_prefetch_init_ex(window_size: u32, budget_mb: u64) ?*anyopaque {
+    const state = PrefetchState.create(std.heap.c_allocator, window_size, budget_mb * 1024 * 1024, true) orelse return null;
+    // SAFETY: state was just allocated by c_allocator.create(PrefetchState), which returns a well-aligned *PrefetchState
+    return @ptrCast(state);
+}
 
-    // POSIX_FADV_WILLNEED = 3 (triggers readahead)
-    _ = std.os.linux.fadvise(fd, 0, @intCast(READAHEAD_SIZE), 3);
+/// Submit a prefetch hint for an upcoming file. Safe to call from any
+/// task; the path is copied, and the worker starts readahead when the
+/// budget allows.
+export fn ddac_prefetch_hint(handle: ?*anyopaque, path: [*:0]const u8) void {
+    const h = handle orelse return;
+    // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *PrefetchState = @ptrCast(@alignCast(h));
+    state.request(.hint, path);
+    state.wake.set();
 }
 
-fn prefetchWithUring(state: *PrefetchState, fd: std.posix.fd_t) void {
-    if (builtin.os.tag != .linux) return;
-
-    if (state.ring) |*ring_state| {
-        // Submit a NOP operation as a readahead trigger
-        // (io_uring doesn't have a native readahead op, but opening + fadvise
-        // is triggered by the kernel when we submit a read)
-        //
-        // Use IORING_OP_FADVISE if available (kernel 5.6+)
-        var sqe = ring_state.ring.get_sqe() orelse return;
-        sqe.prep_fadvise(fd, 0, @intCast(READAHEAD_SIZE), 3); // POSIX_FADV_WILLNEED
-        sqe.user_data = @intCast(fd);
-
-        // Submit without waiting — failure is non-fatal; the file will still
-        // be read synchronously when the parser reaches it.
-        _ = ring_state.ring.submit() catch |err| {
-            std.log.debug("io_uring prefetch submit failed: {s}", .{@errorName(err)});
-        };
+/// Submit hints for a batch of upcoming files (null entries are skipped)
+/// with a single worker wakeup. The scheduler calls this with the next
+/// chunk's paths when a task claims it.
+export fn ddac_prefetch_submit(handle: ?*anyopaque, paths: [*]const ?[*:0]const u8, count: u32) void {
+    const h = handle orelse return;
+    // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *PrefetchState = @ptrCast(@alignCast(h));
+    for (paths[0..count]) |p| {
+        if (p) |path| state.request(.hint, path);
+    }
+    state.wake.set();
+}
+
+/// Signal that a file has been processed: its descriptor is closed and
+/// its bytes return to the budget (a hint not yet started is dropped).
+export fn ddac_prefetch_done(handle: ?*anyopaque, path: [*:0]const u8) void {
+    const h = handle orelse return;
+    // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *PrefetchState = @ptrCast(@alignCast(h));
+    state.request(.done, path);
+    state.wake.set();
+}
+
+/// Free the prefetcher and close all open files.
+export fn ddac_prefetch_free(handle: ?*anyopaque) void {
+    if (handle) |h| {
+        // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
+        const state: *PrefetchState = @ptrCast(@alignCast(h));
+        state.destroy();
     }
 }
 
-fn drainUring(state: *PrefetchState) void {
-    if (builtin.os.tag != .linux) return;
+/// Get prefetcher statistics.
+/// Returns the number of files currently being prefetched.
+export fn ddac_prefetch_inflight(handle: ?*anyopaque) u32 {
+    const h = handle orelse return 0;
+    // SAFETY: h originates from ddac_prefetch_init() which stores a *PrefetchState via @ptrCast; alignment is guaranteed by c_allocator
+    const state: *PrefetchState = @ptrCast(@alignCast(h));
+    return state.files_inflight.load(.monotonic);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "queue delivers every push from concurrent producers" {
+    const allocator = std.testing.allocator;
+    const PER_THREAD = 500;
+    const THREADS = 4;
+
+    var queue: Queue = undefined;
+    queue.init();
+    const nodes = try allocator.alloc(Node, PER_THREAD * THREADS);
+    defer allocator.free(nodes);
 
-    if (state.ring) |*ring_state| {
-        // Collect any completed operations (non-blocking)
-        while (ring_state.ring.cq_ready() > 0) {
-            _ = ring_state.ring.cq_advance(1);
+    const Producer = struct {
+        fn run(q: *Queue, mine: []Node) void {
+            for (mine) |*n| {
+                n.* = .{ .kind = .hint, .path = undefined };
+                q.push(n);
+            }
         }
+    };
+    var threads: [THREADS]std.Thread = undefined;
+    for (&threads, 0..) |*t, i| {
+        t.* = try std.Thread.spawn(.{}, Producer.run, .{ &queue, nodes[i * PER_THREAD ..][0..PER_THREAD] });
+    }
+    var seen: usize = 0;
+    while (seen < nodes.len) {
+        if (queue.pop() != null) seen += 1 else std.Thread.yield() catch {};
+    }
+    for (threads) |t| t.join();
+    try std.testing.expect(queue.pop() == null);
+}
+
+test "byte budget holds files back until earlier ones are done" {
+    var path_buf: [2][64]u8 = undefined;
+    var paths: [2][:0]const u8 = undefined;
+    const stamp = std.time.milliTimestamp();
+    for (0..2) |i| {
+        paths[i] = try std.fmt.bufPrintZ(&path_buf[i], "/tmp/ddac-test-prefetch-{d}-{d}", .{ stamp, i });
+        const f = try std.fs.createFileAbsoluteZ(paths[i], .{});
+        defer f.close();
+        try f.writeAll(&([_]u8{'x'} ** 4096));
     }
+    defer for (paths) |p| std.fs.deleteFileAbsoluteZ(p) catch {};
+
+    // Room for one 4 KiB file at a time
+    const state = PrefetchState.create(std.testing.allocator, 8, 6000, false) orelse return error.InitFailed;
+    defer state.destroy();
+
+    state.request(.hint, paths[0]);
+    state.request(.hint, paths[1]);
+    state.runOnce();
+    try std.testing.expectEqual(@as(u32, 1), ddac_prefetch_inflight(state));
+    try std.testing.expectEqual(@as(u64, 4096), state.bytes_inflight);
+
+    state.request(.done, paths[0]);
+    state.runOnce();
+    try std.testing.expectEqual(@as(u32, 1), ddac_prefetch_inflight(state));
+    try std.testing.expect(state.entries.contains(paths[1]));
+
+    // A duplicate hint for a file in flight is ignored
+    state.request(.hint, paths[1]);
+    state.runOnce();
+    try std.testing.expect(state.pending_head == null);
+}
+
+test "memAvailable parses /proc/meminfo" {
+    const text = "MemTotal:       16384000 kB\nMemFree:         1000 kB\nMemAvailable:    8000000 kB\n";
+    try std.testing.expectEqual(@as(?u64, 8000000 * 1024 / AUTO_BUDGET_DIVISOR), memAvailable(text));
+    try std.testing.expectEqual(@as(?u64, null), memAvailable("MemTotal: 1 kB\n"));
 }
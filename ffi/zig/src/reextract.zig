@@ -9,6 +9,11 @@
 // - Re-runs only the missing/updated stages
 // - Merges results into existing Cap'n Proto output
 // - Updates the stagesMask
+//
+// The driver's --reextract mode plans from the stages mask stored in each
+// L1 cache entry instead of opening the files, and adds the missing stages
+// to the existing message in place (ddac_reextract_stages, which reopens
+// it with capnp.Builder.reopen rather than merging two messages).
 
 const std = @import("std");
 const capnp = @import("capnp.zig");
@@ -121,33 +126,39 @@ pub fn reextractPlanDetailed(existing_mask: u64, requested_mask: u64, force: boo
 // Reading Existing Results
 // ============================================================================
 
-/// Read the stages mask from an existing Cap'n Proto results file.
+/// Read the stages mask from an existing Cap'n Proto results file, packed
+/// or not. Only the front of the file is read: the header, the root
+/// pointer and the first data word.
 /// Returns the mask, or 0 if the file cannot be read or is invalid.
 pub fn readExistingMask(path: []const u8) u64 {
     const file = std.fs.openFileAbsolute(path, .{}) catch return 0;
     defer file.close();
 
-    // Read the message header (8 bytes) + enough for the stages mask field
-    var header: [8]u8 = undefined;
-    const hdr_read = file.readAll(&header) catch return 0;
-    if (hdr_read < 8) return 0;
-
-    // Parse segment count and size
-    const seg_count = std.mem.readInt(u32, header[0..4], .little);
-    if (seg_count != 0) return 0; // We only handle single-segment messages
-
-    const seg_words = std.mem.readInt(u32, header[4..8], .little);
+    // Largest header + root pointer + stages mask; packed, each word costs
+    // at most 10 bytes (tag, 8 bytes, run count)
+    const want = capnp.MAX_HEADER + 16;
+    var raw: [want / 8 * 10]u8 = undefined;
+    const raw_len = file.readAll(&raw) catch return 0;
+
+    var unpacked: [want]u8 = undefined;
+    const front: []const u8 = if (capnp.isPacked(raw[0..raw_len]))
+        unpacked[0..capnp.unpackPrefix(raw[0..raw_len], &unpacked)]
+    else
+        raw[0..raw_len];
+    if (front.len < 8) return 0;
+
+    // Segment count, then one size per segment, padded to a word
+    const seg_count = @as(usize, std.mem.readInt(u32, front[0..4], .little)) + 1;
+    if (seg_count > capnp.MAX_SEGMENTS) return 0;
+    const header_len = std.mem.alignForward(usize, 4 + 4 * seg_count, 8);
+    if (front.len < header_len + 16) return 0;
+
+    const seg_words = std.mem.readInt(u32, front[4..8], .little);
     if (seg_words < 2) return 0; // Need at least root pointer + one data word
 
-    // Read the root pointer word + first data word (stages mask)
-    // Root pointer is at offset 0 in segment, data starts at offset 8
-    // Stages mask is at OFF_STAGES_MASK = 0 within data section (= byte 8 of segment = byte 16 of file)
-    var data_buf: [24]u8 = undefined;
-    const data_read = file.readAll(&data_buf) catch return 0;
-    if (data_read < 16) return 0;
-
-    // Stages mask is at data_start(8) + OFF_STAGES_MASK(0) = byte 8 of segment
-    return std.mem.readInt(u64, data_buf[8..16], .little);
+    // Stages mask is at data_start(8) + OFF_STAGES_MASK(0) within segment 0
+    const at = header_len + 8 + capnp.OFF_STAGES_MASK;
+    return std.mem.readInt(u64, front[at..][0..8], .little);
 }
 
 /// Read an entire Cap'n Proto message from a file into a buffer.
@@ -483,10 +494,23 @@ test "reextractMerge rejects too-small input" {
     try std.testing.expect(res.status == @intFromEnum(ReextractStatus.invalid_input));
 }
 
+/// Concatenate a builder's message (header + segments) into out.
+fn testMessage(b: *const capnp.Builder, out: []u8) []u8 {
+    var header: [capnp.MAX_HEADER]u8 = undefined;
+    var parts: [capnp.MAX_SEGMENTS + 1][]const u8 = undefined;
+    var len: usize = 0;
+    for (b.messageParts(&header, &parts)) |part| {
+        @memcpy(out[len..][0..part.len], part);
+        len += part.len;
+    }
+    return out[0..len];
+}
+
 test "reextractMerge with builder-created messages" {
     // Build "existing" message with language detect stage
-    var exist_buf: [8192]u8 align(8) = undefined;
-    var b1 = capnp.Builder.init(&exist_buf);
+    var arena = capnp.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var b1 = capnp.Builder.init(&arena);
     b1.initRoot();
 
     const stages_mod = @import("stages.zig");
@@ -494,30 +518,81 @@ test "reextractMerge with builder-created messages" {
     b1.setF64(capnp.OFF_LANG_CONFIDENCE, 0.95);
     b1.setText(capnp.PTR_LANG_LANGUAGE, "en");
 
-    var exist_msg: [16384]u8 = undefined;
-    const sw1: u32 = @intCast(b1.pos / 8);
-    std.mem.writeInt(u32, exist_msg[0..4], 0, .little);
-    std.mem.writeInt(u32, exist_msg[4..8], sw1, .little);
-    @memcpy(exist_msg[8 .. 8 + b1.pos], exist_buf[0..b1.pos]);
-    const exist_len = 8 + b1.pos;
+    var exist_buf: [16384]u8 = undefined;
+    const exist_msg = testMessage(&b1, &exist_buf);
 
     // Build "new" message with keywords stage
-    var new_buf: [8192]u8 align(8) = undefined;
-    var b2 = capnp.Builder.init(&new_buf);
+    var b2 = capnp.Builder.init(&arena);
     b2.initRoot();
     b2.setU64(capnp.OFF_STAGES_MASK, stages_mod.STAGE_KEYWORDS);
     b2.setU32(capnp.OFF_KW_COUNT, 42);
 
-    var new_msg: [16384]u8 = undefined;
-    const sw2: u32 = @intCast(b2.pos / 8);
-    std.mem.writeInt(u32, new_msg[0..4], 0, .little);
-    std.mem.writeInt(u32, new_msg[4..8], sw2, .little);
-    @memcpy(new_msg[8 .. 8 + b2.pos], new_buf[0..b2.pos]);
-    const new_len = 8 + b2.pos;
+    var new_buf: [16384]u8 = undefined;
+    const new_msg = testMessage(&b2, &new_buf);
 
     // Merge
     var out: [32768]u8 = undefined;
-    const merge_result = reextractMerge(exist_msg[0..exist_len], new_msg[0..new_len], &out);
+    const merge_result = reextractMerge(exist_msg, new_msg, &out);
     try std.testing.expect(merge_result.status == @intFromEnum(ReextractStatus.ok));
     try std.testing.expect(merge_result.merged_mask == (stages_mod.STAGE_LANGUAGE_DETECT | stages_mod.STAGE_KEYWORDS));
 }
+
+test "reopened message keeps its fields and gains new stages" {
+    const stages_mod = @import("stages.zig");
+
+    var arena1 = capnp.Arena.init(std.testing.allocator);
+    defer arena1.deinit();
+    var b1 = capnp.Builder.init(&arena1);
+    b1.initRoot();
+    b1.setU64(capnp.OFF_STAGES_MASK, stages_mod.STAGE_LANGUAGE_DETECT);
+    b1.setText(capnp.PTR_LANG_LANGUAGE, "en");
+
+    var msg_buf: [8192]u8 = undefined;
+    const msg = testMessage(&b1, &msg_buf);
+    const seg1 = arena1.segs[0][0..arena1.used[0]];
+
+    var arena2 = capnp.Arena.init(std.testing.allocator);
+    defer arena2.deinit();
+    var b2 = capnp.Builder.init(&arena2);
+    try std.testing.expect(b2.reopen(msg));
+    try std.testing.expectEqual(stages_mod.STAGE_LANGUAGE_DETECT, b2.getU64(capnp.OFF_STAGES_MASK));
+    b2.setU32(capnp.OFF_KW_COUNT, 42);
+    b2.setText(capnp.PTR_PHASH_AHASH, "00ff00ff00ff00ff");
+
+    // The earlier text and its pointer are untouched; new text goes after them
+    const seg2 = arena2.segs[0][0..arena2.used[0]];
+    try std.testing.expect(seg2.len > seg1.len);
+    const lang_ptr = b1.ptr_start + capnp.PTR_LANG_LANGUAGE * 8;
+    const root_end = b1.ptr_start + @as(usize, capnp.PTR_WORDS) * 8;
+    try std.testing.expectEqualSlices(u8, seg1[lang_ptr .. lang_ptr + 8], seg2[lang_ptr .. lang_ptr + 8]);
+    try std.testing.expectEqualSlices(u8, seg1[root_end..], seg2[root_end..seg1.len]);
+
+    // A message of another layout is not reopened
+    var other_buf: [8192]u8 = undefined;
+    @memcpy(other_buf[0..msg.len], msg);
+    other_buf[8] ^= 0xFF;
+    var b3 = capnp.Builder.init(&arena2);
+    try std.testing.expect(!b3.reopen(other_buf[0..msg.len]));
+}
+
+test "readExistingMask reads packed and unpacked messages" {
+    const stages_mod = @import("stages.zig");
+    var arena = capnp.Arena.init(std.testing.allocator);
+    defer arena.deinit();
+    var b = capnp.Builder.init(&arena);
+    b.initRoot();
+    const mask = stages_mod.STAGE_LANGUAGE_DETECT | stages_mod.STAGE_KEYWORDS;
+    b.setU64(capnp.OFF_STAGES_MASK, mask);
+    b.setText(capnp.PTR_LANG_LANGUAGE, "en");
+
+    var path_buf: [256]u8 = undefined;
+    const path = try std.fmt.bufPrint(&path_buf, "/tmp/ddac-test-mask-{d}.stages.capnp", .{std.time.milliTimestamp()});
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    for ([_]bool{ false, true }) |pack| {
+        const file = try std.fs.createFileAbsolute(path, .{});
+        try b.writeMessage(file, pack);
+        file.close();
+        try std.testing.expectEqual(mask, readExistingMask(path));
+    }
+}
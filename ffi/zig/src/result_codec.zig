@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Compact Cache Record Codec
+//
+// ddac_parse_result_t is 952 bytes, most of it NUL padding in the four
+// fixed string fields. The L1 (LMDB) and L2 (Dragonfly) caches store this
+// variable-length record instead and expand it back to the full struct on
+// a hit, so Chapel still reads and writes the 952-byte layout.
+//
+// Record (version 1):
+//   [version: u8 = 0x81][flags: u8]
+//   varint  zigzag status, content_kind, page_count, word_count, char_count
+//   f64     duration_sec   (FLAG_DURATION; omitted when 0)
+//   f64     parse_time_ms  (FLAG_PARSE_TIME; omitted when 0)
+//   sha256  32 raw bytes   (FLAG_SHA_BINARY: 64 lowercase hex chars)
+//           | string       (anything else, e.g. empty on a failed parse)
+//   mime    u8 table id    | string (FLAG_MIME_TEXT: not in MIME_TABLE)
+//   string  error_msg, title, author
+// A string is a varint length followed by its bytes (no NUL).
+//
+// Rows written by earlier releases are raw structs; their first byte is
+// the status (0..6), never the version byte, so decodeValue accepts both
+// and existing caches stay valid. Those rows predate the explicit _pad1
+// field and hold the strings 7 bytes lower (error_msg at 113); decodeValue
+// moves them to the current offsets.
+//
+// The module sees rows as raw bytes (like cache.zig and container.zig) and
+// does not import the parser; docudactyl_ffi.zig asserts the offsets below
+// against ParseResult.
+
+const std = @import("std");
+
+// ============================================================================
+// Row Layout (ddac_parse_result_t)
+// ============================================================================
+
+pub const ROW_SIZE: usize = 952;
+
+pub const OFF_STATUS: usize = 0;
+pub const OFF_CONTENT_KIND: usize = 4;
+pub const OFF_PAGE_COUNT: usize = 8;
+pub const OFF_WORD_COUNT: usize = 16;
+pub const OFF_CHAR_COUNT: usize = 24;
+pub const OFF_DURATION: usize = 32;
+pub const OFF_PARSE_TIME: usize = 40;
+pub const OFF_SHA256: usize = 48;
+pub const OFF_ERROR_MSG: usize = 120;
+pub const OFF_TITLE: usize = 376;
+pub const OFF_AUTHOR: usize = 632;
+pub const OFF_MIME_TYPE: usize = 888;
+
+/// error_msg offset in raw rows cached before _pad1 was added
+const LEGACY_OFF_ERROR_MSG: usize = 113;
+
+const SHA_FIELD: usize = 65;
+const TEXT_FIELD: usize = 256;
+const MIME_FIELD: usize = 64;
+
+// ============================================================================
+// Record Format
+// ============================================================================
+
+pub const VERSION: u8 = 0x81;
+
+const FLAG_SHA_BINARY: u8 = 0x01;
+const FLAG_MIME_TEXT: u8 = 0x02;
+const FLAG_DURATION: u8 = 0x04;
+const FLAG_PARSE_TIME: u8 = 0x08;
+const KNOWN_FLAGS: u8 = 0x0f;
+
+/// MIME types the parsers emit. Ids are stored on disk: append only.
+/// Id 0 is the empty string.
+const MIME_TABLE = [_][]const u8{
+    "",
+    "application/pdf",
+    "image/png",
+    "image/jpeg",
+    "image/tiff",
+    "image/bmp",
+    "image/webp",
+    "image/unknown",
+    "audio/mpeg",
+    "audio/wav",
+    "audio/flac",
+    "audio/unknown",
+    "video/mp4",
+    "video/x-matroska",
+    "video/unknown",
+    "application/epub+zip",
+    "application/x-shapefile",
+    "application/x-geospatial",
+};
+
+/// Upper bound on an encoded record: header, five worst-case varints,
+/// two f64s, and every string at its field's maximum length.
+pub const MAX_RECORD: usize = 2 + (5 + 5 + 5 + 10 + 10) + 16 +
+    (1 + SHA_FIELD - 1) + (1 + MIME_FIELD - 1) + 3 * (2 + TEXT_FIELD - 1);
+
+comptime {
+    std.debug.assert(MIME_TABLE.len <= 256);
+    std.debug.assert(OFF_MIME_TYPE + MIME_FIELD <= ROW_SIZE);
+}
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+const Writer = struct {
+    buf: []u8,
+    pos: usize = 0,
+
+    fn byte(self: *Writer, b: u8) void {
+        self.buf[self.pos] = b;
+        self.pos += 1;
+    }
+
+    fn bytes(self: *Writer, s: []const u8) void {
+        @memcpy(self.buf[self.pos..][0..s.len], s);
+        self.pos += s.len;
+    }
+
+    fn varint(self: *Writer, value: u64) void {
+        var v = value;
+        while (v >= 0x80) : (v >>= 7) self.byte(@as(u8, @truncate(v)) | 0x80);
+        self.byte(@truncate(v));
+    }
+
+    fn signed(self: *Writer, value: i64) void {
+        self.varint(@bitCast((value << 1) ^ (value >> 63)));
+    }
+
+    fn string(self: *Writer, s: []const u8) void {
+        self.varint(s.len);
+        self.bytes(s);
+    }
+};
+
+/// NUL-terminated contents of a fixed string field. A field with no NUL
+/// keeps field.len - 1 bytes so the decoded row is always terminated.
+fn fieldStr(row: []const u8, off: usize, len: usize) []const u8 {
+    const field = row[off..][0..len];
+    return field[0 .. std.mem.indexOfScalar(u8, field, 0) orelse len - 1];
+}
+
+fn isLowerHex(s: []const u8) bool {
+    for (s) |ch| switch (ch) {
+        '0'...'9', 'a'...'f' => {},
+        else => return false,
+    };
+    return true;
+}
+
+fn mimeId(mime: []const u8) ?u8 {
+    for (MIME_TABLE, 0..) |m, i| {
+        if (std.mem.eql(u8, m, mime)) return @intCast(i);
+    }
+    return null;
+}
+
+/// Encode one 952-byte row. Returns the record length (<= MAX_RECORD).
+pub fn encode(row: *const [ROW_SIZE]u8, out: *[MAX_RECORD]u8) usize {
+    const duration = std.mem.readInt(u64, row[OFF_DURATION..][0..8], .little);
+    const parse_time = std.mem.readInt(u64, row[OFF_PARSE_TIME..][0..8], .little);
+    const sha = fieldStr(row, OFF_SHA256, SHA_FIELD);
+    const mime = fieldStr(row, OFF_MIME_TYPE, MIME_FIELD);
+    const sha_binary = sha.len == 64 and isLowerHex(sha);
+    const mime_id = mimeId(mime);
+
+    var flags: u8 = 0;
+    if (sha_binary) flags |= FLAG_SHA_BINARY;
+    if (mime_id == null) flags |= FLAG_MIME_TEXT;
+    if (duration != 0) flags |= FLAG_DURATION;
+    if (parse_time != 0) flags |= FLAG_PARSE_TIME;
+
+    var w = Writer{ .buf = out };
+    w.byte(VERSION);
+    w.byte(flags);
+    w.signed(std.mem.readInt(i32, row[OFF_STATUS..][0..4], .little));
+    w.signed(std.mem.readInt(i32, row[OFF_CONTENT_KIND..][0..4], .little));
+    w.signed(std.mem.readInt(i32, row[OFF_PAGE_COUNT..][0..4], .little));
+    w.signed(std.mem.readInt(i64, row[OFF_WORD_COUNT..][0..8], .little));
+    w.signed(std.mem.readInt(i64, row[OFF_CHAR_COUNT..][0..8], .little));
+    if (duration != 0) w.bytes(row[OFF_DURATION..][0..8]);
+    if (parse_time != 0) w.bytes(row[OFF_PARSE_TIME..][0..8]);
+
+    if (sha_binary) {
+        var digest: [32]u8 = undefined;
+        _ = std.fmt.hexToBytes(&digest, sha) catch unreachable;
+        w.bytes(&digest);
+    } else w.string(sha);
+
+    if (mime_id) |id| w.byte(id) else w.string(mime);
+
+    w.string(fieldStr(row, OFF_ERROR_MSG, TEXT_FIELD));
+    w.string(fieldStr(row, OFF_TITLE, TEXT_FIELD));
+    w.string(fieldStr(row, OFF_AUTHOR, TEXT_FIELD));
+    return w.pos;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+const Reader = struct {
+    buf: []const u8,
+    pos: usize = 0,
+
+    fn byte(self: *Reader) ?u8 {
+        if (self.pos >= self.buf.len) return null;
+        defer self.pos += 1;
+        return self.buf[self.pos];
+    }
+
+    fn bytes(self: *Reader, n: usize) ?[]const u8 {
+        if (self.buf.len - self.pos < n) return null;
+        defer self.pos += n;
+        return self.buf[self.pos..][0..n];
+    }
+
+    fn varint(self: *Reader) ?u64 {
+        var value: u64 = 0;
+        var shift: u7 = 0;
+        while (shift < 64) : (shift += 7) {
+            const b = self.byte() orelse return null;
+            value |= @as(u64, b & 0x7f) << @intCast(shift);
+            if (b & 0x80 == 0) return value;
+        }
+        return null;
+    }
+
+    fn signed(self: *Reader) ?i64 {
+        const v = self.varint() orelse return null;
+        return @bitCast((v >> 1) ^ (0 -% (v & 1)));
+    }
+
+    fn signed32(self: *Reader) ?i32 {
+        return std.math.cast(i32, self.signed() orelse return null);
+    }
+
+    /// Copy a string into a zeroed fixed field, leaving room for its NUL.
+    fn field(self: *Reader, row: []u8, off: usize, len: usize) ?void {
+        const n = self.varint() orelse return null;
+        if (n >= len) return null;
+        const s = self.bytes(@intCast(n)) orelse return null;
+        @memcpy(row[off..][0..s.len], s);
+    }
+};
+
+/// Decode one record into a 952-byte row (padding and unused string
+/// bytes are zeroed). Returns the number of record bytes consumed, or
+/// null if the bytes are not a well-formed version 1 record.
+pub fn decode(bytes: []const u8, row: *[ROW_SIZE]u8) ?usize {
+    var r = Reader{ .buf = bytes };
+    if ((r.byte() orelse return null) != VERSION) return null;
+    const flags = r.byte() orelse return null;
+    if (flags & ~KNOWN_FLAGS != 0) return null;
+
+    @memset(row, 0);
+    std.mem.writeInt(i32, row[OFF_STATUS..][0..4], r.signed32() orelse return null, .little);
+    std.mem.writeInt(i32, row[OFF_CONTENT_KIND..][0..4], r.signed32() orelse return null, .little);
+    std.mem.writeInt(i32, row[OFF_PAGE_COUNT..][0..4], r.signed32() orelse return null, .little);
+    std.mem.writeInt(i64, row[OFF_WORD_COUNT..][0..8], r.signed() orelse return null, .little);
+    std.mem.writeInt(i64, row[OFF_CHAR_COUNT..][0..8], r.signed() orelse return null, .little);
+    if (flags & FLAG_DURATION != 0) @memcpy(row[OFF_DURATION..][0..8], r.bytes(8) orelse return null);
+    if (flags & FLAG_PARSE_TIME != 0) @memcpy(row[OFF_PARSE_TIME..][0..8], r.bytes(8) orelse return null);
+
+    if (flags & FLAG_SHA_BINARY != 0) {
+        const digest = r.bytes(32) orelse return null;
+        const hex = std.fmt.bytesToHex(digest[0..32].*, .lower);
+        @memcpy(row[OFF_SHA256..][0..64], &hex);
+    } else r.field(row, OFF_SHA256, SHA_FIELD) orelse return null;
+
+    if (flags & FLAG_MIME_TEXT != 0) {
+        r.field(row, OFF_MIME_TYPE, MIME_FIELD) orelse return null;
+    } else {
+        const id = r.byte() orelse return null;
+        if (id >= MIME_TABLE.len) return null;
+        @memcpy(row[OFF_MIME_TYPE..][0..MIME_TABLE[id].len], MIME_TABLE[id]);
+    }
+
+    r.field(row, OFF_ERROR_MSG, TEXT_FIELD) orelse return null;
+    r.field(row, OFF_TITLE, TEXT_FIELD) orelse return null;
+    r.field(row, OFF_AUTHOR, TEXT_FIELD) orelse return null;
+    return r.pos;
+}
+
+/// Decode a stored value that starts with a result: a version 1 record,
+/// or a raw row written before the codec existed. out must be ROW_SIZE
+/// bytes and is only written on success. Returns the bytes consumed (so
+/// callers can find what follows the result), or null if the value is
+/// neither.
+pub fn decodeValue(bytes: []const u8, out: []u8) ?usize {
+    if (out.len != ROW_SIZE) return null;
+    if (bytes.len > 0 and bytes[0] == VERSION) {
+        var row: [ROW_SIZE]u8 = undefined;
+        const used = decode(bytes, &row) orelse return null;
+        @memcpy(out, &row);
+        return used;
+    }
+    if (bytes.len < ROW_SIZE) return null;
+    const shift = OFF_ERROR_MSG - LEGACY_OFF_ERROR_MSG;
+    @memcpy(out[0..LEGACY_OFF_ERROR_MSG], bytes[0..LEGACY_OFF_ERROR_MSG]);
+    @memset(out[LEGACY_OFF_ERROR_MSG..OFF_ERROR_MSG], 0);
+    @memcpy(out[OFF_ERROR_MSG..], bytes[LEGACY_OFF_ERROR_MSG .. ROW_SIZE - shift]);
+    return ROW_SIZE;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+fn testRow() [ROW_SIZE]u8 {
+    var row = [_]u8{0} ** ROW_SIZE;
+    std.mem.writeInt(i32, row[OFF_PAGE_COUNT..][0..4], 12, .little);
+    std.mem.writeInt(i64, row[OFF_WORD_COUNT..][0..8], 4821, .little);
+    std.mem.writeInt(i64, row[OFF_CHAR_COUNT..][0..8], 29_004, .little);
+    std.mem.writeInt(u64, row[OFF_PARSE_TIME..][0..8], @bitCast(@as(f64, 18.25)), .little);
+    @memcpy(row[OFF_SHA256..][0..64], "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08");
+    @memcpy(row[OFF_TITLE..][0..13], "Annual Report");
+    @memcpy(row[OFF_AUTHOR..][0..6], "J. Doe");
+    @memcpy(row[OFF_MIME_TYPE..][0..15], "application/pdf");
+    return row;
+}
+
+test "round trip keeps every field and shrinks the row" {
+    const row = testRow();
+    var rec: [MAX_RECORD]u8 = undefined;
+    const n = encode(&row, &rec);
+    try std.testing.expect(n < 100);
+
+    var out: [ROW_SIZE]u8 = undefined;
+    try std.testing.expectEqual(@as(?usize, n), decode(rec[0..n], &out));
+    try std.testing.expectEqualSlices(u8, &row, &out);
+}
+
+test "non-hex sha, unknown mime and negative counts fall back to text" {
+    var row = testRow();
+    @memset(row[OFF_SHA256..][0..SHA_FIELD], 0);
+    @memcpy(row[OFF_SHA256..][0..5], "ERROR");
+    @memcpy(row[OFF_MIME_TYPE..][0..10], "text/x-odd");
+    std.mem.writeInt(i32, row[OFF_STATUS..][0..4], 2, .little);
+    std.mem.writeInt(i64, row[OFF_WORD_COUNT..][0..8], -1, .little);
+    std.mem.writeInt(u64, row[OFF_DURATION..][0..8], @bitCast(@as(f64, 61.5)), .little);
+
+    var rec: [MAX_RECORD]u8 = undefined;
+    const n = encode(&row, &rec);
+    var out: [ROW_SIZE]u8 = undefined;
+    try std.testing.expectEqual(@as(?usize, n), decode(rec[0..n], &out));
+    try std.testing.expectEqualSlices(u8, &row, &out);
+}
+
+test "full-width unterminated fields stay within MAX_RECORD" {
+    const row = [_]u8{0xff} ** ROW_SIZE;
+    var rec: [MAX_RECORD]u8 = undefined;
+    const n = encode(&row, &rec);
+    try std.testing.expect(n <= MAX_RECORD);
+
+    var out: [ROW_SIZE]u8 = undefined;
+    try std.testing.expectEqual(@as(?usize, n), decode(rec[0..n], &out));
+    try std.testing.expectEqual(@as(u8, 0), out[OFF_TITLE + TEXT_FIELD - 1]);
+    try std.testing.expectEqual(@as(u8, 0xff), out[OFF_TITLE + TEXT_FIELD - 2]);
+}
+
+test "truncated or foreign records are rejected" {
+    const row = testRow();
+    var rec: [MAX_RECORD]u8 = undefined;
+    const n = encode(&row, &rec);
+    var out: [ROW_SIZE]u8 = undefined;
+    try std.testing.expectEqual(@as(?usize, null), decode(rec[0 .. n - 1], &out));
+    rec[1] |= 0x80;
+    try std.testing.expectEqual(@as(?usize, null), decode(rec[0..n], &out));
+}
+
+test "decodeValue accepts legacy raw rows and reports what follows" {
+    const row = testRow();
+    // A row from before _pad1: the strings start 7 bytes lower
+    const shift = OFF_ERROR_MSG - LEGACY_OFF_ERROR_MSG;
+    var legacy: [ROW_SIZE + 8]u8 = undefined;
+    @memcpy(legacy[0..LEGACY_OFF_ERROR_MSG], row[0..LEGACY_OFF_ERROR_MSG]);
+    @memcpy(legacy[LEGACY_OFF_ERROR_MSG .. ROW_SIZE - shift], row[OFF_ERROR_MSG..]);
+    @memset(legacy[ROW_SIZE - shift ..], 0xab);
+
+    var out: [ROW_SIZE]u8 = undefined;
+    try std.testing.expectEqual(@as(?usize, ROW_SIZE), decodeValue(&legacy, &out));
+    try std.testing.expectEqualSlices(u8, &row, &out);
+    try std.testing.expectEqual(@as(?usize, null), decodeValue(legacy[0..100], &out));
+    try std.testing.expectEqual(@as(?usize, null), decodeValue(&legacy, out[0..100]));
+}
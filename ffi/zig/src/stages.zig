@@ -15,6 +15,10 @@
 const std = @import("std");
 const capnp = @import("capnp.zig");
 const ml_inference = @import("ml_inference.zig");
+const container = @import("container.zig");
+const metrics = @import("metrics.zig");
+const tokenizer = @import("tokenizer.zig");
+const neardup = @import("neardup.zig");
 
 // C library bindings — same libraries linked by build.zig
 const c = @cImport({
@@ -129,21 +133,64 @@ pub const StageContext = struct {
     tess_api: ?*anyopaque,
     /// ML inference engine handle (opaque, from ddac_ml_init via Chapel).
     ml_handle: ?*anyopaque = null,
+    /// Extracted text held in the parse handle's text arena (full document,
+    /// no truncation). Null means "read it back from output_path".
+    text: ?[]const u8 = null,
+    /// Results container target: the message becomes a container blob
+    /// instead of the {output_path}.stages.capnp file.
+    blob: ?container.BlobTarget = null,
+    /// Multi-language OCR of a PDF's scanned pages, done by the base parser
+    /// (null when the stage was not requested or no model could be loaded).
+    mlang: ?MlangTally = null,
+    /// Image document decoded by the base parser, shared by the image
+    /// stages (null = each decodes input_path itself).
+    image: ?*SharedImage = null,
+    /// Near-duplicate index the image's hash is checked against and added
+    /// to by STAGE_NEAR_DEDUP, or the caller's verdict for it (null = the
+    /// hash is only written).
+    neardup: ?NearDupCheck = null,
+    /// Stage message from an earlier run (packed or not) that these
+    /// stages are added to, keeping its fields and mask (re-extraction).
+    /// Null starts a new message; one that cannot be reopened (another
+    /// layout, or too many segments) is kept and nothing is written.
+    existing: ?[]const u8 = null,
+    /// Segment arena the message is built in, kept by the parse handle so
+    /// segments are reused across documents (null = a one-off arena).
+    arena: ?*capnp.Arena = null,
+    /// Write the message in Cap'n Proto packed encoding.
+    packed_encoding: bool = false,
+    /// The parse handle's warm multi-language Tesseract (mlangTessCreate),
+    /// used by image-document OCR; only its helper thread touches it while
+    /// the job runs. Null skips multi-language OCR of images.
+    mlang_tess: ?*anyopaque = null,
+};
+
+/// Near-duplicate binding for one parse: an index to check the image
+/// against and add it to (ddac_set_neardup_doc), or a verdict the caller
+/// reached against a sharded index before the parse
+/// (ddac_set_neardup_verdict).
+pub const NearDupCheck = union(enum) {
+    index: struct {
+        index: *neardup.Index,
+        doc_id: u64,
+        /// Hamming distance at or below which the image is a near-duplicate
+        max_hamming: u8,
+    },
+    verdict: neardup.Verdict,
 };
 
 // ============================================================================
 // Text Reading Helper
 // ============================================================================
 
-const MAX_TEXT_READ: usize = 1024 * 1024; // 1 MB cap for text analysis
-
-/// Read extracted text from the output file (written by base parse).
+/// Read extracted text from the output file. Only used when the caller
+/// did not supply ctx.text (ddac_parse always does, from its text arena).
 fn readExtractedText(output_path: [*:0]const u8, allocator: std.mem.Allocator) ?[]u8 {
     const file = std.fs.openFileAbsoluteZ(output_path, .{}) catch return null;
     defer file.close();
 
     const stat = file.stat() catch return null;
-    const read_size = @min(stat.size, MAX_TEXT_READ);
+    const read_size: usize = @intCast(stat.size);
     if (read_size == 0) return null;
 
     const buf = allocator.alloc(u8, read_size) catch return null;
@@ -154,107 +201,30 @@ fn readExtractedText(output_path: [*:0]const u8, allocator: std.mem.Allocator) ?
     return buf[0..n];
 }
 
-// ============================================================================
-// Stop Words (English)
-// ============================================================================
-
-/// Compile-time perfect hash map for O(1) stop-word lookup.
-/// Replaces the previous linear scan over ~120 entries.
-const stop_word_map = std.StaticStringMap(void).initComptime(.{
-    .{ "a", {} },       .{ "about", {} },   .{ "after", {} },   .{ "all", {} },
-    .{ "also", {} },    .{ "am", {} },      .{ "an", {} },      .{ "and", {} },
-    .{ "any", {} },     .{ "are", {} },     .{ "as", {} },      .{ "at", {} },
-    .{ "be", {} },      .{ "been", {} },    .{ "before", {} },  .{ "being", {} },
-    .{ "between", {} }, .{ "both", {} },    .{ "but", {} },     .{ "by", {} },
-    .{ "can", {} },     .{ "could", {} },   .{ "did", {} },     .{ "do", {} },
-    .{ "does", {} },    .{ "doing", {} },   .{ "down", {} },    .{ "during", {} },
-    .{ "each", {} },    .{ "few", {} },     .{ "for", {} },     .{ "from", {} },
-    .{ "further", {} }, .{ "get", {} },     .{ "got", {} },     .{ "had", {} },
-    .{ "has", {} },     .{ "have", {} },    .{ "he", {} },      .{ "her", {} },
-    .{ "here", {} },    .{ "him", {} },     .{ "his", {} },     .{ "how", {} },
-    .{ "i", {} },       .{ "if", {} },      .{ "in", {} },      .{ "into", {} },
-    .{ "is", {} },      .{ "it", {} },      .{ "its", {} },     .{ "just", {} },
-    .{ "may", {} },     .{ "me", {} },      .{ "might", {} },   .{ "more", {} },
-    .{ "most", {} },    .{ "must", {} },    .{ "my", {} },      .{ "no", {} },
-    .{ "nor", {} },     .{ "not", {} },     .{ "now", {} },     .{ "of", {} },
-    .{ "off", {} },     .{ "on", {} },      .{ "once", {} },    .{ "only", {} },
-    .{ "or", {} },      .{ "other", {} },   .{ "our", {} },     .{ "out", {} },
-    .{ "over", {} },    .{ "own", {} },     .{ "s", {} },       .{ "same", {} },
-    .{ "shall", {} },   .{ "she", {} },     .{ "should", {} },  .{ "so", {} },
-    .{ "some", {} },    .{ "such", {} },    .{ "t", {} },       .{ "than", {} },
-    .{ "that", {} },    .{ "the", {} },     .{ "their", {} },   .{ "them", {} },
-    .{ "then", {} },    .{ "there", {} },   .{ "these", {} },   .{ "they", {} },
-    .{ "this", {} },    .{ "those", {} },   .{ "through", {} }, .{ "to", {} },
-    .{ "too", {} },     .{ "under", {} },   .{ "until", {} },   .{ "up", {} },
-    .{ "us", {} },      .{ "very", {} },    .{ "was", {} },     .{ "we", {} },
-    .{ "were", {} },    .{ "what", {} },    .{ "when", {} },    .{ "where", {} },
-    .{ "which", {} },   .{ "while", {} },   .{ "who", {} },     .{ "whom", {} },
-    .{ "why", {} },     .{ "will", {} },    .{ "with", {} },    .{ "would", {} },
-    .{ "you", {} },     .{ "your", {} },
-});
-
-fn isStopWord(word: []const u8) bool {
-    return stop_word_map.has(word);
-}
-
 // ============================================================================
 // Stage Implementations — Text Analysis
 // ============================================================================
 
-/// Language detection via Unicode script analysis.
-fn stageLanguageDetect(b: *capnp.Builder, text: []const u8) void {
-    var latin: u64 = 0;
-    var cjk: u64 = 0;
-    var cyrillic: u64 = 0;
-    var arabic: u64 = 0;
-    var devanagari: u64 = 0;
-    var total: u64 = 0;
-
-    var i: usize = 0;
-    while (i < text.len) {
-        const byte = text[i];
-        if (byte < 0x80) {
-            if (std.ascii.isAlphabetic(byte)) {
-                latin += 1;
-                total += 1;
-            }
-            i += 1;
-        } else if (byte >= 0xC0 and byte < 0xE0 and i + 1 < text.len) {
-            if (byte >= 0xD0 and byte <= 0xD3) cyrillic += 1
-            else if (byte >= 0xD8 and byte <= 0xDB) arabic += 1
-            else latin += 1;
-            total += 1;
-            i += 2;
-        } else if (byte >= 0xE0 and byte < 0xF0 and i + 2 < text.len) {
-            if (byte == 0xE0 and text[i + 1] >= 0xA4 and text[i + 1] <= 0xA7) devanagari += 1
-            else if (byte >= 0xE4 and byte <= 0xE9) cjk += 1
-            else total += 1;
-            total += 1;
-            i += 3;
-        } else if (byte >= 0xF0 and i + 3 < text.len) {
-            total += 1;
-            i += 4;
-        } else {
-            i += 1;
-        }
-    }
-
-    const max_count = @max(latin, @max(cjk, @max(cyrillic, @max(arabic, devanagari))));
+/// Language detection via Unicode script analysis (script counts from the
+/// tokenizer pass).
+fn stageLanguageDetect(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
+    const s = tokens.scripts;
+    const max_count = @max(s.latin, @max(s.cjk, @max(s.cyrillic, @max(s.arabic, s.devanagari))));
     const script: []const u8 = if (max_count == 0) "Unknown"
-        else if (max_count == cjk) "CJK"
-        else if (max_count == cyrillic) "Cyrillic"
-        else if (max_count == arabic) "Arabic"
-        else if (max_count == devanagari) "Devanagari"
+        else if (max_count == s.cjk) "CJK"
+        else if (max_count == s.cyrillic) "Cyrillic"
+        else if (max_count == s.arabic) "Arabic"
+        else if (max_count == s.devanagari) "Devanagari"
         else "Latin";
 
     const language: []const u8 = if (max_count == 0) "und"
-        else if (max_count == cjk) "zh"
-        else if (max_count == cyrillic) "ru"
-        else if (max_count == arabic) "ar"
-        else if (max_count == devanagari) "hi"
+        else if (max_count == s.cjk) "zh"
+        else if (max_count == s.cyrillic) "ru"
+        else if (max_count == s.arabic) "ar"
+        else if (max_count == s.devanagari) "hi"
         else "en";
 
-    const conf: f64 = if (total > 0) @as(f64, @floatFromInt(max_count)) / @as(f64, @floatFromInt(total)) else 0.0;
+    const conf: f64 = if (s.total > 0) @as(f64, @floatFromInt(max_count)) / @as(f64, @floatFromInt(s.total)) else 0.0;
 
     b.setText(capnp.PTR_LANG_SCRIPT, script);
     b.setText(capnp.PTR_LANG_LANGUAGE, language);
@@ -262,40 +232,10 @@ fn stageLanguageDetect(b: *capnp.Builder, text: []const u8) void {
 }
 
 /// Flesch-Kincaid readability scoring.
-fn stageReadability(b: *capnp.Builder, text: []const u8) void {
-    var sentences: u64 = 0;
-    var words: u64 = 0;
-    var syllables: u64 = 0;
-    var in_word = false;
-    var vowel_prev = false;
-
-    for (text) |ch| {
-        const lower = std.ascii.toLower(ch);
-
-        if (ch == '.' or ch == '?' or ch == '!') {
-            sentences += 1;
-        }
-
-        if (ch == ' ' or ch == '\n' or ch == '\r' or ch == '\t' or ch == '.' or ch == ',' or ch == ';' or ch == ':') {
-            if (in_word) {
-                words += 1;
-                if (syllables == 0) syllables = 1;
-                vowel_prev = false;
-            }
-            in_word = false;
-        } else if (std.ascii.isAlphabetic(ch)) {
-            in_word = true;
-            const is_vowel = (lower == 'a' or lower == 'e' or lower == 'i' or lower == 'o' or lower == 'u' or lower == 'y');
-            if (is_vowel and !vowel_prev) {
-                syllables += 1;
-            }
-            vowel_prev = is_vowel;
-        }
-    }
-    if (in_word) words += 1;
-    if (sentences == 0) sentences = 1;
-    if (words == 0) words = 1;
-    if (syllables == 0) syllables = words;
+fn stageReadability(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
+    const sentences: u64 = @max(tokens.sentence_marks, 1);
+    const words: u64 = @max(tokens.items.len, 1);
+    const syllables: u64 = if (tokens.syllables > 0) tokens.syllables else words;
 
     const w_f: f64 = @floatFromInt(words);
     const s_f: f64 = @floatFromInt(sentences);
@@ -312,7 +252,7 @@ fn stageReadability(b: *capnp.Builder, text: []const u8) void {
 }
 
 /// Keyword extraction via word frequency analysis.
-fn stageKeywords(b: *capnp.Builder, text: []const u8) void {
+fn stageKeywords(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
     var arena = std.heap.ArenaAllocator.init(std.heap.c_allocator);
     defer arena.deinit();
     const alloc = arena.allocator();
@@ -320,24 +260,11 @@ fn stageKeywords(b: *capnp.Builder, text: []const u8) void {
     var counts = std.StringHashMap(u32).init(alloc);
 
     var lower_buf: [128]u8 = undefined;
-    var pos: usize = 0;
-    while (pos < text.len) {
-        while (pos < text.len and !std.ascii.isAlphabetic(text[pos])) : (pos += 1) {}
-        if (pos >= text.len) break;
-
-        const start = pos;
-        while (pos < text.len and std.ascii.isAlphabetic(text[pos])) : (pos += 1) {}
-        const word = text[start..pos];
-
-        if (word.len < 3 or word.len > 127) continue;
-
-        for (word, 0..) |ch, idx| {
-            lower_buf[idx] = std.ascii.toLower(ch);
-        }
-        const lower = lower_buf[0..word.len];
-
-        if (isStopWord(lower)) continue;
+    for (tokens.items) |t| {
+        if (!t.has(tokenizer.TOK_ALPHA) or t.has(tokenizer.TOK_STOP_WORD)) continue;
+        if (t.len < 3 or t.len > 127) continue;
 
+        const lower = std.ascii.lowerString(lower_buf[0..t.len], tokens.bytes(t));
         if (counts.getPtr(lower)) |val| {
             val.* += 1;
         } else {
@@ -377,68 +304,65 @@ fn stageKeywords(b: *capnp.Builder, text: []const u8) void {
     b.setTextList(capnp.PTR_KW_WORDS, kw_slices[0..top_count]);
 }
 
+/// The token is exactly `word`.
+fn tokenIs(tokens: *const tokenizer.Tokens, t: tokenizer.Token, word: []const u8) bool {
+    return std.mem.eql(u8, tokens.bytes(t), word);
+}
+
 /// Citation pattern extraction (DOI, ISBN, URL, year references).
-fn stageCitationExtract(b: *capnp.Builder, text: []const u8) void {
+fn stageCitationExtract(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
     var doi_count: u32 = 0;
     var isbn_count: u32 = 0;
     var url_count: u32 = 0;
     var year_count: u32 = 0;
     var num_ref_count: u32 = 0;
 
+    const items = tokens.items;
     var i: usize = 0;
-    while (i < text.len) {
-        if (i + 7 < text.len and text[i] == '1' and text[i + 1] == '0' and text[i + 2] == '.') {
-            var j = i + 3;
-            var digits: u32 = 0;
-            while (j < text.len and std.ascii.isDigit(text[j])) : (j += 1) { digits += 1; }
-            if (digits >= 4 and j < text.len and text[j] == '/') {
+    while (i < items.len) : (i += 1) {
+        const t = items[i];
+
+        // DOI: "10." then 4+ digits then '/'
+        if (i + 1 < items.len and tokenIs(tokens, t, "10") and tokens.after(t, 0) == '.') {
+            const reg = items[i + 1];
+            if (reg.start == t.end() + 1 and reg.has(tokenizer.TOK_NUMERIC) and reg.len >= 4 and
+                tokens.after(reg, 0) == '/')
+            {
                 doi_count += 1;
-                i = j + 1;
+                i += 1;
                 continue;
             }
         }
 
-        if (i + 4 < text.len) {
-            const maybe_isbn = text[i..i + 4];
-            if (std.ascii.eqlIgnoreCase(maybe_isbn, "isbn")) {
-                isbn_count += 1;
-                i += 4;
-                continue;
-            }
+        if (t.len >= 4 and std.ascii.eqlIgnoreCase(tokens.bytes(t)[0..4], "isbn")) {
+            isbn_count += 1;
+            continue;
         }
 
-        if (i + 7 < text.len) {
-            if (std.mem.startsWith(u8, text[i..], "http://") or
-                std.mem.startsWith(u8, text[i..], "https://")) {
-                url_count += 1;
-                while (i < text.len and text[i] != ' ' and text[i] != '\n') : (i += 1) {}
-                continue;
-            }
+        // URL: the rest of the URL is every token up to the next whitespace
+        if ((tokenIs(tokens, t, "http") or tokenIs(tokens, t, "https")) and
+            std.mem.startsWith(u8, tokens.text[t.end()..], "://"))
+        {
+            url_count += 1;
+            while (i + 1 < items.len and !items[i + 1].has(tokenizer.TOK_SPACE_BEFORE)) : (i += 1) {}
+            continue;
         }
 
-        if (i + 5 < text.len and text[i] == '(') {
-            if ((text[i + 1] == '1' and text[i + 2] == '9') or
-                (text[i + 1] == '2' and text[i + 2] == '0'))
+        if (t.has(tokenizer.TOK_NUMERIC) and tokens.after(t, 0) == ')') {
+            const open = tokens.before(t);
+            const digits = tokens.bytes(t);
+            if (open == '(' and t.len == 4 and
+                (std.mem.startsWith(u8, digits, "19") or std.mem.startsWith(u8, digits, "20")))
             {
-                if (std.ascii.isDigit(text[i + 3]) and std.ascii.isDigit(text[i + 4]) and text[i + 5] == ')') {
-                    year_count += 1;
-                    i += 6;
-                    continue;
-                }
+                year_count += 1;
             }
         }
 
-        if (i + 2 < text.len and text[i] == '[' and std.ascii.isDigit(text[i + 1])) {
-            var j = i + 1;
-            while (j < text.len and std.ascii.isDigit(text[j])) : (j += 1) {}
-            if (j < text.len and text[j] == ']' and j - i - 1 <= 4) {
-                num_ref_count += 1;
-                i = j + 1;
-                continue;
-            }
+        if (t.has(tokenizer.TOK_NUMERIC) and t.len <= 4 and
+            tokens.before(t) == '[' and tokens.after(t, 0) == ']')
+        {
+            num_ref_count += 1;
         }
-
-        i += 1;
     }
 
     b.setU32(capnp.OFF_CIT_TOTAL, doi_count + isbn_count + url_count + year_count + num_ref_count);
@@ -458,52 +382,116 @@ fn stageOcrConfidence(b: *capnp.Builder, confidence: i32) void {
     b.setI32(capnp.OFF_OCR_CONF, confidence);
 }
 
-/// Perceptual hash (average hash) via Leptonica.
-fn stagePerceptualHash(b: *capnp.Builder, input_path: [*:0]const u8) void {
-    const pix = c.pixRead(input_path);
-    if (pix == null) return;
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; pix will not be used after this
-    defer c.pixDestroy(@constCast(&pix));
-
-    const gray = c.pixConvertTo8(pix, 0);
-    if (gray == null) return;
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; gray will not be used after this
-    defer c.pixDestroy(@constCast(&gray));
-
-    const pw: u32 = @intCast(c.pixGetWidth(gray));
-    const ph: u32 = @intCast(c.pixGetHeight(gray));
-    if (pw < 8 or ph < 8) return;
-
-    var values: [64]f64 = undefined;
-    var total: f64 = 0.0;
-    for (0..8) |row| {
-        for (0..8) |col| {
-            const x: c_int = @intCast(@as(u32, @intCast(col)) * pw / 8 + pw / 16);
-            const y: c_int = @intCast(@as(u32, @intCast(row)) * ph / 8 + ph / 16);
-            var pixel: c.l_uint32 = 0;
-            _ = c.pixGetPixel(gray, x, y, &pixel);
-            const val: f64 = @floatFromInt(pixel & 0xFF);
-            values[row * 8 + col] = val;
-            total += val;
+/// An image document decoded once per parse. The base parser decodes it
+/// for Tesseract through load(), and the image stages (perceptual hash,
+/// near-dedup, multi-language OCR) read the same PIX and share the 8-bit
+/// grayscale and average hash derived from it on first use, instead of
+/// each decoding the file again. One lives in each parse handle and is
+/// released after every document.
+pub const SharedImage = struct {
+    pix: [*c]c.PIX = null,
+    gray: [*c]c.PIX = null,
+    ahash: ?u64 = null,
+    /// A decode was attempted; a file Leptonica cannot read is not retried
+    tried: bool = false,
+
+    /// Decode the image from the mapped bytes, or from `path` without
+    /// them. Returns the PIX, or null if it cannot be decoded. Opaque
+    /// because the caller's @cImport has its own PIX type.
+    pub fn load(self: *SharedImage, path: [*:0]const u8, mem: ?[]const u8) ?*anyopaque {
+        if (!self.tried) {
+            self.tried = true;
+            self.pix = if (mem) |bytes| c.pixReadMem(bytes.ptr, bytes.len) else c.pixRead(path);
         }
+        // SAFETY: PIX* from Leptonica is cast to *anyopaque for the base parser, which casts it back to its own cImport's PIX
+        return if (self.pix != null) @ptrCast(self.pix) else null;
     }
 
-    const mean = total / 64.0;
-    var hash: u64 = 0;
-    for (0..64) |idx| {
-        if (values[idx] > mean) {
-            hash |= @as(u64, 1) << @as(u6, @intCast(idx));
+    /// The decoded image; decoded from `path` here when the base parse did
+    /// not (GPU OCR handled it).
+    fn image(self: *SharedImage, path: [*:0]const u8) [*c]c.PIX {
+        _ = self.load(path, null);
+        return self.pix;
+    }
+
+    /// 8-bit grayscale of the image, derived once. Always a separate PIX,
+    /// never a clone of the original, so reading it cannot race with the
+    /// original's reference count while another thread OCRs the original.
+    fn grayscale(self: *SharedImage, path: [*:0]const u8) [*c]c.PIX {
+        if (self.gray == null) {
+            const pix = self.image(path);
+            if (pix == null) return null;
+            var gray = c.pixConvertTo8(pix, 0);
+            if (gray == pix) {
+                // 8 bpp input comes back as a clone
+                c.pixDestroy(&gray);
+                gray = c.pixCopy(null, pix);
+            }
+            self.gray = gray;
         }
+        return self.gray;
     }
 
+    /// 8x8 average hash of the grayscale image, computed once for both the
+    /// perceptual-hash and near-dedup stages. Null for images under 8x8.
+    pub fn averageHash(self: *SharedImage, path: [*:0]const u8) ?u64 {
+        if (self.ahash == null) {
+            const gray = self.grayscale(path);
+            if (gray == null) return null;
+
+            const pw: u32 = @intCast(c.pixGetWidth(gray));
+            const ph: u32 = @intCast(c.pixGetHeight(gray));
+            if (pw < 8 or ph < 8) return null;
+
+            var values: [64]f64 = undefined;
+            var total: f64 = 0.0;
+            for (0..8) |row| {
+                for (0..8) |col| {
+                    const x: c_int = @intCast(@as(u32, @intCast(col)) * pw / 8 + pw / 16);
+                    const y: c_int = @intCast(@as(u32, @intCast(row)) * ph / 8 + ph / 16);
+                    var pixel: c.l_uint32 = 0;
+                    _ = c.pixGetPixel(gray, x, y, &pixel);
+                    const val: f64 = @floatFromInt(pixel & 0xFF);
+                    values[row * 8 + col] = val;
+                    total += val;
+                }
+            }
+
+            const mean = total / 64.0;
+            var hash: u64 = 0;
+            for (0..64) |idx| {
+                if (values[idx] > mean) {
+                    hash |= @as(u64, 1) << @as(u6, @intCast(idx));
+                }
+            }
+            self.ahash = hash;
+        }
+        return self.ahash;
+    }
+
+    /// Free the decoded image and everything derived from it.
+    pub fn release(self: *SharedImage) void {
+        if (self.gray != null) c.pixDestroy(&self.gray);
+        if (self.pix != null) c.pixDestroy(&self.pix);
+        self.* = .{};
+    }
+};
+
+/// Write a 64-bit hash as 16 lower-case hex digits.
+fn setHashText(b: *capnp.Builder, ptr_idx: usize, hash: u64) void {
     var hex_buf: [16]u8 = undefined;
     const hex_chars = "0123456789abcdef";
     for (0..16) |hi| {
         const shift: u6 = @intCast((15 - hi) * 4);
         hex_buf[hi] = hex_chars[@as(usize, @intCast((hash >> shift) & 0xF))];
     }
+    b.setText(ptr_idx, &hex_buf);
+}
 
-    b.setText(capnp.PTR_PHASH_AHASH, &hex_buf);
+/// Perceptual hash (average hash) via Leptonica.
+fn stagePerceptualHash(b: *capnp.Builder, image: *SharedImage, input_path: [*:0]const u8) void {
+    const hash = image.averageHash(input_path) orelse return;
+    setHashText(b, capnp.PTR_PHASH_AHASH, hash);
 }
 
 // ============================================================================
@@ -741,21 +729,20 @@ const MerkleStack = struct {
     }
 };
 
+/// Merkle leaf size — extracted content is hashed in 4 KB chunks.
+const MERKLE_CHUNK: usize = 4096;
+
 /// Merkle proof — SHA-256 hash tree over extracted content chunks.
 /// Uses streaming computation: O(log n) memory instead of O(n).
-fn stageMerkleProof(b: *capnp.Builder, output_path: [*:0]const u8) void {
-    const file = std.fs.openFileAbsoluteZ(output_path, .{}) catch return;
-    defer file.close();
-
+fn stageMerkleProof(b: *capnp.Builder, text: []const u8) void {
     var tree = MerkleStack.init();
-    var chunk_buf: [4096]u8 = undefined;
-
-    while (true) {
-        const n = file.read(&chunk_buf) catch break;
-        if (n == 0) break;
-        var hasher = std.crypto.hash.sha2.Sha256.init(.{});
-        hasher.update(chunk_buf[0..n]);
-        tree.pushLeaf(hasher.finalResult());
+
+    var off: usize = 0;
+    while (off < text.len) : (off += MERKLE_CHUNK) {
+        const chunk = text[off..@min(off + MERKLE_CHUNK, text.len)];
+        var digest: [32]u8 = undefined;
+        std.crypto.hash.sha2.Sha256.hash(chunk, &digest, .{});
+        tree.pushLeaf(digest);
     }
 
     if (tree.leaf_count == 0) {
@@ -784,55 +771,52 @@ fn stageExactDedup(b: *capnp.Builder, sha256: *const [65]u8) void {
     b.setText(capnp.PTR_EXACT_SHA, std.mem.sliceTo(sha256, 0));
 }
 
-/// Near dedup support — perceptual hash for image comparison.
-fn stageNearDedup(b: *capnp.Builder, input_path: [*:0]const u8, content_kind: c_int) void {
+/// Near dedup support — perceptual hash for image comparison. With an
+/// index bound, the hash is checked against every earlier document's and
+/// added; with a verdict, the caller already did that against every
+/// shard. Returns the nearest match within the radius.
+fn stageNearDedup(b: *capnp.Builder, image: *SharedImage, input_path: [*:0]const u8, content_kind: c_int, check: ?NearDupCheck) ?neardup.Match {
     if (content_kind != CK_IMAGE) {
         b.setText(capnp.PTR_NEAR_STATUS, "not_applicable");
         b.setText(capnp.PTR_NEAR_REASON, "not an image");
-        return;
-    }
-
-    const pix = c.pixRead(input_path);
-    if (pix == null) return;
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; pix will not be used after this
-    defer c.pixDestroy(@constCast(&pix));
-
-    const gray = c.pixConvertTo8(pix, 0);
-    if (gray == null) return;
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; gray will not be used after this
-    defer c.pixDestroy(@constCast(&gray));
-
-    const pw: u32 = @intCast(c.pixGetWidth(gray));
-    const ph: u32 = @intCast(c.pixGetHeight(gray));
-    if (pw < 8 or ph < 8) return;
-
-    var values: [64]f64 = undefined;
-    var total: f64 = 0.0;
-    for (0..8) |row| {
-        for (0..8) |col| {
-            const x: c_int = @intCast(@as(u32, @intCast(col)) * pw / 8 + pw / 16);
-            const y: c_int = @intCast(@as(u32, @intCast(row)) * ph / 8 + ph / 16);
-            var pixel: c.l_uint32 = 0;
-            _ = c.pixGetPixel(gray, x, y, &pixel);
-            const val: f64 = @floatFromInt(pixel & 0xFF);
-            values[row * 8 + col] = val;
-            total += val;
-        }
+        return null;
     }
 
-    const mean_val = total / 64.0;
-    var hash: u64 = 0;
-    for (0..64) |idx| {
-        if (values[idx] > mean_val) hash |= @as(u64, 1) << @as(u6, @intCast(idx));
+    // The verdict's hash was computed from the same image; not redone
+    if (check) |nd| {
+        if (nd == .verdict and image.ahash == null) image.ahash = nd.verdict.hash;
     }
+    const hash = image.averageHash(input_path) orelse return null;
+    setHashText(b, capnp.PTR_NEAR_AHASH, hash);
+
+    const nd = check orelse return null;
+    var max_hamming: u8 = undefined;
+    const match: ?neardup.Match = switch (nd) {
+        .index => |ix| blk: {
+            max_hamming = ix.max_hamming;
+            break :blk ix.index.checkInsert(hash, ix.doc_id, ix.max_hamming) catch |err| {
+                b.setText(capnp.PTR_NEAR_STATUS, "error");
+                b.setText(capnp.PTR_NEAR_REASON, @errorName(err));
+                return null;
+            };
+        },
+        .verdict => |v| blk: {
+            max_hamming = v.max_hamming;
+            break :blk if (v.matched != 0) .{ .doc_id = v.match_doc, .distance = v.distance } else null;
+        },
+    };
 
-    var hex_buf: [16]u8 = undefined;
-    const hex_chars = "0123456789abcdef";
-    for (0..16) |hi| {
-        const shift: u6 = @intCast((15 - hi) * 4);
-        hex_buf[hi] = hex_chars[@as(usize, @intCast((hash >> shift) & 0xF))];
+    var reason_buf: [128]u8 = undefined;
+    if (match) |m| {
+        const reason = std.fmt.bufPrint(&reason_buf, "within {d} bit(s) of document {d}", .{ m.distance, m.doc_id }) catch "near-duplicate";
+        b.setText(capnp.PTR_NEAR_STATUS, "duplicate");
+        b.setText(capnp.PTR_NEAR_REASON, reason);
+    } else {
+        const reason = std.fmt.bufPrint(&reason_buf, "no indexed hash within {d} bit(s)", .{max_hamming}) catch "unique";
+        b.setText(capnp.PTR_NEAR_STATUS, "unique");
+        b.setText(capnp.PTR_NEAR_REASON, reason);
     }
-    b.setText(capnp.PTR_NEAR_AHASH, &hex_buf);
+    return match;
 }
 
 /// Coordinate normalization — CRS and bounding box from GDAL.
@@ -878,46 +862,172 @@ fn writeStub(b: *capnp.Builder, status_ptr: usize, reason_ptr: usize, reason: []
 // Multi-Language OCR
 // ============================================================================
 
-fn stageMultiLangOcr(b: *capnp.Builder, input_path: [*:0]const u8) void {
-    const tess = c.TessBaseAPICreate();
-    if (tess == null) return;
-    defer c.TessBaseAPIDelete(tess);
+const MLANG_LANGS = "eng+fra+deu+spa+ita+por";
+
+/// Render resolution for scanned PDF pages handed to Tesseract.
+const MLANG_PDF_DPI: f64 = 300.0;
+
+/// Multi-language OCR totals. For a PDF they cover its scanned pages (no
+/// text layer), summed over page ranges when the document was split.
+pub const MlangTally = extern struct {
+    /// Pages (or images) recognised
+    pages: u32 = 0,
+    /// Sum of per-page mean confidences (0-100 each)
+    conf_sum: u32 = 0,
+    words: u64 = 0,
+    chars: u64 = 0,
+
+    pub fn add(self: *MlangTally, other: MlangTally) void {
+        self.pages += other.pages;
+        self.conf_sum += other.conf_sum;
+        self.words += other.words;
+        self.chars += other.chars;
+    }
+};
 
-    if (c.TessBaseAPIInit3(tess, null, "eng+fra+deu+spa+ita+por") != 0) {
-        if (c.TessBaseAPIInit3(tess, null, "eng") != 0) return;
+/// Create a Tesseract instance with the multi-language model (falling back
+/// to English). Opaque so the parse handle can keep it warm; null if no
+/// model could be loaded.
+pub fn mlangTessCreate() ?*anyopaque {
+    const tess = c.TessBaseAPICreate() orelse return null;
+    if (c.TessBaseAPIInit3(tess, null, MLANG_LANGS) != 0 and
+        c.TessBaseAPIInit3(tess, null, "eng") != 0)
+    {
+        c.TessBaseAPIDelete(tess);
+        return null;
     }
+    // SAFETY: TessBaseAPI* from the Tesseract C API is cast to *anyopaque for the parse handle; mlangTessDestroy/PdfPageOcr cast it back
+    return @ptrCast(tess);
+}
 
-    const pix = c.pixRead(input_path);
-    if (pix == null) return;
-    // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; pix will not be used after this
-    defer c.pixDestroy(@constCast(&pix));
+/// Free an instance from mlangTessCreate(). Safe with null.
+pub fn mlangTessDestroy(handle: ?*anyopaque) void {
+    const ptr = handle orelse return;
+    // SAFETY: ptr originates from mlangTessCreate() which returns a *TessBaseAPI via @ptrCast
+    const tess: *c.TessBaseAPI = @ptrCast(@alignCast(ptr));
+    c.TessBaseAPIEnd(tess);
+    c.TessBaseAPIDelete(tess);
+}
 
+/// Recognise one image and add its confidence and counts to the tally.
+fn ocrPix(tess: *c.TessBaseAPI, pix: ?*c.PIX, tally: *MlangTally) void {
     c.TessBaseAPISetImage2(tess, pix);
+    defer c.TessBaseAPIClear(tess);
     if (c.TessBaseAPIRecognize(tess, null) != 0) return;
 
-    const conf = c.TessBaseAPIMeanTextConf(tess);
+    tally.pages += 1;
+    tally.conf_sum += @intCast(std.math.clamp(c.TessBaseAPIMeanTextConf(tess), 0, 100));
     const text_ptr = c.TessBaseAPIGetUTF8Text(tess);
-    var word_count: u64 = 0;
-    var char_count: u64 = 0;
     if (text_ptr != null) {
         const text = std.mem.span(text_ptr);
-        char_count = text.len;
+        tally.chars += text.len;
         var in_word = false;
         for (text) |ch| {
             if (ch == ' ' or ch == '\n' or ch == '\r' or ch == '\t') {
-                if (in_word) { word_count += 1; in_word = false; }
+                if (in_word) { tally.words += 1; in_word = false; }
             } else {
                 in_word = true;
             }
         }
-        if (in_word) word_count += 1;
+        if (in_word) tally.words += 1;
         c.TessDeleteText(text_ptr);
     }
+}
+
+/// Scanned-page OCR for one PDF (or one page range of it). The base
+/// parser calls page() for every page whose text layer is blank; the page
+/// is rendered by libvips' PDF loader and recognised with the handle's
+/// multi-language model.
+pub const PdfPageOcr = struct {
+    /// From mlangTessCreate()
+    tess: *anyopaque,
+    input_path: [*:0]const u8,
+    /// Mapped file bytes (rendered from memory), or null to load input_path
+    mem: ?[]const u8 = null,
+    tally: MlangTally = .{},
+
+    /// OCR page `index` (0-based). A page libvips cannot render is skipped.
+    pub fn page(self: *PdfPageOcr, index: c_int) void {
+        const span = metrics.stageSpan(STAGE_MULTI_LANG_OCR);
+        defer span.end();
+
+        var img: [*c]c.VipsImage = null;
+        const opt_page: [*:0]const u8 = "page";
+        const opt_dpi: [*:0]const u8 = "dpi";
+        const end: ?*anyopaque = null;
+        const rc = if (self.mem) |bytes|
+            // SAFETY: vips_pdfload_buffer takes void* but only reads the bytes; the mapping outlives the call
+            c.vips_pdfload_buffer(@constCast(bytes.ptr), bytes.len, &img, opt_page, index, opt_dpi, MLANG_PDF_DPI, end)
+        else
+            c.vips_pdfload(self.input_path, &img, opt_page, index, opt_dpi, MLANG_PDF_DPI, end);
+        if (rc != 0 or img == null) {
+            c.vips_error_clear();
+            return;
+        }
+        defer c.g_object_unref(img);
+
+        // PNG round trip: Leptonica reads it without a pixel-format shim
+        var png: ?*anyopaque = null;
+        var png_len: usize = 0;
+        if (c.vips_image_write_to_buffer(img, ".png", &png, &png_len, end) != 0) {
+            c.vips_error_clear();
+            return;
+        }
+        defer c.g_free(png);
+
+        // SAFETY: png is a libvips-allocated byte buffer of png_len bytes; pixReadMem reads it as l_uint8
+        const pix = c.pixReadMem(@ptrCast(png), png_len);
+        if (pix == null) return;
+        // SAFETY: @constCast required because pixDestroy takes *?*PIX (mutable pointer) but only reads then nullifies; pix will not be used after this
+        defer c.pixDestroy(@constCast(&pix));
+
+        // SAFETY: self.tess originates from mlangTessCreate() which returns a *TessBaseAPI via @ptrCast
+        ocrPix(@ptrCast(@alignCast(self.tess)), pix, &self.tally);
+    }
+};
+
+/// Multi-language OCR of an image document on a helper thread. runStages
+/// starts it after the hash and near-dedup stages, and only for an image
+/// that is not a near-duplicate, so it overlaps the AV, geospatial and ML
+/// stages; it is joined before the message is written. The thread reads
+/// only the shared original PIX, uses the handle's Tesseract (nothing else
+/// touches it until finish()) and writes only its own tally; the caller
+/// records the stage span around start() and finish().
+const ImageOcrJob = struct {
+    /// From mlangTessCreate()
+    tess: *anyopaque,
+    pix: [*c]c.PIX,
+    tally: MlangTally = .{},
+    thread: ?std.Thread = null,
+
+    /// Begin OCR of `pix`, which must stay alive until finish(). Runs
+    /// synchronously if the helper thread cannot be spawned.
+    fn start(self: *ImageOcrJob, tess: *anyopaque, pix: [*c]c.PIX) void {
+        self.* = .{ .tess = tess, .pix = pix };
+        self.thread = std.Thread.spawn(.{}, run, .{self}) catch null;
+        if (self.thread == null) run(self);
+    }
+
+    /// Wait for the OCR; null if no page was recognised.
+    fn finish(self: *ImageOcrJob) ?MlangTally {
+        if (self.thread) |t| {
+            t.join();
+            self.thread = null;
+        }
+        return if (self.tally.pages > 0) self.tally else null;
+    }
 
-    b.setText(capnp.PTR_MLANG_LANGS, "eng+fra+deu+spa+ita+por");
-    b.setI32(capnp.OFF_MLANG_CONF, @intCast(conf));
-    b.setU64(capnp.OFF_MLANG_WORDS, word_count);
-    b.setU64(capnp.OFF_MLANG_CHARS, char_count);
+    fn run(self: *ImageOcrJob) void {
+        // SAFETY: self.tess originates from mlangTessCreate() which returns a *TessBaseAPI via @ptrCast
+        ocrPix(@ptrCast(@alignCast(self.tess)), self.pix, &self.tally);
+    }
+};
+
+fn writeMlang(b: *capnp.Builder, tally: MlangTally) void {
+    b.setText(capnp.PTR_MLANG_LANGS, MLANG_LANGS);
+    b.setI32(capnp.OFF_MLANG_CONF, if (tally.pages > 0) @intCast(tally.conf_sum / tally.pages) else -1);
+    b.setU64(capnp.OFF_MLANG_WORDS, tally.words);
+    b.setU64(capnp.OFF_MLANG_CHARS, tally.chars);
 }
 
 // ============================================================================
@@ -991,45 +1101,47 @@ fn stageRedactionDetect(b: *capnp.Builder, input_path: [*:0]const u8) void {
 
 /// Financial entity extraction — pattern-based detection of monetary amounts,
 /// account numbers, transaction references, and currency codes in extracted text.
-fn stageFinancialExtract(b: *capnp.Builder, text: []const u8) void {
+fn stageFinancialExtract(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
     var amount_count: u32 = 0;
     var account_count: u32 = 0;
-    var i: usize = 0;
+    const text = tokens.text;
+    const items = tokens.items;
 
-    while (i < text.len) : (i += 1) {
-        // Detect currency symbols/codes followed by digits: $, £, €, USD, GBP, EUR
-        if (text[i] == '$' or text[i] == 0xC2 or // £ = C2 A3 in UTF-8
-            text[i] == 0xE2) // € = E2 82 AC in UTF-8
+    var i: usize = 0;
+    while (i < items.len) : (i += 1) {
+        const t = items[i];
+        const word = tokens.bytes(t);
+
+        // Currency symbol then digits: "$ 1,200", "£40" (C2 A3), "€9" (E2 82 AC).
+        // A UTF-8 symbol is part of the token it prefixes
+        if (t.has(tokenizer.TOK_NUMERIC)) {
+            var j: usize = t.start;
+            while (j > 0 and (text[j - 1] == ' ' or text[j - 1] == ',')) : (j -= 1) {}
+            if (j > 0 and text[j - 1] == '$') amount_count += 1;
+        } else if ((std.mem.startsWith(u8, word, "\xc2\xa3") and word.len > 2 and std.ascii.isDigit(word[2])) or
+            (std.mem.startsWith(u8, word, "\xe2\x82\xac") and word.len > 3 and std.ascii.isDigit(word[3])))
         {
-            // Scan forward for digits
-            var j = i + 1;
-            if (text[i] == 0xC2 or text[i] == 0xE2) j = i + 2; // skip multi-byte
-            if (j < text.len and text[i] == 0xE2) j = i + 3;
-            while (j < text.len and (text[j] == ' ' or text[j] == ',')) : (j += 1) {}
-            if (j < text.len and text[j] >= '0' and text[j] <= '9') {
-                amount_count += 1;
-            }
+            amount_count += 1;
         }
 
-        // Detect "USD", "GBP", "EUR", "CHF" followed by space and digits
-        if (i + 4 < text.len and text[i + 3] == ' ') {
-            const code = text[i .. i + 3];
-            if (std.mem.eql(u8, code, "USD") or std.mem.eql(u8, code, "GBP") or
-                std.mem.eql(u8, code, "EUR") or std.mem.eql(u8, code, "CHF") or
-                std.mem.eql(u8, code, "JPY") or std.mem.eql(u8, code, "CAD"))
+        // "USD", "GBP", "EUR", "CHF", "JPY", "CAD" followed by space and digits
+        if (t.len == 3 and tokens.after(t, 0) == ' ' and std.ascii.isDigit(tokens.after(t, 1))) {
+            if (std.mem.eql(u8, word, "USD") or std.mem.eql(u8, word, "GBP") or
+                std.mem.eql(u8, word, "EUR") or std.mem.eql(u8, word, "CHF") or
+                std.mem.eql(u8, word, "JPY") or std.mem.eql(u8, word, "CAD"))
             {
-                if (i + 4 < text.len and text[i + 4] >= '0' and text[i + 4] <= '9') {
-                    amount_count += 1;
-                }
+                amount_count += 1;
             }
         }
 
-        // Detect account-like patterns: sequences of 8+ digits with optional dashes
-        if (text[i] >= '0' and text[i] <= '9') {
-            var digit_count: u32 = 0;
+        // Account-like patterns: 8-20 digits, optionally grouped with dashes
+        if (t.has(tokenizer.TOK_NUMERIC)) {
+            var digit_count: usize = t.len;
             var k = i;
-            while (k < text.len and (text[k] >= '0' and text[k] <= '9' or text[k] == '-')) : (k += 1) {
-                if (text[k] >= '0' and text[k] <= '9') digit_count += 1;
+            while (k + 1 < items.len and tokens.after(items[k], 0) == '-' and
+                items[k + 1].start == items[k].end() + 1 and items[k + 1].has(tokenizer.TOK_NUMERIC)) : (k += 1)
+            {
+                digit_count += items[k + 1].len;
             }
             if (digit_count >= 8 and digit_count <= 20) {
                 account_count += 1;
@@ -1053,44 +1165,36 @@ fn stageFinancialExtract(b: *capnp.Builder, text: []const u8) void {
 /// Legal NER — pattern-based detection of legal entities: case citations,
 /// docket numbers, statute references, judge names, and party identifiers.
 /// Complements the general NER stage with domain-specific legal patterns.
-fn stageLegalNer(b: *capnp.Builder, text: []const u8) void {
+fn stageLegalNer(b: *capnp.Builder, tokens: *const tokenizer.Tokens) void {
     var case_citations: u32 = 0;
     var docket_refs: u32 = 0;
     var statute_refs: u32 = 0;
-    var i: usize = 0;
 
-    while (i < text.len) : (i += 1) {
-        // Case citations: "v." or "vs." pattern (e.g. "Doe v. Epstein")
-        if (i + 2 < text.len and text[i] == 'v' and text[i + 1] == '.') {
-            // Check preceding word and following word exist
-            if (i > 0 and text[i - 1] == ' ' and i + 2 < text.len and text[i + 2] == ' ') {
-                case_citations += 1;
-            }
+    for (tokens.items) |t| {
+        const word = tokens.bytes(t);
+
+        // Case citations: " v. " between party names (e.g. "Doe v. Epstein")
+        if (tokens.before(t) == ' ' and tokenIs(tokens, t, "v") and
+            tokens.after(t, 0) == '.' and tokens.after(t, 1) == ' ')
+        {
+            case_citations += 1;
         }
 
         // Docket numbers: patterns like "No. 08-cv-1234" or "Case 1:15-cv-07433"
-        if (i + 3 < text.len) {
-            const prefix = text[i .. i + 3];
-            if (std.mem.eql(u8, prefix, "No.") or std.mem.eql(u8, prefix, "no.")) {
-                docket_refs += 1;
-            }
+        if ((tokenIs(tokens, t, "No") or tokenIs(tokens, t, "no")) and tokens.after(t, 0) == '.') {
+            docket_refs += 1;
         }
-        if (i + 4 < text.len) {
-            const prefix = text[i .. i + 4];
-            if (std.mem.eql(u8, prefix, "Case") and i + 5 < text.len and text[i + 4] == ' ') {
-                // Look for digit following "Case "
-                if (text[i + 5] >= '0' and text[i + 5] <= '9') {
-                    docket_refs += 1;
-                }
-            }
+        if (tokenIs(tokens, t, "Case") and tokens.after(t, 0) == ' ' and std.ascii.isDigit(tokens.after(t, 1))) {
+            docket_refs += 1;
         }
 
-        // Statute references: "U.S.C." or "§" (section symbol, C2 A7 in UTF-8)
-        if (i + 5 < text.len and std.mem.eql(u8, text[i .. i + 5], "U.S.C")) {
+        // Statute references: "U.S.C." or "§" (section symbol, C2 A7 in UTF-8,
+        // inside whichever token it touches)
+        if (tokenIs(tokens, t, "U") and std.mem.startsWith(u8, tokens.text[t.start..], "U.S.C")) {
             statute_refs += 1;
         }
-        if (text[i] == 0xC2 and i + 1 < text.len and text[i + 1] == 0xA7) {
-            statute_refs += 1;
+        if (t.has(tokenizer.TOK_NON_ASCII)) {
+            statute_refs += @intCast(std.mem.count(u8, word, "\xc2\xa7"));
         }
     }
 
@@ -1127,100 +1231,181 @@ fn uriFromPath(path: [*:0]const u8) ?[4096]u8 {
 
 /// Run all enabled processing stages. Called from ddac_parse after base parse.
 /// Writes results to {output_path}.stages.capnp in Cap'n Proto binary format.
-pub fn runStages(ctx: StageContext) void {
-    if (ctx.stages == STAGE_NONE) return;
+/// Returns the stages mask of the message written (ctx.stages plus those of
+/// ctx.existing), or 0 if none was written.
+pub fn runStages(ctx: StageContext) u64 {
+    if (ctx.stages == STAGE_NONE) return 0;
 
     // Build stages output path: {output_path}.stages.capnp
     const path_slice = std.mem.span(ctx.output_path);
     const suffix = ".stages.capnp";
     var path_buf: [4096]u8 = undefined;
-    if (path_slice.len + suffix.len >= 4096) return;
+    if (path_slice.len + suffix.len >= 4096) return 0;
     @memcpy(path_buf[0..path_slice.len], path_slice);
     @memcpy(path_buf[path_slice.len .. path_slice.len + suffix.len], suffix);
     path_buf[path_slice.len + suffix.len] = 0;
 
     // SAFETY: path_buf was null-terminated on line 1135; the sentinel-terminated slice is valid; @ptrCast converts the slice pointer to [*:0]u8
     const stages_path: [*:0]u8 = @ptrCast(path_buf[0 .. path_slice.len + suffix.len :0]);
-    const file = std.fs.createFileAbsoluteZ(stages_path, .{}) catch return;
-    defer file.close();
 
-    // Initialise Cap'n Proto builder (64 KB stack buffer)
-    var buf: [65536]u8 align(8) = undefined;
-    var b = capnp.Builder.init(&buf);
-    b.initRoot();
+    // Initialise the Cap'n Proto builder in the handle's segment arena (or
+    // a one-off arena), on top of the earlier run's message when re-extracting
+    var own_segments = capnp.Arena.init(std.heap.c_allocator);
+    defer own_segments.deinit();
+    var b = capnp.Builder.init(ctx.arena orelse &own_segments);
+    const reopened = if (ctx.existing) |msg| b.reopen(msg) else false;
+    // An earlier message that cannot be extended is left as it is
+    if (ctx.existing != null and !reopened) return 0;
+    if (!reopened) b.initRoot();
 
     // Write the stages bitmask so readers know which fields are populated
-    b.setU64(capnp.OFF_STAGES_MASK, ctx.stages);
+    const mask = ctx.stages | (if (reopened) b.getU64(capnp.OFF_STAGES_MASK) else 0);
+    b.setU64(capnp.OFF_STAGES_MASK, mask);
 
     // ── Phase 1: Result-only stages (no extra I/O) ───────────────────
 
     if (ctx.stages & STAGE_PREMIS_METADATA != 0) {
+        const span = metrics.stageSpan(STAGE_PREMIS_METADATA);
+        defer span.end();
         stagePremisMetadata(&b, &ctx);
     }
 
     if (ctx.stages & STAGE_EXACT_DEDUP != 0) {
+        const span = metrics.stageSpan(STAGE_EXACT_DEDUP);
+        defer span.end();
         stageExactDedup(&b, ctx.sha256);
     }
 
     if (ctx.stages & STAGE_OCR_CONFIDENCE != 0 and ctx.content_kind == CK_IMAGE and ctx.ocr_confidence >= 0) {
+        const span = metrics.stageSpan(STAGE_OCR_CONFIDENCE);
+        defer span.end();
         stageOcrConfidence(&b, ctx.ocr_confidence);
     }
 
-    // ── Phase 2: Text-based stages (read extracted text) ─────────────
+    // ── Phase 2: Text-based stages (over the in-memory extracted text) ──
 
     const needs_text = (ctx.stages & (STAGE_LANGUAGE_DETECT | STAGE_READABILITY |
         STAGE_KEYWORDS | STAGE_CITATION_EXTRACT |
-        STAGE_FINANCIAL_EXTRACT | STAGE_LEGAL_NER)) != 0;
+        STAGE_FINANCIAL_EXTRACT | STAGE_LEGAL_NER | STAGE_MERKLE_PROOF)) != 0;
 
-    if (needs_text) {
-        var arena = std.heap.ArenaAllocator.init(std.heap.c_allocator);
-        defer arena.deinit();
+    // Holds the tokens, and the text when the caller did not hand us the
+    // text arena
+    var arena = std.heap.ArenaAllocator.init(std.heap.c_allocator);
+    defer arena.deinit();
 
-        if (readExtractedText(ctx.output_path, arena.allocator())) |text| {
-            if (ctx.stages & STAGE_LANGUAGE_DETECT != 0)
-                stageLanguageDetect(&b, text);
+    const doc_text: ?[]const u8 = if (!needs_text)
+        null
+    else if (ctx.text) |t|
+        (if (t.len > 0) t else null)
+    else
+        readExtractedText(ctx.output_path, arena.allocator());
+
+    // One tokenizer pass feeds every text stage
+    const text_stages = STAGE_LANGUAGE_DETECT | STAGE_READABILITY | STAGE_KEYWORDS |
+        STAGE_CITATION_EXTRACT | STAGE_FINANCIAL_EXTRACT | STAGE_LEGAL_NER;
+    const tokens: ?tokenizer.Tokens = if (doc_text != null and ctx.stages & text_stages != 0)
+        tokenizer.tokenize(arena.allocator(), doc_text.?) catch |err| blk: {
+            std.log.err("Tokenizer failed, text stages skipped: {s}", .{@errorName(err)});
+            break :blk null;
+        }
+    else
+        null;
+
+    if (tokens) |*toks| {
+        if (ctx.stages & STAGE_LANGUAGE_DETECT != 0) {
+            const span = metrics.stageSpan(STAGE_LANGUAGE_DETECT);
+            defer span.end();
+            stageLanguageDetect(&b, toks);
+        }
 
-            if (ctx.stages & STAGE_READABILITY != 0)
-                stageReadability(&b, text);
+        if (ctx.stages & STAGE_READABILITY != 0) {
+            const span = metrics.stageSpan(STAGE_READABILITY);
+            defer span.end();
+            stageReadability(&b, toks);
+        }
 
-            if (ctx.stages & STAGE_KEYWORDS != 0)
-                stageKeywords(&b, text);
+        if (ctx.stages & STAGE_KEYWORDS != 0) {
+            const span = metrics.stageSpan(STAGE_KEYWORDS);
+            defer span.end();
+            stageKeywords(&b, toks);
+        }
 
-            if (ctx.stages & STAGE_CITATION_EXTRACT != 0)
-                stageCitationExtract(&b, text);
+        if (ctx.stages & STAGE_CITATION_EXTRACT != 0) {
+            const span = metrics.stageSpan(STAGE_CITATION_EXTRACT);
+            defer span.end();
+            stageCitationExtract(&b, toks);
+        }
 
-            if (ctx.stages & STAGE_FINANCIAL_EXTRACT != 0)
-                stageFinancialExtract(&b, text);
+        if (ctx.stages & STAGE_FINANCIAL_EXTRACT != 0) {
+            const span = metrics.stageSpan(STAGE_FINANCIAL_EXTRACT);
+            defer span.end();
+            stageFinancialExtract(&b, toks);
+        }
 
-            if (ctx.stages & STAGE_LEGAL_NER != 0)
-                stageLegalNer(&b, text);
+        if (ctx.stages & STAGE_LEGAL_NER != 0) {
+            const span = metrics.stageSpan(STAGE_LEGAL_NER);
+            defer span.end();
+            stageLegalNer(&b, toks);
         }
     }
 
-    // ── Phase 3: Integrity stages (read output file) ─────────────────
+    // ── Phase 3: Integrity stages (over the same extracted text) ─────
 
     if (ctx.stages & STAGE_MERKLE_PROOF != 0) {
-        stageMerkleProof(&b, ctx.output_path);
+        const span = metrics.stageSpan(STAGE_MERKLE_PROOF);
+        defer span.end();
+        stageMerkleProof(&b, doc_text orelse "");
     }
 
     // ── Phase 4: PDF-specific stages ─────────────────────────────────
 
     if (ctx.stages & STAGE_TOC_EXTRACT != 0 and ctx.content_kind == CK_PDF) {
+        const span = metrics.stageSpan(STAGE_TOC_EXTRACT);
+        defer span.end();
         stageTocExtract(&b, ctx.input_path);
     }
 
     // ── Phase 5: Image-specific stages ───────────────────────────────
+    //
+    // All read the image decoded once by the base parser. The hash stages
+    // run first: a near-duplicate of an indexed image skips its OCR and
+    // ML stages. Multi-language OCR then runs on a helper thread while
+    // the remaining stages run, and only the helper touches the original
+    // PIX after it starts.
+
+    var own_image = SharedImage{};
+    defer own_image.release();
+    const image = ctx.image orelse &own_image;
 
     if (ctx.stages & STAGE_PERCEPTUAL_HASH != 0 and ctx.content_kind == CK_IMAGE) {
-        stagePerceptualHash(&b, ctx.input_path);
+        const span = metrics.stageSpan(STAGE_PERCEPTUAL_HASH);
+        defer span.end();
+        stagePerceptualHash(&b, image, ctx.input_path);
     }
 
+    var near_dup: ?neardup.Match = null;
     if (ctx.stages & STAGE_NEAR_DEDUP != 0) {
-        stageNearDedup(&b, ctx.input_path, ctx.content_kind);
+        const span = metrics.stageSpan(STAGE_NEAR_DEDUP);
+        defer span.end();
+        near_dup = stageNearDedup(&b, image, ctx.input_path, ctx.content_kind, ctx.neardup);
+    }
+
+    var mlang_job: ImageOcrJob = undefined;
+    var mlang_span: ?metrics.Span = null;
+    if (ctx.stages & STAGE_MULTI_LANG_OCR != 0 and ctx.content_kind == CK_IMAGE and near_dup == null) {
+        if (ctx.mlang_tess) |tess| {
+            const pix = image.image(ctx.input_path);
+            if (pix != null) {
+                mlang_span = metrics.stageSpan(STAGE_MULTI_LANG_OCR);
+                mlang_job.start(tess, pix);
+            }
+        }
     }
 
-    if (ctx.stages & STAGE_MULTI_LANG_OCR != 0 and ctx.content_kind == CK_IMAGE) {
-        stageMultiLangOcr(&b, ctx.input_path);
+    // Scanned PDF pages were recognised during the base parse (per page
+    // range when the document was split); only the totals are written here
+    if (ctx.stages & STAGE_MULTI_LANG_OCR != 0 and ctx.content_kind == CK_PDF) {
+        if (ctx.mlang) |tally| writeMlang(&b, tally);
     }
 
     // ── Phase 6: AV-specific stages ──────────────────────────────────
@@ -1228,12 +1413,16 @@ pub fn runStages(ctx: StageContext) void {
     if (ctx.stages & STAGE_SUBTITLE_EXTRACT != 0 and
         (ctx.content_kind == CK_VIDEO or ctx.content_kind == CK_AUDIO))
     {
+        const span = metrics.stageSpan(STAGE_SUBTITLE_EXTRACT);
+        defer span.end();
         stageSubtitleExtract(&b, ctx.input_path);
     }
 
     // ── Phase 7: Geospatial stages ───────────────────────────────────
 
     if (ctx.stages & STAGE_COORD_NORMALIZE != 0 and ctx.content_kind == CK_GEOSPATIAL) {
+        const span = metrics.stageSpan(STAGE_COORD_NORMALIZE);
+        defer span.end();
         stageCoordNormalize(&b, ctx.input_path);
     }
 
@@ -1254,9 +1443,20 @@ pub fn runStages(ctx: StageContext) void {
         .{ .flag = STAGE_HANDWRITING_OCR, .stage_id = 4, .status_ptr = capnp.PTR_HWOCR_STATUS, .reason_ptr = capnp.PTR_HWOCR_REASON, .name = "Handwriting", .stub_msg = "Requires handwriting recognition model. Install ONNX Runtime and place handwriting_ocr.onnx in modelDir." },
     };
 
+    var skip_buf: [96]u8 = undefined;
+    const skip_reason: ?[]const u8 = if (near_dup) |m|
+        std.fmt.bufPrint(&skip_buf, "Near-duplicate of document {d}; not run.", .{m.doc_id}) catch "Near-duplicate; not run."
+    else
+        null;
+
     inline for (ml_stages) |ml_stage| {
         if (ctx.stages & ml_stage.flag != 0) {
-            if (ctx.ml_handle) |ml| {
+            const span = metrics.stageSpan(ml_stage.flag);
+            defer span.end();
+            if (skip_reason) |reason| {
+                b.setText(ml_stage.status_ptr, "skipped");
+                b.setText(ml_stage.reason_ptr, reason);
+            } else if (ctx.ml_handle) |ml| {
                 var ml_result: ml_inference.MlResult = std.mem.zeroes(ml_inference.MlResult);
                 const rc = ml_inference.ddac_ml_run_stage(ml, ml_stage.stage_id, ctx.input_path, &ml_result);
                 if (rc == 0 and ml_result.status == 0) {
@@ -1288,16 +1488,23 @@ pub fn runStages(ctx: StageContext) void {
         }
     }
 
-    if (ctx.stages & STAGE_FORMAT_CONVERT != 0)
+    if (ctx.stages & STAGE_FORMAT_CONVERT != 0) {
+        const span = metrics.stageSpan(STAGE_FORMAT_CONVERT);
+        defer span.end();
         writeStub(&b, capnp.PTR_FMTCONV_STATUS, capnp.PTR_FMTCONV_REASON, "Format conversion not yet implemented.");
+    }
 
     // ── Phase 9: Investigative document analysis stages ───────────────
 
     if (ctx.stages & STAGE_REDACTION_DETECT != 0 and ctx.content_kind == CK_PDF) {
+        const span = metrics.stageSpan(STAGE_REDACTION_DETECT);
+        defer span.end();
         stageRedactionDetect(&b, ctx.input_path);
     }
 
     if (ctx.stages & STAGE_SPEAKER_ID != 0) {
+        const span = metrics.stageSpan(STAGE_SPEAKER_ID);
+        defer span.end();
         // Speaker ID dispatches to ML — uses stage_id 5 for speaker diarization model
         if (ctx.ml_handle) |ml| {
             var ml_result: ml_inference.MlResult = std.mem.zeroes(ml_inference.MlResult);
@@ -1321,9 +1528,35 @@ pub fn runStages(ctx: StageContext) void {
         }
     }
 
-    // ── Write Cap'n Proto message to file ─────────────────────────────
+    if (mlang_span) |span| {
+        const tally = mlang_job.finish();
+        span.end();
+        if (tally) |t| writeMlang(&b, t);
+    }
+
+    // ── Write Cap'n Proto message (container blob or sidecar file) ────
+
+    if (b.segmentCount() == 0) return 0; // segment 0 could not be allocated
 
-    b.writeMessage(file) catch |err| {
+    if (ctx.blob) |blob| {
+        var header: [capnp.MAX_HEADER]u8 = undefined;
+        var parts_buf: [capnp.MAX_SEGMENTS + 1][]const u8 = undefined;
+        const parts = if (ctx.packed_encoding) blk: {
+            parts_buf[0] = b.packedMessage() orelse return 0;
+            break :blk parts_buf[0..1];
+        } else b.messageParts(&header, &parts_buf);
+        blob.append(.stages, parts) catch |err| {
+            std.log.err("Failed to append stages Cap'n Proto output: {s}", .{@errorName(err)});
+            return 0;
+        };
+        return mask;
+    }
+
+    const file = std.fs.createFileAbsoluteZ(stages_path, .{}) catch return 0;
+    defer file.close();
+    b.writeMessage(file, ctx.packed_encoding) catch |err| {
         std.log.err("Failed to write stages Cap'n Proto output: {s}", .{@errorName(err)});
+        return 0;
     };
+    return mask;
 }
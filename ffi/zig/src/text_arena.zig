@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Per-Handle Extracted Text Arena
+//
+// Base parsers append extracted text here instead of writing the output
+// file page by page. Processing stages then read the same bytes as a
+// []const u8 (no re-open, no 1 MB truncation), and the output file is
+// written once by a write-behind thread that overlaps the stage pipeline.
+//
+// One arena lives in each parse handle and is reset per document, so the
+// backing buffer is reused across the whole run.
+
+const std = @import("std");
+const container = @import("container.zig");
+
+/// Arenas grown past this are released on reset so that one outsized
+/// document does not pin its buffer for the rest of the run.
+const RETAIN_LIMIT: usize = 64 * 1024 * 1024;
+
+/// Growable buffer holding the extracted text of the current document.
+pub const TextArena = struct {
+    allocator: std.mem.Allocator,
+    buf: std.ArrayList(u8) = .{},
+    /// Set when an append could not grow the buffer; the text is truncated.
+    oom: bool = false,
+
+    pub fn init(allocator: std.mem.Allocator) TextArena {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *TextArena) void {
+        self.buf.deinit(self.allocator);
+    }
+
+    /// Start a new document: drop the previous text, keep the capacity.
+    pub fn reset(self: *TextArena) void {
+        if (self.buf.capacity > RETAIN_LIMIT) {
+            self.buf.clearAndFree(self.allocator);
+        } else {
+            self.buf.clearRetainingCapacity();
+        }
+        self.oom = false;
+    }
+
+    /// Append extracted bytes. Returns false (and sets oom) on allocation failure.
+    pub fn append(self: *TextArena, bytes: []const u8) bool {
+        self.buf.appendSlice(self.allocator, bytes) catch {
+            self.oom = true;
+            return false;
+        };
+        return true;
+    }
+
+    /// Append formatted text (metadata summaries from AV/geo parsers).
+    pub fn print(self: *TextArena, comptime fmt: []const u8, args: anytype) bool {
+        self.buf.print(self.allocator, fmt, args) catch {
+            self.oom = true;
+            return false;
+        };
+        return true;
+    }
+
+    /// Append a whole file (a page-range part being stitched). Returns
+    /// false if it cannot be read; sets oom if the buffer cannot grow.
+    pub fn appendFile(self: *TextArena, path: [*:0]const u8) bool {
+        const file = std.fs.openFileAbsoluteZ(path, .{}) catch return false;
+        defer file.close();
+        const size: usize = @intCast(file.getEndPos() catch return false);
+        self.buf.ensureUnusedCapacity(self.allocator, size) catch {
+            self.oom = true;
+            return false;
+        };
+        const dest = self.buf.unusedCapacitySlice()[0..size];
+        const n = file.readAll(dest) catch return false;
+        self.buf.items.len += n;
+        return n == size;
+    }
+
+    /// View of the current document's text, valid until the next reset.
+    pub fn slice(self: *const TextArena) []const u8 {
+        return self.buf.items;
+    }
+};
+
+// ============================================================================
+// Write-behind sink
+// ============================================================================
+
+/// Writes the arena to the output file (or, with `blob` set, appends it to
+/// a results container) on the handle's writer thread while the stages run
+/// over the same bytes. The caller must call finish() before the arena is
+/// reset or the handle is reused.
+pub const WriteBehind = struct {
+    blob: ?container.BlobTarget = null,
+    /// Writer the job was handed to; null once finished or when it ran inline
+    writer: ?*Writer = null,
+    path: [*:0]const u8 = undefined,
+    data: []const u8 = &.{},
+    ok: bool = false,
+
+    /// Begin writing `data` to `path`. With no `writer` (nothing to
+    /// overlap with) or if its thread cannot be spawned, the write happens
+    /// synchronously before start() returns.
+    pub fn start(self: *WriteBehind, writer: ?*Writer, path: [*:0]const u8, data: []const u8) void {
+        self.path = path;
+        self.data = data;
+        self.ok = false;
+        self.writer = null;
+        if (writer) |w| {
+            if (w.submit(self)) {
+                self.writer = w;
+                return;
+            }
+        }
+        run(self);
+    }
+
+    /// Wait for the write to complete. Returns true if the file was written.
+    pub fn finish(self: *WriteBehind) bool {
+        if (self.writer) |w| {
+            w.wait();
+            self.writer = null;
+        }
+        return self.ok;
+    }
+
+    fn run(self: *WriteBehind) void {
+        if (self.blob) |blob| {
+            blob.append(.text, &.{self.data}) catch |err| {
+                std.log.err("Container text append failed: {s}", .{@errorName(err)});
+                return;
+            };
+            self.ok = true;
+            return;
+        }
+        const file = std.fs.createFileAbsoluteZ(self.path, .{}) catch |err| {
+            std.log.err("Output file create failed: {s}", .{@errorName(err)});
+            return;
+        };
+        defer file.close();
+        file.writeAll(self.data) catch |err| {
+            std.log.err("Output file write failed: {s}", .{@errorName(err)});
+            return;
+        };
+        self.ok = true;
+    }
+};
+
+/// One persistent output-writer thread per parse handle, spawned on first
+/// use and signalled per document, so write-behind costs a handoff rather
+/// than a thread spawn and join. Holds at most one job at a time.
+pub const Writer = struct {
+    thread: ?std.Thread = null,
+    mutex: std.Thread.Mutex = .{},
+    cond: std.Thread.Condition = .{},
+    /// Job pending or being written; cleared by the thread when done
+    job: ?*WriteBehind = null,
+    stop: bool = false,
+    /// The thread could not be spawned; later jobs run inline
+    spawn_failed: bool = false,
+
+    /// Stop and join the thread (after any pending job). Safe if never used.
+    pub fn deinit(self: *Writer) void {
+        const t = self.thread orelse return;
+        self.mutex.lock();
+        self.stop = true;
+        self.cond.broadcast();
+        self.mutex.unlock();
+        t.join();
+        self.thread = null;
+    }
+
+    /// Hand `job` to the thread. False if it cannot be spawned.
+    fn submit(self: *Writer, job: *WriteBehind) bool {
+        if (self.thread == null) {
+            if (self.spawn_failed) return false;
+            self.thread = std.Thread.spawn(.{}, loop, .{self}) catch {
+                self.spawn_failed = true;
+                return false;
+            };
+        }
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.job = job;
+        self.cond.broadcast();
+        return true;
+    }
+
+    /// Block until the submitted job has been written.
+    fn wait(self: *Writer) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (self.job != null) self.cond.wait(&self.mutex);
+    }
+
+    fn loop(self: *Writer) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            while (self.job == null and !self.stop) self.cond.wait(&self.mutex);
+            const job = self.job orelse return;
+            self.mutex.unlock();
+            job.run();
+            self.mutex.lock();
+            self.job = null;
+            self.cond.broadcast();
+        }
+    }
+};
+
+test "writer thread is reused across documents" {
+    var path_buf: [128]u8 = undefined;
+    const path = try std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-writer-{d}", .{std.time.milliTimestamp()});
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    var writer = Writer{};
+    defer writer.deinit();
+
+    var first = WriteBehind{};
+    first.start(&writer, path, "first");
+    try std.testing.expect(first.finish());
+    const thread = writer.thread;
+
+    var second = WriteBehind{};
+    second.start(&writer, path, "second document");
+    try std.testing.expect(second.finish());
+    try std.testing.expectEqual(thread, writer.thread);
+
+    var buf: [64]u8 = undefined;
+    const file = try std.fs.openFileAbsolute(path, .{});
+    defer file.close();
+    const n = try file.readAll(&buf);
+    try std.testing.expectEqualStrings("second document", buf[0..n]);
+}
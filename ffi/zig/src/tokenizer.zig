@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+// Docudactyl — Single-Pass Text Tokenizer
+//
+// One vectorised pass over a document's extracted text feeds every text
+// stage (language detect, readability, keywords, citations, financial,
+// legal NER), so STAGE_ALL costs one walk of the text instead of one per
+// stage. Each 64-byte block is classified with @Vector(64, u8) compares
+// into u64 bit masks (letter, digit, UTF-8 lead bytes, vowel, sentence
+// punctuation); token boundaries are the mask edges, and per-token flags
+// are mask tests over the token's bits.
+//
+// A token is a maximal run of word bytes: ASCII letters, digits and any
+// byte >= 0x80 (so UTF-8 letters stay inside their token). Punctuation
+// and whitespace separate tokens; stages that match patterns such as
+// "10.1234/" or "U.S.C." look at the bytes around a token in O(1).
+//
+// The same pass also yields the document totals the stages need:
+// sentence marks, vowel groups (syllables) and script counts per UTF-8
+// lead byte. Text past 4 GiB is not tokenised (token offsets are u32).
+
+const std = @import("std");
+
+// ============================================================================
+// Stop Words (English)
+// ============================================================================
+
+/// Compile-time perfect hash map for O(1) stop-word lookup.
+/// Replaces the previous linear scan over ~120 entries.
+pub const stop_word_map = std.StaticStringMap(void).initComptime(.{
+    .{ "a", {} },       .{ "about", {} },   .{ "after", {} },   .{ "all", {} },
+    .{ "also", {} },    .{ "am", {} },      .{ "an", {} },      .{ "and", {} },
+    .{ "any", {} },     .{ "are", {} },     .{ "as", {} },      .{ "at", {} },
+    .{ "be", {} },      .{ "been", {} },    .{ "before", {} },  .{ "being", {} },
+    .{ "between", {} }, .{ "both", {} },    .{ "but", {} },     .{ "by", {} },
+    .{ "can", {} },     .{ "could", {} },   .{ "did", {} },     .{ "do", {} },
+    .{ "does", {} },    .{ "doing", {} },   .{ "down", {} },    .{ "during", {} },
+    .{ "each", {} },    .{ "few", {} },     .{ "for", {} },     .{ "from", {} },
+    .{ "further", {} }, .{ "get", {} },     .{ "got", {} },     .{ "had", {} },
+    .{ "has", {} },     .{ "have", {} },    .{ "he", {} },      .{ "her", {} },
+    .{ "here", {} },    .{ "him", {} },     .{ "his", {} },     .{ "how", {} },
+    .{ "i", {} },       .{ "if", {} },      .{ "in", {} },      .{ "into", {} },
+    .{ "is", {} },      .{ "it", {} },      .{ "its", {} },     .{ "just", {} },
+    .{ "may", {} },     .{ "me", {} },      .{ "might", {} },   .{ "more", {} },
+    .{ "most", {} },    .{ "must", {} },    .{ "my", {} },      .{ "no", {} },
+    .{ "nor", {} },     .{ "not", {} },     .{ "now", {} },     .{ "of", {} },
+    .{ "off", {} },     .{ "on", {} },      .{ "once", {} },    .{ "only", {} },
+    .{ "or", {} },      .{ "other", {} },   .{ "our", {} },     .{ "out", {} },
+    .{ "over", {} },    .{ "own", {} },     .{ "s", {} },       .{ "same", {} },
+    .{ "shall", {} },   .{ "she", {} },     .{ "should", {} },  .{ "so", {} },
+    .{ "some", {} },    .{ "such", {} },    .{ "t", {} },       .{ "than", {} },
+    .{ "that", {} },    .{ "the", {} },     .{ "their", {} },   .{ "them", {} },
+    .{ "then", {} },    .{ "there", {} },   .{ "these", {} },   .{ "they", {} },
+    .{ "this", {} },    .{ "those", {} },   .{ "through", {} }, .{ "to", {} },
+    .{ "too", {} },     .{ "under", {} },   .{ "until", {} },   .{ "up", {} },
+    .{ "us", {} },      .{ "very", {} },    .{ "was", {} },     .{ "we", {} },
+    .{ "were", {} },    .{ "what", {} },    .{ "when", {} },    .{ "where", {} },
+    .{ "which", {} },   .{ "while", {} },   .{ "who", {} },     .{ "whom", {} },
+    .{ "why", {} },     .{ "will", {} },    .{ "with", {} },    .{ "would", {} },
+    .{ "you", {} },     .{ "your", {} },
+});
+
+/// Longest stop word ("between", "through", "further")
+const MAX_STOP_LEN: usize = 7;
+
+// ============================================================================
+// Tokens
+// ============================================================================
+
+/// Only ASCII letters
+pub const TOK_ALPHA: u16 = 1 << 0;
+/// Only ASCII digits
+pub const TOK_NUMERIC: u16 = 1 << 1;
+/// At least one ASCII digit
+pub const TOK_HAS_DIGIT: u16 = 1 << 2;
+/// At least one byte >= 0x80
+pub const TOK_NON_ASCII: u16 = 1 << 3;
+/// First byte is an ASCII upper-case letter
+pub const TOK_CAPITALISED: u16 = 1 << 4;
+/// Alphabetic and in stop_word_map (case-insensitive)
+pub const TOK_STOP_WORD: u16 = 1 << 5;
+/// Followed by '.', '?' or '!' (optionally after one closing quote/bracket)
+pub const TOK_SENTENCE_END: u16 = 1 << 6;
+/// At the start of the text or preceded by whitespace
+pub const TOK_SPACE_BEFORE: u16 = 1 << 7;
+
+pub const Token = struct {
+    start: u32,
+    len: u32,
+    flags: u16,
+
+    pub fn end(self: Token) usize {
+        return @as(usize, self.start) + self.len;
+    }
+
+    pub fn has(self: Token, flag: u16) bool {
+        return self.flags & flag != 0;
+    }
+};
+
+/// Letter counts per script, by UTF-8 lead byte (ASCII letters are Latin).
+pub const ScriptCounts = struct {
+    latin: u64 = 0,
+    cjk: u64 = 0,
+    cyrillic: u64 = 0,
+    arabic: u64 = 0,
+    devanagari: u64 = 0,
+    /// Every counted letter, including scripts not listed above
+    total: u64 = 0,
+};
+
+/// Tokens and document totals of one text, from tokenize().
+pub const Tokens = struct {
+    text: []const u8,
+    items: []Token,
+    /// '.', '?' and '!' bytes
+    sentence_marks: u64 = 0,
+    /// Runs of ASCII vowels (a e i o u y) inside letters
+    syllables: u64 = 0,
+    scripts: ScriptCounts = .{},
+
+    pub fn deinit(self: *Tokens, allocator: std.mem.Allocator) void {
+        allocator.free(self.items);
+        self.* = undefined;
+    }
+
+    pub fn bytes(self: *const Tokens, t: Token) []const u8 {
+        return self.text[t.start..t.end()];
+    }
+
+    /// Byte just before the token, or 0 at the start of the text.
+    pub fn before(self: *const Tokens, t: Token) u8 {
+        return if (t.start > 0) self.text[t.start - 1] else 0;
+    }
+
+    /// Byte `offset` bytes after the token's last byte, or 0 past the end.
+    pub fn after(self: *const Tokens, t: Token, offset: usize) u8 {
+        const i = t.end() + offset;
+        return if (i < self.text.len) self.text[i] else 0;
+    }
+};
+
+// ============================================================================
+// Block Classification
+// ============================================================================
+
+const W = 64;
+const V = @Vector(W, u8);
+const Mask = u64;
+
+fn bits(v: @Vector(W, bool)) Mask {
+    return @bitCast(v);
+}
+
+fn inRange(v: V, comptime lo: u8, comptime hi: u8) Mask {
+    return bits(v >= @as(V, @splat(lo))) & bits(v <= @as(V, @splat(hi)));
+}
+
+fn eq(v: V, comptime byte: u8) Mask {
+    return bits(v == @as(V, @splat(byte)));
+}
+
+/// Bit masks for one 64-byte block (bit i = byte i).
+const Classes = struct {
+    letter: Mask,
+    digit: Mask,
+    high: Mask,
+    vowel: Mask,
+    sentence: Mask,
+    lead2: Mask,
+    lead3: Mask,
+    lead4: Mask,
+    cyrillic: Mask,
+    arabic: Mask,
+    cjk: Mask,
+    e0: Mask,
+
+    fn of(v: V) Classes {
+        const lower = v | @as(V, @splat(0x20));
+        const letter = inRange(lower, 'a', 'z');
+        return .{
+            .letter = letter,
+            .digit = inRange(v, '0', '9'),
+            .high = bits(v >= @as(V, @splat(0x80))),
+            .vowel = letter & (eq(lower, 'a') | eq(lower, 'e') | eq(lower, 'i') |
+                eq(lower, 'o') | eq(lower, 'u') | eq(lower, 'y')),
+            .sentence = eq(v, '.') | eq(v, '?') | eq(v, '!'),
+            .lead2 = inRange(v, 0xC0, 0xDF),
+            .lead3 = inRange(v, 0xE0, 0xEF),
+            .lead4 = bits(v >= @as(V, @splat(0xF0))),
+            .cyrillic = inRange(v, 0xD0, 0xD3),
+            .arabic = inRange(v, 0xD8, 0xDB),
+            .cjk = inRange(v, 0xE4, 0xE9),
+            .e0 = eq(v, 0xE0),
+        };
+    }
+
+    fn word(self: Classes) Mask {
+        return self.letter | self.digit | self.high;
+    }
+};
+
+/// Bits [lo, hi) set.
+fn rangeMask(lo: u7, hi: u7) Mask {
+    const upto_hi: Mask = if (hi == 64) ~@as(Mask, 0) else (@as(Mask, 1) << @intCast(hi)) - 1;
+    const below_lo: Mask = if (lo == 64) ~@as(Mask, 0) else (@as(Mask, 1) << @intCast(lo)) - 1;
+    return upto_hi & ~below_lo;
+}
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+/// Flags accumulated while a token spans one or more blocks.
+const Open = struct {
+    start: usize,
+    any_non_letter: bool = false,
+    any_non_digit: bool = false,
+    any_digit: bool = false,
+    any_high: bool = false,
+
+    fn add(self: *Open, cls: Classes, seg: Mask) void {
+        self.any_non_letter = self.any_non_letter or (seg & ~cls.letter) != 0;
+        self.any_non_digit = self.any_non_digit or (seg & ~cls.digit) != 0;
+        self.any_digit = self.any_digit or (seg & cls.digit) != 0;
+        self.any_high = self.any_high or (seg & cls.high) != 0;
+    }
+};
+
+fn isStop(word: []const u8) bool {
+    if (word.len > MAX_STOP_LEN) return false;
+    var lower: [MAX_STOP_LEN]u8 = undefined;
+    for (word, 0..) |ch, i| lower[i] = std.ascii.toLower(ch);
+    return stop_word_map.has(lower[0..word.len]);
+}
+
+fn closeToken(text: []const u8, open: Open, end: usize) Token {
+    const start = open.start;
+    var flags: u16 = 0;
+    if (!open.any_non_letter) flags |= TOK_ALPHA;
+    if (!open.any_non_digit) flags |= TOK_NUMERIC;
+    if (open.any_digit) flags |= TOK_HAS_DIGIT;
+    if (open.any_high) flags |= TOK_NON_ASCII;
+    if (std.ascii.isUpper(text[start])) flags |= TOK_CAPITALISED;
+    if (!open.any_non_letter and isStop(text[start..end])) flags |= TOK_STOP_WORD;
+    if (start == 0 or text[start - 1] <= ' ') flags |= TOK_SPACE_BEFORE;
+
+    var p = end;
+    if (p < text.len and (text[p] == '"' or text[p] == '\'' or text[p] == ')' or text[p] == ']')) p += 1;
+    if (p < text.len and (text[p] == '.' or text[p] == '?' or text[p] == '!')) flags |= TOK_SENTENCE_END;
+
+    return .{ .start = @intCast(start), .len = @intCast(end - start), .flags = flags };
+}
+
+/// Tokenise `text` in one pass. The caller frees with Tokens.deinit().
+pub fn tokenize(allocator: std.mem.Allocator, text_in: []const u8) !Tokens {
+    const text = text_in[0..@min(text_in.len, std.math.maxInt(u32))];
+    var list: std.ArrayList(Token) = .empty;
+    errdefer list.deinit(allocator);
+    // English averages ~6 bytes per token including the separator
+    try list.ensureTotalCapacity(allocator, text.len / 6 + 1);
+
+    var out = Tokens{ .text = text, .items = &.{} };
+    var open: ?Open = null;
+    var prev_word: Mask = 0; // bit 0: last byte of the previous block was a word byte
+    var prev_vowel: Mask = 0;
+
+    var base: usize = 0;
+    while (base < text.len) : (base += W) {
+        var block: [W]u8 = @splat(' ');
+        const n = @min(W, text.len - base);
+        @memcpy(block[0..n], text[base..][0..n]);
+        const cls = Classes.of(block);
+
+        // Document totals
+        out.sentence_marks += @popCount(cls.sentence);
+        out.syllables += @popCount(cls.vowel & ~((cls.vowel << 1) | prev_vowel));
+        const other2 = cls.lead2 & ~cls.cyrillic & ~cls.arabic;
+        var devanagari: u64 = 0;
+        var e0 = cls.e0;
+        while (e0 != 0) : (e0 &= e0 - 1) {
+            const i = base + @ctz(e0);
+            if (i + 1 < text.len and text[i + 1] >= 0xA4 and text[i + 1] <= 0xA7) devanagari += 1;
+        }
+        out.scripts.latin += @popCount(cls.letter) + @popCount(other2);
+        out.scripts.cyrillic += @popCount(cls.cyrillic);
+        out.scripts.arabic += @popCount(cls.arabic);
+        out.scripts.cjk += @popCount(cls.cjk);
+        out.scripts.devanagari += devanagari;
+        out.scripts.total += @popCount(cls.letter) + @popCount(cls.lead2) +
+            @popCount(cls.lead3) + @popCount(cls.lead4);
+
+        // Token edges: a start is a word byte after a non-word byte, an
+        // end the first non-word byte after a word byte
+        const word = cls.word();
+        const shifted = (word << 1) | prev_word;
+        var edges = (word & ~shifted) | (~word & shifted);
+        var seg_lo: u7 = 0;
+        while (edges != 0) : (edges &= edges - 1) {
+            const bit: u7 = @intCast(@ctz(edges));
+            if (open) |*o| {
+                o.add(cls, rangeMask(seg_lo, bit));
+                try list.append(allocator, closeToken(text, o.*, base + bit));
+                open = null;
+            } else {
+                open = .{ .start = base + bit };
+                seg_lo = bit;
+            }
+        }
+        if (open) |*o| {
+            o.add(cls, rangeMask(seg_lo, W));
+        }
+
+        prev_word = word >> (W - 1);
+        prev_vowel = cls.vowel >> (W - 1);
+    }
+    // The padding after the last byte is whitespace, so every token closed
+    std.debug.assert(open == null or text.len % W == 0);
+    if (open) |o| try list.append(allocator, closeToken(text, o, text.len));
+
+    out.items = try list.toOwnedSlice(allocator);
+    return out;
+}
+
+/// Whitespace-delimited word count (' ', '\n', '\r', '\t'), vectorised.
+pub fn countWords(text: []const u8) i64 {
+    var count: i64 = 0;
+    var prev_word: Mask = 0;
+    var base: usize = 0;
+    while (base < text.len) : (base += W) {
+        var block: [W]u8 = @splat(' ');
+        const n = @min(W, text.len - base);
+        @memcpy(block[0..n], text[base..][0..n]);
+        const v: V = block;
+        const word = ~(eq(v, ' ') | eq(v, '\n') | eq(v, '\r') | eq(v, '\t'));
+        count += @popCount(word & ~((word << 1) | prev_word));
+        prev_word = word >> (W - 1);
+    }
+    return count;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+test "tokens, flags and edges across blocks" {
+    const text = "The cat sat. " ** 4 ++ "Incomprehensibly Zero 10.1234/x (1999) caf\xc3\xa9 end";
+    var toks = try tokenize(std.testing.allocator, text);
+    defer toks.deinit(std.testing.allocator);
+
+    try std.testing.expectEqual(@as(usize, 12 + 8), toks.items.len);
+    const first = toks.items[0];
+    try std.testing.expectEqualStrings("The", toks.bytes(first));
+    try std.testing.expect(first.has(TOK_CAPITALISED) and first.has(TOK_STOP_WORD) and first.has(TOK_SPACE_BEFORE));
+    try std.testing.expect(toks.items[2].has(TOK_SENTENCE_END));
+    try std.testing.expect(!toks.items[1].has(TOK_STOP_WORD));
+
+    // Bytes 52..68 straddle the first 64-byte block boundary
+    const long = toks.items[12];
+    try std.testing.expectEqualStrings("Incomprehensibly", toks.bytes(long));
+    try std.testing.expect(long.has(TOK_ALPHA) and long.has(TOK_CAPITALISED));
+
+    try std.testing.expect(toks.items[14].has(TOK_NUMERIC));
+    try std.testing.expectEqual(@as(u8, '.'), toks.after(toks.items[14], 0));
+    try std.testing.expectEqual(@as(u8, '('), toks.before(toks.items[17]));
+    try std.testing.expect(toks.items[18].has(TOK_NON_ASCII) and !toks.items[18].has(TOK_ALPHA));
+    try std.testing.expectEqualStrings("end", toks.bytes(toks.items[19]));
+    try std.testing.expectEqual(@as(u64, 4 + 1), toks.sentence_marks);
+}
+
+test "token at the very end of a full block" {
+    const text = "x" ** 64;
+    var toks = try tokenize(std.testing.allocator, text);
+    defer toks.deinit(std.testing.allocator);
+    try std.testing.expectEqual(@as(usize, 1), toks.items.len);
+    try std.testing.expectEqual(@as(u32, 64), toks.items[0].len);
+}
+
+test "vectorised word count matches the scalar definition" {
+    try std.testing.expectEqual(@as(i64, 0), countWords(""));
+    try std.testing.expectEqual(@as(i64, 3), countWords("  one\ttwo\r\nthree "));
+    try std.testing.expectEqual(@as(i64, 40), countWords("word, " ** 40));
+}
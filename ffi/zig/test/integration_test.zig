@@ -20,12 +20,43 @@ extern fn ddac_init() ?*anyopaque;
 extern fn ddac_free(?*anyopaque) void;
 extern fn ddac_version() [*:0]const u8;
 
+// ============================================================================
+// Batched Parse (C ABI)
+// ============================================================================
+
+extern fn ddac_parse_batch(?*anyopaque, ?[*]const ?[*:0]const u8, ?[*]const ?[*:0]const u8, u32, u64, ?*anyopaque) u32;
+extern fn ddac_parse_columns(?*const anyopaque, u32, ?*const ParseColumns) void;
+
+const ParseColumns = extern struct {
+    status: ?[*]i32,
+    content_kind: ?[*]i32,
+    page_count: ?[*]i32,
+    word_count: ?[*]i64,
+    char_count: ?[*]i64,
+    duration_sec: ?[*]f64,
+    parse_time_ms: ?[*]f64,
+    sha256: ?[*][65]u8,
+};
+
 // ============================================================================
 // Handle Setters (C ABI)
 // ============================================================================
 
 extern fn ddac_set_ml_handle(?*anyopaque, ?*anyopaque) void;
 extern fn ddac_set_gpu_ocr_handle(?*anyopaque, ?*anyopaque) void;
+extern fn ddac_set_stages_packed(?*anyopaque, c_int) void;
+
+// ============================================================================
+// Handle Pool (C ABI)
+// ============================================================================
+
+extern fn ddac_pool_create(u32) ?*anyopaque;
+extern fn ddac_pool_free(?*anyopaque) void;
+extern fn ddac_pool_acquire(?*anyopaque) ?*anyopaque;
+extern fn ddac_pool_release(?*anyopaque, ?*anyopaque) void;
+extern fn ddac_pool_bind(?*anyopaque, ?*anyopaque, ?*anyopaque) void;
+extern fn ddac_pool_size(?*anyopaque) u32;
+extern fn ddac_pool_set_stages_packed(?*anyopaque, c_int) void;
 
 // ============================================================================
 // LMDB Cache (C ABI)
@@ -37,6 +68,11 @@ extern fn ddac_cache_count(?*anyopaque) u64;
 extern fn ddac_cache_sync(?*anyopaque) void;
 extern fn ddac_cache_lookup(?*anyopaque, [*:0]const u8, i64, i64, ?*anyopaque, usize) c_int;
 extern fn ddac_cache_store(?*anyopaque, [*:0]const u8, i64, i64, ?*const anyopaque, usize) void;
+extern fn ddac_cache_init_ex([*:0]const u8, u64, u32) ?*anyopaque;
+extern fn ddac_cache_lookup_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?*anyopaque, usize, ?[*]u64, [*]u8, u32) u32;
+extern fn ddac_cache_store_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?*const anyopaque, usize, ?[*]const u64, ?[*]const u8, u32) u32;
+extern fn ddac_cache_lookup_content_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?[*]const ?[*:0]const u8, ?[*]const ?[*:0]const u8, ?*anyopaque, usize, [*]u8, [*]u8, u32) u32;
+extern fn ddac_cache_store_content_batch(?*anyopaque, [*]const ?[*:0]const u8, [*]const i64, [*]const i64, ?[*]const ?[*:0]const u8, ?[*]const ?[*:0]const u8, ?*const anyopaque, usize, ?[*]const u8, u32) u32;
 
 // ============================================================================
 // I/O Prefetcher (C ABI)
@@ -47,6 +83,8 @@ extern fn ddac_prefetch_hint(?*anyopaque, [*:0]const u8) void;
 extern fn ddac_prefetch_done(?*anyopaque, [*:0]const u8) void;
 extern fn ddac_prefetch_free(?*anyopaque) void;
 extern fn ddac_prefetch_inflight(?*anyopaque) u32;
+extern fn ddac_prefetch_init_ex(u32, u64) ?*anyopaque;
+extern fn ddac_prefetch_submit(?*anyopaque, [*]const ?[*:0]const u8, u32) void;
 
 // ============================================================================
 // Hardware Crypto (C ABI)
@@ -61,12 +99,14 @@ const CryptoCaps = extern struct {
     has_aes_ni: u8,
     _pad: [2]u8,
     sha256_tier: u8,
-    _pad2: [7]u8,
+    sha256_lanes: u8,
+    _pad2: [6]u8,
 };
 
 extern fn ddac_crypto_detect(*CryptoCaps) void;
 extern fn ddac_crypto_sha256_tier() u8;
 extern fn ddac_crypto_sha256_name() [*:0]const u8;
+extern fn ddac_crypto_batch_sha256([*]const [*:0]const u8, [*][65]u8, u32) u32;
 extern fn ddac_crypto_caps_size() usize;
 
 // ============================================================================
@@ -79,6 +119,9 @@ extern fn ddac_ml_available(?*anyopaque) u8;
 extern fn ddac_ml_provider(?*anyopaque) u8;
 extern fn ddac_ml_provider_name(?*anyopaque) [*:0]const u8;
 extern fn ddac_ml_set_model_dir(?*anyopaque, [*:0]const u8) void;
+extern fn ddac_ml_run_stage(?*anyopaque, u8, [*:0]const u8, *[48]u8) c_int;
+extern fn ddac_ml_set_batch_policy(?*anyopaque, u8, u32, u32) void;
+extern fn ddac_ml_queue_stats(?*anyopaque, u8, *u64, *u64, *u64, *u64, *u32) void;
 extern fn ddac_ml_result_size() usize;
 extern fn ddac_ml_stage_count() u8;
 extern fn ddac_ml_model_name(u8) [*:0]const u8;
@@ -90,6 +133,12 @@ extern fn ddac_ml_model_name(u8) [*:0]const u8;
 extern fn ddac_gpu_ocr_init() ?*anyopaque;
 extern fn ddac_gpu_ocr_free(?*anyopaque) void;
 extern fn ddac_gpu_ocr_backend(?*anyopaque) u8;
+extern fn ddac_gpu_ocr_set_model_dir(?*anyopaque, [*:0]const u8) void;
+extern fn ddac_gpu_ocr_submit(?*anyopaque, [*:0]const u8, ?[*:0]const u8) c_int;
+extern fn ddac_gpu_ocr_flush(?*anyopaque) void;
+extern fn ddac_gpu_ocr_collect(?*anyopaque, u32, ?*anyopaque) c_int;
+extern fn ddac_gpu_ocr_release(?*anyopaque, c_int) void;
+extern fn ddac_set_gpu_ocr_ticket(?*anyopaque, c_int) void;
 extern fn ddac_gpu_ocr_max_batch() u32;
 extern fn ddac_gpu_ocr_result_size() usize;
 
@@ -99,6 +148,12 @@ extern fn ddac_gpu_ocr_result_size() usize;
 
 extern fn ddac_conduit_result_size() usize;
 extern fn ddac_conduit_process([*:0]const u8, ?*anyopaque) c_int;
+extern fn ddac_conduit_map([*:0]const u8, ?*anyopaque) ?*anyopaque;
+extern fn ddac_conduit_unmap(?*anyopaque) void;
+extern fn ddac_conduit_batch([*]const ?[*:0]const u8, ?*anyopaque, u32) u32;
+extern fn ddac_conduit_batch_start(?*anyopaque, [*]const ?[*:0]const u8, ?*anyopaque, u32) ?*anyopaque;
+extern fn ddac_conduit_batch_wait(?*anyopaque) u32;
+extern fn ddac_resolve_kind(u8, ?[*:0]const u8) c_int;
 
 // ============================================================================
 // Dragonfly / Redis (C ABI)
@@ -106,6 +161,119 @@ extern fn ddac_conduit_process([*:0]const u8, ?*anyopaque) c_int;
 
 extern fn ddac_dragonfly_connect([*:0]const u8) ?*anyopaque;
 extern fn ddac_dragonfly_close(?*anyopaque) void;
+extern fn ddac_dragonfly_pool_create([*:0]const u8, u32) ?*anyopaque;
+extern fn ddac_dragonfly_pool_free(?*anyopaque) void;
+extern fn ddac_dragonfly_lookup_batch(?*anyopaque, ?[*]const ?[*:0]const u8, ?[*]u8, usize, ?[*]u8, u32) u32;
+extern fn ddac_dragonfly_store_batch(?*anyopaque, ?[*]const ?[*:0]const u8, ?[*]const u8, usize, ?[*]const u8, u32, u32) u32;
+
+// ============================================================================
+// Checkpoint Bitmaps + Journal (C ABI)
+// ============================================================================
+
+extern fn ddac_ckpt_open([*:0]const u8, [*:0]const u8, u64, u8, u32) ?*anyopaque;
+extern fn ddac_ckpt_mark(?*anyopaque, u64) i32;
+extern fn ddac_ckpt_merge(?*anyopaque, [*:0]const u8, [*:0]const u8) i32;
+extern fn ddac_ckpt_test(?*anyopaque, u64) u8;
+extern fn ddac_ckpt_resume_count(?*anyopaque) u64;
+extern fn ddac_ckpt_sync(?*anyopaque) i32;
+extern fn ddac_ckpt_close(?*anyopaque) i32;
+
+// ============================================================================
+// Streaming NDJSON Writer (C ABI)
+// ============================================================================
+
+extern fn ddac_ndjson_open([*:0]const u8, u32, u8) ?*anyopaque;
+extern fn ddac_ndjson_task_buffer(?*anyopaque) ?*anyopaque;
+extern fn ddac_ndjson_append(?*anyopaque, [*:0]const u8, *const anyopaque, f64) i32;
+extern fn ddac_ndjson_task_release(?*anyopaque) void;
+extern fn ddac_ndjson_close(?*anyopaque) i64;
+
+// ============================================================================
+// Results Container (C ABI)
+// ============================================================================
+
+extern fn ddac_container_open([*:0]const u8, u32, u8) ?*anyopaque;
+extern fn ddac_container_put_result(?*anyopaque, u64, *const anyopaque, usize) i32;
+extern fn ddac_container_stats(?*anyopaque, *u64, *u64, *u64, *u32) void;
+extern fn ddac_container_close(?*anyopaque) i32;
+extern fn ddac_container_merge([*:0]const u8, [*]const [*:0]const u8, u32) i64;
+
+// ============================================================================
+// Parallel Manifest Scanner (C ABI)
+// ============================================================================
+
+const ManifestEntry = extern struct {
+    path: ?[*]const u8,
+    path_len: u32,
+    kind_len: u32,
+    kind: ?[*]const u8,
+    size: i64,
+    mtime: i64,
+};
+
+extern fn ddac_manifest_open([*:0]const u8) ?*anyopaque;
+extern fn ddac_manifest_bytes(?*anyopaque) u64;
+extern fn ddac_manifest_count(?*anyopaque, u64, u64) u64;
+extern fn ddac_manifest_next(?*anyopaque, *u64, u64, u8, *ManifestEntry) i32;
+extern fn ddac_manifest_close(?*anyopaque) void;
+
+// ============================================================================
+// Isolated Parse Workers (C ABI)
+// ============================================================================
+
+extern fn ddac_isolate_create([*:0]const u8, u32) ?*anyopaque;
+extern fn ddac_isolate_parse(?*anyopaque, ?[*:0]const u8, ?[*:0]const u8, c_int, u64, ?*const anyopaque, ?*const anyopaque, u32, *anyopaque) i32;
+extern fn ddac_isolate_stats(?*anyopaque, *u64, *u64, *u64) void;
+extern fn ddac_isolate_free(?*anyopaque) void;
+extern fn ddac_metrics_layout(*u32, *u32) void;
+extern fn ddac_metrics_phase_name(u32) [*:0]const u8;
+extern fn ddac_metrics_snapshot([*]u64, usize) usize;
+extern fn ddac_metrics_quantile([*]const u64, u32, f64) f64;
+extern fn ddac_metrics_reset() void;
+
+// ============================================================================
+// Page-Range PDF Parsing (C ABI)
+// ============================================================================
+
+const PagePart = extern struct {
+    status: c_int,
+    first: i32,
+    last: i32,
+    _pad: u32,
+    word_count: i64,
+    char_count: i64,
+    parse_time_ms: f64,
+    ocr_pages: u32,
+    ocr_conf_sum: u32,
+    ocr_words: u64,
+    ocr_chars: u64,
+};
+
+extern fn ddac_pdf_page_count(?[*:0]const u8, ?*const anyopaque) i32;
+extern fn ddac_parse_pages(?*anyopaque, ?[*:0]const u8, ?[*:0]const u8, i32, i32, u64, ?*const anyopaque, ?*PagePart) c_int;
+
+// ============================================================================
+// Near-Duplicate Index (C ABI)
+// ============================================================================
+
+extern fn ddac_neardup_create() ?*anyopaque;
+extern fn ddac_neardup_open(?[*:0]const u8) ?*anyopaque;
+extern fn ddac_neardup_insert(?*anyopaque, u64, u64) i32;
+extern fn ddac_neardup_query(?*anyopaque, u64, u8, ?[*]u64, ?[*]u8, u32) i32;
+extern fn ddac_neardup_count(?*anyopaque) u64;
+extern fn ddac_neardup_save(?*anyopaque, ?[*:0]const u8) i32;
+extern fn ddac_neardup_shards(u64, u8, u32, ?[*]u32) u32;
+extern fn ddac_neardup_check_batch(?*anyopaque, ?[*]const u64, ?[*]const u64, u32, u8, ?[*]u64, ?[*]u8) i32;
+extern fn ddac_neardup_insert_batch(?*anyopaque, ?[*]const u64, ?[*]const u64, u32) i32;
+extern fn ddac_image_ahash(?[*:0]const u8, ?*const anyopaque, ?*u64) i32;
+extern fn ddac_neardup_free(?*anyopaque) void;
+
+// ============================================================================
+// Stage Re-extraction (C ABI)
+// ============================================================================
+
+extern fn ddac_reextract_plan(u64, u64) u64;
+extern fn ddac_reextract_stages(?*anyopaque, ?[*:0]const u8, ?[*:0]const u8, u64, ?*anyopaque, ?*u64) c_int;
 
 // ============================================================================
 // Tests — Core Lifecycle
@@ -175,6 +343,56 @@ test "set GPU OCR handle with null OCR handle is safe" {
     ddac_set_gpu_ocr_handle(handle, null);
 }
 
+// ============================================================================
+// Tests — Handle Pool
+// ============================================================================
+
+test "pool create warms requested handles" {
+    const pool = ddac_pool_create(2) orelse return error.InitFailed;
+    defer ddac_pool_free(pool);
+    try testing.expectEqual(@as(u32, 2), ddac_pool_size(pool));
+}
+
+test "pool acquire returns distinct handles and reuses released ones" {
+    const pool = ddac_pool_create(2) orelse return error.InitFailed;
+    defer ddac_pool_free(pool);
+
+    const h1 = ddac_pool_acquire(pool) orelse return error.AcquireFailed;
+    const h2 = ddac_pool_acquire(pool) orelse return error.AcquireFailed;
+    try testing.expect(h1 != h2);
+
+    ddac_pool_release(pool, h2);
+    const h3 = ddac_pool_acquire(pool) orelse return error.AcquireFailed;
+    try testing.expect(h3 == h2);
+
+    ddac_pool_release(pool, h1);
+    ddac_pool_release(pool, h3);
+    try testing.expectEqual(@as(u32, 2), ddac_pool_size(pool));
+}
+
+test "pool grows when exhausted" {
+    const pool = ddac_pool_create(1) orelse return error.InitFailed;
+    defer ddac_pool_free(pool);
+
+    const h1 = ddac_pool_acquire(pool) orelse return error.AcquireFailed;
+    const h2 = ddac_pool_acquire(pool) orelse return error.AcquireFailed;
+    try testing.expect(h1 != h2);
+    try testing.expectEqual(@as(u32, 2), ddac_pool_size(pool));
+
+    ddac_pool_release(pool, h1);
+    ddac_pool_release(pool, h2);
+}
+
+test "pool null handling is safe" {
+    ddac_pool_free(null);
+    ddac_pool_release(null, null);
+    ddac_pool_bind(null, null, null);
+    ddac_pool_set_stages_packed(null, 1);
+    ddac_set_stages_packed(null, 1);
+    try testing.expect(ddac_pool_acquire(null) == null);
+    try testing.expectEqual(@as(u32, 0), ddac_pool_size(null));
+}
+
 // ============================================================================
 // Tests — Hardware Crypto
 // ============================================================================
@@ -215,6 +433,48 @@ test "crypto capabilities are boolean flags" {
     try testing.expect(caps.has_aes_ni <= 1);
 }
 
+test "crypto sha256 lanes match tier" {
+    var caps: CryptoCaps = std.mem.zeroes(CryptoCaps);
+    ddac_crypto_detect(&caps);
+    if (caps.sha256_tier == 1) {
+        try testing.expect(caps.sha256_lanes == 8 or caps.sha256_lanes == 16);
+    } else {
+        try testing.expectEqual(@as(u8, 1), caps.sha256_lanes);
+    }
+}
+
+test "crypto batch sha256 matches std sha256" {
+    var dir_buf: [256]u8 = undefined;
+    const dir = std.fmt.bufPrint(&dir_buf, "/tmp/ddac-test-crypto-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    // Mixed small files (hashed in lanes), one large file (streamed),
+    // an empty file and a missing one
+    var data: [200 * 1024]u8 = undefined;
+    for (&data, 0..) |*b, i| b.* = @truncate(i *% 13);
+    const sizes = [_]usize{ 5, 0, 4096, 65536, 100, 200 * 1024, 63, 19 * 1024, 1 };
+    var name_bufs: [sizes.len + 1][256]u8 = undefined;
+    var paths: [sizes.len + 1][*:0]const u8 = undefined;
+    for (sizes, 0..) |len, i| {
+        const p = std.fmt.bufPrintZ(&name_bufs[i], "{s}/f{d}.bin", .{ dir, i }) catch return;
+        const f = try std.fs.createFileAbsoluteZ(p, .{});
+        defer f.close();
+        try f.writeAll(data[0..len]);
+        paths[i] = p;
+    }
+    paths[sizes.len] = "/nonexistent/file.bin";
+
+    var hex: [sizes.len + 1][65]u8 = undefined;
+    try testing.expectEqual(@as(u32, sizes.len), ddac_crypto_batch_sha256(&paths, &hex, paths.len));
+    for (sizes, 0..) |len, i| {
+        var digest: [32]u8 = undefined;
+        std.crypto.hash.sha2.Sha256.hash(data[0..len], &digest, .{});
+        const want = std.fmt.bytesToHex(digest, .lower);
+        try testing.expectEqualSlices(u8, &want, hex[i][0..64]);
+    }
+}
+
 // ============================================================================
 // Tests — I/O Prefetcher
 // ============================================================================
@@ -240,6 +500,26 @@ test "prefetch hint and done with nonexistent file is safe" {
     ddac_prefetch_done(handle, "/nonexistent/file.pdf");
 }
 
+test "prefetch submit from concurrent tasks is safe" {
+    const handle = ddac_prefetch_init_ex(16, 1) orelse return;
+    defer ddac_prefetch_free(handle);
+
+    const Task = struct {
+        fn run(h: *anyopaque) void {
+            const paths = [_]?[*:0]const u8{ "/proc/self/status", null, "/nonexistent/file.pdf" };
+            for (0..100) |_| {
+                ddac_prefetch_submit(h, &paths, paths.len);
+                ddac_prefetch_done(h, "/proc/self/status");
+            }
+        }
+    };
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*t| t.* = try std.Thread.spawn(.{}, Task.run, .{handle});
+    for (threads) |t| t.join();
+    ddac_prefetch_submit(null, &[_]?[*:0]const u8{null}, 1);
+    try testing.expect(ddac_prefetch_inflight(handle) <= 16);
+}
+
 // ============================================================================
 // Tests — LMDB Cache
 // ============================================================================
@@ -285,6 +565,92 @@ test "cache lookup on empty cache returns miss" {
     try testing.expectEqual(@as(c_int, 0), hit);
 }
 
+test "cache batch store then batch lookup round-trips in one txn each" {
+    var buf: [256]u8 = undefined;
+    const tmpdir = std.fmt.bufPrintZ(&buf, "/tmp/ddac-test-batch-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(std.mem.span(tmpdir)) catch return;
+    defer std.fs.deleteTreeAbsolute(std.mem.span(tmpdir)) catch {};
+
+    const handle = ddac_cache_init_ex(tmpdir, 64, 0x1) orelse return; // NOSYNC
+    defer ddac_cache_free(handle);
+
+    const paths = [_]?[*:0]const u8{ "/a.pdf", "/b.pdf", "/c.pdf", null };
+    const mtimes = [_]i64{ 10, 20, 30, 40 };
+    const sizes = [_]i64{ 100, 200, 300, 400 };
+    // ddac_parse_result_t: word_count at offset 16, title at 376
+    var results = std.mem.zeroes([4][952]u8);
+    for (&results, 0..) |*r, i| {
+        std.mem.writeInt(i64, r[16..24], @intCast(1000 * (i + 1)), .little);
+        @memcpy(r[376..][0..7], "Doc #00");
+        r[382] = '0' + @as(u8, @intCast(i));
+    }
+
+    // Store only entries 0 and 2 (mask 0b0101), each with its stages mask
+    const mask = [_]u8{0x05};
+    const stage_masks = [_]u64{ 0x7, 0x0, (1 << 14) | 0x1, 0x0 };
+    const stored = ddac_cache_store_batch(handle, &paths, &mtimes, &sizes, @ptrCast(&results), 952, &stage_masks, &mask, 4);
+    try testing.expectEqual(@as(u32, 2), stored);
+    ddac_cache_sync(handle);
+
+    var out: [4][952]u8 = std.mem.zeroes([4][952]u8);
+    var masks_out = [_]u64{ 0, 0, 0, 0 };
+    var hits: [1]u8 = .{0xFF};
+    const n_hit = ddac_cache_lookup_batch(handle, &paths, &mtimes, &sizes, @ptrCast(&out), 952, &masks_out, &hits, 4);
+    try testing.expectEqual(@as(u32, 2), n_hit);
+    try testing.expectEqual(@as(u8, 0x05), hits[0]);
+    try testing.expectEqualSlices(u8, &results[0], &out[0]);
+    try testing.expectEqualSlices(u8, &results[2], &out[2]);
+    try testing.expectEqual(@as(u8, 0), out[1][16]);
+    try testing.expectEqual(@as(u64, 0x7), masks_out[0]);
+    try testing.expectEqual(@as(u64, (1 << 14) | 0x1), masks_out[2]);
+
+    // Changed mtime invalidates the entry
+    const stale_mtimes = [_]i64{ 11, 20, 30, 40 };
+    const n_stale = ddac_cache_lookup_batch(handle, &paths, &stale_mtimes, &sizes, @ptrCast(&out), 952, null, &hits, 4);
+    try testing.expectEqual(@as(u32, 1), n_stale);
+    try testing.expectEqual(@as(u8, 0x04), hits[0]);
+}
+
+test "content-addressed cache hits a moved file by sha256" {
+    var buf: [256]u8 = undefined;
+    const tmpdir = std.fmt.bufPrintZ(&buf, "/tmp/ddac-test-cas-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(std.mem.span(tmpdir)) catch return;
+    defer std.fs.deleteTreeAbsolute(std.mem.span(tmpdir)) catch {};
+
+    const handle = ddac_cache_init_ex(tmpdir, 64, 0x4 | 0x1) orelse return; // CONTENT | NOSYNC
+    defer ddac_cache_free(handle);
+
+    const sha: [*:0]const u8 = "ab" ** 32;
+    const shas = [_]?[*:0]const u8{sha};
+    const mtimes = [_]i64{10};
+    const sizes = [_]i64{100};
+    // ddac_parse_result_t: sha256 at offset 48, author at 632
+    var result = std.mem.zeroes([952]u8);
+    @memcpy(result[48..][0..64], std.mem.span(sha));
+    @memcpy(result[632..][0..9], "A. Writer");
+
+    const old_path = [_]?[*:0]const u8{"/mnt/old/scan.pdf"};
+    try testing.expectEqual(@as(u32, 1), ddac_cache_store_content_batch(handle, &old_path, &mtimes, &sizes, &shas, null, @ptrCast(&result), 952, null, 1));
+
+    // Same bytes at a new mount point: a content hit that asks for a re-index
+    const new_path = [_]?[*:0]const u8{"/mnt/new/scan.pdf"};
+    var out: [952]u8 = std.mem.zeroes([952]u8);
+    var hits = [_]u8{0};
+    var moved = [_]u8{0};
+    try testing.expectEqual(@as(u32, 1), ddac_cache_lookup_content_batch(handle, &new_path, &mtimes, &sizes, &shas, null, @ptrCast(&out), 952, &hits, &moved, 1));
+    try testing.expectEqual(@as(u8, 0x01), hits[0]);
+    try testing.expectEqual(@as(u8, 0x01), moved[0]);
+    try testing.expectEqualSlices(u8, &result, &out);
+
+    // After the index update the new path hits without the sha
+    try testing.expectEqual(@as(u32, 1), ddac_cache_store_content_batch(handle, &new_path, &mtimes, &sizes, &shas, null, @ptrCast(&out), 952, null, 1));
+    try testing.expectEqual(@as(u32, 1), ddac_cache_lookup_content_batch(handle, &new_path, &mtimes, &sizes, null, null, @ptrCast(&out), 952, &hits, &moved, 1));
+    try testing.expectEqual(@as(u8, 0x00), moved[0]);
+
+    // One document, two paths
+    try testing.expectEqual(@as(u64, 1), ddac_cache_count(handle));
+}
+
 // ============================================================================
 // Tests — ML Inference Engine
 // ============================================================================
@@ -335,6 +701,68 @@ test "ML set model dir with null handle is safe" {
     ddac_ml_set_model_dir(null, "/nonexistent");
 }
 
+test "ML batch policy is clamped and reported" {
+    const handle = ddac_ml_init() orelse return;
+    defer ddac_ml_free(handle);
+
+    var batches: u64 = 1;
+    var items: u64 = 1;
+    var wait_sum: u64 = 1;
+    var wait_max: u64 = 1;
+    var max_batch: u32 = 0;
+
+    ddac_ml_set_batch_policy(handle, 0, 1000, 500);
+    ddac_ml_queue_stats(handle, 0, &batches, &items, &wait_sum, &wait_max, &max_batch);
+    try testing.expectEqual(@as(u32, 64), max_batch);
+    try testing.expectEqual(@as(u64, 0), batches);
+
+    ddac_ml_set_batch_policy(handle, 0, 0, 500);
+    ddac_ml_queue_stats(handle, 0, &batches, &items, &wait_sum, &wait_max, &max_batch);
+    try testing.expectEqual(@as(u32, 1), max_batch);
+
+    // Unknown stage / null handle: ignored, stats zeroed
+    ddac_ml_set_batch_policy(handle, 99, 8, 500);
+    ddac_ml_set_batch_policy(null, 0, 8, 500);
+    ddac_ml_queue_stats(handle, 99, &batches, &items, &wait_sum, &wait_max, &max_batch);
+    try testing.expectEqual(@as(u32, 0), max_batch);
+}
+
+test "ML concurrent requests share batches" {
+    const handle = ddac_ml_init() orelse return;
+    defer ddac_ml_free(handle);
+    ddac_ml_set_model_dir(handle, "/nonexistent");
+    ddac_ml_set_batch_policy(handle, 0, 4, 200_000);
+
+    const Worker = struct {
+        fn run(h: *anyopaque, status: *u8) void {
+            var out: [48]u8 align(8) = undefined;
+            _ = ddac_ml_run_stage(h, 0, "/nonexistent.txt", &out);
+            status.* = out[0];
+        }
+    };
+    var statuses = [_]u8{0xFF} ** 8;
+    var threads: [8]std.Thread = undefined;
+    for (&threads, &statuses) |*t, *st| t.* = try std.Thread.spawn(.{}, Worker.run, .{ handle, st });
+    for (threads) |t| t.join();
+
+    var batches: u64 = 0;
+    var items: u64 = 0;
+    var wait_sum: u64 = 0;
+    var wait_max: u64 = 0;
+    var max_batch: u32 = 0;
+    ddac_ml_queue_stats(handle, 0, &batches, &items, &wait_sum, &wait_max, &max_batch);
+
+    if (ddac_ml_available(handle) == 0) {
+        // No ONNX Runtime: requests fail fast without queueing
+        for (statuses) |st| try testing.expectEqual(@as(u8, 4), st);
+        try testing.expectEqual(@as(u64, 0), items);
+    } else {
+        for (statuses) |st| try testing.expectEqual(@as(u8, 1), st); // model_not_found
+        try testing.expectEqual(@as(u64, 8), items);
+        try testing.expect(batches >= 2 and batches <= 8);
+    }
+}
+
 // ============================================================================
 // Tests — GPU OCR
 // ============================================================================
@@ -353,6 +781,35 @@ test "GPU OCR free null is safe" {
     ddac_gpu_ocr_free(null);
 }
 
+test "GPU OCR cpu_only backend refuses submits" {
+    const handle = ddac_gpu_ocr_init() orelse return;
+    defer ddac_gpu_ocr_free(handle);
+    if (ddac_gpu_ocr_backend(handle) != 2) return; // a GPU is present
+
+    try testing.expectEqual(@as(c_int, -1), ddac_gpu_ocr_submit(handle, "/nonexistent.png", null));
+    ddac_gpu_ocr_flush(handle);
+}
+
+test "GPU OCR unknown tickets are rejected safely" {
+    const handle = ddac_gpu_ocr_init() orelse return;
+    defer ddac_gpu_ocr_free(handle);
+    ddac_gpu_ocr_set_model_dir(handle, "/nonexistent");
+
+    var out: [48]u8 align(8) = undefined;
+    try testing.expectEqual(@as(c_int, -1), ddac_gpu_ocr_collect(handle, 12345, &out));
+    ddac_gpu_ocr_release(handle, 12345);
+    ddac_gpu_ocr_release(handle, -1);
+    ddac_gpu_ocr_release(null, 0);
+}
+
+test "set GPU OCR ticket without a GPU handle is safe" {
+    ddac_set_gpu_ocr_ticket(null, 0);
+    const handle = ddac_init() orelse return;
+    defer ddac_free(handle);
+    ddac_set_gpu_ocr_ticket(handle, 7); // no GPU handle: released as a no-op
+    ddac_set_gpu_ocr_ticket(handle, -1);
+}
+
 test "GPU OCR max batch is positive" {
     const max = ddac_gpu_ocr_max_batch();
     try testing.expect(max > 0);
@@ -396,6 +853,106 @@ test "conduit process empty file returns empty validation" {
     try testing.expectEqual(@as(u8, 2), result_buf[1]);
 }
 
+test "conduit map nonexistent file returns null" {
+    var result_buf: [88]u8 align(8) = std.mem.zeroes([88]u8);
+    const mapping = ddac_conduit_map("/nonexistent/file.pdf", @ptrCast(&result_buf));
+    try testing.expect(mapping == null);
+    try testing.expectEqual(@as(u8, 1), result_buf[1]);
+}
+
+test "conduit map matches conduit process" {
+    var path_buf: [256]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-map-{d}.pdf", .{std.time.milliTimestamp()}) catch return;
+    const file = std.fs.createFileAbsoluteZ(path, .{}) catch return;
+    file.writeAll("%PDF-1.4\nnot really a pdf\n") catch {};
+    file.close();
+    defer std.fs.deleteFileAbsolute(std.mem.span(path)) catch {};
+
+    var processed: [88]u8 align(8) = std.mem.zeroes([88]u8);
+    try testing.expectEqual(@as(c_int, 0), ddac_conduit_process(path, @ptrCast(&processed)));
+
+    var mapped: [88]u8 align(8) = std.mem.zeroes([88]u8);
+    const mapping = ddac_conduit_map(path, @ptrCast(&mapped)) orelse return error.MapFailed;
+    defer ddac_conduit_unmap(mapping);
+
+    // content_kind (offset 0) = PDF, validation (offset 1) = ok
+    try testing.expectEqual(@as(u8, 0), mapped[0]);
+    try testing.expectEqual(@as(u8, 0), mapped[1]);
+    // file_size (offset 8) and sha256 (offset 16, 65 bytes) must agree
+    try testing.expectEqualSlices(u8, processed[8..81], mapped[8..81]);
+}
+
+test "resolve kind lets a recognised extension win over magic bytes" {
+    // TIFF magic (image) with a .geotiff extension parses as geospatial
+    try testing.expectEqual(@as(c_int, 5), ddac_resolve_kind(1, "/data/scan.geotiff"));
+    // Unrecognised extension: the magic kind stands
+    try testing.expectEqual(@as(c_int, 1), ddac_resolve_kind(1, "/data/scan.bin"));
+    // ZIP magic is EPUB only for .epub
+    try testing.expectEqual(@as(c_int, 4), ddac_resolve_kind(4, "/data/book.epub"));
+    try testing.expectEqual(@as(c_int, 6), ddac_resolve_kind(4, "/data/archive.bin"));
+    try testing.expectEqual(@as(c_int, 6), ddac_resolve_kind(1, null));
+}
+
+test "conduit unmap null is safe" {
+    ddac_conduit_unmap(null);
+}
+
+test "conduit batch matches conduit process per file" {
+    var dir_buf: [256]u8 = undefined;
+    const dir = std.fmt.bufPrint(&dir_buf, "/tmp/ddac-test-cbatch-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    // Small (single read), large (several reads) and empty files
+    var small_buf: [256]u8 = undefined;
+    const small = std.fmt.bufPrintZ(&small_buf, "{s}/small.pdf", .{dir}) catch return;
+    var large_buf: [256]u8 = undefined;
+    const large = std.fmt.bufPrintZ(&large_buf, "{s}/large.bin", .{dir}) catch return;
+    var empty_buf: [256]u8 = undefined;
+    const empty = std.fmt.bufPrintZ(&empty_buf, "{s}/empty.txt", .{dir}) catch return;
+    {
+        const f = try std.fs.createFileAbsoluteZ(small, .{});
+        defer f.close();
+        try f.writeAll("%PDF-1.4\n%%EOF\n");
+    }
+    {
+        const f = try std.fs.createFileAbsoluteZ(large, .{});
+        defer f.close();
+        var block: [4096]u8 = undefined;
+        for (&block, 0..) |*b, i| b.* = @truncate(i * 7);
+        for (0..100) |_| try f.writeAll(&block); // 400 KB
+    }
+    (try std.fs.createFileAbsoluteZ(empty, .{})).close();
+
+    const paths = [_]?[*:0]const u8{ small, null, large, empty, "/nonexistent/file.pdf" };
+    var batch: [paths.len][88]u8 align(8) = undefined;
+    try testing.expectEqual(@as(u32, 2), ddac_conduit_batch(&paths, @ptrCast(&batch), paths.len));
+
+    // Skipped slot reads as not found
+    try testing.expectEqual(@as(u8, 1), batch[1][1]);
+    for (paths, 0..) |p, i| {
+        const path = p orelse continue;
+        var single: [88]u8 align(8) = undefined;
+        _ = ddac_conduit_process(path, @ptrCast(&single));
+        // content_kind, validation, file_size and sha256 agree
+        try testing.expectEqualSlices(u8, single[0..2], batch[i][0..2]);
+        try testing.expectEqualSlices(u8, single[8..81], batch[i][8..81]);
+    }
+
+    // Background variant produces the same results, with two batches
+    // queued on the handle's conduit thread at once
+    const handle = ddac_init() orelse return;
+    defer ddac_free(handle);
+    var async_out: [paths.len][88]u8 align(8) = undefined;
+    var ahead_out: [paths.len][88]u8 align(8) = undefined;
+    const job = ddac_conduit_batch_start(handle, &paths, @ptrCast(&async_out), paths.len);
+    const ahead = ddac_conduit_batch_start(handle, &paths, @ptrCast(&ahead_out), paths.len);
+    if (job != null) try testing.expectEqual(@as(u32, 2), ddac_conduit_batch_wait(job));
+    if (ahead != null) try testing.expectEqual(@as(u32, 2), ddac_conduit_batch_wait(ahead));
+    try testing.expectEqualSlices(u8, &batch[2], &async_out[2]);
+    try testing.expectEqualSlices(u8, &batch[2], &ahead_out[2]);
+}
+
 // ============================================================================
 // Tests — Dragonfly (connection will fail without a server)
 // ============================================================================
@@ -412,10 +969,590 @@ test "dragonfly close null is safe" {
     ddac_dragonfly_close(null);
 }
 
+test "dragonfly pool to unreachable server returns null" {
+    // Port 1 on loopback: connection refused immediately
+    const pool = ddac_dragonfly_pool_create("127.0.0.1:1", 4);
+    if (pool) |p| {
+        ddac_dragonfly_pool_free(p);
+    }
+    try testing.expect(pool == null);
+    ddac_dragonfly_pool_free(null);
+}
+
+test "dragonfly batch calls with null pool clear the bitmap and return 0" {
+    const shas = [_]?[*:0]const u8{ null, null, null };
+    var results: [3 * 952]u8 = undefined;
+    var bitmap = [_]u8{0xFF};
+    try testing.expectEqual(@as(u32, 0), ddac_dragonfly_lookup_batch(null, &shas, &results, 952, &bitmap, 3));
+    try testing.expectEqual(@as(u8, 0), bitmap[0]);
+
+    const mask = [_]u8{0x07};
+    try testing.expectEqual(@as(u32, 0), ddac_dragonfly_store_batch(null, &shas, &results, 952, &mask, 0, 3));
+}
+
+// ============================================================================
+// Tests — Checkpoint
+// ============================================================================
+
+test "checkpoint marks survive close and reopen" {
+    var dir_buf: [128]u8 = undefined;
+    const dir = std.fmt.bufPrintZ(&dir_buf, "/tmp/ddac-test-ckpt-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    var bits_buf: [160]u8 = undefined;
+    var jrnl_buf: [160]u8 = undefined;
+    const bits = try std.fmt.bufPrintZ(&bits_buf, "{s}/checkpoint-0.bits", .{dir});
+    const jrnl = try std.fmt.bufPrintZ(&jrnl_buf, "{s}/checkpoint-0.journal", .{dir});
+
+    // flush_every = 2: indices 5 and 6 go to the journal, 200 stays pending
+    // until close. 63/64 straddle a word boundary.
+    const ck = ddac_ckpt_open(bits, jrnl, 1000, 0, 2) orelse return error.OpenFailed;
+    for ([_]u64{ 6, 5, 63, 64, 200 }) |idx| try testing.expectEqual(@as(i32, 0), ddac_ckpt_mark(ck, idx));
+    try testing.expectEqual(@as(i32, -1), ddac_ckpt_mark(ck, 1000));
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_close(ck));
+
+    const again = ddac_ckpt_open(bits, jrnl, 1000, 1, 2) orelse return error.OpenFailed;
+    defer _ = ddac_ckpt_close(again);
+    try testing.expectEqual(@as(u8, 0), ddac_ckpt_test(again, 5)); // nothing merged yet
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_merge(again, bits, jrnl));
+    try testing.expectEqual(@as(u64, 5), ddac_ckpt_resume_count(again));
+    for ([_]u64{ 5, 6, 63, 64, 200 }) |idx| try testing.expectEqual(@as(u8, 1), ddac_ckpt_test(again, idx));
+    try testing.expectEqual(@as(u8, 0), ddac_ckpt_test(again, 7));
+}
+
+test "checkpoint for another manifest size is reset and not merged" {
+    var dir_buf: [128]u8 = undefined;
+    const dir = std.fmt.bufPrintZ(&dir_buf, "/tmp/ddac-test-ckpt-size-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    var bits_buf: [160]u8 = undefined;
+    var jrnl_buf: [160]u8 = undefined;
+    const bits = try std.fmt.bufPrintZ(&bits_buf, "{s}/checkpoint-0.bits", .{dir});
+    const jrnl = try std.fmt.bufPrintZ(&jrnl_buf, "{s}/checkpoint-0.journal", .{dir});
+
+    const ck = ddac_ckpt_open(bits, jrnl, 100, 0, 1) orelse return error.OpenFailed;
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_mark(ck, 42));
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_sync(ck));
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_close(ck));
+
+    const other = ddac_ckpt_open(bits, jrnl, 5000, 1, 1) orelse return error.OpenFailed;
+    defer _ = ddac_ckpt_close(other);
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_merge(other, bits, jrnl));
+    try testing.expectEqual(@as(u8, 0), ddac_ckpt_test(other, 42));
+    try testing.expectEqual(@as(i32, -1), ddac_ckpt_merge(other, "/nonexistent/ckpt.bits", "/nonexistent/ckpt.journal"));
+    try testing.expectEqual(@as(i32, 0), ddac_ckpt_close(null));
+}
+
+test "resume sees every locale's journal-only marks when all open before merging" {
+    var dir_buf: [128]u8 = undefined;
+    const dir = std.fmt.bufPrintZ(&dir_buf, "/tmp/ddac-test-ckpt-multi-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    var bits_buf: [2][160]u8 = undefined;
+    var jrnl_buf: [2][160]u8 = undefined;
+    var bits: [2][:0]const u8 = undefined;
+    var jrnl: [2][:0]const u8 = undefined;
+    const marks = [_][2]u64{ .{ 10, 70 }, .{ 20, 900 } };
+
+    // Previous run, crashed: each locale's marks reached its journal but
+    // not its bitmap. Build that state by saving the journal, resetting the
+    // pair, and putting the journal back.
+    for (0..2) |l| {
+        bits[l] = try std.fmt.bufPrintZ(&bits_buf[l], "{s}/checkpoint-{d}.bits", .{ dir, l });
+        jrnl[l] = try std.fmt.bufPrintZ(&jrnl_buf[l], "{s}/checkpoint-{d}.journal", .{ dir, l });
+
+        const ck = ddac_ckpt_open(bits[l], jrnl[l], 1000, 0, 1) orelse return error.OpenFailed;
+        for (marks[l]) |idx| try testing.expectEqual(@as(i32, 0), ddac_ckpt_mark(ck, idx));
+        const journal = try std.fs.cwd().readFileAlloc(testing.allocator, jrnl[l], 1 << 20);
+        defer testing.allocator.free(journal);
+        try testing.expectEqual(@as(i32, 0), ddac_ckpt_close(ck));
+
+        try testing.expectEqual(@as(i32, 0), ddac_ckpt_close(ddac_ckpt_open(bits[l], jrnl[l], 1000, 0, 1)));
+        const f = try std.fs.cwd().createFileZ(jrnl[l], .{});
+        defer f.close();
+        try f.writeAll(journal);
+    }
+
+    // Resume, as loadCheckpoint does: open every locale (each folds and
+    // truncates its own journal), then merge every bitmap into each
+    var handles: [2]?*anyopaque = undefined;
+    for (0..2) |l| handles[l] = ddac_ckpt_open(bits[l], jrnl[l], 1000, 1, 1) orelse return error.OpenFailed;
+    defer for (handles) |h| {
+        _ = ddac_ckpt_close(h);
+    };
+    for (handles) |h| {
+        for (0..2) |l| try testing.expectEqual(@as(i32, 0), ddac_ckpt_merge(h, bits[l], jrnl[l]));
+    }
+
+    for (handles) |h| {
+        try testing.expectEqual(@as(u64, 4), ddac_ckpt_resume_count(h));
+        for (marks) |m| for (m) |idx| try testing.expectEqual(@as(u8, 1), ddac_ckpt_test(h, idx));
+    }
+}
+
+// ============================================================================
+// Tests — Streaming NDJSON Writer
+// ============================================================================
+
+test "ndjson task buffers drain every line on close" {
+    var path_buf: [128]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-ndjson-{d}.ndjson", .{std.time.milliTimestamp()}) catch return;
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    // Smallest slab (64 KiB) so 2000 lines cross several slab swaps
+    const writer = ddac_ndjson_open(path, 1, 0) orelse return error.OpenFailed;
+    const a = ddac_ndjson_task_buffer(writer);
+    const b = ddac_ndjson_task_buffer(writer);
+
+    // ddac_parse_result_t: sha256 at offset 48, title at 376
+    var result = std.mem.zeroes([952]u8);
+    @memcpy(result[48..][0..3], "abc");
+    @memcpy(result[376..][0..9], "say \"hi\"\n");
+    for (0..1000) |_| {
+        try testing.expectEqual(@as(i32, 0), ddac_ndjson_append(a, "/data/a.pdf", &result, 1.5));
+        try testing.expectEqual(@as(i32, 0), ddac_ndjson_append(b, "/data/b\tc.pdf", &result, 2.0));
+    }
+    ddac_ndjson_task_release(a);
+    ddac_ndjson_task_release(b);
+    try testing.expectEqual(@as(i64, 2000), ddac_ndjson_close(writer));
+
+    const data = try std.fs.cwd().readFileAlloc(testing.allocator, path, 16 * 1024 * 1024);
+    defer testing.allocator.free(data);
+    try testing.expectEqual(@as(usize, 2000), std.mem.count(u8, data, "\n"));
+    try testing.expect(std.mem.indexOf(u8, data, "\"title\":\"say \\\"hi\\\"\\n\"") != null);
+    try testing.expect(std.mem.indexOf(u8, data, "\"path\":\"/data/b\\tc.pdf\"") != null);
+    try testing.expect(std.mem.startsWith(u8, data, "{\"path\":"));
+}
+
+test "ndjson line bound covers the widest float fields" {
+    var path_buf: [128]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-ndjson-wide-{d}.ndjson", .{std.time.milliTimestamp()}) catch return;
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    const writer = ddac_ndjson_open(path, 1, 0) orelse return error.OpenFailed;
+    const tb = ddac_ndjson_task_buffer(writer);
+
+    // Every string byte escaped as \u00XX and both floats at f64 max
+    var result = std.mem.zeroes([952]u8);
+    @memset(result[48..][0..64], 0x01);
+    @memset(result[376..][0..255], 0x01);
+    @memcpy(result[32..][0..8], std.mem.asBytes(&std.math.floatMax(f64)));
+    const in_path = [_:0]u8{0x01} ** 1024;
+    for (0..20) |_| {
+        try testing.expectEqual(@as(i32, 0), ddac_ndjson_append(tb, &in_path, &result, std.math.floatMax(f64)));
+    }
+    ddac_ndjson_task_release(tb);
+    try testing.expectEqual(@as(i64, 20), ddac_ndjson_close(writer));
+
+    const data = try std.fs.cwd().readFileAlloc(testing.allocator, path, 16 * 1024 * 1024);
+    defer testing.allocator.free(data);
+    try testing.expectEqual(@as(usize, 20), std.mem.count(u8, data, "}\n"));
+    try testing.expect(std.mem.indexOf(u8, data, "\"parse_time_ms\":179769313486231") != null);
+}
+
+test "ndjson null handles are safe" {
+    ddac_ndjson_task_release(null);
+    try testing.expectEqual(@as(i64, 0), ddac_ndjson_close(null));
+    try testing.expect(ddac_ndjson_task_buffer(null) == null);
+}
+
+// ============================================================================
+// Tests — Results Container
+// ============================================================================
+
+test "container stores result rows and catalogs its shard" {
+    var dir_buf: [128]u8 = undefined;
+    const dir = std.fmt.bufPrintZ(&dir_buf, "/tmp/ddac-test-container-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    const c = ddac_container_open(dir, 1, 0) orelse return error.OpenFailed;
+    var result = std.mem.zeroes([952]u8);
+    try testing.expectEqual(@as(i32, 0), ddac_container_put_result(c, 7, &result, result.len));
+    try testing.expectEqual(@as(i32, 0), ddac_container_put_result(c, 3, &result, result.len));
+    // Wrong row size is rejected rather than corrupting the columns
+    try testing.expectEqual(@as(i32, -1), ddac_container_put_result(c, 4, &result, 16));
+
+    var blobs: u64 = 0;
+    var bytes: u64 = 0;
+    var rows: u64 = 0;
+    var segments: u32 = 0;
+    ddac_container_stats(c, &blobs, &bytes, &rows, &segments);
+    try testing.expectEqual(@as(u64, 2), rows);
+    try testing.expectEqual(@as(u64, 0), blobs);
+    try testing.expectEqual(@as(i32, 0), ddac_container_close(c));
+
+    var d = try std.fs.openDirAbsolute(dir, .{});
+    defer d.close();
+    try d.access("results.bin", .{});
+    try d.access("index.bin", .{});
+
+    var cat_buf: [160]u8 = undefined;
+    const cat = try std.fmt.bufPrintZ(&cat_buf, "{s}/container.cat", .{dir});
+    const shards = [_][*:0]const u8{dir};
+    try testing.expectEqual(@as(i64, 0), ddac_container_merge(cat, &shards, 1));
+    const catalog = try std.fs.cwd().readFileAlloc(testing.allocator, cat, 4096);
+    defer testing.allocator.free(catalog);
+    try testing.expect(std.mem.startsWith(u8, catalog, "DDACCAT1"));
+}
+
+test "container append keeps an earlier run's rows and drops a torn tail" {
+    var dir_buf: [128]u8 = undefined;
+    const dir = std.fmt.bufPrintZ(&dir_buf, "/tmp/ddac-test-container-append-{d}", .{std.time.milliTimestamp()}) catch return;
+    std.fs.makeDirAbsolute(dir) catch return;
+    defer std.fs.deleteTreeAbsolute(dir) catch {};
+
+    var result = std.mem.zeroes([952]u8);
+    const first = ddac_container_open(dir, 1, 0) orelse return error.OpenFailed;
+    try testing.expectEqual(@as(i32, 0), ddac_container_put_result(first, 1, &result, result.len));
+    try testing.expectEqual(@as(i32, 0), ddac_container_close(first));
+
+    var d = try std.fs.openDirAbsolute(dir, .{});
+    defer d.close();
+    const one_group = (try d.statFile("results.bin")).size;
+    {
+        // A crash mid-write leaves a partial row group behind
+        const f = try d.openFile("results.bin", .{ .mode = .read_write });
+        defer f.close();
+        try f.seekFromEnd(0);
+        try f.writeAll("DDACRGRP\x05\x00\x00\x00partial");
+    }
+
+    const second = ddac_container_open(dir, 1, 1) orelse return error.OpenFailed;
+    try testing.expectEqual(@as(i32, 0), ddac_container_put_result(second, 2, &result, result.len));
+    try testing.expectEqual(@as(i32, 0), ddac_container_close(second));
+    // Header + two one-row groups: the first run's row survived, the tail did not
+    try testing.expectEqual(2 * one_group - 16, (try d.statFile("results.bin")).size);
+
+    // Without append the container starts over
+    const fresh = ddac_container_open(dir, 1, 0) orelse return error.OpenFailed;
+    try testing.expectEqual(@as(i32, 0), ddac_container_close(fresh));
+    try testing.expectEqual(@as(u64, 16), (try d.statFile("results.bin")).size);
+}
+
+test "container null handles are safe" {
+    var result = std.mem.zeroes([952]u8);
+    try testing.expectEqual(@as(i32, -1), ddac_container_put_result(null, 0, &result, result.len));
+    try testing.expectEqual(@as(i32, 0), ddac_container_close(null));
+}
+
+// ============================================================================
+// Tests — Parallel Manifest Scanner
+// ============================================================================
+
+test "manifest ranges parse every ndjson entry once in order" {
+    var path_buf: [128]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-manifest-{d}.ndjson", .{std.time.milliTimestamp()}) catch return;
+    {
+        const f = try std.fs.createFileAbsoluteZ(path, .{});
+        defer f.close();
+        try f.writeAll("# comment\n");
+        for (0..500) |i| {
+            var line_buf: [96]u8 = undefined;
+            try f.writeAll(try std.fmt.bufPrint(&line_buf, "{{\"path\":\"/data/{d}.pdf\",\"size\":{d},\"kind\":\"pdf\"}}\n\n", .{ i, i * 10 }));
+        }
+    }
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    const m = ddac_manifest_open(path) orelse return error.OpenFailed;
+    defer ddac_manifest_close(m);
+    const bytes = ddac_manifest_bytes(m);
+
+    // Seven ranges that cut lines at arbitrary points
+    const n = 7;
+    var total: u64 = 0;
+    var next_idx: usize = 0;
+    for (0..n) |r| {
+        const lo = bytes * r / n;
+        const hi = bytes * (r + 1) / n;
+        total += ddac_manifest_count(m, lo, hi);
+        var cursor = lo;
+        var e: ManifestEntry = undefined;
+        while (ddac_manifest_next(m, &cursor, hi, 1, &e) == 1) : (next_idx += 1) {
+            var want_buf: [32]u8 = undefined;
+            const want = try std.fmt.bufPrint(&want_buf, "/data/{d}.pdf", .{next_idx});
+            try testing.expectEqualStrings(want, e.path.?[0..e.path_len]);
+            try testing.expectEqual(@as(i64, @intCast(next_idx * 10)), e.size);
+            try testing.expectEqual(@as(i64, -1), e.mtime);
+            try testing.expectEqualStrings("pdf", e.kind.?[0..e.kind_len]);
+        }
+    }
+    try testing.expectEqual(@as(u64, 500), total);
+    try testing.expectEqual(@as(usize, 500), next_idx);
+}
+
+test "manifest null handle is safe" {
+    try testing.expectEqual(@as(u64, 0), ddac_manifest_bytes(null));
+    try testing.expectEqual(@as(u64, 0), ddac_manifest_count(null, 0, 100));
+    ddac_manifest_close(null);
+    try testing.expect(ddac_manifest_open("/nonexistent/manifest.txt") == null);
+}
+
+// ============================================================================
+// Tests — Isolated Parse Workers
+// ============================================================================
+
+test "isolate pool with a missing worker binary is null" {
+    try testing.expect(ddac_isolate_create("/nonexistent/ddac-parse-worker", 2) == null);
+}
+
+test "isolate null pool leaves the result for an in-process parse" {
+    var result = std.mem.zeroes([952]u8);
+    result[0] = 0x5a;
+    try testing.expectEqual(@as(i32, -1), ddac_isolate_parse(null, "/tmp/a.pdf", "/tmp/a.txt", 0, 0, null, null, 1000, &result));
+    try testing.expectEqual(@as(u8, 0x5a), result[0]);
+
+    var timeouts: u64 = 1;
+    var crashes: u64 = 1;
+    var respawns: u64 = 1;
+    ddac_isolate_stats(null, &timeouts, &crashes, &respawns);
+    try testing.expectEqual(@as(u64, 0), timeouts + crashes + respawns);
+    ddac_isolate_free(null);
+}
+
+// ============================================================================
+// Tests — Latency Metrics
+// ============================================================================
+
+test "metrics snapshot after reset is empty and sized by the layout" {
+    var phases: u32 = 0;
+    var buckets: u32 = 0;
+    ddac_metrics_layout(&phases, &buckets);
+    try testing.expect(phases > 0 and buckets > 0);
+
+    const len = @as(usize, phases) * buckets;
+    const counts = try testing.allocator.alloc(u64, len);
+    defer testing.allocator.free(counts);
+
+    // Too small: nothing written, required length returned
+    try testing.expectEqual(len, ddac_metrics_snapshot(counts.ptr, 0));
+
+    ddac_metrics_reset();
+    try testing.expectEqual(len, ddac_metrics_snapshot(counts.ptr, len));
+    for (counts) |c| try testing.expectEqual(@as(u64, 0), c);
+    try testing.expectEqual(@as(f64, 0), ddac_metrics_quantile(counts.ptr, buckets, 0.99));
+}
+
+test "metrics phase names" {
+    try testing.expectEqualStrings("document", std.mem.span(ddac_metrics_phase_name(0)));
+    try testing.expectEqualStrings("stage.language_detect", std.mem.span(ddac_metrics_phase_name(7)));
+    try testing.expectEqualStrings("", std.mem.span(ddac_metrics_phase_name(1 << 20)));
+}
+
+// ============================================================================
+// Tests — Page-Range PDF Parsing
+// ============================================================================
+
+test "pdf page count of a missing or null path is -1" {
+    try testing.expectEqual(@as(i32, -1), ddac_pdf_page_count("/nonexistent/volume.pdf", null));
+    try testing.expectEqual(@as(i32, -1), ddac_pdf_page_count(null, null));
+}
+
+test "parse pages reports failures in the part" {
+    try testing.expectEqual(@as(usize, 64), @sizeOf(PagePart));
+    try testing.expectEqual(@as(c_int, 3), ddac_parse_pages(null, "/tmp/a.pdf", "/tmp/a.part0", 0, 10, 0, null, null));
+
+    var part = std.mem.zeroes(PagePart);
+    try testing.expectEqual(@as(c_int, 4), ddac_parse_pages(null, "/tmp/a.pdf", "/tmp/a.part0", 0, 10, 0, null, &part));
+    try testing.expectEqual(@as(c_int, 4), part.status);
+
+    const handle = ddac_init() orelse return error.InitFailed;
+    defer ddac_free(handle);
+    try testing.expectEqual(@as(c_int, 2), ddac_parse_pages(handle, "/nonexistent/volume.pdf", "/tmp/volume.part0", 0, 10, 0, null, &part));
+    try testing.expectEqual(@as(i64, 0), part.word_count);
+}
+
+// ============================================================================
+// Tests — Near-Duplicate Index
+// ============================================================================
+
+test "near-dup snapshot reopens with its entries and takes new ones" {
+    var path_buf: [128]u8 = undefined;
+    const path = std.fmt.bufPrintZ(&path_buf, "/tmp/ddac-test-neardup-{d}.snap", .{std.time.milliTimestamp()}) catch return;
+    defer std.fs.deleteFileAbsolute(path) catch {};
+
+    const idx = ddac_neardup_create() orelse return error.CreateFailed;
+    const h: u64 = 0xDEAD_BEEF_0BAD_F00D;
+    try testing.expectEqual(@as(i32, 0), ddac_neardup_insert(idx, h, 10));
+    try testing.expectEqual(@as(i32, 0), ddac_neardup_insert(idx, h ^ 0x8000_0000_0000_0001, 11));
+    try testing.expectEqual(@as(i32, 0), ddac_neardup_save(idx, path));
+    ddac_neardup_free(idx);
+
+    const again = ddac_neardup_open(path) orelse return error.OpenFailed;
+    defer ddac_neardup_free(again);
+    try testing.expectEqual(@as(i32, 0), ddac_neardup_insert(again, h ^ 0b111, 12));
+    try testing.expectEqual(@as(u64, 3), ddac_neardup_count(again));
+
+    var ids: [4]u64 = undefined;
+    var dists: [4]u8 = undefined;
+    try testing.expectEqual(@as(i32, 3), ddac_neardup_query(again, h, 3, &ids, &dists, 4));
+    try testing.expectEqual(@as(u64, 10), ids[0]);
+    try testing.expectEqual(@as(u8, 0), dists[0]);
+    try testing.expectEqual(@as(u8, 3), dists[2]);
+    try testing.expectEqual(@as(i32, 1), ddac_neardup_query(again, h, 3, &ids, &dists, 1));
+    try testing.expectEqual(@as(i32, -1), ddac_neardup_query(null, h, 3, &ids, &dists, 4));
+}
+
+test "near-dup open rejects missing and foreign files" {
+    try testing.expect(ddac_neardup_open("/nonexistent/neardup.snap") == null);
+    try testing.expect(ddac_neardup_open(null) == null);
+    ddac_neardup_free(null);
+}
+
+test "near-dup shards cover every chunk owner" {
+    var shards: [16]u32 = undefined;
+    const n = ddac_neardup_shards(0x0123_4567_89AB_CDEF, 0, 16, &shards);
+    try testing.expect(n >= 1 and n <= 4);
+    for (shards[0..n]) |s| try testing.expect(s < 16);
+    // A wider radius visits the owners and more
+    const wide = ddac_neardup_shards(0x0123_4567_89AB_CDEF, 6, 16, &shards);
+    try testing.expect(wide >= n and wide <= 16);
+    try testing.expectEqual(@as(u32, 1), ddac_neardup_shards(42, 15, 1, &shards));
+    try testing.expectEqual(@as(u32, 0), ddac_neardup_shards(42, 0, 0, &shards));
+}
+
+test "near-dup batches check a chunk, then index it" {
+    const idx = ddac_neardup_create() orelse return error.CreateFailed;
+    defer ddac_neardup_free(idx);
+    const hashes = [_]u64{ 0xF0F0, 0xF0F1, 0x0F0F_0000_0000 };
+    const docs = [_]u64{ 1, 2, 3 };
+    try testing.expectEqual(@as(i32, 3), ddac_neardup_insert_batch(idx, &hashes, &docs, 3));
+    // Same documents again: nothing new
+    try testing.expectEqual(@as(i32, 0), ddac_neardup_insert_batch(idx, &hashes, &docs, 3));
+
+    const probe = [_]u64{ 0xF0F0, 0xFFFF_FFFF_FFFF_FFFF };
+    const probe_docs = [_]u64{ 1, 4 };
+    var ids: [2]u64 = undefined;
+    var dists: [2]u8 = undefined;
+    try testing.expectEqual(@as(i32, 1), ddac_neardup_check_batch(idx, &probe, &probe_docs, 2, 4, &ids, &dists));
+    try testing.expectEqual(@as(u64, 2), ids[0]); // not its own entry
+    try testing.expectEqual(@as(u8, 1), dists[0]);
+    try testing.expectEqual(@as(u8, 0xFF), dists[1]);
+    try testing.expectEqual(@as(i32, -1), ddac_neardup_check_batch(null, &probe, &probe_docs, 2, 4, &ids, &dists));
+}
+
+test "image ahash rejects missing files" {
+    var hash: u64 = 0;
+    try testing.expectEqual(@as(i32, -1), ddac_image_ahash("/nonexistent/a.png", null, &hash));
+    try testing.expectEqual(@as(i32, -1), ddac_image_ahash(null, null, &hash));
+}
+
+// ============================================================================
+// Tests — Stage Re-extraction
+// ============================================================================
+
+test "reextract stages adds to the existing stage message in place" {
+    var out_buf: [128]u8 = undefined;
+    const out_path = std.fmt.bufPrintZ(&out_buf, "/tmp/ddac-test-reextract-{d}.txt", .{std.time.milliTimestamp()}) catch return;
+    var stages_buf: [160]u8 = undefined;
+    const stages_path = std.fmt.bufPrintZ(&stages_buf, "{s}.stages.capnp", .{out_path}) catch return;
+    defer std.fs.deleteFileAbsolute(out_path) catch {};
+    defer std.fs.deleteFileAbsolute(stages_path) catch {};
+
+    const handle = ddac_init() orelse return error.InitFailed;
+    defer ddac_free(handle);
+
+    var result = std.mem.zeroes([952]u8);
+    std.mem.writeInt(i32, result[4..8], 6, .little); // content_kind = Unknown
+    var mask: u64 = 0;
+
+    // No extracted text yet: the caller must run a full parse
+    try testing.expectEqual(@as(c_int, 2), ddac_reextract_stages(handle, "/tmp/in.pdf", out_path, 1, &result, &mask));
+    try testing.expectEqual(@as(c_int, 4), ddac_reextract_stages(handle, "/tmp/in.pdf", out_path, 1, null, &mask));
+
+    {
+        const f = try std.fs.createFileAbsoluteZ(out_path, .{});
+        defer f.close();
+        try f.writeAll("The quick brown fox jumps over the lazy dog. The dog sleeps.");
+    }
+
+    const lang: u64 = 1 << 0;
+    const keywords: u64 = 1 << 2;
+    try testing.expectEqual(@as(c_int, 0), ddac_reextract_stages(handle, "/tmp/in.pdf", out_path, lang, &result, &mask));
+    try testing.expectEqual(lang, mask);
+
+    // Only the missing stage runs; the message now holds both
+    const to_run = ddac_reextract_plan(mask, lang | keywords);
+    try testing.expectEqual(keywords, to_run);
+    try testing.expectEqual(@as(c_int, 0), ddac_reextract_stages(handle, "/tmp/in.pdf", out_path, to_run, &result, &mask));
+    try testing.expectEqual(lang | keywords, mask);
+
+    var msg: [24]u8 = undefined;
+    const f = try std.fs.openFileAbsoluteZ(stages_path, .{});
+    defer f.close();
+    try testing.expectEqual(@as(usize, 24), try f.readAll(&msg));
+    try testing.expectEqual(lang | keywords, std.mem.readInt(u64, msg[16..24], .little));
+}
+
+// ============================================================================
+// Tests — Batched Parse
+// ============================================================================
+
+test "parse batch writes every slot of the caller's array" {
+    const handle = ddac_init() orelse return error.InitFailed;
+    defer ddac_free(handle);
+
+    const paths = [_]?[*:0]const u8{ "/nonexistent/a.pdf", null };
+    const outs = [_]?[*:0]const u8{ "/tmp/ddac-test-batch-a", "/tmp/ddac-test-batch-b" };
+    var results: [2][952]u8 = undefined;
+    @memset(std.mem.asBytes(&results), 0xaa);
+
+    try testing.expectEqual(@as(u32, 0), ddac_parse_batch(handle, &paths, &outs, 2, 0, @ptrCast(&results)));
+    // ddac_parse_result_t: status at offset 0, error_msg at 120
+    try testing.expectEqual(@as(i32, 2), std.mem.readInt(i32, results[0][0..4], .little));
+    try testing.expect(std.mem.startsWith(u8, results[0][120..], "File not found: /nonexistent/a.pdf"));
+    try testing.expectEqual(@as(i32, 3), std.mem.readInt(i32, results[1][0..4], .little));
+    try testing.expectEqual(@as(u8, 0), results[1][48]); // zeroed, not left over
+
+    // Null handle: every slot reports it
+    try testing.expectEqual(@as(u32, 0), ddac_parse_batch(null, &paths, &outs, 2, 0, @ptrCast(&results)));
+    try testing.expectEqual(@as(i32, 4), std.mem.readInt(i32, results[1][0..4], .little));
+    try testing.expectEqual(@as(u32, 0), ddac_parse_batch(handle, &paths, &outs, 2, 0, null));
+}
+
+test "parse columns gathers results into contiguous arrays" {
+    // ddac_parse_result_t: status 0, word_count 16, sha256 48
+    var results = std.mem.zeroes([3][952]u8);
+    for (&results, 0..) |*r, i| {
+        std.mem.writeInt(i32, r[0..4], @intCast(i), .little);
+        std.mem.writeInt(i64, r[16..24], @intCast(100 * i), .little);
+        r[48] = 'a' + @as(u8, @intCast(i));
+    }
+
+    var status: [3]i32 = undefined;
+    var words: [3]i64 = undefined;
+    var shas: [3][65]u8 = undefined;
+    const cols = ParseColumns{
+        .status = &status,
+        .content_kind = null,
+        .page_count = null,
+        .word_count = &words,
+        .char_count = null,
+        .duration_sec = null,
+        .parse_time_ms = null,
+        .sha256 = &shas,
+    };
+    ddac_parse_columns(@ptrCast(&results), 3, &cols);
+    try testing.expectEqualSlices(i32, &.{ 0, 1, 2 }, &status);
+    try testing.expectEqualSlices(i64, &.{ 0, 100, 200 }, &words);
+    try testing.expectEqual(@as(u8, 'c'), shas[2][0]);
+
+    // Null arguments are ignored
+    ddac_parse_columns(null, 3, &cols);
+    ddac_parse_columns(@ptrCast(&results), 3, null);
+}
+
 // ============================================================================
 // Tests — Struct Size Assertions (match Idris2 proofs)
 // ============================================================================
 
+test "ParseColumns struct is 64 bytes" {
+    try testing.expectEqual(@as(usize, 64), @sizeOf(ParseColumns));
+}
+
 test "CryptoCaps struct is 16 bytes" {
     try testing.expectEqual(@as(usize, 16), @sizeOf(CryptoCaps));
 }
@@ -49,7 +49,8 @@ enum ddac_parse_status {
  * Pass a combination of these flags as the stage_flags parameter to
  * ddac_parse() to enable per-document analysis stages.
  * Stage results are written to {output_path}.stages.capnp in Cap'n Proto
- * binary format.  Decode with:
+ * binary format (multi-segment when large; packed if
+ * ddac_set_stages_packed is on).  Decode with:
  *   capnp decode schema/stages.capnp StageResults < result.stages.capnp
  * ═══════════════════════════════════════════════════════════════════════ */
 
@@ -149,11 +150,82 @@ void  ddac_set_ml_handle(void *handle, void *ml_handle);
  *  falling back to CPU Tesseract on gpu_error. */
 void  ddac_set_gpu_ocr_handle(void *handle, void *gpu_ocr_handle);
 
+/** Hand the next parse on this handle a ticket from ddac_gpu_ocr_submit()
+ *  so the image's batch runs while other documents are parsed. The parse
+ *  collects the ticket, or releases it if unused; -1 clears it. */
+void  ddac_set_gpu_ocr_ticket(void *handle, int ticket);
+
+/** Write this handle's .stages.capnp messages in Cap'n Proto packed
+ *  encoding (enabled != 0) instead of the standard framing.  Decode with
+ *  `capnp decode --packed`; ddac_reextract_* accept either. */
+void  ddac_set_stages_packed(void *handle, int enabled);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Batched Parse
+ *
+ * ddac_parse_batch parses a chunk in one call, writing each result into a
+ * caller-allocated array (no 952-byte return by value per document).
+ * Slot i receives what ddac_parse(handle, paths[i], out_paths[i], 0,
+ * stage_flags) would return; a NULL path gives status 3.  Returns the
+ * number of documents with status 0.
+ *
+ * ddac_parse_columns gathers the numeric fields and SHA-256 of a result
+ * array into a struct-of-arrays view, so reductions run over contiguous
+ * columns.  Each column has n elements; NULL columns are skipped.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/* Parse Columns -- 64 bytes, 8-byte aligned (Layout.idr) */
+typedef struct ddac_parse_columns_t {
+    int32_t  *status;
+    int32_t  *content_kind;
+    int32_t  *page_count;
+    int64_t  *word_count;
+    int64_t  *char_count;
+    double   *duration_sec;
+    double   *parse_time_ms;
+    char    (*sha256)[65];
+} ddac_parse_columns_t;
+
+_Static_assert(sizeof(ddac_parse_columns_t) == 64,
+    "ddac_parse_columns_t must be 64 bytes on LP64 (Idris2 proof: Layout.idr)");
+
+uint32_t ddac_parse_batch(void *handle, const char *const *paths,
+                          const char *const *out_paths, uint32_t n,
+                          uint64_t stage_flags,
+                          ddac_parse_result_t *results_out);
+void     ddac_parse_columns(const ddac_parse_result_t *results, uint32_t n,
+                            const ddac_parse_columns_t *columns);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Parse Handle Pool
+ *
+ * Keeps warmed parse handles (Tesseract traineddata, GDAL drivers, vips)
+ * alive across documents. Acquire once per worker task, release when the
+ * task ends. Handles from the pool are passed to ddac_parse() exactly
+ * like ddac_init() handles, but must go back via ddac_pool_release().
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+void    *ddac_pool_create(uint32_t size);
+void     ddac_pool_free(void *pool);
+void    *ddac_pool_acquire(void *pool);
+void     ddac_pool_release(void *pool, void *handle);
+
+/** Bind ML and GPU OCR handles to every pooled parse handle (current and
+ *  future). Either may be NULL. Ownership stays with the caller. */
+void     ddac_pool_bind(void *pool, void *ml_handle, void *gpu_ocr_handle);
+
+/** ddac_set_stages_packed for every pooled parse handle (current and future). */
+void     ddac_pool_set_stages_packed(void *pool, int enabled);
+uint32_t ddac_pool_size(void *pool);
+
 /* ═══════════════════════════════════════════════════════════════════════
  * LMDB Result Cache
  *
  * Zero-copy reads, ACID, multi-reader/single-writer.
  * Each Chapel locale should have its own cache directory.
+ * Results are stored as a compact versioned record and expanded back to
+ * ddac_parse_result_t on lookup; result_size must be
+ * sizeof(ddac_parse_result_t).
  * ═══════════════════════════════════════════════════════════════════════ */
 
 void    *ddac_cache_init(const char *dir_path, uint64_t max_size_mb);
@@ -167,15 +239,81 @@ void     ddac_cache_store(void *cache, const char *doc_path,
 uint64_t ddac_cache_count(void *cache);
 void     ddac_cache_sync(void *cache);
 
+/* Durability flags for ddac_cache_init_ex. Either flag skips the fsync on
+ * every commit; call ddac_cache_sync periodically. A crash loses at most
+ * the commits since the last sync and never corrupts the database. */
+#define DDAC_CACHE_NOSYNC    0x1u   /* MDB_NOSYNC */
+#define DDAC_CACHE_WRITEMAP  0x2u   /* MDB_WRITEMAP | MDB_MAPASYNC | MDB_NOSYNC */
+/* Content-addressed layout: DBI "paths" (path -> mtime, size, sha256) and
+ * DBI "content" (sha256 -> result + stage blob). Use a fresh directory;
+ * path-keyed stores are no-ops on such a cache. */
+#define DDAC_CACHE_CONTENT   0x4u
+
+void    *ddac_cache_init_ex(const char *dir_path, uint64_t max_size_mb,
+                            uint32_t flags);
+
+/** Look up n documents in one read transaction. paths/mtimes/sizes are
+ *  parallel arrays; a NULL path or negative mtime/size is a miss.
+ *  results_out holds n * result_size bytes (only hit slots are written).
+ *  stage_masks_out (optional, n entries) receives each hit's stored
+ *  DDAC_STAGE_* mask (0 for entries written without one).
+ *  hit_bitmap holds (n + 7) / 8 bytes; bit i (byte i/8, bit i%8) is set
+ *  on a hit. Returns the number of hits. */
+uint32_t ddac_cache_lookup_batch(void *cache, const char *const *paths,
+                                 const int64_t *mtimes, const int64_t *sizes,
+                                 void *results_out, size_t result_size,
+                                 uint64_t *stage_masks_out,
+                                 uint8_t *hit_bitmap, uint32_t n);
+
+/** Store n documents in one write transaction (one commit). stage_masks
+ *  (optional, n entries) is the stage mask stored with each entry.
+ *  store_mask, if non-NULL, selects entries by bit (same layout as
+ *  hit_bitmap). Returns the number of entries written (0 if the commit
+ *  failed). */
+uint32_t ddac_cache_store_batch(void *cache, const char *const *paths,
+                                const int64_t *mtimes, const int64_t *sizes,
+                                const void *results, size_t result_size,
+                                const uint64_t *stage_masks,
+                                const uint8_t *store_mask, uint32_t n);
+
+/** Content-addressed lookup (DDAC_CACHE_CONTENT). Slot i resolves by path
+ *  first, then by shas[i] (may be NULL). A sha-only hit also sets bit i in
+ *  moved_bitmap and writes the cached stage blob to stage_paths[i] (optional).
+ *  Returns the number of hits. */
+uint32_t ddac_cache_lookup_content_batch(void *cache, const char *const *paths,
+                                         const int64_t *mtimes, const int64_t *sizes,
+                                         const char *const *shas,
+                                         const char *const *stage_paths,
+                                         void *results_out, size_t result_size,
+                                         uint8_t *hit_bitmap, uint8_t *moved_bitmap,
+                                         uint32_t n);
+
+/** Content-addressed store (DDAC_CACHE_CONTENT) in one write transaction.
+ *  Re-points each selected path at shas[i] and adds the result plus the
+ *  file at stage_paths[i] (optional) unless the digest is already cached.
+ *  Returns the number of slots indexed (0 if the commit failed). */
+uint32_t ddac_cache_store_content_batch(void *cache, const char *const *paths,
+                                        const int64_t *mtimes, const int64_t *sizes,
+                                        const char *const *shas,
+                                        const char *const *stage_paths,
+                                        const void *results, size_t result_size,
+                                        const uint8_t *store_mask, uint32_t n);
+
 /* ═══════════════════════════════════════════════════════════════════════
  * I/O Prefetcher (Linux io_uring + fadvise)
  *
  * Prefetches upcoming documents into page cache while current one parses.
  * Uses io_uring on Linux 5.6+, falls back to posix_fadvise.
+ * One prefetcher per locale: hint/submit/done are thread-safe (lock-free
+ * queue to a worker thread). Bytes in flight are bounded by budget_mb,
+ * or by a quarter of MemAvailable when it is 0.
  * ═══════════════════════════════════════════════════════════════════════ */
 
 void    *ddac_prefetch_init(uint32_t window_size);
+void    *ddac_prefetch_init_ex(uint32_t window_size, uint64_t budget_mb);
 void     ddac_prefetch_hint(void *handle, const char *path);
+/** Queue `count` upcoming files (NULL entries skipped) with one wakeup. */
+void     ddac_prefetch_submit(void *handle, const char *const *paths, uint32_t count);
 void     ddac_prefetch_done(void *handle, const char *path);
 void     ddac_prefetch_free(void *handle);
 uint32_t ddac_prefetch_inflight(void *handle);
@@ -184,7 +322,8 @@ uint32_t ddac_prefetch_inflight(void *handle);
  * Dragonfly / Redis L2 Cache (RESP2 protocol)
  *
  * Cross-locale shared cache via Dragonfly (Redis-compatible, 25x faster).
- * Cache key: "ddac:{sha256_hex}"  Value: raw ddac_parse_result_t bytes.
+ * Cache key: "ddac:{sha256_hex}"  Value: compact result record (the same
+ * encoding as the LMDB cache; raw ddac_parse_result_t values still read).
  * Multiple Chapel locales can share a single Dragonfly instance.
  * ═══════════════════════════════════════════════════════════════════════ */
 
@@ -197,6 +336,25 @@ void     ddac_dragonfly_store(void *handle, const char *sha256,
                                uint32_t ttl_secs);
 uint64_t ddac_dragonfly_count(void *handle);
 
+/* Per-locale connection pool + batched L2 traffic.
+ * lookup_batch issues one MGET for the whole block; store_batch pipelines
+ * one SET per masked slot in a single write. Each call leases its own
+ * pooled connection, so concurrent tasks never share a socket. The pool
+ * holds at most `size` connections (callers wait when all are leased);
+ * pool_size is the number open, leased plus idle.
+ * sha256s[i] may be NULL to skip slot i. Bitmaps: bit i = slot i. */
+void    *ddac_dragonfly_pool_create(const char *host_port, uint32_t size);
+void     ddac_dragonfly_pool_free(void *pool);
+uint32_t ddac_dragonfly_pool_size(void *pool);
+uint64_t ddac_dragonfly_pool_count(void *pool);
+uint32_t ddac_dragonfly_lookup_batch(void *pool, const char *const *sha256s,
+                                     void *results_out, size_t result_size,
+                                     uint8_t *hit_bitmap, uint32_t n);
+uint32_t ddac_dragonfly_store_batch(void *pool, const char *const *sha256s,
+                                    const void *results, size_t result_size,
+                                    const uint8_t *store_mask,
+                                    uint32_t ttl_secs, uint32_t n);
+
 /* ═══════════════════════════════════════════════════════════════════════
  * ML Inference Engine (ONNX Runtime)
  *
@@ -243,6 +401,16 @@ int          ddac_ml_run_stage(void *handle, uint8_t stage,
                                 ddac_ml_result_t *result_out);
 void         ddac_ml_stats(void *handle, uint64_t *total_inferences,
                             uint64_t *total_inference_us);
+/* Batching: a stage's batch runs once max_batch (1..64) requests are
+ * queued or the oldest has waited max_wait_us. */
+void         ddac_ml_set_batch_policy(void *handle, uint8_t stage,
+                                      uint32_t max_batch, uint32_t max_wait_us);
+/* Occupancy = items / (batches * max_batch); mean wait = wait_us / items. */
+void         ddac_ml_queue_stats(void *handle, uint8_t stage,
+                                 uint64_t *batches, uint64_t *items,
+                                 uint64_t *queue_wait_us,
+                                 uint64_t *max_queue_wait_us,
+                                 uint32_t *max_batch);
 size_t       ddac_ml_result_size(void);
 uint8_t      ddac_ml_stage_count(void);
 const char  *ddac_ml_model_name(uint8_t stage);
@@ -252,22 +420,24 @@ const char  *ddac_ml_model_name(uint8_t stage);
  *
  * Detects and reports CPU crypto capabilities for SHA-256 hashing.
  * Zig's std SHA-256 auto-uses SHA-NI/ARM-SHA2 for single-file hashing.
- * The batch API provides multi-buffer hashing (4 files at once via AVX2).
+ * The batch API hashes small files in SIMD lanes (16 per pass with
+ * AVX-512, 8 with AVX2) and streams the rest with large reads + readahead.
  *
- * Tiers: 0=SHA-NI/ARM-SHA2, 1=AVX2 multi-buffer, 2=software
+ * Tiers: 0=SHA-NI/ARM-SHA2, 1=AVX-512/AVX2 multi-buffer, 2=software
  * ═══════════════════════════════════════════════════════════════════════ */
 
 /* Crypto capabilities — 16 bytes */
 typedef struct ddac_crypto_caps_t {
     uint8_t  has_sha_ni;       /* x86-64 SHA-NI instructions */
-    uint8_t  has_avx2;         /* x86-64 AVX2 (multi-buffer) */
-    uint8_t  has_avx512;       /* x86-64 AVX-512F */
+    uint8_t  has_avx2;         /* x86-64 AVX2, OS-enabled (8 lanes) */
+    uint8_t  has_avx512;       /* x86-64 AVX-512F, OS-enabled (16 lanes) */
     uint8_t  has_arm_sha2;     /* AArch64 SHA2 extension */
     uint8_t  has_arm_sha512;   /* AArch64 SHA-512 extension */
     uint8_t  has_aes_ni;       /* x86-64 AES-NI */
     uint8_t  _pad[2];
-    uint8_t  sha256_tier;      /* 0=dedicated, 1=AVX2, 2=software */
-    uint8_t  _pad2[7];
+    uint8_t  sha256_tier;      /* 0=dedicated, 1=multi-buffer, 2=software */
+    uint8_t  sha256_lanes;     /* files hashed per pass: 16, 8, or 1 */
+    uint8_t  _pad2[6];
 } ddac_crypto_caps_t;
 
 _Static_assert(sizeof(ddac_crypto_caps_t) == 16,
@@ -316,12 +486,19 @@ _Static_assert(_Alignof(ddac_ocr_result_t) == 8,
 void    *ddac_gpu_ocr_init(void);
 void     ddac_gpu_ocr_free(void *handle);
 uint8_t  ddac_gpu_ocr_backend(void *handle);
+/* PaddleOCR models: {dir}/det, {dir}/rec, {dir}/dict.txt */
+void     ddac_gpu_ocr_set_model_dir(void *handle, const char *dir);
+/* Returns a ticket (>= 0) or -1 (no free batch buffer / no GPU backend).
+ * output_path may be NULL: the text is then only returned via collect. */
 int      ddac_gpu_ocr_submit(void *handle, const char *image_path,
                               const char *output_path);
+/* Starts the partial batch on the worker thread; does not wait. */
 void     ddac_gpu_ocr_flush(void *handle);
 uint32_t ddac_gpu_ocr_results_ready(void *handle);
-int      ddac_gpu_ocr_collect(void *handle, uint32_t slot_id,
+/* Waits for the ticket's batch. Returns 0, or -1 on an invalid ticket. */
+int      ddac_gpu_ocr_collect(void *handle, uint32_t ticket,
                                ddac_ocr_result_t *result_out);
+void     ddac_gpu_ocr_release(void *handle, int ticket);
 void     ddac_gpu_ocr_stats(void *handle, uint64_t *submitted,
                               uint64_t *completed, uint64_t *batches,
                               uint64_t *gpu_time_us);
@@ -338,8 +515,12 @@ size_t   ddac_gpu_ocr_result_size(void);
  *   - SHA-256 pre-computation (feeds L2 Dragonfly cache lookup)
  *   - File size capture (avoids stat() in main loop)
  *
- * Run ddac_conduit_batch() on a block of paths before entering the
- * forall loop to amortise I/O latency and pre-populate cache keys.
+ * Run ddac_conduit_batch() on a block of paths before parsing it to
+ * amortise I/O latency and pre-populate cache keys. On Linux the batch
+ * drives openat/statx/read for the whole block through io_uring and
+ * hashes as reads complete. ddac_conduit_batch_start/_wait run it on the
+ * parse handle's conduit thread, which keeps its ring across blocks, so
+ * the next block's I/O overlaps the current parse.
  * ═══════════════════════════════════════════════════════════════════════ */
 
 /* Conduit validation codes */
@@ -368,14 +549,437 @@ _Static_assert(_Alignof(ddac_conduit_result_t) == 8,
 int      ddac_conduit_process(const char *path,
                                ddac_conduit_result_t *result_out);
 
-/** Batch pre-process N files. Returns number of valid files. */
-uint32_t ddac_conduit_batch(const char **paths,
+/** Batch pre-process N files. A NULL path skips the slot (its result
+ *  reads DDAC_CONDUIT_NOT_FOUND). Returns number of valid files. */
+uint32_t ddac_conduit_batch(const char *const *paths,
                              ddac_conduit_result_t *results,
                              uint32_t count);
 
+/** Queue ddac_conduit_batch() on the handle's conduit thread (spawned on
+ *  first use; batches run in order). paths and results must stay valid
+ *  until ddac_conduit_batch_wait(). Returns a job handle (NULL if the
+ *  batch had to run synchronously — results are then complete). */
+void    *ddac_conduit_batch_start(void *handle,
+                                   const char *const *paths,
+                                   ddac_conduit_result_t *results,
+                                   uint32_t count);
+
+/** Join a batch job and free it. Returns number of valid files (0 for NULL). */
+uint32_t ddac_conduit_batch_wait(void *job);
+
 /** Get sizeof(ddac_conduit_result_t) for Chapel allocation. */
 size_t   ddac_conduit_result_size(void);
 
+/** Single-read variant of ddac_conduit_process(): mmap the file once,
+ *  detect and hash from the mapping, and return the mapping so that
+ *  ddac_parse_ex() can parse from the same bytes. Returns NULL when
+ *  validation fails (see result_out->validation). */
+void    *ddac_conduit_map(const char *path,
+                           ddac_conduit_result_t *result_out);
+
+/** Release a mapping from ddac_conduit_map(). Safe to call with NULL. */
+void     ddac_conduit_unmap(void *mapping);
+
+/** Parse using a precomputed conduit result: the SHA-256 is reused and
+ *  the existence check is skipped. A recognised extension picks the
+ *  parser; otherwise the magic-byte content kind does, except that ZIP
+ *  magic is parsed as EPUB only for a .epub file. If mapping (from
+ *  ddac_conduit_map) is non-NULL, PDF, image and EPUB parsers read from
+ *  memory. conduit == NULL is identical to ddac_parse(). Neither pointer
+ *  is retained after the call. */
+ddac_parse_result_t ddac_parse_ex(void *handle, const char *input_path,
+                                  const char *output_path, int output_fmt,
+                                  uint64_t stage_flags,
+                                  const ddac_conduit_result_t *conduit,
+                                  const void *mapping);
+
+/** Content kind (0-6) ddac_parse_ex() parses path as, given the conduit's
+ *  magic-byte content_kind (so a .geotiff with TIFF magic is geospatial).
+ *  6 (unknown) for a NULL path. */
+int      ddac_resolve_kind(uint8_t content_kind, const char *path);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Checkpoint Bitmaps + Journal (resume)
+ *
+ * One dense bitmap per locale over the manifest index range (mmap'd,
+ * header + ceil(num_docs/64) u64 words) plus an append-only journal of
+ * completed (lo, count) ranges, fdatasync'd every flush_every marks and
+ * compacted into the bitmap once it grows past 4 MiB. On resume each
+ * locale merges every locale's files into a private resume bitmap, so
+ * ddac_ckpt_test() is a single bit test.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Open or create a checkpoint. keep != 0 keeps completed documents from
+ *  matching files (resume); otherwise they are reset. NULL on failure. */
+void    *ddac_ckpt_open(const char *bits_path, const char *journal_path,
+                        uint64_t num_docs, uint8_t keep, uint32_t flush_every);
+
+/** Mark document idx completed. Thread-safe. 0, or -1 on a bad index or
+ *  a failed journal append. */
+int32_t  ddac_ckpt_mark(void *ckpt, uint64_t idx);
+
+/** OR another checkpoint's files into the resume bitmap. 0, or -1 if
+ *  missing or for a different manifest. */
+int32_t  ddac_ckpt_merge(void *ckpt, const char *bits_path,
+                         const char *journal_path);
+
+/** 1 if idx is set in the resume bitmap, else 0. */
+uint8_t  ddac_ckpt_test(void *ckpt, uint64_t idx);
+
+/** Number of documents in the resume bitmap. */
+uint64_t ddac_ckpt_resume_count(void *ckpt);
+
+/** Append pending marks to the journal and compact. 0, or -1 on error. */
+int32_t  ddac_ckpt_sync(void *ckpt);
+
+/** Sync and close. Safe to call with NULL. 0, or -1 if the sync failed. */
+int32_t  ddac_ckpt_close(void *ckpt);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Streaming NDJSON Result Writer
+ *
+ * One writer per locale with a background writer thread. Each task leases
+ * a task buffer and formats lines straight from ddac_parse_result_t into
+ * it without locking; full slabs are swapped out and drained by the
+ * writer thread in large sequential writes (optionally O_DIRECT).
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Open (truncate) path. slab_bytes: per-task buffer (0 = 1 MiB).
+ *  direct != 0 requests O_DIRECT (falls back if refused). NULL on failure. */
+void    *ddac_ndjson_open(const char *path, uint32_t slab_bytes, uint8_t direct);
+
+/** Lease a task buffer (one per task). NULL on failure. */
+void    *ddac_ndjson_task_buffer(void *writer);
+
+/** Append one result line. 0, or -1 if the line was dropped. */
+int32_t  ddac_ndjson_append(void *buffer, const char *input_path,
+                            const ddac_parse_result_t *result,
+                            double parse_time_ms);
+
+/** Hand remaining lines to the writer and free the buffer (NULL-safe). */
+void     ddac_ndjson_task_release(void *buffer);
+
+/** Drain, stop the writer thread and close; release every task buffer
+ *  first. Returns lines written, or -1 if a write failed. NULL-safe. */
+int64_t  ddac_ndjson_close(void *writer);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Packed Results Container
+ *
+ * Per-locale replacement for one output file + .stages.capnp sidecar per
+ * document: append-only segment-NNNNN.dat files (extracted text and stage
+ * messages), index.bin (64-byte records: manifest index, raw SHA-256,
+ * segment, offset, length, blob kind) and results.bin (column-major row
+ * groups of ddac_parse_result_t). Merge writes a catalog of the shards'
+ * index records; segments are never copied.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Open a container in dir_path. segment_mb: roll-over size (0 = 4096).
+ *  append != 0 keeps an existing container's index, rows and segments and
+ *  adds to them (resume); 0 creates it afresh (truncate). NULL on failure. */
+void    *ddac_container_open(const char *dir_path, uint32_t segment_mb,
+                             uint8_t append);
+
+/** Route the next parse on handle into container as document doc_idx
+ *  (one parse; container == NULL clears). */
+void     ddac_set_container_doc(void *handle, void *container, uint64_t doc_idx);
+
+/** Append a result row (result_size = sizeof(ddac_parse_result_t)).
+ *  Thread-safe. 0, or -1 on failure. */
+int32_t  ddac_container_put_result(void *container, uint64_t doc_idx,
+                                   const void *result, size_t result_size);
+
+/** Blobs indexed, blob bytes and result rows added by this run; segment
+ *  files (including reopened ones). */
+void     ddac_container_stats(void *container, uint64_t *blobs, uint64_t *bytes,
+                              uint64_t *rows, uint32_t *segments);
+
+/** Flush and close (NULL-safe). 0, or -1 if any write failed. */
+int32_t  ddac_container_close(void *container);
+
+/** Catalog n shard containers' indexes into out_path. Returns index
+ *  records catalogued, or -1. */
+int64_t  ddac_container_merge(const char *out_path,
+                              const char *const *shard_dirs, uint32_t n);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Parallel Manifest Scanner
+ *
+ * The manifest is mmap'd read-only on every locale and scanned by byte
+ * range. A line belongs to the range holding its first byte, so any split
+ * of [0, ddac_manifest_bytes()) visits each entry once; per-range counts
+ * plus a prefix sum give each range's first entry index. Blank lines and
+ * '#' comments are not entries.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** One manifest entry. path/kind point into the mapping (not
+ *  NUL-terminated) and live until ddac_manifest_close(). path_len == 0:
+ *  NDJSON line without a path. */
+typedef struct ddac_manifest_entry_t {
+    const char *path;
+    uint32_t    path_len;
+    uint32_t    kind_len;
+    const char *kind;
+    int64_t     size;         /* bytes, -1 if absent */
+    int64_t     mtime;        /* Unix seconds, -1 if absent */
+} ddac_manifest_entry_t;
+
+_Static_assert(sizeof(ddac_manifest_entry_t) == 40,
+    "ddac_manifest_entry_t must be 40 bytes");
+
+/** Map a manifest read-only. NULL if it cannot be opened. */
+void    *ddac_manifest_open(const char *path);
+
+/** Manifest size in bytes. */
+uint64_t ddac_manifest_bytes(void *manifest);
+
+/** Entries on lines starting in [lo, hi); also reads the range ahead. */
+uint64_t ddac_manifest_count(void *manifest, uint64_t lo, uint64_t hi);
+
+/** Next entry on a line starting in [*cursor, hi). Start with *cursor = lo.
+ *  ndjson != 0 scans NDJSON fields, else the trimmed line is the path.
+ *  1 with *out filled, 0 when the range is exhausted. */
+int32_t  ddac_manifest_next(void *manifest, uint64_t *cursor, uint64_t hi,
+                            uint8_t ndjson, ddac_manifest_entry_t *out);
+
+/** Unmap (NULL-safe). */
+void     ddac_manifest_close(void *manifest);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Isolated Parse Workers
+ *
+ * ddac_parse_ex() run in a pool of ddac-parse-worker processes. Each
+ * worker has a shared-memory slot carrying the request and the
+ * ddac_parse_result_t back. A parse past its deadline is SIGKILLed and
+ * a crashed worker costs only its document; either way a warm
+ * replacement is spawned. Creating a pool ignores SIGPIPE.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Start `workers` worker processes (worker_path: path or PATH name).
+ *  NULL if none started. */
+void    *ddac_isolate_create(const char *worker_path, uint32_t workers);
+
+/** Parse in a worker; blocks while all are busy. timeout_ms 0 = none.
+ *  neardup_verdict (may be NULL) is handed to the worker's parse as by
+ *  ddac_set_neardup_verdict (see Near-Duplicate Index).
+ *  0 = done (*result_out = worker's result); 1 = killed at the deadline;
+ *  2 = worker died (*result_out = DDAC_PARSE_ERROR, worker replaced);
+ *  -1 = no worker / path too long (*result_out untouched). */
+int32_t  ddac_isolate_parse(void *pool, const char *input_path,
+                            const char *output_path, int output_fmt,
+                            uint64_t stage_flags,
+                            const ddac_conduit_result_t *conduit_result,
+                            const struct ddac_neardup_verdict_t *neardup_verdict,
+                            uint32_t timeout_ms,
+                            ddac_parse_result_t *result_out);
+
+/** Parses killed at the deadline, worker crashes, respawns. */
+void     ddac_isolate_stats(void *pool, uint64_t *timeouts, uint64_t *crashes,
+                            uint64_t *respawns);
+
+/** Stop all workers (NULL-safe). No parse may be in flight. */
+void     ddac_isolate_free(void *pool);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Latency Metrics
+ *
+ * Per-phase latency histograms (conduit, L1/L2 lookup, parse, output,
+ * stage pipeline, each stage bit), recorded per thread without locks in
+ * log-linear microsecond buckets. Snapshots are plain bucket counts, so
+ * snapshots from several locales merge by addition.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Number of phases and buckets per phase. */
+void     ddac_metrics_layout(uint32_t *phases, uint32_t *buckets);
+
+/** Name of a phase ("parse", "stage.keywords", ...); "" if out of range. */
+const char *ddac_metrics_phase_name(uint32_t phase);
+
+/** Sum all threads into counts[phase * buckets + bucket]. Returns
+ *  phases * buckets; writes nothing if len is smaller than that. */
+size_t   ddac_metrics_snapshot(uint64_t *counts, size_t len);
+
+/** Microseconds at quantile q (0..1) of one phase's `buckets` counts
+ *  (bucket upper bound; 0 if empty). */
+double   ddac_metrics_quantile(const uint64_t *counts, uint32_t buckets, double q);
+
+/** Drop all samples recorded so far. */
+void     ddac_metrics_reset(void);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Page-Range PDF Parsing
+ *
+ * A large PDF is split into page ranges parsed in parallel, each on its
+ * own handle with its own Poppler document, then stitched into one
+ * ddac_parse_result_t and one output. With DDAC_STAGE_MULTI_LANG_OCR the
+ * scanned pages (blank text layer) of each range are OCRed in the range.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+typedef struct {
+    int32_t  status;
+    int32_t  first;          /* 0-based, clamped to the page count */
+    int32_t  last;           /* one past the last page */
+    uint32_t _pad;
+    int64_t  word_count;
+    int64_t  char_count;
+    double   parse_time_ms;
+    uint32_t ocr_pages;      /* scanned pages recognised */
+    uint32_t ocr_conf_sum;   /* sum of per-page mean confidences */
+    uint64_t ocr_words;
+    uint64_t ocr_chars;
+} ddac_page_part_t;
+
+_Static_assert(sizeof(ddac_page_part_t) == 64,
+    "ddac_page_part_t must be 64 bytes");
+
+/** Page count of a PDF, -1 if it cannot be opened. mapping as for
+ *  ddac_parse_ex() (may be NULL). */
+int32_t  ddac_pdf_page_count(const char *input_path, const void *mapping);
+
+/** Extract pages [first, last) into part_path and fill *part. Only
+ *  DDAC_STAGE_MULTI_LANG_OCR of stage_flags applies here. Returns
+ *  part->status. */
+int32_t  ddac_parse_pages(void *handle, const char *input_path,
+                          const char *part_path, int32_t first, int32_t last,
+                          uint64_t stage_flags, const void *mapping,
+                          ddac_page_part_t *part);
+
+/** Concatenate the n_parts part files (page order) into output_path (or
+ *  the bound container), delete them, sum the parts into one result and
+ *  run the stages over the whole text. A failed part fails the document. */
+ddac_parse_result_t ddac_parse_stitch(void *handle, const char *input_path,
+                                      const char *output_path,
+                                      const char *const *part_paths,
+                                      const ddac_page_part_t *parts,
+                                      uint32_t n_parts, int output_fmt,
+                                      uint64_t stage_flags,
+                                      const ddac_conduit_result_t *conduit,
+                                      const void *mapping);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Near-Duplicate Index
+ *
+ * Multi-index hashing over the 64-bit average hashes of
+ * DDAC_STAGE_NEAR_DEDUP: queries find every indexed hash within a Hamming
+ * radius (up to 15) without an all-pairs pass. A snapshot is mmap'd
+ * read-only on open; inserts after that stay in memory until saved.
+ *
+ * Across locales the index is sharded by 16-bit chunk value: a hash is
+ * inserted into the shards ddac_neardup_shards(hash, 0, ...) names (at
+ * most four), and a query within r bits visits those
+ * ddac_neardup_shards(hash, r, ...) names. The driver hashes a chunk's
+ * images before parsing it (ddac_image_ahash), checks them with one
+ * ddac_neardup_check_batch per shard, inserts them with one
+ * ddac_neardup_insert_batch per shard, and hands each parse its verdict.
+ *
+ * ddac_image_ahash decodes the image, and the parse decodes it again, so
+ * the driver only hashes images up to a size threshold (nearDupHashMaxMB)
+ * ahead of the parse. A larger image is decoded once: its parse checks
+ * and inserts it against the local shard (ddac_set_neardup_doc), which
+ * can miss a near-duplicate owned by another shard.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** A near-duplicate decision reached before the parse — 24 bytes. */
+typedef struct ddac_neardup_verdict_t {
+    uint64_t hash;           /* the image's average hash */
+    uint64_t match_doc;      /* nearest indexed document, if matched */
+    uint8_t  distance;
+    uint8_t  matched;        /* 0 = unique */
+    uint8_t  max_hamming;    /* radius the decision was made at */
+    uint8_t  _pad[5];
+} ddac_neardup_verdict_t;
+
+_Static_assert(sizeof(ddac_neardup_verdict_t) == 24,
+    "ddac_neardup_verdict_t must be 24 bytes");
+
+#define DDAC_NEARDUP_NO_MATCH 0xFF
+
+/** Empty index, or NULL. */
+void    *ddac_neardup_create(void);
+
+/** Index over the snapshot at path; NULL if missing or invalid. */
+void    *ddac_neardup_open(const char *path);
+
+/** Index hash as doc_id. Thread-safe. 0, or -1 on failure. */
+int32_t  ddac_neardup_insert(void *index, uint64_t hash, uint64_t doc_id);
+
+/** Up to max_out (at most 64) indexed hashes within max_hamming bits,
+ *  nearest first. Thread-safe. Returns the number found, -1 on NULL. */
+int32_t  ddac_neardup_query(void *index, uint64_t hash, uint8_t max_hamming,
+                            uint64_t *out_doc_ids, uint8_t *out_distances,
+                            uint32_t max_out);
+
+/** Number of indexed hashes. */
+uint64_t ddac_neardup_count(void *index);
+
+/** Write the whole index as a snapshot (temp file + rename). 0, or -1. */
+int32_t  ddac_neardup_save(void *index, const char *path);
+
+/** Shards (of n_shards) owning a chunk value within max_hamming / 4 bits
+ *  of hash's, into out_shards (room for n_shards). max_hamming 0: where
+ *  hash is inserted; the query radius: every shard a query must visit.
+ *  Returns the number written. */
+uint32_t ddac_neardup_shards(uint64_t hash, uint8_t max_hamming,
+                             uint32_t n_shards, uint32_t *out_shards);
+
+/** Nearest indexed hash of another document within max_hamming bits for
+ *  each of n hashes (distance DDAC_NEARDUP_NO_MATCH if none). Read-only,
+ *  thread-safe. Returns the number matched, -1 on NULL. */
+int32_t  ddac_neardup_check_batch(void *index, const uint64_t *hashes,
+                                  const uint64_t *doc_ids, uint32_t n,
+                                  uint8_t max_hamming, uint64_t *out_doc_ids,
+                                  uint8_t *out_distances);
+
+/** Index n hashes, skipping any its document already has. Thread-safe.
+ *  Returns the number added, or -1. */
+int32_t  ddac_neardup_insert_batch(void *index, const uint64_t *hashes,
+                                   const uint64_t *doc_ids, uint32_t n);
+
+void     ddac_neardup_free(void *index);
+
+/** Average hash of an image document, as DDAC_STAGE_NEAR_DEDUP computes it
+ *  (mapping from ddac_conduit_map, may be NULL). 0, or -1 if it cannot be
+ *  decoded or is under 8x8. */
+int32_t  ddac_image_ahash(const char *path, const void *mapping,
+                          uint64_t *out_hash);
+
+/** Check the next parse's image against index as doc_id and add it
+ *  (DDAC_STAGE_NEAR_DEDUP). Within max_hamming bits of an indexed hash it
+ *  is a near-duplicate and its OCR/ML stages are skipped. One parse;
+ *  index == NULL clears. */
+void     ddac_set_neardup_doc(void *handle, void *index, uint64_t doc_id,
+                              uint8_t max_hamming);
+
+/** Hand the next parse's image a verdict reached against a sharded index;
+ *  DDAC_STAGE_NEAR_DEDUP writes it, and a match skips the OCR/ML stages.
+ *  One parse; verdict == NULL clears. */
+void     ddac_set_neardup_verdict(void *handle,
+                                  const ddac_neardup_verdict_t *verdict);
+
+/* ═══════════════════════════════════════════════════════════════════════
+ * Stage Re-extraction
+ *
+ * Add stages to an already-processed corpus without its base parse. The
+ * L1 cache stores each document's stage mask, so the plan is a cache scan;
+ * only requested & ~existing stages run, over the extracted text read
+ * back from output_path, and are added to the existing .stages.capnp.
+ * ═══════════════════════════════════════════════════════════════════════ */
+
+/** Stages still to run: requested & ~existing. */
+uint64_t ddac_reextract_plan(uint64_t existing_mask, uint64_t requested_mask);
+
+/** Stages mask of an existing .stages.capnp file (0 if unreadable). */
+uint64_t ddac_reextract_read_mask(const char *path, size_t path_len);
+
+/** Run stage_flags over the text at output_path and add them to its
+ *  stage message in place. result is the document's earlier ParseResult
+ *  (updated: status, parse_time_ms); stages_out (optional) receives the
+ *  message's new mask. Returns 0, 2 if there is no extracted text, or 1
+ *  if the message could not be extended — parse in full then. */
+int      ddac_reextract_stages(void *handle, const char *input_path,
+                               const char *output_path, uint64_t stage_flags,
+                               ddac_parse_result_t *result, uint64_t *stages_out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,12 +1,17 @@
 // Docudactyl HPC — Checkpoint & Resume
 //
 // Enables resuming long-running HPC jobs after node failures.
-// Writes a checkpoint file every N documents (per locale) recording
-// the last successfully processed index. On restart with --resume,
-// the engine skips already-processed documents.
+// Each locale records the documents it completes in a dense bitmap over
+// the manifest index range plus an append-only binary journal of
+// completed index ranges (ffi/zig/src/checkpoint.zig). The journal is
+// appended and fdatasync'd every N documents, so a checkpoint write costs
+// O(documents since the last one); it is folded into the bitmap when it
+// grows large and at the end of the run. On restart with --resume, every
+// locale merges all locales' bitmaps into one local resume bitmap and the
+// engine skips already-processed documents with a single bit test.
 //
-// Checkpoint file: outputDir/checkpoint-{localeId}.txt
-// Format: one index per line (processed document indices)
+// Checkpoint files: outputDir/checkpoint-{localeId}.bits
+//                   outputDir/checkpoint-{localeId}.journal
 //
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
@@ -15,108 +20,116 @@ module Checkpoint {
   use IO;
   use FileSystem;
   use Config;
-  use Set;
+  use FFIBridge;
+  use BlockDist;
+  use CTypes;
+  use List;
 
-  /** How often to flush the checkpoint file (every N documents). */
+  /** How often to append to the checkpoint journal (every N documents). */
   config const checkpointIntervalDocs: int = 1000;
 
   /** Whether to resume from a previous checkpoint. */
   config const resume: bool = false;
 
-  /** Per-locale set of already-processed indices (populated on resume). */
-  var completedIndices: [0..#numLocales] set(int);
+  /** Per-locale checkpoint handle (ddac_ckpt_open), one element stored on
+      each locale so the per-document lookups stay local. */
+  const ckptDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+  var ckptHandles: [ckptDom] c_ptr(void);
 
-  /** Per-locale counter for checkpoint flushing. */
-  var docsSinceCheckpoint: [0..#numLocales] int;
-
-  /** Checkpoint file path for a locale. */
+  /** Checkpoint bitmap path for a locale. */
   proc checkpointPath(localeId: int): string {
-    return outputDir + "/checkpoint-" + localeId:string + ".txt";
+    return outputDir + "/checkpoint-" + localeId:string + ".bits";
   }
 
-  /** Load checkpoint from a previous run, if --resume is set.
-      Returns true if checkpoint was loaded. */
-  proc loadCheckpoint(): bool throws {
-    if !resume then return false;
-
-    var totalLoaded = 0;
+  /** Journal path belonging to a checkpoint bitmap path. */
+  proc journalPathFor(bitsPath: string): string {
+    return bitsPath[0..#(bitsPath.size - ".bits".size)] + ".journal";
+  }
 
-    for locId in 0..#numLocales {
-      const path = checkpointPath(locId);
-      if !exists(path) then continue;
+  /** Open every locale's checkpoint for a manifest of numDocs documents.
+      With --resume, each locale then merges every bitmap left by the
+      previous run (whatever its locale count was) into its resume bitmap.
+      Returns true if completed documents were loaded. */
+  proc loadCheckpoint(numDocs: int): bool {
+    // Fresh run: drop every old checkpoint, including those of locales
+    // this run does not have, so a later --resume sees only this run
+    var bitsFiles: list(string);
+    if resume then
+      for f in glob(outputDir + "/checkpoint-*.bits") do bitsFiles.pushBack(f);
+    else
+      try { clearCheckpoints(); } catch { }
+
+    // Pass 1: open every locale's checkpoint. Opening folds that locale's
+    // journal into its bitmap and truncates the journal, so no locale may
+    // merge until every open has finished (the coforall joins first);
+    // otherwise a merge could miss marks that were only in a journal.
+    coforall loc in Locales with (ref ckptHandles) do on loc {
+      const path = checkpointPath(here.id);
+      const h = ddac_ckpt_open(path.c_str(), journalPathFor(path).c_str(),
+                               numDocs: uint(64), resume: uint(8),
+                               checkpointIntervalDocs: uint(32));
+      if h == nil then
+        writeln("[checkpoint] Could not open ", path, " on locale ", here.id,
+                "; progress will not be recorded");
+      ckptHandles[here.id] = h;
+    }
 
-      var f = open(path, ioMode.r);
-      var reader = f.reader(locking=false);
-      var line: string;
-      while reader.readLine(line) {
-        const trimmed = line.strip();
-        if trimmed.size > 0 {
-          const idx = trimmed: int;
-          completedIndices[locId].add(idx);
-          totalLoaded += 1;
-        }
+    // Pass 2: merge the previous run's bitmaps (and any journals of
+    // locales this run does not have) into each resume bitmap
+    var totalLoaded: atomic int;
+    coforall loc in Locales do on loc {
+      const h = ckptHandles[here.id];
+      if h != nil && bitsFiles.size > 0 {
+        for f in bitsFiles do
+          ddac_ckpt_merge(h, f.c_str(), journalPathFor(f).c_str());
+        // Same union on every locale; report it once
+        if here.id == 0 then totalLoaded.write(ddac_ckpt_resume_count(h): int);
       }
     }
 
-    if totalLoaded > 0 then
-      writeln("[checkpoint] Resumed: ", totalLoaded, " documents already processed");
+    if totalLoaded.read() > 0 then
+      writeln("[checkpoint] Resumed: ", totalLoaded.read(), " documents already processed");
 
-    return totalLoaded > 0;
+    return totalLoaded.read() > 0;
   }
 
   /** Check if a document index was already processed (for resume). */
   proc isAlreadyProcessed(idx: int): bool {
     if !resume then return false;
-    // Check all locales' completed sets (document could have been
-    // processed on any locale in the previous run)
-    for locId in 0..#numLocales {
-      if completedIndices[locId].contains(idx) then return true;
-    }
-    return false;
+    // One bit test: the resume bitmap already holds every locale's
+    // completions from the previous run
+    return ddac_ckpt_test(ckptHandles[here.id], idx: uint(64)) != 0;
   }
 
   /** Record that a document was successfully processed.
-      Flushes to disk every checkpointIntervalDocs documents. */
+      Appended to the journal every checkpointIntervalDocs documents. */
   proc recordCheckpoint(idx: int) throws {
-    const locId = here.id;
-    completedIndices[locId].add(idx);
-    docsSinceCheckpoint[locId] += 1;
-
-    if docsSinceCheckpoint[locId] >= checkpointIntervalDocs {
-      flushCheckpoint(locId);
-      docsSinceCheckpoint[locId] = 0;
-    }
-  }
-
-  /** Flush all pending checkpoints for a locale to disk. */
-  proc flushCheckpoint(localeId: int) throws {
-    const path = checkpointPath(localeId);
-    var f = open(path, ioMode.cw);
-    var w = f.writer(locking=false);
-
-    for idx in completedIndices[localeId] {
-      w.writeln(idx);
-    }
-
-    w.close();
-    f.close();
+    const h = ckptHandles[here.id];
+    if h == nil then return;
+    if ddac_ckpt_mark(h, idx: uint(64)) != 0 then
+      throw new Error("checkpoint journal append failed for document " + idx:string);
   }
 
-  /** Flush all locales' checkpoints (call at end of run). */
+  /** Journal and compact all locales' checkpoints and close them (call at
+      end of run). */
   proc flushAllCheckpoints() throws {
-    for locId in 0..#numLocales {
-      if completedIndices[locId].size > 0 then
-        flushCheckpoint(locId);
+    var failed: atomic bool;
+    coforall loc in Locales with (ref ckptHandles) do on loc {
+      if ddac_ckpt_close(ckptHandles[here.id]) != 0 then failed.write(true);
+      ckptHandles[here.id] = nil;
     }
+    if failed.read() then
+      throw new Error("could not write the final checkpoint on every locale");
     writeln("[checkpoint] Saved progress for all locales");
   }
 
   /** Remove checkpoint files (call after successful completion). */
   proc clearCheckpoints() throws {
-    for locId in 0..#numLocales {
-      const path = checkpointPath(locId);
-      if exists(path) then
-        remove(path);
+    for f in glob(outputDir + "/checkpoint-*.bits") {
+      remove(f);
+      const j = journalPathFor(f);
+      if exists(j) then
+        remove(j);
     }
   }
 }
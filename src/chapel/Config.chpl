@@ -21,15 +21,27 @@ module Config {
 
   // ── Parallelism Tuning ──────────────────────────────────────────────
 
-  /** Number of documents per dynamic-iteration chunk.
+  /** Number of documents per work chunk (one conduit batch, one cache
+      read/write txn and one L2 round trip each).
       Larger = less overhead, smaller = better load balance.
       256 is a good default for mixed-size corpora. */
   config const chunkSize: int = 256;
 
-  /** Minimum chunk size for dynamic iteration.
-      Prevents degenerate single-doc chunks at tail. */
+  /** Minimum documents per cost-cut chunk (--costScheduling), unless a
+      single document already outweighs an average chunk. */
   config const minChunkSize: int = 16;
 
+  /** Cost-aware scheduling (LPT): sort each locale's documents by
+      estimated parse cost, longest first, and cut chunks of roughly equal
+      cost instead of equal count. Costs come from a per-kind model applied
+      to the manifest size/kind fields (NDJSON manifests; plain manifests
+      fall back to extension-based kinds and a nominal size). */
+  config const costScheduling: bool = true;
+
+  /** Per-kind cost model, refitted from parse timings and rewritten at the
+      end of every run. Empty = outputDir + "/cost-model.tsv". */
+  config const costModelPath: string = "";
+
   // ── Fault Tolerance ─────────────────────────────────────────────────
 
   /** Maximum retries per document before marking as failed. */
@@ -44,11 +56,62 @@ module Config {
   /** Seconds between progress reports on locale 0. */
   config const progressIntervalSec: int = 10;
 
+  /** Also write the run's per-phase latency quantiles in Prometheus text
+      format to this path (e.g. a node-exporter textfile collector
+      directory). Empty = off. */
+  config const metricsPrometheusPath: string = "";
+
   /** Timeout per document in milliseconds.
       Documents taking longer than this are abandoned.
       300000 ms = 5 minutes (generous for 1000-page manuscripts). */
   config const timeoutPerDocMs: int = 300000;
 
+  /** Parse every document in an isolated worker process
+      (ddac-parse-worker) instead of on the task's own handle.
+      timeoutPerDocMs becomes a hard deadline: the worker is killed and the
+      document fails. A parser crash costs one document, not the locale.
+      Workers parse images with their own CPU OCR (no GPU OCR
+      pre-submission) and write per-document text and stage files; with
+      --outputLayout=container only the result rows go to the container. */
+  config const isolateParse: bool = false;
+
+  /** Worker executable for --isolateParse (a path, or a name on PATH). */
+  config const parseWorkerPath: string = "ddac-parse-worker";
+
+  // ── Large PDFs ──────────────────────────────────────────────────────
+
+  /** PDFs with more pages than this are split into page ranges parsed in
+      parallel (ddac_parse_pages) and stitched into one result and one
+      output. 0 = never split. Not used with --isolateParse. */
+  config const pdfSplitPages: int = 500;
+
+  /** Pages per range of a split PDF. */
+  config const pdfPagesPerRange: int = 100;
+
+  /** Only PDFs of at least this many MB are opened to count their pages. */
+  config const pdfSplitMinMB: int = 16;
+
+  // ── Near-Duplicate Index ───────────────────────────────────────────
+
+  /** With near_dedup in the stages, every image's average hash goes into
+      one corpus-wide index sharded across the locales, and an image
+      within this many bits (0..15) of one already indexed, on any locale,
+      is reported as its near-duplicate and skips its OCR and ML stages.
+      0 = write hashes only. Requires conduitEnabled (images are found
+      from the conduit result, ddac_resolve_kind). Each locale keeps its
+      shard as neardup-{locale}.snap in the output directory, reloaded by a
+      --resume or --reextract run on the same number of locales (an image
+      never matches its own earlier entry). */
+  config const nearDupMaxHamming: int = 6;
+
+  /** Images up to this many MB are hashed before their parse so they can
+      be checked against every locale's shard; that decodes each of them
+      twice. A larger image is decoded once and checked at parse time
+      against this locale's shard only, so a near-duplicate indexed on
+      another locale can be missed (with --isolateParse it gets no
+      verdict). 0 = hash every image before its parse. */
+  config const nearDupHashMaxMB: int = 16;
+
   // ── Manifest Format ────────────────────────────────────────────────
 
   /** Manifest format:
@@ -67,6 +130,26 @@ module Config {
       Does not replace per-document output — runs alongside it. */
   config const streamOutput: bool = false;
 
+  /** Per-task NDJSON buffer size in KB. Full buffers are handed to the
+      locale's writer thread, so this is also the write size. */
+  config const ndjsonBufferKB: int = 1024;
+
+  /** Open results.ndjson with O_DIRECT (parallel filesystems such as
+      Lustre/GPFS); falls back to buffered writes where refused. */
+  config const ndjsonDirectIO: bool = false;
+
+  /** Output layout per shard:
+        "files"     — one output file (+ .stages.capnp) per document
+        "container" — append-only segment files + index.bin + columnar
+                      results.bin per shard (for parallel filesystems
+                      whose metadata servers can't take 340M small files).
+                      Cache hits get a results row; their text and stage
+                      blobs live in the container of the run that parsed them. */
+  config const outputLayout: string = "files";
+
+  /** Container segment size in MB before a new segment file is started. */
+  config const containerSegmentMB: int = 4096;
+
   // ── Multi-Locale / Cluster ─────────────────────────────────────────
 
   /** Manifest loading strategy:
@@ -83,7 +166,8 @@ module Config {
   config const cacheDir: string = "";
 
   /** Maximum cache size per locale in MB (default 10240 = 10 GB).
-      At ~1 KB per entry, 10 GB holds ~10 million cached results. */
+      Entries are ~250 bytes (path key plus a compact result record), so
+      10 GB holds ~40 million cached results. */
   config const cacheSizeMB: int = 10240;
 
   /** Cache mode:
@@ -93,6 +177,35 @@ module Config {
         "readwrite" - full caching (default when cacheDir is set) */
   config const cacheMode: string = "readwrite";
 
+  /** LMDB commit durability:
+        "sync"     - fsync on every commit (default, slowest)
+        "nosync"   - MDB_NOSYNC: commits skip fsync
+        "writemap" - MDB_WRITEMAP + MDB_MAPASYNC: write through the map
+      The relaxed modes sync every cacheSyncIntervalSec and at shutdown;
+      a crash loses at most that window and never corrupts the cache. */
+  config const cacheDurability: string = "sync";
+
+  /** Seconds between ddac_cache_sync calls when cacheDurability != "sync". */
+  config const cacheSyncIntervalSec: real = 30.0;
+
+  /** Content-addressed L1 layout: path -> sha256 index plus
+      sha256 -> result + stage blob. Survives collection moves and
+      re-mounts, and parses exact duplicates once. Uses the conduit's
+      SHA-256, and a separate per-locale environment ({cacheDir}/locale-N-cas). */
+  config const cacheContentAddressed: bool = false;
+
+  /** Map cacheDurability / cacheContentAddressed to ddac_cache_init_ex flags. */
+  proc cacheInitFlags(): uint(32) {
+    var flags: uint(32);
+    select cacheDurability {
+      when "nosync" do flags = 0x1;    // DDAC_CACHE_NOSYNC
+      when "writemap" do flags = 0x2;  // DDAC_CACHE_WRITEMAP
+      otherwise do flags = 0;
+    }
+    if cacheContentAddressed then flags |= 0x4;  // DDAC_CACHE_CONTENT
+    return flags;
+  }
+
   // ── Preprocessing Conduit ──────────────────────────────────────────
 
   /** Enable the preprocessing conduit (magic-byte detection, validation,
@@ -101,6 +214,11 @@ module Config {
       Disable only for benchmarking the raw parse path. */
   config const conduitEnabled: bool = true;
 
+  /** Single-read pipeline: the conduit mmaps each document once, hashes
+      it from the mapping and hands the same bytes to the parser
+      (PDF, image and EPUB parse from memory). Requires conduitEnabled. */
+  config const conduitMmap: bool = false;
+
   // ── ML Inference (ONNX Runtime) ───────────────────────────────────
 
   /** Enable ONNX Runtime ML inference for ML-dependent stages
@@ -113,6 +231,14 @@ module Config {
                       layout_analysis.onnx, handwriting_ocr.onnx */
   config const modelDir: string = "models/onnx";
 
+  /** Per-stage ML batching overrides, comma-separated
+      "stage=maxBatch:maxWaitUs" with stage one of ner, whisper, classify,
+      layout, handwriting (e.g. "ner=64:1000,whisper=2:50000").
+      A batch runs when maxBatch requests from concurrent tasks are queued
+      or the oldest has waited maxWaitUs. Unlisted stages keep the
+      defaults; maxBatch=1 disables batching for that stage. */
+  config const mlBatchPolicy: string = "";
+
   // ── GPU OCR Coprocessor ────────────────────────────────────────────
 
   /** Enable GPU-accelerated OCR for image documents.
@@ -122,12 +248,20 @@ module Config {
       Requires conduitEnabled=true for content-type detection. */
   config const gpuOcrEnabled: bool = true;
 
+  /** PaddleOCR inference model directory: det/ and rec/ subdirectories
+      (inference.pdmodel + inference.pdiparams each) and dict.txt. */
+  config const gpuOcrModelDir: string = "models/paddleocr";
+
   // ── I/O Prefetcher ─────────────────────────────────────────────────
 
-  /** Number of files to prefetch ahead via io_uring/fadvise.
-      Set to 0 to disable prefetching.
-      Default: 8 (good balance between memory pressure and throughput). */
-  config const prefetchWindow: int = 8;
+  /** Most files prefetched at once via io_uring/fadvise. Each task
+      queues the chunk it will parse next; the bytes in flight are bounded
+      by prefetchBudgetMB. Set to 0 to disable prefetching. */
+  config const prefetchWindow: int = 256;
+
+  /** Readahead bytes in flight per locale, in MB.
+      0 = a quarter of MemAvailable, re-read every second. */
+  config const prefetchBudgetMB: int = 0;
 
   // ── Dragonfly L2 Cache ──────────────────────────────────────────────
 
@@ -152,6 +286,19 @@ module Config {
         "0x7FF" (hex) or "2047" (decimal) */
   config const stagesConfig: string = "none";
 
+  /** Write .stages.capnp messages in Cap'n Proto packed encoding (decode
+      with `capnp decode --packed`). Typically several times smaller, as
+      most stage fields of a document are zero. Not used with --isolateParse. */
+  config const stagesPacked: bool = false;
+
+  /** Re-extraction mode: add stages to a corpus an earlier run processed.
+      A document whose L1 cache entry is current skips the base parse; only
+      the requested stages missing from the stage mask stored with the
+      entry run, over the existing extracted text, and are added to its
+      .stages.capnp in place. Needs a path-keyed cacheDir (cacheMode
+      read or readwrite) and per-document output files. */
+  config const reextract: bool = false;
+
   // ── Output Format Codes (for FFI) ──────────────────────────────────
 
   /** Map string format name to integer code for Zig FFI. */
@@ -10,6 +10,7 @@
 //   Cluster (64):   ./docudactyl-hpc --manifestPath=paths.txt -nl 64
 //   With stages:    ./docudactyl-hpc --manifestPath=paths.txt --stagesConfig=analysis
 //   With cache:     ./docudactyl-hpc --manifestPath=paths.txt --cacheDir=/tmp/ddac-cache
+//   Add a stage:    ./docudactyl-hpc --manifestPath=paths.txt --cacheDir=/tmp/ddac-cache --stagesConfig=ner --reextract=true
 //   NDJSON manifest: ./docudactyl-hpc --manifestPath=enriched.ndjson
 //   Streaming out:  ./docudactyl-hpc --manifestPath=paths.txt --streamOutput=true
 //
@@ -25,8 +26,8 @@ use FaultHandler;
 use ProgressReporter;
 use ShardedOutput;
 use ResultAggregator;
+use WorkScheduler;
 use Checkpoint;
-use DynamicIters;
 use Time;
 use CTypes;
 use Version;
@@ -34,11 +35,430 @@ use FileSystem;
 use IO;
 use Path;
 use OS.POSIX;
+use BlockDist;
+use BitOps;
 
 // Minimum Chapel version required (2.7.0 for --parse-only, begin ref intent)
 param DOCUDACTYL_MIN_CHAPEL_MAJOR = 2;
 param DOCUDACTYL_MIN_CHAPEL_MINOR = 7;
 
+/* Per-locale FFI resources. Each locale opens its own LMDB environment,
+   io_uring prefetcher, Dragonfly pool, ONNX Runtime engine, GPU OCR
+   coprocessor, warmed parse-handle pool, parse worker processes, NDJSON
+   shard writer, results container and near-duplicate index shard, so no
+   handle is ever used outside the address space that created it. Built by openResources() inside
+   `on loc`, stored in a block-distributed array with one element per
+   locale, and looked up as resources[here.id]. */
+record ResourceSet {
+  var localCacheHandle: c_ptr(void);
+  var prefetchHandle: c_ptr(void);
+  var dragonflyPool: c_ptr(void);
+  var mlHandle: c_ptr(void);
+  var gpuOcrHandle: c_ptr(void);
+  var parsePool: c_ptr(void);
+  var isolatePool: c_ptr(void);
+  var ndjsonWriter: NdjsonWriter;
+  var resultsContainer: c_ptr(void);
+  var nearDupIndex: c_ptr(void);
+}
+
+/* Path of this locale's near-duplicate index shard snapshot. */
+proc nearDupSnapshotPath(): string {
+  return outputDir + "/neardup-" + here.id:string + ".snap";
+}
+
+/* Near-duplicate verdicts for one chunk's images, against the index
+   sharded over every locale (locale s holds shard s). Each hash is
+   checked on every shard its radius reaches (ddac_neardup_shards), one
+   ddac_neardup_check_batch per shard, and against the chunk's earlier
+   images; then it is inserted into its owning shards, one
+   ddac_neardup_insert_batch per shard. The whole chunk is checked before
+   any of it is inserted, so two images never both skip their OCR as each
+   other's duplicate; two near-duplicates in chunks checked at the same
+   moment by different tasks can both come out unique. */
+proc nearDupVerdicts(const ref resources, const ref hashes: [] uint(64),
+                     const ref docIds: [] uint(64),
+                     ref verdicts: [] ddac_neardup_verdict_t) {
+  const m = hashes.size;
+  const radius = min(nearDupMaxHamming, 15): uint(8);
+  const nShards = numLocales;
+
+  // Which hashes each shard is asked about, and which it takes
+  var query, owns: [0..#nShards, 0..#m] bool;
+  var shards: [0..#nShards] uint(32);
+  for j in 0..#m {
+    const nq = ddac_neardup_shards(hashes[j], radius, nShards: uint(32), c_ptrTo(shards[0]));
+    for s in 0..#nq do query[shards[s]: int, j] = true;
+    const no = ddac_neardup_shards(hashes[j], 0, nShards: uint(32), c_ptrTo(shards[0]));
+    for s in 0..#no do owns[shards[s]: int, j] = true;
+  }
+
+  /* Run `insert` (else check) on shard s for the hashes `want` selects;
+     check results land in row s of foundDoc/foundDist. */
+  proc exchange(s: int, const ref want: [] bool, insert: bool,
+                ref foundDoc: [] uint(64), ref foundDist: [] uint(8)) {
+    var k = 0;
+    for j in 0..#m do if want[s, j] then k += 1;
+    if k == 0 then return;
+    var sel: [0..#k] int;
+    var selHashes, selDocs, outDocs: [0..#k] uint(64);
+    var outDists: [0..#k] uint(8) = DDAC_NEARDUP_NO_MATCH;
+    var i = 0;
+    for j in 0..#m do if want[s, j] {
+      sel[i] = j;
+      selHashes[i] = hashes[j];
+      selDocs[i] = docIds[j];
+      i += 1;
+    }
+    on Locales[s] {
+      // Local copies for the FFI: one bulk transfer each way
+      var h: [0..#k] uint(64) = selHashes;
+      var d: [0..#k] uint(64) = selDocs;
+      var od: [0..#k] uint(64);
+      var odist: [0..#k] uint(8) = DDAC_NEARDUP_NO_MATCH;
+      const index = resources[here.id].nearDupIndex;
+      if index != nil {
+        if insert then
+          ddac_neardup_insert_batch(index, c_ptrTo(h[0]), c_ptrTo(d[0]), k: uint(32));
+        else
+          ddac_neardup_check_batch(index, c_ptrTo(h[0]), c_ptrTo(d[0]), k: uint(32),
+                                   radius, c_ptrTo(od[0]), c_ptrTo(odist[0]));
+      }
+      if !insert {
+        outDocs = od;
+        outDists = odist;
+      }
+    }
+    if !insert then
+      for i in 0..#k {
+        foundDoc[s, sel[i]] = outDocs[i];
+        foundDist[s, sel[i]] = outDists[i];
+      }
+  }
+
+  // Check on every shard at once
+  var foundDoc: [0..#nShards, 0..#m] uint(64);
+  var foundDist: [0..#nShards, 0..#m] uint(8) = DDAC_NEARDUP_NO_MATCH;
+  coforall s in 0..#nShards with (ref foundDoc, ref foundDist) do
+    exchange(s, query, false, foundDoc, foundDist);
+
+  // Nearest over the shards and the chunk's earlier images
+  for j in 0..#m {
+    var bestDoc: uint(64);
+    var bestDist = DDAC_NEARDUP_NO_MATCH;
+    for s in 0..#nShards do
+      if foundDist[s, j] < bestDist {
+        bestDist = foundDist[s, j];
+        bestDoc = foundDoc[s, j];
+      }
+    for e in 0..#j {
+      const dist = popCount(hashes[j] ^ hashes[e]): uint(8);
+      if docIds[e] != docIds[j] && dist <= radius && dist < bestDist {
+        bestDist = dist;
+        bestDoc = docIds[e];
+      }
+    }
+    ref v = verdicts[j];
+    v.hash = hashes[j];
+    v.max_hamming = radius;
+    v.matched = (bestDist != DDAC_NEARDUP_NO_MATCH): uint(8);
+    v.match_doc = bestDoc;
+    v.distance = bestDist;
+  }
+
+  // Then index the chunk on each hash's owning shards
+  coforall s in 0..#nShards with (ref foundDoc, ref foundDist) do
+    exchange(s, owns, true, foundDoc, foundDist);
+}
+
+/* Open this locale's resources. parsePool is nil if the pool failed. */
+proc openResources(cacheEnabled: bool): ResourceSet {
+  var res: ResourceSet;
+
+  // ── LMDB cache ─────────────────────────────────────────────────────
+  // Each locale gets its own LMDB environment to avoid cross-locale
+  // write contention. Reads are zero-copy and fully concurrent.
+  if cacheEnabled {
+    // Create per-locale cache directory
+    // The content-addressed layout lives in its own environment
+    const localeCacheDir = cacheDir + "/locale-" + here.id:string +
+                           (if cacheContentAddressed then "-cas" else "");
+    try {
+      mkdir(localeCacheDir, parents=true);
+    } catch {
+      writeln("[warn] Cannot create cache dir: ", localeCacheDir);
+    }
+
+    res.localCacheHandle = ddac_cache_init_ex(localeCacheDir.c_str(), cacheSizeMB: uint(64),
+                                              cacheInitFlags());
+    if res.localCacheHandle == nil {
+      writeln("[warn] LMDB cache init failed for locale ", here.id, " — running without cache");
+    } else {
+      const count = ddac_cache_count(res.localCacheHandle);
+      writeln("[cache] Locale ", here.id, ": ", count, " cached entries");
+    }
+  }
+
+  // ── I/O prefetcher ─────────────────────────────────────────────────
+  if prefetchWindow > 0 {
+    res.prefetchHandle = ddac_prefetch_init_ex(prefetchWindow: uint(32),
+                                               prefetchBudgetMB: uint(64));
+    if res.prefetchHandle == nil then
+      writeln("[warn] I/O prefetcher init failed on locale ", here.id, " — running without prefetch");
+    else if here.id == 0 then
+      writeln("[prefetch] Next chunk ahead, up to ", prefetchWindow, " files, ",
+              if prefetchBudgetMB > 0 then prefetchBudgetMB: string + " MB"
+              else "1/4 of MemAvailable", " in flight (io_uring/fadvise)");
+  }
+
+  // ── Dragonfly L2 cache (one server, one pool per locale) ───────────
+  // One pooled connection per worker task: each chunk leases its own
+  // socket for a single MGET and a single pipelined SET burst.
+  if dragonflyAddr != "" {
+    res.dragonflyPool = ddac_dragonfly_pool_create(dragonflyAddr.c_str(),
+                                                   here.maxTaskPar: uint(32));
+    if res.dragonflyPool == nil {
+      writeln("[warn] Dragonfly connection failed on locale ", here.id, " (",
+              dragonflyAddr, ") — running without L2 cache");
+    } else if here.id == 0 {
+      const l2Count = ddac_dragonfly_pool_count(res.dragonflyPool);
+      writeln("[cache-l2] Connected to Dragonfly: ", l2Count, " cached entries (",
+              ddac_dragonfly_pool_size(res.dragonflyPool), " connections per locale)");
+    }
+  }
+
+  // ── ML inference engine ────────────────────────────────────────────
+  if mlEnabled {
+    res.mlHandle = ddac_ml_init();
+    if res.mlHandle == nil {
+      writeln("[warn] ML inference init failed on locale ", here.id, " — ML stages will be skipped");
+    } else {
+      ddac_ml_set_model_dir(res.mlHandle, modelDir.c_str());
+      // Per-stage batching overrides (--mlBatchPolicy)
+      for item in mlBatchPolicy.split(",", ignoreEmpty=true) {
+        const stageAndPolicy = item.strip().split("=");
+        const sizeAndWait = stageAndPolicy[stageAndPolicy.size - 1].split(":");
+        var stageId = -1;
+        for id in mlStageNames.domain do
+          if mlStageNames[id] == stageAndPolicy[0] then stageId = id;
+        try {
+          if stageId < 0 || stageAndPolicy.size != 2 || sizeAndWait.size != 2 then
+            throw new IllegalArgumentError(item);
+          ddac_ml_set_batch_policy(res.mlHandle, stageId: uint(8),
+                                   sizeAndWait[0]: uint(32), sizeAndWait[1]: uint(32));
+        } catch {
+          if here.id == 0 then
+            writeln("[warn] mlBatchPolicy: ignoring '", item, "'");
+        }
+      }
+      const mlAvail = ddac_ml_available(res.mlHandle);
+      if mlAvail == 1 {
+        const provName = ddac_ml_provider_name(res.mlHandle);
+        writeln("[ml] Locale ", here.id, ": ONNX Runtime ",
+                string.createCopyingBuffer(provName:c_ptrConst(c_char)),
+                " | models: ", modelDir);
+      } else {
+        writeln("[warn] ONNX Runtime not found on locale ", here.id,
+                " — ML stages will return status=4");
+      }
+    }
+  }
+
+  // ── GPU OCR coprocessor ────────────────────────────────────────────
+  if gpuOcrEnabled && conduitEnabled {
+    res.gpuOcrHandle = ddac_gpu_ocr_init();
+    if res.gpuOcrHandle == nil {
+      writeln("[warn] GPU OCR init failed on locale ", here.id,
+              " — using CPU Tesseract for all images");
+    } else {
+      const backendId = ddac_gpu_ocr_backend(res.gpuOcrHandle);
+      const backendName = if backendId == 0 then "PaddleOCR (CUDA/TensorRT)"
+                          else if backendId == 1 then "Tesseract CUDA"
+                          else "CPU only (no GPU detected)";
+      ddac_gpu_ocr_set_model_dir(res.gpuOcrHandle, gpuOcrModelDir.c_str());
+      const maxBatch = ddac_gpu_ocr_max_batch();
+      writeln("[gpu-ocr] Locale ", here.id, ": ", backendName, " | batch size: ", maxBatch);
+    }
+  }
+
+  // ── Warm parse handle pool ─────────────────────────────────────────
+  // One warmed handle per worker task: Tesseract/GDAL/vips are initialised
+  // here once, not per document. ML and GPU OCR are bound to every pooled
+  // handle up front so the hot loop never re-attaches them.
+  res.parsePool = ddac_pool_create(here.maxTaskPar: uint(32));
+  if res.parsePool == nil {
+    writeln("[FATAL] Parse handle pool init failed on locale ", here.id);
+    return res;
+  }
+  ddac_pool_bind(res.parsePool, res.mlHandle, res.gpuOcrHandle);
+  if stagesPacked then ddac_pool_set_stages_packed(res.parsePool, 1: c_int);
+  writeln("[pool] Locale ", here.id, ": ", ddac_pool_size(res.parsePool),
+          " warmed parse handles");
+
+  // ── Isolated parse workers (--isolateParse) ────────────────────────
+  // The pooled handles stay for parses no worker can take
+  if isolateParse {
+    res.isolatePool = ddac_isolate_create(parseWorkerPath.c_str(),
+                                          here.maxTaskPar: uint(32));
+    if res.isolatePool == nil then
+      writeln("[warn] Cannot start ", parseWorkerPath, " on locale ", here.id,
+              "; parsing in-process");
+    else
+      writeln("[isolate] Locale ", here.id, ": ", here.maxTaskPar,
+              " parse worker processes");
+  }
+
+  // ── Streaming NDJSON writer (this locale's shard) ──────────────────
+  if streamOutput {
+    res.ndjsonWriter = initNdjsonWriter(shardDir(here.id));
+    writeln("[stream] NDJSON streaming output enabled for locale ", here.id);
+  }
+
+  // ── Packed results container (--outputLayout=container) ────────────
+  // Appended to, never truncated, whenever documents can be finished
+  // without writing their blobs again: skipped by --resume, or served
+  // from the L1/L2 cache
+  if outputLayout == "container" {
+    const cacheServes = (cacheEnabled && (cacheMode == "read" || cacheMode == "readwrite")) ||
+                        dragonflyAddr != "";
+    const append = resume || cacheServes;
+    res.resultsContainer = ddac_container_open(shardDir(here.id).c_str(),
+                                               containerSegmentMB: uint(32),
+                                               append: uint(8));
+    if res.resultsContainer == nil then
+      writeln("[warn] Cannot open results container in ", shardDir(here.id),
+              "; writing per-document files");
+  }
+
+  // ── Near-duplicate index shard (near_dedup stage) ──────────────────
+  // This locale's shard of the corpus-wide index (nearDupVerdicts). A
+  // resumed or re-extracting run reopens the previous run's snapshot so
+  // it keeps recognising the images already done; a fresh run starts empty
+  if (parseStagesMask() & STAGE_NEAR_DEDUP) != 0 && nearDupMaxHamming > 0 && conduitEnabled {
+    if resume || reextract then
+      res.nearDupIndex = ddac_neardup_open(nearDupSnapshotPath().c_str());
+    if res.nearDupIndex == nil then
+      res.nearDupIndex = ddac_neardup_create();
+    if res.nearDupIndex == nil then
+      writeln("[warn] Near-duplicate index init failed on locale ", here.id,
+              "; writing hashes only");
+    else
+      writeln("[neardup] Locale ", here.id, ": shard ", here.id, " of ", numLocales, ", ",
+              ddac_neardup_count(res.nearDupIndex), " indexed image hashes (radius ",
+              nearDupMaxHamming, " bits)");
+  }
+
+  return res;
+}
+
+/* Flush, report and free this locale's resources. */
+proc ref ResourceSet.close() {
+  if streamOutput then ndjsonWriter.close();
+
+  // Flush the results container's index and last row group
+  if resultsContainer != nil {
+    var blobs, blobBytes, rows: uint(64);
+    var segments: uint(32);
+    ddac_container_stats(resultsContainer, c_ptrTo(blobs), c_ptrTo(blobBytes),
+                         c_ptrTo(rows), c_ptrTo(segments));
+    if ddac_container_close(resultsContainer) != 0 then
+      writeln("[warn] Results container on locale ", here.id, " is incomplete (write error)");
+    writeln("[container] Locale ", here.id, ": ", rows, " rows, ", blobs,
+            " blobs (", blobBytes / (1024 * 1024), " MB) in ", segments, " segments");
+  }
+
+  // Persist the near-duplicate index for the next run
+  if nearDupIndex != nil {
+    if ddac_neardup_save(nearDupIndex, nearDupSnapshotPath().c_str()) != 0 then
+      writeln("[warn] Cannot save near-duplicate index on locale ", here.id);
+    writeln("[neardup] Locale ", here.id, ": ", ddac_neardup_count(nearDupIndex),
+            " indexed image hashes after run");
+    ddac_neardup_free(nearDupIndex);
+  }
+
+  // Sync and close cache
+  if localCacheHandle != nil {
+    ddac_cache_sync(localCacheHandle);
+    const finalCount = ddac_cache_count(localCacheHandle);
+    writeln("[cache] Locale ", here.id, ": ", finalCount, " entries after run");
+    ddac_cache_free(localCacheHandle);
+  }
+
+  // Stop parse workers
+  if isolatePool != nil {
+    var timeouts, crashes, respawns: uint(64);
+    ddac_isolate_stats(isolatePool, c_ptrTo(timeouts), c_ptrTo(crashes),
+                       c_ptrTo(respawns));
+    writeln("[isolate] Locale ", here.id, ": ", timeouts, " killed at deadline, ",
+            crashes, " worker crashes, ", respawns, " respawns");
+    ddac_isolate_free(isolatePool);
+  }
+
+  // Release warmed parse handles (ML/GPU OCR handles are freed below)
+  if parsePool != nil then
+    ddac_pool_free(parsePool);
+
+  // Close I/O prefetcher
+  if prefetchHandle != nil then
+    ddac_prefetch_free(prefetchHandle);
+
+  // Close Dragonfly L2 pool (the server is shared; report its count once)
+  if dragonflyPool != nil {
+    if here.id == 0 {
+      const l2Final = ddac_dragonfly_pool_count(dragonflyPool);
+      writeln("[cache-l2] Dragonfly: ", l2Final, " entries after run");
+    }
+    ddac_dragonfly_pool_free(dragonflyPool);
+  }
+
+  // Close GPU OCR coprocessor and print stats
+  if gpuOcrHandle != nil {
+    var gpuSubmitted, gpuCompleted, gpuBatches, gpuTimeUs: uint(64);
+    ddac_gpu_ocr_stats(gpuOcrHandle,
+      c_ptrTo(gpuSubmitted), c_ptrTo(gpuCompleted),
+      c_ptrTo(gpuBatches), c_ptrTo(gpuTimeUs));
+    writeln("[gpu-ocr] Locale ", here.id, ": ", gpuSubmitted, " submitted, ",
+            gpuCompleted, " completed, ", gpuBatches, " batches, ",
+            gpuTimeUs / 1000, "ms GPU time");
+    ddac_gpu_ocr_free(gpuOcrHandle);
+  }
+
+  // Close ML inference engine
+  if mlHandle != nil {
+    var mlInferences, mlTimeUs: uint(64);
+    ddac_ml_stats(mlHandle, c_ptrTo(mlInferences), c_ptrTo(mlTimeUs));
+    if mlInferences > 0 then
+      writeln("[ml] Locale ", here.id, ": ", mlInferences, " inferences, ",
+              mlTimeUs / 1000, "ms total");
+    for stageId in mlStageNames.domain {
+      var batches, items, waitUs, maxWaitUs: uint(64);
+      var maxBatch: uint(32);
+      ddac_ml_queue_stats(mlHandle, stageId: uint(8),
+        c_ptrTo(batches), c_ptrTo(items), c_ptrTo(waitUs),
+        c_ptrTo(maxWaitUs), c_ptrTo(maxBatch));
+      if batches == 0 then continue;
+      writeln("[ml] Locale ", here.id, " ", mlStageNames[stageId], ": ", batches,
+              " batches, ", (100.0 * items / (batches * maxBatch)): int,
+              "% occupancy, queue wait ", waitUs / items, "us mean / ",
+              maxWaitUs, "us max");
+    }
+    ddac_ml_free(mlHandle);
+  }
+}
+
+/* Page count of a PDF to split into page ranges, or 0 to parse it whole.
+   Only PDFs of at least pdfSplitMinMB are opened to count their pages. */
+proc splitPageCount(inputPath: string, conduit: c_ptrConst(ddac_conduit_result_t),
+                    mapping: c_ptrConst(void), fileSize: int): int {
+  if pdfSplitPages <= 0 then return 0;
+  const isPdf = if conduit != nil && conduit.deref().content_kind != 6
+                  then conduit.deref().content_kind == 0
+                  else detectContentType(inputPath) == ContentKind.PDF;
+  if !isPdf || fileSize < pdfSplitMinMB * 1024 * 1024 then return 0;
+  const pages = ddac_pdf_page_count(inputPath.c_str(), mapping);
+  return if pages > pdfSplitPages then pages else 0;
+}
+
 proc main() throws {
   // ── Version checks ────────────────────────────────────────────────
   if chplVersion.major < DOCUDACTYL_MIN_CHAPEL_MAJOR ||
@@ -58,14 +478,26 @@ proc main() throws {
   const cacheRead = cacheEnabled && (cacheMode == "read" || cacheMode == "readwrite");
   const cacheWrite = cacheEnabled && (cacheMode == "write" || cacheMode == "readwrite");
 
+  // --reextract plans from the stage masks in path-keyed L1 entries and
+  // extends per-document .stages.capnp files
+  const reextractMode = reextract && stagesMask != STAGE_NONE && cacheRead &&
+                        !cacheContentAddressed && outputLayout != "container";
+  if reextract && !reextractMode then
+    writeln("[warn] --reextract needs stages, a readable path-keyed cache and ",
+            "per-document output files — running a full extraction");
+
   writeln("═══════════════════════════════════════════════════════════");
   writeln("  Docudactyl HPC Engine");
   writeln("  Locales: ", numLocales, "  |  Manifest: ", manifestPath);
   writeln("  Output:  ", outputDir, " (", outputFormat, ")");
   if stagesMask != STAGE_NONE then
     writeln("  Stages:  ", stagesConfig, " (mask=0x", stagesMask:string, ")");
+  if reextractMode then
+    writeln("  Re-extract: cached documents run only their missing stages");
   if cacheEnabled then
-    writeln("  Cache L1: ", cacheDir, " (mode=", cacheMode, ", max=", cacheSizeMB, "MB/locale)");
+    writeln("  Cache L1: ", cacheDir, " (mode=", cacheMode, ", max=", cacheSizeMB,
+            "MB/locale, durability=", cacheDurability,
+            (if cacheContentAddressed then ", content-addressed" else ""), ")");
   if dragonflyAddr != "" then
     writeln("  Cache L2: Dragonfly @ ", dragonflyAddr, " (TTL=", dragonflyTTL, "s)");
   if manifestFormat != "auto" then
@@ -74,12 +506,20 @@ proc main() throws {
     writeln("  Streaming: NDJSON (results.ndjson per shard)");
   if manifestMode != "shared" then
     writeln("  Manifest mode: ", manifestMode);
+  if outputLayout == "container" then
+    writeln("  Output layout: packed container (", containerSegmentMB, " MB segments)");
+  if costScheduling then
+    writeln("  Scheduling: LPT by estimated cost (chunks of ", minChunkSize,
+            "..", chunkSize, " docs)");
   if conduitEnabled then
-    writeln("  Conduit: magic-byte detection + SHA-256 pre-compute");
+    writeln("  Conduit: magic-byte detection + SHA-256 pre-compute",
+            if conduitMmap then " (mmap, single read)" else "");
   if mlEnabled then
     writeln("  ML stages: ONNX Runtime (models: ", modelDir, ")");
   if gpuOcrEnabled then
     writeln("  GPU OCR: enabled (auto-detect backend)");
+  if isolateParse then
+    writeln("  Isolation: worker processes (hard deadline ", timeoutPerDocMs, " ms)");
   writeln("  Chapel: ", chplVersion);
   writeln("═══════════════════════════════════════════════════════════");
   writeln();
@@ -92,89 +532,6 @@ proc main() throws {
   const cryptoName = ddac_crypto_sha256_name();
   writeln("[crypto] SHA-256: ", string.createCopyingBuffer(cryptoName:c_ptrConst(c_char)));
 
-  // ── Initialise LMDB cache (per locale) ─────────────────────────────
-  // Each locale gets its own LMDB environment to avoid cross-locale
-  // write contention. Reads are zero-copy and fully concurrent.
-
-  var localCacheHandle: c_ptr(void) = nil;
-
-  if cacheEnabled {
-    // Create per-locale cache directory
-    const localeCacheDir = cacheDir + "/locale-" + here.id:string;
-    try {
-      mkdir(localeCacheDir, parents=true);
-    } catch {
-      writeln("[warn] Cannot create cache dir: ", localeCacheDir);
-    }
-
-    localCacheHandle = ddac_cache_init(localeCacheDir.c_str(), cacheSizeMB: uint(64));
-    if localCacheHandle == nil {
-      writeln("[warn] LMDB cache init failed for locale ", here.id, " — running without cache");
-    } else {
-      const count = ddac_cache_count(localCacheHandle);
-      writeln("[cache] Locale ", here.id, ": ", count, " cached entries");
-    }
-  }
-
-  // ── Initialise I/O prefetcher (per locale) ─────────────────────────
-  var prefetchHandle: c_ptr(void) = nil;
-  if prefetchWindow > 0 {
-    prefetchHandle = ddac_prefetch_init(prefetchWindow: uint(32));
-    if prefetchHandle == nil then
-      writeln("[warn] I/O prefetcher init failed — running without prefetch");
-    else
-      writeln("[prefetch] Window: ", prefetchWindow, " files ahead (io_uring/fadvise)");
-  }
-
-  // ── Initialise Dragonfly L2 cache (shared across locales) ──────────
-  var dragonflyHandle: c_ptr(void) = nil;
-  const dragonflyEnabled = dragonflyAddr != "";
-
-  if dragonflyEnabled {
-    dragonflyHandle = ddac_dragonfly_connect(dragonflyAddr.c_str());
-    if dragonflyHandle == nil {
-      writeln("[warn] Dragonfly connection failed (", dragonflyAddr, ") — running without L2 cache");
-    } else {
-      const l2Count = ddac_dragonfly_count(dragonflyHandle);
-      writeln("[cache-l2] Connected to Dragonfly: ", l2Count, " cached entries");
-    }
-  }
-
-  // ── Initialise ML inference engine (per locale) ──────────────────
-  var mlHandle: c_ptr(void) = nil;
-  if mlEnabled {
-    mlHandle = ddac_ml_init();
-    if mlHandle == nil {
-      writeln("[warn] ML inference init failed — ML stages will be skipped");
-    } else {
-      ddac_ml_set_model_dir(mlHandle, modelDir.c_str());
-      const mlAvail = ddac_ml_available(mlHandle);
-      if mlAvail == 1 {
-        const provName = ddac_ml_provider_name(mlHandle);
-        writeln("[ml] ONNX Runtime: ", string.createCopyingBuffer(provName:c_ptrConst(c_char)),
-                " | models: ", modelDir);
-      } else {
-        writeln("[warn] ONNX Runtime not found — ML stages will return status=4");
-      }
-    }
-  }
-
-  // ── Initialise GPU OCR coprocessor (per locale) ──────────────────
-  var gpuOcrHandle: c_ptr(void) = nil;
-  if gpuOcrEnabled && conduitEnabled {
-    gpuOcrHandle = ddac_gpu_ocr_init();
-    if gpuOcrHandle == nil {
-      writeln("[warn] GPU OCR init failed — using CPU Tesseract for all images");
-    } else {
-      const backendId = ddac_gpu_ocr_backend(gpuOcrHandle);
-      const backendName = if backendId == 0 then "PaddleOCR (CUDA/TensorRT)"
-                          else if backendId == 1 then "Tesseract CUDA"
-                          else "CPU only (no GPU detected)";
-      const maxBatch = ddac_gpu_ocr_max_batch();
-      writeln("[gpu-ocr] Backend: ", backendName, " | batch size: ", maxBatch);
-    }
-  }
-
   // ── Load manifest ─────────────────────────────────────────────────
   var docEntries = loadManifest(manifestPath);
   const totalDocs = docEntries.size;
@@ -183,18 +540,28 @@ proc main() throws {
   initShards();
   resetStats();
   resetFaultCounters();
-
-  // ── Initialise streaming NDJSON writer (per locale) ───────────────
-  var ndjsonWriter: NdjsonWriter;
-  if streamOutput {
-    ndjsonWriter = initNdjsonWriter(shardDir(here.id));
-    writeln("[stream] NDJSON streaming output enabled for locale ", here.id);
+  resetLatency();
+
+  // ── Per-locale resources ──────────────────────────────────────────
+  // Every locale opens its own cache, prefetcher, L2 pool, ML engine,
+  // GPU OCR coprocessor, parse-handle pool and NDJSON shard writer.
+  const resourceDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+  var resources: [resourceDom] ResourceSet;
+  var poolFailed: atomic bool;
+  coforall loc in Locales with (ref resources) do on loc {
+    resources[here.id] = openResources(cacheEnabled);
+    if resources[here.id].parsePool == nil then poolFailed.write(true);
   }
+  if poolFailed.read() then return;
 
   // ── Resume from checkpoint if --resume is set ─────────────────────
-  loadCheckpoint();
+  loadCheckpoint(totalDocs);
 
   initProgress(totalDocs);
+  const modelPath = if costModelPath != "" then costModelPath
+                    else outputDir + "/cost-model.tsv";
+  loadCostModel(modelPath);
+  initScheduler(docEntries);
 
   // ── Start timer and background progress reporter ──────────────────
   var timer: stopwatch;
@@ -202,285 +569,554 @@ proc main() throws {
   begin with (ref timer) reportLoop(timer);
 
   // ── Main processing loop ──────────────────────────────────────────
-  // Dynamic iteration: Chapel distributes chunks across locales,
-  // balancing 2-page pamphlets next to 1000-page manuscripts.
+  // Each locale works through its own block of the manifest with its own
+  // ResourceSet. There, one task per core pulls chunks from the locale's
+  // queue: with --costScheduling the block is ordered longest estimated
+  // parse first and cut into chunks of roughly equal cost, so a
+  // 1000-page manuscript never starts last behind thousands of pamphlets;
+  // a locale that runs dry steals the costliest tail (WorkScheduler).
+  // Each task claims its next chunk before parsing the current one, so
+  // that chunk's conduit batch (io_uring reads + hashing) runs in the
+  // background. Each chunk is processed in passes so that cache traffic
+  // is batched: one LMDB read txn + one write txn and one Dragonfly
+  // MGET + one pipelined SET burst per chunk.
 
   const fmtCode = outputFormatCode();
   const resultSize: c_size_t = 952; // sizeof(ddac_parse_result_t)
+  const relaxedCacheSync = cacheDurability != "sync";
+  const conduitBatched = conduitEnabled && !conduitMmap;
+
+  coforall loc in Locales with (ref resources) do on loc {
+    // This locale's handles and chunk queue: documents are parsed against
+    // node-local caches and shards (stolen chunks included)
+    ref res = resources[here.id];
+    const localCacheHandle = res.localCacheHandle;
+    const prefetchHandle = res.prefetchHandle;
+    const dragonflyPool = res.dragonflyPool;
+    const gpuOcrHandle = res.gpuOcrHandle;
+    const parsePool = res.parsePool;
+    const resultsContainer = res.resultsContainer;
+    const isolatePool = res.isolatePool;
+    const nearDupIndex = res.nearDupIndex;
+
+    const queue = localQueue();
+    var lastCacheSync: atomic real;
+    var syncClock: stopwatch;
+    syncClock.start();
+
+    /* Claim the next chunk (own, or stolen from a busier locale), queue
+       its files for prefetch and start its conduit batch on the task's
+       handle; nil when no locale has work left. Tasks claim one chunk
+       ahead, so the prefetcher reads chunk N+1 while chunk N is parsed. */
+    proc claimChunk(handle: c_ptr(void)): owned ConduitBlock? {
+      const docIdx = nextChunk(queue);
+      if docIdx.size == 0 then return nil;
+
+      if prefetchHandle != nil {
+        var hintStrs: [0..#docIdx.size] string;
+        var hintPaths: [0..#docIdx.size] c_ptrConst(c_char);   // nil = skip
+        for i in 0..#docIdx.size {
+          if isAlreadyProcessed(docIdx[i]) then continue;
+          hintStrs[i] = docEntries[docIdx[i]].path;   // local copy for c_str
+          hintPaths[i] = hintStrs[i].c_str();
+        }
+        ddac_prefetch_submit(prefetchHandle, c_ptrTo(hintPaths[0]), docIdx.size: uint(32));
+      }
 
-  forall idx in dynamic(docEntries.domain, chunkSize) with (ref ndjsonWriter) {
-    // Each task gets its own FFI handle (owns Tesseract/GDAL contexts)
-    var handle = ddac_init();
-    defer ddac_free(handle);
-
-    if handle == nil {
-      writeln("[error] ddac_init failed on locale ", here.id);
-      recordFailure();
-      recordCompletion();
-      continue;
+      var block = new ConduitBlock(docIdx);
+      if conduitBatched {
+        for i in 0..#block.n do
+          if !isAlreadyProcessed(docIdx[i]) then
+            block.setPath(i, docEntries[docIdx[i]].path);
+        block.start(handle);
+      }
+      return block;
     }
 
-    // Attach ML and GPU OCR subsystem handles so ddac_parse can use them
-    if mlHandle != nil then
-      ddac_set_ml_handle(handle, mlHandle);
-    if gpuOcrHandle != nil then
-      ddac_set_gpu_ocr_handle(handle, gpuOcrHandle);
-
-    // Skip if already processed in a previous run (--resume)
-    if isAlreadyProcessed(idx) {
-      recordCompletion();
-      continue;
+    /* Release the prefetch slot of document idx when it is dropped without
+       being processed: claimChunk hinted every document not already done,
+       and each hint holds a window slot, budget bytes and an open fd until
+       ddac_prefetch_done. */
+    proc releaseHint(idx: int) {
+      if prefetchHandle == nil || isAlreadyProcessed(idx) then return;
+      const path = docEntries[idx].path;   // local copy for c_str
+      ddac_prefetch_done(prefetchHandle, path.c_str());
     }
 
-    // Check for abort before processing
-    if shouldAbort() {
-      recordCompletion();
-      continue;
-    }
+    coforall tid in 0..#here.maxTaskPar {
+      // Each task leases one warmed FFI handle from the pool for its whole
+      // lifetime (owns Tesseract/GDAL contexts); released when the task ends
+      var lease = new PooledHandle(parsePool);
+      const handle = lease.handle;
+      // ...and one NDJSON buffer (drained by the locale's writer thread)
+      var ndjsonBuf = new NdjsonTaskBuffer(res.ndjsonWriter);
+
+      var ahead = claimChunk(handle);
+      while ahead != nil {
+        var current = ahead;     // takes ownership; ahead is now nil
+        ahead = claimChunk(handle);    // its conduit batch overlaps this chunk's parse
+        const block = current!;
+        const n = block.n;
+
+        if handle == nil {
+          writeln("[error] ddac_pool_acquire failed on locale ", here.id);
+          for i in 0..#n {
+            recordFailure();
+            recordCompletion();
+            releaseHint(block.docIdx[i]);
+          }
+          continue;
+        }
 
-    const entry = docEntries[idx];
-    const inputPath = entry.path;
-    const outPath = outputPathFor(inputPath);
-
-    // Prefetch hint — tell kernel to start loading this file into page cache
-    if prefetchHandle != nil then
-      ddac_prefetch_hint(prefetchHandle, inputPath.c_str());
-
-    // ── Conduit pre-processing ─────────────────────────────────────
-    // Lightweight validation + magic-byte detection + SHA-256 pre-computation.
-    // Runs before the full parse to:
-    //   1. Skip invalid/empty/missing files early (no Tesseract/Poppler init)
-    //   2. Provide SHA-256 for L2 Dragonfly lookup even on cold runs
-    //   3. Record content type from magic bytes (more accurate than extension)
-    //   4. Capture file size without a separate stat() call
-
-    var conduitResult: ddac_conduit_result_t;
-    var conduitValid = false;
-
-    if conduitEnabled {
-      const conduitRc = ddac_conduit_process(
-        inputPath.c_str(),
-        c_ptrTo(conduitResult): c_ptr(void)
-      );
-
-      // Skip invalid files — conduit detected a problem before the expensive parse
-      if conduitRc != 0 {
-        if conduitResult.validation == 1 then
-          writeln("[skip] Not found: ", inputPath);
-        else if conduitResult.validation == 2 then
-          writeln("[skip] Empty: ", inputPath);
-        else
-          writeln("[skip] Unreadable: ", inputPath);
-        recordFailure();
-        recordCompletion();
-        if prefetchHandle != nil then
-          ddac_prefetch_done(prefetchHandle, inputPath.c_str());
-        continue;
-      }
+        // ── Per-chunk working set (parallel arrays, slot i = block.docIdx[i]) ──
+        var active: [0..#n] bool;
+        var entries: [0..#n] DocEntry;
+        var outPaths: [0..#n] string;
+        var pathPtrs: [0..#n] c_ptrConst(c_char);   // nil for inactive slots
+        var mtimes: [0..#n] int(64) = -1;
+        var fsizes: [0..#n] int(64) = -1;
+        ref conduitResults = block.results;
+        var conduitValid: [0..#n] bool;
+        ref conduitMappings = block.mappings;          // unmapped with the block
+        var results: [0..#n] ddac_parse_result_t;
+        var stageMasks: [0..#n] uint(64);      // stages each L1 entry holds
+        var missingStages: [0..#n] uint(64);   // --reextract: stages to add
+        const bitmapBytes = (n + 7) / 8;
+        var hitBits: [0..#bitmapBytes] uint(8);
+        var storeBits: [0..#bitmapBytes] uint(8);
+        var shaPtrs: [0..#n] c_ptrConst(c_char);    // L2 keys; nil = skip slot
+        var l2HitBits: [0..#bitmapBytes] uint(8);
+        var l2StoreBits: [0..#bitmapBytes] uint(8);
+        // Content-addressed L1 (--cacheContentAddressed) only
+        var casShaPtrs: [0..#n] c_ptrConst(c_char);
+        var stagePaths: [0..#n] string;
+        var stagePtrs: [0..#n] c_ptrConst(c_char);
+        var movedBits: [0..#bitmapBytes] uint(8);
+
+        // ── Pass 1: resume/abort filter ───────────────────────────────────
+        for i in 0..#n {
+          const idx = block.docIdx[i];
+
+          // Skip if already processed in a previous run (--resume),
+          // or if the failure threshold has tripped
+          if isAlreadyProcessed(idx) || shouldAbort() {
+            recordCompletion();
+            releaseHint(idx);
+            continue;
+          }
 
-      conduitValid = true;
-      // Record the content type detected by magic bytes
-      recordContentType(conduitResult.content_kind: int);
-    }
+          active[i] = true;
+          entries[i] = docEntries[idx];
+          outPaths[i] = outputPathFor(entries[i].path);
+        }
 
-    var result: ddac_parse_result_t;
-    var cacheHit = false;
-
-    // ── Cache lookup ─────────────────────────────────────────────
-    // When NDJSON manifest provides pre-computed mtime/size, skip stat().
-    // When conduit ran, use its file_size (avoids a second stat).
-    if cacheRead && localCacheHandle != nil {
-      var mtime: int(64) = -1;
-      var fsize: int(64) = -1;
-
-      if entry.hasMetadata() {
-        // Use pre-computed metadata — no stat() needed
-        mtime = entry.mtime;
-        fsize = entry.size;
-      } else if conduitValid {
-        // Use conduit file_size, but still need mtime from stat()
-        fsize = conduitResult.file_size;
-        try {
-          var sb: struct_stat;
-          if stat(inputPath.c_str(), c_ptrTo(sb)) == 0 {
-            mtime = sb.st_mtim.tv_sec: int(64);
+        // ── Pass 2: conduit pre-processing ────────────────────────────────
+        // Lightweight validation + magic-byte detection + SHA-256 pre-computation.
+        // Runs before the full parse to:
+        //   1. Skip invalid/empty/missing files early (no Tesseract/Poppler init)
+        //   2. Provide SHA-256 for L2 Dragonfly lookup even on cold runs
+        //   3. Record content type from magic bytes (more accurate than extension)
+        //   4. Capture file size without a separate stat() call
+        //   5. With --conduitMmap, keep the mapping so the parser reads the
+        //      same bytes from memory (document comes off the filesystem once)
+        // Without --conduitMmap the batch was started when this chunk was
+        // claimed; usually it has finished by now.
+        if conduitEnabled {
+          block.wait();
+          for i in 0..#n {
+            if !active[i] then continue;
+            const inputPath = entries[i].path;
+
+            if conduitMmap {
+              conduitMappings[i] = ddac_conduit_map(
+                inputPath.c_str(),
+                c_ptrTo(conduitResults[i]): c_ptr(void)
+              );
+            }
+            const conduitRc = conduitResults[i].validation: c_int;
+
+            // Skip invalid files — conduit detected a problem before the expensive parse
+            if conduitRc != 0 {
+              if conduitResults[i].validation == 1 then
+                writeln("[skip] Not found: ", inputPath);
+              else if conduitResults[i].validation == 2 then
+                writeln("[skip] Empty: ", inputPath);
+              else
+                writeln("[skip] Unreadable: ", inputPath);
+              recordFailure();
+              recordCompletion();
+              if prefetchHandle != nil then
+                ddac_prefetch_done(prefetchHandle, inputPath.c_str());
+              active[i] = false;
+              continue;
+            }
+
+            conduitValid[i] = true;
+            // Record the content type detected by magic bytes
+            recordContentType(conduitResults[i].content_kind: int);
           }
-        } catch {
-          // stat failed — proceed with normal parse
         }
-      } else {
-        // Fall back to stat() for plain manifests without conduit
-        try {
-          var sb: struct_stat;
-          if stat(inputPath.c_str(), c_ptrTo(sb)) == 0 {
-            mtime = sb.st_mtim.tv_sec: int(64);
-            fsize = sb.st_size: int(64);
+
+        // ── Pass 3: cache key metadata (mtime, size) ──────────────────────
+        // When NDJSON manifest provides pre-computed mtime/size, skip stat().
+        // When conduit ran, use its file_size (only mtime needs a stat()).
+        if cacheEnabled && localCacheHandle != nil {
+          for i in 0..#n {
+            if !active[i] then continue;
+            pathPtrs[i] = entries[i].path.c_str();
+
+            if entries[i].hasMetadata() {
+              mtimes[i] = entries[i].mtime;
+              fsizes[i] = entries[i].size;
+              continue;
+            }
+
+            try {
+              var sb: struct_stat;
+              if stat(entries[i].path.c_str(), c_ptrTo(sb)) == 0 {
+                mtimes[i] = sb.st_mtim.tv_sec: int(64);
+                fsizes[i] = if conduitValid[i] then conduitResults[i].file_size
+                            else sb.st_size: int(64);
+              }
+            } catch {
+              // stat failed — leave -1 (treated as a miss / not stored)
+            }
           }
-        } catch {
-          // stat failed — proceed with normal parse
-        }
-      }
 
-      if mtime >= 0 && fsize >= 0 {
-        const hit = ddac_cache_lookup(
-          localCacheHandle,
-          inputPath.c_str(),
-          mtime, fsize,
-          c_ptrTo(result): c_ptr(void),
-          resultSize
-        );
-
-        if hit == 1 {
-          cacheHit = true;
-          recordSuccess();
+          // Content-addressed keys: the conduit's SHA-256, plus where a cached
+          // stage blob should be restored when the content hit is for a new path
+          if cacheContentAddressed {
+            for i in 0..#n {
+              if !active[i] then continue;
+              if conduitValid[i] then
+                casShaPtrs[i] = conduitResults[i].sha256: c_ptrConst(c_char);
+              // (no sidecar files to restore into a results container)
+              if stagesMask != 0 && resultsContainer == nil {
+                stagePaths[i] = outPaths[i] + ".stages.capnp";
+                stagePtrs[i] = stagePaths[i].c_str();
+              }
+            }
+          }
         }
-      }
-    }
 
-    // ── L2 Dragonfly lookup (cross-locale dedup) ──────────────────
-    // When conduit ran, SHA-256 is pre-computed, so L2 lookup works
-    // on cold runs too (previously sha256 was uninitialized without L1 hit).
-    if !cacheHit && dragonflyHandle != nil {
-      var sha: string;
-      if conduitValid {
-        sha = string.createCopyingBuffer(conduitResult.sha256: c_ptrConst(c_char));
-      } else {
-        sha = string.createCopyingBuffer(result.sha256: c_ptrConst(c_char));
-      }
-      if sha.size >= 64 {
-        const l2Hit = ddac_dragonfly_lookup(
-          dragonflyHandle,
-          sha.c_str(),
-          c_ptrTo(result): c_ptr(void),
-          resultSize
-        );
-        if l2Hit == 1 {
-          cacheHit = true;
-          recordSuccess();
+        // ── Pass 4: L1 batch lookup (one read txn for the whole chunk) ────
+        if cacheRead && localCacheHandle != nil {
+          const hits =
+            if cacheContentAddressed then
+              ddac_cache_lookup_content_batch(
+                localCacheHandle,
+                c_ptrTo(pathPtrs[0]),
+                c_ptrTo(mtimes[0]),
+                c_ptrTo(fsizes[0]),
+                c_ptrTo(casShaPtrs[0]),
+                c_ptrTo(stagePtrs[0]),
+                c_ptrTo(results[0]): c_ptr(void),
+                resultSize,
+                c_ptrTo(hitBits[0]),
+                c_ptrTo(movedBits[0]),
+                n: uint(32)
+              )
+            else
+              ddac_cache_lookup_batch(
+                localCacheHandle,
+                c_ptrTo(pathPtrs[0]),
+                c_ptrTo(mtimes[0]),
+                c_ptrTo(fsizes[0]),
+                c_ptrTo(results[0]): c_ptr(void),
+                resultSize,
+                c_ptrTo(stageMasks[0]),
+                c_ptrTo(hitBits[0]),
+                n: uint(32)
+              );
+          if hits > 0 {
+            for i in 0..#n {
+              if !active[i] || !bitmapTest(hitBits, i) then continue;
+              // --reextract: a hit lacking requested stages is finished in pass 8
+              if reextractMode then
+                missingStages[i] = ddac_reextract_plan(stageMasks[i], stagesMask);
+              if missingStages[i] != 0 then continue;
+              recordSuccess();
+              // Moved or duplicate document: re-point the path index only
+              // (content, and therefore the stage blob, is already cached)
+              if cacheWrite && bitmapTest(movedBits, i) {
+                bitmapSet(storeBits, i);
+                stagePtrs[i] = nil;
+              }
+            }
+          }
         }
-      }
-    }
 
-    // ── Parse (only if both L1 and L2 missed) ────────────────────
-    if !cacheHit {
-      result = safeParse(handle, inputPath, outPath, fmtCode, stagesMask);
-
-      // ── L1 cache store ──────────────────────────────────────
-      if cacheWrite && localCacheHandle != nil && parseSucceeded(result) {
-        var mtime: int(64) = -1;
-        var fsize: int(64) = -1;
-
-        if entry.hasMetadata() {
-          mtime = entry.mtime;
-          fsize = entry.size;
-        } else {
-          try {
-            var sb: struct_stat;
-            if stat(inputPath.c_str(), c_ptrTo(sb)) == 0 {
-              mtime = sb.st_mtim.tv_sec: int(64);
-              fsize = sb.st_size: int(64);
+        // ── Pass 5: L2 Dragonfly batch lookup (one MGET per chunk) ────────
+        // Cross-locale dedup for L1 misses. When conduit ran, SHA-256 is
+        // pre-computed, so L2 lookup works on cold runs too.
+        if dragonflyPool != nil {
+          var wanted = 0;
+          for i in 0..#n {
+            if active[i] && conduitValid[i] && !(cacheRead && bitmapTest(hitBits, i)) {
+              shaPtrs[i] = conduitResults[i].sha256: c_ptrConst(c_char);
+              wanted += 1;
             }
-          } catch {
-            // stat failed — skip caching
+          }
+          if wanted > 0 {
+            const l2Hits = ddac_dragonfly_lookup_batch(
+              dragonflyPool,
+              c_ptrTo(shaPtrs[0]),
+              c_ptrTo(results[0]): c_ptr(void),
+              resultSize,
+              c_ptrTo(l2HitBits[0]),
+              n: uint(32)
+            );
+            if l2Hits > 0 then
+              for i in 0..#n do
+                if bitmapTest(l2HitBits, i) then recordSuccess();
           }
         }
 
-        if mtime >= 0 && fsize >= 0 {
-          ddac_cache_store(
-            localCacheHandle,
-            inputPath.c_str(),
-            mtime, fsize,
-            c_ptrToConst(result): c_ptrConst(void),
-            resultSize
-          );
+        // Images as the parse will see them: a recognised extension wins
+        // over the magic bytes, so a .geotiff raster (TIFF magic) goes to
+        // the geospatial parser and is neither hashed nor GPU-OCR'd here
+        var isImage: [0..#n] bool;
+        for i in 0..#n do
+          if active[i] && conduitValid[i] then
+            isImage[i] = ddac_resolve_kind(conduitResults[i].content_kind,
+                                           entries[i].path.c_str()) == 1;
+
+        // ── Pass 6: near-duplicate check against every locale's shard ─────
+        // Each image about to run the near_dedup stage is hashed here and
+        // checked against the corpus-wide index before it is parsed, so a
+        // near-duplicate parsed on another locale (or in a stolen chunk) is
+        // found as well; its parse writes the verdict and skips OCR/ML.
+        // Images over nearDupHashMaxMB are not decoded twice: their parse
+        // checks them against this locale's shard (nearDupLocal).
+        var nearDup: [0..#n] ddac_neardup_verdict_t;
+        var hasNearDup, nearDupLocal: [0..#n] bool;
+        const nearDupHashMax = nearDupHashMaxMB * 1024 * 1024;
+        if nearDupIndex != nil {
+          var ndSlots: [0..#n] int;
+          var ndHashes, ndDocs: [0..#n] uint(64);
+          var m = 0;
+          for i in 0..#n {
+            if !isImage[i] then continue;
+            // Served from a cache: the stage already ran, unless it is re-extracted
+            const cacheHit = (cacheRead && bitmapTest(hitBits, i)) || bitmapTest(l2HitBits, i);
+            if cacheHit && (missingStages[i] & STAGE_NEAR_DEDUP) == 0 then continue;
+            if nearDupHashMax > 0 && conduitResults[i].file_size > nearDupHashMax {
+              nearDupLocal[i] = isolatePool == nil;
+              continue;
+            }
+            var hash: uint(64);
+            if ddac_image_ahash(entries[i].path.c_str(), conduitMappings[i]: c_ptrConst(void),
+                                c_ptrTo(hash)) != 0 then continue;
+            ndSlots[m] = i;
+            ndHashes[m] = hash;
+            ndDocs[m] = block.docIdx[i]: uint(64);
+            m += 1;
+          }
+          if m > 0 {
+            var verdicts: [0..#m] ddac_neardup_verdict_t;
+            nearDupVerdicts(resources, ndHashes[0..#m], ndDocs[0..#m], verdicts);
+            for j in 0..#m {
+              nearDup[ndSlots[j]] = verdicts[j];
+              hasNearDup[ndSlots[j]] = true;
+            }
+          }
         }
-      }
 
-      // ── L2 Dragonfly store (cross-locale dedup) ─────────────
-      if dragonflyHandle != nil && parseSucceeded(result) {
-        const sha = string.createCopyingBuffer(result.sha256: c_ptrConst(c_char));
-        if sha.size >= 64 {
-          ddac_dragonfly_store(
-            dragonflyHandle,
-            sha.c_str(),
-            c_ptrToConst(result): c_ptrConst(void),
-            resultSize,
-            dragonflyTTL: uint(32)
-          );
+        // ── Pass 7: pre-submit the chunk's images to the GPU OCR worker ───
+        // The batch runs on the GPU while pass 8 parses the non-image
+        // documents; each image's parse then collects its ticket. Images
+        // that get no ticket (buffers busy) fall back to submit-on-parse.
+        var gpuTickets: [0..#n] c_int = -1;
+        var parseOrder: [0..#n] int;
+        var nOrder = 0;
+        // (a worker process cannot collect tickets from this locale's queue)
+        if gpuOcrHandle != nil && isolatePool == nil {
+          var submitted = 0;
+          for i in 0..#n {
+            if !isImage[i] then continue;
+            if (cacheRead && bitmapTest(hitBits, i)) || bitmapTest(l2HitBits, i) then continue;
+            gpuTickets[i] = ddac_gpu_ocr_submit(gpuOcrHandle, entries[i].path.c_str(), nil);
+            if gpuTickets[i] >= 0 then submitted += 1;
+          }
+          if submitted > 0 then ddac_gpu_ocr_flush(gpuOcrHandle);
         }
-      }
-    }
+        for i in 0..#n do
+          if gpuTickets[i] < 0 { parseOrder[nOrder] = i; nOrder += 1; }
+        for i in 0..#n do
+          if gpuTickets[i] >= 0 { parseOrder[nOrder] = i; nOrder += 1; }
+
+        // ── Pass 8: parse misses, per-document bookkeeping ────────────────
+        for i in parseOrder {
+          if !active[i] then continue;
+          const idx = block.docIdx[i];
+          const inputPath = entries[i].path;
+          const outPath = outPaths[i];
+          ref result = results[i];
+          const cacheHit = (cacheRead && bitmapTest(hitBits, i)) ||
+                           bitmapTest(l2HitBits, i);
+          var needParse = !cacheHit;
+
+          // ── Re-extract: only the stages the L1 entry lacks, no base parse ──
+          if cacheHit && missingStages[i] != 0 {
+            if hasNearDup[i] then
+              ddac_set_neardup_verdict(handle, c_ptrToConst(nearDup[i]));
+            else if nearDupLocal[i] then
+              ddac_set_neardup_doc(handle, nearDupIndex, idx: uint(64),
+                                   min(nearDupMaxHamming, 15): uint(8));
+            if safeReextract(handle, inputPath, outPath, missingStages[i],
+                             result, stageMasks[i]) {
+              if cacheWrite then bitmapSet(storeBits, i);
+            } else {
+              needParse = true;
+            }
+          }
 
-    // Signal prefetcher that this file is done (release page cache)
-    if prefetchHandle != nil then
-      ddac_prefetch_done(prefetchHandle, inputPath.c_str());
+          // ── Parse (only if both L1 and L2 missed) ────────────────────
+          if needParse {
+            // Reuse the conduit's SHA-256 and magic-byte kind (no re-read/re-hash)
+            const conduitPtr: c_ptrConst(ddac_conduit_result_t) =
+              if conduitValid[i] then c_ptrToConst(conduitResults[i]) else nil;
+            if gpuTickets[i] >= 0 then
+              ddac_set_gpu_ocr_ticket(handle, gpuTickets[i]);
+            if resultsContainer != nil && isolatePool == nil then
+              ddac_set_container_doc(handle, resultsContainer, idx: uint(64));
+            const nearDupPtr: c_ptrConst(ddac_neardup_verdict_t) =
+              if hasNearDup[i] then c_ptrToConst(nearDup[i]) else nil;
+            if nearDupLocal[i] then
+              ddac_set_neardup_doc(handle, nearDupIndex, idx: uint(64),
+                                   min(nearDupMaxHamming, 15): uint(8));
+            const mapping = conduitMappings[i]: c_ptrConst(void);
+            // Large PDFs run as page ranges across the locale's idle tasks
+            // (in-process, so not with --isolateParse)
+            const fileSize = if conduitValid[i] then conduitResults[i].file_size
+                             else max(fsizes[i], entries[i].size);
+            const splitPages =
+              if isolatePool == nil then splitPageCount(inputPath, conduitPtr, mapping, fileSize)
+              else 0;
+            if splitPages > 0 then
+              result = safeParseSplit(handle, parsePool, inputPath, outPath, fmtCode,
+                                      stagesMask, conduitPtr, mapping, splitPages,
+                                      fileSize: int);
+            else
+              result = safeParse(handle, inputPath, outPath, fmtCode, stagesMask,
+                                 conduitPtr, mapping, isolatePool, fileSize: int,
+                                 nearDupPtr);
+
+            // Queue for the chunk's L1 and L2 batch stores
+            if parseSucceeded(result) {
+              stageMasks[i] = stagesMask;
+              if cacheWrite then bitmapSet(storeBits, i);
+              if cacheContentAddressed then
+                casShaPtrs[i] = result.sha256: c_ptrConst(c_char);
+              if dragonflyPool != nil {
+                shaPtrs[i] = result.sha256: c_ptrConst(c_char);
+                bitmapSet(l2StoreBits, i);
+              }
+            }
+          }
 
-    accumulate(result);
-    recordCompletion();
+          // Signal prefetcher that this file is done (release page cache)
+          if prefetchHandle != nil then
+            ddac_prefetch_done(prefetchHandle, inputPath.c_str());
 
-    // Write streaming NDJSON result if enabled
-    if streamOutput {
-      ndjsonWriter.writeResult(inputPath, result, result.parse_time_ms);
-    }
+          recordCompletion();
+
+          // Results row in the shard's container (parsed and cache hits)
+          if resultsContainer != nil then
+            ddac_container_put_result(resultsContainer, idx: uint(64),
+                                      c_ptrToConst(result): c_ptrConst(void),
+                                      resultSize);
+
+          // Write streaming NDJSON result if enabled
+          if streamOutput {
+            ndjsonBuf.writeResult(inputPath, result, result.parse_time_ms);
+          }
+
+          // Record checkpoint for resume capability
+          if parseSucceeded(result) {
+            try { recordCheckpoint(idx); } catch { }
+          }
+        }
+
+        // Chunk statistics, reduced over columns (every active slot)
+        accumulateChunk(results, active);
+
+        // ── Pass 9: batch stores (one LMDB commit + one SET burst per chunk) ──
+        if dragonflyPool != nil {
+          ddac_dragonfly_store_batch(
+            dragonflyPool,
+            c_ptrTo(shaPtrs[0]),
+            c_ptrToConst(results[0]): c_ptrConst(void),
+            resultSize,
+            c_ptrTo(l2StoreBits[0]),
+            dragonflyTTL: uint(32),
+            n: uint(32)
+          );
+        }
 
-    // Record checkpoint for resume capability
-    if parseSucceeded(result) {
-      try { recordCheckpoint(idx); } catch { }
+        if cacheWrite && localCacheHandle != nil {
+          if cacheContentAddressed then
+            ddac_cache_store_content_batch(
+              localCacheHandle,
+              c_ptrTo(pathPtrs[0]),
+              c_ptrTo(mtimes[0]),
+              c_ptrTo(fsizes[0]),
+              c_ptrTo(casShaPtrs[0]),
+              c_ptrTo(stagePtrs[0]),
+              c_ptrToConst(results[0]): c_ptrConst(void),
+              resultSize,
+              c_ptrTo(storeBits[0]),
+              n: uint(32)
+            );
+          else
+            ddac_cache_store_batch(
+              localCacheHandle,
+              c_ptrTo(pathPtrs[0]),
+              c_ptrTo(mtimes[0]),
+              c_ptrTo(fsizes[0]),
+              c_ptrToConst(results[0]): c_ptrConst(void),
+              resultSize,
+              c_ptrTo(stageMasks[0]),
+              c_ptrTo(storeBits[0]),
+              n: uint(32)
+            );
+
+          // Relaxed durability: one task syncs every cacheSyncIntervalSec
+          if relaxedCacheSync {
+            const now = syncClock.elapsed();
+            var last = lastCacheSync.read();
+            if now - last >= cacheSyncIntervalSec &&
+               lastCacheSync.compareExchange(last, now) then
+              ddac_cache_sync(localCacheHandle);
+          }
+        }
+      }
     }
   }
 
   // ── Finalise ──────────────────────────────────────────────────────
-  if streamOutput then ndjsonWriter.flush();
   timer.stop();
   stopReporter();
 
   // Give reporter thread time to print final line
   sleep(1.0);
 
-  // Sync and close cache
-  if localCacheHandle != nil {
-    ddac_cache_sync(localCacheHandle);
-    const finalCount = ddac_cache_count(localCacheHandle);
-    writeln("[cache] Locale ", here.id, ": ", finalCount, " entries after run");
-    ddac_cache_free(localCacheHandle);
-  }
-
-  // Close I/O prefetcher
-  if prefetchHandle != nil then
-    ddac_prefetch_free(prefetchHandle);
-
-  // Close Dragonfly L2 cache
-  if dragonflyHandle != nil {
-    const l2Final = ddac_dragonfly_count(dragonflyHandle);
-    writeln("[cache-l2] Dragonfly: ", l2Final, " entries after run");
-    ddac_dragonfly_close(dragonflyHandle);
-  }
+  // Flush, report and free every locale's resources
+  coforall loc in Locales with (ref resources) do on loc do
+    resources[here.id].close();
 
-  // Close GPU OCR coprocessor and print stats
-  if gpuOcrHandle != nil {
-    var gpuSubmitted, gpuCompleted, gpuBatches, gpuTimeUs: uint(64);
-    ddac_gpu_ocr_stats(gpuOcrHandle,
-      c_ptrTo(gpuSubmitted), c_ptrTo(gpuCompleted),
-      c_ptrTo(gpuBatches), c_ptrTo(gpuTimeUs));
-    writeln("[gpu-ocr] ", gpuSubmitted, " submitted, ", gpuCompleted, " completed, ",
-            gpuBatches, " batches, ", gpuTimeUs / 1000, "ms GPU time");
-    ddac_gpu_ocr_free(gpuOcrHandle);
-  }
-
-  // Close ML inference engine
-  if mlHandle != nil {
-    var mlInferences, mlTimeUs: uint(64);
-    ddac_ml_stats(mlHandle, c_ptrTo(mlInferences), c_ptrTo(mlTimeUs));
-    if mlInferences > 0 then
-      writeln("[ml] ", mlInferences, " inferences, ", mlTimeUs / 1000, "ms total");
-    ddac_ml_free(mlHandle);
-  }
+  for locId in 0..#numLocales do
+    recordSteals(locId, stealCounts(locId));
+  freeScheduler();
+  saveCostModel(modelPath);
 
   // Compute and display global statistics
   var report = computeGlobal(timer.elapsed());
   printReport(report);
   writeReport(report, outputDir + "/run-report.scm");
   writeJSONReport(report, outputDir + "/run-report.json");
+  if metricsPrometheusPath != "" then
+    writePrometheusMetrics(report, metricsPrometheusPath);
 
   // Save final checkpoint (for resume if needed later)
   try { flushAllCheckpoints(); } catch { }
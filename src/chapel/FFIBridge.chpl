@@ -59,6 +59,41 @@ module FFIBridge {
     stage_flags: uint(64)
   ): ddac_parse_result_t;
 
+  // ── Batched parse ─────────────────────────────────────────────────────
+
+  /** Struct-of-arrays view of a result array (ddac_parse_columns).
+      Each non-nil column receives n elements in result order. */
+  extern record ddac_parse_columns_t {
+    var status: c_ptr(c_int);
+    var content_kind: c_ptr(c_int);
+    var page_count: c_ptr(int(32));
+    var word_count: c_ptr(int(64));
+    var char_count: c_ptr(int(64));
+    var duration_sec: c_ptr(real(64));
+    var parse_time_ms: c_ptr(real(64));
+    var sha256: c_ptr(c_array(c_char, 65));
+  }
+
+  /** Parse n documents in one call into a caller-allocated result array.
+      Slot i gets what ddac_parse(handle, paths[i], out_paths[i], 0,
+      stage_flags) would return (nil path = status 3).
+      Returns the number of documents with status 0. */
+  extern proc ddac_parse_batch(
+    handle: c_ptr(void),
+    paths: c_ptrConst(c_ptrConst(c_char)),
+    out_paths: c_ptrConst(c_ptrConst(c_char)),
+    n: uint(32),
+    stage_flags: uint(64),
+    results_out: c_ptr(ddac_parse_result_t)
+  ): uint(32);
+
+  /** Gather n results into contiguous columns (nil columns skipped). */
+  extern proc ddac_parse_columns(
+    results: c_ptrConst(ddac_parse_result_t),
+    n: uint(32),
+    const ref columns: ddac_parse_columns_t
+  ): void;
+
   // ── Version information ───────────────────────────────────────────────
 
   /** Get library version string (static storage, do not free). */
@@ -84,6 +119,69 @@ module FFIBridge {
     gpu_ocr_handle: c_ptr(void)
   ): void;
 
+  /** Hand the next parse on this handle a ticket from ddac_gpu_ocr_submit.
+      The parse collects it (or releases it if unused); -1 clears it. */
+  extern proc ddac_set_gpu_ocr_ticket(handle: c_ptr(void), ticket: c_int): void;
+
+  /** Write this handle's stage messages in Cap'n Proto packed encoding
+      (enabled != 0) instead of the standard framing. */
+  extern proc ddac_set_stages_packed(handle: c_ptr(void), enabled: c_int): void;
+
+  // ── Parse handle pool ───────────────────────────────────────────────
+  //
+  // Warmed parse handles reused across documents. ddac_init() loads the
+  // Tesseract eng traineddata every call; the pool pays that once per
+  // worker task instead of once per document.
+
+  /** Create a pool of `size` pre-warmed parse handles. Returns nil on failure. */
+  extern proc ddac_pool_create(size: uint(32)): c_ptr(void);
+
+  /** Free the pool and all its parse handles (not the bound ML/GPU handles). */
+  extern proc ddac_pool_free(pool: c_ptr(void)): void;
+
+  /** Check out a warmed parse handle (grows the pool if all are in use). */
+  extern proc ddac_pool_acquire(pool: c_ptr(void)): c_ptr(void);
+
+  /** Return a parse handle obtained from ddac_pool_acquire(). */
+  extern proc ddac_pool_release(pool: c_ptr(void), handle: c_ptr(void)): void;
+
+  /** Bind ML and GPU OCR handles to every pooled parse handle. Either may be nil. */
+  extern proc ddac_pool_bind(
+    pool: c_ptr(void),
+    ml_handle: c_ptr(void),
+    gpu_ocr_handle: c_ptr(void)
+  ): void;
+
+  /** ddac_set_stages_packed for every pooled parse handle. */
+  extern proc ddac_pool_set_stages_packed(pool: c_ptr(void), enabled: c_int): void;
+
+  /** Number of parse handles owned by the pool. */
+  extern proc ddac_pool_size(pool: c_ptr(void)): uint(32);
+
+  /** Task-private lease on a pooled parse handle.
+      Declare as a forall task-private variable
+      (`with (var lease = new PooledHandle(pool))`) so each task acquires
+      once and the handle is released when the task finishes. */
+  record PooledHandle {
+    var pool: c_ptr(void);
+    var handle: c_ptr(void);
+
+    proc init(pool: c_ptr(void)) {
+      this.pool = pool;
+      this.handle = ddac_pool_acquire(pool);
+    }
+
+    // A copy takes its own lease, so each copy releases exactly once
+    proc init=(other: PooledHandle) {
+      this.pool = other.pool;
+      this.handle = ddac_pool_acquire(other.pool);
+    }
+
+    proc deinit() {
+      if handle != nil then ddac_pool_release(pool, handle);
+    }
+  }
+
   // ── LMDB Result Cache ────────────────────────────────────────────────
 
   /** Initialise LMDB cache at dir_path. Returns opaque handle or nil. */
@@ -122,16 +220,110 @@ module FFIBridge {
   /** Sync cache to disk. */
   extern proc ddac_cache_sync(cache: c_ptr(void)): void;
 
+  /** ddac_cache_init_ex durability flags (DDAC_CACHE_* in the header). */
+  param DDAC_CACHE_NOSYNC: uint(32) = 0x1;
+  param DDAC_CACHE_WRITEMAP: uint(32) = 0x2;
+  param DDAC_CACHE_CONTENT: uint(32) = 0x4;
+
+  /** Initialise LMDB cache with durability flags. With NOSYNC/WRITEMAP,
+      commits skip fsync and ddac_cache_sync must be called periodically. */
+  extern proc ddac_cache_init_ex(
+    dir_path: c_ptrConst(c_char),
+    max_size_mb: uint(64),
+    flags: uint(32)
+  ): c_ptr(void);
+
+  /** Look up n documents in ONE read transaction.
+      stage_masks_out: n entries (nil = not wanted), each hit's stored stage mask.
+      hit_bitmap: (n+7)/8 bytes, bit i set on hit. Returns hit count. */
+  extern proc ddac_cache_lookup_batch(
+    cache: c_ptr(void),
+    paths: c_ptr(c_ptrConst(c_char)),
+    mtimes: c_ptr(int(64)),
+    sizes: c_ptr(int(64)),
+    results_out: c_ptr(void),
+    result_size: c_size_t,
+    stage_masks_out: c_ptr(uint(64)),
+    hit_bitmap: c_ptr(uint(8)),
+    n: uint(32)
+  ): uint(32);
+
+  /** Store n documents in ONE write transaction.
+      stage_masks: n entries (nil = 0), the stage mask stored with each.
+      store_mask: (n+7)/8 bytes selecting entries (nil = all). Returns count stored. */
+  extern proc ddac_cache_store_batch(
+    cache: c_ptr(void),
+    paths: c_ptr(c_ptrConst(c_char)),
+    mtimes: c_ptr(int(64)),
+    sizes: c_ptr(int(64)),
+    results: c_ptrConst(void),
+    result_size: c_size_t,
+    stage_masks: c_ptr(uint(64)),
+    store_mask: c_ptr(uint(8)),
+    n: uint(32)
+  ): uint(32);
+
+  /** Content-addressed batch lookup (DDAC_CACHE_CONTENT caches).
+      Path index first, then shas[i] directly; sha-only hits set moved_bitmap
+      and restore the cached stage blob to stage_paths[i]. Returns hit count. */
+  extern proc ddac_cache_lookup_content_batch(
+    cache: c_ptr(void),
+    paths: c_ptr(c_ptrConst(c_char)),
+    mtimes: c_ptr(int(64)),
+    sizes: c_ptr(int(64)),
+    shas: c_ptr(c_ptrConst(c_char)),
+    stage_paths: c_ptr(c_ptrConst(c_char)),
+    results_out: c_ptr(void),
+    result_size: c_size_t,
+    hit_bitmap: c_ptr(uint(8)),
+    moved_bitmap: c_ptr(uint(8)),
+    n: uint(32)
+  ): uint(32);
+
+  /** Content-addressed batch store: re-point path index entries and add
+      new digests (result + stage blob read from stage_paths[i]).
+      Returns the number of slots indexed. */
+  extern proc ddac_cache_store_content_batch(
+    cache: c_ptr(void),
+    paths: c_ptr(c_ptrConst(c_char)),
+    mtimes: c_ptr(int(64)),
+    sizes: c_ptr(int(64)),
+    shas: c_ptr(c_ptrConst(c_char)),
+    stage_paths: c_ptr(c_ptrConst(c_char)),
+    results: c_ptrConst(void),
+    result_size: c_size_t,
+    store_mask: c_ptr(uint(8)),
+    n: uint(32)
+  ): uint(32);
+
+  /** Test bit i of a batch bitmap (byte i/8, bit i%8). */
+  inline proc bitmapTest(const ref bits: [] uint(8), i: int): bool {
+    return ((bits[bits.domain.low + i / 8] >> (i % 8): uint(8)) & 1) == 1;
+  }
+
+  /** Set bit i of a batch bitmap. */
+  inline proc bitmapSet(ref bits: [] uint(8), i: int) {
+    bits[bits.domain.low + i / 8] |= (1: uint(8)) << (i % 8): uint(8);
+  }
+
   // ── I/O Prefetcher ─────────────────────────────────────────────────────
 
   /** Initialise I/O prefetcher with a window of upcoming files.
       Uses io_uring on Linux 5.6+, falls back to posix_fadvise. */
   extern proc ddac_prefetch_init(window_size: uint(32)): c_ptr(void);
 
+  /** As ddac_prefetch_init, with a byte budget for readahead in flight
+      (budget_mb = 0: a quarter of MemAvailable). */
+  extern proc ddac_prefetch_init_ex(window_size: uint(32), budget_mb: uint(64)): c_ptr(void);
+
   /** Hint that a file will be needed soon (triggers kernel readahead). */
   extern proc ddac_prefetch_hint(handle: c_ptr(void), path: c_ptrConst(c_char)): void;
 
-  /** Signal that a file has been fully processed (release page cache). */
+  /** Queue a batch of upcoming files (nil entries skipped); thread-safe. */
+  extern proc ddac_prefetch_submit(handle: c_ptr(void), paths: c_ptr(c_ptrConst(c_char)),
+                                   count: uint(32)): void;
+
+  /** Signal that a file has been fully processed (returns its bytes to the budget). */
   extern proc ddac_prefetch_done(handle: c_ptr(void), path: c_ptrConst(c_char)): void;
 
   /** Free the prefetcher and close all open files. */
@@ -174,6 +366,47 @@ module FFIBridge {
   /** Get approximate key count in Dragonfly. */
   extern proc ddac_dragonfly_count(handle: c_ptr(void)): uint(64);
 
+  /** Create a pool of at most `size` Dragonfly connections (one per
+      task); callers wait when all are leased. Returns nil if the server
+      is unreachable. */
+  extern proc ddac_dragonfly_pool_create(
+    host_port: c_ptrConst(c_char),
+    size: uint(32)
+  ): c_ptr(void);
+
+  /** Close all pooled connections and free the pool. */
+  extern proc ddac_dragonfly_pool_free(pool: c_ptr(void)): void;
+
+  /** Number of connections open in the pool (leased plus idle). */
+  extern proc ddac_dragonfly_pool_size(pool: c_ptr(void)): uint(32);
+
+  /** Approximate key count (DBSIZE) over a pooled connection. */
+  extern proc ddac_dragonfly_pool_count(pool: c_ptr(void)): uint(64);
+
+  /** Look up n results by SHA-256 in one MGET round trip.
+      sha256s[i] = nil skips slot i. Hit slots of results_out are filled
+      and their bit set in hit_bitmap (ceil(n/8) bytes). Returns hit count. */
+  extern proc ddac_dragonfly_lookup_batch(
+    pool: c_ptr(void),
+    sha256s: c_ptr(c_ptrConst(c_char)),
+    results_out: c_ptr(void),
+    result_size: c_size_t,
+    hit_bitmap: c_ptr(uint(8)),
+    n: uint(32)
+  ): uint(32);
+
+  /** Store the slots whose store_mask bit is set as one pipelined burst
+      of SETs. Returns the number of SETs acknowledged. */
+  extern proc ddac_dragonfly_store_batch(
+    pool: c_ptr(void),
+    sha256s: c_ptr(c_ptrConst(c_char)),
+    results: c_ptrConst(void),
+    result_size: c_size_t,
+    store_mask: c_ptr(uint(8)),
+    ttl_secs: uint(32),
+    n: uint(32)
+  ): uint(32);
+
   // ── ML Inference Engine (ONNX Runtime) ──────────────────────────────
 
   /** ML inference result — 56 bytes, matches ddac_ml_result_t.
@@ -228,6 +461,32 @@ module FFIBridge {
     total_inference_us: c_ptr(uint(64))
   ): void;
 
+  /** Set a stage's batching policy: run a batch once maxBatch requests
+      (1..64; 1 = no batching) are queued or the oldest has waited
+      maxWaitUs. Requests from all tasks on the locale share the queue. */
+  extern proc ddac_ml_set_batch_policy(
+    handle: c_ptr(void),
+    stage: uint(8),
+    max_batch: uint(32),
+    max_wait_us: uint(32)
+  ): void;
+
+  /** Get a stage's batch statistics (batches, requests, summed and worst
+      queue wait in us, current maxBatch).
+      Occupancy = items / (batches * maxBatch). */
+  extern proc ddac_ml_queue_stats(
+    handle: c_ptr(void),
+    stage: uint(8),
+    batches: c_ptr(uint(64)),
+    items: c_ptr(uint(64)),
+    queue_wait_us: c_ptr(uint(64)),
+    max_queue_wait_us: c_ptr(uint(64)),
+    max_batch: c_ptr(uint(32))
+  ): void;
+
+  /** Short ML stage names by stage ID (--mlBatchPolicy keys). */
+  const mlStageNames = ["ner", "whisper", "classify", "layout", "handwriting"];
+
   /** Get sizeof(ddac_ml_result_t) for allocation. */
   extern proc ddac_ml_result_size(): c_size_t;
 
@@ -243,27 +502,29 @@ module FFIBridge {
       Reports CPU crypto features for SHA-256 acceleration. */
   extern record ddac_crypto_caps_t {
     var has_sha_ni: uint(8);         // x86-64 SHA-NI
-    var has_avx2: uint(8);           // x86-64 AVX2
-    var has_avx512: uint(8);         // x86-64 AVX-512F
+    var has_avx2: uint(8);           // x86-64 AVX2 (OS-enabled)
+    var has_avx512: uint(8);         // x86-64 AVX-512F (OS-enabled)
     var has_arm_sha2: uint(8);       // AArch64 SHA2
     var has_arm_sha512: uint(8);     // AArch64 SHA-512
     var has_aes_ni: uint(8);         // x86-64 AES-NI
     var _pad: c_array(uint(8), 2);   // padding
-    var sha256_tier: uint(8);        // 0=dedicated, 1=AVX2, 2=software
-    var _pad2: c_array(uint(8), 7);  // padding
+    var sha256_tier: uint(8);        // 0=dedicated, 1=multi-buffer, 2=software
+    var sha256_lanes: uint(8);       // files hashed per pass: 16, 8, or 1
+    var _pad2: c_array(uint(8), 6);  // padding
   }
 
   /** Detect hardware crypto capabilities. */
   extern proc ddac_crypto_detect(caps_out: c_ptr(void)): void;
 
-  /** Get SHA-256 acceleration tier: 0=SHA-NI/ARM-SHA2, 1=AVX2, 2=software. */
+  /** Get SHA-256 acceleration tier: 0=SHA-NI/ARM-SHA2, 1=AVX-512/AVX2, 2=software. */
   extern proc ddac_crypto_sha256_tier(): uint(8);
 
   /** Get human-readable name for the SHA-256 backend. */
   extern proc ddac_crypto_sha256_name(): c_ptrConst(c_char);
 
   /** Batch SHA-256: compute digests for N files in parallel.
-      Uses multi-buffer technique when AVX2 is available.
+      Small files are hashed 16 (AVX-512) or 8 (AVX2) per SIMD pass;
+      with SHA-NI, files are streamed with large reads and readahead.
       Returns number of successfully hashed files. */
   extern proc ddac_crypto_batch_sha256(
     paths: c_ptr(c_ptrConst(c_char)),
@@ -299,29 +560,41 @@ module FFIBridge {
   /** Get detected backend: 0=paddle_gpu, 1=tesseract_cuda, 2=cpu_only. */
   extern proc ddac_gpu_ocr_backend(handle: c_ptr(void)): uint(8);
 
+  /** Set the PaddleOCR model directory ({dir}/det, {dir}/rec, {dir}/dict.txt).
+      Call before the first batch runs. */
+  extern proc ddac_gpu_ocr_set_model_dir(
+    handle: c_ptr(void),
+    dir: c_ptrConst(c_char)
+  ): void;
+
   /** Submit an image for batched GPU OCR.
-      Returns slot ID (0..max_batch-1) or -1 if queue full.
-      Auto-flushes when the batch fills up. */
+      Returns a ticket (>= 0), or -1 if no batch buffer is free or there is
+      no GPU backend. A full batch starts at once. output_path may be nil
+      (text then only comes back through collect / a parse handle). */
   extern proc ddac_gpu_ocr_submit(
     handle: c_ptr(void),
     image_path: c_ptrConst(c_char),
     output_path: c_ptrConst(c_char)
   ): c_int;
 
-  /** Flush pending images — process the current (partial) batch. */
+  /** Flush pending images — start the current (partial) batch.
+      Does not wait; collect blocks until the batch is done. */
   extern proc ddac_gpu_ocr_flush(handle: c_ptr(void)): void;
 
   /** Number of results ready after a flush. */
   extern proc ddac_gpu_ocr_results_ready(handle: c_ptr(void)): uint(32);
 
-  /** Collect one OCR result by slot ID.
-      Returns 0 on success, -1 on invalid slot. */
+  /** Collect one OCR result by ticket, waiting for its batch.
+      Returns 0 on success, -1 on an invalid or spent ticket. */
   extern proc ddac_gpu_ocr_collect(
     handle: c_ptr(void),
-    slot_id: uint(32),
+    ticket: uint(32),
     result_out: c_ptr(void)
   ): c_int;
 
+  /** Give up a ticket without collecting it. Safe on spent tickets. */
+  extern proc ddac_gpu_ocr_release(handle: c_ptr(void), ticket: c_int): void;
+
   /** Get GPU OCR statistics (total submitted, completed, batches, GPU time). */
   extern proc ddac_gpu_ocr_stats(
     handle: c_ptr(void),
@@ -359,7 +632,7 @@ module FFIBridge {
     result_out: c_ptr(void)
   ): c_int;
 
-  /** Batch pre-process N files.
+  /** Batch pre-process N files (io_uring on Linux). nil paths are skipped.
       Returns number of valid (validation==0) files. */
   extern proc ddac_conduit_batch(
     paths: c_ptr(c_ptrConst(c_char)),
@@ -367,9 +640,394 @@ module FFIBridge {
     count: uint(32)
   ): uint(32);
 
+  /** Queue ddac_conduit_batch on the handle's conduit thread; join with
+      ddac_conduit_batch_wait. paths/results must outlive the job. */
+  extern proc ddac_conduit_batch_start(
+    handle: c_ptr(void),
+    paths: c_ptr(c_ptrConst(c_char)),
+    results: c_ptr(void),
+    count: uint(32)
+  ): c_ptr(void);
+
+  /** Join a conduit batch job. Returns number of valid files. */
+  extern proc ddac_conduit_batch_wait(job: c_ptr(void)): uint(32);
+
   /** Get sizeof(ddac_conduit_result_t) for Chapel allocation. */
   extern proc ddac_conduit_result_size(): c_size_t;
 
+  /** Single-read conduit: mmap the file, detect + hash from the mapping.
+      Returns a mapping handle for ddac_parse_ex(), or nil on validation
+      failure (result_out.validation says why). */
+  extern proc ddac_conduit_map(
+    path: c_ptrConst(c_char),
+    result_out: c_ptr(void)
+  ): c_ptr(void);
+
+  /** Release a mapping from ddac_conduit_map(). Safe to call with nil. */
+  extern proc ddac_conduit_unmap(mapping: c_ptr(void)): void;
+
+  /** Conduit state for one driver chunk: the path block handed to
+      ddac_conduit_batch_start and the results it fills.  Claiming the next
+      chunk's block before parsing the current one overlaps its reads and
+      hashing with the parse.  Unmaps any ddac_conduit_map mappings and
+      joins an unfinished job on destruction. */
+  class ConduitBlock {
+    const n: int;
+    var docIdx: [0..#n] int;                  // manifest index of each slot
+    var paths: [0..#n] c_ptrConst(c_char);    // nil = skip slot
+    var pathStrs: [0..#n] string;             // local copies backing paths
+    var results: [0..#n] ddac_conduit_result_t;
+    var mappings: [0..#n] c_ptr(void);        // --conduitMmap only
+    var job: c_ptr(void) = nil;
+
+    proc init(const ref docIdx: [] int) {
+      this.n = docIdx.size;
+      this.docIdx = docIdx;
+    }
+
+    /** Queue slot i's path (copied, so it may come from another locale). */
+    proc setPath(i: int, path: string) {
+      pathStrs[i] = path;
+      paths[i] = pathStrs[i].c_str();
+    }
+
+    /** Queue the batch on handle's conduit thread (nil: run it now). */
+    proc start(handle: c_ptr(void)) {
+      job = ddac_conduit_batch_start(handle, c_ptrTo(paths[0]),
+                                     c_ptrTo(results[0]): c_ptr(void),
+                                     n: uint(32));
+    }
+
+    /** Block until the batch (if any) has filled results. */
+    proc wait() {
+      if job != nil {
+        ddac_conduit_batch_wait(job);
+        job = nil;
+      }
+    }
+
+    proc deinit() {
+      wait();
+      for m in mappings do ddac_conduit_unmap(m);
+    }
+  }
+
+  /** Parse reusing a conduit result (SHA-256, no existence re-check). A
+      recognised extension picks the parser, else the magic-byte content
+      kind (ZIP magic is EPUB only for .epub). With a mapping from
+      ddac_conduit_map(), PDF/image/EPUB parse from memory. conduit = nil
+      behaves like ddac_parse. */
+  extern proc ddac_parse_ex(
+    handle: c_ptr(void),
+    input_path: c_ptrConst(c_char),
+    output_path: c_ptrConst(c_char),
+    output_fmt: c_int,
+    stage_flags: uint(64),
+    conduit: c_ptrConst(ddac_conduit_result_t),
+    mapping: c_ptrConst(void)
+  ): ddac_parse_result_t;
+
+  /** Content kind (0-6) ddac_parse_ex parses path as, given the conduit's
+      magic-byte content_kind: a recognised extension wins, so a .geotiff
+      with TIFF magic is geospatial (5), not an image (1). */
+  extern proc ddac_resolve_kind(content_kind: uint(8),
+                                path: c_ptrConst(c_char)): c_int;
+
+  // ── Checkpoint Bitmaps + Journal ─────────────────────────────────────
+
+  /** Open/create a checkpoint bitmap + journal for num_docs documents.
+      keep != 0 keeps completed documents from matching files (resume).
+      Returns nil on failure. */
+  extern proc ddac_ckpt_open(bits_path: c_ptrConst(c_char),
+                             journal_path: c_ptrConst(c_char),
+                             num_docs: uint(64), keep: uint(8),
+                             flush_every: uint(32)): c_ptr(void);
+
+  /** Mark a document completed (thread-safe). 0, or -1 on error. */
+  extern proc ddac_ckpt_mark(ckpt: c_ptr(void), idx: uint(64)): int(32);
+
+  /** OR another checkpoint's files into the resume bitmap. 0, or -1. */
+  extern proc ddac_ckpt_merge(ckpt: c_ptr(void), bits_path: c_ptrConst(c_char),
+                              journal_path: c_ptrConst(c_char)): int(32);
+
+  /** 1 if idx is in the resume bitmap, else 0. */
+  extern proc ddac_ckpt_test(ckpt: c_ptr(void), idx: uint(64)): uint(8);
+
+  /** Number of documents in the resume bitmap. */
+  extern proc ddac_ckpt_resume_count(ckpt: c_ptr(void)): uint(64);
+
+  /** Journal pending marks and compact. 0, or -1 on error. */
+  extern proc ddac_ckpt_sync(ckpt: c_ptr(void)): int(32);
+
+  /** Sync and close (nil-safe). 0, or -1 if the sync failed. */
+  extern proc ddac_ckpt_close(ckpt: c_ptr(void)): int(32);
+
+  // ── Streaming NDJSON Result Writer ───────────────────────────────────
+
+  /** Open a per-locale NDJSON writer with a background writer thread.
+      slab_bytes: per-task buffer (0 = 1 MiB); direct != 0 = O_DIRECT. */
+  extern proc ddac_ndjson_open(path: c_ptrConst(c_char), slab_bytes: uint(32),
+                               direct: uint(8)): c_ptr(void);
+
+  /** Lease a task buffer on a writer (one per task). */
+  extern proc ddac_ndjson_task_buffer(writer: c_ptr(void)): c_ptr(void);
+
+  /** Format one result line into a task buffer (no lock). 0, or -1 if dropped. */
+  extern proc ddac_ndjson_append(buffer: c_ptr(void), input_path: c_ptrConst(c_char),
+                                 result: c_ptrConst(ddac_parse_result_t),
+                                 parse_time_ms: real(64)): int(32);
+
+  /** Hand a task buffer's remaining lines to the writer and free it. */
+  extern proc ddac_ndjson_task_release(buffer: c_ptr(void)): void;
+
+  /** Drain, stop and close a writer. Lines written, or -1 on a write error. */
+  extern proc ddac_ndjson_close(writer: c_ptr(void)): int(64);
+
+  // ── Packed Results Container ─────────────────────────────────────────
+
+  /** Open a per-locale results container in dir_path (segment roll-over
+      at segment_mb; 0 = 4096). append != 0 keeps an existing container
+      and adds to it; 0 truncates. Returns nil on failure. */
+  extern proc ddac_container_open(dir_path: c_ptrConst(c_char),
+                                  segment_mb: uint(32),
+                                  append: uint(8)): c_ptr(void);
+
+  /** Route the next parse on handle into the container as doc_idx. */
+  extern proc ddac_set_container_doc(handle: c_ptr(void), container: c_ptr(void),
+                                     doc_idx: uint(64)): void;
+
+  /** Append a result row. 0, or -1 on failure. */
+  extern proc ddac_container_put_result(container: c_ptr(void), doc_idx: uint(64),
+                                        result: c_ptrConst(void),
+                                        result_size: c_size_t): int(32);
+
+  /** Container counters: blobs, blob bytes, result rows, segment files. */
+  extern proc ddac_container_stats(container: c_ptr(void), blobs: c_ptr(uint(64)),
+                                   bytes: c_ptr(uint(64)), rows: c_ptr(uint(64)),
+                                   segments: c_ptr(uint(32))): void;
+
+  /** Flush and close. 0, or -1 if any write failed. */
+  extern proc ddac_container_close(container: c_ptr(void)): int(32);
+
+  /** Catalog the shards' index records into out_path (segments stay put). */
+  extern proc ddac_container_merge(out_path: c_ptrConst(c_char),
+                                   shard_dirs: c_ptr(c_ptrConst(c_char)),
+                                   n: uint(32)): int(64);
+
+  // ── Parallel Manifest Scanner ────────────────────────────────────────
+
+  /** Manifest entry — 40 bytes, matches ddac_manifest_entry_t.
+      path/kind point into the mapping (not NUL-terminated). */
+  extern record ddac_manifest_entry_t {
+    var path: c_ptrConst(c_char);
+    var path_len: uint(32);          // 0 = NDJSON line without a path
+    var kind_len: uint(32);
+    var kind: c_ptrConst(c_char);
+    var size: int(64);               // bytes, -1 if absent
+    var mtime: int(64);              // Unix seconds, -1 if absent
+  }
+
+  /** Map a manifest read-only. Returns nil if it cannot be opened. */
+  extern proc ddac_manifest_open(path: c_ptrConst(c_char)): c_ptr(void);
+
+  /** Manifest size in bytes. */
+  extern proc ddac_manifest_bytes(manifest: c_ptr(void)): uint(64);
+
+  /** Entries on lines starting in byte range [lo, hi). */
+  extern proc ddac_manifest_count(manifest: c_ptr(void), lo: uint(64),
+                                  hi: uint(64)): uint(64);
+
+  /** Next entry on a line starting in [cursor, hi); 1, or 0 when done. */
+  extern proc ddac_manifest_next(manifest: c_ptr(void), cursor: c_ptr(uint(64)),
+                                 hi: uint(64), ndjson: uint(8),
+                                 entry: c_ptr(ddac_manifest_entry_t)): int(32);
+
+  /** Unmap a manifest (nil-safe). */
+  extern proc ddac_manifest_close(manifest: c_ptr(void)): void;
+
+  // ── Isolated Parse Workers ───────────────────────────────────────────
+
+  /** Start `workers` ddac-parse-worker processes. nil if none started. */
+  extern proc ddac_isolate_create(worker_path: c_ptrConst(c_char),
+                                  workers: uint(32)): c_ptr(void);
+
+  /** Parse in a worker (timeout_ms 0 = none; neardup_verdict may be nil).
+      0 = done, 1 = killed at the deadline, 2 = worker died, -1 = no
+      worker (result_out untouched). */
+  extern proc ddac_isolate_parse(pool: c_ptr(void), input_path: c_ptrConst(c_char),
+                                 output_path: c_ptrConst(c_char), output_fmt: c_int,
+                                 stage_flags: uint(64),
+                                 conduit_result: c_ptrConst(ddac_conduit_result_t),
+                                 neardup_verdict: c_ptrConst(ddac_neardup_verdict_t),
+                                 timeout_ms: uint(32),
+                                 result_out: c_ptr(ddac_parse_result_t)): int(32);
+
+  /** Parses killed at the deadline, worker crashes, respawns. */
+  extern proc ddac_isolate_stats(pool: c_ptr(void), timeouts: c_ptr(uint(64)),
+                                 crashes: c_ptr(uint(64)),
+                                 respawns: c_ptr(uint(64))): void;
+
+  /** Stop all workers (nil-safe). */
+  extern proc ddac_isolate_free(pool: c_ptr(void)): void;
+
+  // ── Latency Metrics ──────────────────────────────────────────────────
+
+  /** Number of phases and buckets per phase. */
+  extern proc ddac_metrics_layout(phases: c_ptr(uint(32)),
+                                  buckets: c_ptr(uint(32))): void;
+
+  /** Name of a phase ("parse", "stage.keywords", ...); "" if out of range. */
+  extern proc ddac_metrics_phase_name(phase: uint(32)): c_ptrConst(c_char);
+
+  /** Sum this process's histograms into counts[phase * buckets + bucket].
+      Returns phases * buckets (nothing written if len is smaller). */
+  extern proc ddac_metrics_snapshot(counts: c_ptr(uint(64)),
+                                    len: c_size_t): c_size_t;
+
+  /** Microseconds at quantile q of one phase's bucket counts (0 if empty). */
+  extern proc ddac_metrics_quantile(counts: c_ptrConst(uint(64)),
+                                    buckets: uint(32), q: real(64)): real(64);
+
+  /** Drop all samples recorded so far. */
+  extern proc ddac_metrics_reset(): void;
+
+  // ── Page-Range PDF Parsing ───────────────────────────────────────────
+
+  /** One page range of a split PDF — 64 bytes, matches ddac_page_part_t. */
+  extern record ddac_page_part_t {
+    var status: c_int;               // 0 = success
+    var first: int(32);              // 0-based first page (clamped)
+    var last: int(32);               // one past the last page
+    var _pad: uint(32);              // alignment padding
+    var word_count: int(64);
+    var char_count: int(64);
+    var parse_time_ms: real(64);
+    var ocr_pages: uint(32);         // scanned pages recognised
+    var ocr_conf_sum: uint(32);      // sum of per-page mean confidences
+    var ocr_words: uint(64);
+    var ocr_chars: uint(64);
+  }
+
+  /** Page count of a PDF (mapping may be nil), -1 if it cannot be opened. */
+  extern proc ddac_pdf_page_count(input_path: c_ptrConst(c_char),
+                                  mapping: c_ptrConst(void)): int(32);
+
+  /** Extract pages [first, last) into part_path and fill part. Only
+      STAGE_MULTI_LANG_OCR of stage_flags applies. Returns part.status. */
+  extern proc ddac_parse_pages(handle: c_ptr(void), input_path: c_ptrConst(c_char),
+                               part_path: c_ptrConst(c_char),
+                               first: int(32), last: int(32),
+                               stage_flags: uint(64), mapping: c_ptrConst(void),
+                               part: c_ptr(ddac_page_part_t)): c_int;
+
+  /** Concatenate the part files (page order) into output_path, delete
+      them, sum the parts into one result and run the stages over the
+      whole text. A failed part fails the document. */
+  extern proc ddac_parse_stitch(handle: c_ptr(void), input_path: c_ptrConst(c_char),
+                                output_path: c_ptrConst(c_char),
+                                part_paths: c_ptrConst(c_ptrConst(c_char)),
+                                parts: c_ptrConst(ddac_page_part_t),
+                                n_parts: uint(32), output_fmt: c_int,
+                                stage_flags: uint(64),
+                                conduit_result: c_ptrConst(ddac_conduit_result_t),
+                                mapping: c_ptrConst(void)): ddac_parse_result_t;
+
+  // ── Near-Duplicate Index ─────────────────────────────────────────────
+
+  /** Near-duplicate decision reached before the parse — 24 bytes, matches
+      ddac_neardup_verdict_t. */
+  extern record ddac_neardup_verdict_t {
+    var hash: uint(64);              // the image's average hash
+    var match_doc: uint(64);         // nearest indexed document, if matched
+    var distance: uint(8);
+    var matched: uint(8);            // 0 = unique
+    var max_hamming: uint(8);        // radius the decision was made at
+    var _pad: c_array(uint(8), 5);   // alignment padding
+  }
+
+  /** ddac_neardup_check_batch distance for a hash with no match. */
+  param DDAC_NEARDUP_NO_MATCH: uint(8) = 0xFF;
+
+  /** Empty near-duplicate index, or nil. */
+  extern proc ddac_neardup_create(): c_ptr(void);
+
+  /** Index over a snapshot from ddac_neardup_save; nil if missing/invalid. */
+  extern proc ddac_neardup_open(path: c_ptrConst(c_char)): c_ptr(void);
+
+  /** Index hash as doc_id. Thread-safe. 0, or -1 on failure. */
+  extern proc ddac_neardup_insert(index: c_ptr(void), hash: uint(64),
+                                  doc_id: uint(64)): int(32);
+
+  /** Up to max_out (<= 64) hashes within max_hamming bits, nearest first. */
+  extern proc ddac_neardup_query(index: c_ptr(void), hash: uint(64),
+                                 max_hamming: uint(8),
+                                 out_doc_ids: c_ptr(uint(64)),
+                                 out_distances: c_ptr(uint(8)),
+                                 max_out: uint(32)): int(32);
+
+  /** Number of indexed hashes. */
+  extern proc ddac_neardup_count(index: c_ptr(void)): uint(64);
+
+  /** Write the index as a snapshot. 0, or -1 on failure. */
+  extern proc ddac_neardup_save(index: c_ptr(void), path: c_ptrConst(c_char)): int(32);
+
+  /** Shards (of n_shards) owning a chunk value within max_hamming / 4
+      bits of hash's: max_hamming 0 = where hash is inserted (<= 4), the
+      query radius = every shard a query visits. out_shards: room for
+      n_shards. Returns the count. */
+  extern proc ddac_neardup_shards(hash: uint(64), max_hamming: uint(8),
+                                  n_shards: uint(32),
+                                  out_shards: c_ptr(uint(32))): uint(32);
+
+  /** Nearest indexed hash of another document within max_hamming bits,
+      per hash (distance DDAC_NEARDUP_NO_MATCH if none). Read-only. */
+  extern proc ddac_neardup_check_batch(index: c_ptr(void),
+                                       hashes: c_ptrConst(uint(64)),
+                                       doc_ids: c_ptrConst(uint(64)),
+                                       n: uint(32), max_hamming: uint(8),
+                                       out_doc_ids: c_ptr(uint(64)),
+                                       out_distances: c_ptr(uint(8))): int(32);
+
+  /** Index n hashes, skipping any its document already has. Returns the
+      number added, or -1. */
+  extern proc ddac_neardup_insert_batch(index: c_ptr(void),
+                                        hashes: c_ptrConst(uint(64)),
+                                        doc_ids: c_ptrConst(uint(64)),
+                                        n: uint(32)): int(32);
+
+  extern proc ddac_neardup_free(index: c_ptr(void)): void;
+
+  /** Average hash of an image document (mapping may be nil). 0, or -1 if
+      it cannot be decoded. */
+  extern proc ddac_image_ahash(path: c_ptrConst(c_char), mapping: c_ptrConst(void),
+                               out_hash: c_ptr(uint(64))): int(32);
+
+  /** Check the next parse's image against index as doc_id and add it;
+      a near-duplicate skips its OCR/ML stages. One parse; nil clears. */
+  extern proc ddac_set_neardup_doc(handle: c_ptr(void), index: c_ptr(void),
+                                   doc_id: uint(64), max_hamming: uint(8)): void;
+
+  /** Hand the next parse's image a verdict reached against the sharded
+      index; a match skips its OCR/ML stages. One parse; nil clears. */
+  extern proc ddac_set_neardup_verdict(handle: c_ptr(void),
+                                       verdict: c_ptrConst(ddac_neardup_verdict_t)): void;
+
+  // ── Stage Re-extraction ──────────────────────────────────────────────
+
+  /** Stages still to run: requested & ~existing. */
+  extern proc ddac_reextract_plan(existing_mask: uint(64),
+                                  requested_mask: uint(64)): uint(64);
+
+  /** Run stage_flags over the extracted text at output_path (no base
+      parse) and add them to its .stages.capnp in place. result is the
+      document's cached ParseResult; stages_out gets the message's new
+      mask. 0, 2 = no extracted text, 1 = not extended (parse in full). */
+  extern proc ddac_reextract_stages(handle: c_ptr(void), input_path: c_ptrConst(c_char),
+                                    output_path: c_ptrConst(c_char),
+                                    stage_flags: uint(64),
+                                    result: c_ptr(ddac_parse_result_t),
+                                    stages_out: c_ptr(uint(64))): c_int;
+
   // ── Helpers ───────────────────────────────────────────────────────────
 
   /** Extract a Chapel string from a fixed-size c_char array. */
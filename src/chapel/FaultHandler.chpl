@@ -2,7 +2,10 @@
 //
 // Per-document fault isolation with retry logic.
 // Wraps ddac_parse with retry loop and tracks failure rates
-// per locale to detect systematic problems.
+// per locale to detect systematic problems. With --isolateParse the parse
+// runs in a worker process (ddac_isolate_parse) that is killed at
+// timeoutPerDocMs; otherwise the timeout is only measured. With --reextract,
+// cached documents run only their missing stages (safeReextract).
 //
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
@@ -12,78 +15,174 @@ module FaultHandler {
   use Config;
   use CTypes;
   use Time;
+  use BlockDist;
 
   // ── Per-locale failure tracking ───────────────────────────────────────
 
-  /** Atomic counters for per-locale success/failure tracking.
-      Each locale maintains its own instance. */
-  var localeSuccessCount: atomic int;
-  var localeFailureCount: atomic int;
+  /** Success/failure, straggler and content-type counters of one locale.
+      Only that locale's tasks update them. */
+  record LocaleFaultCounters {
+    var successCount: atomic int;
+    var failureCount: atomic int;
 
-  /** Straggler tracking — documents exceeding a time threshold. */
-  var localeTimeoutCount: atomic int;
-  var localeSlowestMs: atomic int;   // longest parse time seen (milliseconds)
-  var localeTotalMs: atomic int;     // sum of all parse times (for average)
+    /** Straggler tracking — documents exceeding a time threshold. */
+    var timeoutCount: atomic int;
+    var slowestMs: atomic int;   // longest parse time seen (milliseconds)
+    var totalMs: atomic int;     // sum of all parse times (for average)
 
-  /** Per-content-type counters (ContentKind enum: 0-6). */
-  var contentTypeCounts: [0..6] atomic int;
+    /** Per-content-type counters (ContentKind enum: 0-6). */
+    var contentTypeCounts: [0..6] atomic int;
+
+    /** Raised on every locale by checkFailureRate(); read per document. */
+    var aborting: atomic bool;
+  }
+
+  /** One element per locale, stored on that locale (block-distributed like
+      the driver's ResourceSets), so recording a document is a local
+      atomic. Run-wide figures sum the locales (faultTotals). */
+  const faultCounterDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+  var faultCounters: [faultCounterDom] LocaleFaultCounters;
+
+  /** Per-content-type timing samples of successful parses with a known
+      input size: count and the sums the scheduler's least-squares cost
+      fit needs (x = input MB, y = parse ms). */
+  record KindTimingSums {
+    var count: [0..6] int;
+    var sumMB, sumMs, sumMBMs, sumMB2: [0..6] real;
+  }
+
+  /** One locale's cost-model samples, stored on that locale. Plain sums
+      under a lock: a sample costs one local lock round trip rather than
+      five atomic real adds. Summed over the locales once, when the model
+      is refitted (kindTimingTotals). */
+  record LocaleKindTiming {
+    var lock: atomic bool;
+    var sums: KindTimingSums;
+  }
+  var kindTiming: [faultCounterDom] LocaleKindTiming;
+
+  /** Sum every locale's cost-model samples (call once the parses are done). */
+  proc kindTimingTotals(): KindTimingSums {
+    var total = new KindTimingSums();
+    for t in kindTiming {
+      const sums = t.sums;   // one copy off the owning locale
+      total.count += sums.count;
+      total.sumMB += sums.sumMB;
+      total.sumMs += sums.sumMs;
+      total.sumMBMs += sums.sumMBMs;
+      total.sumMB2 += sums.sumMB2;
+    }
+    return total;
+  }
 
   /** Reset counters (call at start of run). */
   proc resetFaultCounters() {
-    localeSuccessCount.write(0);
-    localeFailureCount.write(0);
-    localeTimeoutCount.write(0);
-    localeSlowestMs.write(0);
-    localeTotalMs.write(0);
-    for i in 0..6 do contentTypeCounts[i].write(0);
+    forall c in faultCounters {   // each on its own locale
+      c.successCount.write(0);
+      c.failureCount.write(0);
+      c.timeoutCount.write(0);
+      c.slowestMs.write(0);
+      c.totalMs.write(0);
+      for i in 0..6 do c.contentTypeCounts[i].write(0);
+      c.aborting.write(false);
+    }
+    forall t in kindTiming do t.sums = new KindTimingSums();
+  }
+
+  /** Run-wide sums of every locale's counters (slowestMs is the maximum). */
+  record FaultTotals {
+    var success, failure, timeouts, totalMs, slowestMs: int;
+    var contentTypes: [0..6] int;
+  }
+
+  /** Read every locale's counters once. For reports and the periodic
+      failure-rate check, not the per-document path. */
+  proc faultTotals(): FaultTotals {
+    var t = new FaultTotals();
+    for c in faultCounters {
+      t.success += c.successCount.read();
+      t.failure += c.failureCount.read();
+      t.timeouts += c.timeoutCount.read();
+      t.totalMs += c.totalMs.read();
+      t.slowestMs = max(t.slowestMs, c.slowestMs.read());
+      for i in 0..6 do t.contentTypes[i] += c.contentTypeCounts[i].read();
+    }
+    return t;
   }
 
   /** Record a successful parse with timing. */
   proc recordSuccess() {
-    localeSuccessCount.add(1);
+    faultCounters[here.id].successCount.add(1);
+  }
+
+  /** Document size for a cost-model sample: the conduit's, else the
+      caller's (manifest or stat) size, -1 if neither is known. */
+  proc costBytes(conduit: c_ptrConst(ddac_conduit_result_t), fileSize: int): int {
+    return if conduit != nil then conduit.deref().file_size: int else fileSize;
   }
 
-  /** Record parse timing in milliseconds. */
-  proc recordTiming(ms: int) {
-    localeTotalMs.add(ms);
+  /** Record parse timing in milliseconds. With a content kind and input
+      size (successful parses) it is also a cost-model sample. */
+  proc recordTiming(ms: int, kind: int = -1, bytes: int = -1) {
+    if kind >= 0 && kind <= 6 && bytes >= 0 {
+      const mb = bytes: real / (1024.0 * 1024.0);
+      ref t = kindTiming[here.id];
+      while t.lock.testAndSet() do currentTask.yieldExecution();
+      t.sums.count[kind] += 1;
+      t.sums.sumMB[kind] += mb;
+      t.sums.sumMs[kind] += ms: real;
+      t.sums.sumMBMs[kind] += mb * ms;
+      t.sums.sumMB2[kind] += mb * mb;
+      t.lock.clear();
+    }
+    ref c = faultCounters[here.id];
+    c.totalMs.add(ms);
     // Update slowest (atomic CAS loop)
-    var current = localeSlowestMs.read();
+    var current = c.slowestMs.read();
     while ms > current {
-      if localeSlowestMs.compareExchange(current, ms) then break;
-      current = localeSlowestMs.read();
+      if c.slowestMs.compareExchange(current, ms) then break;
+      current = c.slowestMs.read();
     }
   }
 
   /** Record a content type encounter. */
   proc recordContentType(kind: int) {
     if kind >= 0 && kind <= 6 then
-      contentTypeCounts[kind].add(1);
+      faultCounters[here.id].contentTypeCounts[kind].add(1);
   }
 
   /** Record a timed-out document. */
   proc recordTimeout() {
-    localeTimeoutCount.add(1);
+    faultCounters[here.id].timeoutCount.add(1);
   }
 
   /** Record a failed parse. */
   proc recordFailure() {
-    localeFailureCount.add(1);
+    faultCounters[here.id].failureCount.add(1);
   }
 
-  /** Get current failure rate as a percentage.
+  /** Get the run-wide failure rate as a percentage (all locales).
       Returns 0.0 if fewer than minSamples have been processed. */
   proc currentFailureRate(minSamples: int = 1000): real {
-    const total = localeSuccessCount.read() + localeFailureCount.read();
+    const t = faultTotals();
+    const total = t.success + t.failure;
     if total < minSamples then return 0.0;
-    return (localeFailureCount.read(): real / total: real) * 100.0;
+    return (t.failure: real / total: real) * 100.0;
   }
 
-  /** Check if the run should abort due to excessive failures.
-      Only triggers after 1000+ documents have been processed. */
+  /** Check the run-wide failure rate and, once it exceeds
+      failureThresholdPct (after 1000+ documents), tell every locale to
+      stop. Called periodically by the progress reporter. */
+  proc checkFailureRate(): bool {
+    if currentFailureRate() <= failureThresholdPct then return false;
+    forall c in faultCounters do c.aborting.write(true);
+    return true;
+  }
+
+  /** Whether the run is aborting (checkFailureRate tripped). A local read,
+      cheap enough to check per document. */
   proc shouldAbort(): bool {
-    const total = localeSuccessCount.read() + localeFailureCount.read();
-    if total < 1000 then return false;
-    return currentFailureRate() > failureThresholdPct;
+    return faultCounters[here.id].aborting.read();
   }
 
   // ── Safe parse with retry ─────────────────────────────────────────────
@@ -98,13 +197,24 @@ module FaultHandler {
       inputPath:  absolute path to source document
       outputPath: absolute path for extracted content
       fmtCode:    output format (0=scheme, 1=json, 2=csv)
-      stagesMask: bitmask of processing stages to run (0 = none) */
+      stagesMask: bitmask of processing stages to run (0 = none)
+      conduit:    precomputed conduit result (nil = hash + detect in ddac_parse)
+      mapping:    mmap handle from ddac_conduit_map (nil = parse from path)
+      fileSize:   size for the cost model when there is no conduit result
+                  (manifest or stat size; -1 = unknown)
+      nearDup:    near-duplicate verdict for the image (nil = none), handed
+                  to every attempt, in a worker or in-process */
   proc safeParse(
     handle: c_ptr(void),
     inputPath: string,
     outputPath: string,
     fmtCode: int,
-    stagesMask: uint(64) = 0
+    stagesMask: uint(64) = 0,
+    conduit: c_ptrConst(ddac_conduit_result_t) = nil,
+    mapping: c_ptrConst(void) = nil,
+    isolatePool: c_ptr(void) = nil,
+    fileSize: int = -1,
+    nearDup: c_ptrConst(ddac_neardup_verdict_t) = nil
   ): ddac_parse_result_t {
 
     var result: ddac_parse_result_t;
@@ -114,19 +224,47 @@ module FaultHandler {
     while attempts <= maxRetriesPerDoc {
       parseTimer.start();
 
-      result = ddac_parse(
-        handle,
-        inputPath.c_str(),
-        outputPath.c_str(),
-        fmtCode: c_int,
-        stagesMask
-      );
+      // 0 = parsed in a worker, 1 = killed at the deadline, 2 = worker died
+      var isolated: int(32) = -1;
+      if isolatePool != nil then
+        isolated = ddac_isolate_parse(isolatePool, inputPath.c_str(),
+                                      outputPath.c_str(), fmtCode: c_int,
+                                      stagesMask, conduit, nearDup,
+                                      timeoutPerDocMs: uint(32), c_ptrTo(result));
+
+      // No worker available: parse on the task's own handle.
+      // ddac_parse_ex with a nil conduit is exactly ddac_parse
+      if isolated < 0 {
+        if nearDup != nil then ddac_set_neardup_verdict(handle, nearDup);
+        result = ddac_parse_ex(
+          handle,
+          inputPath.c_str(),
+          outputPath.c_str(),
+          fmtCode: c_int,
+          stagesMask,
+          conduit,
+          mapping
+        );
+      }
 
       parseTimer.stop();
       const elapsedMs = (parseTimer.elapsed() * 1000.0): int;
-      recordTiming(elapsedMs);
+      if parseSucceeded(result) then
+        recordTiming(elapsedMs, result.content_kind: int, costBytes(conduit, fileSize));
+      else
+        recordTiming(elapsedMs);
       recordContentType(result.content_kind: int);
 
+      // Killed at the deadline: it would only hit it again, no retry
+      if isolated == 1 {
+        recordTimeout();
+        recordFailure();
+        writeln("[timeout] ", inputPath, " killed after ", timeoutPerDocMs, "ms");
+        return result;
+      }
+      if isolated == 2 then
+        writeln("[fault] Parse worker died on: ", inputPath);
+
       // Check for straggler (exceeds timeout threshold)
       if elapsedMs > timeoutPerDocMs {
         recordTimeout();
@@ -156,16 +294,137 @@ module FaultHandler {
     return result;
   }
 
-  /** Get a summary of fault statistics for this locale. */
+  // ── Page-range parse of large PDFs ────────────────────────────────────
+
+  /** Parse a PDF of `pages` pages as ranges of pdfPagesPerRange pages in
+      parallel: each range runs ddac_parse_pages on its own pooled handle
+      into a part file next to outputPath, then ddac_parse_stitch joins
+      the parts on `handle` into one result and one output and runs the
+      stages over the whole text. If the stitch fails the document is
+      parsed whole by safeParse (with its retries).
+
+      pool: the locale's parse-handle pool (grows past maxTaskPar if
+            every handle is leased)
+      fileSize: as for safeParse */
+  proc safeParseSplit(
+    handle: c_ptr(void),
+    pool: c_ptr(void),
+    inputPath: string,
+    outputPath: string,
+    fmtCode: int,
+    stagesMask: uint(64),
+    conduit: c_ptrConst(ddac_conduit_result_t),
+    mapping: c_ptrConst(void),
+    pages: int,
+    fileSize: int = -1
+  ): ddac_parse_result_t {
+
+    const perRange = max(1, pdfPagesPerRange);
+    const nRanges = (pages + perRange - 1) / perRange;
+    var partPaths: [0..#nRanges] string;
+    var partPtrs: [0..#nRanges] c_ptrConst(c_char);
+    var parts: [0..#nRanges] ddac_page_part_t;
+    for r in 0..#nRanges {
+      partPaths[r] = outputPath + ".part" + r:string;
+      partPtrs[r] = partPaths[r].c_str();
+    }
+
+    var parseTimer: stopwatch;
+    parseTimer.start();
+
+    // One task per range, each on its own leased handle
+    forall r in 0..#nRanges with (var lease = new PooledHandle(pool)) {
+      const first = (r * perRange): int(32);
+      const last = min(pages, (r + 1) * perRange): int(32);
+      if lease.handle == nil then
+        parts[r].status = 4;
+      else
+        ddac_parse_pages(lease.handle, inputPath.c_str(), partPtrs[r],
+                         first, last, stagesMask, mapping, c_ptrTo(parts[r]));
+    }
+
+    var result = ddac_parse_stitch(handle, inputPath.c_str(), outputPath.c_str(),
+                                   c_ptrToConst(partPtrs[0]), c_ptrToConst(parts[0]),
+                                   nRanges: uint(32), fmtCode: c_int, stagesMask,
+                                   conduit, mapping);
+    parseTimer.stop();
+
+    if !parseSucceeded(result) {
+      writeln("[split] ", inputPath, ": ", parseErrorMsg(result),
+              " — parsing it whole");
+      return safeParse(handle, inputPath, outputPath, fmtCode, stagesMask,
+                       conduit, mapping, fileSize=fileSize);
+    }
+
+    const elapsedMs = (parseTimer.elapsed() * 1000.0): int;
+    recordTiming(elapsedMs, result.content_kind: int, costBytes(conduit, fileSize));
+    recordContentType(result.content_kind: int);
+    if elapsedMs > timeoutPerDocMs {
+      recordTimeout();
+      writeln("[straggler] ", inputPath, " took ", elapsedMs, "ms over ",
+              nRanges, " page ranges (timeout=", timeoutPerDocMs, "ms)");
+    }
+    recordSuccess();
+    return result;
+  }
+
+  // ── Stage-only re-extraction (--reextract) ────────────────────────────
+
+  /** Add `missing` stages to a document the L1 cache holds: they run over
+      the extracted text at outputPath, with no base parse, and are added
+      to its .stages.capnp in place. On success result (the cached
+      ParseResult) gets the new status and timing, stagesHeld the stage
+      message's new mask, and the document is recorded.
+
+      Returns false, leaving both untouched, when the document must be
+      parsed in full instead: its extracted text is gone, its stage
+      message could not be extended, or a missing stage comes out of the
+      base parse itself (an image's OCR confidence, a PDF's scanned-page
+      OCR). */
+  proc safeReextract(
+    handle: c_ptr(void),
+    inputPath: string,
+    outputPath: string,
+    missing: uint(64),
+    ref result: ddac_parse_result_t,
+    ref stagesHeld: uint(64)
+  ): bool {
+    if (result.content_kind == 1 && (missing & STAGE_OCR_CONFIDENCE) != 0) ||
+       (result.content_kind == 0 && (missing & STAGE_MULTI_LANG_OCR) != 0) then
+      return false;
+
+    var attempt = result;   // the cached result survives a failed attempt
+    var held: uint(64);
+    var timer: stopwatch;
+    timer.start();
+    const rc = ddac_reextract_stages(handle, inputPath.c_str(), outputPath.c_str(),
+                                     missing, c_ptrTo(attempt), c_ptrTo(held));
+    timer.stop();
+    if rc != 0 {
+      writeln("[reextract] ", inputPath, ": ", parseErrorMsg(attempt),
+              " — parsing it in full");
+      return false;
+    }
+
+    // Stage-only timings stay out of the per-kind cost model
+    recordTiming((timer.elapsed() * 1000.0): int);
+    recordSuccess();
+    result = attempt;
+    stagesHeld = held;
+    return true;
+  }
+
+  /** Get a summary of fault statistics over all locales. */
   proc faultSummary(): string {
-    const succ = localeSuccessCount.read();
-    const fail = localeFailureCount.read();
-    const timeouts = localeTimeoutCount.read();
+    const t = faultTotals();
+    const succ = t.success;
+    const fail = t.failure;
+    const timeouts = t.timeouts;
     const total = succ + fail;
     const rate = if total > 0 then (fail: real / total: real) * 100.0 else 0.0;
-    const avgMs = if total > 0 then localeTotalMs.read(): real / total: real else 0.0;
-    const slowest = localeSlowestMs.read();
-    return "locale " + here.id:string + ": " +
+    const avgMs = if total > 0 then t.totalMs: real / total: real else 0.0;
+    const slowest = t.slowestMs;
+    return numLocales:string + " locale(s): " +
            succ:string + " ok, " + fail:string + " failed (" +
            rate:string + "%), " +
            timeouts:string + " stragglers, " +
@@ -186,11 +445,12 @@ module FaultHandler {
     }
   }
 
-  /** Get per-content-type breakdown for this locale. */
+  /** Get per-content-type breakdown over all locales. */
   proc contentTypeSummary(): string {
+    const t = faultTotals();
     var parts: string;
     for i in 0..6 {
-      const count = contentTypeCounts[i].read();
+      const count = t.contentTypes[i];
       if count > 0 {
         if parts.size > 0 then parts += ", ";
         parts += contentKindName(i) + "=" + count:string;
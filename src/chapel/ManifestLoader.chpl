@@ -14,9 +14,13 @@
 //   "shared"    — all locales read from a shared filesystem (default)
 //   "broadcast" — locale 0 reads, then broadcasts to all locales
 //
-// Two-pass strategy (for shared mode):
-//   Pass 1: Count valid lines (skip comments, blanks)
-//   Pass 2: Read entries into a block-distributed array
+// The manifest is mmap'd and split into byte ranges, maxTaskPar per
+// locale (ffi/zig/src/manifest_scan.zig). A line belongs to the range
+// holding its first byte, so ranges need no coordination:
+//   Pass 1: every task counts the entries in its range (comments, blanks
+//           skipped); an exclusive prefix sum gives each range's first index
+//   Pass 2: every task parses its range straight into its slice of the
+//           block-distributed array
 //
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
@@ -27,6 +31,8 @@ module ManifestLoader {
   use BlockDist;
   use Random;
   use Config;
+  use CTypes;
+  use FFIBridge;
   use NdjsonManifest;
 
   /** Load a manifest file and return a block-distributed array of DocEntry.
@@ -58,73 +64,70 @@ module ManifestLoader {
   // Shared filesystem mode (default)
   // ══════════════════════════════════════════════════════════════════════
 
-  /** Load manifest assuming all locales share a filesystem. */
+  /** Load manifest assuming all locales share a filesystem.
+      Each locale maps the file and scans maxTaskPar byte ranges of its
+      share in parallel; nothing is read sequentially. */
   proc loadManifestShared(manifestPath: string, isNdjson: bool) throws {
     if !exists(manifestPath) then
       throw new Error("Manifest file not found: " + manifestPath);
 
-    // ── Pass 1: count valid lines ───────────────────────────────────
-    var lineCount = 0;
-    {
-      var f = open(manifestPath, ioMode.r);
-      var reader = f.reader(locking=false);
-      var line: string;
-      while reader.readLine(line) {
-        const trimmed = line.strip();
-        if trimmed.size > 0 && !trimmed.startsWith("#") then
-          lineCount += 1;
+    const locDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+    var maps: [locDom] c_ptr(void);
+    var mapFailed: atomic bool;
+    coforall loc in Locales with (ref maps) do on loc {
+      maps[here.id] = ddac_manifest_open(manifestPath.c_str());
+      if maps[here.id] == nil then mapFailed.write(true);
+    }
+    defer {
+      coforall loc in Locales do on loc do ddac_manifest_close(maps[here.id]);
+    }
+    if mapFailed.read() then
+      throw new Error("Cannot map manifest on every locale: " + manifestPath);
+
+    // Byte range c belongs to the locale owning chunk c: maxTaskPar each
+    const fileBytes = ddac_manifest_bytes(maps[0]);
+    const numChunks = numLocales * here.maxTaskPar;
+    const chunkDom = {0..#numChunks} dmapped new blockDist({0..#numChunks});
+
+    // ── Pass 1: count entries per byte range ────────────────────────
+    var chunkCounts: [chunkDom] int;
+    coforall loc in Locales with (ref chunkCounts) do on loc {
+      const m = maps[here.id];
+      forall c in chunkDom.localSubdomain() with (ref chunkCounts) {
+        const (lo, hi) = chunkBytes(c, numChunks, fileBytes);
+        chunkCounts[c] = ddac_manifest_count(m, lo, hi): int;
       }
     }
 
+    const lineCount = + reduce chunkCounts;
     if lineCount == 0 then
       throw new Error("Manifest is empty (no valid entries): " + manifestPath);
 
-    writeln("[manifest] ", lineCount, " entries found in ", manifestPath);
+    writeln("[manifest] ", lineCount, " entries found in ", manifestPath,
+            " (", numChunks, " ranges scanned on ", numLocales, " locales)");
+
+    // Exclusive prefix sum: index of each range's first entry
+    const chunkFirst: [chunkDom] int = (+ scan chunkCounts) - chunkCounts;
 
-    // ── Pass 2: read into block-distributed array ───────────────────
+    // ── Pass 2: parse each range into its slice of the array ────────
+    // Ranges are proportional in bytes and the array is blocked by index,
+    // so most entries land on the locale that parsed them
     const entryDom = {0..#lineCount} dmapped new blockDist({0..#lineCount});
     var docEntries: [entryDom] DocEntry;
 
-    var actualCount = 0;
-    {
-      var f = open(manifestPath, ioMode.r);
-      var reader = f.reader(locking=false);
-      var line: string;
-      var idx = 0;
-      while reader.readLine(line) {
-        const trimmed = line.strip();
-        if trimmed.size > 0 && !trimmed.startsWith("#") {
-          if idx < lineCount {
-            if isNdjson then
-              docEntries[idx] = parseNdjsonLine(trimmed);
-            else
-              docEntries[idx] = new DocEntry(path=trimmed);
-            idx += 1;
-          }
-        }
+    coforall loc in Locales with (ref docEntries) do on loc {
+      const m = maps[here.id];
+      forall c in chunkDom.localSubdomain() with (ref docEntries) {
+        const (lo, hi) = chunkBytes(c, numChunks, fileBytes);
+        parseRange(m, lo, hi, isNdjson, docEntries, chunkFirst[c]);
       }
-      actualCount = idx;
-    }
-
-    // If actual count differs from pass-1 count, use the smaller value
-    if actualCount < lineCount {
-      writeln("[manifest] Note: ", lineCount - actualCount,
-              " fewer entries read in pass 2 (", actualCount, " vs ", lineCount,
-              "); using ", actualCount, " entries");
-      const fixedDom = {0..#actualCount} dmapped new blockDist({0..#actualCount});
-      var fixedEntries: [fixedDom] DocEntry;
-      forall i in fixedDom do fixedEntries[i] = docEntries[i];
-      validateEntrySample(fixedEntries, actualCount);
-      return fixedEntries;
     }
 
     validateEntrySample(docEntries, lineCount);
 
     if isNdjson {
       // Report metadata coverage
-      var metaCount = 0;
-      for entry in docEntries do
-        if entry.hasMetadata() then metaCount += 1;
+      const metaCount = + reduce [e in docEntries] e.hasMetadata(): int;
       writeln("[manifest] ", metaCount, "/", lineCount,
               " entries have pre-computed metadata (stat()-free)");
     }
@@ -139,26 +142,28 @@ module ManifestLoader {
   /** Load manifest on locale 0, then broadcast to all locales. */
   proc loadManifestBroadcast(manifestPath: string, isNdjson: bool) throws {
     var lineCount = 0;
-    var localEntries: [0..0] DocEntry;
+    var localDom: domain(1);
+    var localEntries: [localDom] DocEntry;
 
-    // ── Locale 0 reads the entire manifest ──────────────────────────
+    // ── Locale 0 scans the entire manifest with all its tasks ───────
     on Locales[0] {
       if !exists(manifestPath) then
         throw new Error("Manifest file not found on locale 0: " + manifestPath);
 
-      // Pass 1: count
-      var count = 0;
-      {
-        var f = open(manifestPath, ioMode.r);
-        var reader = f.reader(locking=false);
-        var line: string;
-        while reader.readLine(line) {
-          const trimmed = line.strip();
-          if trimmed.size > 0 && !trimmed.startsWith("#") then
-            count += 1;
-        }
+      const m = ddac_manifest_open(manifestPath.c_str());
+      if m == nil then
+        throw new Error("Cannot map manifest on locale 0: " + manifestPath);
+      defer ddac_manifest_close(m);
+
+      const fileBytes = ddac_manifest_bytes(m);
+      const numChunks = here.maxTaskPar;
+      var chunkCounts: [0..#numChunks] int;
+      forall c in 0..#numChunks {
+        const (lo, hi) = chunkBytes(c, numChunks, fileBytes);
+        chunkCounts[c] = ddac_manifest_count(m, lo, hi): int;
       }
 
+      const count = + reduce chunkCounts;
       if count == 0 then
         throw new Error("Manifest is empty (no valid entries): " + manifestPath);
 
@@ -166,29 +171,12 @@ module ManifestLoader {
               " (broadcast mode, reading on locale 0)");
 
       lineCount = count;
-
-      // Pass 2: read into local array
-      var entries: [0..#count] DocEntry;
-      {
-        var f = open(manifestPath, ioMode.r);
-        var reader = f.reader(locking=false);
-        var line: string;
-        var idx = 0;
-        while reader.readLine(line) {
-          const trimmed = line.strip();
-          if trimmed.size > 0 && !trimmed.startsWith("#") {
-            if idx < count {
-              if isNdjson then
-                entries[idx] = parseNdjsonLine(trimmed);
-              else
-                entries[idx] = new DocEntry(path=trimmed);
-              idx += 1;
-            }
-          }
-        }
-        lineCount = idx;
+      localDom = {0..#count};
+      const chunkFirst = (+ scan chunkCounts) - chunkCounts;
+      forall c in 0..#numChunks with (ref localEntries) {
+        const (lo, hi) = chunkBytes(c, numChunks, fileBytes);
+        parseRange(m, lo, hi, isNdjson, localEntries, chunkFirst[c]);
       }
-      localEntries = entries[0..#lineCount];
     }
 
     // ── Distribute from locale 0 to all locales ─────────────────────
@@ -204,6 +192,29 @@ module ManifestLoader {
     return docEntries;
   }
 
+  // ══════════════════════════════════════════════════════════════════════
+  // Byte-Range Scanning
+  // ══════════════════════════════════════════════════════════════════════
+
+  /** Byte range [lo, hi) of chunk c out of numChunks equal slices. */
+  private proc chunkBytes(c: int, numChunks: int, fileBytes: uint(64)): (uint(64), uint(64)) {
+    const n = numChunks: uint(64);
+    return (fileBytes * c: uint(64) / n, fileBytes * (c + 1): uint(64) / n);
+  }
+
+  /** Parse the entries on lines starting in [lo, hi) into entries[first..]. */
+  private proc parseRange(m: c_ptr(void), lo: uint(64), hi: uint(64),
+                          isNdjson: bool, ref entries, first: int) throws {
+    var cursor = lo;
+    var scanned: ddac_manifest_entry_t;
+    var idx = first;
+    while ddac_manifest_next(m, c_ptrTo(cursor), hi, isNdjson: uint(8),
+                             c_ptrTo(scanned)) == 1 {
+      entries[idx] = docEntryFromScan(scanned);
+      idx += 1;
+    }
+  }
+
   // ══════════════════════════════════════════════════════════════════════
   // Validation
   // ══════════════════════════════════════════════════════════════════════
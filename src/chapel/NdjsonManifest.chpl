@@ -10,7 +10,9 @@
 //   - Cache lookups use embedded mtime/size directly
 //
 // Streaming output format (one JSON result per line, appended):
-//   {"path":"...","status":0,"pages":42,"words":15000,"time_ms":123.4}
+//   {"path":"...","status":0,"pages":42,"words":15000,"parse_time_ms":123.4}
+// Lines are formatted in Zig (ffi/zig/src/ndjson_writer.zig) into
+// per-task buffers and drained by a per-locale writer thread.
 //
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
@@ -19,6 +21,7 @@ module NdjsonManifest {
   use IO;
   use CTypes;
   use FFIBridge;
+  use Config;
 
   // ══════════════════════════════════════════════════════════════════════
   // Document Entry — carries manifest metadata through the pipeline
@@ -47,88 +50,26 @@ module NdjsonManifest {
   }
 
   // ══════════════════════════════════════════════════════════════════════
-  // NDJSON Line Parser (minimal, no external JSON library)
+  // Manifest Entries (scanned in Zig: ffi/zig/src/manifest_scan.zig)
   // ══════════════════════════════════════════════════════════════════════
 
-  /** Parse a single NDJSON line into a DocEntry.
-      Expected format: {"path":"...","size":N,"mtime":N,"kind":"..."}
-      Fields beyond `path` are optional.
-      Returns a DocEntry, or one with empty path if the line is invalid. */
-  proc parseNdjsonLine(line: string): DocEntry {
+  /** Build a DocEntry from a scanned manifest line.
+      Expected NDJSON: {"path":"...","size":N,"mtime":N,"kind":"..."}
+      Fields beyond `path` are optional; a line without one yields an
+      entry with an empty path. */
+  proc docEntryFromScan(const ref e: ddac_manifest_entry_t): DocEntry throws {
     var entry: DocEntry;
+    if e.path_len == 0 then return entry;
 
-    // Extract "path" field (required)
-    entry.path = extractStringField(line, "path");
-    if entry.path == "" then return entry;
-
-    // Extract optional numeric fields
-    entry.size = extractIntField(line, "size");
-    entry.mtime = extractIntField(line, "mtime");
-    entry.kind = extractStringField(line, "kind");
+    entry.path = string.createCopyingBuffer(e.path, e.path_len: int);
+    entry.size = e.size;
+    entry.mtime = e.mtime;
+    if e.kind_len > 0 then
+      entry.kind = string.createCopyingBuffer(e.kind, e.kind_len: int);
 
     return entry;
   }
 
-  /** Extract a string value for a given key from a JSON line.
-      Finds "key":"value" and returns value. Returns "" if not found. */
-  private proc extractStringField(line: string, key: string): string {
-    const needle = '"' + key + '":"';
-    const pos = line.find(needle);
-    if pos == -1 then return "";
-
-    const valStart = pos + needle.size;
-    if valStart >= line.size then return "";
-
-    // Find closing quote (handle escaped quotes minimally)
-    var valEnd = valStart;
-    while valEnd < line.size {
-      if line[valEnd] == '"' && (valEnd == valStart || line[valEnd - 1] != '\\') then
-        break;
-      valEnd += 1;
-    }
-
-    if valEnd > valStart {
-      try {
-        return line[valStart..#(valEnd - valStart)];
-      } catch {
-        return "";
-      }
-    } else {
-      return "";
-    }
-  }
-
-  /** Extract an integer value for a given key from a JSON line.
-      Finds "key":N and returns N. Returns -1 if not found. */
-  private proc extractIntField(line: string, key: string): int(64) {
-    const needle = '"' + key + '":';
-    const pos = line.find(needle);
-    if pos == -1 then return -1;
-
-    const valStart = pos + needle.size;
-    if valStart >= line.size then return -1;
-
-    // Read digits (and optional leading minus)
-    var numStr = "";
-    var i = valStart;
-    if i < line.size && line[i] == '-' {
-      numStr += "-";
-      i += 1;
-    }
-    while i < line.size && line[i] >= '0' && line[i] <= '9' {
-      numStr += line[i];
-      i += 1;
-    }
-
-    if numStr.size == 0 || numStr == "-" then return -1;
-
-    try {
-      return numStr: int(64);
-    } catch {
-      return -1;
-    }
-  }
-
   /** Detect whether a manifest file is NDJSON (first non-comment line starts with '{').
       Returns true for NDJSON, false for plain text. */
   proc detectNdjsonManifest(manifestPath: string): bool {
@@ -154,94 +95,68 @@ module NdjsonManifest {
 
   /** Per-locale streaming NDJSON output writer.
       Appends one JSON line per processed document to:
-        {outputDir}/shard-{localeId}/results.ndjson */
+        {outputDir}/shard-{localeId}/results.ndjson
+      Lines are formatted by the FFI writer (ddac_ndjson_*) into per-task
+      buffers and written by a background thread; tasks write through an
+      NdjsonTaskBuffer, never through this record directly. */
   record NdjsonWriter {
-    var ch: fileWriter(locking=true);
+    var handle: c_ptr(void) = nil;
     var active: bool = false;
 
-    /** Write a single result line.
-        Fields match ddac_parse_result_t but in JSON for interoperability. */
-    proc ref writeResult(inputPath: string, const ref result: ddac_parse_result_t,
-                         parseTimeMs: real) {
+    /** Drain every task's lines, stop the writer thread and close the file.
+        All NdjsonTaskBuffers must be gone. */
+    proc ref close() {
       if !active then return;
+      const lines = ddac_ndjson_close(handle);
+      if lines < 0 then
+        writeln("[warn] NDJSON output incomplete on locale ", here.id, " (write error)");
+      handle = nil;
+      active = false;
+    }
+  }
 
-      // Build JSON line manually (no external JSON library)
-      var line = '{"path":' + jsonEscapeString(inputPath);
-      line += ',"status":' + result.status:string;
-      line += ',"content_kind":' + result.content_kind:string;
-      line += ',"pages":' + result.page_count:string;
-      line += ',"words":' + result.word_count:string;
-      line += ',"chars":' + result.char_count:string;
-
-      if result.duration_sec > 0.0 then
-        line += ',"duration_sec":' + result.duration_sec:string;
-
-      line += ',"parse_time_ms":' + parseTimeMs:string;
-
-      // Include SHA-256 if present (FFI strings are well-formed in practice;
-      // throws on UTF-8 boundary errors are skipped to preserve forall task)
-      try {
-        const sha = string.createCopyingBuffer(result.sha256: c_ptrConst(c_char));
-        if sha.size > 0 then
-          line += ',"sha256":' + jsonEscapeString(sha);
-      } catch { }
-
-      // Include title if present
-      try {
-        const title = string.createCopyingBuffer(result.title: c_ptrConst(c_char));
-        if title.size > 0 then
-          line += ',"title":' + jsonEscapeString(title);
-      } catch { }
-
-      line += "}";
-
-      try {
-        ch.writeln(line);
-      } catch {
-        // Silently drop — don't interrupt the pipeline
-      }
+  /** One task's NDJSON buffer, leased for the task's lifetime
+      (`var ndjsonBuf = new NdjsonTaskBuffer(writer)`) and handed to the
+      writer thread when the task ends. */
+  record NdjsonTaskBuffer {
+    var buffer: c_ptr(void);
+
+    proc init(const ref writer: NdjsonWriter) {
+      this.buffer = if writer.active then ddac_ndjson_task_buffer(writer.handle)
+                    else nil;
     }
 
-    /** Flush buffered output. */
-    proc ref flush() {
-      if active {
-        try { ch.flush(); } catch { }
-      }
+    // A copy must not share the lease; it writes nothing
+    proc init=(other: NdjsonTaskBuffer) {
+      this.buffer = nil;
+    }
+
+    proc deinit() {
+      if buffer != nil then ddac_ndjson_task_release(buffer);
+    }
+
+    /** Write a single result line, formatted from the result struct in
+        place. Fields match ddac_parse_result_t but in JSON for
+        interoperability. Dropped lines don't interrupt the pipeline. */
+    proc writeResult(inputPath: string, const ref result: ddac_parse_result_t,
+                     parseTimeMs: real) {
+      if buffer == nil then return;
+      ddac_ndjson_append(buffer, inputPath.c_str(), c_ptrToConst(result),
+                         parseTimeMs);
     }
   }
 
   /** Create a streaming NDJSON writer for the current locale. */
   proc initNdjsonWriter(shardPath: string): NdjsonWriter {
     const ndjsonPath = shardPath + "/results.ndjson";
-    try {
-      var f = open(ndjsonPath, ioMode.cw);
-      var writer = f.writer(locking=true);
-      return new NdjsonWriter(ch=writer, active=true);
-    } catch {
+    const h = ddac_ndjson_open(ndjsonPath.c_str(),
+                               (ndjsonBufferKB * 1024): uint(32),
+                               ndjsonDirectIO: uint(8));
+    if h == nil {
       writeln("[warn] Cannot open NDJSON output: ", ndjsonPath);
       var dummy: NdjsonWriter;
       return dummy;
     }
-  }
-
-  // ══════════════════════════════════════════════════════════════════════
-  // JSON Helpers
-  // ══════════════════════════════════════════════════════════════════════
-
-  /** Escape a string for JSON (handles quotes and backslashes). */
-  private proc jsonEscapeString(s: string): string {
-    var result = '"';
-    for ch in s {
-      select ch {
-        when '"'  do result += '\\"';
-        when '\\' do result += '\\\\';
-        when '\n' do result += '\\n';
-        when '\r' do result += '\\r';
-        when '\t' do result += '\\t';
-        otherwise do result += ch;
-      }
-    }
-    result += '"';
-    return result;
+    return new NdjsonWriter(handle=h, active=true);
   }
 }
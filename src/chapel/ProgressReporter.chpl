@@ -10,14 +10,17 @@ module ProgressReporter {
   use Time;
   use Config;
   use FaultHandler;
+  use BlockDist;
 
   // ── Shared state ──────────────────────────────────────────────────────
 
   /** Total number of documents in this run. Set by initProgress(). */
   var totalDocs: int = 0;
 
-  /** Atomic counter of completed documents (success + failure). */
-  var completedDocs: atomic int;
+  /** Completed documents (success + failure), one counter per locale
+      stored on that locale; the reporter sums them (completedTotal). */
+  const completedDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+  var completedDocs: [completedDom] atomic int;
 
   /** Flag to signal the report loop to stop. */
   var reporterDone: atomic bool;
@@ -28,14 +31,21 @@ module ProgressReporter {
       Call once before starting the forall loop. */
   proc initProgress(total: int) {
     totalDocs = total;
-    completedDocs.write(0);
+    forall c in completedDocs do c.write(0);
     reporterDone.write(false);
   }
 
   /** Record that one document has been processed (success or failure).
       Call from inside the forall loop after safeParse returns. */
   proc recordCompletion() {
-    completedDocs.add(1);
+    completedDocs[here.id].add(1);
+  }
+
+  /** Documents completed on every locale. */
+  proc completedTotal(): int {
+    var done = 0;
+    for c in completedDocs do done += c.read();
+    return done;
   }
 
   /** Signal the reporter loop to stop.
@@ -50,7 +60,7 @@ module ProgressReporter {
     while !reporterDone.read() {
       sleep(progressIntervalSec: real);
 
-      const done = completedDocs.read();
+      const done = completedTotal();
       const elapsed = timer.elapsed();
 
       if done == 0 || elapsed < 0.1 then continue;
@@ -59,18 +69,18 @@ module ProgressReporter {
       const rate = done: real / elapsed;
       const remaining = totalDocs - done;
       const eta = if rate > 0.0 then remaining: real / rate else 0.0;
-      const failures = localeFailureCount.read();
-
-      const timeouts = localeTimeoutCount.read();
-      const avgMs = if done > 0 then localeTotalMs.read(): real / done: real else 0.0;
+      const faults = faultTotals();
+      const failures = faults.failure;
+      const timeouts = faults.timeouts;
+      const avgMs = if done > 0 then faults.totalMs: real / done: real else 0.0;
 
       writeln("[", formatDuration(elapsed), "] ",
               done, "/", totalDocs, " (", pct:string, "%) | ",
               rate:string, " docs/s | ETA ", formatDuration(eta), " | ",
               failures, " fail, ", timeouts, " straggle | avg ", avgMs:string, "ms");
 
-      // Check for abort condition
-      if shouldAbort() {
+      // Check for abort condition (stops every locale's tasks)
+      if checkFailureRate() {
         writeln("[ABORT] Failure rate exceeds ", failureThresholdPct, "% — stopping run");
         reporterDone.write(true);
         return;
@@ -78,7 +88,7 @@ module ProgressReporter {
     }
 
     // Final report
-    const done = completedDocs.read();
+    const done = completedTotal();
     const elapsed = timer.elapsed();
     const pct = if totalDocs > 0 then (done: real / totalDocs: real) * 100.0 else 100.0;
     const rate = if elapsed > 0.0 then done: real / elapsed else 0.0;
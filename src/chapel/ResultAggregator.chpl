@@ -7,10 +7,12 @@
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
 
 module ResultAggregator {
+  use CTypes;
   use FFIBridge;
   use ContentType;
   use IO;
   use FileSystem;
+  use BlockDist;
 
   // ── Per-Locale Statistics ─────────────────────────────────────────────
 
@@ -35,44 +37,109 @@ module ResultAggregator {
     var epubCount: int = 0;
     var geoCount: int = 0;
     var unknownCount: int = 0;
+
+    // Work stealing (WorkScheduler)
+    var steals: int = 0;
+    var stolenChunks: int = 0;
+    var stolenDocs: int = 0;
   }
 
-  /** Per-locale stats storage. Each locale writes only to its own slot. */
-  var perLocaleStats: [0..#numLocales] LocaleStats;
+  /** Per-locale stats storage. Each locale writes only to its own slot,
+      which is stored on that locale (block-distributed), so merging a
+      chunk involves no communication. */
+  const perLocaleDom = {0..#numLocales} dmapped new blockDist({0..#numLocales});
+  var perLocaleStats: [perLocaleDom] LocaleStats;
+
+  /** Held while a chunk's totals are merged into perLocaleStats[i]: every
+      task of locale i accumulates into the same slot. Lives on locale i. */
+  var perLocaleStatsLock: [perLocaleDom] atomic bool;
 
   /** Reset all per-locale stats (call at start of run). */
   proc resetStats() {
-    for i in 0..#numLocales do
-      perLocaleStats[i] = new LocaleStats();
+    forall s in perLocaleStats do s = new LocaleStats();   // each on its own locale
   }
 
-  /** Accumulate a single parse result into the current locale's stats. */
-  proc accumulate(const ref result: ddac_parse_result_t) {
-    ref stats = perLocaleStats[here.id];
-
-    stats.totalDocs += 1;
-
-    if result.status == 0 {
-      stats.successDocs += 1;
-      stats.totalPages += result.page_count: int(64);
-      stats.totalWords += result.word_count;
-      stats.totalChars += result.char_count;
-      stats.totalDurationSec += result.duration_sec;
-      stats.totalParseTimeMs += result.parse_time_ms;
-
-      // Count by content kind
-      select result.content_kind {
-        when 0 do stats.pdfCount += 1;
-        when 1 do stats.imageCount += 1;
-        when 2 do stats.audioCount += 1;
-        when 3 do stats.videoCount += 1;
-        when 4 do stats.epubCount += 1;
-        when 5 do stats.geoCount += 1;
-        otherwise do stats.unknownCount += 1;
+  /** Add another set of per-document totals (not the steal counts). */
+  proc ref LocaleStats.add(const ref other: LocaleStats) {
+    totalDocs += other.totalDocs;
+    successDocs += other.successDocs;
+    failedDocs += other.failedDocs;
+    totalPages += other.totalPages;
+    totalWords += other.totalWords;
+    totalChars += other.totalChars;
+    totalDurationSec += other.totalDurationSec;
+    totalParseTimeMs += other.totalParseTimeMs;
+    pdfCount += other.pdfCount;
+    imageCount += other.imageCount;
+    audioCount += other.audioCount;
+    videoCount += other.videoCount;
+    epubCount += other.epubCount;
+    geoCount += other.geoCount;
+    unknownCount += other.unknownCount;
+  }
+
+  /** Accumulate a chunk of results (slots where counted[i] is set) into
+      the current locale's stats. The fields are gathered into columns by
+      ddac_parse_columns and reduced column by column, rather than walking
+      the 952-byte result structs once per document. The chunk is reduced
+      on its own, then merged into the locale's slot under its lock. */
+  proc accumulateChunk(const ref results: [?D] ddac_parse_result_t,
+                       const ref counted: [D] bool) {
+    const n = D.size;
+    if n == 0 then return;
+
+    var status, kind, pages: [0..#n] c_int;
+    var words, chars: [0..#n] int(64);
+    var durations, parseTimes: [0..#n] real(64);
+    var cols: ddac_parse_columns_t;
+    cols.status = c_ptrTo(status[0]);
+    cols.content_kind = c_ptrTo(kind[0]);
+    cols.page_count = c_ptrTo(pages[0]);
+    cols.word_count = c_ptrTo(words[0]);
+    cols.char_count = c_ptrTo(chars[0]);
+    cols.duration_sec = c_ptrTo(durations[0]);
+    cols.parse_time_ms = c_ptrTo(parseTimes[0]);
+    ddac_parse_columns(c_ptrToConst(results[D.low]), n: uint(32), cols);
+
+    const live = [i in 0..#n] counted[D.low + i];
+    const ok = [i in 0..#n] live[i] && status[i] == 0;
+
+    var chunk = new LocaleStats();
+    const nLive = + reduce (live: int);
+    const nOk = + reduce (ok: int);
+    chunk.totalDocs = nLive;
+    chunk.successDocs = nOk;
+    chunk.failedDocs = nLive - nOk;
+    chunk.totalPages = + reduce [i in 0..#n] if ok[i] then pages[i]: int(64) else 0: int(64);
+    chunk.totalWords = + reduce [i in 0..#n] if ok[i] then words[i] else 0: int(64);
+    chunk.totalChars = + reduce [i in 0..#n] if ok[i] then chars[i] else 0: int(64);
+    chunk.totalDurationSec = + reduce [i in 0..#n] if ok[i] then durations[i] else 0.0;
+    chunk.totalParseTimeMs = + reduce [i in 0..#n] if ok[i] then parseTimes[i] else 0.0;
+
+    // Count by content kind
+    for i in 0..#n {
+      if !ok[i] then continue;
+      select kind[i] {
+        when 0 do chunk.pdfCount += 1;
+        when 1 do chunk.imageCount += 1;
+        when 2 do chunk.audioCount += 1;
+        when 3 do chunk.videoCount += 1;
+        when 4 do chunk.epubCount += 1;
+        when 5 do chunk.geoCount += 1;
+        otherwise do chunk.unknownCount += 1;
       }
-    } else {
-      stats.failedDocs += 1;
     }
+
+    ref lock = perLocaleStatsLock[here.id];
+    while lock.testAndSet() do currentTask.yieldExecution();
+    perLocaleStats[here.id].add(chunk);
+    lock.clear();
+  }
+
+  /** Record a locale's work-stealing counts (steals, chunks, documents). */
+  proc recordSteals(locId: int, counts: (int, int, int)) {
+    ref stats = perLocaleStats[locId];
+    (stats.steals, stats.stolenChunks, stats.stolenDocs) = counts;
   }
 
   // ── Global Statistics ─────────────────────────────────────────────────
@@ -97,6 +164,19 @@ module ResultAggregator {
     var epubCount: int = 0;
     var geoCount: int = 0;
     var unknownCount: int = 0;
+
+    // Work stealing (WorkScheduler)
+    var steals: int = 0;
+    var stolenChunks: int = 0;
+    var stolenDocs: int = 0;
+
+    // Per-phase latency (ddac_metrics_*), phases with samples only
+    var phaseDom: domain(1);
+    var phaseName: [phaseDom] string;
+    var phaseCount: [phaseDom] int;
+    var phaseP50Ms: [phaseDom] real;
+    var phaseP99Ms: [phaseDom] real;
+    var phaseP999Ms: [phaseDom] real;
   }
 
   /** Reduce per-locale stats into a single GlobalStats. */
@@ -121,11 +201,58 @@ module ResultAggregator {
       g.epubCount += s.epubCount;
       g.geoCount += s.geoCount;
       g.unknownCount += s.unknownCount;
+      g.steals += s.steals;
+      g.stolenChunks += s.stolenChunks;
+      g.stolenDocs += s.stolenDocs;
     }
 
+    mergeLatency(g);
     return g;
   }
 
+  /** Sum every locale's latency histograms and take per-phase quantiles.
+      Bucket counts add exactly, so these are quantiles of the whole run,
+      not averages of per-locale quantiles. */
+  proc mergeLatency(ref g: GlobalStats) {
+    var nPhases, nBuckets: uint(32);
+    ddac_metrics_layout(c_ptrTo(nPhases), c_ptrTo(nBuckets));
+    const P = nPhases: int, B = nBuckets: int;
+
+    var perLocale: [0..#numLocales, 0..#P*B] uint(64);
+    coforall loc in Locales with (ref perLocale) do on loc {
+      var counts: [0..#P*B] uint(64);
+      ddac_metrics_snapshot(c_ptrTo(counts), (P*B): c_size_t);
+      perLocale[loc.id, 0..#P*B] = counts;
+    }
+
+    var merged: [0..#P*B] uint(64);
+    for l in 0..#numLocales do
+      forall j in 0..#P*B with (ref merged) do merged[j] += perLocale[l, j];
+
+    var live = 0;
+    for p in 0..#P do
+      if + reduce merged[p*B..#B] > 0 then live += 1;
+
+    g.phaseDom = {0..#live};
+    var k = 0;
+    for p in 0..#P {
+      const n = + reduce merged[p*B..#B];
+      if n == 0 then continue;
+      const row = c_ptrTo(merged[p*B]): c_ptrConst(uint(64));
+      g.phaseName[k] = string.createCopyingBuffer(ddac_metrics_phase_name(p: uint(32)));
+      g.phaseCount[k] = n: int;
+      g.phaseP50Ms[k] = ddac_metrics_quantile(row, nBuckets, 0.5) / 1000.0;
+      g.phaseP99Ms[k] = ddac_metrics_quantile(row, nBuckets, 0.99) / 1000.0;
+      g.phaseP999Ms[k] = ddac_metrics_quantile(row, nBuckets, 0.999) / 1000.0;
+      k += 1;
+    }
+  }
+
+  /** Start a new latency window on every locale (call at start of run). */
+  proc resetLatency() {
+    coforall loc in Locales do on loc do ddac_metrics_reset();
+  }
+
   // ── Reporting ─────────────────────────────────────────────────────────
 
   /** Print a human-readable report to stdout. */
@@ -166,6 +293,15 @@ module ResultAggregator {
     writeln("    A/V Duration:", g.totalDurationSec:string, " s");
     writeln();
     writeln("  Parse time:    ", g.totalParseTimeMs:string, " ms (cumulative)");
+    if g.phaseDom.size > 0 {
+      writeln("  Latency (ms, p50 / p99 / p999):");
+      for i in g.phaseDom do
+        writeln("    ", g.phaseName[i], ": ", g.phaseP50Ms[i], " / ", g.phaseP99Ms[i],
+                " / ", g.phaseP999Ms[i], " (", g.phaseCount[i], ")");
+    }
+    if numLocales > 1 then
+      writeln("  Work stealing: ", g.steals, " steals, ", g.stolenChunks, " chunks / ",
+              g.stolenDocs, " docs moved");
     writeln("═══════════════════════════════════════════════════════════");
     writeln();
   }
@@ -202,7 +338,24 @@ module ResultAggregator {
       w.writeln("    \"characters\": ", g.totalChars, ",");
       w.writeln("    \"avDurationSec\": ", g.totalDurationSec);
       w.writeln("  },");
-      w.writeln("  \"cumulativeParseMs\": ", g.totalParseTimeMs);
+      w.writeln("  \"cumulativeParseMs\": ", g.totalParseTimeMs, ",");
+      w.writeln("  \"latencyMs\": {");
+      for i in g.phaseDom {
+        w.writeln("    \"", g.phaseName[i], "\": {\"count\": ", g.phaseCount[i],
+                  ", \"p50\": ", g.phaseP50Ms[i], ", \"p99\": ", g.phaseP99Ms[i],
+                  ", \"p999\": ", g.phaseP999Ms[i], "}",
+                  if i < g.phaseDom.high then "," else "");
+      }
+      w.writeln("  },");
+      w.writeln("  \"scheduler\": {");
+      w.writeln("    \"steals\": ", g.steals, ",");
+      w.writeln("    \"stolenChunks\": ", g.stolenChunks, ",");
+      w.writeln("    \"stolenDocs\": ", g.stolenDocs, ",");
+      w.write("    \"stealsByLocale\": [");
+      for i in 0..#numLocales do
+        w.write(if i > 0 then ", " else "", perLocaleStats[i].steals);
+      w.writeln("]");
+      w.writeln("  }");
       w.writeln("}");
 
       w.close();
@@ -247,7 +400,16 @@ module ResultAggregator {
       w.writeln("    (characters ", g.totalChars, ")");
       w.writeln("    (av-duration-sec ", g.totalDurationSec, "))");
       w.writeln("  (timing");
-      w.writeln("    (cumulative-parse-ms ", g.totalParseTimeMs, ")))");
+      w.writeln("    (cumulative-parse-ms ", g.totalParseTimeMs, "))");
+      w.write("  (latency-ms");
+      for i in g.phaseDom do
+        w.write("\n    (", g.phaseName[i], " (count ", g.phaseCount[i], ") (p50 ",
+                g.phaseP50Ms[i], ") (p99 ", g.phaseP99Ms[i], ") (p999 ", g.phaseP999Ms[i], "))");
+      w.writeln(")");
+      w.writeln("  (scheduler");
+      w.writeln("    (steals ", g.steals, ")");
+      w.writeln("    (stolen-chunks ", g.stolenChunks, ")");
+      w.writeln("    (stolen-docs ", g.stolenDocs, ")))");
 
       w.close();
       f.close();
@@ -256,4 +418,39 @@ module ResultAggregator {
       writeln("[report] ERROR: Could not write report to ", path, ": ", e.message());
     }
   }
+
+  /** Write per-phase latency in Prometheus text format (for the node
+      exporter's textfile collector). Written to path + ".tmp" and renamed,
+      so the collector never reads a partial file. */
+  proc writePrometheusMetrics(const ref g: GlobalStats, path: string) {
+    try {
+      const tmp = path + ".tmp";
+      var f = open(tmp, ioMode.cw);
+      var w = f.writer(locking=false);
+
+      w.writeln("# HELP docudactyl_phase_latency_seconds Per-document phase latency quantiles of the last run.");
+      w.writeln("# TYPE docudactyl_phase_latency_seconds gauge");
+      for i in g.phaseDom {
+        const phase = "phase=\"" + g.phaseName[i] + "\"";
+        w.writeln("docudactyl_phase_latency_seconds{", phase, ",quantile=\"0.5\"} ", g.phaseP50Ms[i] / 1000.0);
+        w.writeln("docudactyl_phase_latency_seconds{", phase, ",quantile=\"0.99\"} ", g.phaseP99Ms[i] / 1000.0);
+        w.writeln("docudactyl_phase_latency_seconds{", phase, ",quantile=\"0.999\"} ", g.phaseP999Ms[i] / 1000.0);
+      }
+      w.writeln("# HELP docudactyl_phase_samples Samples behind each phase's latency quantiles.");
+      w.writeln("# TYPE docudactyl_phase_samples gauge");
+      for i in g.phaseDom do
+        w.writeln("docudactyl_phase_samples{phase=\"", g.phaseName[i], "\"} ", g.phaseCount[i]);
+      w.writeln("# HELP docudactyl_run_documents Documents in the last run by outcome.");
+      w.writeln("# TYPE docudactyl_run_documents gauge");
+      w.writeln("docudactyl_run_documents{outcome=\"succeeded\"} ", g.successDocs);
+      w.writeln("docudactyl_run_documents{outcome=\"failed\"} ", g.failedDocs);
+
+      w.close();
+      f.close();
+      rename(tmp, path);
+      writeln("[report] Prometheus metrics written to ", path);
+    } catch e: Error {
+      writeln("[report] ERROR: Could not write Prometheus metrics to ", path, ": ", e.message());
+    }
+  }
 }
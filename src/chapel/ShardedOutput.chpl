@@ -2,7 +2,9 @@
 //
 // Per-locale output directories: output/shard-{localeId}/
 // Each locale writes only to its own shard, eliminating I/O contention.
-// Optional post-run merge combines all shards.
+// Optional post-run merge combines all shards: by moving the per-document
+// files, or with --outputLayout=container by cataloguing the shards'
+// container indexes (the segment files are not touched).
 //
 // SPDX-License-Identifier: MPL-2.0
 // Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
@@ -11,6 +13,8 @@ module ShardedOutput {
   use FileSystem;
   use Path;
   use Config;
+  use CTypes;
+  use FFIBridge;
 
   // ── Shard Management ──────────────────────────────────────────────────
 
@@ -67,6 +71,12 @@ module ShardedOutput {
       This is optional and runs after the forall loop completes.
       Only runs on locale 0 for simplicity. */
   proc mergeAllShards() throws {
+    // The catalog is the container's entry point, even for one shard
+    if outputLayout == "container" {
+      mergeContainers();
+      return;
+    }
+
     if numLocales == 1 {
       writeln("[shards] Single locale — no merge needed");
       return;
@@ -99,6 +109,25 @@ module ShardedOutput {
     writeln("[shards] Merged ", fileCount, " files into ", mergedDir);
   }
 
+  /** Write outputDir/container.cat: one catalog over every shard's
+      container index. Metadata-only — segments stay in their shards. */
+  proc mergeContainers() {
+    var dirs: [0..#numLocales] string;
+    var dirPtrs: [0..#numLocales] c_ptrConst(c_char);
+    for locId in 0..#numLocales {
+      dirs[locId] = shardDir(locId);
+      dirPtrs[locId] = dirs[locId].c_str();
+    }
+    const catalogPath = outputDir + "/container.cat";
+    const records = ddac_container_merge(catalogPath.c_str(), c_ptrTo(dirPtrs[0]),
+                                         numLocales: uint(32));
+    if records < 0 then
+      writeln("[shards] Container catalog failed: ", catalogPath);
+    else
+      writeln("[shards] Catalogued ", records, " blobs from ", numLocales,
+              " shard containers in ", catalogPath);
+  }
+
   /** Count total output files across all shards. */
   proc totalOutputFiles(): int throws {
     var count = 0;
@@ -0,0 +1,348 @@
+// Docudactyl HPC — Work Scheduler
+//
+// Hands out manifest chunks with cost-weighted work stealing across
+// locales. Each locale starts with the chunks of its own block of the
+// block-distributed manifest and claims them front to back. A locale that
+// runs dry steals from the back of the locale with the most estimated work
+// left, taking about half of it, so one node stuck with the 2000-page
+// newspaper PDFs no longer holds up the whole job.
+//
+// Work is estimated per document by a per-kind cost model (fixed cost +
+// cost per MB, applied to the manifest `size` and `kind` fields). The
+// model is fitted from the parse timings FaultHandler records and kept in
+// a small file between runs. With --costScheduling each locale also runs
+// an LPT pre-pass: its documents are sorted longest-first and cut into
+// chunks of roughly equal estimated cost, so the 3 GB TIFF stacks start
+// at the beginning of the run instead of landing in its tail.
+//
+// SPDX-License-Identifier: MPL-2.0
+// Copyright (c) 2026 Jonathan D.A. Jewell (hyperpolymath) <j.d.a.jewell@open.ac.uk>
+
+module WorkScheduler {
+  use Config;
+  use NdjsonManifest;
+  use ContentType;
+  use FaultHandler;
+  use IO;
+  use List;
+  use Sort;
+
+  // ── Cost Model ────────────────────────────────────────────────────────
+
+  /** Estimated parse cost per content kind (ContentKind 0-6): a fixed
+      cost per document plus a cost per MB of input, in milliseconds.
+      Starts from these priors; loadCostModel() replaces them with the
+      fit from a previous run. */
+  var perDocMs: [0..6] real = [200.0, 800.0, 50.0, 50.0, 100.0, 100.0, 20.0];
+  var perMBMs: [0..6] real = [50.0, 20.0, 1.0, 0.5, 30.0, 10.0, 5.0];
+
+  /** Size assumed for documents the manifest gives no size for. */
+  param UNKNOWN_SIZE_MB = 1.0;
+
+  /** Fewest timed documents of a kind before its fitted cost is used. */
+  param MIN_FIT_SAMPLES = 30;
+
+  /** Content kind of a manifest entry: its "kind" hint, else the extension. */
+  proc entryKind(const ref entry: DocEntry): int {
+    select entry.kind {
+      when "pdf" do return 0;
+      when "image" do return 1;
+      when "audio" do return 2;
+      when "video" do return 3;
+      when "epub" do return 4;
+      when "geo" do return 5;
+      when "unknown" do return 6;
+    }
+    return detectContentType(entry.path): int;
+  }
+
+  /** Estimated parse cost of a manifest entry, in microseconds (>= 1),
+      under the model (docMs, mbMs) — local copies of perDocMs/perMBMs. */
+  proc estimateCostUs(const ref entry: DocEntry, const ref docMs: [] real,
+                      const ref mbMs: [] real): int {
+    const kind = entryKind(entry);
+    const mb = if entry.size >= 0 then entry.size: real / (1024.0 * 1024.0)
+               else UNKNOWN_SIZE_MB;
+    return max(((docMs[kind] + mbMs[kind] * mb) * 1000.0): int, 1);
+  }
+
+  /** Load the cost model written by a previous run (one "kind perDocMs
+      perMBMs" line per kind). A missing or bad file keeps the priors. */
+  proc loadCostModel(path: string) {
+    try {
+      var f = open(path, ioMode.r);
+      var reader = f.reader(locking=false);
+      var kind: int, docMs, mbMs: real;
+      while reader.read(kind, docMs, mbMs) {
+        if kind >= 0 && kind <= 6 {
+          perDocMs[kind] = docMs;
+          perMBMs[kind] = mbMs;
+        }
+      }
+      writeln("[sched] Cost model loaded from ", path);
+    } catch {
+      // First run (or unreadable file): priors
+    }
+  }
+
+  /** Refit the cost model from this run's timings (least squares of ms
+      against MB per kind, summed over the locales by
+      FaultHandler.kindTimingTotals) and write it to path. Kinds with too
+      few samples keep their current costs. */
+  proc saveCostModel(path: string) {
+    const sums = kindTimingTotals();
+    for kind in 0..6 {
+      const n = sums.count[kind]: real;
+      if n < MIN_FIT_SAMPLES then continue;
+      const sx = sums.sumMB[kind], sy = sums.sumMs[kind];
+      const sxy = sums.sumMBMs[kind], sxx = sums.sumMB2[kind];
+      const denom = n * sxx - sx * sx;
+      var slope = if denom > 1e-9 then (n * sxy - sx * sy) / denom else 0.0;
+      slope = max(slope, 0.0);
+      perMBMs[kind] = slope;
+      perDocMs[kind] = max((sy - slope * sx) / n, 0.0);
+    }
+
+    try {
+      var f = open(path, ioMode.cw);
+      var w = f.writer(locking=false);
+      for kind in 0..6 do
+        w.writeln(kind, " ", perDocMs[kind], " ", perMBMs[kind]);
+      w.close();
+      f.close();
+    } catch e: Error {
+      writeln("[sched] Could not write cost model to ", path, ": ", e.message());
+    }
+  }
+
+  /** Orders (cost, docIdx) pairs most expensive first. */
+  record costDescending: keyComparator {
+    proc key(e: (int, int)) do return -e(0);
+  }
+
+  private param HALF_BITS = 32;
+  private param HALF_MASK = (1 << HALF_BITS) - 1;
+
+  private inline proc packBounds(head: int, tail: int): int {
+    return (tail << HALF_BITS) | head;
+  }
+
+  // ── Per-Locale Queue ──────────────────────────────────────────────────
+
+  /** One locale's chunks. The locale's documents are listed in `order`
+      (manifest order, or longest-first with --costScheduling); chunk j is
+      order[chunkStart[j]..chunkStart[j+1]-1]. Allocated on its locale. */
+  class LocaleQueue {
+    var numChunks: int;
+    var orderDom: domain(1);
+    /** position -> document index */
+    var order: [orderDom] int;
+    var chunkDom: domain(1);
+    var chunkStart: [chunkDom] int;
+    /** costPrefix[j] = estimated cost (us) of chunks 0..j-1 */
+    var costPrefix: [chunkDom] int;
+
+    /** Unclaimed chunks [head, tail), packed (tail << 32) | head. The owner
+        claims from the head, thieves cut from the tail; both by CAS. */
+    var bounds: atomic int;
+
+    // ── Stolen batch: this locale's tasks only, guarded by stolenLock ──
+    var stolenLock: sync bool = true;
+    var stolenFrom: unmanaged LocaleQueue?;  // victim's queue
+    var stolenNext: int;        // victim chunk indices still to run
+    var stolenEnd: int;
+    var exhausted: bool;        // no work left on any locale
+
+    // Statistics (written under stolenLock)
+    var steals: int;
+    var stolenChunks: int;
+    var stolenDocs: int;
+
+    proc init(const ref docEntries, localDocs: domain(1)) {
+      orderDom = {0..#localDocs.size};
+      init this;
+
+      // Per-document cost estimates; LPT pre-pass sorts longest first
+      const docMs: [0..6] real = perDocMs, mbMs: [0..6] real = perMBMs;
+      var costs: [orderDom] (int, int);
+      forall (p, idx) in zip(orderDom, localDocs) do
+        costs[p] = (estimateCostUs(docEntries[idx], docMs, mbMs), idx);
+      if costScheduling then
+        sort(costs, comparator=new costDescending());
+      forall p in orderDom do order[p] = costs[p](1);
+
+      // Cut chunks: by count in manifest order; by cost with LPT, so each
+      // chunk is worth about as much as a chunkSize chunk on average. A
+      // document costlier than that gets a chunk to itself; otherwise a
+      // chunk holds minChunkSize..chunkSize documents.
+      const total = + reduce [c in costs] c(0);
+      const countChunks = (orderDom.size + chunkSize - 1) / chunkSize;
+      const target = if costScheduling && countChunks > 0
+                     then max(total / countChunks, 1) else max(int);
+      var starts: list(int);
+      var prefix: list(int);
+      var acc = 0, inChunk = 0, chunkCost = 0;
+      for p in orderDom {
+        if inChunk == 0 {
+          starts.pushBack(p);
+          prefix.pushBack(acc);
+        }
+        acc += costs[p](0);
+        chunkCost += costs[p](0);
+        inChunk += 1;
+        if inChunk == chunkSize ||
+           (chunkCost >= target && (inChunk == 1 || inChunk >= minChunkSize)) {
+          inChunk = 0;
+          chunkCost = 0;
+        }
+      }
+
+      numChunks = starts.size;
+      chunkDom = {0..numChunks};
+      for j in 0..#numChunks {
+        chunkStart[j] = starts[j];
+        costPrefix[j] = prefix[j];
+      }
+      chunkStart[numChunks] = orderDom.size;
+      costPrefix[numChunks] = acc;
+      bounds.write(packBounds(0, numChunks));
+    }
+
+    /** Document indices of chunk j (a local copy). */
+    proc chunkDocs(j: int) {
+      const positions = chunkStart[j]..chunkStart[j + 1] - 1;
+      var docIdx: [0..#positions.size] int = order[positions];
+      return docIdx;
+    }
+
+    /** Estimated cost of the chunks nobody has claimed yet. */
+    proc remainingCost(): int {
+      const b = bounds.read();
+      const head = b & HALF_MASK, tail = b >> HALF_BITS;
+      return if head < tail then costPrefix[tail] - costPrefix[head] else 0;
+    }
+
+    /** Owner side: claim the next chunk from the head, or -1. */
+    proc claimHead(): int {
+      var b = bounds.read();
+      while true {
+        const head = b & HALF_MASK, tail = b >> HALF_BITS;
+        if head >= tail then return -1;
+        if bounds.compareExchange(b, packBounds(head + 1, tail)) then return head;
+      }
+    }
+
+    /** Thief side (run on this locale): cut chunks off the tail worth about
+        half the remaining cost, leaving the owner at least one chunk unless
+        only one is left. Returns the chunk range [s, t); empty if none. */
+    proc cutTail(): (int, int) {
+      var b = bounds.read();
+      while true {
+        const head = b & HALF_MASK, tail = b >> HALF_BITS;
+        if head >= tail then return (0, 0);
+
+        // Smallest split s in head+1..tail-1 that leaves the owner half
+        var s = head;
+        if tail - head > 1 {
+          const target = costPrefix[head] + (costPrefix[tail] - costPrefix[head]) / 2;
+          var lo = head + 1, hi = tail - 1;
+          while lo < hi {
+            const mid = (lo + hi) / 2;
+            if costPrefix[mid] >= target then hi = mid; else lo = mid + 1;
+          }
+          s = lo;
+        }
+        if bounds.compareExchange(b, packBounds(head, s)) then return (s, tail);
+      }
+    }
+  }
+
+  // ── Scheduler ─────────────────────────────────────────────────────────
+
+  /** Per-locale queues. Each locale's queue is allocated on that locale. */
+  var localeQueues: [0..#numLocales] unmanaged LocaleQueue?;
+
+  /** Build every locale's queue from its block of the manifest. */
+  proc initScheduler(const ref docEntries) {
+    coforall loc in Locales with (ref localeQueues) do on loc {
+      const q = new unmanaged LocaleQueue(docEntries, docEntries.localSubdomain());
+      localeQueues[here.id] = q;
+    }
+  }
+
+  /** Free every locale's queue. */
+  proc freeScheduler() {
+    for q in localeQueues {
+      if q != nil then delete q;
+      q = nil;
+    }
+  }
+
+  /** This locale's queue (look it up once per task, not per chunk). */
+  proc localQueue(): unmanaged LocaleQueue {
+    return localeQueues[here.id]!;
+  }
+
+  /** Next chunk for this locale's tasks: own chunks first, then the current
+      stolen batch, then a new steal. Returns the chunk's document indices;
+      empty once no locale has work left. */
+  proc nextChunk(q: unmanaged LocaleQueue) {
+    const j = q.claimHead();
+    if j >= 0 then return q.chunkDocs(j);
+
+    // One task at a time works the stolen batch (and steals the next one)
+    q.stolenLock.readFE();
+    defer q.stolenLock.writeEF(true);
+    while q.stolenNext >= q.stolenEnd {
+      if q.exhausted || !stealInto(q) {
+        q.exhausted = true;
+        var none: [0..#0] int;
+        return none;
+      }
+    }
+    const k = q.stolenNext;
+    q.stolenNext += 1;
+    return q.stolenFrom!.chunkDocs(k);
+  }
+
+  /** Steal about half of the busiest other locale's remaining work into
+      q's stolen batch. Stolen chunks are not stolen again. Returns false
+      when no other locale has unclaimed chunks. Caller holds q.stolenLock. */
+  private proc stealInto(q: unmanaged LocaleQueue): bool {
+    while true {
+      // Victim: the locale with the most estimated work left
+      var victim = -1, most = 0;
+      for locId in 0..#numLocales {
+        if locId == here.id then continue;
+        const cost = localeQueues[locId]!.remainingCost();
+        if cost > most {
+          most = cost;
+          victim = locId;
+        }
+      }
+      if victim < 0 then return false;
+
+      const vq = localeQueues[victim]!;
+      var cut: (int, int);
+      on vq do cut = vq.cutTail();
+      const (s, t) = cut;
+      if s >= t then continue; // the owner got there first; look again
+
+      q.stolenFrom = vq;
+      q.stolenNext = s;
+      q.stolenEnd = t;
+      q.steals += 1;
+      q.stolenChunks += t - s;
+      q.stolenDocs += vq.chunkStart[t] - vq.chunkStart[s];
+      return true;
+    }
+    return false;
+  }
+
+  /** Steal statistics of a locale: (steals, chunks stolen, documents stolen). */
+  proc stealCounts(locId: int): (int, int, int) {
+    const q = localeQueues[locId];
+    if q == nil then return (0, 0, 0);
+    return (q!.steals, q!.stolenChunks, q!.stolenDocs);
+  }
+}